@@ -0,0 +1,265 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-alignment-scheduler.h"
+
+/* Runs the chunks of all the GcsvAlignment's of the application, one chunk
+ * per main loop iteration, instead of one idle function per GcsvAlignment
+ * competing with the others.
+ *
+ * The GcsvAlignment with the highest GcsvAlignmentPriority goes first. The
+ * GcsvAlignment's with the same priority are handled in a round-robin
+ * fashion. When only background GcsvAlignment's remain, they are throttled to
+ * one chunk every BACKGROUND_INTERVAL milliseconds, so that they don't
+ * compete with the rest of the desktop.
+ */
+
+struct _GcsvAlignmentScheduler
+{
+	GObject parent;
+
+	/* The GcsvAlignment's with pending chunks. Not owned, a GcsvAlignment
+	 * removes itself when it is disposed.
+	 */
+	GQueue alignments;
+
+	guint idle_id;
+	guint background_timeout_id;
+};
+
+/* In milliseconds. */
+#define BACKGROUND_INTERVAL 100
+
+G_DEFINE_TYPE (GcsvAlignmentScheduler, gcsv_alignment_scheduler, G_TYPE_OBJECT)
+
+static void
+remove_sources (GcsvAlignmentScheduler *scheduler)
+{
+	if (scheduler->idle_id != 0)
+	{
+		g_source_remove (scheduler->idle_id);
+		scheduler->idle_id = 0;
+	}
+
+	if (scheduler->background_timeout_id != 0)
+	{
+		g_source_remove (scheduler->background_timeout_id);
+		scheduler->background_timeout_id = 0;
+	}
+}
+
+static void
+gcsv_alignment_scheduler_finalize (GObject *object)
+{
+	GcsvAlignmentScheduler *scheduler = GCSV_ALIGNMENT_SCHEDULER (object);
+
+	remove_sources (scheduler);
+	g_queue_clear (&scheduler->alignments);
+
+	G_OBJECT_CLASS (gcsv_alignment_scheduler_parent_class)->finalize (object);
+}
+
+static void
+gcsv_alignment_scheduler_class_init (GcsvAlignmentSchedulerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = gcsv_alignment_scheduler_finalize;
+}
+
+static void
+gcsv_alignment_scheduler_init (GcsvAlignmentScheduler *scheduler)
+{
+	g_queue_init (&scheduler->alignments);
+}
+
+/* Returns: (transfer none): the GcsvAlignmentScheduler of the application. */
+GcsvAlignmentScheduler *
+gcsv_alignment_scheduler_get_default (void)
+{
+	static GcsvAlignmentScheduler *default_scheduler = NULL;
+
+	if (default_scheduler == NULL)
+	{
+		default_scheduler = g_object_new (GCSV_TYPE_ALIGNMENT_SCHEDULER, NULL);
+	}
+
+	return default_scheduler;
+}
+
+static GcsvAlignment *
+get_next_alignment (GcsvAlignmentScheduler *scheduler)
+{
+	GcsvAlignment *next = NULL;
+	GList *l;
+
+	for (l = scheduler->alignments.head; l != NULL; l = l->next)
+	{
+		GcsvAlignment *align = l->data;
+
+		if (next == NULL ||
+		    gcsv_alignment_get_priority (align) > gcsv_alignment_get_priority (next))
+		{
+			next = align;
+		}
+	}
+
+	return next;
+}
+
+static void
+run_next_chunk (GcsvAlignmentScheduler *scheduler)
+{
+	GcsvAlignment *align;
+
+	align = get_next_alignment (scheduler);
+	if (align == NULL)
+	{
+		return;
+	}
+
+	/* Goes to the end of the queue, for the round-robin. If it has no more
+	 * chunks, it is not re-added.
+	 */
+	g_queue_remove (&scheduler->alignments, align);
+
+	g_object_ref (align);
+
+	if (gcsv_alignment_process_next_chunk (align) &&
+	    g_queue_find (&scheduler->alignments, align) == NULL)
+	{
+		g_queue_push_tail (&scheduler->alignments, align);
+	}
+
+	g_object_unref (align);
+}
+
+static gboolean
+idle_cb (gpointer user_data)
+{
+	GcsvAlignmentScheduler *scheduler = GCSV_ALIGNMENT_SCHEDULER (user_data);
+	GcsvAlignment *next;
+
+	run_next_chunk (scheduler);
+
+	next = get_next_alignment (scheduler);
+	if (next != NULL &&
+	    gcsv_alignment_get_priority (next) > GCSV_ALIGNMENT_PRIORITY_BACKGROUND)
+	{
+		return G_SOURCE_CONTINUE;
+	}
+
+	scheduler->idle_id = 0;
+	gcsv_alignment_scheduler_reschedule (scheduler);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+background_timeout_cb (gpointer user_data)
+{
+	GcsvAlignmentScheduler *scheduler = GCSV_ALIGNMENT_SCHEDULER (user_data);
+
+	run_next_chunk (scheduler);
+
+	scheduler->background_timeout_id = 0;
+	gcsv_alignment_scheduler_reschedule (scheduler);
+	return G_SOURCE_REMOVE;
+}
+
+/* To call when the priority of a GcsvAlignment has changed. */
+void
+gcsv_alignment_scheduler_reschedule (GcsvAlignmentScheduler *scheduler)
+{
+	GcsvAlignment *next;
+
+	g_return_if_fail (GCSV_IS_ALIGNMENT_SCHEDULER (scheduler));
+
+	next = get_next_alignment (scheduler);
+
+	if (next == NULL)
+	{
+		remove_sources (scheduler);
+	}
+	else if (gcsv_alignment_get_priority (next) > GCSV_ALIGNMENT_PRIORITY_BACKGROUND)
+	{
+		if (scheduler->background_timeout_id != 0)
+		{
+			g_source_remove (scheduler->background_timeout_id);
+			scheduler->background_timeout_id = 0;
+		}
+
+		if (scheduler->idle_id == 0)
+		{
+			scheduler->idle_id = g_idle_add (idle_cb, scheduler);
+		}
+	}
+	else
+	{
+		if (scheduler->idle_id != 0)
+		{
+			g_source_remove (scheduler->idle_id);
+			scheduler->idle_id = 0;
+		}
+
+		if (scheduler->background_timeout_id == 0)
+		{
+			scheduler->background_timeout_id = g_timeout_add (BACKGROUND_INTERVAL,
+									  background_timeout_cb,
+									  scheduler);
+		}
+	}
+}
+
+/* Schedules the chunks of @align, until gcsv_alignment_process_next_chunk()
+ * returns %FALSE or gcsv_alignment_scheduler_remove() is called.
+ */
+void
+gcsv_alignment_scheduler_add (GcsvAlignmentScheduler *scheduler,
+			      GcsvAlignment          *align)
+{
+	g_return_if_fail (GCSV_IS_ALIGNMENT_SCHEDULER (scheduler));
+	g_return_if_fail (GCSV_IS_ALIGNMENT (align));
+
+	if (g_queue_find (&scheduler->alignments, align) == NULL)
+	{
+		g_queue_push_tail (&scheduler->alignments, align);
+		gcsv_alignment_scheduler_reschedule (scheduler);
+	}
+}
+
+void
+gcsv_alignment_scheduler_remove (GcsvAlignmentScheduler *scheduler,
+				 GcsvAlignment          *align)
+{
+	g_return_if_fail (GCSV_IS_ALIGNMENT_SCHEDULER (scheduler));
+
+	if (g_queue_remove (&scheduler->alignments, align))
+	{
+		gcsv_alignment_scheduler_reschedule (scheduler);
+	}
+}
+
+/* Returns: the number of GcsvAlignment's with pending chunks. */
+guint
+gcsv_alignment_scheduler_get_n_pending (GcsvAlignmentScheduler *scheduler)
+{
+	g_return_val_if_fail (GCSV_IS_ALIGNMENT_SCHEDULER (scheduler), 0);
+
+	return g_queue_get_length (&scheduler->alignments);
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_ALIGNMENT_SCHEDULER_H
+#define GCSV_ALIGNMENT_SCHEDULER_H
+
+#include <glib-object.h>
+#include "gcsv-alignment.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_ALIGNMENT_SCHEDULER (gcsv_alignment_scheduler_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvAlignmentScheduler, gcsv_alignment_scheduler,
+		      GCSV, ALIGNMENT_SCHEDULER,
+		      GObject)
+
+GcsvAlignmentScheduler *
+		gcsv_alignment_scheduler_get_default	(void);
+
+void		gcsv_alignment_scheduler_add		(GcsvAlignmentScheduler *scheduler,
+							 GcsvAlignment          *align);
+
+void		gcsv_alignment_scheduler_remove		(GcsvAlignmentScheduler *scheduler,
+							 GcsvAlignment          *align);
+
+void		gcsv_alignment_scheduler_reschedule	(GcsvAlignmentScheduler *scheduler);
+
+guint		gcsv_alignment_scheduler_get_n_pending	(GcsvAlignmentScheduler *scheduler);
+
+G_END_DECLS
+
+#endif /* GCSV_ALIGNMENT_SCHEDULER_H */
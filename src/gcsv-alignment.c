@@ -20,6 +20,8 @@
  */
 
 #include "gcsv-alignment.h"
+#include <string.h>
+#include "gcsv-alignment-scheduler.h"
 #include "gcsv-utils.h"
 
 struct _GcsvAlignment
@@ -31,7 +33,7 @@ struct _GcsvAlignment
 	/* The alignment is done by inserting spaces to the buffer. The spaces
 	 * are surrounded by a tag, so we know where the alignment is. It
 	 * permits to remove it or to not take it into account for certain
-	 * features like file saving.
+	 * features like file saving. The tag is owned by the GcsvBuffer.
 	 */
 	GtkTextTag *tag;
 
@@ -48,6 +50,12 @@ struct _GcsvAlignment
 	/* The region to align, i.e. adjusting the spacing. */
 	GtkSourceRegion *align_region;
 
+	/* When the delimiter changes, all the virtual spaces after this mark
+	 * are removed, before scanning and aligning. NULL if there is nothing
+	 * to remove. See strip_next_chunk().
+	 */
+	GtkTextMark *strip_mark;
+
 	/* When adding a subregion to the scan_region or align_region, the
 	 * subregion is sometimes not handled directly/synchronously, instead a
 	 * timeout or idle function is used, to not block the user interface. An
@@ -58,14 +66,49 @@ struct _GcsvAlignment
 	 * Using threads would not be convenient because this class uses lots of
 	 * GTK functions, and the GTK API can be accessed only by the main
 	 * thread.
+	 * Instead of an idle function per GcsvAlignment, the chunks are run by
+	 * the GcsvAlignmentScheduler, shared by all the GcsvAlignment's of the
+	 * application.
 	 */
 	guint timeout_id;
-	guint idle_id;
+
+	/* Single-character edits are aligned once per frame before the
+	 * redraw, see HANDLE_MODE_BEFORE_PAINT. In a tick callback of the view
+	 * when it is mapped, in an idle otherwise.
+	 */
+	GtkWidget *view;
+	guint before_paint_tick_id;
+	guint before_paint_idle_id;
+
+	/* See GcsvAlignmentScheduler. */
+	GcsvAlignmentPriority priority;
+
+	/* The visible lines, aligned first. -1 if unknown. */
+	gint viewport_first_line;
+	gint viewport_last_line;
+
+	/* Only the first n_aligned_columns columns have virtual spaces, see
+	 * gcsv_alignment_set_last_visible_column(). G_MAXUINT for all the
+	 * columns.
+	 */
+	guint n_aligned_columns;
+
+	/* Lines longer than that, in characters, are not aligned and don't
+	 * count for the column lengths. They are wrapped with long_lines_tag,
+	 * so the view shows them on several rows instead of one row that is
+	 * millions of pixels wide. See gcsv_alignment_set_max_line_length().
+	 */
+	guint max_line_length;
+	GtkTextTag *long_lines_tag;
 
 	gulong delimiter_notify_handler_id;
 	gulong insert_text_handler_id;
 	gulong delete_range_handler_id;
-	gulong delete_range_after_handler_id;
+	gulong replace_lines_handler_id;
+	gulong replace_lines_after_handler_id;
+
+	/* The buffer line count when GcsvBuffer::replace-lines is emitted. */
+	gint line_count_before_replace;
 
 	/* Whether the alignment is enabled. It is different than setting the
 	 * delimiter to '\0'. Setting the delimiter to '\0' removes the
@@ -81,11 +124,6 @@ struct _GcsvAlignment
 	 * finished.
 	 */
 	guint unit_test_mode : 1;
-
-	/* Whether the scan/align regions need to be handled synchronously (just
-	 * the next chunk) when a delete-range in the buffer is done.
-	 */
-	guint sync_after_delete_range : 1;
 };
 
 enum
@@ -97,7 +135,7 @@ enum
 
 typedef enum
 {
-	HANDLE_MODE_SYNC, /* Handle directly the next chunk */
+	HANDLE_MODE_BEFORE_PAINT, /* Handle the next chunk before the next redraw */
 	HANDLE_MODE_IDLE,
 	HANDLE_MODE_TIMEOUT,
 } HandleMode;
@@ -105,7 +143,6 @@ typedef enum
 typedef struct _BufferEditData BufferEditData;
 struct _BufferEditData
 {
-	gulong *handler_ids;
 	guint modified : 1;
 };
 
@@ -125,6 +162,11 @@ typedef gboolean (* HandleSubregionFunc) (GcsvAlignment     *align,
 #define SCANNING_BATCH_SIZE 100
 #define ALIGNING_BATCH_SIZE 50
 
+/* Max number of lines where the virtual spaces are removed at once. The lines
+ * without virtual spaces are skipped, so it is much faster than aligning.
+ */
+#define STRIPPING_BATCH_SIZE 1000
+
 /* Timeout duration in milliseconds.
  * By default in GNOME, the key repeat-interval is 30ms.
  * It would be better to get the value of the
@@ -132,6 +174,21 @@ typedef gboolean (* HandleSubregionFunc) (GcsvAlignment     *align,
  */
 #define TIMEOUT_DURATION 40
 
+/* Without a mapped view, before the GTK+ redraw if there is one. But the idle
+ * can run several times per frame, after each main loop iteration that has
+ * dispatched events.
+ */
+#define BEFORE_PAINT_PRIORITY (G_PRIORITY_HIGH_IDLE + 10)
+
+/* With gcsv_alignment_set_last_visible_column(), the number of columns aligned
+ * after the last visible one, so that scrolling horizontally by a few columns
+ * doesn't require to re-align the buffer.
+ */
+#define COLUMN_MARGIN 10
+
+/* For example a line with an embedded JSON document. */
+#define DEFAULT_MAX_LINE_LENGTH (64 * 1024)
+
 #define ENABLE_DEBUG 0
 
 G_DEFINE_TYPE (GcsvAlignment, gcsv_alignment, G_TYPE_OBJECT)
@@ -214,29 +271,19 @@ set_column_length (GcsvAlignment *align,
 	handle_mode (align, HANDLE_MODE_IDLE);
 }
 
+/* The own edit handlers return early during a virtual spaces edit, and the
+ * buffer doesn't emit modified-changed, see
+ * gcsv_buffer_begin_virtual_spaces_edit(). So it is cheap enough to be done
+ * for each chunk.
+ */
 static BufferEditData
 begin_buffer_edit (GcsvAlignment *align)
 {
 	BufferEditData data;
 
-	data.handler_ids = gcsv_utils_block_all_signal_handlers (G_OBJECT (align->buffer),
-								 "modified-changed");
 	data.modified = gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (align->buffer));
 
-	if (align->insert_text_handler_id != 0)
-	{
-		g_signal_handler_block (align->buffer, align->insert_text_handler_id);
-	}
-
-	if (align->delete_range_handler_id != 0)
-	{
-		g_signal_handler_block (align->buffer, align->delete_range_handler_id);
-	}
-
-	if (align->delete_range_after_handler_id != 0)
-	{
-		g_signal_handler_block (align->buffer, align->delete_range_after_handler_id);
-	}
+	gcsv_buffer_begin_virtual_spaces_edit (align->buffer);
 
 	return data;
 }
@@ -245,25 +292,12 @@ static void
 end_buffer_edit (GcsvAlignment  *align,
 		 BufferEditData *data)
 {
-	if (align->insert_text_handler_id != 0)
-	{
-		g_signal_handler_unblock (align->buffer, align->insert_text_handler_id);
-	}
-
-	if (align->delete_range_handler_id != 0)
-	{
-		g_signal_handler_unblock (align->buffer, align->delete_range_handler_id);
-	}
-
-	if (align->delete_range_after_handler_id != 0)
-	{
-		g_signal_handler_unblock (align->buffer, align->delete_range_after_handler_id);
-	}
-
+	/* Before the end of the virtual spaces edit, so that it is not
+	 * noticed.
+	 */
 	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (align->buffer), data->modified);
-	gcsv_utils_unblock_signal_handlers (G_OBJECT (align->buffer),
-					    data->handler_ids);
-	g_free (data->handler_ids);
+
+	gcsv_buffer_end_virtual_spaces_edit (align->buffer);
 }
 
 /* Length in characters, not in bytes. */
@@ -274,29 +308,57 @@ get_field_length (GcsvAlignment     *align,
 		  gboolean           include_virtual_spaces)
 {
 	GtkTextIter iter;
-	guint length = 0;
+	guint length;
 
 	g_return_val_if_fail (gtk_text_iter_get_line (field_start) == gtk_text_iter_get_line (field_end), 0);
 	g_return_val_if_fail (gtk_text_iter_compare (field_start, field_end) <= 0, 0);
 
+	length = gtk_text_iter_get_line_offset (field_end) - gtk_text_iter_get_line_offset (field_start);
+
 	if (include_virtual_spaces)
 	{
-		return gtk_text_iter_get_line_offset (field_end) - gtk_text_iter_get_line_offset (field_start);
+		return length;
 	}
 
-	for (iter = *field_start;
-	     !gtk_text_iter_equal (&iter, field_end);
-	     gtk_text_iter_forward_char (&iter))
+	/* Subtract the virtual spaces, going from tag toggle to tag toggle, so
+	 * that the cost doesn't depend on the field length.
+	 */
+	iter = *field_start;
+	while (gtk_text_iter_compare (&iter, field_end) < 0)
 	{
-		if (!gtk_text_iter_has_tag (&iter, align->tag))
+		GtkTextIter toggle = iter;
+		gboolean in_virtual_spaces;
+
+		in_virtual_spaces = gtk_text_iter_has_tag (&iter, align->tag);
+
+		gtk_text_iter_forward_to_tag_toggle (&toggle, align->tag);
+		if (gtk_text_iter_compare (field_end, &toggle) < 0)
 		{
-			length++;
+			toggle = *field_end;
 		}
+
+		if (in_virtual_spaces)
+		{
+			length -= gtk_text_iter_get_line_offset (&toggle) - gtk_text_iter_get_line_offset (&iter);
+		}
+
+		iter = toggle;
 	}
 
 	return length;
 }
 
+static gboolean
+is_long_line (GcsvAlignment *align,
+	      guint          line_num)
+{
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (align->buffer), &iter, line_num);
+
+	return gtk_text_iter_get_chars_in_line (&iter) > align->max_line_length;
+}
+
 static gboolean
 scan_subregion (GcsvAlignment     *align,
 		const GtkTextIter *start,
@@ -320,6 +382,11 @@ scan_subregion (GcsvAlignment     *align,
 		guint n_columns;
 		guint column_num;
 
+		if (is_long_line (align, line_num))
+		{
+			continue;
+		}
+
 		n_columns = gcsv_buffer_count_columns_at_line (align->buffer, line_num);
 
 		for (column_num = 0; column_num < n_columns; column_num++)
@@ -464,6 +531,59 @@ adjust_field_alignment (GcsvAlignment *align,
 	return TRUE;
 }
 
+/* Removes the virtual spaces of the columns that are no longer aligned. */
+static void
+remove_alignment_after_column (GcsvAlignment *align,
+			       guint          line_num,
+			       guint          column_num)
+{
+	GtkTextIter start;
+	GtkTextIter line_end;
+
+	gcsv_buffer_get_field_bounds (align->buffer, line_num, column_num, &start, &line_end);
+
+	if (!gtk_text_iter_ends_line (&line_end))
+	{
+		gtk_text_iter_forward_to_line_end (&line_end);
+	}
+
+	gcsv_utils_delete_text_with_tag (GTK_TEXT_BUFFER (align->buffer),
+					 &start,
+					 &line_end,
+					 align->tag);
+}
+
+/* Wraps or unwraps the line, when it becomes long or short. The tag is checked
+ * at the line start only, so an aligned line costs almost nothing.
+ */
+static void
+update_long_line_tag (GcsvAlignment *align,
+		      guint          line_num,
+		      gboolean       long_line)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (align->buffer), &start, line_num);
+
+	if (gtk_text_iter_has_tag (&start, align->long_lines_tag) == long_line)
+	{
+		return;
+	}
+
+	end = start;
+	gtk_text_iter_forward_line (&end);
+
+	if (long_line)
+	{
+		gtk_text_buffer_apply_tag (GTK_TEXT_BUFFER (align->buffer), align->long_lines_tag, &start, &end);
+	}
+	else
+	{
+		gtk_text_buffer_remove_tag (GTK_TEXT_BUFFER (align->buffer), align->long_lines_tag, &start, &end);
+	}
+}
+
 /* Returns TRUE if the subregion is correctly aligned, FALSE if a column length
  * has been updated.
  */
@@ -489,9 +609,18 @@ align_subregion (GcsvAlignment     *align,
 
 	for (line_num = start_line; line_num <= end_line; line_num++)
 	{
-		guint n_columns = align->column_lengths->len;
+		guint n_columns = MIN (align->column_lengths->len, align->n_aligned_columns);
 		guint column_num;
 
+		if (is_long_line (align, line_num))
+		{
+			update_long_line_tag (align, line_num, TRUE);
+			remove_alignment_after_column (align, line_num, 0);
+			continue;
+		}
+
+		update_long_line_tag (align, line_num, FALSE);
+
 		for (column_num = 0; column_num < n_columns; column_num++)
 		{
 			if (!adjust_field_alignment (align, line_num, column_num))
@@ -500,6 +629,11 @@ align_subregion (GcsvAlignment     *align,
 				goto out;
 			}
 		}
+
+		if (n_columns < align->column_lengths->len)
+		{
+			remove_alignment_after_column (align, line_num, n_columns);
+		}
 	}
 
 out:
@@ -525,10 +659,15 @@ adjust_subregion (GtkTextIter *start,
 
 /* Returns whether the handling of the whole buffer is finished.
  * I.e. it returns TRUE if there is no more chunks.
+ *
+ * The subregions of @iter_region are handled in order, @iter_region must be
+ * included in @region. It permits to handle a part of @region first, like the
+ * viewport.
  */
 static gboolean
 handle_next_chunk (GcsvAlignment       *align,
 		   GtkSourceRegion     *region,
+		   GtkSourceRegion     *iter_region,
 		   guint                batch_size,
 		   HandleSubregionFunc  handle_subregion_func)
 {
@@ -536,6 +675,7 @@ handle_next_chunk (GcsvAlignment       *align,
 	GtkSourceRegionIter region_iter;
 	GtkTextIter start;
 	GtkTextIter stop;
+	gint line_start = -1;
 
 	if (region == NULL)
 	{
@@ -544,7 +684,7 @@ handle_next_chunk (GcsvAlignment       *align,
 
 	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (align->buffer), &stop);
 
-	gtk_source_region_get_start_region_iter (region, &region_iter);
+	gtk_source_region_get_start_region_iter (iter_region, &region_iter);
 
 	while (n_remaining_lines > 0 &&
 	       !gtk_source_region_iter_is_end (&region_iter))
@@ -569,6 +709,11 @@ handle_next_chunk (GcsvAlignment       *align,
 
 		adjust_subregion (&subregion_start, &subregion_end);
 
+		if (line_start == -1)
+		{
+			line_start = gtk_text_iter_get_line (&subregion_start);
+		}
+
 		/* Remember the line, since the iter won't be valid after
 		 * handling the subregion. In our case, the line number won't
 		 * change, but if lines are inserted or deleted, we would need a
@@ -592,8 +737,11 @@ handle_next_chunk (GcsvAlignment       *align,
 		gtk_source_region_iter_next (&region_iter);
 	}
 
-	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (align->buffer), &start);
-	gtk_source_region_subtract_subregion (region, &start, &stop);
+	if (line_start != -1)
+	{
+		gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (align->buffer), &start, line_start);
+		gtk_source_region_subtract_subregion (region, &start, &stop);
+	}
 
 	if (gtk_source_region_is_empty (region))
 	{
@@ -607,23 +755,145 @@ static gboolean
 scan_next_chunk (GcsvAlignment *align)
 {
 	return handle_next_chunk (align,
+				  align->scan_region,
 				  align->scan_region,
 				  SCANNING_BATCH_SIZE,
 				  scan_subregion);
 }
 
+/* Returns: (transfer full) (nullable): the part of the align_region in the
+ * viewport, or %NULL if it is empty or unknown.
+ */
+static GtkSourceRegion *
+get_viewport_region_to_align (GcsvAlignment *align)
+{
+	GtkTextIter viewport_start;
+	GtkTextIter viewport_end;
+	GtkSourceRegion *viewport_region;
+
+	if (align->align_region == NULL ||
+	    align->viewport_first_line < 0)
+	{
+		return NULL;
+	}
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (align->buffer),
+					  &viewport_start,
+					  align->viewport_first_line);
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (align->buffer),
+					  &viewport_end,
+					  align->viewport_last_line);
+	adjust_subregion (&viewport_start, &viewport_end);
+
+	viewport_region = gtk_source_region_intersect_subregion (align->align_region,
+								 &viewport_start,
+								 &viewport_end);
+
+	if (viewport_region != NULL &&
+	    gtk_source_region_is_empty (viewport_region))
+	{
+		g_clear_object (&viewport_region);
+	}
+
+	return viewport_region;
+}
+
 static gboolean
 align_next_chunk (GcsvAlignment *align)
 {
-	return handle_next_chunk (align,
-				  align->align_region,
-				  ALIGNING_BATCH_SIZE,
-				  align_subregion);
+	GtkSourceRegion *viewport_region;
+	gboolean finished;
+
+	/* The visible lines first, so the user sees the result sooner. */
+	viewport_region = get_viewport_region_to_align (align);
+
+	finished = handle_next_chunk (align,
+				      align->align_region,
+				      viewport_region != NULL ? viewport_region : align->align_region,
+				      ALIGNING_BATCH_SIZE,
+				      align_subregion);
+
+	g_clear_object (&viewport_region);
+	return finished;
 }
 
+/* Removes the virtual spaces in the next lines after strip_mark, going from
+ * one run of virtual spaces to the next, without looking at the fields.
+ * Returns whether all the virtual spaces have been removed.
+ */
 static gboolean
-idle_cb (GcsvAlignment *align)
+strip_next_chunk (GcsvAlignment *align)
 {
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (align->buffer);
+	BufferEditData edit_data;
+	GtkTextIter start;
+	GtkTextIter end;
+	gint end_line;
+
+	gtk_text_buffer_get_iter_at_mark (buffer, &start, align->strip_mark);
+
+	/* Jump to the next run of virtual spaces. */
+	if (!gtk_text_iter_has_tag (&start, align->tag) &&
+	    !gtk_text_iter_forward_to_tag_toggle (&start, align->tag))
+	{
+		gtk_text_buffer_delete_mark (buffer, align->strip_mark);
+		align->strip_mark = NULL;
+		return TRUE;
+	}
+
+	end_line = gtk_text_iter_get_line (&start) + STRIPPING_BATCH_SIZE;
+	gtk_text_buffer_get_iter_at_line (buffer, &end, end_line);
+
+	edit_data = begin_buffer_edit (align);
+	gcsv_utils_delete_text_with_tag (buffer, &start, &end, align->tag);
+	end_buffer_edit (align, &edit_data);
+
+	/* Removing virtual spaces doesn't change the line numbers. */
+	gtk_text_buffer_get_iter_at_line (buffer, &end, end_line);
+	gtk_text_buffer_move_mark (buffer, align->strip_mark, &end);
+
+	return FALSE;
+}
+
+/* Schedules the removal of all the virtual spaces, it is done before scanning
+ * and aligning again.
+ */
+static void
+start_stripping (GcsvAlignment *align)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (align->buffer);
+	GtkTextIter start;
+
+	gtk_text_buffer_get_start_iter (buffer, &start);
+
+	if (align->strip_mark == NULL)
+	{
+		align->strip_mark = gtk_text_buffer_create_mark (buffer, NULL, &start, TRUE);
+	}
+	else
+	{
+		gtk_text_buffer_move_mark (buffer, align->strip_mark, &start);
+	}
+}
+
+/* Handles the next chunk of the virtual spaces to remove, of the scan_region or
+ * of the align_region.
+ *
+ * Returns: whether there are more chunks to handle.
+ */
+gboolean
+gcsv_alignment_process_next_chunk (GcsvAlignment *align)
+{
+	g_return_val_if_fail (GCSV_IS_ALIGNMENT (align), FALSE);
+
+	if (align->strip_mark != NULL)
+	{
+		strip_next_chunk (align);
+		return (align->strip_mark != NULL ||
+			align->scan_region != NULL ||
+			align->align_region != NULL);
+	}
+
 	if (align->scan_region != NULL)
 	{
 		gboolean finished = scan_next_chunk (align);
@@ -640,7 +910,7 @@ idle_cb (GcsvAlignment *align)
 			g_clear_object (&align->scan_region);
 		}
 
-		return G_SOURCE_CONTINUE;
+		return TRUE;
 	}
 
 	if (align->align_region != NULL)
@@ -649,16 +919,35 @@ idle_cb (GcsvAlignment *align)
 		if (finished)
 		{
 			g_clear_object (&align->align_region);
-
-			align->idle_id = 0;
-			return G_SOURCE_REMOVE;
+			return FALSE;
 		}
 
-		return G_SOURCE_CONTINUE;
+		return TRUE;
 	}
 
-	align->idle_id = 0;
-	return G_SOURCE_REMOVE;
+	return FALSE;
+}
+
+static gboolean
+has_before_paint_callback (GcsvAlignment *align)
+{
+	return align->before_paint_tick_id != 0 || align->before_paint_idle_id != 0;
+}
+
+static void
+remove_before_paint_callback (GcsvAlignment *align)
+{
+	if (align->before_paint_tick_id != 0)
+	{
+		gtk_widget_remove_tick_callback (align->view, align->before_paint_tick_id);
+		align->before_paint_tick_id = 0;
+	}
+
+	if (align->before_paint_idle_id != 0)
+	{
+		g_source_remove (align->before_paint_idle_id);
+		align->before_paint_idle_id = 0;
+	}
 }
 
 static void
@@ -669,17 +958,18 @@ install_idle (GcsvAlignment *align)
 		return;
 	}
 
-	/* If the idle is installed, the timeout is no longer needed. */
+	/* If the idle is installed, the timeout is no longer needed. The
+	 * before-paint subregions are handled by the chunks too.
+	 */
 	if (align->timeout_id != 0)
 	{
 		g_source_remove (align->timeout_id);
 		align->timeout_id = 0;
 	}
 
-	if (align->idle_id == 0)
-	{
-		align->idle_id = g_idle_add ((GSourceFunc) idle_cb, align);
-	}
+	remove_before_paint_callback (align);
+
+	gcsv_alignment_scheduler_add (gcsv_alignment_scheduler_get_default (), align);
 }
 
 static gboolean
@@ -705,15 +995,13 @@ install_timeout (GcsvAlignment *align)
 		return;
 	}
 
-	/* Remove the idle, because if we install a timeout it's because we want
-	 * to be more responsive. If the idle function is running, we loose the
-	 * responsiveness.
+	/* Unschedule the chunks, because if we install a timeout it's because
+	 * we want to be more responsive. If the chunks are being handled, we
+	 * loose the responsiveness.
 	 */
-	if (align->idle_id != 0)
-	{
-		g_source_remove (align->idle_id);
-		align->idle_id = 0;
-	}
+	gcsv_alignment_scheduler_remove (gcsv_alignment_scheduler_get_default (), align);
+
+	remove_before_paint_callback (align);
 
 	if (align->timeout_id != 0)
 	{
@@ -756,17 +1044,94 @@ sync_scan_and_align (GcsvAlignment *align)
 	return TRUE;
 }
 
+static void
+before_paint (GcsvAlignment *align)
+{
+	if (!sync_scan_and_align (align))
+	{
+		install_timeout (align);
+	}
+}
+
+static gboolean
+before_paint_tick_cb (GtkWidget     *view,
+		      GdkFrameClock *frame_clock,
+		      gpointer       user_data)
+{
+	GcsvAlignment *align = GCSV_ALIGNMENT (user_data);
+
+	align->before_paint_tick_id = 0;
+	before_paint (align);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+before_paint_idle_cb (GcsvAlignment *align)
+{
+	align->before_paint_idle_id = 0;
+	before_paint (align);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* The edits done since the last frame are scanned and aligned at once just
+ * before the redraw, instead of after each keystroke. With the key repeat or an
+ * input method, several characters can be inserted per frame.
+ */
+static void
+install_before_paint_callback (GcsvAlignment *align)
+{
+	if (!align->enabled ||
+	    has_before_paint_callback (align))
+	{
+		return;
+	}
+
+	/* The tick callbacks run during the update phase of the frame clock,
+	 * i.e. once per frame, before the layout and the paint.
+	 */
+	if (align->view != NULL &&
+	    gtk_widget_get_mapped (align->view))
+	{
+		align->before_paint_tick_id = gtk_widget_add_tick_callback (align->view,
+									    before_paint_tick_cb,
+									    align,
+									    NULL);
+	}
+	else
+	{
+		align->before_paint_idle_id = g_idle_add_full (BEFORE_PAINT_PRIORITY,
+							       (GSourceFunc) before_paint_idle_cb,
+							       align,
+							       NULL);
+	}
+}
+
+/* Whether an edit can be aligned before the next redraw: there is nothing else
+ * to scan or align, except other edits of the same frame.
+ */
+static gboolean
+can_align_before_paint (GcsvAlignment *align)
+{
+	if (align->strip_mark != NULL)
+	{
+		return FALSE;
+	}
+
+	return (has_before_paint_callback (align) ||
+		(gtk_source_region_is_empty (align->scan_region) &&
+		 gtk_source_region_is_empty (align->align_region)));
+}
+
 static void
 handle_mode (GcsvAlignment *align,
 	     HandleMode     mode)
 {
 	switch (mode)
 	{
-		case HANDLE_MODE_SYNC:
-			if (!sync_scan_and_align (align))
-			{
-				install_timeout (align);
-			}
+		case HANDLE_MODE_BEFORE_PAINT:
+			install_before_paint_callback (align);
 			break;
 
 		case HANDLE_MODE_IDLE:
@@ -859,6 +1224,19 @@ update_all (GcsvAlignment *align,
 
 	align->column_lengths = g_array_new (FALSE, TRUE, sizeof (gint));
 
+	/* Without delimiter there is nothing to scan or align, removing the
+	 * virtual spaces is enough.
+	 */
+	if (gcsv_buffer_get_delimiter (align->buffer) == '\0')
+	{
+		g_clear_object (&align->scan_region);
+		g_clear_object (&align->align_region);
+
+		start_stripping (align);
+		handle_mode (align, mode);
+		return;
+	}
+
 	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (align->buffer), &start, &end);
 	add_subregion (align, &start, &end, mode);
 }
@@ -868,6 +1246,10 @@ delimiter_notify_cb (GcsvBuffer    *buffer,
 		     GParamSpec    *pspec,
 		     GcsvAlignment *align)
 {
+	/* The virtual spaces of the previous delimiter are removed in bulk
+	 * first, it is much faster than adjusting each field.
+	 */
+	start_stripping (align);
 	update_all (align, HANDLE_MODE_IDLE);
 }
 
@@ -883,11 +1265,20 @@ insert_text_after_cb (GtkTextBuffer *buffer,
 	GtkTextIter end;
 	gunichar delimiter;
 
+	if (gcsv_buffer_is_virtual_spaces_edit (align->buffer))
+	{
+		return;
+	}
+
 	/* If Enter is pressed in the middle of a line, a column can shrink. So
 	 * it's simpler to update everything.
+	 * When the text is appended at the end of the buffer (e.g. by the
+	 * GcsvFileFollower), no existing field is split, so columns can only
+	 * grow: scanning and aligning the new lines is enough.
 	 */
-	if (g_utf8_strchr (text, length, '\n') != NULL ||
-	    g_utf8_strchr (text, length, '\r') != NULL)
+	if (!gtk_text_iter_is_end (location) &&
+	    (g_utf8_strchr (text, length, '\n') != NULL ||
+	     g_utf8_strchr (text, length, '\r') != NULL))
 	{
 		update_all (align, HANDLE_MODE_TIMEOUT);
 	}
@@ -901,23 +1292,14 @@ insert_text_after_cb (GtkTextBuffer *buffer,
 
 	if (delimiter != '\0' &&
 	    n_chars == 1 &&
-	    gtk_source_region_is_empty (align->scan_region) &&
-	    gtk_source_region_is_empty (align->align_region) &&
+	    can_align_before_paint (align) &&
 	    g_utf8_strchr (text, length, delimiter) == NULL)
 	{
-		GtkTextMark *mark;
-
-		mark = gtk_text_buffer_create_mark (buffer, NULL, location, TRUE);
-
-		/* When possible, it's better to re-align the buffer
-		 * synchronously, so the fields on the right are not shifted,
-		 * like in a spreadsheet.
+		/* When possible, it's better to re-align the buffer before the
+		 * next redraw, so the fields on the right are not shifted, like
+		 * in a spreadsheet.
 		 */
-		add_subregion (align, &start, &end, HANDLE_MODE_SYNC);
-
-		/* Restore location */
-		gtk_text_buffer_get_iter_at_mark (buffer, location, mark);
-		gtk_text_buffer_delete_mark (buffer, mark);
+		add_subregion (align, &start, &end, HANDLE_MODE_BEFORE_PAINT);
 	}
 	else
 	{
@@ -943,6 +1325,11 @@ delete_range_cb (GtkTextBuffer *buffer,
 	gint field_length;
 	gint column_length;
 
+	if (gcsv_buffer_is_virtual_spaces_edit (align->buffer))
+	{
+		return;
+	}
+
 	delimiter = gcsv_buffer_get_delimiter (align->buffer);
 
 	if (delimiter == '\0')
@@ -997,35 +1384,142 @@ delete_range_cb (GtkTextBuffer *buffer,
 		return;
 	}
 
-	align->sync_after_delete_range = (gtk_source_region_is_empty (align->scan_region) &&
-					  gtk_source_region_is_empty (align->align_region));
+	/* The subregion is tracked by the GtkSourceRegion, it is handled
+	 * after the deletion.
+	 */
+	add_subregion (align,
+		       &start_copy,
+		       &end_copy,
+		       can_align_before_paint (align) ? HANDLE_MODE_BEFORE_PAINT : HANDLE_MODE_TIMEOUT);
+}
 
-	add_subregion (align, &start_copy, &end_copy, HANDLE_MODE_TIMEOUT);
+static void
+block_edit_handlers (GcsvAlignment *align)
+{
+	g_signal_handler_block (align->buffer, align->insert_text_handler_id);
+	g_signal_handler_block (align->buffer, align->delete_range_handler_id);
 }
 
 static void
-delete_range_after_cb (GtkTextBuffer *buffer,
-		       GtkTextIter   *start,
-		       GtkTextIter   *end,
-		       GcsvAlignment *align)
+unblock_edit_handlers (GcsvAlignment *align)
 {
-	if (align->sync_after_delete_range)
+	g_signal_handler_unblock (align->buffer, align->insert_text_handler_id);
+	g_signal_handler_unblock (align->buffer, align->delete_range_handler_id);
+}
+
+static void
+replace_lines_cb (GcsvBuffer    *buffer,
+		  guint          start_line,
+		  guint          n_lines,
+		  const gchar   *text,
+		  GArray        *column_map,
+		  GArray        *column_lengths,
+		  GcsvAlignment *align)
+{
+	/* The replaced lines are handled as a whole in
+	 * replace_lines_after_cb().
+	 */
+	block_edit_handlers (align);
+
+	align->line_count_before_replace = gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (buffer));
+}
+
+static void
+apply_column_map (GcsvAlignment *align,
+		  GArray        *column_map)
+{
+	GArray *new_column_lengths;
+	guint i;
+
+	new_column_lengths = g_array_sized_new (FALSE, TRUE, sizeof (gint), column_map->len);
+
+	for (i = 0; i < column_map->len; i++)
 	{
-		GtkTextMark *mark;
+		gint old_column = g_array_index (column_map, gint, i);
+		gint column_length = 0;
 
-		mark = gtk_text_buffer_create_mark (buffer, NULL, start, TRUE);
+		if (old_column >= 0 && (guint) old_column < align->column_lengths->len)
+		{
+			column_length = get_column_length (align, old_column);
+		}
+
+		g_array_append_val (new_column_lengths, column_length);
+	}
 
-		/* When possible, it's better to re-align the buffer
-		 * synchronously, so the fields on the right are not shifted,
-		 * like in a spreadsheet.
+	g_array_unref (align->column_lengths);
+	align->column_lengths = new_column_lengths;
+}
+
+static gboolean
+column_lengths_equal (GArray *column_lengths_a,
+		      GArray *column_lengths_b)
+{
+	return (column_lengths_a->len == column_lengths_b->len &&
+		memcmp (column_lengths_a->data,
+			column_lengths_b->data,
+			column_lengths_a->len * sizeof (gint)) == 0);
+}
+
+static void
+replace_lines_after_cb (GcsvBuffer    *buffer,
+			guint          start_line,
+			guint          n_lines,
+			const gchar   *text,
+			GArray        *column_map,
+			GArray        *column_lengths,
+			GcsvAlignment *align)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+	gint n_new_lines;
+
+	unblock_edit_handlers (align);
+
+	/* A pending scan means that the column lengths are not all known, so
+	 * the column map can't be applied.
+	 */
+	if (align->scan_region != NULL)
+	{
+		update_all (align, HANDLE_MODE_IDLE);
+		return;
+	}
+
+	n_new_lines = n_lines +
+		gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (buffer)) -
+		align->line_count_before_replace;
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &start, start_line);
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &end, start_line + MAX (n_new_lines, 1) - 1);
+
+	if (column_lengths != NULL)
+	{
+		/* The column lengths have been computed from all the lines
+		 * once replaced, and can shrink. When they change, the other
+		 * lines must be aligned again too.
 		 */
-		handle_mode (align, HANDLE_MODE_SYNC);
-		align->sync_after_delete_range = FALSE;
+		if (!column_lengths_equal (align->column_lengths, column_lengths))
+		{
+			gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (buffer), &start, &end);
+		}
+
+		g_array_unref (align->column_lengths);
+		align->column_lengths = g_array_sized_new (FALSE, TRUE, sizeof (gint), column_lengths->len);
+		g_array_append_vals (align->column_lengths, column_lengths->data, column_lengths->len);
 
-		/* Restore location */
-		gtk_text_buffer_get_iter_at_mark (buffer, start, mark);
-		*end = *start;
-		gtk_text_buffer_delete_mark (buffer, mark);
+		add_subregion_to_align (align, &start, &end);
+		handle_mode (align, HANDLE_MODE_IDLE);
+	}
+	else if (column_map != NULL)
+	{
+		/* No need to scan the new lines. */
+		apply_column_map (align, column_map);
+		add_subregion_to_align (align, &start, &end);
+		handle_mode (align, HANDLE_MODE_IDLE);
+	}
+	else
+	{
+		/* The column lengths can only grow, like for other insertions. */
+		add_subregion (align, &start, &end, HANDLE_MODE_IDLE);
 	}
 }
 
@@ -1059,12 +1553,21 @@ connect_signals (GcsvAlignment *align)
 					  align);
 	}
 
-	if (align->delete_range_after_handler_id == 0)
+	if (align->replace_lines_handler_id == 0)
+	{
+		align->replace_lines_handler_id =
+			g_signal_connect (align->buffer,
+					  "replace-lines",
+					  G_CALLBACK (replace_lines_cb),
+					  align);
+	}
+
+	if (align->replace_lines_after_handler_id == 0)
 	{
-		align->delete_range_after_handler_id =
+		align->replace_lines_after_handler_id =
 			g_signal_connect_after (align->buffer,
-						"delete-range",
-						G_CALLBACK (delete_range_after_cb),
+						"replace-lines",
+						G_CALLBACK (replace_lines_after_cb),
 						align);
 	}
 }
@@ -1090,10 +1593,16 @@ disconnect_signals (GcsvAlignment *align)
 		align->delete_range_handler_id = 0;
 	}
 
-	if (align->delete_range_after_handler_id != 0)
+	if (align->replace_lines_handler_id != 0)
 	{
-		g_signal_handler_disconnect (align->buffer, align->delete_range_after_handler_id);
-		align->delete_range_after_handler_id = 0;
+		g_signal_handler_disconnect (align->buffer, align->replace_lines_handler_id);
+		align->replace_lines_handler_id = 0;
+	}
+
+	if (align->replace_lines_after_handler_id != 0)
+	{
+		g_signal_handler_disconnect (align->buffer, align->replace_lines_after_handler_id);
+		align->replace_lines_after_handler_id = 0;
 	}
 }
 
@@ -1130,11 +1639,13 @@ set_buffer (GcsvAlignment *align,
 	g_return_if_fail (GCSV_IS_BUFFER (buffer));
 	align->buffer = g_object_ref (buffer);
 
-	align->tag = gtk_source_buffer_create_source_tag (GTK_SOURCE_BUFFER (buffer),
-							  NULL,
-							  "draw-spaces", FALSE,
-							  NULL);
-	g_object_ref (align->tag);
+	align->tag = g_object_ref (gcsv_buffer_get_virtual_spaces_tag (buffer));
+
+	align->long_lines_tag = gtk_text_buffer_create_tag (GTK_TEXT_BUFFER (buffer),
+							    NULL,
+							    "wrap-mode", GTK_WRAP_CHAR,
+							    NULL);
+	g_object_ref (align->long_lines_tag);
 
 	if (align->enabled)
 	{
@@ -1206,17 +1717,15 @@ gcsv_alignment_set_property (GObject      *object,
 static void
 remove_event_sources (GcsvAlignment *align)
 {
-	if (align->idle_id != 0)
-	{
-		g_source_remove (align->idle_id);
-		align->idle_id = 0;
-	}
+	gcsv_alignment_scheduler_remove (gcsv_alignment_scheduler_get_default (), align);
 
 	if (align->timeout_id != 0)
 	{
 		g_source_remove (align->timeout_id);
 		align->timeout_id = 0;
 	}
+
+	remove_before_paint_callback (align);
 }
 
 static void
@@ -1226,27 +1735,21 @@ gcsv_alignment_dispose (GObject *object)
 
 	disconnect_signals (align);
 	remove_event_sources (align);
+	gcsv_alignment_set_view (align, NULL);
 
 	g_clear_object (&align->scan_region);
 	g_clear_object (&align->align_region);
 
-	if (align->buffer != NULL)
+	if (align->strip_mark != NULL)
 	{
-		if (align->tag != NULL)
-		{
-			GtkTextTagTable *table;
-
-			table = gtk_text_buffer_get_tag_table (GTK_TEXT_BUFFER (align->buffer));
-			gtk_text_tag_table_remove (table, align->tag);
-
-			g_object_unref (align->tag);
-			align->tag = NULL;
-		}
-
-		g_object_unref (align->buffer);
-		align->buffer = NULL;
+		gtk_text_buffer_delete_mark (GTK_TEXT_BUFFER (align->buffer), align->strip_mark);
+		align->strip_mark = NULL;
 	}
 
+	g_clear_object (&align->tag);
+	g_clear_object (&align->long_lines_tag);
+	g_clear_object (&align->buffer);
+
 	G_OBJECT_CLASS (gcsv_alignment_parent_class)->dispose (object);
 }
 
@@ -1297,6 +1800,11 @@ gcsv_alignment_class_init (GcsvAlignmentClass *klass)
 static void
 gcsv_alignment_init (GcsvAlignment *align)
 {
+	align->priority = GCSV_ALIGNMENT_PRIORITY_VISIBLE;
+	align->viewport_first_line = -1;
+	align->viewport_last_line = -1;
+	align->n_aligned_columns = G_MAXUINT;
+	align->max_line_length = DEFAULT_MAX_LINE_LENGTH;
 }
 
 GcsvAlignment *
@@ -1338,68 +1846,258 @@ gcsv_alignment_set_enabled (GcsvAlignment *align,
 	g_object_notify (G_OBJECT (align), "enabled");
 }
 
+static void
+view_destroy_cb (GtkWidget     *view,
+		 GcsvAlignment *align)
+{
+	gcsv_alignment_set_view (align, NULL);
+}
+
+/* Sets the view of the buffer. Its frame clock is used to align the keystrokes
+ * once per frame. %NULL to unset it.
+ */
+void
+gcsv_alignment_set_view (GcsvAlignment *align,
+			 GtkWidget     *view)
+{
+	gboolean had_before_paint_callback;
+
+	g_return_if_fail (GCSV_IS_ALIGNMENT (align));
+	g_return_if_fail (view == NULL || GTK_IS_WIDGET (view));
+
+	if (align->view == view)
+	{
+		return;
+	}
+
+	/* The pending edits are aligned with the new view, or in an idle. */
+	had_before_paint_callback = has_before_paint_callback (align);
+	remove_before_paint_callback (align);
+
+	if (align->view != NULL)
+	{
+		g_signal_handlers_disconnect_by_func (align->view, view_destroy_cb, align);
+	}
+
+	align->view = view;
+
+	if (view != NULL)
+	{
+		g_signal_connect (view,
+				  "destroy",
+				  G_CALLBACK (view_destroy_cb),
+				  align);
+	}
+
+	if (had_before_paint_callback)
+	{
+		install_before_paint_callback (align);
+	}
+}
+
 TeplBuffer *
 gcsv_alignment_copy_buffer_without_alignment (GcsvAlignment *align)
 {
 	GtkTextBuffer *copy;
-	GtkTextIter iter;
-	GtkTextIter insert;
+	GtkTextIter start;
+	GtkTextIter end;
+	gchar *text;
 
 	copy = GTK_TEXT_BUFFER (tepl_buffer_new ());
 
-	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (align->buffer), &iter);
-	gtk_text_buffer_get_start_iter (copy, &insert);
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (align->buffer), &start, &end);
+	text = gcsv_buffer_get_text_without_virtual_spaces (align->buffer, &start, &end);
+	gtk_text_buffer_set_text (copy, text, -1);
+	g_free (text);
+
+	return TEPL_BUFFER (copy);
+}
 
-	while (!gtk_text_iter_is_end (&iter))
+void
+gcsv_alignment_set_unit_test_mode (GcsvAlignment *align,
+				   gboolean       unit_test_mode)
+{
+	g_return_if_fail (GCSV_IS_ALIGNMENT (align));
+
+	align->unit_test_mode = unit_test_mode != FALSE;
+
+	if (align->timeout_id != 0)
 	{
-		GtkTextIter start;
-		GtkTextIter end;
-		gchar *text;
+		install_idle (align);
+	}
+}
 
-		start = iter;
-		if (gtk_text_iter_starts_tag (&start, align->tag))
-		{
-			gtk_text_iter_forward_to_tag_toggle (&start, align->tag);
-			g_assert (gtk_text_iter_ends_tag (&start, align->tag));
-		}
+/* The priority of the background work, i.e. the chunks handled by the
+ * GcsvAlignmentScheduler. The default is %GCSV_ALIGNMENT_PRIORITY_VISIBLE.
+ */
+void
+gcsv_alignment_set_priority (GcsvAlignment         *align,
+			     GcsvAlignmentPriority  priority)
+{
+	g_return_if_fail (GCSV_IS_ALIGNMENT (align));
 
-		g_assert (!gtk_text_iter_has_tag (&start, align->tag));
+	if (align->priority != priority)
+	{
+		align->priority = priority;
+		gcsv_alignment_scheduler_reschedule (gcsv_alignment_scheduler_get_default ());
+	}
+}
 
-		if (gtk_text_iter_is_end (&start))
-		{
-			break;
-		}
+GcsvAlignmentPriority
+gcsv_alignment_get_priority (GcsvAlignment *align)
+{
+	g_return_val_if_fail (GCSV_IS_ALIGNMENT (align), GCSV_ALIGNMENT_PRIORITY_VISIBLE);
 
-		end = start;
-		if (gtk_text_iter_forward_to_tag_toggle (&end, align->tag))
-		{
-			g_assert (gtk_text_iter_starts_tag (&end, align->tag));
-		}
-		else
+	return align->priority;
+}
+
+/* Sets the lines currently visible, they are aligned before the other lines.
+ * @first_line and @last_line are included. Pass -1 for both to unset it.
+ */
+void
+gcsv_alignment_set_viewport (GcsvAlignment *align,
+			     gint           first_line,
+			     gint           last_line)
+{
+	g_return_if_fail (GCSV_IS_ALIGNMENT (align));
+	g_return_if_fail (first_line <= last_line);
+
+	align->viewport_first_line = first_line;
+	align->viewport_last_line = last_line;
+}
+
+/* For very wide lines, with thousands of columns, where only a few columns fit
+ * in the view. Only the columns up to @column_num, plus a margin, are aligned;
+ * the next ones stay compact until they are scrolled into view. So the memory
+ * and the time to align a line depend on the visible width, not on the number
+ * of columns. The columns before the visible ones are still aligned, so that
+ * the horizontal position of the visible columns doesn't change.
+ *
+ * Pass -1 to align all the columns, which is the default.
+ */
+void
+gcsv_alignment_set_last_visible_column (GcsvAlignment *align,
+					gint           column_num)
+{
+	guint n_aligned_columns;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	g_return_if_fail (GCSV_IS_ALIGNMENT (align));
+	g_return_if_fail (column_num >= -1);
+
+	if (column_num < 0)
+	{
+		n_aligned_columns = G_MAXUINT;
+	}
+	else
+	{
+		guint n_visible_columns = column_num + 1;
+
+		/* Keep the current columns while the margin is not half used
+		 * or too big.
+		 */
+		if (align->n_aligned_columns != G_MAXUINT &&
+		    n_visible_columns + COLUMN_MARGIN / 2 <= align->n_aligned_columns &&
+		    align->n_aligned_columns <= n_visible_columns + 2 * COLUMN_MARGIN)
 		{
-			g_assert (gtk_text_iter_is_end (&end));
+			return;
 		}
 
-		text = gtk_text_buffer_get_text (GTK_TEXT_BUFFER (align->buffer), &start, &end, TRUE);
-		gtk_text_buffer_insert (copy, &insert, text, -1);
-		g_free (text);
+		n_aligned_columns = n_visible_columns + COLUMN_MARGIN;
+	}
 
-		iter = end;
+	if (align->n_aligned_columns == n_aligned_columns)
+	{
+		return;
 	}
 
-	return TEPL_BUFFER (copy);
+	align->n_aligned_columns = n_aligned_columns;
+
+	if (align->buffer != NULL && align->enabled)
+	{
+		/* The viewport is re-aligned first. */
+		gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (align->buffer), &start, &end);
+		add_subregion_to_align (align, &start, &end);
+		handle_mode (align, HANDLE_MODE_IDLE);
+	}
 }
 
+/* Lines longer than @max_line_length characters, virtual spaces included, are
+ * neither aligned nor taken into account for the column lengths, and they are
+ * wrapped in the view. Otherwise each keystroke in a line of several megabytes
+ * would be followed by re-computing its field lengths, and the view would lay
+ * it out as a single row. Pass G_MAXUINT to align all the lines.
+ */
 void
-gcsv_alignment_set_unit_test_mode (GcsvAlignment *align,
-				   gboolean       unit_test_mode)
+gcsv_alignment_set_max_line_length (GcsvAlignment *align,
+				    guint          max_line_length)
 {
 	g_return_if_fail (GCSV_IS_ALIGNMENT (align));
 
-	align->unit_test_mode = unit_test_mode != FALSE;
+	if (align->max_line_length == max_line_length)
+	{
+		return;
+	}
 
-	if (align->timeout_id != 0)
+	align->max_line_length = max_line_length;
+
+	if (align->buffer != NULL)
 	{
-		install_idle (align);
+		update_all (align, HANDLE_MODE_IDLE);
+	}
+}
+
+static guint
+count_lines (GtkSourceRegion *region)
+{
+	GtkSourceRegionIter region_iter;
+	guint n_lines = 0;
+
+	if (region == NULL)
+	{
+		return 0;
 	}
+
+	gtk_source_region_get_start_region_iter (region, &region_iter);
+
+	while (!gtk_source_region_iter_is_end (&region_iter))
+	{
+		GtkTextIter subregion_start;
+		GtkTextIter subregion_end;
+
+		gtk_source_region_iter_get_subregion (&region_iter,
+						      &subregion_start,
+						      &subregion_end);
+
+		n_lines += gtk_text_iter_get_line (&subregion_end) - gtk_text_iter_get_line (&subregion_start) + 1;
+
+		gtk_source_region_iter_next (&region_iter);
+	}
+
+	return n_lines;
+}
+
+/* Returns: the number of lines that remain to be stripped, scanned or aligned.
+ * A line counts several times if it needs several of them.
+ */
+guint
+gcsv_alignment_get_queue_depth (GcsvAlignment *align)
+{
+	guint n_lines_to_strip = 0;
+
+	g_return_val_if_fail (GCSV_IS_ALIGNMENT (align), 0);
+
+	if (align->strip_mark != NULL)
+	{
+		GtkTextIter iter;
+
+		gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (align->buffer), &iter, align->strip_mark);
+		n_lines_to_strip = (gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (align->buffer)) -
+				    gtk_text_iter_get_line (&iter));
+	}
+
+	return (n_lines_to_strip +
+		count_lines (align->scan_region) +
+		count_lines (align->align_region));
 }
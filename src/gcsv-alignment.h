@@ -27,6 +27,20 @@
 
 G_BEGIN_DECLS
 
+/**
+ * GcsvAlignmentPriority:
+ * @GCSV_ALIGNMENT_PRIORITY_BACKGROUND: the buffer is not visible, for example
+ *   the window is minimized. The chunks are throttled.
+ * @GCSV_ALIGNMENT_PRIORITY_VISIBLE: the buffer is visible.
+ * @GCSV_ALIGNMENT_PRIORITY_FOCUSED: the buffer is in the focused window.
+ */
+typedef enum
+{
+	GCSV_ALIGNMENT_PRIORITY_BACKGROUND,
+	GCSV_ALIGNMENT_PRIORITY_VISIBLE,
+	GCSV_ALIGNMENT_PRIORITY_FOCUSED,
+} GcsvAlignmentPriority;
+
 #define GCSV_TYPE_ALIGNMENT (gcsv_alignment_get_type ())
 G_DECLARE_FINAL_TYPE (GcsvAlignment, gcsv_alignment,
 		      GCSV, ALIGNMENT,
@@ -37,11 +51,34 @@ GcsvAlignment *	gcsv_alignment_new				(GcsvBuffer *buffer);
 void		gcsv_alignment_set_enabled			(GcsvAlignment *align,
 								 gboolean       enabled);
 
+void		gcsv_alignment_set_view				(GcsvAlignment *align,
+								 GtkWidget     *view);
+
 TeplBuffer *	gcsv_alignment_copy_buffer_without_alignment	(GcsvAlignment *align);
 
 void		gcsv_alignment_set_unit_test_mode		(GcsvAlignment *align,
 								 gboolean       unit_test_mode);
 
+void		gcsv_alignment_set_priority			(GcsvAlignment         *align,
+								 GcsvAlignmentPriority  priority);
+
+GcsvAlignmentPriority
+		gcsv_alignment_get_priority			(GcsvAlignment *align);
+
+void		gcsv_alignment_set_viewport			(GcsvAlignment *align,
+								 gint           first_line,
+								 gint           last_line);
+
+void		gcsv_alignment_set_last_visible_column		(GcsvAlignment *align,
+								 gint           column_num);
+
+void		gcsv_alignment_set_max_line_length		(GcsvAlignment *align,
+								 guint          max_line_length);
+
+guint		gcsv_alignment_get_queue_depth			(GcsvAlignment *align);
+
+gboolean	gcsv_alignment_process_next_chunk		(GcsvAlignment *align);
+
 G_END_DECLS
 
 #endif /* GCSV_ALIGNMENT_H */
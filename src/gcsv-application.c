@@ -21,6 +21,7 @@
 #include "gcsv-application.h"
 #include <tepl/tepl.h>
 #include <glib/gi18n.h>
+#include "gcsv-cli.h"
 #include "gcsv-window.h"
 
 #ifdef G_OS_WIN32
@@ -33,6 +34,11 @@
 #endif
 
 static gboolean option_version;
+static gboolean option_align;
+static gboolean option_unalign;
+static gchar *option_input;
+static gchar *option_delimiter;
+static gint option_titles_line = 1;
 
 static GOptionEntry options[] = {
 	{ "version", 'v',
@@ -41,6 +47,43 @@ static GOptionEntry options[] = {
 	  NULL
 	},
 
+	/* Not stored in a variable, see open_files_read_only(). */
+	{ "read-only", 'r',
+	  G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, NULL,
+	  N_("Open the file read-only, without loading it into memory (for very large files)"),
+	  NULL
+	},
+
+	{ "align", '\0',
+	  G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &option_align,
+	  N_("Align the columns of the input and write the result to the standard output, without opening a window"),
+	  NULL
+	},
+
+	{ "unalign", '\0',
+	  G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &option_unalign,
+	  N_("Remove the alignment of the input and write the result to the standard output, without opening a window"),
+	  NULL
+	},
+
+	{ "input", 'i',
+	  G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME, &option_input,
+	  N_("Input file for --align and --unalign (default: the standard input)"),
+	  N_("FILE")
+	},
+
+	{ "delimiter", 'd',
+	  G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &option_delimiter,
+	  N_("Delimiter for --align and --unalign (default: guessed)"),
+	  N_("CHAR")
+	},
+
+	{ "titles-line", '\0',
+	  G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &option_titles_line,
+	  N_("Column titles line for --align and --unalign, the lines before are copied as is (default: 1)"),
+	  N_("LINE")
+	},
+
         { NULL }
 };
 
@@ -72,6 +115,54 @@ add_action_info_entries (GcsvApplication *gcsv_app)
 
 		{ "win.save-as", "document-save-as", N_("Save _As"), "<Shift><Control>s",
 		  N_("Save the current file with a different name") },
+
+		{ "win.grid-view", NULL, N_("_Grid View"), NULL,
+		  N_("Show the fields in a grid of text entries") },
+
+		{ "win.filter-bar", NULL, N_("_Filter Rows"), "<Shift><Control>f",
+		  N_("Show only the rows where a column matches a pattern") },
+
+		{ "win.search-bar", "edit-find", N_("_Find in Columns"), "<Control>f",
+		  N_("Search in some columns only, without the alignment spaces") },
+
+		{ "win.stats-panel", NULL, N_("Column _Statistics"), NULL,
+		  N_("Show statistics on the values of a column") },
+
+		{ "win.follow", NULL, N_("F_ollow File Changes"), NULL,
+		  N_("Append the rows written to the file, like “tail -f”") },
+
+		{ "win.follow-auto-scroll", NULL, N_("Scroll to _New Rows"), NULL,
+		  N_("Scroll to the end when rows are appended while following the file") },
+
+		{ "win.next-ragged-row", "go-down", N_("_Next Ragged Row"), "F8",
+		  N_("Go to the next row without the expected number of columns") },
+
+		{ "win.previous-ragged-row", "go-up", N_("_Previous Ragged Row"), "<Shift>F8",
+		  N_("Go to the previous row without the expected number of columns") },
+
+		{ "win.insert-column", NULL, N_("_Insert Column"), NULL,
+		  N_("Insert an empty column before the current column") },
+
+		{ "win.delete-column", NULL, N_("D_elete Column"), NULL,
+		  N_("Delete the current column") },
+
+		{ "win.duplicate-column", NULL, N_("D_uplicate Column"), NULL,
+		  N_("Insert a copy of the current column after it") },
+
+		{ "win.move-column-left", NULL, N_("Move Column _Left"), NULL,
+		  N_("Swap the current column with the previous one") },
+
+		{ "win.move-column-right", NULL, N_("Move Column _Right"), NULL,
+		  N_("Swap the current column with the next one") },
+
+		{ "win.sort-by-column-text", NULL, N_("_Sort Rows by Column"), NULL,
+		  N_("Sort the rows by the text of the current column") },
+
+		{ "win.sort-by-column-numeric", NULL, N_("Sort Rows by Column _Numerically"), NULL,
+		  N_("Sort the rows by the numbers of the current column") },
+
+		{ "win.sort-by-column-locale", NULL, N_("Sort Rows by Column in _Alphabetical Order"), NULL,
+		  N_("Sort the rows by the current column, with the rules of the current language") },
 	};
 
 	tepl_app = tepl_application_get_from_gtk_application (GTK_APPLICATION (gcsv_app));
@@ -90,6 +181,53 @@ get_active_gcsv_window (GcsvApplication *app)
 	return GCSV_WINDOW (tepl_application_get_active_main_window (tepl_app));
 }
 
+/* The files are opened here with the read-only hint, instead of by the default
+ * GApplication implementation, so that the --read-only option applies to this
+ * invocation only, and is forwarded to the primary instance.
+ */
+static gint
+open_files_read_only (GApplication *app,
+		      GVariantDict *options_dict)
+{
+	const gchar **remaining = NULL;
+	GFile **files;
+	guint n_files;
+	guint i;
+	GError *error = NULL;
+
+	if (!g_variant_dict_lookup (options_dict, G_OPTION_REMAINING, "^a&ay", &remaining))
+	{
+		return -1;
+	}
+
+	if (!g_application_register (app, NULL, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		g_free (remaining);
+		return 1;
+	}
+
+	n_files = g_strv_length ((gchar **) remaining);
+	files = g_new0 (GFile *, n_files);
+
+	for (i = 0; i < n_files; i++)
+	{
+		files[i] = g_file_new_for_commandline_arg (remaining[i]);
+	}
+
+	g_application_open (app, files, n_files, GCSV_OPEN_HINT_READ_ONLY);
+
+	for (i = 0; i < n_files; i++)
+	{
+		g_object_unref (files[i]);
+	}
+
+	g_free (files);
+	g_free (remaining);
+	return 0;
+}
+
 static gint
 gcsv_application_handle_local_options (GApplication *app,
 				       GVariantDict *options_dict)
@@ -100,6 +238,49 @@ gcsv_application_handle_local_options (GApplication *app,
 		return 0;
 	}
 
+	if (option_align && option_unalign)
+	{
+		g_printerr (_("The --align and --unalign options are mutually exclusive.\n"));
+		return 1;
+	}
+
+	if (option_align || option_unalign)
+	{
+		GError *error = NULL;
+
+		if (option_titles_line < 1)
+		{
+			g_printerr (_("The --titles-line option must be at least 1.\n"));
+			return 1;
+		}
+
+		gcsv_cli_run (option_align ? GCSV_CLI_MODE_ALIGN : GCSV_CLI_MODE_UNALIGN,
+			      option_input,
+			      NULL,
+			      option_delimiter,
+			      option_titles_line - 1,
+			      &error);
+
+		if (error != NULL)
+		{
+			g_printerr ("%s\n", error->message);
+			g_error_free (error);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if (g_variant_dict_contains (options_dict, "read-only"))
+	{
+		gint exit_status = open_files_read_only (app, options_dict);
+
+		if (exit_status >= 0)
+		{
+			return exit_status;
+		}
+	}
+
 	if (G_APPLICATION_CLASS (gcsv_application_parent_class)->handle_local_options != NULL)
 	{
 		return G_APPLICATION_CLASS (gcsv_application_parent_class)->handle_local_options (app, options_dict);
@@ -312,7 +493,15 @@ gcsv_application_open (GApplication  *app,
 		gtk_widget_show (GTK_WIDGET (window));
 	}
 
-	gcsv_window_load_file (window, files[0]);
+	/* Set by the --read-only option, or by the Open dialog. */
+	if (g_strcmp0 (hint, GCSV_OPEN_HINT_READ_ONLY) == 0)
+	{
+		gcsv_window_load_file_read_only (window, files[0]);
+	}
+	else
+	{
+		gcsv_window_load_file (window, files[0]);
+	}
 }
 
 static void
@@ -0,0 +1,263 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-block-hashes.h"
+#include "gcsv-tokenizer.h"
+
+/* Hashes of a text by blocks of lines, to find quickly which lines differ
+ * between two versions of a file.
+ *
+ * The block boundaries depend on the content, not on the line numbers: a block
+ * ends after a line whose hash has its low bits to zero. So when lines are
+ * inserted or deleted, only the blocks around the change differ, the next
+ * blocks are the same in both versions. MIN_BLOCK_N_LINES and
+ * MAX_BLOCK_N_LINES bound the block sizes for unusual contents, for example
+ * when all the lines are equal.
+ *
+ * The line terminators are hashed with the lines, so a change of line
+ * terminator is a change.
+ */
+
+typedef struct _Block Block;
+struct _Block
+{
+	guint64 hash;
+	gsize offset;
+	gsize length;
+	guint first_line;
+	guint n_lines;
+};
+
+struct _GcsvBlockHashes
+{
+	/* Array of Block's. */
+	GArray *blocks;
+	guint n_lines;
+	gsize length;
+};
+
+/* 256 lines per block on average. */
+#define BOUNDARY_MASK 0xff
+#define MIN_BLOCK_N_LINES 16
+#define MAX_BLOCK_N_LINES 4096
+
+#define FNV_OFFSET_BASIS G_GUINT64_CONSTANT (14695981039346656037)
+#define FNV_PRIME G_GUINT64_CONSTANT (1099511628211)
+
+/* Checking the cancellable for every line would be too costly. */
+#define CANCELLABLE_CHECK_INTERVAL 4096
+
+/* FNV-1a */
+static guint64
+hash_bytes (const gchar *p,
+	    const gchar *end)
+{
+	guint64 hash = FNV_OFFSET_BASIS;
+
+	for (; p < end; p++)
+	{
+		hash ^= (guchar) *p;
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/* Returns: (nullable): the hashes of @text, or %NULL if @cancellable has been
+ * cancelled. Blocking function, meant to be called in a worker thread.
+ */
+GcsvBlockHashes *
+gcsv_block_hashes_new (const gchar  *text,
+		       gsize         length,
+		       GCancellable *cancellable)
+{
+	GcsvBlockHashes *hashes;
+	const gchar *end = text + length;
+	const gchar *p = text;
+	Block block = { FNV_OFFSET_BASIS, 0, 0, 0, 0 };
+
+	g_return_val_if_fail (text != NULL || length == 0, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+
+	hashes = g_new0 (GcsvBlockHashes, 1);
+	hashes->blocks = g_array_new (FALSE, FALSE, sizeof (Block));
+	hashes->length = length;
+
+	while (p < end)
+	{
+		const gchar *next_line_start;
+		guint64 line_hash;
+
+		gcsv_tokenizer_find_line_end (p, end, &next_line_start);
+		line_hash = hash_bytes (p, next_line_start);
+
+		block.hash = (block.hash ^ line_hash) * FNV_PRIME;
+		block.n_lines++;
+		hashes->n_lines++;
+		p = next_line_start;
+
+		if ((block.n_lines >= MIN_BLOCK_N_LINES && (line_hash & BOUNDARY_MASK) == 0) ||
+		    block.n_lines >= MAX_BLOCK_N_LINES ||
+		    p == end)
+		{
+			block.length = p - text - block.offset;
+			g_array_append_val (hashes->blocks, block);
+
+			block.hash = FNV_OFFSET_BASIS;
+			block.offset = p - text;
+			block.first_line = hashes->n_lines;
+			block.n_lines = 0;
+		}
+
+		if (hashes->n_lines % CANCELLABLE_CHECK_INTERVAL == 0 &&
+		    g_cancellable_is_cancelled (cancellable))
+		{
+			gcsv_block_hashes_free (hashes);
+			return NULL;
+		}
+	}
+
+	return hashes;
+}
+
+void
+gcsv_block_hashes_free (GcsvBlockHashes *hashes)
+{
+	if (hashes != NULL)
+	{
+		g_array_unref (hashes->blocks);
+		g_free (hashes);
+	}
+}
+
+guint
+gcsv_block_hashes_get_n_lines (const GcsvBlockHashes *hashes)
+{
+	g_return_val_if_fail (hashes != NULL, 0);
+
+	return hashes->n_lines;
+}
+
+guint
+gcsv_block_hashes_get_n_blocks (const GcsvBlockHashes *hashes)
+{
+	g_return_val_if_fail (hashes != NULL, 0);
+
+	return hashes->blocks->len;
+}
+
+static const Block *
+get_block (const GcsvBlockHashes *hashes,
+	   guint                  block_num)
+{
+	return &g_array_index (hashes->blocks, Block, block_num);
+}
+
+static gboolean
+blocks_equal (const Block *block1,
+	      const Block *block2)
+{
+	return (block1->hash == block2->hash &&
+		block1->n_lines == block2->n_lines &&
+		block1->length == block2->length);
+}
+
+/* Compares the blocks of two versions of a text. The lines before and after the
+ * differing lines are the same in both versions, so replacing the
+ * @diff->old_n_lines lines at @diff->start_line by the new text between
+ * @diff->new_start and @diff->new_end gives the new version.
+ *
+ * The differing lines are found at the granularity of the blocks, so @diff
+ * can contain some unchanged lines around the changed ones.
+ *
+ * Returns: whether the texts differ.
+ */
+gboolean
+gcsv_block_hashes_diff (const GcsvBlockHashes *old_hashes,
+			const GcsvBlockHashes *new_hashes,
+			GcsvBlockDiff         *diff)
+{
+	guint old_n_blocks;
+	guint new_n_blocks;
+	guint n_common_first = 0;
+	guint n_common_last = 0;
+	guint old_end_line;
+	guint new_end_line;
+
+	g_return_val_if_fail (old_hashes != NULL, FALSE);
+	g_return_val_if_fail (new_hashes != NULL, FALSE);
+	g_return_val_if_fail (diff != NULL, FALSE);
+
+	old_n_blocks = old_hashes->blocks->len;
+	new_n_blocks = new_hashes->blocks->len;
+
+	while (n_common_first < MIN (old_n_blocks, new_n_blocks) &&
+	       blocks_equal (get_block (old_hashes, n_common_first),
+			     get_block (new_hashes, n_common_first)))
+	{
+		n_common_first++;
+	}
+
+	if (n_common_first == old_n_blocks &&
+	    n_common_first == new_n_blocks)
+	{
+		return FALSE;
+	}
+
+	while (n_common_last < MIN (old_n_blocks, new_n_blocks) - n_common_first &&
+	       blocks_equal (get_block (old_hashes, old_n_blocks - 1 - n_common_last),
+			     get_block (new_hashes, new_n_blocks - 1 - n_common_last)))
+	{
+		n_common_last++;
+	}
+
+	if (n_common_first < new_n_blocks)
+	{
+		const Block *first_block = get_block (new_hashes, n_common_first);
+
+		diff->start_line = first_block->first_line;
+		diff->new_start = first_block->offset;
+	}
+	else
+	{
+		diff->start_line = new_hashes->n_lines;
+		diff->new_start = new_hashes->length;
+	}
+
+	if (n_common_last > 0)
+	{
+		const Block *old_block = get_block (old_hashes, old_n_blocks - n_common_last);
+		const Block *new_block = get_block (new_hashes, new_n_blocks - n_common_last);
+
+		old_end_line = old_block->first_line;
+		new_end_line = new_block->first_line;
+		diff->new_end = new_block->offset;
+	}
+	else
+	{
+		old_end_line = old_hashes->n_lines;
+		new_end_line = new_hashes->n_lines;
+		diff->new_end = new_hashes->length;
+	}
+
+	diff->old_n_lines = old_end_line - diff->start_line;
+	diff->new_n_lines = new_end_line - diff->start_line;
+
+	return TRUE;
+}
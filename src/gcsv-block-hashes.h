@@ -0,0 +1,58 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_BLOCK_HASHES_H
+#define GCSV_BLOCK_HASHES_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GcsvBlockHashes GcsvBlockHashes;
+
+/* The lines that differ between two texts, see gcsv_block_hashes_diff(). */
+typedef struct _GcsvBlockDiff GcsvBlockDiff;
+struct _GcsvBlockDiff
+{
+	guint start_line;
+	guint old_n_lines;
+	guint new_n_lines;
+
+	/* The byte range of the new lines in the new text. */
+	gsize new_start;
+	gsize new_end;
+};
+
+GcsvBlockHashes *	gcsv_block_hashes_new		(const gchar  *text,
+							 gsize         length,
+							 GCancellable *cancellable);
+
+void			gcsv_block_hashes_free		(GcsvBlockHashes *hashes);
+
+guint			gcsv_block_hashes_get_n_lines	(const GcsvBlockHashes *hashes);
+
+guint			gcsv_block_hashes_get_n_blocks	(const GcsvBlockHashes *hashes);
+
+gboolean		gcsv_block_hashes_diff		(const GcsvBlockHashes *old_hashes,
+							 const GcsvBlockHashes *new_hashes,
+							 GcsvBlockDiff         *diff);
+
+G_END_DECLS
+
+#endif /* GCSV_BLOCK_HASHES_H */
@@ -23,6 +23,12 @@
 #include "gcsv-buffer.h"
 #include <glib/gi18n.h>
 #include <stdlib.h>
+#include <string.h>
+#include "gcsv-column-widths.h"
+#include "gcsv-replace.h"
+#include "gcsv-sort.h"
+#include "gcsv-tokenizer.h"
+#include "gcsv-undo-manager.h"
 
 struct _GcsvBuffer
 {
@@ -35,6 +41,35 @@ struct _GcsvBuffer
 
 	/* The column titles location, i.e. the header end boundary. */
 	GtkTextMark *title_mark;
+
+	/* The alignment is done by inserting spaces to the buffer, see
+	 * GcsvAlignment. The spaces are surrounded by this tag, so we know
+	 * where the alignment is.
+	 */
+	GtkTextTag *virtual_spaces_tag;
+
+	/* Nesting level of gcsv_buffer_begin_virtual_spaces_edit(). */
+	guint virtual_spaces_edit_depth;
+
+	/* Incremented by each edit of the text, except the virtual spaces. A
+	 * worker thread working on a copy of the text compares it when it has
+	 * finished, to know if the text has been modified in the meantime.
+	 */
+	guint64 change_count;
+
+	/* Cache of the character offsets of the delimiters in one line, to
+	 * compute the column number at the cursor and the field bounds without
+	 * walking the line. Updated in place when an edit doesn't add or remove
+	 * a line, so typing in a very long line doesn't re-scan it; otherwise
+	 * invalidated (cached_line set to -1).
+	 */
+	GArray *line_delimiters;
+	gint cached_line;
+
+	/* To move the title_mark at most once per main loop iteration when the
+	 * cursor moves.
+	 */
+	guint title_mark_idle_id;
 };
 
 enum
@@ -46,11 +81,15 @@ enum
 enum
 {
 	SIGNAL_COLUMN_TITLES_SET,
+	SIGNAL_REPLACE_LINES,
 	LAST_SIGNAL
 };
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
+/* GtkTextBuffer::modified-changed */
+static guint modified_changed_signal_id;
+
 G_DEFINE_TYPE (GcsvBuffer, gcsv_buffer, TEPL_TYPE_BUFFER)
 
 #define METADATA_DELIMITER	"gcsvedit-delimiter"
@@ -104,6 +143,7 @@ gcsv_buffer_constructed (GObject *object)
 	GtkSourceLanguage *csv_lang;
 	GtkSourceStyleSchemeManager *scheme_manager;
 	GtkSourceStyleScheme *scheme;
+	GcsvUndoManager *undo_manager;
 
 	G_OBJECT_CLASS (gcsv_buffer_parent_class)->constructed (object);
 
@@ -114,6 +154,82 @@ gcsv_buffer_constructed (GObject *object)
 	scheme_manager = gtk_source_style_scheme_manager_get_default ();
 	scheme = gtk_source_style_scheme_manager_get_scheme (scheme_manager, "tango");
 	gtk_source_buffer_set_style_scheme (GTK_SOURCE_BUFFER (buffer), scheme);
+
+	buffer->virtual_spaces_tag = gtk_source_buffer_create_source_tag (GTK_SOURCE_BUFFER (buffer),
+									  NULL,
+									  "draw-spaces", FALSE,
+									  NULL);
+
+	/* The default undo manager would record the virtual spaces too. */
+	undo_manager = gcsv_undo_manager_new (buffer);
+	gtk_source_buffer_set_undo_manager (GTK_SOURCE_BUFFER (buffer),
+					    GTK_SOURCE_UNDO_MANAGER (undo_manager));
+	g_object_unref (undo_manager);
+}
+
+static void
+gcsv_buffer_dispose (GObject *object)
+{
+	GcsvBuffer *buffer = GCSV_BUFFER (object);
+
+	if (buffer->title_mark_idle_id != 0)
+	{
+		g_source_remove (buffer->title_mark_idle_id);
+		buffer->title_mark_idle_id = 0;
+	}
+
+	G_OBJECT_CLASS (gcsv_buffer_parent_class)->dispose (object);
+}
+
+static void
+gcsv_buffer_finalize (GObject *object)
+{
+	GcsvBuffer *buffer = GCSV_BUFFER (object);
+
+	g_array_unref (buffer->line_delimiters);
+
+	G_OBJECT_CLASS (gcsv_buffer_parent_class)->finalize (object);
+}
+
+/* Sets the title_mark to be at the beginning of the line. Since the cursor
+ * moved (without a buffer change), change the header boundary to be at the
+ * beginning of a line instead of keeping the location at a random place.
+ *
+ * If later the user places the cursor at that random place and presses Enter,
+ * it would be awkward if the column titles line changed. On the other hand, at
+ * the beginning of the line is not awkward.
+ */
+static void
+move_title_mark_to_line_start (GcsvBuffer *buffer)
+{
+	GtkTextIter iter;
+	guint line;
+
+	if (buffer->title_mark_idle_id != 0)
+	{
+		g_source_remove (buffer->title_mark_idle_id);
+		buffer->title_mark_idle_id = 0;
+	}
+
+	if (buffer->title_mark == NULL)
+	{
+		return;
+	}
+
+	gcsv_buffer_get_column_titles_location (buffer, &iter);
+	line = gtk_text_iter_get_line (&iter);
+	gcsv_buffer_set_column_titles_line (buffer, line);
+}
+
+static gboolean
+move_title_mark_idle_cb (gpointer user_data)
+{
+	GcsvBuffer *buffer = GCSV_BUFFER (user_data);
+
+	buffer->title_mark_idle_id = 0;
+	move_title_mark_to_line_start (buffer);
+
+	return G_SOURCE_REMOVE;
 }
 
 static void
@@ -128,30 +244,220 @@ gcsv_buffer_mark_set (GtkTextBuffer     *text_buffer,
 		GTK_TEXT_BUFFER_CLASS (gcsv_buffer_parent_class)->mark_set (text_buffer, location, mark);
 	}
 
-	if (mark == gtk_text_buffer_get_insert (text_buffer))
+	/* When the cursor moves several times in a row, for example when an
+	 * arrow key is held down, move the title_mark only once.
+	 */
+	if (mark == gtk_text_buffer_get_insert (text_buffer) &&
+	    buffer->title_mark != NULL &&
+	    buffer->title_mark_idle_id == 0)
 	{
-		/* Sets the title_mark to be at the beginning of the line. Since
-		 * the cursor moved (without a buffer change), change the header
-		 * boundary to be at the beginning of a line instead of keeping
-		 * the location at a random place.
-		 *
-		 * If later the user places the cursor at that random place and
-		 * presses Enter, it would be awkward if the column titles line
-		 * changed. On the other hand, at the beginning of the line is
-		 * not awkward.
-		 */
-		if (buffer->title_mark != NULL)
+		buffer->title_mark_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+							      move_title_mark_idle_cb,
+							      buffer,
+							      NULL);
+	}
+}
+
+/* Index of the first cached delimiter at or after @line_offset. */
+static guint
+find_cached_delimiter (GcsvBuffer *buffer,
+		       gint        line_offset)
+{
+	guint low = 0;
+	guint high = buffer->line_delimiters->len;
+
+	while (low < high)
+	{
+		guint middle = low + (high - low) / 2;
+
+		if (g_array_index (buffer->line_delimiters, gint, middle) < line_offset)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+static void
+shift_cached_delimiters (GcsvBuffer *buffer,
+			 guint       from_index,
+			 gint        delta)
+{
+	guint i;
+
+	for (i = from_index; i < buffer->line_delimiters->len; i++)
+	{
+		g_array_index (buffer->line_delimiters, gint, i) += delta;
+	}
+}
+
+/* In a "\r\n" line terminator, between the two characters. Inserting text
+ * there, or joining a "\r" and a "\n", changes the number of lines.
+ */
+static gboolean
+is_inside_crlf (const GtkTextIter *iter)
+{
+	return (gtk_text_iter_get_char (iter) == '\n' &&
+		!gtk_text_iter_ends_line (iter));
+}
+
+static void
+gcsv_buffer_insert_text (GtkTextBuffer *text_buffer,
+			 GtkTextIter   *location,
+			 const gchar   *text,
+			 gint           length)
+{
+	GcsvBuffer *buffer = GCSV_BUFFER (text_buffer);
+	gint line;
+	gint line_offset;
+	gboolean same_lines;
+
+	/* The pending title_mark move must happen on the text before the
+	 * change, see move_title_mark_to_line_start().
+	 */
+	if (buffer->title_mark_idle_id != 0)
+	{
+		move_title_mark_to_line_start (buffer);
+	}
+
+	if (buffer->virtual_spaces_edit_depth == 0)
+	{
+		buffer->change_count++;
+	}
+
+	line = gtk_text_iter_get_line (location);
+	line_offset = gtk_text_iter_get_line_offset (location);
+	same_lines = (memchr (text, '\n', length) == NULL &&
+		      memchr (text, '\r', length) == NULL &&
+		      !is_inside_crlf (location));
+
+	GTK_TEXT_BUFFER_CLASS (gcsv_buffer_parent_class)->insert_text (text_buffer, location, text, length);
+
+	if (buffer->cached_line < line)
+	{
+		/* The cached line is before the change. */
+		return;
+	}
+
+	if (!same_lines)
+	{
+		buffer->cached_line = -1;
+		return;
+	}
+
+	if (buffer->cached_line == line)
+	{
+		const gchar *p;
+		const gchar *text_end = text + length;
+		guint index;
+		gint offset = line_offset;
+
+		index = find_cached_delimiter (buffer, line_offset);
+		shift_cached_delimiters (buffer, index, g_utf8_strlen (text, length));
+
+		for (p = text; p < text_end; p = g_utf8_next_char (p))
 		{
-			GtkTextIter iter;
-			guint line;
+			if (g_utf8_get_char (p) == buffer->delimiter)
+			{
+				g_array_insert_val (buffer->line_delimiters, index, offset);
+				index++;
+			}
 
-			gcsv_buffer_get_column_titles_location (buffer, &iter);
-			line = gtk_text_iter_get_line (&iter);
-			gcsv_buffer_set_column_titles_line (buffer, line);
+			offset++;
 		}
 	}
 }
 
+static void
+gcsv_buffer_delete_range (GtkTextBuffer *text_buffer,
+			  GtkTextIter   *start,
+			  GtkTextIter   *end)
+{
+	GcsvBuffer *buffer = GCSV_BUFFER (text_buffer);
+	gint line;
+	gint start_offset;
+	gint end_offset;
+	gboolean same_lines;
+
+	if (buffer->title_mark_idle_id != 0)
+	{
+		move_title_mark_to_line_start (buffer);
+	}
+
+	if (buffer->virtual_spaces_edit_depth == 0)
+	{
+		buffer->change_count++;
+	}
+
+	gtk_text_iter_order (start, end);
+
+	line = gtk_text_iter_get_line (start);
+	start_offset = gtk_text_iter_get_line_offset (start);
+	end_offset = gtk_text_iter_get_line_offset (end);
+	same_lines = (gtk_text_iter_get_line (end) == line &&
+		      !gtk_text_iter_ends_line (start) &&
+		      !is_inside_crlf (end));
+
+	GTK_TEXT_BUFFER_CLASS (gcsv_buffer_parent_class)->delete_range (text_buffer, start, end);
+
+	if (buffer->cached_line < line)
+	{
+		return;
+	}
+
+	/* Deleting the whole content of a line between a "\r" and a "\n"
+	 * joins them.
+	 */
+	if (!same_lines || is_inside_crlf (start))
+	{
+		buffer->cached_line = -1;
+		return;
+	}
+
+	if (buffer->cached_line == line)
+	{
+		guint first = find_cached_delimiter (buffer, start_offset);
+		guint last = find_cached_delimiter (buffer, end_offset);
+
+		g_array_remove_range (buffer->line_delimiters, first, last - first);
+		shift_cached_delimiters (buffer, first, start_offset - end_offset);
+	}
+}
+
+static void
+gcsv_buffer_replace_lines_default (GcsvBuffer  *buffer,
+				   guint        start_line,
+				   guint        n_lines,
+				   const gchar *text,
+				   GArray      *column_map,
+				   GArray      *column_lengths)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_iter_at_line (text_buffer, &start, start_line);
+
+	if ((gint) (start_line + n_lines) < gtk_text_buffer_get_line_count (text_buffer))
+	{
+		gtk_text_buffer_get_iter_at_line (text_buffer, &end, start_line + n_lines);
+	}
+	else
+	{
+		gtk_text_buffer_get_end_iter (text_buffer, &end);
+	}
+
+	gtk_text_buffer_begin_user_action (text_buffer);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+	gtk_text_buffer_insert (text_buffer, &start, text, -1);
+	gtk_text_buffer_end_user_action (text_buffer);
+}
+
 static void
 gcsv_buffer_class_init (GcsvBufferClass *klass)
 {
@@ -161,8 +467,14 @@ gcsv_buffer_class_init (GcsvBufferClass *klass)
 	object_class->get_property = gcsv_buffer_get_property;
 	object_class->set_property = gcsv_buffer_set_property;
 	object_class->constructed = gcsv_buffer_constructed;
+	object_class->dispose = gcsv_buffer_dispose;
+	object_class->finalize = gcsv_buffer_finalize;
+
+	modified_changed_signal_id = g_signal_lookup ("modified-changed", GTK_TYPE_TEXT_BUFFER);
 
 	text_buffer_class->mark_set = gcsv_buffer_mark_set;
+	text_buffer_class->insert_text = gcsv_buffer_insert_text;
+	text_buffer_class->delete_range = gcsv_buffer_delete_range;
 
 	g_object_class_install_property (object_class,
 					 PROP_DELIMITER,
@@ -191,15 +503,63 @@ gcsv_buffer_class_init (GcsvBufferClass *klass)
 			      0,
 			      NULL, NULL, NULL,
 			      G_TYPE_NONE, 0);
+
+	/**
+	 * GcsvBuffer::replace-lines:
+	 * @buffer: the #GcsvBuffer who emits the signal.
+	 * @start_line: the first line to replace.
+	 * @n_lines: the number of lines to replace.
+	 * @text: the new content of the lines, without virtual spaces.
+	 * @column_map: (nullable): how the columns have changed, or %NULL if
+	 *   unknown.
+	 * @column_lengths: (nullable): the new column lengths, or %NULL if
+	 *   unknown. It takes precedence over @column_map.
+	 *
+	 * The ::replace-lines signal is emitted by gcsv_buffer_replace_lines().
+	 * The default handler does the replacement, as one deletion and one
+	 * insertion.
+	 *
+	 * It permits to GcsvAlignment to not handle the deletion and insertion
+	 * as normal text edits. With a @column_map or @column_lengths, the new
+	 * column lengths are known without scanning the new lines.
+	 */
+	signals[SIGNAL_REPLACE_LINES] =
+		g_signal_new_class_handler ("replace-lines",
+					    G_TYPE_FROM_CLASS (klass),
+					    G_SIGNAL_RUN_LAST,
+					    G_CALLBACK (gcsv_buffer_replace_lines_default),
+					    NULL, NULL, NULL,
+					    G_TYPE_NONE, 5,
+					    G_TYPE_UINT,
+					    G_TYPE_UINT,
+					    G_TYPE_STRING | G_SIGNAL_TYPE_STATIC_SCOPE,
+					    G_TYPE_ARRAY,
+					    G_TYPE_ARRAY);
+}
+
+/* Connected before any other handler, see
+ * gcsv_buffer_begin_virtual_spaces_edit().
+ */
+static void
+modified_changed_first_cb (GcsvBuffer *buffer,
+			   gpointer    user_data)
+{
+	if (buffer->virtual_spaces_edit_depth > 0)
+	{
+		g_signal_stop_emission (buffer, modified_changed_signal_id, 0);
+	}
 }
 
 static void
 gcsv_buffer_init (GcsvBuffer *buffer)
 {
-	/* Disable the undo/redo, because it doesn't work well currently with
-	 * the virtual spaces.
-	 */
-	gtk_source_buffer_set_max_undo_levels (GTK_SOURCE_BUFFER (buffer), 0);
+	buffer->line_delimiters = g_array_new (FALSE, FALSE, sizeof (gint));
+	buffer->cached_line = -1;
+
+	g_signal_connect (buffer,
+			  "modified-changed",
+			  G_CALLBACK (modified_changed_first_cb),
+			  NULL);
 }
 
 GcsvBuffer *
@@ -237,166 +597,404 @@ gcsv_buffer_set_delimiter (GcsvBuffer *buffer,
 	if (buffer->delimiter != delimiter)
 	{
 		buffer->delimiter = delimiter;
+		buffer->cached_line = -1;
 		g_object_notify (G_OBJECT (buffer), "delimiter");
 	}
 }
 
+/* Returns: (transfer none): the tag surrounding the virtual spaces, i.e. the
+ * spaces inserted by GcsvAlignment.
+ */
+GtkTextTag *
+gcsv_buffer_get_virtual_spaces_tag (GcsvBuffer *buffer)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+
+	return buffer->virtual_spaces_tag;
+}
+
+/* Marks the beginning of an edit that only inserts or deletes virtual spaces,
+ * so the other objects listening to the buffer changes can ignore it. Can be
+ * nested.
+ *
+ * Until the matching gcsv_buffer_end_virtual_spaces_edit(), the
+ * GtkTextBuffer::modified-changed signal is stopped before reaching any
+ * handler, so the caller can restore the modified flag without the rest of the
+ * application noticing. It costs the same whatever the number of handlers,
+ * unlike blocking them one by one.
+ */
 void
-gcsv_buffer_get_column_titles_location (GcsvBuffer  *buffer,
-					GtkTextIter *iter)
+gcsv_buffer_begin_virtual_spaces_edit (GcsvBuffer *buffer)
 {
 	g_return_if_fail (GCSV_IS_BUFFER (buffer));
-	g_return_if_fail (iter != NULL);
-
-	if (buffer->title_mark == NULL)
-	{
-		gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (buffer), iter);
-	}
-	else
-	{
-		gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
-						  iter,
-						  buffer->title_mark);
 
-		gtk_text_iter_set_line_offset (iter, 0);
-	}
+	buffer->virtual_spaces_edit_depth++;
 }
 
-/* @line starts at 0. */
 void
-gcsv_buffer_set_column_titles_line (GcsvBuffer *buffer,
-				    guint       line)
+gcsv_buffer_end_virtual_spaces_edit (GcsvBuffer *buffer)
 {
-	GtkTextIter new_location;
-	GtkTextIter old_location;
-
 	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+	g_return_if_fail (buffer->virtual_spaces_edit_depth > 0);
 
-	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer),
-					  &new_location,
-					  line);
+	buffer->virtual_spaces_edit_depth--;
+}
 
-	if (buffer->title_mark == NULL)
-	{
-		/* Create the mark lazily, so that for a new file, the column
-		 * titles are kept at the first line by default. Once this
-		 * function is called, it means that the column titles are
-		 * known, so we can keep track of them.
-		 */
-		buffer->title_mark = gtk_text_buffer_create_mark (GTK_TEXT_BUFFER (buffer),
-								  NULL,
-								  &new_location,
-								  FALSE);
+gboolean
+gcsv_buffer_is_virtual_spaces_edit (GcsvBuffer *buffer)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), FALSE);
 
-		g_signal_emit (buffer, signals[SIGNAL_COLUMN_TITLES_SET], 0);
-		return;
-	}
+	return buffer->virtual_spaces_edit_depth > 0;
+}
 
-	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
-					  &old_location,
-					  buffer->title_mark);
+/* Returns: a number incremented by each edit of the text, except the virtual
+ * spaces. To know if the text has been modified since a snapshot.
+ */
+guint64
+gcsv_buffer_get_change_count (GcsvBuffer *buffer)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), 0);
 
-	gtk_text_buffer_move_mark (GTK_TEXT_BUFFER (buffer),
-				   buffer->title_mark,
-				   &new_location);
+	return buffer->change_count;
+}
 
-	if (gtk_text_iter_get_line (&old_location) != gtk_text_iter_get_line (&new_location))
+/* Like gtk_text_buffer_get_text(), but without the virtual spaces. */
+gchar *
+gcsv_buffer_get_text_without_virtual_spaces (GcsvBuffer        *buffer,
+					     const GtkTextIter *start,
+					     const GtkTextIter *end)
+{
+	GString *string;
+	GtkTextIter iter;
+
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+	g_return_val_if_fail (start != NULL, NULL);
+	g_return_val_if_fail (end != NULL, NULL);
+
+	string = g_string_new (NULL);
+	iter = *start;
+
+	while (gtk_text_iter_compare (&iter, end) < 0)
 	{
-		g_signal_emit (buffer, signals[SIGNAL_COLUMN_TITLES_SET], 0);
+		GtkTextIter chunk_end;
+		gchar *text;
+
+		if (gtk_text_iter_has_tag (&iter, buffer->virtual_spaces_tag))
+		{
+			gtk_text_iter_forward_to_tag_toggle (&iter, buffer->virtual_spaces_tag);
+			continue;
+		}
+
+		chunk_end = iter;
+		gtk_text_iter_forward_to_tag_toggle (&chunk_end, buffer->virtual_spaces_tag);
+		if (gtk_text_iter_compare (end, &chunk_end) < 0)
+		{
+			chunk_end = *end;
+		}
+
+		text = gtk_text_buffer_get_text (GTK_TEXT_BUFFER (buffer), &iter, &chunk_end, TRUE);
+		g_string_append (string, text);
+		g_free (text);
+
+		iter = chunk_end;
 	}
+
+	return g_string_free (string, FALSE);
 }
 
+/* Returns: the byte index of @iter in its line, without counting the virtual
+ * spaces.
+ */
 guint
-gcsv_buffer_get_column_num (GcsvBuffer        *buffer,
-			    const GtkTextIter *iter)
+gcsv_buffer_get_line_index_without_virtual_spaces (GcsvBuffer        *buffer,
+						   const GtkTextIter *iter)
 {
-	GtkTextIter start_line;
-	guint column_num = 0;
-	gchar *line;
-	gchar *p;
+	GtkTextIter pos;
+	guint index;
 
 	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), 0);
 	g_return_val_if_fail (iter != NULL, 0);
-	g_return_val_if_fail (gtk_text_iter_get_buffer (iter) == GTK_TEXT_BUFFER (buffer), 0);
-
-	if (buffer->delimiter == '\0')
-	{
-		return 0;
-	}
 
-	start_line = *iter;
-	gtk_text_iter_set_line_offset (&start_line, 0);
+	index = gtk_text_iter_get_line_index (iter);
 
-	line = gtk_text_buffer_get_text (GTK_TEXT_BUFFER (buffer),
-					 &start_line,
-					 iter,
-					 TRUE);
+	pos = *iter;
+	gtk_text_iter_set_line_offset (&pos, 0);
 
-	p = line;
-	while (p != NULL && *p != '\0')
+	while (gtk_text_iter_compare (&pos, iter) < 0)
 	{
-		gunichar ch;
+		GtkTextIter toggle = pos;
+		gboolean in_virtual_spaces;
 
-		ch = g_utf8_get_char (p);
-		if (ch == buffer->delimiter)
+		in_virtual_spaces = gtk_text_iter_has_tag (&pos, buffer->virtual_spaces_tag);
+
+		gtk_text_iter_forward_to_tag_toggle (&toggle, buffer->virtual_spaces_tag);
+		if (gtk_text_iter_compare (&toggle, iter) > 0)
+		{
+			toggle = *iter;
+		}
+
+		if (in_virtual_spaces)
 		{
-			column_num++;
+			index -= gtk_text_iter_get_line_index (&toggle) - gtk_text_iter_get_line_index (&pos);
 		}
 
-		p = g_utf8_find_next_char (p, NULL);
+		pos = toggle;
 	}
 
-	g_free (line);
-	return column_num;
+	return index;
 }
 
-guint
-gcsv_buffer_count_columns_at_line (GcsvBuffer *buffer,
-				   guint       at_line)
+/* The inverse of gcsv_buffer_get_line_index_without_virtual_spaces(). If
+ * @index is just before virtual spaces, @iter is placed before them.
+ *
+ * Returns: %FALSE if @line_num or @index doesn't exist in the buffer, or if
+ * @index is in the middle of a character.
+ */
+gboolean
+gcsv_buffer_get_iter_at_line_index_without_virtual_spaces (GcsvBuffer  *buffer,
+							   GtkTextIter *iter,
+							   guint        line_num,
+							   guint        index)
 {
-	GtkTextIter iter;
+	GtkTextBuffer *text_buffer;
 
-	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), 1);
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), FALSE);
+	g_return_val_if_fail (iter != NULL, FALSE);
 
-	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, at_line);
+	text_buffer = GTK_TEXT_BUFFER (buffer);
 
-	if (!gtk_text_iter_ends_line (&iter))
+	if (line_num >= (guint) gtk_text_buffer_get_line_count (text_buffer))
 	{
-		gtk_text_iter_forward_to_line_end (&iter);
+		return FALSE;
 	}
 
-	return gcsv_buffer_get_column_num (buffer, &iter) + 1;
-}
-
-static void
-move_iter_to_nth_column (GcsvBuffer  *buffer,
-			 GtkTextIter *iter,
-			 guint        nth_column)
-{
-	guint column_num = 0;
-
-	gtk_text_iter_set_line_offset (iter, 0);
+	gtk_text_buffer_get_iter_at_line (text_buffer, iter, line_num);
 
-	while (column_num < nth_column &&
-	       !gtk_text_iter_is_end (iter))
+	while (index > 0)
 	{
-		gunichar ch;
+		GtkTextIter chunk_end;
+		GtkTextIter line_end;
+		guint chunk_length;
 
-		ch = gtk_text_iter_get_char (iter);
-		if (ch == buffer->delimiter)
+		if (gtk_text_iter_ends_line (iter))
 		{
-			column_num++;
+			return FALSE;
 		}
-		else if (ch == '\n' || ch == '\r')
+
+		chunk_end = *iter;
+		gtk_text_iter_forward_to_tag_toggle (&chunk_end, buffer->virtual_spaces_tag);
+
+		line_end = *iter;
+		gtk_text_iter_forward_to_line_end (&line_end);
+		if (gtk_text_iter_compare (&line_end, &chunk_end) < 0)
+		{
+			chunk_end = line_end;
+		}
+
+		if (gtk_text_iter_has_tag (iter, buffer->virtual_spaces_tag))
+		{
+			*iter = chunk_end;
+			continue;
+		}
+
+		chunk_length = gtk_text_iter_get_line_index (&chunk_end) - gtk_text_iter_get_line_index (iter);
+
+		if (index < chunk_length)
 		{
-			return;
+			gchar *chunk;
+			gboolean char_start;
+
+			chunk = gtk_text_iter_get_slice (iter, &chunk_end);
+			char_start = ((guchar) chunk[index] & 0xc0) != 0x80;
+			g_free (chunk);
+
+			if (char_start)
+			{
+				gtk_text_iter_set_line_index (iter, gtk_text_iter_get_line_index (iter) + index);
+			}
+
+			return char_start;
 		}
 
-		gtk_text_iter_forward_char (iter);
+		index -= chunk_length;
+		*iter = chunk_end;
+	}
+
+	return TRUE;
+}
+
+void
+gcsv_buffer_get_column_titles_location (GcsvBuffer  *buffer,
+					GtkTextIter *iter)
+{
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+	g_return_if_fail (iter != NULL);
+
+	if (buffer->title_mark == NULL)
+	{
+		gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (buffer), iter);
+	}
+	else
+	{
+		gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
+						  iter,
+						  buffer->title_mark);
+
+		gtk_text_iter_set_line_offset (iter, 0);
+	}
+}
+
+/* @line starts at 0. */
+void
+gcsv_buffer_set_column_titles_line (GcsvBuffer *buffer,
+				    guint       line)
+{
+	GtkTextIter new_location;
+	GtkTextIter old_location;
+
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer),
+					  &new_location,
+					  line);
+
+	if (buffer->title_mark == NULL)
+	{
+		/* Create the mark lazily, so that for a new file, the column
+		 * titles are kept at the first line by default. Once this
+		 * function is called, it means that the column titles are
+		 * known, so we can keep track of them.
+		 */
+		buffer->title_mark = gtk_text_buffer_create_mark (GTK_TEXT_BUFFER (buffer),
+								  NULL,
+								  &new_location,
+								  FALSE);
+
+		g_signal_emit (buffer, signals[SIGNAL_COLUMN_TITLES_SET], 0);
+		return;
+	}
+
+	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
+					  &old_location,
+					  buffer->title_mark);
+
+	gtk_text_buffer_move_mark (GTK_TEXT_BUFFER (buffer),
+				   buffer->title_mark,
+				   &new_location);
+
+	if (gtk_text_iter_get_line (&old_location) != gtk_text_iter_get_line (&new_location))
+	{
+		g_signal_emit (buffer, signals[SIGNAL_COLUMN_TITLES_SET], 0);
+	}
+}
+
+/* Number of characters copied at once when filling the cache, so that a line
+ * of several megabytes is not copied entirely.
+ */
+#define LINE_CHUNK_SIZE (64 * 1024)
+
+static void
+update_line_delimiters_cache (GcsvBuffer *buffer,
+			      gint        line)
+{
+	GtkTextIter iter;
+	gint offset = 0;
+
+	if (line == buffer->cached_line)
+	{
+		return;
+	}
+
+	/* Keeps the allocated size of the array. */
+	g_array_set_size (buffer->line_delimiters, 0);
+
+	/* @line can be after the last line. */
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, line);
+	line = gtk_text_iter_get_line (&iter);
+	buffer->cached_line = line;
+
+	/* Walking the characters with a GtkTextIter is much slower than
+	 * walking a copy of the text.
+	 */
+	while (!gtk_text_iter_ends_line (&iter))
+	{
+		GtkTextIter chunk_end = iter;
+		gchar *chunk;
+		const gchar *p;
+		gint n_chars;
+		gint i;
+
+		if (!gtk_text_iter_forward_chars (&chunk_end, LINE_CHUNK_SIZE) ||
+		    gtk_text_iter_get_line (&chunk_end) != line ||
+		    gtk_text_iter_ends_line (&chunk_end) ||
+		    is_inside_crlf (&chunk_end))
+		{
+			chunk_end = iter;
+			gtk_text_iter_forward_to_line_end (&chunk_end);
+		}
+
+		n_chars = gtk_text_iter_get_offset (&chunk_end) - gtk_text_iter_get_offset (&iter);
+		chunk = gtk_text_iter_get_slice (&iter, &chunk_end);
+
+		for (i = 0, p = chunk; i < n_chars; i++, p = g_utf8_next_char (p))
+		{
+			if (g_utf8_get_char (p) == buffer->delimiter)
+			{
+				g_array_append_val (buffer->line_delimiters, offset);
+			}
+
+			offset++;
+		}
+
+		g_free (chunk);
+		iter = chunk_end;
+	}
+}
+
+/* Doesn't allocate memory when @iter is on the same line as the previous call
+ * and the buffer hasn't changed in-between, so it is cheap to call on every
+ * cursor movement.
+ */
+guint
+gcsv_buffer_get_column_num (GcsvBuffer        *buffer,
+			    const GtkTextIter *iter)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), 0);
+	g_return_val_if_fail (iter != NULL, 0);
+	g_return_val_if_fail (gtk_text_iter_get_buffer (iter) == GTK_TEXT_BUFFER (buffer), 0);
+
+	if (buffer->delimiter == '\0')
+	{
+		return 0;
+	}
+
+	update_line_delimiters_cache (buffer, gtk_text_iter_get_line (iter));
+
+	/* Number of delimiters before @iter. */
+	return find_cached_delimiter (buffer, gtk_text_iter_get_line_offset (iter));
+}
+
+guint
+gcsv_buffer_count_columns_at_line (GcsvBuffer *buffer,
+				   guint       at_line)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), 1);
+
+	if (buffer->delimiter == '\0')
+	{
+		return 1;
 	}
+
+	update_line_delimiters_cache (buffer, at_line);
+
+	return buffer->line_delimiters->len + 1;
 }
 
-/* Get field bounds, delimiters excluded, virtual spaces included. */
+/* Get field bounds, delimiters excluded, virtual spaces included. Uses the
+ * delimiters cache, so getting the bounds of all the fields of a line walks
+ * the line only once.
+ */
 void
 gcsv_buffer_get_field_bounds (GcsvBuffer  *buffer,
 			      guint        line_num,
@@ -404,6 +1002,8 @@ gcsv_buffer_get_field_bounds (GcsvBuffer  *buffer,
 			      GtkTextIter *start,
 			      GtkTextIter *end)
 {
+	GArray *delimiters;
+
 	g_return_if_fail (GCSV_IS_BUFFER (buffer));
 	g_return_if_fail (start != NULL);
 	g_return_if_fail (end != NULL);
@@ -415,61 +1015,888 @@ gcsv_buffer_get_field_bounds (GcsvBuffer  *buffer,
 		return;
 	}
 
-	move_iter_to_nth_column (buffer, start, column_num);
+	update_line_delimiters_cache (buffer, line_num);
+	delimiters = buffer->line_delimiters;
 
 	*end = *start;
-	while (!gtk_text_iter_is_end (end))
+	if (!gtk_text_iter_ends_line (end))
+	{
+		gtk_text_iter_forward_to_line_end (end);
+	}
+
+	if (column_num > delimiters->len)
+	{
+		/* The line doesn't have that column. */
+		*start = *end;
+		return;
+	}
+
+	if (column_num > 0)
+	{
+		gtk_text_iter_set_line_offset (start, g_array_index (delimiters, gint, column_num - 1) + 1);
+	}
+
+	if (column_num < delimiters->len)
+	{
+		gtk_text_iter_set_line_offset (end, g_array_index (delimiters, gint, column_num));
+	}
+}
+
+/* Without quoting, a field can't contain the delimiter or a line terminator. */
+static gboolean
+can_be_field_text (GcsvBuffer  *buffer,
+		   const gchar *text)
+{
+	const gchar *p;
+
+	for (p = text; *p != '\0'; p = g_utf8_next_char (p))
 	{
-		gunichar ch;
+		gunichar ch = g_utf8_get_char (p);
 
-		ch = gtk_text_iter_get_char (end);
-		if (ch == buffer->delimiter || ch == '\n' || ch == '\r')
+		if (ch == '\n' ||
+		    ch == '\r' ||
+		    ch == 0x2029 ||
+		    (buffer->delimiter != '\0' && ch == buffer->delimiter))
 		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Replaces the field content, virtual spaces included, by @text. Returns FALSE
+ * if the line doesn't have that column, or if @text contains the delimiter or
+ * a line terminator.
+ */
+gboolean
+gcsv_buffer_set_field_text (GcsvBuffer  *buffer,
+			    guint        line_num,
+			    guint        column_num,
+			    const gchar *text)
+{
+	GtkTextIter field_start;
+	GtkTextIter field_end;
+
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), FALSE);
+	g_return_val_if_fail (text != NULL, FALSE);
+
+	if ((gint) line_num >= gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (buffer)) ||
+	    column_num >= gcsv_buffer_count_columns_at_line (buffer, line_num) ||
+	    !can_be_field_text (buffer, text))
+	{
+		return FALSE;
+	}
+
+	gcsv_buffer_get_field_bounds (buffer, line_num, column_num, &field_start, &field_end);
+
+	gtk_text_buffer_begin_user_action (GTK_TEXT_BUFFER (buffer));
+	gtk_text_buffer_delete (GTK_TEXT_BUFFER (buffer), &field_start, &field_end);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &field_start, text, -1);
+	gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (buffer));
+
+	return TRUE;
+}
+
+/* Replaces the lines [@start_line, @start_line + @n_lines) by @text, which must
+ * contain the line terminators, like the replaced lines.
+ *
+ * @column_map contains gint's, see gcsv_tokenizer_remap_columns(). It must
+ * apply to all the lines after the column titles location, not just the
+ * replaced lines, because the lengths of the columns are computed from it. For
+ * example when only the order of the lines changes, an identity map can be
+ * given. Pass %NULL if the columns are unknown.
+ *
+ * @column_lengths contains gint's, the maximum number of characters of the
+ * fields of each column, for all the lines after the column titles location
+ * once replaced. When the new lines have been scanned anyway, it permits the
+ * column lengths to shrink. Pass %NULL if unknown.
+ */
+void
+gcsv_buffer_replace_lines (GcsvBuffer  *buffer,
+			   guint        start_line,
+			   guint        n_lines,
+			   const gchar *text,
+			   GArray      *column_map,
+			   GArray      *column_lengths)
+{
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+	g_return_if_fail (text != NULL);
+
+	g_signal_emit (buffer,
+		       signals[SIGNAL_REPLACE_LINES],
+		       0,
+		       start_line,
+		       n_lines,
+		       text,
+		       column_map,
+		       column_lengths);
+}
+
+typedef enum
+{
+	COLUMN_OP_DELETE,
+	COLUMN_OP_INSERT,
+	COLUMN_OP_MOVE,
+	COLUMN_OP_DUPLICATE,
+} ColumnOp;
+
+/* Returns: (nullable): the column map for @op, or %NULL if the column doesn't
+ * exist.
+ */
+static GArray *
+create_column_map (ColumnOp op,
+		   guint    n_columns,
+		   guint    column_num,
+		   guint    new_column_num)
+{
+	GArray *column_map;
+	gint old_column;
+	gint i;
+
+	if ((op == COLUMN_OP_INSERT && column_num > n_columns) ||
+	    (op != COLUMN_OP_INSERT && column_num >= n_columns) ||
+	    (op == COLUMN_OP_MOVE && new_column_num >= n_columns))
+	{
+		return NULL;
+	}
+
+	column_map = g_array_sized_new (FALSE, FALSE, sizeof (gint), n_columns + 1);
+
+	for (i = 0; i < (gint) n_columns; i++)
+	{
+		g_array_append_val (column_map, i);
+	}
+
+	old_column = column_num;
+
+	switch (op)
+	{
+		case COLUMN_OP_DELETE:
+			g_array_remove_index (column_map, column_num);
 			break;
+
+		case COLUMN_OP_INSERT:
+			old_column = -1;
+			g_array_insert_val (column_map, column_num, old_column);
+			break;
+
+		case COLUMN_OP_MOVE:
+			g_array_remove_index (column_map, column_num);
+			g_array_insert_val (column_map, new_column_num, old_column);
+			break;
+
+		case COLUMN_OP_DUPLICATE:
+			g_array_insert_val (column_map, column_num + 1, old_column);
+			break;
+
+		default:
+			g_assert_not_reached ();
+	}
+
+	return column_map;
+}
+
+/* Rewrites all the lines from the column titles location, as one edit. */
+static gboolean
+apply_column_op (GcsvBuffer *buffer,
+		 ColumnOp    op,
+		 guint       column_num,
+		 guint       new_column_num)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+	GcsvTokenizer tokenizer;
+	gchar *text;
+	gsize text_length;
+	GArray *column_map;
+	GString *new_text;
+	gint start_line;
+
+	if (buffer->delimiter == '\0')
+	{
+		return FALSE;
+	}
+
+	gcsv_buffer_get_column_titles_location (buffer, &start);
+	gtk_text_buffer_get_end_iter (GTK_TEXT_BUFFER (buffer), &end);
+	start_line = gtk_text_iter_get_line (&start);
+
+	gcsv_tokenizer_init (&tokenizer, buffer->delimiter);
+	text = gcsv_buffer_get_text_without_virtual_spaces (buffer, &start, &end);
+	text_length = strlen (text);
+
+	column_map = create_column_map (op,
+					gcsv_tokenizer_count_max_columns (&tokenizer, text, text + text_length),
+					column_num,
+					new_column_num);
+	if (column_map == NULL)
+	{
+		g_free (text);
+		return FALSE;
+	}
+
+	new_text = g_string_sized_new (text_length + text_length / 8);
+	gcsv_tokenizer_remap_columns (&tokenizer, text, text + text_length, column_map, new_text);
+	g_free (text);
+
+	gcsv_buffer_replace_lines (buffer,
+				   start_line,
+				   gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (buffer)) - start_line,
+				   new_text->str,
+				   column_map,
+				   NULL);
+
+	g_string_free (new_text, TRUE);
+	g_array_unref (column_map);
+	return TRUE;
+}
+
+/* Deletes the column @column_num, in all the lines from the column titles
+ * location. Returns FALSE if the column doesn't exist.
+ */
+gboolean
+gcsv_buffer_delete_column (GcsvBuffer *buffer,
+			   guint       column_num)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), FALSE);
+
+	return apply_column_op (buffer, COLUMN_OP_DELETE, column_num, 0);
+}
+
+/* Inserts an empty column at @column_num, which can be the number of columns
+ * to append it.
+ */
+gboolean
+gcsv_buffer_insert_column (GcsvBuffer *buffer,
+			   guint       column_num)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), FALSE);
+
+	return apply_column_op (buffer, COLUMN_OP_INSERT, column_num, 0);
+}
+
+gboolean
+gcsv_buffer_move_column (GcsvBuffer *buffer,
+			 guint       column_num,
+			 guint       new_column_num)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), FALSE);
+
+	return apply_column_op (buffer, COLUMN_OP_MOVE, column_num, new_column_num);
+}
+
+/* Inserts a copy of the column @column_num just after it. */
+gboolean
+gcsv_buffer_duplicate_column (GcsvBuffer *buffer,
+			      guint       column_num)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), FALSE);
+
+	return apply_column_op (buffer, COLUMN_OP_DUPLICATE, column_num, 0);
+}
+
+typedef struct _SortData SortData;
+struct _SortData
+{
+	GcsvTokenizer tokenizer;
+	guint column_num;
+	GcsvSortMode mode;
+
+	/* The lines from the column titles location, without virtual spaces. */
+	gchar *text;
+	guint titles_line;
+	guint64 change_count;
+
+	/* Filled by the thread. */
+	GString *sorted_lines;
+	guint n_columns;
+};
+
+static void
+sort_data_free (gpointer data)
+{
+	SortData *sort_data = data;
+
+	if (sort_data != NULL)
+	{
+		g_free (sort_data->text);
+
+		if (sort_data->sorted_lines != NULL)
+		{
+			g_string_free (sort_data->sorted_lines, TRUE);
 		}
 
-		gtk_text_iter_forward_char (end);
+		g_free (sort_data);
 	}
 }
 
 static void
-guess_delimiter (GcsvBuffer *buffer)
+sort_thread (GTask        *task,
+	     gpointer      source_object,
+	     gpointer      task_data,
+	     GCancellable *cancellable)
 {
-	GtkTextIter iter;
-	GtkTextIter limit;
+	SortData *sort_data = task_data;
+	const gchar *text_end;
+	const gchar *data_lines;
+	gsize data_length;
+
+	text_end = sort_data->text + strlen (sort_data->text);
+	gcsv_tokenizer_find_line_end (sort_data->text, text_end, &data_lines);
+	data_length = text_end - data_lines;
+
+	sort_data->n_columns = gcsv_tokenizer_count_max_columns (&sort_data->tokenizer,
+								 sort_data->text,
+								 text_end);
+
+	sort_data->sorted_lines = g_string_sized_new (data_length);
+
+	if (!gcsv_sort_lines (&sort_data->tokenizer,
+			      data_lines,
+			      data_length,
+			      sort_data->column_num,
+			      sort_data->mode,
+			      sort_data->sorted_lines,
+			      cancellable))
+	{
+		g_task_return_error_if_cancelled (task);
+		return;
+	}
+
+	g_task_return_boolean (task, TRUE);
+}
 
-	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (buffer), &iter);
-	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &limit, 1000);
+static void
+sort_thread_cb (GObject      *source_object,
+		GAsyncResult *result,
+		gpointer      user_data)
+{
+	GcsvBuffer *buffer = GCSV_BUFFER (source_object);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	GTask *thread_task = G_TASK (result);
+	GTask *task = G_TASK (user_data);
+	SortData *sort_data = g_task_get_task_data (thread_task);
+	GtkTextIter start;
+	GArray *column_map;
+	GError *error = NULL;
+	gint i;
+
+	if (!g_task_propagate_boolean (thread_task, &error))
+	{
+		g_task_return_error (task, error);
+		g_object_unref (task);
+		return;
+	}
+
+	/* Any edit, not only the ones changing the line count, because the
+	 * sort would silently revert the edits done in the meantime.
+	 */
+	gcsv_buffer_get_column_titles_location (buffer, &start);
 
-	/* Really simple guess */
-	if (gtk_text_iter_forward_search (&iter,
-					  "\t",
-					  GTK_TEXT_SEARCH_TEXT_ONLY,
-					  NULL,
-					  NULL,
-					  &limit))
+	if ((guint) gtk_text_iter_get_line (&start) != sort_data->titles_line ||
+	    buffer->change_count != sort_data->change_count)
 	{
-		gcsv_buffer_set_delimiter (buffer, '\t');
+		g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+					 _("The document has been modified during the sort."));
+		g_object_unref (task);
+		return;
 	}
-	else
+
+	if (sort_data->sorted_lines->len == 0)
+	{
+		g_task_return_boolean (task, TRUE);
+		g_object_unref (task);
+		return;
+	}
+
+	/* Only the order of the lines changes, so the column lengths stay the
+	 * same.
+	 */
+	column_map = g_array_sized_new (FALSE, FALSE, sizeof (gint), sort_data->n_columns);
+	for (i = 0; i < (gint) sort_data->n_columns; i++)
 	{
-		gcsv_buffer_set_delimiter (buffer, ',');
+		g_array_append_val (column_map, i);
 	}
+
+	gcsv_buffer_replace_lines (buffer,
+				   sort_data->titles_line + 1,
+				   gtk_text_buffer_get_line_count (text_buffer) - sort_data->titles_line - 1,
+				   sort_data->sorted_lines->str,
+				   column_map,
+				   NULL);
+
+	g_array_unref (column_map);
+
+	g_task_return_boolean (task, TRUE);
+	g_object_unref (task);
 }
 
-/* Setup the state (delimiter and column titles location) from the metadata, or
- * guess the state if the metadata doesn't exist.
- * The metadata must have been loaded before calling this function.
+/**
+ * gcsv_buffer_sort_by_column_async:
+ * @buffer: a #GcsvBuffer.
+ * @column_num: the column of the sort key.
+ * @mode: how to compare the fields of @column_num.
+ * @cancellable: (nullable): a #GCancellable.
+ * @callback: the callback to call when the sort is finished.
+ * @user_data: the data to pass to @callback.
+ *
+ * Sorts the lines after the column titles by the content of @column_num. The
+ * column titles line and the header lines above it stay in place. The sort is
+ * stable, it is done in worker threads on a copy of the text, and the buffer is
+ * rewritten as one edit. The buffer must not be modified until the sort is
+ * finished, otherwise it fails.
  */
 void
-gcsv_buffer_setup_state (GcsvBuffer *buffer)
+gcsv_buffer_sort_by_column_async (GcsvBuffer          *buffer,
+				  guint                column_num,
+				  GcsvSortMode         mode,
+				  GCancellable        *cancellable,
+				  GAsyncReadyCallback  callback,
+				  gpointer             user_data)
+{
+	GTask *task;
+	GTask *thread_task;
+	SortData *sort_data;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (buffer, cancellable, callback, user_data);
+
+	if (buffer->delimiter == '\0')
+	{
+		g_task_return_boolean (task, TRUE);
+		g_object_unref (task);
+		return;
+	}
+
+	gcsv_buffer_get_column_titles_location (buffer, &start);
+	gtk_text_buffer_get_end_iter (GTK_TEXT_BUFFER (buffer), &end);
+
+	sort_data = g_new0 (SortData, 1);
+	gcsv_tokenizer_init (&sort_data->tokenizer, buffer->delimiter);
+	sort_data->column_num = column_num;
+	sort_data->mode = mode;
+	sort_data->text = gcsv_buffer_get_text_without_virtual_spaces (buffer, &start, &end);
+	sort_data->titles_line = gtk_text_iter_get_line (&start);
+	sort_data->change_count = buffer->change_count;
+
+	thread_task = g_task_new (buffer, cancellable, sort_thread_cb, task);
+	g_task_set_task_data (thread_task, sort_data, sort_data_free);
+	g_task_run_in_thread (thread_task, sort_thread);
+	g_object_unref (thread_task);
+}
+
+gboolean
+gcsv_buffer_sort_by_column_finish (GcsvBuffer    *buffer,
+				   GAsyncResult  *result,
+				   GError       **error)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), FALSE);
+	g_return_val_if_fail (g_task_is_valid (result, buffer), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+typedef struct _ReplaceData ReplaceData;
+struct _ReplaceData
+{
+	GcsvTokenizer tokenizer;
+	GArray *columns;
+	gchar *search;
+	gchar *replacement;
+	guint case_sensitive : 1;
+
+	/* The lines from the column titles location, without virtual spaces. */
+	gchar *text;
+	guint titles_line;
+	guint64 change_count;
+
+	/* Filled by the thread. Only the lines from the first to the last line
+	 * with a replacement are replaced, @new_text is their new content.
+	 */
+	GString *new_text;
+	GArray *column_lengths;
+	guint64 n_replacements;
+	guint start_line;
+	guint n_lines;
+};
+
+static void
+replace_data_free (gpointer data)
+{
+	ReplaceData *replace_data = data;
+
+	if (replace_data != NULL)
+	{
+		if (replace_data->columns != NULL)
+		{
+			g_array_unref (replace_data->columns);
+		}
+
+		g_free (replace_data->search);
+		g_free (replace_data->replacement);
+		g_free (replace_data->text);
+
+		if (replace_data->new_text != NULL)
+		{
+			g_string_free (replace_data->new_text, TRUE);
+		}
+
+		if (replace_data->column_lengths != NULL)
+		{
+			g_array_unref (replace_data->column_lengths);
+		}
+
+		g_free (replace_data);
+	}
+}
+
+static gint
+compare_column_nums (gconstpointer a,
+		     gconstpointer b)
+{
+	guint column_a = *(const guint *) a;
+	guint column_b = *(const guint *) b;
+
+	return column_a < column_b ? -1 : column_a > column_b;
+}
+
+/* The column lengths are computed from the new text, so that they don't need
+ * to be recomputed on the main thread.
+ */
+static GArray *
+compute_column_lengths (const GcsvTokenizer *tokenizer,
+			const gchar         *text,
+			const gchar         *text_end)
+{
+	GcsvColumnWidths *widths;
+	GArray *column_lengths;
+	const gchar *line = text;
+	guint n_columns;
+	guint column_num;
+
+	widths = gcsv_column_widths_new ();
+
+	while (line < text_end)
+	{
+		const gchar *line_end;
+		const gchar *next_line;
+
+		line_end = gcsv_tokenizer_find_line_end (line, text_end, &next_line);
+		gcsv_column_widths_add_line (widths, tokenizer, line, line_end);
+		line = next_line;
+	}
+
+	n_columns = gcsv_column_widths_get_n_columns (widths);
+	column_lengths = g_array_sized_new (FALSE, FALSE, sizeof (gint), n_columns);
+
+	for (column_num = 0; column_num < n_columns; column_num++)
+	{
+		gint column_length = gcsv_column_widths_get (widths, column_num);
+		g_array_append_val (column_lengths, column_length);
+	}
+
+	gcsv_column_widths_free (widths);
+	return column_lengths;
+}
+
+static void
+replace_thread (GTask        *task,
+		gpointer      source_object,
+		gpointer      task_data,
+		GCancellable *cancellable)
+{
+	ReplaceData *replace_data = task_data;
+	const gchar *text_end;
+	const gchar *data_lines;
+	const gchar *changed_start;
+	const gchar *changed_end;
+	guint first_line;
+	guint last_line;
+	guint line_num;
+
+	text_end = replace_data->text + strlen (replace_data->text);
+	gcsv_tokenizer_find_line_end (replace_data->text, text_end, &data_lines);
+
+	replace_data->new_text = g_string_sized_new (text_end - replace_data->text);
+
+	/* The column titles are not data, they are kept as is. */
+	g_string_append_len (replace_data->new_text,
+			     replace_data->text,
+			     data_lines - replace_data->text);
+
+	if (!gcsv_replace_in_columns (&replace_data->tokenizer,
+				      data_lines,
+				      text_end,
+				      replace_data->columns,
+				      replace_data->search,
+				      replace_data->replacement,
+				      replace_data->case_sensitive,
+				      replace_data->new_text,
+				      &replace_data->n_replacements,
+				      &first_line,
+				      &last_line,
+				      cancellable))
+	{
+		g_task_return_error_if_cancelled (task);
+		return;
+	}
+
+	if (replace_data->n_replacements == 0)
+	{
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	/* The column lengths are for all the lines, not only the replaced
+	 * ones, see gcsv_buffer_replace_lines().
+	 */
+	replace_data->column_lengths =
+		compute_column_lengths (&replace_data->tokenizer,
+					replace_data->new_text->str,
+					replace_data->new_text->str + replace_data->new_text->len);
+
+	/* The lines before and after the changed lines are the same in the new
+	 * text, so the changed lines are at the same distance from its start
+	 * and its end.
+	 */
+	changed_start = data_lines;
+	for (line_num = 0; line_num < first_line; line_num++)
+	{
+		gcsv_tokenizer_find_line_end (changed_start, text_end, &changed_start);
+	}
+
+	changed_end = changed_start;
+	for (; line_num <= last_line; line_num++)
+	{
+		gcsv_tokenizer_find_line_end (changed_end, text_end, &changed_end);
+	}
+
+	g_string_truncate (replace_data->new_text,
+			   replace_data->new_text->len - (text_end - changed_end));
+	g_string_erase (replace_data->new_text, 0, changed_start - replace_data->text);
+
+	replace_data->start_line = replace_data->titles_line + 1 + first_line;
+	replace_data->n_lines = last_line - first_line + 1;
+
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+replace_thread_cb (GObject      *source_object,
+		   GAsyncResult *result,
+		   gpointer      user_data)
+{
+	GcsvBuffer *buffer = GCSV_BUFFER (source_object);
+	GTask *thread_task = G_TASK (result);
+	GTask *task = G_TASK (user_data);
+	ReplaceData *replace_data = g_task_get_task_data (thread_task);
+	guint64 *n_replacements;
+	GtkTextIter start;
+	GError *error = NULL;
+
+	if (!g_task_propagate_boolean (thread_task, &error))
+	{
+		g_task_return_error (task, error);
+		g_object_unref (task);
+		return;
+	}
+
+	/* Like for the sort, the edits done in the meantime must not be
+	 * silently reverted.
+	 */
+	gcsv_buffer_get_column_titles_location (buffer, &start);
+
+	if ((guint) gtk_text_iter_get_line (&start) != replace_data->titles_line ||
+	    buffer->change_count != replace_data->change_count)
+	{
+		g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+					 _("The document has been modified during the replacement."));
+		g_object_unref (task);
+		return;
+	}
+
+	if (replace_data->n_replacements > 0)
+	{
+		gcsv_buffer_replace_lines (buffer,
+					   replace_data->start_line,
+					   replace_data->n_lines,
+					   replace_data->new_text->str,
+					   NULL,
+					   replace_data->column_lengths);
+	}
+
+	n_replacements = g_new (guint64, 1);
+	*n_replacements = replace_data->n_replacements;
+	g_task_return_pointer (task, n_replacements, g_free);
+	g_object_unref (task);
+}
+
+/**
+ * gcsv_buffer_replace_in_columns_async:
+ * @buffer: a #GcsvBuffer.
+ * @columns: (nullable) (element-type guint): the columns where to replace, or
+ *   %NULL for all the columns.
+ * @search: the string to search, not empty.
+ * @replacement: the string to put instead.
+ * @case_sensitive: whether the search is case sensitive.
+ * @cancellable: (nullable): a #GCancellable.
+ * @callback: the callback to call when the replacement is finished.
+ * @user_data: the data to pass to @callback.
+ *
+ * Replaces all the occurrences of @search in the fields of @columns, in the
+ * lines after the column titles. The search is literal. The replacements are
+ * computed in a worker thread on a copy of the text, together with the new
+ * column lengths, and the lines from the first to the last replacement are
+ * rewritten as one edit. The buffer must not be modified until the replacement
+ * is finished, otherwise it fails.
+ */
+void
+gcsv_buffer_replace_in_columns_async (GcsvBuffer          *buffer,
+				      GArray              *columns,
+				      const gchar         *search,
+				      const gchar         *replacement,
+				      gboolean             case_sensitive,
+				      GCancellable        *cancellable,
+				      GAsyncReadyCallback  callback,
+				      gpointer             user_data)
+{
+	GTask *task;
+	GTask *thread_task;
+	ReplaceData *replace_data;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+	g_return_if_fail (search != NULL && search[0] != '\0');
+	g_return_if_fail (replacement != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (buffer, cancellable, callback, user_data);
+
+	if (buffer->delimiter == '\0')
+	{
+		g_task_return_pointer (task, g_new0 (guint64, 1), g_free);
+		g_object_unref (task);
+		return;
+	}
+
+	gcsv_buffer_get_column_titles_location (buffer, &start);
+	gtk_text_buffer_get_end_iter (GTK_TEXT_BUFFER (buffer), &end);
+
+	replace_data = g_new0 (ReplaceData, 1);
+	gcsv_tokenizer_init (&replace_data->tokenizer, buffer->delimiter);
+	replace_data->search = g_strdup (search);
+	replace_data->replacement = g_strdup (replacement);
+	replace_data->case_sensitive = case_sensitive != FALSE;
+	replace_data->text = gcsv_buffer_get_text_without_virtual_spaces (buffer, &start, &end);
+	replace_data->titles_line = gtk_text_iter_get_line (&start);
+	replace_data->change_count = buffer->change_count;
+
+	if (columns != NULL)
+	{
+		replace_data->columns = g_array_sized_new (FALSE, FALSE, sizeof (guint), columns->len);
+		g_array_append_vals (replace_data->columns, columns->data, columns->len);
+		g_array_sort (replace_data->columns, compare_column_nums);
+	}
+
+	thread_task = g_task_new (buffer, cancellable, replace_thread_cb, task);
+	g_task_set_task_data (thread_task, replace_data, replace_data_free);
+	g_task_run_in_thread (thread_task, replace_thread);
+	g_object_unref (thread_task);
+}
+
+/**
+ * gcsv_buffer_replace_in_columns_finish:
+ * @buffer: a #GcsvBuffer.
+ * @result: a #GAsyncResult.
+ * @n_replacements: (out) (optional): the number of replacements.
+ * @error: location to a #GError, or %NULL.
+ *
+ * Returns: whether the replacement succeeded.
+ */
+gboolean
+gcsv_buffer_replace_in_columns_finish (GcsvBuffer    *buffer,
+				       GAsyncResult  *result,
+				       guint64       *n_replacements,
+				       GError       **error)
+{
+	guint64 *count;
+
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), FALSE);
+	g_return_val_if_fail (g_task_is_valid (result, buffer), FALSE);
+
+	count = g_task_propagate_pointer (G_TASK (result), error);
+	if (count == NULL)
+	{
+		return FALSE;
+	}
+
+	if (n_replacements != NULL)
+	{
+		*n_replacements = *count;
+	}
+
+	g_free (count);
+	return TRUE;
+}
+
+static void
+guess_delimiter_from_sample (GcsvBuffer  *buffer,
+			     const gchar *sample,
+			     gsize        sample_length)
+{
+	gcsv_buffer_set_delimiter (buffer, gcsv_tokenizer_guess_delimiter (sample, sample_length));
+}
+
+/* Takes the first complete lines up to GCSV_TOKENIZER_GUESS_SAMPLE_SIZE bytes,
+ * so that only a bounded amount of text is copied out of the buffer.
+ */
+static void
+guess_delimiter (GcsvBuffer *buffer)
+{
+	GtkTextIter start;
+	GtkTextIter limit;
+	gsize n_bytes = 0;
+	gchar *sample;
+
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (buffer), &start);
+	limit = start;
+
+	do
+	{
+		n_bytes += gtk_text_iter_get_bytes_in_line (&limit);
+	}
+	while (n_bytes < GCSV_TOKENIZER_GUESS_SAMPLE_SIZE &&
+	       gtk_text_iter_forward_line (&limit));
+
+	/* @limit is at the start of the line that exceeded the size, exclude it
+	 * unless it is the first line.
+	 */
+	if (n_bytes >= GCSV_TOKENIZER_GUESS_SAMPLE_SIZE &&
+	    gtk_text_iter_get_line (&limit) == 0)
+	{
+		gtk_text_iter_forward_line (&limit);
+	}
+
+	sample = gtk_text_buffer_get_text (GTK_TEXT_BUFFER (buffer), &start, &limit, TRUE);
+	guess_delimiter_from_sample (buffer, sample, strlen (sample));
+	g_free (sample);
+}
+
+static void
+setup_state (GcsvBuffer  *buffer,
+	     const gchar *sample,
+	     gsize        sample_length)
 {
 	TeplMetadata *metadata;
 	gchar *delimiter;
 	gchar *title_line_str;
 
-	g_return_if_fail (GCSV_IS_BUFFER (buffer));
-
 	metadata = tepl_buffer_get_metadata (TEPL_BUFFER (buffer));
 
 	delimiter = tepl_metadata_get (metadata, METADATA_DELIMITER);
@@ -478,6 +1905,10 @@ gcsv_buffer_setup_state (GcsvBuffer *buffer)
 		gcsv_buffer_set_delimiter (buffer, g_utf8_get_char (delimiter));
 		g_free (delimiter);
 	}
+	else if (sample != NULL)
+	{
+		guess_delimiter_from_sample (buffer, sample, sample_length);
+	}
 	else
 	{
 		guess_delimiter (buffer);
@@ -495,6 +1926,33 @@ gcsv_buffer_setup_state (GcsvBuffer *buffer)
 	}
 }
 
+/* Setup the state (delimiter and column titles location) from the metadata, or
+ * guess the state if the metadata doesn't exist.
+ * The metadata must have been loaded before calling this function.
+ */
+void
+gcsv_buffer_setup_state (GcsvBuffer *buffer)
+{
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+
+	setup_state (buffer, NULL, 0);
+}
+
+/* Like gcsv_buffer_setup_state(), but when the metadata doesn't exist the
+ * delimiter is guessed from @sample instead of the buffer content. Useful when
+ * the file content is not loaded into the buffer, like in read-only mode.
+ */
+void
+gcsv_buffer_setup_state_from_sample (GcsvBuffer  *buffer,
+				     const gchar *sample,
+				     gsize        sample_length)
+{
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+	g_return_if_fail (sample != NULL || sample_length == 0);
+
+	setup_state (buffer, sample != NULL ? sample : "", sample_length);
+}
+
 static void
 set_metadata (GcsvBuffer *buffer)
 {
@@ -24,6 +24,7 @@
 #define GCSV_BUFFER_H
 
 #include <tepl/tepl.h>
+#include "gcsv-sort.h"
 
 G_BEGIN_DECLS
 
@@ -41,6 +42,31 @@ gchar *			gcsv_buffer_get_delimiter_as_string	(GcsvBuffer *buffer);
 void			gcsv_buffer_set_delimiter		(GcsvBuffer *buffer,
 								 gunichar    delimiter);
 
+GtkTextTag *		gcsv_buffer_get_virtual_spaces_tag	(GcsvBuffer *buffer);
+
+void			gcsv_buffer_begin_virtual_spaces_edit	(GcsvBuffer *buffer);
+
+void			gcsv_buffer_end_virtual_spaces_edit	(GcsvBuffer *buffer);
+
+gboolean		gcsv_buffer_is_virtual_spaces_edit	(GcsvBuffer *buffer);
+
+guint64			gcsv_buffer_get_change_count		(GcsvBuffer *buffer);
+
+gchar *			gcsv_buffer_get_text_without_virtual_spaces
+								(GcsvBuffer        *buffer,
+								 const GtkTextIter *start,
+								 const GtkTextIter *end);
+
+guint			gcsv_buffer_get_line_index_without_virtual_spaces
+								(GcsvBuffer        *buffer,
+								 const GtkTextIter *iter);
+
+gboolean		gcsv_buffer_get_iter_at_line_index_without_virtual_spaces
+								(GcsvBuffer  *buffer,
+								 GtkTextIter *iter,
+								 guint        line_num,
+								 guint        index);
+
 void			gcsv_buffer_get_column_titles_location	(GcsvBuffer  *buffer,
 								 GtkTextIter *iter);
 
@@ -59,8 +85,62 @@ void			gcsv_buffer_get_field_bounds		(GcsvBuffer  *buffer,
 								 GtkTextIter *start,
 								 GtkTextIter *end);
 
+gboolean		gcsv_buffer_set_field_text		(GcsvBuffer  *buffer,
+								 guint        line_num,
+								 guint        column_num,
+								 const gchar *text);
+
+void			gcsv_buffer_replace_lines		(GcsvBuffer  *buffer,
+								 guint        start_line,
+								 guint        n_lines,
+								 const gchar *text,
+								 GArray      *column_map,
+								 GArray      *column_lengths);
+
+gboolean		gcsv_buffer_delete_column		(GcsvBuffer *buffer,
+								 guint       column_num);
+
+gboolean		gcsv_buffer_insert_column		(GcsvBuffer *buffer,
+								 guint       column_num);
+
+gboolean		gcsv_buffer_move_column			(GcsvBuffer *buffer,
+								 guint       column_num,
+								 guint       new_column_num);
+
+gboolean		gcsv_buffer_duplicate_column		(GcsvBuffer *buffer,
+								 guint       column_num);
+
+void			gcsv_buffer_sort_by_column_async	(GcsvBuffer          *buffer,
+								 guint                column_num,
+								 GcsvSortMode         mode,
+								 GCancellable        *cancellable,
+								 GAsyncReadyCallback  callback,
+								 gpointer             user_data);
+
+gboolean		gcsv_buffer_sort_by_column_finish	(GcsvBuffer    *buffer,
+								 GAsyncResult  *result,
+								 GError       **error);
+
+void			gcsv_buffer_replace_in_columns_async	(GcsvBuffer          *buffer,
+								 GArray              *columns,
+								 const gchar         *search,
+								 const gchar         *replacement,
+								 gboolean             case_sensitive,
+								 GCancellable        *cancellable,
+								 GAsyncReadyCallback  callback,
+								 gpointer             user_data);
+
+gboolean		gcsv_buffer_replace_in_columns_finish	(GcsvBuffer    *buffer,
+								 GAsyncResult  *result,
+								 guint64       *n_replacements,
+								 GError       **error);
+
 void			gcsv_buffer_setup_state			(GcsvBuffer *buffer);
 
+void			gcsv_buffer_setup_state_from_sample	(GcsvBuffer  *buffer,
+								 const gchar *sample,
+								 gsize        sample_length);
+
 void			gcsv_buffer_save_metadata		(GcsvBuffer *buffer);
 
 G_END_DECLS
@@ -0,0 +1,859 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-chunked-tracker.h"
+#include <string.h>
+
+/* Keeps a result per chunk of lines up to date, without blocking the main
+ * thread on big files. It is the common part of GcsvColumnStatsTracker,
+ * GcsvRaggedRows, GcsvColumnSearch and GcsvRowFilter, which provide what is
+ * computed with a GcsvChunkedTrackerFuncs.
+ *
+ * The lines from the first line given by the client are split into chunks,
+ * each starting at a GtkTextMark. The result of each chunk is computed in a
+ * worker thread on a copy of its text, without the virtual spaces.
+ *
+ * When the text is edited, only the edited chunks are marked dirty and
+ * computed again, after a short delay so that a burst of keystrokes results in
+ * only one computation. Each edit increments the generation of the edited
+ * chunks, the result of a chunk is dropped if its generation has changed in
+ * the meantime. The previous result of a dirty chunk is kept until the new one
+ * arrives. The virtual spaces are not part of the text computed, the alignment
+ * edits are ignored.
+ *
+ * Only a few chunks are copied and computed at a time, so that copying the
+ * text of a multi-million rows file doesn't freeze the main thread either.
+ */
+
+struct _GcsvChunkedTracker
+{
+	GObject parent;
+
+	GcsvBuffer *buffer;
+
+	const GcsvChunkedTrackerFuncs *funcs;
+	gpointer user_data;
+
+	/* The chunks are freed only when the whole buffer is computed again,
+	 * and a new GCancellable is created at that time. So the jobs of the
+	 * current GCancellable can point to their Chunk. NULL when stopped.
+	 */
+	GCancellable *cancellable;
+	GPtrArray *chunks;
+	guint n_jobs;
+
+	guint dispatch_id;
+
+	/* When text is inserted in a buffer without chunks, for example while
+	 * a file is loaded.
+	 */
+	guint recompute_pending : 1;
+
+	/* During GcsvBuffer::replace-lines, the insertions and deletions are
+	 * ignored, the replaced lines are invalidated at the end.
+	 */
+	gint line_count_before_replace_lines;
+	guint in_replace_lines : 1;
+};
+
+typedef struct _Chunk Chunk;
+struct _Chunk
+{
+	/* Left gravity, at a line start. The chunk ends at the next chunk. */
+	GtkTextMark *start_mark;
+
+	/* NULL until the first result. */
+	gpointer result;
+
+	guint generation;
+
+	guint dirty : 1;
+	guint in_flight : 1;
+};
+
+/* The data of a chunk for the worker thread. */
+typedef struct _Job Job;
+struct _Job
+{
+	GcsvChunkedTracker *tracker;
+	Chunk *chunk;
+	guint generation;
+	gpointer data;
+	gchar *text;
+
+	gpointer result;
+};
+
+#define CHUNK_N_LINES 4096
+
+/* A chunk that has grown beyond this size after edits is split. */
+#define MAX_CHUNK_N_LINES (2 * CHUNK_N_LINES)
+
+/* Delay before computing the edited chunks, in milliseconds. */
+#define EDIT_DELAY 250
+
+G_DEFINE_TYPE (GcsvChunkedTracker, gcsv_chunked_tracker, G_TYPE_OBJECT)
+
+static void dispatch_jobs (GcsvChunkedTracker *tracker);
+
+static void
+clear_result (GcsvChunkedTracker *tracker,
+	      gpointer           *result)
+{
+	if (*result != NULL)
+	{
+		tracker->funcs->result_free (*result);
+		*result = NULL;
+	}
+}
+
+static void
+chunk_free (GcsvChunkedTracker *tracker,
+	    Chunk              *chunk)
+{
+	GtkTextBuffer *buffer;
+
+	buffer = gtk_text_mark_get_buffer (chunk->start_mark);
+	if (buffer != NULL)
+	{
+		gtk_text_buffer_delete_mark (buffer, chunk->start_mark);
+	}
+
+	g_object_unref (chunk->start_mark);
+	clear_result (tracker, &chunk->result);
+	g_free (chunk);
+}
+
+static void
+remove_chunk (GcsvChunkedTracker *tracker,
+	      guint               chunk_index)
+{
+	chunk_free (tracker, g_ptr_array_index (tracker->chunks, chunk_index));
+	g_ptr_array_remove_index (tracker->chunks, chunk_index);
+}
+
+static Chunk *
+chunk_new (GcsvChunkedTracker *tracker,
+	   const GtkTextIter  *start)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (tracker->buffer);
+	Chunk *chunk;
+
+	chunk = g_new0 (Chunk, 1);
+	chunk->start_mark = g_object_ref (gtk_text_buffer_create_mark (buffer, NULL, start, TRUE));
+	chunk->dirty = TRUE;
+
+	return chunk;
+}
+
+static void
+job_free (gpointer data)
+{
+	Job *job = data;
+
+	if (job->data != NULL && job->tracker->funcs->job_data_free != NULL)
+	{
+		job->tracker->funcs->job_data_free (job->data);
+	}
+
+	clear_result (job->tracker, &job->result);
+	g_free (job->text);
+	g_object_unref (job->tracker);
+	g_free (job);
+}
+
+static void
+notify_chunks_changed (GcsvChunkedTracker *tracker)
+{
+	if (tracker->funcs->chunks_changed != NULL)
+	{
+		tracker->funcs->chunks_changed (tracker->user_data);
+	}
+}
+
+static guint
+get_max_n_jobs (void)
+{
+	return MAX (g_get_num_processors (), 1);
+}
+
+static gboolean
+dispatch_cb (gpointer user_data)
+{
+	GcsvChunkedTracker *tracker = GCSV_CHUNKED_TRACKER (user_data);
+
+	tracker->dispatch_id = 0;
+
+	if (tracker->recompute_pending)
+	{
+		tracker->recompute_pending = FALSE;
+		tracker->funcs->recompute (tracker->user_data);
+	}
+	else
+	{
+		dispatch_jobs (tracker);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* A dispatch already queued is not delayed further. */
+static void
+queue_dispatch (GcsvChunkedTracker *tracker)
+{
+	if (tracker->dispatch_id == 0)
+	{
+		tracker->dispatch_id = g_timeout_add (EDIT_DELAY, dispatch_cb, tracker);
+	}
+}
+
+static guint
+get_chunk_index (GcsvChunkedTracker *tracker,
+		 Chunk              *chunk)
+{
+	guint i;
+
+	for (i = 0; i < tracker->chunks->len; i++)
+	{
+		if (g_ptr_array_index (tracker->chunks, i) == chunk)
+		{
+			break;
+		}
+	}
+
+	g_assert (i < tracker->chunks->len);
+	return i;
+}
+
+static void
+compute_chunk_thread (GTask        *task,
+		      gpointer      source_object,
+		      gpointer      task_data,
+		      GCancellable *cancellable)
+{
+	Job *job = task_data;
+
+	if (g_task_return_error_if_cancelled (task))
+	{
+		return;
+	}
+
+	job->result = job->tracker->funcs->compute_chunk (job->data,
+							  job->text,
+							  job->text + strlen (job->text));
+
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+compute_chunk_cb (GObject      *source_object,
+		  GAsyncResult *result,
+		  gpointer      user_data)
+{
+	GcsvChunkedTracker *tracker = GCSV_CHUNKED_TRACKER (source_object);
+	GTask *task = G_TASK (result);
+	Job *job = g_task_get_task_data (task);
+	Chunk *chunk = job->chunk;
+
+	/* The chunks of a previous computation have been freed. */
+	if (!g_task_propagate_boolean (task, NULL) ||
+	    g_task_get_cancellable (task) != tracker->cancellable)
+	{
+		return;
+	}
+
+	chunk->in_flight = FALSE;
+	tracker->n_jobs--;
+
+	if (chunk->generation == job->generation)
+	{
+		clear_result (tracker, &chunk->result);
+		chunk->result = job->result;
+		job->result = NULL;
+		chunk->dirty = FALSE;
+
+		if (tracker->funcs->chunk_computed != NULL)
+		{
+			tracker->funcs->chunk_computed (tracker->user_data, get_chunk_index (tracker, chunk));
+		}
+	}
+
+	dispatch_jobs (tracker);
+}
+
+/* Splits a chunk that has grown too much, so that it doesn't take longer to
+ * compute than the others.
+ */
+static void
+split_chunk_if_needed (GcsvChunkedTracker *tracker,
+		       guint               chunk_index)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+	gint start_line;
+
+	gcsv_chunked_tracker_get_chunk_bounds (tracker, chunk_index, &start, &end);
+	start_line = gtk_text_iter_get_line (&start);
+
+	if (gtk_text_iter_get_line (&end) - start_line <= MAX_CHUNK_N_LINES)
+	{
+		return;
+	}
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (tracker->buffer), &start, start_line + CHUNK_N_LINES);
+	g_ptr_array_insert (tracker->chunks, chunk_index + 1, chunk_new (tracker, &start));
+
+	notify_chunks_changed (tracker);
+}
+
+static void
+start_job (GcsvChunkedTracker *tracker,
+	   guint               chunk_index)
+{
+	Chunk *chunk = g_ptr_array_index (tracker->chunks, chunk_index);
+	GtkTextIter start;
+	GtkTextIter end;
+	Job *job;
+	GTask *task;
+
+	gcsv_chunked_tracker_get_chunk_bounds (tracker, chunk_index, &start, &end);
+
+	job = g_new0 (Job, 1);
+	job->tracker = g_object_ref (tracker);
+	job->chunk = chunk;
+	job->generation = chunk->generation;
+	job->text = gcsv_buffer_get_text_without_virtual_spaces (tracker->buffer, &start, &end);
+
+	if (tracker->funcs->job_data_new != NULL)
+	{
+		job->data = tracker->funcs->job_data_new (tracker->user_data);
+	}
+
+	chunk->in_flight = TRUE;
+	tracker->n_jobs++;
+
+	task = g_task_new (tracker, tracker->cancellable, compute_chunk_cb, NULL);
+	g_task_set_task_data (task, job, job_free);
+	g_task_run_in_thread (task, compute_chunk_thread);
+	g_object_unref (task);
+}
+
+/* Starts jobs for the dirty chunks, while there are free workers. A chunk is
+ * copied only when a worker can take it.
+ */
+static void
+dispatch_jobs (GcsvChunkedTracker *tracker)
+{
+	guint max_n_jobs = get_max_n_jobs ();
+	guint i;
+
+	if (tracker->cancellable == NULL)
+	{
+		return;
+	}
+
+	for (i = 0; i < tracker->chunks->len && tracker->n_jobs < max_n_jobs; i++)
+	{
+		Chunk *chunk = g_ptr_array_index (tracker->chunks, i);
+
+		if (chunk->dirty && !chunk->in_flight)
+		{
+			split_chunk_if_needed (tracker, i);
+			start_job (tracker, i);
+		}
+	}
+}
+
+static void
+cancel_pending_work (GcsvChunkedTracker *tracker)
+{
+	guint i;
+
+	if (tracker->cancellable != NULL)
+	{
+		g_cancellable_cancel (tracker->cancellable);
+		g_clear_object (&tracker->cancellable);
+	}
+
+	for (i = 0; i < tracker->chunks->len; i++)
+	{
+		chunk_free (tracker, g_ptr_array_index (tracker->chunks, i));
+	}
+
+	g_ptr_array_set_size (tracker->chunks, 0);
+	tracker->n_jobs = 0;
+	tracker->recompute_pending = FALSE;
+
+	if (tracker->dispatch_id != 0)
+	{
+		g_source_remove (tracker->dispatch_id);
+		tracker->dispatch_id = 0;
+	}
+}
+
+static gboolean
+is_tracking (GcsvChunkedTracker *tracker)
+{
+	return (tracker->cancellable != NULL &&
+		!tracker->in_replace_lines &&
+		!gcsv_buffer_is_virtual_spaces_edit (tracker->buffer));
+}
+
+/* The chunks between @start and @end are about to be edited. */
+static void
+invalidate_chunks (GcsvChunkedTracker *tracker,
+		   const GtkTextIter  *start,
+		   const GtkTextIter  *end)
+{
+	gint first;
+	gint last;
+	gint i;
+
+	if (tracker->chunks->len == 0)
+	{
+		tracker->recompute_pending = TRUE;
+		queue_dispatch (tracker);
+		return;
+	}
+
+	first = gcsv_chunked_tracker_find_chunk (tracker, start);
+	last = gcsv_chunked_tracker_find_chunk (tracker, end);
+
+	if (first < 0)
+	{
+		notify_chunks_changed (tracker);
+		first = 0;
+	}
+
+	for (i = first; i <= last; i++)
+	{
+		Chunk *chunk = g_ptr_array_index (tracker->chunks, i);
+
+		chunk->dirty = TRUE;
+		chunk->generation++;
+	}
+
+	if (first <= last)
+	{
+		queue_dispatch (tracker);
+	}
+}
+
+static void
+insert_text_cb (GtkTextBuffer      *buffer,
+		GtkTextIter        *location,
+		const gchar        *text,
+		gint                length,
+		GcsvChunkedTracker *tracker)
+{
+	if (is_tracking (tracker))
+	{
+		invalidate_chunks (tracker, location, location);
+	}
+}
+
+static void
+delete_range_cb (GtkTextBuffer      *buffer,
+		 GtkTextIter        *start,
+		 GtkTextIter        *end,
+		 GcsvChunkedTracker *tracker)
+{
+	if (is_tracking (tracker))
+	{
+		invalidate_chunks (tracker, start, end);
+	}
+}
+
+/* The chunks that started in the deleted text now start at @location, like
+ * the chunk containing @location. Only the last one of them has lines, the
+ * others are removed. The ones in flight are kept until the next computation
+ * since their job points to them, without their previous result.
+ */
+static void
+remove_emptied_chunks (GcsvChunkedTracker *tracker,
+		       const GtkTextIter  *location)
+{
+	gint i;
+
+	for (i = gcsv_chunked_tracker_find_chunk (tracker, location) - 1; i >= 0; i--)
+	{
+		Chunk *chunk = g_ptr_array_index (tracker->chunks, i);
+		GtkTextIter chunk_start;
+
+		gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (tracker->buffer),
+						  &chunk_start,
+						  chunk->start_mark);
+
+		if (!gtk_text_iter_equal (&chunk_start, location))
+		{
+			break;
+		}
+
+		if (chunk->in_flight)
+		{
+			clear_result (tracker, &chunk->result);
+			chunk->generation++;
+		}
+		else
+		{
+			remove_chunk (tracker, i);
+		}
+	}
+
+	notify_chunks_changed (tracker);
+}
+
+static void
+replace_lines_cb (GcsvBuffer         *buffer,
+		  guint               start_line,
+		  guint               n_lines,
+		  const gchar        *text,
+		  GArray             *column_map,
+		  GArray             *column_lengths,
+		  GcsvChunkedTracker *tracker)
+{
+	tracker->in_replace_lines = TRUE;
+	tracker->line_count_before_replace_lines = gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (buffer));
+}
+
+/* Only the replaced lines are computed again, the marks of the chunks after
+ * them have followed the edit. When the lines before the first chunk are
+ * replaced, for example the column titles line when a column is inserted, all
+ * the lines are replaced anyway.
+ */
+static void
+replace_lines_after_cb (GcsvBuffer         *buffer,
+			guint               start_line,
+			guint               n_lines,
+			const gchar        *text,
+			GArray             *column_map,
+			GArray             *column_lengths,
+			GcsvChunkedTracker *tracker)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	GtkTextIter start;
+	GtkTextIter end;
+	GtkTextIter before_start;
+	gint new_n_lines;
+
+	tracker->in_replace_lines = FALSE;
+
+	if (tracker->cancellable == NULL)
+	{
+		return;
+	}
+
+	if (tracker->chunks->len == 0 ||
+	    (gint) start_line < tracker->funcs->get_first_line (tracker->user_data))
+	{
+		tracker->funcs->recompute (tracker->user_data);
+		return;
+	}
+
+	new_n_lines = n_lines +
+		      gtk_text_buffer_get_line_count (text_buffer) -
+		      tracker->line_count_before_replace_lines;
+
+	gtk_text_buffer_get_iter_at_line (text_buffer, &start, start_line);
+
+	if ((gint) start_line + new_n_lines < gtk_text_buffer_get_line_count (text_buffer))
+	{
+		gtk_text_buffer_get_iter_at_line (text_buffer, &end, start_line + new_n_lines);
+	}
+	else
+	{
+		gtk_text_buffer_get_end_iter (text_buffer, &end);
+	}
+
+	remove_emptied_chunks (tracker, &start);
+
+	/* The chunk before the replaced lines can have lost its last lines,
+	 * if the next chunk started in the deleted text.
+	 */
+	before_start = start;
+	gtk_text_iter_backward_line (&before_start);
+	invalidate_chunks (tracker, &before_start, &end);
+}
+
+static void
+gcsv_chunked_tracker_dispose (GObject *object)
+{
+	GcsvChunkedTracker *tracker = GCSV_CHUNKED_TRACKER (object);
+
+	cancel_pending_work (tracker);
+	g_clear_object (&tracker->buffer);
+
+	G_OBJECT_CLASS (gcsv_chunked_tracker_parent_class)->dispose (object);
+}
+
+static void
+gcsv_chunked_tracker_finalize (GObject *object)
+{
+	GcsvChunkedTracker *tracker = GCSV_CHUNKED_TRACKER (object);
+
+	g_ptr_array_unref (tracker->chunks);
+
+	G_OBJECT_CLASS (gcsv_chunked_tracker_parent_class)->finalize (object);
+}
+
+static void
+gcsv_chunked_tracker_class_init (GcsvChunkedTrackerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gcsv_chunked_tracker_dispose;
+	object_class->finalize = gcsv_chunked_tracker_finalize;
+}
+
+static void
+gcsv_chunked_tracker_init (GcsvChunkedTracker *tracker)
+{
+	tracker->chunks = g_ptr_array_new ();
+}
+
+/* @funcs must stay alive as long as the tracker, normally it is static.
+ *
+ * The jobs in flight keep a reference to the tracker, so the client calls
+ * gcsv_chunked_tracker_stop() when it is disposed, after which @user_data is
+ * no longer used.
+ */
+GcsvChunkedTracker *
+gcsv_chunked_tracker_new (GcsvBuffer                    *buffer,
+			  const GcsvChunkedTrackerFuncs *funcs,
+			  gpointer                       user_data)
+{
+	GcsvChunkedTracker *tracker;
+
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+	g_return_val_if_fail (funcs != NULL, NULL);
+
+	tracker = g_object_new (GCSV_TYPE_CHUNKED_TRACKER, NULL);
+	tracker->buffer = g_object_ref (buffer);
+	tracker->funcs = funcs;
+	tracker->user_data = user_data;
+
+	g_signal_connect_object (buffer,
+				 "insert-text",
+				 G_CALLBACK (insert_text_cb),
+				 tracker,
+				 0);
+
+	g_signal_connect_object (buffer,
+				 "delete-range",
+				 G_CALLBACK (delete_range_cb),
+				 tracker,
+				 0);
+
+	g_signal_connect_object (buffer,
+				 "replace-lines",
+				 G_CALLBACK (replace_lines_cb),
+				 tracker,
+				 0);
+
+	g_signal_connect_object (buffer,
+				 "replace-lines",
+				 G_CALLBACK (replace_lines_after_cb),
+				 tracker,
+				 G_CONNECT_AFTER);
+
+	return tracker;
+}
+
+/* Computes the whole buffer again. The results of the previous chunks are
+ * freed.
+ */
+void
+gcsv_chunked_tracker_start (GcsvChunkedTracker *tracker)
+{
+	GtkTextBuffer *buffer;
+	GtkTextIter iter;
+	gint line_count;
+	gint line_num;
+
+	g_return_if_fail (GCSV_IS_CHUNKED_TRACKER (tracker));
+
+	buffer = GTK_TEXT_BUFFER (tracker->buffer);
+
+	cancel_pending_work (tracker);
+	tracker->cancellable = g_cancellable_new ();
+
+	line_count = gtk_text_buffer_get_line_count (buffer);
+
+	for (line_num = tracker->funcs->get_first_line (tracker->user_data);
+	     line_num < line_count;
+	     line_num += CHUNK_N_LINES)
+	{
+		gtk_text_buffer_get_iter_at_line (buffer, &iter, line_num);
+		g_ptr_array_add (tracker->chunks, chunk_new (tracker, &iter));
+	}
+
+	dispatch_jobs (tracker);
+}
+
+/* Frees the chunks, and stops following the edits until the next
+ * gcsv_chunked_tracker_start().
+ */
+void
+gcsv_chunked_tracker_stop (GcsvChunkedTracker *tracker)
+{
+	g_return_if_fail (GCSV_IS_CHUNKED_TRACKER (tracker));
+
+	cancel_pending_work (tracker);
+}
+
+gboolean
+gcsv_chunked_tracker_is_started (GcsvChunkedTracker *tracker)
+{
+	g_return_val_if_fail (GCSV_IS_CHUNKED_TRACKER (tracker), FALSE);
+
+	return tracker->cancellable != NULL;
+}
+
+/* Returns whether all the chunks have been computed since their last edit. */
+gboolean
+gcsv_chunked_tracker_is_complete (GcsvChunkedTracker *tracker)
+{
+	guint i;
+
+	g_return_val_if_fail (GCSV_IS_CHUNKED_TRACKER (tracker), FALSE);
+
+	if (tracker->recompute_pending)
+	{
+		return FALSE;
+	}
+
+	for (i = 0; i < tracker->chunks->len; i++)
+	{
+		Chunk *chunk = g_ptr_array_index (tracker->chunks, i);
+
+		if (chunk->dirty)
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+guint
+gcsv_chunked_tracker_get_n_chunks (GcsvChunkedTracker *tracker)
+{
+	g_return_val_if_fail (GCSV_IS_CHUNKED_TRACKER (tracker), 0);
+
+	return tracker->chunks->len;
+}
+
+/* Returns: the index of the chunk that contains @iter, i.e. the last one
+ * starting at or before @iter, or -1 if @iter is before the first chunk.
+ */
+gint
+gcsv_chunked_tracker_find_chunk (GcsvChunkedTracker *tracker,
+				 const GtkTextIter  *iter)
+{
+	gint low = 0;
+	gint high;
+	gint result = -1;
+
+	g_return_val_if_fail (GCSV_IS_CHUNKED_TRACKER (tracker), -1);
+	g_return_val_if_fail (iter != NULL, -1);
+
+	high = (gint) tracker->chunks->len - 1;
+
+	while (low <= high)
+	{
+		gint middle = low + (high - low) / 2;
+		Chunk *chunk = g_ptr_array_index (tracker->chunks, middle);
+		GtkTextIter chunk_start;
+
+		gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (tracker->buffer),
+						  &chunk_start,
+						  chunk->start_mark);
+
+		if (gtk_text_iter_compare (&chunk_start, iter) <= 0)
+		{
+			result = middle;
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+
+	return result;
+}
+
+void
+gcsv_chunked_tracker_get_chunk_bounds (GcsvChunkedTracker *tracker,
+				       guint               chunk_index,
+				       GtkTextIter        *start,
+				       GtkTextIter        *end)
+{
+	GtkTextBuffer *buffer;
+	Chunk *chunk;
+
+	g_return_if_fail (GCSV_IS_CHUNKED_TRACKER (tracker));
+	g_return_if_fail (chunk_index < tracker->chunks->len);
+
+	buffer = GTK_TEXT_BUFFER (tracker->buffer);
+
+	chunk = g_ptr_array_index (tracker->chunks, chunk_index);
+	gtk_text_buffer_get_iter_at_mark (buffer, start, chunk->start_mark);
+
+	if (chunk_index + 1 < tracker->chunks->len)
+	{
+		Chunk *next_chunk = g_ptr_array_index (tracker->chunks, chunk_index + 1);
+		gtk_text_buffer_get_iter_at_mark (buffer, end, next_chunk->start_mark);
+	}
+	else
+	{
+		gtk_text_buffer_get_end_iter (buffer, end);
+	}
+}
+
+/* Returns: (transfer none) (nullable): the last result of the chunk, which can
+ * be out of date if the chunk is dirty, or %NULL if the chunk has not been
+ * computed yet.
+ */
+gpointer
+gcsv_chunked_tracker_get_chunk_result (GcsvChunkedTracker *tracker,
+				       guint               chunk_index)
+{
+	Chunk *chunk;
+
+	g_return_val_if_fail (GCSV_IS_CHUNKED_TRACKER (tracker), NULL);
+	g_return_val_if_fail (chunk_index < tracker->chunks->len, NULL);
+
+	chunk = g_ptr_array_index (tracker->chunks, chunk_index);
+	return chunk->result;
+}
+
+/* Returns: whether the chunk has been edited since its last result. */
+gboolean
+gcsv_chunked_tracker_is_chunk_dirty (GcsvChunkedTracker *tracker,
+				     guint               chunk_index)
+{
+	Chunk *chunk;
+
+	g_return_val_if_fail (GCSV_IS_CHUNKED_TRACKER (tracker), FALSE);
+	g_return_val_if_fail (chunk_index < tracker->chunks->len, FALSE);
+
+	chunk = g_ptr_array_index (tracker->chunks, chunk_index);
+	return chunk->dirty;
+}
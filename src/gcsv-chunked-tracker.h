@@ -0,0 +1,102 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_CHUNKED_TRACKER_H
+#define GCSV_CHUNKED_TRACKER_H
+
+#include <gtk/gtk.h>
+#include "gcsv-buffer.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_CHUNKED_TRACKER (gcsv_chunked_tracker_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvChunkedTracker, gcsv_chunked_tracker,
+		      GCSV, CHUNKED_TRACKER,
+		      GObject)
+
+typedef struct _GcsvChunkedTrackerFuncs GcsvChunkedTrackerFuncs;
+
+/* What the client computes for each chunk. All the functions are called in the
+ * main thread, except compute_chunk. job_data_new, job_data_free,
+ * chunk_computed and chunks_changed can be NULL.
+ */
+struct _GcsvChunkedTrackerFuncs
+{
+	/* The line where the first chunk starts. */
+	gint		(* get_first_line)	(gpointer user_data);
+
+	/* Calls gcsv_chunked_tracker_start() or gcsv_chunked_tracker_stop(),
+	 * when the whole buffer needs to be computed again.
+	 */
+	void		(* recompute)		(gpointer user_data);
+
+	/* A copy of the parameters of the computation, for a worker thread. */
+	gpointer	(* job_data_new)	(gpointer user_data);
+	GDestroyNotify	job_data_free;
+
+	/* In a worker thread. @text is the chunk without the virtual spaces.
+	 * Returns: the result of the chunk.
+	 */
+	gpointer	(* compute_chunk)	(gpointer     job_data,
+						 const gchar *text,
+						 const gchar *text_end);
+	GDestroyNotify	result_free;
+
+	/* The result of the chunk at @chunk_index has been stored. */
+	void		(* chunk_computed)	(gpointer user_data,
+						 guint    chunk_index);
+
+	/* Chunks have been added or removed, or the lines before the first
+	 * chunk have been edited.
+	 */
+	void		(* chunks_changed)	(gpointer user_data);
+};
+
+GcsvChunkedTracker *
+		gcsv_chunked_tracker_new		(GcsvBuffer                    *buffer,
+							 const GcsvChunkedTrackerFuncs *funcs,
+							 gpointer                       user_data);
+
+void		gcsv_chunked_tracker_start		(GcsvChunkedTracker *tracker);
+
+void		gcsv_chunked_tracker_stop		(GcsvChunkedTracker *tracker);
+
+gboolean	gcsv_chunked_tracker_is_started		(GcsvChunkedTracker *tracker);
+
+gboolean	gcsv_chunked_tracker_is_complete	(GcsvChunkedTracker *tracker);
+
+guint		gcsv_chunked_tracker_get_n_chunks	(GcsvChunkedTracker *tracker);
+
+gint		gcsv_chunked_tracker_find_chunk		(GcsvChunkedTracker *tracker,
+							 const GtkTextIter  *iter);
+
+void		gcsv_chunked_tracker_get_chunk_bounds	(GcsvChunkedTracker *tracker,
+							 guint               chunk_index,
+							 GtkTextIter        *start,
+							 GtkTextIter        *end);
+
+gpointer	gcsv_chunked_tracker_get_chunk_result	(GcsvChunkedTracker *tracker,
+							 guint               chunk_index);
+
+gboolean	gcsv_chunked_tracker_is_chunk_dirty	(GcsvChunkedTracker *tracker,
+							 guint               chunk_index);
+
+G_END_DECLS
+
+#endif /* GCSV_CHUNKED_TRACKER_H */
@@ -0,0 +1,598 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-cli.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include "gcsv-column-widths.h"
+#include "gcsv-tokenizer.h"
+
+/* Headless alignment and unalignment, to use gCSVedit in pipelines. The input
+ * is streamed, without GtkTextBuffer, and with the same width rules as
+ * GcsvAlignment: a column length is the maximum number of characters of the
+ * fields in that column, and each field followed by a delimiter is padded with
+ * spaces up to the column length. Like in GcsvAlignment, the lines before the
+ * column titles are a header, copied as is and not part of the column lengths.
+ *
+ * Aligning is done in two passes: the first pass computes the column lengths,
+ * the second pass writes the output. So the memory usage is bounded by the
+ * longest line, not by the file size. When the input is stdin, it is copied to
+ * a temporary file during the first pass.
+ *
+ * Unaligning is done in one pass. Since the virtual spaces can not be
+ * distinguished from real spaces without the GtkTextTag, the trailing spaces
+ * of each field followed by a delimiter are removed.
+ */
+
+typedef struct _Context Context;
+
+typedef void (* LineFunc) (Context     *ctx,
+			   const gchar *line,
+			   gsize        line_length,
+			   const gchar *terminator,
+			   gsize        terminator_length);
+
+struct _Context
+{
+	GcsvCliMode mode;
+
+	GcsvTokenizer tokenizer;
+	guint delimiter_set : 1;
+
+	/* The lines before are the header. Starts at 0. */
+	guint titles_line;
+
+	/* The number of lines read so far in the current pass. */
+	guint64 n_lines_read;
+
+	GcsvColumnWidths *column_widths;
+
+	FILE *output_file;
+	GString *output;
+};
+
+#define CHUNK_SIZE (1024 * 1024)
+
+static void
+set_delimiter (Context  *ctx,
+	       gunichar  delimiter)
+{
+	gcsv_tokenizer_init (&ctx->tokenizer, delimiter);
+	ctx->delimiter_set = TRUE;
+}
+
+static gboolean
+is_header_line (Context *ctx)
+{
+	return ctx->n_lines_read < ctx->titles_line;
+}
+
+static void
+scan_line (Context     *ctx,
+	   const gchar *line,
+	   gsize        line_length,
+	   const gchar *terminator,
+	   gsize        terminator_length)
+{
+	if (!is_header_line (ctx))
+	{
+		gcsv_column_widths_add_line (ctx->column_widths, &ctx->tokenizer, line, line + line_length);
+	}
+}
+
+static gboolean
+flush_output (Context  *ctx,
+	      GError  **error)
+{
+	if (ctx->output->len > 0 &&
+	    fwrite (ctx->output->str, 1, ctx->output->len, ctx->output_file) != ctx->output->len)
+	{
+		gint saved_errno = errno;
+
+		g_set_error (error,
+			     G_FILE_ERROR,
+			     g_file_error_from_errno (saved_errno),
+			     _("Error when writing the output: %s"),
+			     g_strerror (saved_errno));
+		return FALSE;
+	}
+
+	g_string_truncate (ctx->output, 0);
+	return TRUE;
+}
+
+static void
+align_line (Context     *ctx,
+	    const gchar *line,
+	    gsize        line_length,
+	    const gchar *terminator,
+	    gsize        terminator_length)
+{
+	const gchar *line_end = line + line_length;
+	const gchar *field_start = line;
+	guint column_num = 0;
+
+	if (gcsv_tokenizer_get_delimiter (&ctx->tokenizer) != '\0' &&
+	    !is_header_line (ctx))
+	{
+		gsize delimiter_len = gcsv_tokenizer_get_delimiter_length (&ctx->tokenizer);
+		const gchar *field_end;
+
+		while ((field_end = gcsv_tokenizer_find_delimiter (&ctx->tokenizer, field_start, line_end)) != NULL)
+		{
+			gint field_length;
+			gint column_length;
+
+			g_string_append_len (ctx->output, field_start, field_end - field_start);
+
+			field_length = g_utf8_strlen (field_start, field_end - field_start);
+			column_length = gcsv_column_widths_get (ctx->column_widths, column_num);
+
+			for (; field_length < column_length; field_length++)
+			{
+				g_string_append_c (ctx->output, ' ');
+			}
+
+			g_string_append_len (ctx->output, field_end, delimiter_len);
+
+			field_start = field_end + delimiter_len;
+			column_num++;
+		}
+	}
+
+	g_string_append_len (ctx->output, field_start, line_end - field_start);
+	g_string_append_len (ctx->output, terminator, terminator_length);
+}
+
+static void
+unalign_line (Context     *ctx,
+	      const gchar *line,
+	      gsize        line_length,
+	      const gchar *terminator,
+	      gsize        terminator_length)
+{
+	const gchar *line_end = line + line_length;
+	const gchar *field_start = line;
+
+	if (gcsv_tokenizer_get_delimiter (&ctx->tokenizer) != '\0' &&
+	    !is_header_line (ctx))
+	{
+		gsize delimiter_len = gcsv_tokenizer_get_delimiter_length (&ctx->tokenizer);
+		const gchar *field_end;
+
+		while ((field_end = gcsv_tokenizer_find_delimiter (&ctx->tokenizer, field_start, line_end)) != NULL)
+		{
+			const gchar *content_end = field_end;
+
+			while (content_end > field_start && content_end[-1] == ' ')
+			{
+				content_end--;
+			}
+
+			g_string_append_len (ctx->output, field_start, content_end - field_start);
+			g_string_append_len (ctx->output, field_end, delimiter_len);
+
+			field_start = field_end + delimiter_len;
+		}
+	}
+
+	g_string_append_len (ctx->output, field_start, line_end - field_start);
+	g_string_append_len (ctx->output, terminator, terminator_length);
+}
+
+static gboolean
+read_error (FILE    *input,
+	    GError **error)
+{
+	gint saved_errno = errno;
+
+	if (!ferror (input))
+	{
+		return FALSE;
+	}
+
+	g_set_error (error,
+		     G_FILE_ERROR,
+		     g_file_error_from_errno (saved_errno),
+		     _("Error when reading the input: %s"),
+		     g_strerror (saved_errno));
+	return TRUE;
+}
+
+/* Reads @input by chunks and calls @line_func for each line, with the line
+ * terminator separated. A line is kept in memory only until it is complete.
+ * If @spill is not %NULL, the input is also copied to it.
+ */
+static gboolean
+read_lines (Context   *ctx,
+	    FILE      *input,
+	    FILE      *spill,
+	    LineFunc   line_func,
+	    GError   **error)
+{
+	GByteArray *buffer;
+	gboolean ok = TRUE;
+
+	buffer = g_byte_array_sized_new (CHUNK_SIZE);
+
+	while (TRUE)
+	{
+		gsize old_length = buffer->len;
+		gsize n_read;
+		const gchar *data;
+		const gchar *end;
+		const gchar *line_start;
+		gboolean eof;
+
+		g_byte_array_set_size (buffer, old_length + CHUNK_SIZE);
+		n_read = fread (buffer->data + old_length, 1, CHUNK_SIZE, input);
+		g_byte_array_set_size (buffer, old_length + n_read);
+
+		if (read_error (input, error))
+		{
+			ok = FALSE;
+			break;
+		}
+
+		eof = n_read < CHUNK_SIZE;
+
+		if (spill != NULL && n_read > 0 &&
+		    fwrite (buffer->data + old_length, 1, n_read, spill) != n_read)
+		{
+			gint saved_errno = errno;
+
+			g_set_error (error,
+				     G_FILE_ERROR,
+				     g_file_error_from_errno (saved_errno),
+				     _("Error when writing the temporary file: %s"),
+				     g_strerror (saved_errno));
+			ok = FALSE;
+			break;
+		}
+
+		data = (const gchar *) buffer->data;
+		end = data + buffer->len;
+
+		if (!ctx->delimiter_set)
+		{
+			set_delimiter (ctx, gcsv_tokenizer_guess_delimiter (data, buffer->len));
+		}
+
+		line_start = data;
+
+		while (line_start < end)
+		{
+			const gchar *newline;
+			const gchar *line_end;
+
+			newline = memchr (line_start, '\n', end - line_start);
+			if (newline == NULL)
+			{
+				if (!eof)
+				{
+					break;
+				}
+
+				line_func (ctx, line_start, end - line_start, NULL, 0);
+				ctx->n_lines_read++;
+				line_start = end;
+				break;
+			}
+
+			line_end = newline;
+			if (line_end > line_start && line_end[-1] == '\r')
+			{
+				line_end--;
+			}
+
+			line_func (ctx,
+				   line_start, line_end - line_start,
+				   line_end, newline + 1 - line_end);
+			ctx->n_lines_read++;
+
+			line_start = newline + 1;
+		}
+
+		if (ctx->output->len >= CHUNK_SIZE &&
+		    !flush_output (ctx, error))
+		{
+			ok = FALSE;
+			break;
+		}
+
+		/* Keep the incomplete line for the next chunk. */
+		g_byte_array_remove_range (buffer, 0, line_start - data);
+
+		if (eof)
+		{
+			break;
+		}
+	}
+
+	g_byte_array_unref (buffer);
+	return ok;
+}
+
+static gboolean
+parse_delimiter (Context      *ctx,
+		 const gchar  *delimiter,
+		 GError      **error)
+{
+	if (delimiter == NULL)
+	{
+		/* Guessed from the first chunk. */
+		return TRUE;
+	}
+
+	if (g_str_equal (delimiter, "\\t") ||
+	    g_ascii_strcasecmp (delimiter, "tab") == 0)
+	{
+		set_delimiter (ctx, '\t');
+		return TRUE;
+	}
+
+	if (!g_utf8_validate (delimiter, -1, NULL) ||
+	    g_utf8_strlen (delimiter, -1) > 1 ||
+	    delimiter[0] == '\n' ||
+	    delimiter[0] == '\r')
+	{
+		g_set_error (error,
+			     G_OPTION_ERROR,
+			     G_OPTION_ERROR_BAD_VALUE,
+			     _("Invalid delimiter: “%s”. The delimiter must be one character."),
+			     delimiter);
+		return FALSE;
+	}
+
+	/* An empty delimiter means no alignment. */
+	set_delimiter (ctx, g_utf8_get_char (delimiter));
+	return TRUE;
+}
+
+static FILE *
+open_spill_file (gchar   **path,
+		 GError  **error)
+{
+	gint fd;
+	FILE *file;
+
+	fd = g_file_open_tmp ("gcsvedit-XXXXXX", path, error);
+	if (fd == -1)
+	{
+		return NULL;
+	}
+
+	file = fdopen (fd, "w+b");
+	if (file == NULL)
+	{
+		gint saved_errno = errno;
+
+		g_set_error (error,
+			     G_FILE_ERROR,
+			     g_file_error_from_errno (saved_errno),
+			     _("Error when opening the temporary file: %s"),
+			     g_strerror (saved_errno));
+
+		g_close (fd, NULL);
+		g_unlink (*path);
+		g_clear_pointer (path, g_free);
+	}
+
+	return file;
+}
+
+static gboolean
+run (Context      *ctx,
+     FILE         *input,
+     gboolean      input_is_seekable,
+     GError      **error)
+{
+	FILE *spill = NULL;
+	gchar *spill_path = NULL;
+	gboolean ok = FALSE;
+
+	if (ctx->mode == GCSV_CLI_MODE_UNALIGN)
+	{
+		ok = read_lines (ctx, input, NULL, unalign_line, error);
+		goto out;
+	}
+
+	/* First pass. */
+	if (!input_is_seekable)
+	{
+		spill = open_spill_file (&spill_path, error);
+		if (spill == NULL)
+		{
+			goto out;
+		}
+	}
+
+	if (!read_lines (ctx, input, spill, scan_line, error))
+	{
+		goto out;
+	}
+
+	/* Second pass. */
+	if (spill != NULL)
+	{
+		if (fflush (spill) != 0)
+		{
+			gint saved_errno = errno;
+
+			g_set_error (error,
+				     G_FILE_ERROR,
+				     g_file_error_from_errno (saved_errno),
+				     _("Error when writing the temporary file: %s"),
+				     g_strerror (saved_errno));
+			goto out;
+		}
+
+		input = spill;
+	}
+
+	rewind (input);
+	ctx->n_lines_read = 0;
+
+	ok = read_lines (ctx, input, NULL, align_line, error);
+
+out:
+	if (spill != NULL)
+	{
+		fclose (spill);
+		g_unlink (spill_path);
+	}
+
+	g_free (spill_path);
+
+	return ok && flush_output (ctx, error);
+}
+
+static FILE *
+open_file (const gchar  *path,
+	   const gchar  *mode,
+	   GError      **error)
+{
+	FILE *file;
+	gint saved_errno;
+	gchar *display_name;
+
+	file = g_fopen (path, mode);
+	if (file != NULL)
+	{
+		return file;
+	}
+
+	saved_errno = errno;
+	display_name = g_filename_display_name (path);
+
+	g_set_error (error,
+		     G_FILE_ERROR,
+		     g_file_error_from_errno (saved_errno),
+		     _("Error when opening “%s”: %s"),
+		     display_name,
+		     g_strerror (saved_errno));
+
+	g_free (display_name);
+	return NULL;
+}
+
+static gboolean
+is_std_stream (const gchar *path)
+{
+	return path == NULL || g_str_equal (path, "-");
+}
+
+/* Aligns or unaligns @input_path, or stdin if %NULL or "-", to @output_path,
+ * or stdout if %NULL or "-". If @delimiter is %NULL, it is guessed from the
+ * beginning of the input. The lines before @titles_line (starting at 0) are
+ * copied as is.
+ */
+gboolean
+gcsv_cli_run (GcsvCliMode   mode,
+	      const gchar  *input_path,
+	      const gchar  *output_path,
+	      const gchar  *delimiter,
+	      guint         titles_line,
+	      GError      **error)
+{
+	Context ctx = { 0 };
+	FILE *input;
+	gboolean input_is_stdin;
+	gboolean output_is_stdout;
+	gboolean ok;
+
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	ctx.mode = mode;
+	ctx.titles_line = titles_line;
+
+	if (!parse_delimiter (&ctx, delimiter, error))
+	{
+		return FALSE;
+	}
+
+	input_is_stdin = is_std_stream (input_path);
+	output_is_stdout = is_std_stream (output_path);
+
+	if (input_is_stdin)
+	{
+		input = stdin;
+	}
+	else
+	{
+		input = open_file (input_path, "rb", error);
+		if (input == NULL)
+		{
+			return FALSE;
+		}
+	}
+
+	if (output_is_stdout)
+	{
+		ctx.output_file = stdout;
+	}
+	else
+	{
+		ctx.output_file = open_file (output_path, "wb", error);
+		if (ctx.output_file == NULL)
+		{
+			if (!input_is_stdin)
+			{
+				fclose (input);
+			}
+
+			return FALSE;
+		}
+	}
+
+	ctx.column_widths = gcsv_column_widths_new ();
+	ctx.output = g_string_sized_new (2 * CHUNK_SIZE);
+
+	ok = run (&ctx, input, !input_is_stdin, error);
+
+	if (ok &&
+	    (output_is_stdout ? fflush (ctx.output_file) : fclose (ctx.output_file)) != 0)
+	{
+		gint saved_errno = errno;
+
+		g_set_error (error,
+			     G_FILE_ERROR,
+			     g_file_error_from_errno (saved_errno),
+			     _("Error when writing the output: %s"),
+			     g_strerror (saved_errno));
+		ok = FALSE;
+	}
+	else if (!ok && !output_is_stdout)
+	{
+		fclose (ctx.output_file);
+	}
+
+	if (!input_is_stdin)
+	{
+		fclose (input);
+	}
+
+	gcsv_column_widths_free (ctx.column_widths);
+	g_string_free (ctx.output, TRUE);
+
+	return ok;
+}
@@ -0,0 +1,42 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_CLI_H
+#define GCSV_CLI_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum _GcsvCliMode
+{
+	GCSV_CLI_MODE_ALIGN,
+	GCSV_CLI_MODE_UNALIGN
+} GcsvCliMode;
+
+gboolean	gcsv_cli_run		(GcsvCliMode   mode,
+					 const gchar  *input_path,
+					 const gchar  *output_path,
+					 const gchar  *delimiter,
+					 guint         titles_line,
+					 GError      **error);
+
+G_END_DECLS
+
+#endif /* GCSV_CLI_H */
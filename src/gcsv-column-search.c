@@ -0,0 +1,686 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-column-search.h"
+#include <string.h>
+#include "gcsv-chunked-tracker.h"
+#include "gcsv-trigram-index.h"
+
+/* Searches a pattern in some columns only, ignoring the virtual spaces added
+ * by the alignment. A match is always inside one field.
+ *
+ * To make the search fast on big files, a GcsvTrigramIndex of each chunk of
+ * the buffer is built with a GcsvChunkedTracker. The search then checks only
+ * the candidate lines given by the index. A chunk that is not indexed yet, or
+ * edited since, is searched line by line.
+ *
+ * The virtual spaces are at the end of the fields, so the text indexed, which
+ * is without virtual spaces, has the same lines as the buffer.
+ */
+
+struct _GcsvColumnSearch
+{
+	GObject parent;
+
+	GcsvBuffer *buffer;
+
+	/* Sorted column numbers, as guint's. NULL to search in all the
+	 * columns.
+	 */
+	GArray *columns;
+
+	GcsvChunkedTracker *chunked_tracker;
+
+	guint case_sensitive : 1;
+};
+
+enum
+{
+	PROP_0,
+	PROP_BUFFER,
+};
+
+G_DEFINE_TYPE (GcsvColumnSearch, gcsv_column_search, G_TYPE_OBJECT)
+
+static gint
+get_first_line (gpointer user_data)
+{
+	return 0;
+}
+
+static void
+reindex (gpointer user_data)
+{
+	GcsvColumnSearch *search = GCSV_COLUMN_SEARCH (user_data);
+
+	gcsv_chunked_tracker_start (search->chunked_tracker);
+}
+
+static gpointer
+index_chunk (gpointer     job_data,
+	     const gchar *text,
+	     const gchar *text_end)
+{
+	return gcsv_trigram_index_new (text, text_end);
+}
+
+static const GcsvChunkedTrackerFuncs chunked_tracker_funcs =
+{
+	get_first_line,
+	reindex,
+	NULL,
+	NULL,
+	index_chunk,
+	(GDestroyNotify) gcsv_trigram_index_free,
+	NULL,
+	NULL,
+};
+
+/* Moves @end backward to the end of the field content, before the virtual
+ * spaces.
+ */
+static void
+skip_virtual_spaces_backward (GcsvColumnSearch  *search,
+			      const GtkTextIter *field_start,
+			      GtkTextIter       *end)
+{
+	GtkTextTag *tag = gcsv_buffer_get_virtual_spaces_tag (search->buffer);
+
+	while (gtk_text_iter_compare (field_start, end) < 0)
+	{
+		GtkTextIter prev = *end;
+
+		gtk_text_iter_backward_char (&prev);
+		if (!gtk_text_iter_has_tag (&prev, tag))
+		{
+			break;
+		}
+
+		*end = prev;
+	}
+}
+
+static GtkTextSearchFlags
+get_search_flags (GcsvColumnSearch *search)
+{
+	GtkTextSearchFlags flags = GTK_TEXT_SEARCH_TEXT_ONLY;
+
+	if (!search->case_sensitive)
+	{
+		flags |= GTK_TEXT_SEARCH_CASE_INSENSITIVE;
+	}
+
+	return flags;
+}
+
+static guint
+get_n_columns_in_scope (GcsvColumnSearch *search,
+			guint             n_columns)
+{
+	return search->columns != NULL ? search->columns->len : n_columns;
+}
+
+static guint
+get_column_in_scope (GcsvColumnSearch *search,
+		     guint             i)
+{
+	return search->columns != NULL ? g_array_index (search->columns, guint, i) : i;
+}
+
+/* Searches the first match in the fields of @line_num, starting at @from if
+ * not %NULL.
+ */
+static gboolean
+search_line_forward (GcsvColumnSearch  *search,
+		     gint               line_num,
+		     const gchar       *pattern,
+		     const GtkTextIter *from,
+		     GtkTextIter       *match_start,
+		     GtkTextIter       *match_end)
+{
+	guint n_columns;
+	guint i;
+
+	n_columns = gcsv_buffer_count_columns_at_line (search->buffer, line_num);
+
+	for (i = 0; i < get_n_columns_in_scope (search, n_columns); i++)
+	{
+		guint column_num = get_column_in_scope (search, i);
+		GtkTextIter field_start;
+		GtkTextIter content_end;
+		GtkTextIter start;
+
+		if (column_num >= n_columns)
+		{
+			break;
+		}
+
+		gcsv_buffer_get_field_bounds (search->buffer, line_num, column_num, &field_start, &content_end);
+		skip_virtual_spaces_backward (search, &field_start, &content_end);
+
+		start = field_start;
+		if (from != NULL && gtk_text_iter_compare (&start, from) < 0)
+		{
+			start = *from;
+		}
+
+		if (gtk_text_iter_compare (&start, &content_end) <= 0 &&
+		    gtk_text_iter_forward_search (&start, pattern, get_search_flags (search),
+						  match_start, match_end, &content_end))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/* Searches the last match in the fields of @line_num, ending at @from if not
+ * %NULL.
+ */
+static gboolean
+search_line_backward (GcsvColumnSearch  *search,
+		      gint               line_num,
+		      const gchar       *pattern,
+		      const GtkTextIter *from,
+		      GtkTextIter       *match_start,
+		      GtkTextIter       *match_end)
+{
+	guint n_columns;
+	guint i;
+
+	n_columns = gcsv_buffer_count_columns_at_line (search->buffer, line_num);
+
+	for (i = get_n_columns_in_scope (search, n_columns); i > 0; i--)
+	{
+		guint column_num = get_column_in_scope (search, i - 1);
+		GtkTextIter field_start;
+		GtkTextIter end;
+
+		if (column_num >= n_columns)
+		{
+			continue;
+		}
+
+		gcsv_buffer_get_field_bounds (search->buffer, line_num, column_num, &field_start, &end);
+		skip_virtual_spaces_backward (search, &field_start, &end);
+
+		if (from != NULL && gtk_text_iter_compare (from, &end) < 0)
+		{
+			end = *from;
+		}
+
+		if (gtk_text_iter_compare (&field_start, &end) <= 0 &&
+		    gtk_text_iter_backward_search (&end, pattern, get_search_flags (search),
+						   match_start, match_end, &field_start))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/* Returns: (transfer none) (nullable): the index of the chunk at
+ * @chunk_index, if it can be used for @pattern.
+ */
+static GcsvTrigramIndex *
+get_usable_index (GcsvColumnSearch *search,
+		  guint             chunk_index,
+		  const gchar      *pattern)
+{
+	/* The index has only the ASCII letters in lowercase. */
+	if (gcsv_chunked_tracker_is_chunk_dirty (search->chunked_tracker, chunk_index) ||
+	    !(search->case_sensitive || g_str_is_ascii (pattern)))
+	{
+		return NULL;
+	}
+
+	return gcsv_chunked_tracker_get_chunk_result (search->chunked_tracker, chunk_index);
+}
+
+/* Gets the lines of the chunk at @chunk_index to search, in increasing order.
+ * Returns: (transfer full) (nullable): the line numbers relative to the chunk
+ * start, or %NULL to search all the lines.
+ */
+static GArray *
+get_candidate_lines (GcsvColumnSearch *search,
+		     guint             chunk_index,
+		     const gchar      *pattern)
+{
+	GcsvTrigramIndex *index;
+	GArray *candidate_lines;
+
+	index = get_usable_index (search, chunk_index, pattern);
+
+	if (index == NULL)
+	{
+		return NULL;
+	}
+
+	candidate_lines = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	if (!gcsv_trigram_index_lookup (index, pattern, strlen (pattern), candidate_lines))
+	{
+		g_array_unref (candidate_lines);
+		return NULL;
+	}
+
+	return candidate_lines;
+}
+
+/* Gets the chunk containing @line_num and the lines of the chunk. */
+static void
+get_chunk_at_line (GcsvColumnSearch *search,
+		   gint              line_num,
+		   guint            *chunk_index,
+		   gint             *chunk_first_line,
+		   gint             *chunk_last_line)
+{
+	GtkTextIter iter;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (search->buffer), &iter, line_num);
+
+	/* The first chunk starts at the first line. */
+	*chunk_index = MAX (gcsv_chunked_tracker_find_chunk (search->chunked_tracker, &iter), 0);
+	gcsv_chunked_tracker_get_chunk_bounds (search->chunked_tracker, *chunk_index, &start, &end);
+
+	*chunk_first_line = gtk_text_iter_get_line (&start);
+	*chunk_last_line = gtk_text_iter_get_line (&end);
+	if (gtk_text_iter_starts_line (&end) && !gtk_text_iter_is_end (&end))
+	{
+		(*chunk_last_line)--;
+	}
+}
+
+static gboolean
+search_lines_forward (GcsvColumnSearch  *search,
+		      gint               first_line,
+		      gint               last_line,
+		      const gchar       *pattern,
+		      const GtkTextIter *from,
+		      GtkTextIter       *match_start,
+		      GtkTextIter       *match_end)
+{
+	gint line_num = first_line;
+
+	while (line_num <= last_line)
+	{
+		guint chunk_index;
+		gint chunk_first_line;
+		gint chunk_last_line;
+		gint range_last_line;
+		GArray *candidate_lines;
+
+		get_chunk_at_line (search, line_num, &chunk_index, &chunk_first_line, &chunk_last_line);
+		range_last_line = MIN (MAX (chunk_last_line, line_num), last_line);
+		candidate_lines = get_candidate_lines (search, chunk_index, pattern);
+
+		if (candidate_lines == NULL)
+		{
+			for (; line_num <= range_last_line; line_num++)
+			{
+				if (search_line_forward (search, line_num, pattern,
+							 line_num == first_line ? from : NULL,
+							 match_start, match_end))
+				{
+					return TRUE;
+				}
+			}
+		}
+		else
+		{
+			guint i;
+
+			for (i = 0; i < candidate_lines->len; i++)
+			{
+				gint candidate = chunk_first_line + g_array_index (candidate_lines, guint, i);
+
+				if (candidate < line_num || candidate > range_last_line)
+				{
+					continue;
+				}
+
+				if (search_line_forward (search, candidate, pattern,
+							 candidate == first_line ? from : NULL,
+							 match_start, match_end))
+				{
+					g_array_unref (candidate_lines);
+					return TRUE;
+				}
+			}
+
+			g_array_unref (candidate_lines);
+		}
+
+		line_num = range_last_line + 1;
+	}
+
+	return FALSE;
+}
+
+static gboolean
+search_lines_backward (GcsvColumnSearch  *search,
+		       gint               first_line,
+		       gint               last_line,
+		       const gchar       *pattern,
+		       const GtkTextIter *from,
+		       GtkTextIter       *match_start,
+		       GtkTextIter       *match_end)
+{
+	gint line_num = last_line;
+
+	while (line_num >= first_line)
+	{
+		guint chunk_index;
+		gint chunk_first_line;
+		gint chunk_last_line;
+		gint range_first_line;
+		GArray *candidate_lines;
+
+		get_chunk_at_line (search, line_num, &chunk_index, &chunk_first_line, &chunk_last_line);
+		range_first_line = MAX (MIN (chunk_first_line, line_num), first_line);
+		candidate_lines = get_candidate_lines (search, chunk_index, pattern);
+
+		if (candidate_lines == NULL)
+		{
+			for (; line_num >= range_first_line; line_num--)
+			{
+				if (search_line_backward (search, line_num, pattern,
+							  line_num == last_line ? from : NULL,
+							  match_start, match_end))
+				{
+					return TRUE;
+				}
+			}
+		}
+		else
+		{
+			guint i;
+
+			for (i = candidate_lines->len; i > 0; i--)
+			{
+				gint candidate = chunk_first_line + g_array_index (candidate_lines, guint, i - 1);
+
+				if (candidate > line_num || candidate < range_first_line)
+				{
+					continue;
+				}
+
+				if (search_line_backward (search, candidate, pattern,
+							  candidate == last_line ? from : NULL,
+							  match_start, match_end))
+				{
+					g_array_unref (candidate_lines);
+					return TRUE;
+				}
+			}
+
+			g_array_unref (candidate_lines);
+		}
+
+		line_num = range_first_line - 1;
+	}
+
+	return FALSE;
+}
+
+static void
+set_buffer (GcsvColumnSearch *search,
+	    GcsvBuffer       *buffer)
+{
+	g_assert (search->buffer == NULL);
+
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+	search->buffer = g_object_ref (buffer);
+
+	search->chunked_tracker = gcsv_chunked_tracker_new (buffer, &chunked_tracker_funcs, search);
+
+	g_object_notify (G_OBJECT (search), "buffer");
+}
+
+static void
+gcsv_column_search_get_property (GObject    *object,
+				 guint       prop_id,
+				 GValue     *value,
+				 GParamSpec *pspec)
+{
+	GcsvColumnSearch *search = GCSV_COLUMN_SEARCH (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_value_set_object (value, search->buffer);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_column_search_set_property (GObject      *object,
+				 guint         prop_id,
+				 const GValue *value,
+				 GParamSpec   *pspec)
+{
+	GcsvColumnSearch *search = GCSV_COLUMN_SEARCH (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			set_buffer (search, g_value_get_object (value));
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_column_search_constructed (GObject *object)
+{
+	G_OBJECT_CLASS (gcsv_column_search_parent_class)->constructed (object);
+
+	reindex (GCSV_COLUMN_SEARCH (object));
+}
+
+static void
+gcsv_column_search_dispose (GObject *object)
+{
+	GcsvColumnSearch *search = GCSV_COLUMN_SEARCH (object);
+
+	if (search->chunked_tracker != NULL)
+	{
+		gcsv_chunked_tracker_stop (search->chunked_tracker);
+		g_clear_object (&search->chunked_tracker);
+	}
+
+	g_clear_object (&search->buffer);
+
+	G_OBJECT_CLASS (gcsv_column_search_parent_class)->dispose (object);
+}
+
+static void
+gcsv_column_search_finalize (GObject *object)
+{
+	GcsvColumnSearch *search = GCSV_COLUMN_SEARCH (object);
+
+	if (search->columns != NULL)
+	{
+		g_array_unref (search->columns);
+	}
+
+	G_OBJECT_CLASS (gcsv_column_search_parent_class)->finalize (object);
+}
+
+static void
+gcsv_column_search_class_init (GcsvColumnSearchClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_column_search_get_property;
+	object_class->set_property = gcsv_column_search_set_property;
+	object_class->constructed = gcsv_column_search_constructed;
+	object_class->dispose = gcsv_column_search_dispose;
+	object_class->finalize = gcsv_column_search_finalize;
+
+	g_object_class_install_property (object_class,
+					 PROP_BUFFER,
+					 g_param_spec_object ("buffer",
+							      "Buffer",
+							      "",
+							      GCSV_TYPE_BUFFER,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gcsv_column_search_init (GcsvColumnSearch *search)
+{
+	search->case_sensitive = TRUE;
+}
+
+/* The buffer is indexed in the background, as long as the object is alive. */
+GcsvColumnSearch *
+gcsv_column_search_new (GcsvBuffer *buffer)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+
+	return g_object_new (GCSV_TYPE_COLUMN_SEARCH,
+			     "buffer", buffer,
+			     NULL);
+}
+
+static gint
+compare_column_nums (gconstpointer a,
+		     gconstpointer b)
+{
+	guint column_a = *(const guint *) a;
+	guint column_b = *(const guint *) b;
+
+	return column_a < column_b ? -1 : column_a > column_b;
+}
+
+/* Sets the columns to search in, as an array of guint's, or %NULL to search
+ * in all the columns.
+ */
+void
+gcsv_column_search_set_columns (GcsvColumnSearch *search,
+				GArray           *columns)
+{
+	guint n_columns = 0;
+	guint i;
+
+	g_return_if_fail (GCSV_IS_COLUMN_SEARCH (search));
+
+	if (search->columns != NULL)
+	{
+		g_array_unref (search->columns);
+		search->columns = NULL;
+	}
+
+	if (columns == NULL)
+	{
+		return;
+	}
+
+	search->columns = g_array_sized_new (FALSE, FALSE, sizeof (guint), columns->len);
+	g_array_append_vals (search->columns, columns->data, columns->len);
+	g_array_sort (search->columns, compare_column_nums);
+
+	/* Removes the duplicates. */
+	for (i = 0; i < search->columns->len; i++)
+	{
+		guint column_num = g_array_index (search->columns, guint, i);
+
+		if (n_columns == 0 || column_num != g_array_index (search->columns, guint, n_columns - 1))
+		{
+			g_array_index (search->columns, guint, n_columns++) = column_num;
+		}
+	}
+
+	g_array_set_size (search->columns, n_columns);
+}
+
+void
+gcsv_column_search_set_case_sensitive (GcsvColumnSearch *search,
+				       gboolean          case_sensitive)
+{
+	g_return_if_fail (GCSV_IS_COLUMN_SEARCH (search));
+
+	search->case_sensitive = case_sensitive != FALSE;
+}
+
+/* Finds the next match of @pattern after @from, or the previous one before
+ * @from if @backward is %TRUE. The search wraps around the buffer.
+ *
+ * Returns: whether a match has been found.
+ */
+gboolean
+gcsv_column_search_find (GcsvColumnSearch  *search,
+			 const gchar       *pattern,
+			 const GtkTextIter *from,
+			 gboolean           backward,
+			 GtkTextIter       *match_start,
+			 GtkTextIter       *match_end)
+{
+	gint from_line;
+	gint last_line;
+
+	g_return_val_if_fail (GCSV_IS_COLUMN_SEARCH (search), FALSE);
+	g_return_val_if_fail (pattern != NULL, FALSE);
+	g_return_val_if_fail (from != NULL, FALSE);
+	g_return_val_if_fail (match_start != NULL, FALSE);
+	g_return_val_if_fail (match_end != NULL, FALSE);
+
+	/* A match is inside one field. */
+	if (pattern[0] == '\0' || strpbrk (pattern, "\n\r") != NULL)
+	{
+		return FALSE;
+	}
+
+	from_line = gtk_text_iter_get_line (from);
+	last_line = gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (search->buffer)) - 1;
+
+	if (!backward)
+	{
+		return (search_lines_forward (search, from_line, last_line, pattern, from, match_start, match_end) ||
+			search_lines_forward (search, 0, from_line, pattern, NULL, match_start, match_end));
+	}
+
+	return (search_lines_backward (search, 0, from_line, pattern, from, match_start, match_end) ||
+		search_lines_backward (search, from_line, last_line, pattern, NULL, match_start, match_end));
+}
+
+/* Returns whether some chunks are not indexed yet. The search works in the
+ * meantime, but is slower.
+ */
+gboolean
+gcsv_column_search_is_indexing (GcsvColumnSearch *search)
+{
+	g_return_val_if_fail (GCSV_IS_COLUMN_SEARCH (search), FALSE);
+
+	return !gcsv_chunked_tracker_is_complete (search->chunked_tracker);
+}
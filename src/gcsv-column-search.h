@@ -0,0 +1,52 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_COLUMN_SEARCH_H
+#define GCSV_COLUMN_SEARCH_H
+
+#include <gtk/gtk.h>
+#include "gcsv-buffer.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_COLUMN_SEARCH (gcsv_column_search_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvColumnSearch, gcsv_column_search,
+		      GCSV, COLUMN_SEARCH,
+		      GObject)
+
+GcsvColumnSearch *	gcsv_column_search_new			(GcsvBuffer *buffer);
+
+void			gcsv_column_search_set_columns		(GcsvColumnSearch *search,
+								 GArray           *columns);
+
+void			gcsv_column_search_set_case_sensitive	(GcsvColumnSearch *search,
+								 gboolean          case_sensitive);
+
+gboolean		gcsv_column_search_find			(GcsvColumnSearch  *search,
+								 const gchar       *pattern,
+								 const GtkTextIter *from,
+								 gboolean           backward,
+								 GtkTextIter       *match_start,
+								 GtkTextIter       *match_end);
+
+gboolean		gcsv_column_search_is_indexing		(GcsvColumnSearch *search);
+
+G_END_DECLS
+
+#endif /* GCSV_COLUMN_SEARCH_H */
@@ -0,0 +1,426 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-column-stats-tracker.h"
+#include "gcsv-chunked-tracker.h"
+
+/* Keeps the GcsvColumnStats of one column up to date, without blocking the
+ * main thread on big files.
+ *
+ * The stats of each chunk of lines after the column titles are computed by a
+ * GcsvChunkedTracker, and the stats of all the chunks are merged in the main
+ * thread, which is cheap since the stats have a fixed size.
+ */
+
+struct _GcsvColumnStatsTracker
+{
+	GObject parent;
+
+	GcsvBuffer *buffer;
+	guint column_num;
+
+	GcsvTokenizer tokenizer;
+
+	GcsvChunkedTracker *chunked_tracker;
+
+	/* The merged stats of all the chunks. NULL if there is no stats yet. */
+	GcsvColumnStats *stats;
+
+	guint merge_idle_id;
+};
+
+/* The parameters of a chunk computation, for the worker thread. */
+typedef struct _JobData JobData;
+struct _JobData
+{
+	guint column_num;
+	GcsvTokenizer tokenizer;
+};
+
+enum
+{
+	PROP_0,
+	PROP_BUFFER,
+};
+
+enum
+{
+	SIGNAL_CHANGED,
+	LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE (GcsvColumnStatsTracker, gcsv_column_stats_tracker, G_TYPE_OBJECT)
+
+static gboolean
+merge_idle_cb (gpointer user_data)
+{
+	GcsvColumnStatsTracker *tracker = GCSV_COLUMN_STATS_TRACKER (user_data);
+	GcsvColumnStats *stats;
+	guint n_chunks;
+	guint i;
+
+	tracker->merge_idle_id = 0;
+
+	stats = gcsv_column_stats_new ();
+	n_chunks = gcsv_chunked_tracker_get_n_chunks (tracker->chunked_tracker);
+
+	for (i = 0; i < n_chunks; i++)
+	{
+		GcsvColumnStats *chunk_stats;
+
+		chunk_stats = gcsv_chunked_tracker_get_chunk_result (tracker->chunked_tracker, i);
+
+		if (chunk_stats != NULL)
+		{
+			gcsv_column_stats_merge (stats, chunk_stats);
+		}
+	}
+
+	gcsv_column_stats_free (tracker->stats);
+	tracker->stats = stats;
+
+	g_signal_emit (tracker, signals[SIGNAL_CHANGED], 0);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Several results can arrive during the same main loop iteration, they are
+ * merged only once.
+ */
+static void
+queue_merge (GcsvColumnStatsTracker *tracker)
+{
+	if (tracker->merge_idle_id == 0)
+	{
+		tracker->merge_idle_id = g_idle_add (merge_idle_cb, tracker);
+	}
+}
+
+static gint
+get_first_line (gpointer user_data)
+{
+	GcsvColumnStatsTracker *tracker = GCSV_COLUMN_STATS_TRACKER (user_data);
+	GtkTextIter titles_location;
+
+	gcsv_buffer_get_column_titles_location (tracker->buffer, &titles_location);
+	return gtk_text_iter_get_line (&titles_location) + 1;
+}
+
+/* Computes the stats of the whole buffer again. */
+static void
+recompute (gpointer user_data)
+{
+	GcsvColumnStatsTracker *tracker = GCSV_COLUMN_STATS_TRACKER (user_data);
+	gunichar delimiter;
+
+	delimiter = gcsv_buffer_get_delimiter (tracker->buffer);
+
+	if (delimiter == '\0')
+	{
+		gcsv_chunked_tracker_stop (tracker->chunked_tracker);
+
+		gcsv_column_stats_free (tracker->stats);
+		tracker->stats = NULL;
+
+		if (tracker->merge_idle_id != 0)
+		{
+			g_source_remove (tracker->merge_idle_id);
+			tracker->merge_idle_id = 0;
+		}
+
+		g_signal_emit (tracker, signals[SIGNAL_CHANGED], 0);
+		return;
+	}
+
+	gcsv_tokenizer_init (&tracker->tokenizer, delimiter);
+	gcsv_chunked_tracker_start (tracker->chunked_tracker);
+
+	/* An empty table has empty stats. */
+	queue_merge (tracker);
+}
+
+static gpointer
+job_data_new (gpointer user_data)
+{
+	GcsvColumnStatsTracker *tracker = GCSV_COLUMN_STATS_TRACKER (user_data);
+	JobData *data;
+
+	data = g_new0 (JobData, 1);
+	data->column_num = tracker->column_num;
+	data->tokenizer = tracker->tokenizer;
+
+	return data;
+}
+
+static gpointer
+compute_chunk (gpointer     job_data,
+	       const gchar *text,
+	       const gchar *text_end)
+{
+	JobData *data = job_data;
+	GcsvColumnStats *stats;
+
+	stats = gcsv_column_stats_new ();
+	gcsv_column_stats_add_lines (stats, &data->tokenizer, data->column_num, text, text_end);
+
+	return stats;
+}
+
+static void
+chunk_computed (gpointer user_data,
+		guint    chunk_index)
+{
+	queue_merge (GCSV_COLUMN_STATS_TRACKER (user_data));
+}
+
+static void
+chunks_changed (gpointer user_data)
+{
+	queue_merge (GCSV_COLUMN_STATS_TRACKER (user_data));
+}
+
+static const GcsvChunkedTrackerFuncs chunked_tracker_funcs =
+{
+	get_first_line,
+	recompute,
+	job_data_new,
+	g_free,
+	compute_chunk,
+	(GDestroyNotify) gcsv_column_stats_free,
+	chunk_computed,
+	chunks_changed,
+};
+
+static void
+delimiter_notify_cb (GcsvBuffer             *buffer,
+		     GParamSpec             *pspec,
+		     GcsvColumnStatsTracker *tracker)
+{
+	recompute (tracker);
+}
+
+static void
+column_titles_set_cb (GcsvBuffer             *buffer,
+		      GcsvColumnStatsTracker *tracker)
+{
+	recompute (tracker);
+}
+
+static void
+set_buffer (GcsvColumnStatsTracker *tracker,
+	    GcsvBuffer             *buffer)
+{
+	g_assert (tracker->buffer == NULL);
+
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+	tracker->buffer = g_object_ref (buffer);
+
+	tracker->chunked_tracker = gcsv_chunked_tracker_new (buffer, &chunked_tracker_funcs, tracker);
+
+	g_signal_connect_object (buffer,
+				 "notify::delimiter",
+				 G_CALLBACK (delimiter_notify_cb),
+				 tracker,
+				 0);
+
+	g_signal_connect_object (buffer,
+				 "column-titles-set",
+				 G_CALLBACK (column_titles_set_cb),
+				 tracker,
+				 0);
+
+	g_object_notify (G_OBJECT (tracker), "buffer");
+}
+
+static void
+gcsv_column_stats_tracker_get_property (GObject    *object,
+					guint       prop_id,
+					GValue     *value,
+					GParamSpec *pspec)
+{
+	GcsvColumnStatsTracker *tracker = GCSV_COLUMN_STATS_TRACKER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_value_set_object (value, tracker->buffer);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_column_stats_tracker_set_property (GObject      *object,
+					guint         prop_id,
+					const GValue *value,
+					GParamSpec   *pspec)
+{
+	GcsvColumnStatsTracker *tracker = GCSV_COLUMN_STATS_TRACKER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			set_buffer (tracker, g_value_get_object (value));
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_column_stats_tracker_constructed (GObject *object)
+{
+	G_OBJECT_CLASS (gcsv_column_stats_tracker_parent_class)->constructed (object);
+
+	recompute (GCSV_COLUMN_STATS_TRACKER (object));
+}
+
+static void
+gcsv_column_stats_tracker_dispose (GObject *object)
+{
+	GcsvColumnStatsTracker *tracker = GCSV_COLUMN_STATS_TRACKER (object);
+
+	if (tracker->chunked_tracker != NULL)
+	{
+		gcsv_chunked_tracker_stop (tracker->chunked_tracker);
+		g_clear_object (&tracker->chunked_tracker);
+	}
+
+	if (tracker->merge_idle_id != 0)
+	{
+		g_source_remove (tracker->merge_idle_id);
+		tracker->merge_idle_id = 0;
+	}
+
+	g_clear_object (&tracker->buffer);
+
+	G_OBJECT_CLASS (gcsv_column_stats_tracker_parent_class)->dispose (object);
+}
+
+static void
+gcsv_column_stats_tracker_finalize (GObject *object)
+{
+	GcsvColumnStatsTracker *tracker = GCSV_COLUMN_STATS_TRACKER (object);
+
+	gcsv_column_stats_free (tracker->stats);
+
+	G_OBJECT_CLASS (gcsv_column_stats_tracker_parent_class)->finalize (object);
+}
+
+static void
+gcsv_column_stats_tracker_class_init (GcsvColumnStatsTrackerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_column_stats_tracker_get_property;
+	object_class->set_property = gcsv_column_stats_tracker_set_property;
+	object_class->constructed = gcsv_column_stats_tracker_constructed;
+	object_class->dispose = gcsv_column_stats_tracker_dispose;
+	object_class->finalize = gcsv_column_stats_tracker_finalize;
+
+	g_object_class_install_property (object_class,
+					 PROP_BUFFER,
+					 g_param_spec_object ("buffer",
+							      "Buffer",
+							      "",
+							      GCSV_TYPE_BUFFER,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GcsvColumnStatsTracker::changed:
+	 * @tracker: the #GcsvColumnStatsTracker who emits the signal.
+	 *
+	 * The ::changed signal is emitted when new stats are available, which
+	 * can be partial, see gcsv_column_stats_tracker_is_complete().
+	 */
+	signals[SIGNAL_CHANGED] =
+		g_signal_new ("changed",
+			      G_TYPE_FROM_CLASS (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL, NULL,
+			      G_TYPE_NONE, 0);
+}
+
+static void
+gcsv_column_stats_tracker_init (GcsvColumnStatsTracker *tracker)
+{
+}
+
+GcsvColumnStatsTracker *
+gcsv_column_stats_tracker_new (GcsvBuffer *buffer)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+
+	return g_object_new (GCSV_TYPE_COLUMN_STATS_TRACKER,
+			     "buffer", buffer,
+			     NULL);
+}
+
+void
+gcsv_column_stats_tracker_set_column_num (GcsvColumnStatsTracker *tracker,
+					  guint                   column_num)
+{
+	g_return_if_fail (GCSV_IS_COLUMN_STATS_TRACKER (tracker));
+
+	if (tracker->column_num != column_num)
+	{
+		tracker->column_num = column_num;
+		recompute (tracker);
+	}
+}
+
+guint
+gcsv_column_stats_tracker_get_column_num (GcsvColumnStatsTracker *tracker)
+{
+	g_return_val_if_fail (GCSV_IS_COLUMN_STATS_TRACKER (tracker), 0);
+
+	return tracker->column_num;
+}
+
+/* Returns: (transfer none) (nullable): the stats, or %NULL if there is no
+ * delimiter. The stats of the edited lines can be out of date, see
+ * gcsv_column_stats_tracker_is_complete().
+ */
+const GcsvColumnStats *
+gcsv_column_stats_tracker_get_stats (GcsvColumnStatsTracker *tracker)
+{
+	g_return_val_if_fail (GCSV_IS_COLUMN_STATS_TRACKER (tracker), NULL);
+
+	return tracker->stats;
+}
+
+/* Returns whether the stats are up to date with the buffer content. */
+gboolean
+gcsv_column_stats_tracker_is_complete (GcsvColumnStatsTracker *tracker)
+{
+	g_return_val_if_fail (GCSV_IS_COLUMN_STATS_TRACKER (tracker), FALSE);
+
+	return (tracker->merge_idle_id == 0 &&
+		gcsv_chunked_tracker_is_complete (tracker->chunked_tracker));
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_COLUMN_STATS_TRACKER_H
+#define GCSV_COLUMN_STATS_TRACKER_H
+
+#include <gtk/gtk.h>
+#include "gcsv-buffer.h"
+#include "gcsv-column-stats.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_COLUMN_STATS_TRACKER (gcsv_column_stats_tracker_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvColumnStatsTracker, gcsv_column_stats_tracker,
+		      GCSV, COLUMN_STATS_TRACKER,
+		      GObject)
+
+GcsvColumnStatsTracker *
+		gcsv_column_stats_tracker_new			(GcsvBuffer *buffer);
+
+void		gcsv_column_stats_tracker_set_column_num	(GcsvColumnStatsTracker *tracker,
+								 guint                   column_num);
+
+guint		gcsv_column_stats_tracker_get_column_num	(GcsvColumnStatsTracker *tracker);
+
+const GcsvColumnStats *
+		gcsv_column_stats_tracker_get_stats		(GcsvColumnStatsTracker *tracker);
+
+gboolean	gcsv_column_stats_tracker_is_complete		(GcsvColumnStatsTracker *tracker);
+
+G_END_DECLS
+
+#endif /* GCSV_COLUMN_STATS_TRACKER_H */
@@ -0,0 +1,679 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-column-stats.h"
+#include <math.h>
+#include <string.h>
+
+/* Statistics on the fields of one column, computed in one pass. All the
+ * statistics are mergeable: the stats of several chunks of lines can be
+ * computed separately, in worker threads, and then merged. It permits also to
+ * update the stats of a big file incrementally, by recomputing only the
+ * edited chunks.
+ *
+ * - The mean and the variance of the numbers use Welford's algorithm, merged
+ *   with the formula of Chan et al.
+ * - The number of distinct values is estimated with HyperLogLog.
+ * - The most frequent values are found with the Space-Saving algorithm. The
+ *   counts are exact as long as there are less than TOP_CAPACITY distinct
+ *   values, otherwise they can be overestimated.
+ *
+ * The empty fields, or with only spaces, are counted but are not values. A
+ * line without the column has an empty field.
+ */
+
+/* 2^HLL_PRECISION registers, for a standard error of about 1.6%. */
+#define HLL_PRECISION 12
+#define N_REGISTERS (1 << HLL_PRECISION)
+
+/* Number of Space-Saving counters. More counters than the number of values
+ * shown, for better estimates.
+ */
+#define TOP_CAPACITY 64
+
+typedef struct _Counter Counter;
+struct _Counter
+{
+	gchar *value;
+	guint64 count;
+};
+
+struct _GcsvColumnStats
+{
+	guint64 count;
+	guint64 n_empty;
+
+	guint64 n_numbers;
+	gdouble min;
+	gdouble max;
+	gdouble mean;
+
+	/* Sum of the squares of the differences from the mean. */
+	gdouble m2;
+
+	guint8 registers[N_REGISTERS];
+
+	/* Array of Counter's. The values are owned by the counters, and are
+	 * the keys of counter_indexes, whose values are the indexes + 1.
+	 */
+	GArray *counters;
+	GHashTable *counter_indexes;
+
+	/* To nul-terminate a field without allocation. */
+	GString *scratch;
+};
+
+GcsvColumnStats *
+gcsv_column_stats_new (void)
+{
+	GcsvColumnStats *stats;
+
+	stats = g_new0 (GcsvColumnStats, 1);
+	stats->counters = g_array_sized_new (FALSE, FALSE, sizeof (Counter), TOP_CAPACITY);
+	stats->counter_indexes = g_hash_table_new (g_str_hash, g_str_equal);
+	stats->scratch = g_string_new (NULL);
+
+	return stats;
+}
+
+static void
+rebuild_counter_indexes (GcsvColumnStats *stats)
+{
+	guint i;
+
+	g_hash_table_remove_all (stats->counter_indexes);
+
+	for (i = 0; i < stats->counters->len; i++)
+	{
+		Counter *counter = &g_array_index (stats->counters, Counter, i);
+
+		g_hash_table_insert (stats->counter_indexes,
+				     counter->value,
+				     GUINT_TO_POINTER (i + 1));
+	}
+}
+
+GcsvColumnStats *
+gcsv_column_stats_copy (const GcsvColumnStats *stats)
+{
+	GcsvColumnStats *copy;
+	guint i;
+
+	g_return_val_if_fail (stats != NULL, NULL);
+
+	copy = gcsv_column_stats_new ();
+
+	copy->count = stats->count;
+	copy->n_empty = stats->n_empty;
+	copy->n_numbers = stats->n_numbers;
+	copy->min = stats->min;
+	copy->max = stats->max;
+	copy->mean = stats->mean;
+	copy->m2 = stats->m2;
+	memcpy (copy->registers, stats->registers, sizeof (stats->registers));
+
+	for (i = 0; i < stats->counters->len; i++)
+	{
+		Counter counter = g_array_index (stats->counters, Counter, i);
+
+		counter.value = g_strdup (counter.value);
+		g_array_append_val (copy->counters, counter);
+	}
+
+	rebuild_counter_indexes (copy);
+
+	return copy;
+}
+
+static void
+free_counters (GArray *counters)
+{
+	guint i;
+
+	for (i = 0; i < counters->len; i++)
+	{
+		g_free (g_array_index (counters, Counter, i).value);
+	}
+
+	g_array_unref (counters);
+}
+
+void
+gcsv_column_stats_free (GcsvColumnStats *stats)
+{
+	if (stats != NULL)
+	{
+		g_hash_table_unref (stats->counter_indexes);
+		free_counters (stats->counters);
+		g_string_free (stats->scratch, TRUE);
+		g_free (stats);
+	}
+}
+
+/* FNV-1a, followed by the finalizer of MurmurHash3 to mix all the bits, since
+ * HyperLogLog needs a uniform hash.
+ */
+static guint64
+hash_value (const gchar *value,
+	    gsize        length)
+{
+	guint64 hash = G_GUINT64_CONSTANT (0xcbf29ce484222325);
+	gsize i;
+
+	for (i = 0; i < length; i++)
+	{
+		hash ^= (guint8) value[i];
+		hash *= G_GUINT64_CONSTANT (0x100000001b3);
+	}
+
+	hash ^= hash >> 33;
+	hash *= G_GUINT64_CONSTANT (0xff51afd7ed558ccd);
+	hash ^= hash >> 33;
+	hash *= G_GUINT64_CONSTANT (0xc4ceb9fe1a85ec53);
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+static void
+add_to_registers (GcsvColumnStats *stats,
+		  guint64          hash)
+{
+	const guint n_rest_bits = 64 - HLL_PRECISION;
+	guint index;
+	guint64 rest;
+	guint8 rank = 1;
+
+	index = hash >> n_rest_bits;
+	rest = hash & ((G_GUINT64_CONSTANT (1) << n_rest_bits) - 1);
+
+	/* The position of the first 1 bit in the rest. */
+	while (rank <= n_rest_bits &&
+	       (rest & (G_GUINT64_CONSTANT (1) << (n_rest_bits - 1))) == 0)
+	{
+		rest <<= 1;
+		rank++;
+	}
+
+	stats->registers[index] = MAX (stats->registers[index], rank);
+}
+
+static gboolean
+counters_are_full (const GcsvColumnStats *stats)
+{
+	return stats->counters->len >= TOP_CAPACITY;
+}
+
+static guint
+get_min_counter_index (const GcsvColumnStats *stats)
+{
+	guint min_index = 0;
+	guint i;
+
+	for (i = 1; i < stats->counters->len; i++)
+	{
+		if (g_array_index (stats->counters, Counter, i).count <
+		    g_array_index (stats->counters, Counter, min_index).count)
+		{
+			min_index = i;
+		}
+	}
+
+	return min_index;
+}
+
+static void
+add_to_counters (GcsvColumnStats *stats,
+		 const gchar     *value,
+		 gsize            length)
+{
+	gpointer index_plus_one;
+	Counter *counter;
+
+	g_string_truncate (stats->scratch, 0);
+	g_string_append_len (stats->scratch, value, length);
+
+	index_plus_one = g_hash_table_lookup (stats->counter_indexes, stats->scratch->str);
+
+	if (index_plus_one != NULL)
+	{
+		counter = &g_array_index (stats->counters, Counter, GPOINTER_TO_UINT (index_plus_one) - 1);
+		counter->count++;
+		return;
+	}
+
+	if (!counters_are_full (stats))
+	{
+		Counter new_counter;
+
+		new_counter.value = g_strndup (value, length);
+		new_counter.count = 1;
+		g_array_append_val (stats->counters, new_counter);
+
+		g_hash_table_insert (stats->counter_indexes,
+				     new_counter.value,
+				     GUINT_TO_POINTER (stats->counters->len));
+		return;
+	}
+
+	/* Space-Saving: the new value replaces the least frequent one, and
+	 * inherits its count.
+	 */
+	{
+		guint min_index = get_min_counter_index (stats);
+
+		counter = &g_array_index (stats->counters, Counter, min_index);
+		g_hash_table_remove (stats->counter_indexes, counter->value);
+		g_free (counter->value);
+
+		counter->value = g_strndup (value, length);
+		counter->count++;
+
+		g_hash_table_insert (stats->counter_indexes,
+				     counter->value,
+				     GUINT_TO_POINTER (min_index + 1));
+	}
+}
+
+static void
+add_number (GcsvColumnStats *stats,
+	    gdouble          number)
+{
+	gdouble delta;
+
+	if (stats->n_numbers == 0)
+	{
+		stats->min = number;
+		stats->max = number;
+	}
+	else
+	{
+		stats->min = MIN (stats->min, number);
+		stats->max = MAX (stats->max, number);
+	}
+
+	stats->n_numbers++;
+
+	delta = number - stats->mean;
+	stats->mean += delta / stats->n_numbers;
+	stats->m2 += delta * (number - stats->mean);
+}
+
+void
+gcsv_column_stats_add_field (GcsvColumnStats *stats,
+			     const gchar     *field,
+			     const gchar     *field_end)
+{
+	gdouble number;
+
+	g_return_if_fail (stats != NULL);
+	g_return_if_fail (field <= field_end);
+
+	stats->count++;
+
+	while (field < field_end && g_ascii_isspace (*field))
+	{
+		field++;
+	}
+
+	while (field < field_end && g_ascii_isspace (field_end[-1]))
+	{
+		field_end--;
+	}
+
+	if (field == field_end)
+	{
+		stats->n_empty++;
+		return;
+	}
+
+	if (gcsv_tokenizer_parse_number (field, field_end, &number) && isfinite (number))
+	{
+		add_number (stats, number);
+	}
+
+	add_to_registers (stats, hash_value (field, field_end - field));
+	add_to_counters (stats, field, field_end - field);
+}
+
+/* Adds the field at @column_num of each line of @text. */
+void
+gcsv_column_stats_add_lines (GcsvColumnStats     *stats,
+			     const GcsvTokenizer *tokenizer,
+			     guint                column_num,
+			     const gchar         *text,
+			     const gchar         *text_end)
+{
+	const gchar *line = text;
+
+	g_return_if_fail (stats != NULL);
+	g_return_if_fail (tokenizer != NULL);
+	g_return_if_fail (text <= text_end);
+
+	while (line < text_end)
+	{
+		const gchar *line_end;
+		const gchar *next_line_start;
+		const gchar *field_start;
+		const gchar *field_end;
+
+		line_end = gcsv_tokenizer_find_line_end (line, text_end, &next_line_start);
+
+		if (!gcsv_tokenizer_get_field_bounds (tokenizer, line, line_end, column_num,
+						      &field_start, &field_end))
+		{
+			field_start = field_end = line_end;
+		}
+
+		gcsv_column_stats_add_field (stats, field_start, field_end);
+
+		line = next_line_start;
+	}
+}
+
+static void
+merge_numbers (GcsvColumnStats       *stats,
+	       const GcsvColumnStats *other)
+{
+	guint64 n_numbers;
+	gdouble delta;
+
+	if (other->n_numbers == 0)
+	{
+		return;
+	}
+
+	if (stats->n_numbers == 0)
+	{
+		stats->n_numbers = other->n_numbers;
+		stats->min = other->min;
+		stats->max = other->max;
+		stats->mean = other->mean;
+		stats->m2 = other->m2;
+		return;
+	}
+
+	n_numbers = stats->n_numbers + other->n_numbers;
+	delta = other->mean - stats->mean;
+
+	stats->mean += delta * other->n_numbers / n_numbers;
+	stats->m2 += other->m2 + delta * delta * stats->n_numbers * other->n_numbers / n_numbers;
+	stats->min = MIN (stats->min, other->min);
+	stats->max = MAX (stats->max, other->max);
+	stats->n_numbers = n_numbers;
+}
+
+static gint
+compare_counters (gconstpointer a,
+		  gconstpointer b)
+{
+	const Counter *counter_a = a;
+	const Counter *counter_b = b;
+
+	if (counter_a->count != counter_b->count)
+	{
+		return counter_a->count > counter_b->count ? -1 : 1;
+	}
+
+	return strcmp (counter_a->value, counter_b->value);
+}
+
+static guint64
+lookup_count (const GcsvColumnStats *stats,
+	      const gchar           *value,
+	      guint64                default_count)
+{
+	gpointer index_plus_one;
+
+	index_plus_one = g_hash_table_lookup (stats->counter_indexes, value);
+	if (index_plus_one == NULL)
+	{
+		return default_count;
+	}
+
+	return g_array_index (stats->counters, Counter, GPOINTER_TO_UINT (index_plus_one) - 1).count;
+}
+
+/* A value missing from a full summary can have been counted at most as many
+ * times as its least frequent value, so that count is added, like Space-Saving
+ * does.
+ */
+static void
+merge_counters (GcsvColumnStats       *stats,
+		const GcsvColumnStats *other)
+{
+	guint64 stats_min = 0;
+	guint64 other_min = 0;
+	GArray *merged;
+	guint i;
+
+	if (counters_are_full (stats))
+	{
+		stats_min = g_array_index (stats->counters, Counter, get_min_counter_index (stats)).count;
+	}
+
+	if (counters_are_full (other))
+	{
+		other_min = g_array_index (other->counters, Counter, get_min_counter_index (other)).count;
+	}
+
+	merged = g_array_sized_new (FALSE, FALSE, sizeof (Counter),
+				    stats->counters->len + other->counters->len);
+
+	for (i = 0; i < stats->counters->len; i++)
+	{
+		Counter counter = g_array_index (stats->counters, Counter, i);
+
+		counter.count += lookup_count (other, counter.value, other_min);
+		g_array_append_val (merged, counter);
+	}
+
+	for (i = 0; i < other->counters->len; i++)
+	{
+		Counter counter = g_array_index (other->counters, Counter, i);
+
+		if (!g_hash_table_contains (stats->counter_indexes, counter.value))
+		{
+			counter.value = g_strdup (counter.value);
+			counter.count += stats_min;
+			g_array_append_val (merged, counter);
+		}
+	}
+
+	g_array_sort (merged, compare_counters);
+
+	for (i = TOP_CAPACITY; i < merged->len; i++)
+	{
+		g_free (g_array_index (merged, Counter, i).value);
+	}
+
+	if (merged->len > TOP_CAPACITY)
+	{
+		g_array_set_size (merged, TOP_CAPACITY);
+	}
+
+	/* The values have been moved to merged. */
+	g_array_unref (stats->counters);
+	stats->counters = merged;
+	rebuild_counter_indexes (stats);
+}
+
+void
+gcsv_column_stats_merge (GcsvColumnStats       *stats,
+			 const GcsvColumnStats *other)
+{
+	guint i;
+
+	g_return_if_fail (stats != NULL);
+	g_return_if_fail (other != NULL);
+
+	stats->count += other->count;
+	stats->n_empty += other->n_empty;
+
+	merge_numbers (stats, other);
+
+	for (i = 0; i < N_REGISTERS; i++)
+	{
+		stats->registers[i] = MAX (stats->registers[i], other->registers[i]);
+	}
+
+	merge_counters (stats, other);
+}
+
+/* Number of lines. */
+guint64
+gcsv_column_stats_get_count (const GcsvColumnStats *stats)
+{
+	g_return_val_if_fail (stats != NULL, 0);
+
+	return stats->count;
+}
+
+guint64
+gcsv_column_stats_get_n_empty (const GcsvColumnStats *stats)
+{
+	g_return_val_if_fail (stats != NULL, 0);
+
+	return stats->n_empty;
+}
+
+guint64
+gcsv_column_stats_get_n_numbers (const GcsvColumnStats *stats)
+{
+	g_return_val_if_fail (stats != NULL, 0);
+
+	return stats->n_numbers;
+}
+
+/* The numeric getters return 0 if there is no number. */
+gdouble
+gcsv_column_stats_get_min (const GcsvColumnStats *stats)
+{
+	g_return_val_if_fail (stats != NULL, 0.0);
+
+	return stats->min;
+}
+
+gdouble
+gcsv_column_stats_get_max (const GcsvColumnStats *stats)
+{
+	g_return_val_if_fail (stats != NULL, 0.0);
+
+	return stats->max;
+}
+
+gdouble
+gcsv_column_stats_get_mean (const GcsvColumnStats *stats)
+{
+	g_return_val_if_fail (stats != NULL, 0.0);
+
+	return stats->mean;
+}
+
+/* The sample standard deviation. */
+gdouble
+gcsv_column_stats_get_stddev (const GcsvColumnStats *stats)
+{
+	g_return_val_if_fail (stats != NULL, 0.0);
+
+	if (stats->n_numbers < 2)
+	{
+		return 0.0;
+	}
+
+	return sqrt (stats->m2 / (stats->n_numbers - 1));
+}
+
+/* An estimate of the number of distinct non-empty values. */
+guint64
+gcsv_column_stats_get_n_distinct (const GcsvColumnStats *stats)
+{
+	const gdouble m = N_REGISTERS;
+	gdouble alpha;
+	gdouble sum = 0.0;
+	gdouble estimate;
+	guint n_zeros = 0;
+	guint i;
+
+	g_return_val_if_fail (stats != NULL, 0);
+
+	for (i = 0; i < N_REGISTERS; i++)
+	{
+		sum += ldexp (1.0, -stats->registers[i]);
+
+		if (stats->registers[i] == 0)
+		{
+			n_zeros++;
+		}
+	}
+
+	alpha = 0.7213 / (1.0 + 1.079 / m);
+	estimate = alpha * m * m / sum;
+
+	/* Small range correction: linear counting. */
+	if (estimate <= 2.5 * m && n_zeros > 0)
+	{
+		estimate = m * log (m / n_zeros);
+	}
+
+	return (guint64) (estimate + 0.5);
+}
+
+static void
+value_count_free (gpointer data)
+{
+	GcsvValueCount *value_count = data;
+
+	g_free (value_count->value);
+	g_free (value_count);
+}
+
+/* Returns: (transfer full) (element-type GcsvValueCount): the most frequent
+ * values, the most frequent first.
+ */
+GPtrArray *
+gcsv_column_stats_get_top_values (const GcsvColumnStats *stats,
+				  guint                  max_n_values)
+{
+	GArray *sorted;
+	GPtrArray *top_values;
+	guint i;
+
+	g_return_val_if_fail (stats != NULL, NULL);
+
+	sorted = g_array_sized_new (FALSE, FALSE, sizeof (Counter), stats->counters->len);
+	g_array_append_vals (sorted, stats->counters->data, stats->counters->len);
+	g_array_sort (sorted, compare_counters);
+
+	top_values = g_ptr_array_new_with_free_func (value_count_free);
+
+	for (i = 0; i < sorted->len && i < max_n_values; i++)
+	{
+		Counter *counter = &g_array_index (sorted, Counter, i);
+		GcsvValueCount *value_count;
+
+		value_count = g_new (GcsvValueCount, 1);
+		value_count->value = g_strdup (counter->value);
+		value_count->count = counter->count;
+		g_ptr_array_add (top_values, value_count);
+	}
+
+	g_array_unref (sorted);
+	return top_values;
+}
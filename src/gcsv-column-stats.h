@@ -0,0 +1,78 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_COLUMN_STATS_H
+#define GCSV_COLUMN_STATS_H
+
+#include <glib.h>
+#include "gcsv-tokenizer.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GcsvColumnStats GcsvColumnStats;
+
+typedef struct _GcsvValueCount GcsvValueCount;
+
+struct _GcsvValueCount
+{
+	gchar *value;
+	guint64 count;
+};
+
+GcsvColumnStats *	gcsv_column_stats_new			(void);
+
+GcsvColumnStats *	gcsv_column_stats_copy			(const GcsvColumnStats *stats);
+
+void			gcsv_column_stats_free			(GcsvColumnStats *stats);
+
+void			gcsv_column_stats_add_field		(GcsvColumnStats *stats,
+								 const gchar     *field,
+								 const gchar     *field_end);
+
+void			gcsv_column_stats_add_lines		(GcsvColumnStats     *stats,
+								 const GcsvTokenizer *tokenizer,
+								 guint                column_num,
+								 const gchar         *text,
+								 const gchar         *text_end);
+
+void			gcsv_column_stats_merge			(GcsvColumnStats       *stats,
+								 const GcsvColumnStats *other);
+
+guint64			gcsv_column_stats_get_count		(const GcsvColumnStats *stats);
+
+guint64			gcsv_column_stats_get_n_empty		(const GcsvColumnStats *stats);
+
+guint64			gcsv_column_stats_get_n_numbers		(const GcsvColumnStats *stats);
+
+gdouble			gcsv_column_stats_get_min		(const GcsvColumnStats *stats);
+
+gdouble			gcsv_column_stats_get_max		(const GcsvColumnStats *stats);
+
+gdouble			gcsv_column_stats_get_mean		(const GcsvColumnStats *stats);
+
+gdouble			gcsv_column_stats_get_stddev		(const GcsvColumnStats *stats);
+
+guint64			gcsv_column_stats_get_n_distinct	(const GcsvColumnStats *stats);
+
+GPtrArray *		gcsv_column_stats_get_top_values	(const GcsvColumnStats *stats,
+								 guint                  max_n_values);
+
+G_END_DECLS
+
+#endif /* GCSV_COLUMN_STATS_H */
@@ -0,0 +1,187 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-column-widths.h"
+
+/* Accumulates the column lengths, with the same rules as GcsvAlignment: a
+ * column length is the maximum number of characters of the fields in that
+ * column, the last field of a line included.
+ *
+ * Accumulators can be filled independently, for example one per worker
+ * thread, and merged afterwards.
+ */
+
+struct _GcsvColumnWidths
+{
+	/* Contains the column lengths as gint's. */
+	GArray *lengths;
+};
+
+GcsvColumnWidths *
+gcsv_column_widths_new (void)
+{
+	GcsvColumnWidths *widths;
+
+	widths = g_new0 (GcsvColumnWidths, 1);
+	widths->lengths = g_array_new (FALSE, FALSE, sizeof (gint));
+
+	return widths;
+}
+
+GcsvColumnWidths *
+gcsv_column_widths_copy (const GcsvColumnWidths *widths)
+{
+	GcsvColumnWidths *copy;
+
+	g_return_val_if_fail (widths != NULL, NULL);
+
+	copy = gcsv_column_widths_new ();
+	g_array_append_vals (copy->lengths, widths->lengths->data, widths->lengths->len);
+
+	return copy;
+}
+
+void
+gcsv_column_widths_free (GcsvColumnWidths *widths)
+{
+	if (widths != NULL)
+	{
+		g_array_unref (widths->lengths);
+		g_free (widths);
+	}
+}
+
+void
+gcsv_column_widths_clear (GcsvColumnWidths *widths)
+{
+	g_return_if_fail (widths != NULL);
+
+	g_array_set_size (widths->lengths, 0);
+}
+
+guint
+gcsv_column_widths_get_n_columns (const GcsvColumnWidths *widths)
+{
+	g_return_val_if_fail (widths != NULL, 0);
+
+	return widths->lengths->len;
+}
+
+/* Returns: the column length, or -1 if no field has been seen in that
+ * column.
+ */
+gint
+gcsv_column_widths_get (const GcsvColumnWidths *widths,
+			guint                   column_num)
+{
+	g_return_val_if_fail (widths != NULL, -1);
+
+	if (column_num >= widths->lengths->len)
+	{
+		return -1;
+	}
+
+	return g_array_index (widths->lengths, gint, column_num);
+}
+
+void
+gcsv_column_widths_update (GcsvColumnWidths *widths,
+			   guint             column_num,
+			   gint              field_length)
+{
+	g_return_if_fail (widths != NULL);
+
+	if (column_num >= widths->lengths->len)
+	{
+		gint unknown = -1;
+
+		while (widths->lengths->len < column_num)
+		{
+			g_array_append_val (widths->lengths, unknown);
+		}
+
+		g_array_append_val (widths->lengths, field_length);
+	}
+	else if (field_length > g_array_index (widths->lengths, gint, column_num))
+	{
+		g_array_index (widths->lengths, gint, column_num) = field_length;
+	}
+}
+
+/* @line doesn't contain the line terminator. */
+void
+gcsv_column_widths_add_line (GcsvColumnWidths    *widths,
+			     const GcsvTokenizer *tokenizer,
+			     const gchar         *line,
+			     const gchar         *line_end)
+{
+	const gchar *field_start = line;
+	gsize delimiter_len;
+	guint column_num = 0;
+
+	g_return_if_fail (widths != NULL);
+	g_return_if_fail (tokenizer != NULL);
+
+	if (gcsv_tokenizer_get_delimiter (tokenizer) == '\0')
+	{
+		return;
+	}
+
+	delimiter_len = gcsv_tokenizer_get_delimiter_length (tokenizer);
+
+	while (TRUE)
+	{
+		const gchar *field_end;
+
+		field_end = gcsv_tokenizer_find_delimiter (tokenizer, field_start, line_end);
+		if (field_end == NULL)
+		{
+			field_end = line_end;
+		}
+
+		gcsv_column_widths_update (widths,
+					   column_num,
+					   g_utf8_strlen (field_start, field_end - field_start));
+
+		if (field_end == line_end)
+		{
+			break;
+		}
+
+		field_start = field_end + delimiter_len;
+		column_num++;
+	}
+}
+
+void
+gcsv_column_widths_merge (GcsvColumnWidths       *widths,
+			  const GcsvColumnWidths *other)
+{
+	guint column_num;
+
+	g_return_if_fail (widths != NULL);
+	g_return_if_fail (other != NULL);
+
+	for (column_num = 0; column_num < other->lengths->len; column_num++)
+	{
+		gcsv_column_widths_update (widths,
+					   column_num,
+					   g_array_index (other->lengths, gint, column_num));
+	}
+}
@@ -0,0 +1,57 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_COLUMN_WIDTHS_H
+#define GCSV_COLUMN_WIDTHS_H
+
+#include <glib.h>
+#include "gcsv-tokenizer.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GcsvColumnWidths GcsvColumnWidths;
+
+GcsvColumnWidths *	gcsv_column_widths_new			(void);
+
+GcsvColumnWidths *	gcsv_column_widths_copy			(const GcsvColumnWidths *widths);
+
+void			gcsv_column_widths_free			(GcsvColumnWidths *widths);
+
+void			gcsv_column_widths_clear		(GcsvColumnWidths *widths);
+
+guint			gcsv_column_widths_get_n_columns	(const GcsvColumnWidths *widths);
+
+gint			gcsv_column_widths_get			(const GcsvColumnWidths *widths,
+								 guint                   column_num);
+
+void			gcsv_column_widths_update		(GcsvColumnWidths *widths,
+								 guint             column_num,
+								 gint              field_length);
+
+void			gcsv_column_widths_add_line		(GcsvColumnWidths    *widths,
+								 const GcsvTokenizer *tokenizer,
+								 const gchar         *line,
+								 const gchar         *line_end);
+
+void			gcsv_column_widths_merge		(GcsvColumnWidths       *widths,
+								 const GcsvColumnWidths *other);
+
+G_END_DECLS
+
+#endif /* GCSV_COLUMN_WIDTHS_H */
@@ -0,0 +1,733 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "gcsv-compression.h"
+#include <glib/gi18n.h>
+#include <string.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+
+/* Compressed files are read and written as streams, with a GConverter: the
+ * GZlibCompressor and GZlibDecompressor of GIO for gzip, and GcsvCodecConverter
+ * below for zstd and xz. So no temporary file is needed, and the compressed
+ * data is never entirely in memory.
+ *
+ * The functions doing I/O are blocking, they are meant to be called in a
+ * worker thread.
+ */
+
+/* The length of the longest magic number below. */
+#define MAGIC_MAX_LENGTH 6
+
+static const guint8 gzip_magic[] = { 0x1f, 0x8b };
+static const guint8 zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+static const guint8 xz_magic[] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+
+static gboolean
+has_magic (const guint8 *data,
+	   gsize         length,
+	   const guint8 *magic,
+	   gsize         magic_length)
+{
+	return length >= magic_length && memcmp (data, magic, magic_length) == 0;
+}
+
+/* Returns: the compression format of the data starting with @data, from its
+ * magic number.
+ */
+GcsvCompression
+gcsv_compression_detect (const guint8 *data,
+			 gsize         length)
+{
+	g_return_val_if_fail (data != NULL || length == 0, GCSV_COMPRESSION_NONE);
+
+	if (has_magic (data, length, gzip_magic, sizeof (gzip_magic)))
+	{
+		return GCSV_COMPRESSION_GZIP;
+	}
+
+	if (has_magic (data, length, zstd_magic, sizeof (zstd_magic)))
+	{
+		return GCSV_COMPRESSION_ZSTD;
+	}
+
+	if (has_magic (data, length, xz_magic, sizeof (xz_magic)))
+	{
+		return GCSV_COMPRESSION_XZ;
+	}
+
+	return GCSV_COMPRESSION_NONE;
+}
+
+/* Returns: the compression format for a new file, from its extension. */
+GcsvCompression
+gcsv_compression_from_filename (const gchar *filename)
+{
+	g_return_val_if_fail (filename != NULL, GCSV_COMPRESSION_NONE);
+
+	if (g_str_has_suffix (filename, ".gz"))
+	{
+		return GCSV_COMPRESSION_GZIP;
+	}
+
+	if (g_str_has_suffix (filename, ".zst"))
+	{
+		return GCSV_COMPRESSION_ZSTD;
+	}
+
+	if (g_str_has_suffix (filename, ".xz"))
+	{
+		return GCSV_COMPRESSION_XZ;
+	}
+
+	return GCSV_COMPRESSION_NONE;
+}
+
+gboolean
+gcsv_compression_is_supported (GcsvCompression compression)
+{
+	switch (compression)
+	{
+		case GCSV_COMPRESSION_NONE:
+		case GCSV_COMPRESSION_GZIP:
+			return TRUE;
+
+		case GCSV_COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+			return TRUE;
+#else
+			return FALSE;
+#endif
+
+		case GCSV_COMPRESSION_XZ:
+#ifdef HAVE_LZMA
+			return TRUE;
+#else
+			return FALSE;
+#endif
+
+		default:
+			g_return_val_if_reached (FALSE);
+	}
+}
+
+#if defined (HAVE_ZSTD) || defined (HAVE_LZMA)
+
+#define GCSV_TYPE_CODEC_CONVERTER (gcsv_codec_converter_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvCodecConverter, gcsv_codec_converter,
+		      GCSV, CODEC_CONVERTER,
+		      GObject)
+
+/* A GConverter for the compression libraries without GIO support. */
+struct _GcsvCodecConverter
+{
+	GObject parent;
+
+	GcsvCompression compression;
+	guint compress : 1;
+
+#ifdef HAVE_ZSTD
+	ZSTD_CCtx *zstd_cctx;
+	ZSTD_DCtx *zstd_dctx;
+#endif
+
+#ifdef HAVE_LZMA
+	lzma_stream lzma;
+	guint lzma_initialized : 1;
+#endif
+};
+
+static void gcsv_codec_converter_iface_init (GConverterIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (GcsvCodecConverter, gcsv_codec_converter, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_CONVERTER,
+						gcsv_codec_converter_iface_init))
+
+static void
+set_codec_error (GError      **error,
+		 const gchar  *message)
+{
+	g_set_error (error,
+		     G_IO_ERROR,
+		     G_IO_ERROR_INVALID_DATA,
+		     _("Compression error: %s"),
+		     message);
+}
+
+/* When nothing has been read nor written, tells GConverter what is missing. */
+static GConverterResult
+no_progress (gsize            inbuf_size,
+	     GConverterFlags  flags,
+	     GError         **error)
+{
+	if (inbuf_size > 0)
+	{
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE,
+				     "Need more output space");
+	}
+	else if (flags & G_CONVERTER_INPUT_AT_END)
+	{
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+				     _("Unexpected end of the compressed data."));
+	}
+	else
+	{
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+				     "Need more input");
+	}
+
+	return G_CONVERTER_ERROR;
+}
+
+#ifdef HAVE_ZSTD
+static GConverterResult
+zstd_convert (GcsvCodecConverter  *converter,
+	      const void          *inbuf,
+	      gsize                inbuf_size,
+	      void                *outbuf,
+	      gsize                outbuf_size,
+	      GConverterFlags      flags,
+	      gsize               *bytes_read,
+	      gsize               *bytes_written,
+	      GError             **error)
+{
+	ZSTD_inBuffer input = { inbuf, inbuf_size, 0 };
+	ZSTD_outBuffer output = { outbuf, outbuf_size, 0 };
+	gsize ret;
+
+	if (converter->compress)
+	{
+		ZSTD_EndDirective directive = ZSTD_e_continue;
+
+		if (flags & G_CONVERTER_INPUT_AT_END)
+		{
+			directive = ZSTD_e_end;
+		}
+		else if (flags & G_CONVERTER_FLUSH)
+		{
+			directive = ZSTD_e_flush;
+		}
+
+		ret = ZSTD_compressStream2 (converter->zstd_cctx, &output, &input, directive);
+		if (ZSTD_isError (ret))
+		{
+			set_codec_error (error, ZSTD_getErrorName (ret));
+			return G_CONVERTER_ERROR;
+		}
+
+		*bytes_read = input.pos;
+		*bytes_written = output.pos;
+
+		/* ret is the number of bytes still to flush. */
+		if (ret == 0 && input.pos == inbuf_size)
+		{
+			if (directive == ZSTD_e_end)
+			{
+				return G_CONVERTER_FINISHED;
+			}
+
+			if (directive == ZSTD_e_flush)
+			{
+				return G_CONVERTER_FLUSHED;
+			}
+		}
+	}
+	else
+	{
+		ret = ZSTD_decompressStream (converter->zstd_dctx, &output, &input);
+		if (ZSTD_isError (ret))
+		{
+			set_codec_error (error, ZSTD_getErrorName (ret));
+			return G_CONVERTER_ERROR;
+		}
+
+		*bytes_read = input.pos;
+		*bytes_written = output.pos;
+
+		/* ret is 0 at the end of a frame. A file can contain several
+		 * frames.
+		 */
+		if (ret == 0 &&
+		    input.pos == inbuf_size &&
+		    (flags & G_CONVERTER_INPUT_AT_END))
+		{
+			return G_CONVERTER_FINISHED;
+		}
+	}
+
+	if (input.pos == 0 && output.pos == 0)
+	{
+		return no_progress (inbuf_size, flags, error);
+	}
+
+	return G_CONVERTER_CONVERTED;
+}
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZMA
+static gboolean
+lzma_init (GcsvCodecConverter  *converter,
+	   GError             **error)
+{
+	lzma_stream init = LZMA_STREAM_INIT;
+	lzma_ret ret;
+
+	converter->lzma = init;
+
+	if (converter->compress)
+	{
+		ret = lzma_easy_encoder (&converter->lzma, LZMA_PRESET_DEFAULT, LZMA_CHECK_CRC64);
+	}
+	else
+	{
+		ret = lzma_stream_decoder (&converter->lzma, UINT64_MAX, LZMA_CONCATENATED);
+	}
+
+	if (ret != LZMA_OK)
+	{
+		set_codec_error (error, _("Failed to initialize liblzma."));
+		return FALSE;
+	}
+
+	converter->lzma_initialized = TRUE;
+	return TRUE;
+}
+
+static GConverterResult
+lzma_convert (GcsvCodecConverter  *converter,
+	      const void          *inbuf,
+	      gsize                inbuf_size,
+	      void                *outbuf,
+	      gsize                outbuf_size,
+	      GConverterFlags      flags,
+	      gsize               *bytes_read,
+	      gsize               *bytes_written,
+	      GError             **error)
+{
+	lzma_action action = LZMA_RUN;
+	lzma_ret ret;
+
+	if (flags & G_CONVERTER_INPUT_AT_END)
+	{
+		action = LZMA_FINISH;
+	}
+	else if ((flags & G_CONVERTER_FLUSH) && converter->compress)
+	{
+		action = LZMA_SYNC_FLUSH;
+	}
+
+	converter->lzma.next_in = inbuf;
+	converter->lzma.avail_in = inbuf_size;
+	converter->lzma.next_out = outbuf;
+	converter->lzma.avail_out = outbuf_size;
+
+	ret = lzma_code (&converter->lzma, action);
+
+	*bytes_read = inbuf_size - converter->lzma.avail_in;
+	*bytes_written = outbuf_size - converter->lzma.avail_out;
+
+	switch (ret)
+	{
+		case LZMA_STREAM_END:
+			if (action == LZMA_SYNC_FLUSH)
+			{
+				return G_CONVERTER_FLUSHED;
+			}
+			return G_CONVERTER_FINISHED;
+
+		case LZMA_OK:
+		case LZMA_BUF_ERROR:
+			if (*bytes_read == 0 && *bytes_written == 0)
+			{
+				return no_progress (inbuf_size, flags, error);
+			}
+			return G_CONVERTER_CONVERTED;
+
+		case LZMA_MEM_ERROR:
+			set_codec_error (error, _("Not enough memory."));
+			return G_CONVERTER_ERROR;
+
+		default:
+			set_codec_error (error, _("The data is corrupt or in an unsupported format."));
+			return G_CONVERTER_ERROR;
+	}
+}
+#endif /* HAVE_LZMA */
+
+static GConverterResult
+gcsv_codec_converter_convert (GConverter       *converter,
+			      const void       *inbuf,
+			      gsize             inbuf_size,
+			      void             *outbuf,
+			      gsize             outbuf_size,
+			      GConverterFlags   flags,
+			      gsize            *bytes_read,
+			      gsize            *bytes_written,
+			      GError          **error)
+{
+	GcsvCodecConverter *codec_converter = GCSV_CODEC_CONVERTER (converter);
+
+	switch (codec_converter->compression)
+	{
+#ifdef HAVE_ZSTD
+		case GCSV_COMPRESSION_ZSTD:
+			return zstd_convert (codec_converter,
+					     inbuf, inbuf_size,
+					     outbuf, outbuf_size,
+					     flags,
+					     bytes_read, bytes_written,
+					     error);
+#endif
+
+#ifdef HAVE_LZMA
+		case GCSV_COMPRESSION_XZ:
+			return lzma_convert (codec_converter,
+					     inbuf, inbuf_size,
+					     outbuf, outbuf_size,
+					     flags,
+					     bytes_read, bytes_written,
+					     error);
+#endif
+
+		default:
+			g_return_val_if_reached (G_CONVERTER_ERROR);
+	}
+}
+
+static void
+gcsv_codec_converter_reset (GConverter *converter)
+{
+	GcsvCodecConverter *codec_converter = GCSV_CODEC_CONVERTER (converter);
+
+#ifdef HAVE_ZSTD
+	if (codec_converter->zstd_cctx != NULL)
+	{
+		ZSTD_CCtx_reset (codec_converter->zstd_cctx, ZSTD_reset_session_only);
+	}
+
+	if (codec_converter->zstd_dctx != NULL)
+	{
+		ZSTD_DCtx_reset (codec_converter->zstd_dctx, ZSTD_reset_session_only);
+	}
+#endif
+
+#ifdef HAVE_LZMA
+	if (codec_converter->lzma_initialized)
+	{
+		lzma_end (&codec_converter->lzma);
+		codec_converter->lzma_initialized = FALSE;
+		lzma_init (codec_converter, NULL);
+	}
+#endif
+}
+
+static void
+gcsv_codec_converter_finalize (GObject *object)
+{
+	GcsvCodecConverter *converter = GCSV_CODEC_CONVERTER (object);
+
+#ifdef HAVE_ZSTD
+	ZSTD_freeCCtx (converter->zstd_cctx);
+	ZSTD_freeDCtx (converter->zstd_dctx);
+#endif
+
+#ifdef HAVE_LZMA
+	if (converter->lzma_initialized)
+	{
+		lzma_end (&converter->lzma);
+	}
+#endif
+
+	G_OBJECT_CLASS (gcsv_codec_converter_parent_class)->finalize (object);
+}
+
+static void
+gcsv_codec_converter_class_init (GcsvCodecConverterClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = gcsv_codec_converter_finalize;
+}
+
+static void
+gcsv_codec_converter_iface_init (GConverterIface *iface)
+{
+	iface->convert = gcsv_codec_converter_convert;
+	iface->reset = gcsv_codec_converter_reset;
+}
+
+static void
+gcsv_codec_converter_init (GcsvCodecConverter *converter)
+{
+}
+
+static GConverter *
+codec_converter_new (GcsvCompression   compression,
+		     gboolean          compress,
+		     GError          **error)
+{
+	GcsvCodecConverter *converter;
+
+	converter = g_object_new (GCSV_TYPE_CODEC_CONVERTER, NULL);
+	converter->compression = compression;
+	converter->compress = compress != FALSE;
+
+#ifdef HAVE_ZSTD
+	if (compression == GCSV_COMPRESSION_ZSTD)
+	{
+		if (compress)
+		{
+			converter->zstd_cctx = ZSTD_createCCtx ();
+		}
+		else
+		{
+			converter->zstd_dctx = ZSTD_createDCtx ();
+		}
+	}
+#endif
+
+#ifdef HAVE_LZMA
+	if (compression == GCSV_COMPRESSION_XZ &&
+	    !lzma_init (converter, error))
+	{
+		g_object_unref (converter);
+		return NULL;
+	}
+#endif
+
+	return G_CONVERTER (converter);
+}
+
+#endif /* HAVE_ZSTD || HAVE_LZMA */
+
+/* Returns: (transfer full) (nullable): a new converter to compress or
+ * decompress data in the @compression format, or %NULL if the format is not
+ * supported by this build.
+ */
+GConverter *
+gcsv_compression_create_converter (GcsvCompression   compression,
+				   gboolean          compress,
+				   GError          **error)
+{
+	g_return_val_if_fail (compression != GCSV_COMPRESSION_NONE, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (!gcsv_compression_is_supported (compression))
+	{
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     _("The %s compression format is not supported by this build."),
+			     compression == GCSV_COMPRESSION_ZSTD ? "zstd" : "xz");
+		return NULL;
+	}
+
+	if (compression == GCSV_COMPRESSION_GZIP)
+	{
+		if (compress)
+		{
+			return G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1));
+		}
+
+		return G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+	}
+
+#if defined (HAVE_ZSTD) || defined (HAVE_LZMA)
+	return codec_converter_new (compression, compress, error);
+#else
+	g_return_val_if_reached (NULL);
+#endif
+}
+
+/* Opens @location for reading, decompressing it if needed. @compression is set
+ * to the detected compression format.
+ *
+ * Returns: (transfer full) (nullable): the stream of the uncompressed content.
+ */
+GInputStream *
+gcsv_compression_open_file (GFile            *location,
+			    GcsvCompression  *compression,
+			    GCancellable     *cancellable,
+			    GError          **error)
+{
+	GFileInputStream *file_stream;
+	GBufferedInputStream *buffered_stream;
+	const guint8 *header;
+	gsize header_length;
+	GcsvCompression detected;
+	GConverter *converter;
+	GInputStream *converter_stream;
+
+	g_return_val_if_fail (G_IS_FILE (location), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	file_stream = g_file_read (location, cancellable, error);
+	if (file_stream == NULL)
+	{
+		return NULL;
+	}
+
+	buffered_stream = G_BUFFERED_INPUT_STREAM (g_buffered_input_stream_new (G_INPUT_STREAM (file_stream)));
+	g_object_unref (file_stream);
+
+	/* A read can return less bytes than requested. */
+	while (g_buffered_input_stream_get_available (buffered_stream) < MAGIC_MAX_LENGTH)
+	{
+		gssize n_bytes;
+
+		n_bytes = g_buffered_input_stream_fill (buffered_stream,
+							MAGIC_MAX_LENGTH - g_buffered_input_stream_get_available (buffered_stream),
+							cancellable,
+							error);
+
+		if (n_bytes < 0)
+		{
+			g_object_unref (buffered_stream);
+			return NULL;
+		}
+
+		if (n_bytes == 0)
+		{
+			break;
+		}
+	}
+
+	header = g_buffered_input_stream_peek_buffer (buffered_stream, &header_length);
+	detected = gcsv_compression_detect (header, header_length);
+
+	if (compression != NULL)
+	{
+		*compression = detected;
+	}
+
+	if (detected == GCSV_COMPRESSION_NONE)
+	{
+		return G_INPUT_STREAM (buffered_stream);
+	}
+
+	converter = gcsv_compression_create_converter (detected, FALSE, error);
+	if (converter == NULL)
+	{
+		g_object_unref (buffered_stream);
+		return NULL;
+	}
+
+	converter_stream = g_converter_input_stream_new (G_INPUT_STREAM (buffered_stream), converter);
+	g_object_unref (buffered_stream);
+	g_object_unref (converter);
+
+	return converter_stream;
+}
+
+/* Writes @contents to @location, compressed in the @compression format. The
+ * file is replaced only if everything has been written successfully.
+ *
+ * If @etag is not NULL and the file has another entity tag, i.e. it has been
+ * modified by another program, the save fails with G_IO_ERROR_WRONG_ETAG. On
+ * success, @new_etag is set to the entity tag of the written file.
+ */
+gboolean
+gcsv_compression_save_file (GFile            *location,
+			    GcsvCompression   compression,
+			    GBytes           *contents,
+			    const gchar      *etag,
+			    gchar           **new_etag,
+			    GCancellable     *cancellable,
+			    GError          **error)
+{
+	GFileOutputStream *file_stream;
+	GOutputStream *stream;
+	const gchar *data;
+	gsize length;
+	gboolean ok;
+
+	g_return_val_if_fail (G_IS_FILE (location), FALSE);
+	g_return_val_if_fail (contents != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	file_stream = g_file_replace (location, etag, FALSE, G_FILE_CREATE_NONE, cancellable, error);
+	if (file_stream == NULL)
+	{
+		return FALSE;
+	}
+
+	if (compression == GCSV_COMPRESSION_NONE)
+	{
+		stream = G_OUTPUT_STREAM (g_object_ref (file_stream));
+	}
+	else
+	{
+		GConverter *converter;
+
+		converter = gcsv_compression_create_converter (compression, TRUE, error);
+		if (converter == NULL)
+		{
+			ok = FALSE;
+			goto out;
+		}
+
+		stream = g_converter_output_stream_new (G_OUTPUT_STREAM (file_stream), converter);
+		g_object_unref (converter);
+
+		/* The file stream is closed below, only if everything has been
+		 * written. Otherwise closing @stream, explicitly or when it is
+		 * finalized, would replace the original file.
+		 */
+		g_filter_output_stream_set_close_base_stream (G_FILTER_OUTPUT_STREAM (stream), FALSE);
+	}
+
+	data = g_bytes_get_data (contents, &length);
+
+	ok = (g_output_stream_write_all (stream, data, length, NULL, cancellable, error) &&
+	      g_output_stream_close (stream, cancellable, error) &&
+	      g_output_stream_close (G_OUTPUT_STREAM (file_stream), cancellable, error));
+
+	if (ok && new_etag != NULL)
+	{
+		*new_etag = g_file_output_stream_get_etag (file_stream);
+	}
+
+	g_object_unref (stream);
+
+out:
+	if (!ok)
+	{
+		GCancellable *abort_cancellable;
+
+		/* Closing with a cancelled GCancellable keeps the original
+		 * file, instead of replacing it with the partial content.
+		 */
+		abort_cancellable = g_cancellable_new ();
+		g_cancellable_cancel (abort_cancellable);
+		g_output_stream_close (G_OUTPUT_STREAM (file_stream), abort_cancellable, NULL);
+		g_object_unref (abort_cancellable);
+	}
+
+	g_object_unref (file_stream);
+	return ok;
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_COMPRESSION_H
+#define GCSV_COMPRESSION_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GcsvCompression:
+ * @GCSV_COMPRESSION_NONE: not compressed.
+ * @GCSV_COMPRESSION_GZIP: gzip, always supported.
+ * @GCSV_COMPRESSION_ZSTD: Zstandard, supported if built with libzstd.
+ * @GCSV_COMPRESSION_XZ: xz, supported if built with liblzma.
+ */
+typedef enum
+{
+	GCSV_COMPRESSION_NONE,
+	GCSV_COMPRESSION_GZIP,
+	GCSV_COMPRESSION_ZSTD,
+	GCSV_COMPRESSION_XZ,
+} GcsvCompression;
+
+GcsvCompression	gcsv_compression_detect			(const guint8 *data,
+							 gsize         length);
+
+GcsvCompression	gcsv_compression_from_filename		(const gchar *filename);
+
+gboolean	gcsv_compression_is_supported		(GcsvCompression compression);
+
+GConverter *	gcsv_compression_create_converter	(GcsvCompression   compression,
+							 gboolean          compress,
+							 GError          **error);
+
+GInputStream *	gcsv_compression_open_file		(GFile            *location,
+							 GcsvCompression  *compression,
+							 GCancellable     *cancellable,
+							 GError          **error);
+
+gboolean	gcsv_compression_save_file		(GFile            *location,
+							 GcsvCompression   compression,
+							 GBytes           *contents,
+							 const gchar      *etag,
+							 gchar           **new_etag,
+							 GCancellable     *cancellable,
+							 GError          **error);
+
+G_END_DECLS
+
+#endif /* GCSV_COMPRESSION_H */
@@ -0,0 +1,779 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-file-follower.h"
+#include <glib/gi18n.h>
+#include <string.h>
+#include "gcsv-utils.h"
+
+/* Follows a file that grows, like "tail -f": when the file changes, only the
+ * bytes after the ones already read are read, and the complete lines are
+ * appended to the buffer. An incomplete last line is kept until its line
+ * terminator is written.
+ *
+ * The text is inserted at the end of the buffer, so the other components
+ * handle it as an append and not as an edit of the existing content:
+ * GcsvAlignment scans and aligns only the new lines, and re-aligns the whole
+ * buffer only if a column becomes wider.
+ *
+ * The file is followed from its size when gcsv_file_follower_start() is
+ * called, so the buffer is expected to contain the file content at that
+ * time.
+ */
+
+struct _GcsvFileFollower
+{
+	GObject parent;
+
+	GcsvBuffer *buffer;
+	GFile *location;
+
+	/* Non-NULL while the file is followed. Cancelled by
+	 * gcsv_file_follower_stop().
+	 */
+	GCancellable *cancellable;
+	GFileMonitor *monitor;
+
+	/* Non-NULL while reading. */
+	GFileInputStream *stream;
+
+	/* The number of bytes of the file already read. */
+	goffset offset;
+
+	/* The bytes read after the last line terminator. */
+	GByteArray *partial_line;
+
+	/* With an implicit trailing newline, the line terminator of the last
+	 * line is not in the buffer, it is inserted with the next lines.
+	 */
+	guint newline_pending : 1;
+
+	guint reading : 1;
+
+	/* Whether the file has changed while reading, in which case it is
+	 * read again afterwards.
+	 */
+	guint read_again : 1;
+};
+
+enum
+{
+	PROP_0,
+	PROP_BUFFER,
+	PROP_LOCATION,
+};
+
+enum
+{
+	SIGNAL_APPENDED,
+	SIGNAL_STOPPED,
+	LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+/* Not too big, so that a file growing quickly is shown progressively. */
+#define READ_SIZE (1024 * 1024)
+
+/* In milliseconds. The default of GFileMonitor is 800. */
+#define RATE_LIMIT 100
+
+G_DEFINE_TYPE (GcsvFileFollower, gcsv_file_follower, G_TYPE_OBJECT)
+
+static void read_appended_bytes (GcsvFileFollower *follower);
+
+static void
+stop_with_error (GcsvFileFollower *follower,
+		 GError           *error)
+{
+	gcsv_file_follower_stop (follower);
+	g_signal_emit (follower, signals[SIGNAL_STOPPED], 0, error);
+}
+
+/* Inserts @text, which contains complete lines, at the end of the buffer. */
+static void
+append_lines (GcsvFileFollower *follower,
+	      const gchar      *text,
+	      gsize             length)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (follower->buffer);
+	GString *valid_text;
+	GtkTextIter end;
+	gboolean modified;
+
+	valid_text = g_string_sized_new (length + 1);
+
+	/* The file content is loaded without its last line terminator, which
+	 * is added back when saving the file.
+	 */
+	if (gtk_source_buffer_get_implicit_trailing_newline (GTK_SOURCE_BUFFER (buffer)))
+	{
+		if (follower->newline_pending)
+		{
+			g_string_append_c (valid_text, '\n');
+		}
+
+		follower->newline_pending = TRUE;
+
+		gcsv_utils_append_valid_utf8 (valid_text, text, length - 1);
+
+		if (valid_text->len > 0 && valid_text->str[valid_text->len - 1] == '\r')
+		{
+			g_string_truncate (valid_text, valid_text->len - 1);
+		}
+	}
+	else
+	{
+		gcsv_utils_append_valid_utf8 (valid_text, text, length);
+	}
+
+	/* The appended lines are part of the file, they are not an edit that
+	 * can be undone or that needs to be saved.
+	 */
+	modified = gtk_text_buffer_get_modified (buffer);
+
+	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+	gtk_text_buffer_get_end_iter (buffer, &end);
+	gtk_text_buffer_insert (buffer, &end, valid_text->str, valid_text->len);
+	gtk_source_buffer_end_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+
+	if (!modified)
+	{
+		gtk_text_buffer_set_modified (buffer, FALSE);
+	}
+
+	g_string_free (valid_text, TRUE);
+
+	g_signal_emit (follower, signals[SIGNAL_APPENDED], 0);
+}
+
+static void
+handle_bytes (GcsvFileFollower *follower,
+	      GBytes           *bytes)
+{
+	const guint8 *data;
+	gsize length;
+	gsize complete_length;
+
+	data = g_bytes_get_data (bytes, &length);
+	g_byte_array_append (follower->partial_line, data, length);
+	follower->offset += length;
+
+	/* With "\r\n" line terminators, the '\r' is part of the complete lines
+	 * only once its '\n' is read.
+	 */
+	for (complete_length = follower->partial_line->len; complete_length > 0; complete_length--)
+	{
+		if (follower->partial_line->data[complete_length - 1] == '\n')
+		{
+			break;
+		}
+	}
+
+	if (complete_length > 0)
+	{
+		append_lines (follower, (const gchar *) follower->partial_line->data, complete_length);
+		g_byte_array_remove_range (follower->partial_line, 0, complete_length);
+	}
+}
+
+static void
+finish_reading (GcsvFileFollower *follower)
+{
+	g_clear_object (&follower->stream);
+	follower->reading = FALSE;
+
+	if (follower->read_again)
+	{
+		follower->read_again = FALSE;
+		read_appended_bytes (follower);
+	}
+}
+
+static void
+read_bytes_cb (GObject      *source_object,
+	       GAsyncResult *result,
+	       gpointer      user_data)
+{
+	GcsvFileFollower *follower = GCSV_FILE_FOLLOWER (user_data);
+	GBytes *bytes;
+	GError *error = NULL;
+
+	bytes = g_input_stream_read_bytes_finish (G_INPUT_STREAM (source_object), result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_clear_error (&error);
+		goto out;
+	}
+
+	if (error != NULL)
+	{
+		stop_with_error (follower, error);
+		g_clear_error (&error);
+		goto out;
+	}
+
+	if (g_bytes_get_size (bytes) == 0)
+	{
+		g_bytes_unref (bytes);
+		finish_reading (follower);
+		goto out;
+	}
+
+	handle_bytes (follower, bytes);
+	g_bytes_unref (bytes);
+
+	/* The handlers of ::appended can stop the follower. */
+	if (follower->reading)
+	{
+		g_input_stream_read_bytes_async (G_INPUT_STREAM (follower->stream),
+						 READ_SIZE,
+						 G_PRIORITY_DEFAULT,
+						 follower->cancellable,
+						 read_bytes_cb,
+						 g_object_ref (follower));
+	}
+
+out:
+	g_object_unref (follower);
+}
+
+static void
+query_info_cb (GObject      *source_object,
+	       GAsyncResult *result,
+	       gpointer      user_data)
+{
+	GcsvFileFollower *follower = GCSV_FILE_FOLLOWER (user_data);
+	GFileInfo *info;
+	goffset size;
+	GError *error = NULL;
+
+	info = g_file_input_stream_query_info_finish (G_FILE_INPUT_STREAM (source_object), result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_clear_error (&error);
+		goto out;
+	}
+
+	if (error != NULL)
+	{
+		stop_with_error (follower, error);
+		g_clear_error (&error);
+		goto out;
+	}
+
+	size = g_file_info_get_size (info);
+	g_object_unref (info);
+
+	if (size < follower->offset)
+	{
+		g_set_error_literal (&error, G_IO_ERROR, G_IO_ERROR_FAILED,
+				     _("The file has been truncated."));
+		stop_with_error (follower, error);
+		g_clear_error (&error);
+		goto out;
+	}
+
+	if (size == follower->offset)
+	{
+		finish_reading (follower);
+		goto out;
+	}
+
+	if (!g_seekable_seek (G_SEEKABLE (follower->stream),
+			      follower->offset,
+			      G_SEEK_SET,
+			      follower->cancellable,
+			      &error))
+	{
+		stop_with_error (follower, error);
+		g_clear_error (&error);
+		goto out;
+	}
+
+	g_input_stream_read_bytes_async (G_INPUT_STREAM (follower->stream),
+					 READ_SIZE,
+					 G_PRIORITY_DEFAULT,
+					 follower->cancellable,
+					 read_bytes_cb,
+					 g_object_ref (follower));
+
+out:
+	g_object_unref (follower);
+}
+
+static void
+read_cb (GObject      *source_object,
+	 GAsyncResult *result,
+	 gpointer      user_data)
+{
+	GcsvFileFollower *follower = GCSV_FILE_FOLLOWER (user_data);
+	GFileInputStream *stream;
+	GError *error = NULL;
+
+	stream = g_file_read_finish (G_FILE (source_object), result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_clear_error (&error);
+		goto out;
+	}
+
+	if (error != NULL)
+	{
+		stop_with_error (follower, error);
+		g_clear_error (&error);
+		goto out;
+	}
+
+	follower->stream = stream;
+
+	g_file_input_stream_query_info_async (stream,
+					      G_FILE_ATTRIBUTE_STANDARD_SIZE,
+					      G_PRIORITY_DEFAULT,
+					      follower->cancellable,
+					      query_info_cb,
+					      g_object_ref (follower));
+
+out:
+	g_object_unref (follower);
+}
+
+static void
+read_appended_bytes (GcsvFileFollower *follower)
+{
+	if (follower->cancellable == NULL)
+	{
+		return;
+	}
+
+	if (follower->reading)
+	{
+		follower->read_again = TRUE;
+		return;
+	}
+
+	follower->reading = TRUE;
+
+	/* Reopened each time, in case the file has been replaced. */
+	g_file_read_async (follower->location,
+			   G_PRIORITY_DEFAULT,
+			   follower->cancellable,
+			   read_cb,
+			   g_object_ref (follower));
+}
+
+static void
+monitor_changed_cb (GFileMonitor      *monitor,
+		    GFile             *file,
+		    GFile             *other_file,
+		    GFileMonitorEvent  event_type,
+		    GcsvFileFollower  *follower)
+{
+	GError *error = NULL;
+
+	switch (event_type)
+	{
+		case G_FILE_MONITOR_EVENT_CHANGED:
+		case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+		case G_FILE_MONITOR_EVENT_CREATED:
+			read_appended_bytes (follower);
+			break;
+
+		case G_FILE_MONITOR_EVENT_DELETED:
+			g_set_error_literal (&error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+					     _("The file has been deleted or moved."));
+			stop_with_error (follower, error);
+			g_clear_error (&error);
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void
+start_monitoring (GcsvFileFollower *follower)
+{
+	GError *error = NULL;
+
+	follower->monitor = g_file_monitor_file (follower->location,
+						 G_FILE_MONITOR_NONE,
+						 follower->cancellable,
+						 &error);
+
+	if (error != NULL)
+	{
+		stop_with_error (follower, error);
+		g_clear_error (&error);
+		return;
+	}
+
+	g_file_monitor_set_rate_limit (follower->monitor, RATE_LIMIT);
+
+	g_signal_connect_object (follower->monitor,
+				 "changed",
+				 G_CALLBACK (monitor_changed_cb),
+				 follower,
+				 0);
+}
+
+static void
+read_last_byte_cb (GObject      *source_object,
+		   GAsyncResult *result,
+		   gpointer      user_data)
+{
+	GcsvFileFollower *follower = GCSV_FILE_FOLLOWER (user_data);
+	GBytes *bytes;
+	const guint8 *data;
+	gsize length;
+	GError *error = NULL;
+
+	bytes = g_input_stream_read_bytes_finish (G_INPUT_STREAM (source_object), result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_clear_error (&error);
+		goto out;
+	}
+
+	if (error != NULL)
+	{
+		stop_with_error (follower, error);
+		g_clear_error (&error);
+		goto out;
+	}
+
+	g_clear_object (&follower->stream);
+
+	/* If the file doesn't end with a line terminator, its last line is
+	 * incomplete, but it is already in the buffer: the next bytes continue
+	 * it, so they are inserted without a line terminator before them, and
+	 * the partial line stays empty.
+	 */
+	data = g_bytes_get_data (bytes, &length);
+	follower->newline_pending = length == 1 && data[0] == '\n';
+	g_bytes_unref (bytes);
+
+	start_monitoring (follower);
+
+out:
+	g_object_unref (follower);
+}
+
+static void
+open_for_last_byte_cb (GObject      *source_object,
+		       GAsyncResult *result,
+		       gpointer      user_data)
+{
+	GcsvFileFollower *follower = GCSV_FILE_FOLLOWER (user_data);
+	GFileInputStream *stream;
+	GError *error = NULL;
+
+	stream = g_file_read_finish (G_FILE (source_object), result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_clear_error (&error);
+		goto out;
+	}
+
+	if (error == NULL)
+	{
+		follower->stream = stream;
+
+		g_seekable_seek (G_SEEKABLE (stream),
+				 follower->offset - 1,
+				 G_SEEK_SET,
+				 follower->cancellable,
+				 &error);
+	}
+
+	if (error != NULL)
+	{
+		stop_with_error (follower, error);
+		g_clear_error (&error);
+		goto out;
+	}
+
+	g_input_stream_read_bytes_async (G_INPUT_STREAM (stream),
+					 1,
+					 G_PRIORITY_DEFAULT,
+					 follower->cancellable,
+					 read_last_byte_cb,
+					 g_object_ref (follower));
+
+out:
+	g_object_unref (follower);
+}
+
+static void
+query_initial_size_cb (GObject      *source_object,
+		       GAsyncResult *result,
+		       gpointer      user_data)
+{
+	GcsvFileFollower *follower = GCSV_FILE_FOLLOWER (user_data);
+	GFileInfo *info;
+	GError *error = NULL;
+
+	info = g_file_query_info_finish (G_FILE (source_object), result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_clear_error (&error);
+		goto out;
+	}
+
+	if (error != NULL)
+	{
+		stop_with_error (follower, error);
+		g_clear_error (&error);
+		goto out;
+	}
+
+	follower->offset = g_file_info_get_size (info);
+	follower->newline_pending = FALSE;
+	g_object_unref (info);
+
+	if (follower->offset == 0)
+	{
+		start_monitoring (follower);
+		goto out;
+	}
+
+	/* The last byte tells whether the last line is complete. */
+	g_file_read_async (follower->location,
+			   G_PRIORITY_DEFAULT,
+			   follower->cancellable,
+			   open_for_last_byte_cb,
+			   g_object_ref (follower));
+
+out:
+	g_object_unref (follower);
+}
+
+static void
+gcsv_file_follower_get_property (GObject    *object,
+				 guint       prop_id,
+				 GValue     *value,
+				 GParamSpec *pspec)
+{
+	GcsvFileFollower *follower = GCSV_FILE_FOLLOWER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_value_set_object (value, follower->buffer);
+			break;
+
+		case PROP_LOCATION:
+			g_value_set_object (value, follower->location);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_file_follower_set_property (GObject      *object,
+				 guint         prop_id,
+				 const GValue *value,
+				 GParamSpec   *pspec)
+{
+	GcsvFileFollower *follower = GCSV_FILE_FOLLOWER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_assert (follower->buffer == NULL);
+			follower->buffer = g_value_dup_object (value);
+			break;
+
+		case PROP_LOCATION:
+			g_assert (follower->location == NULL);
+			follower->location = g_value_dup_object (value);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_file_follower_dispose (GObject *object)
+{
+	GcsvFileFollower *follower = GCSV_FILE_FOLLOWER (object);
+
+	gcsv_file_follower_stop (follower);
+
+	g_clear_object (&follower->buffer);
+	g_clear_object (&follower->location);
+
+	G_OBJECT_CLASS (gcsv_file_follower_parent_class)->dispose (object);
+}
+
+static void
+gcsv_file_follower_finalize (GObject *object)
+{
+	GcsvFileFollower *follower = GCSV_FILE_FOLLOWER (object);
+
+	g_byte_array_unref (follower->partial_line);
+
+	G_OBJECT_CLASS (gcsv_file_follower_parent_class)->finalize (object);
+}
+
+static void
+gcsv_file_follower_class_init (GcsvFileFollowerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_file_follower_get_property;
+	object_class->set_property = gcsv_file_follower_set_property;
+	object_class->dispose = gcsv_file_follower_dispose;
+	object_class->finalize = gcsv_file_follower_finalize;
+
+	g_object_class_install_property (object_class,
+					 PROP_BUFFER,
+					 g_param_spec_object ("buffer",
+							      "Buffer",
+							      "",
+							      GCSV_TYPE_BUFFER,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (object_class,
+					 PROP_LOCATION,
+					 g_param_spec_object ("location",
+							      "Location",
+							      "",
+							      G_TYPE_FILE,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GcsvFileFollower::appended:
+	 * @follower: the #GcsvFileFollower who emits the signal.
+	 *
+	 * The ::appended signal is emitted after new lines have been inserted
+	 * at the end of the buffer.
+	 */
+	signals[SIGNAL_APPENDED] =
+		g_signal_new ("appended",
+			      G_TYPE_FROM_CLASS (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL, NULL,
+			      G_TYPE_NONE, 0);
+
+	/**
+	 * GcsvFileFollower::stopped:
+	 * @follower: the #GcsvFileFollower who emits the signal.
+	 * @error: the reason.
+	 *
+	 * The ::stopped signal is emitted when the file can no longer be
+	 * followed, for example when it is truncated or deleted.
+	 */
+	signals[SIGNAL_STOPPED] =
+		g_signal_new ("stopped",
+			      G_TYPE_FROM_CLASS (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL, NULL,
+			      G_TYPE_NONE, 1, G_TYPE_ERROR);
+}
+
+static void
+gcsv_file_follower_init (GcsvFileFollower *follower)
+{
+	follower->partial_line = g_byte_array_new ();
+}
+
+GcsvFileFollower *
+gcsv_file_follower_new (GcsvBuffer *buffer,
+			GFile      *location)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+	g_return_val_if_fail (G_IS_FILE (location), NULL);
+
+	return g_object_new (GCSV_TYPE_FILE_FOLLOWER,
+			     "buffer", buffer,
+			     "location", location,
+			     NULL);
+}
+
+void
+gcsv_file_follower_start (GcsvFileFollower *follower)
+{
+	g_return_if_fail (GCSV_IS_FILE_FOLLOWER (follower));
+
+	if (follower->cancellable != NULL)
+	{
+		return;
+	}
+
+	follower->cancellable = g_cancellable_new ();
+	g_byte_array_set_size (follower->partial_line, 0);
+
+	g_file_query_info_async (follower->location,
+				 G_FILE_ATTRIBUTE_STANDARD_SIZE,
+				 G_FILE_QUERY_INFO_NONE,
+				 G_PRIORITY_DEFAULT,
+				 follower->cancellable,
+				 query_initial_size_cb,
+				 g_object_ref (follower));
+}
+
+void
+gcsv_file_follower_stop (GcsvFileFollower *follower)
+{
+	g_return_if_fail (GCSV_IS_FILE_FOLLOWER (follower));
+
+	if (follower->cancellable == NULL)
+	{
+		return;
+	}
+
+	g_cancellable_cancel (follower->cancellable);
+	g_clear_object (&follower->cancellable);
+
+	if (follower->monitor != NULL)
+	{
+		g_file_monitor_cancel (follower->monitor);
+		g_clear_object (&follower->monitor);
+	}
+
+	g_clear_object (&follower->stream);
+	follower->reading = FALSE;
+	follower->read_again = FALSE;
+}
+
+gboolean
+gcsv_file_follower_is_started (GcsvFileFollower *follower)
+{
+	g_return_val_if_fail (GCSV_IS_FILE_FOLLOWER (follower), FALSE);
+
+	return follower->cancellable != NULL;
+}
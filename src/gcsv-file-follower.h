@@ -0,0 +1,44 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_FILE_FOLLOWER_H
+#define GCSV_FILE_FOLLOWER_H
+
+#include <gtk/gtk.h>
+#include "gcsv-buffer.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_FILE_FOLLOWER (gcsv_file_follower_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvFileFollower, gcsv_file_follower,
+		      GCSV, FILE_FOLLOWER,
+		      GObject)
+
+GcsvFileFollower *	gcsv_file_follower_new		(GcsvBuffer *buffer,
+							 GFile      *location);
+
+void			gcsv_file_follower_start	(GcsvFileFollower *follower);
+
+void			gcsv_file_follower_stop		(GcsvFileFollower *follower);
+
+gboolean		gcsv_file_follower_is_started	(GcsvFileFollower *follower);
+
+G_END_DECLS
+
+#endif /* GCSV_FILE_FOLLOWER_H */
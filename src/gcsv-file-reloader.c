@@ -0,0 +1,574 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-file-reloader.h"
+#include <glib/gi18n.h>
+#include "gcsv-block-hashes.h"
+#include "gcsv-utils.h"
+
+/* Reloads the lines that have changed when the file is rewritten by another
+ * program, instead of loading the whole file again.
+ *
+ * The block hashes of the file content are recorded when the
+ * GcsvFileReloader is created, i.e. just after the file is loaded or saved.
+ * When the file changes, it is read and hashed again in a worker thread, and
+ * only the lines of the blocks that differ are replaced in the buffer, with
+ * gcsv_buffer_replace_lines(). So GcsvAlignment scans and aligns only those
+ * lines.
+ *
+ * The buffer is reloaded only if it is not modified, the user changes are not
+ * discarded.
+ *
+ * The file must be in UTF-8, since the changed bytes are inserted as-is. If the
+ * changed lines are not valid UTF-8, they are not reloaded.
+ */
+
+struct _GcsvFileReloader
+{
+	GObject parent;
+
+	GcsvBuffer *buffer;
+	GFile *location;
+
+	GFileMonitor *monitor;
+
+	/* Non-NULL while a worker thread runs. */
+	GCancellable *cancellable;
+
+	/* The hashes of the file content that is in the buffer. NULL until
+	 * the first thread has finished.
+	 */
+	GcsvBlockHashes *hashes;
+
+	/* The entity tag of the file when its content has been reloaded, or
+	 * has been found unchanged. NULL until then.
+	 */
+	gchar *etag;
+
+	guint stopped : 1;
+
+	/* Whether the file has changed while a thread was running. */
+	guint reload_pending : 1;
+};
+
+typedef struct _ReloadData ReloadData;
+struct _ReloadData
+{
+	GFile *location;
+	const GcsvBlockHashes *old_hashes;
+	guint implicit_trailing_newline : 1;
+
+	/* Filled by the thread. */
+	gchar *etag;
+	GcsvBlockHashes *new_hashes;
+	GcsvBlockDiff diff;
+	GString *text;
+};
+
+enum
+{
+	PROP_0,
+	PROP_BUFFER,
+	PROP_LOCATION,
+};
+
+enum
+{
+	SIGNAL_RELOADED,
+	LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE (GcsvFileReloader, gcsv_file_reloader, G_TYPE_OBJECT)
+
+static void launch_thread (GcsvFileReloader *reloader);
+
+static void
+reload_data_free (gpointer data)
+{
+	ReloadData *reload_data = data;
+
+	if (reload_data != NULL)
+	{
+		g_object_unref (reload_data->location);
+		g_free (reload_data->etag);
+		gcsv_block_hashes_free (reload_data->new_hashes);
+
+		if (reload_data->text != NULL)
+		{
+			g_string_free (reload_data->text, TRUE);
+		}
+
+		g_free (reload_data);
+	}
+}
+
+/* @offset is at the start of a line which is not the first one. */
+static gsize
+get_previous_line_start (const gchar *text,
+			 gsize        offset)
+{
+	offset--;
+
+	while (offset > 0 && text[offset - 1] != '\n')
+	{
+		offset--;
+	}
+
+	return offset;
+}
+
+/* The buffer has an implicit trailing newline: its last line has no line
+ * terminator. So when the diff includes the last line, the text must not end
+ * with a line terminator, and the line before must be replaced too, in case its
+ * line terminator needs to be removed or added.
+ */
+static void
+adjust_diff_to_buffer_end (ReloadData  *data,
+			   const gchar *content)
+{
+	if (data->diff.start_line > 0)
+	{
+		data->diff.new_start = get_previous_line_start (content, data->diff.new_start);
+		data->diff.start_line--;
+		data->diff.old_n_lines++;
+		data->diff.new_n_lines++;
+	}
+}
+
+static void
+reload_thread (GTask        *task,
+	       gpointer      source_object,
+	       gpointer      task_data,
+	       GCancellable *cancellable)
+{
+	ReloadData *data = task_data;
+	gchar *content;
+	gsize length;
+	gboolean at_end;
+	GError *error = NULL;
+
+	if (!g_file_load_contents (data->location, cancellable, &content, &length, &data->etag, &error))
+	{
+		g_task_return_error (task, error);
+		return;
+	}
+
+	data->new_hashes = gcsv_block_hashes_new (content, length, cancellable);
+
+	if (data->new_hashes == NULL)
+	{
+		g_free (content);
+		g_task_return_error_if_cancelled (task);
+		return;
+	}
+
+	if (data->old_hashes == NULL ||
+	    !gcsv_block_hashes_diff (data->old_hashes, data->new_hashes, &data->diff))
+	{
+		g_free (content);
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	at_end = data->diff.new_end == length;
+
+	if (at_end && data->implicit_trailing_newline)
+	{
+		adjust_diff_to_buffer_end (data, content);
+	}
+
+	if (!g_utf8_validate (content + data->diff.new_start,
+			      data->diff.new_end - data->diff.new_start,
+			      NULL))
+	{
+		g_free (content);
+		g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+					 _("The file is not in UTF-8."));
+		return;
+	}
+
+	data->text = g_string_new_len (content + data->diff.new_start,
+				       data->diff.new_end - data->diff.new_start);
+
+	if (at_end && data->implicit_trailing_newline)
+	{
+		gcsv_utils_strip_last_line_terminator (data->text);
+	}
+
+	g_free (content);
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+apply_diff (GcsvFileReloader *reloader,
+	    ReloadData       *data)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (reloader->buffer);
+
+	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+
+	gcsv_buffer_replace_lines (reloader->buffer,
+				   data->diff.start_line,
+				   data->diff.old_n_lines,
+				   data->text->str,
+				   NULL,
+				   NULL);
+
+	gtk_source_buffer_end_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+
+	gtk_text_buffer_set_modified (buffer, FALSE);
+}
+
+static void
+reload_cb (GObject      *source_object,
+	   GAsyncResult *result,
+	   gpointer      user_data)
+{
+	GcsvFileReloader *reloader = GCSV_FILE_RELOADER (source_object);
+	GTask *task = G_TASK (result);
+	ReloadData *data;
+	GError *error = NULL;
+
+	g_clear_object (&reloader->cancellable);
+
+	/* For example when the file is being replaced and doesn't exist for a
+	 * short time, or when the changed lines are not in UTF-8. The next
+	 * change will be handled.
+	 */
+	if (!g_task_propagate_boolean (task, &error))
+	{
+		g_clear_error (&error);
+		goto out;
+	}
+
+	data = g_task_get_task_data (task);
+
+	/* For the first thread, the file may have changed since it has been
+	 * loaded, so its etag is not recorded.
+	 */
+	if (data->old_hashes == NULL)
+	{
+		goto update_hashes;
+	}
+
+	if (data->text != NULL)
+	{
+		/* The buffer has been modified during the thread. The hashes
+		 * are kept, they don't correspond to the file anymore but to
+		 * what is in the buffer.
+		 */
+		if (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (reloader->buffer)))
+		{
+			goto out;
+		}
+
+		apply_diff (reloader, data);
+	}
+
+	g_free (reloader->etag);
+	reloader->etag = data->etag;
+	data->etag = NULL;
+
+update_hashes:
+	gcsv_block_hashes_free (reloader->hashes);
+	reloader->hashes = data->new_hashes;
+	data->new_hashes = NULL;
+
+	if (data->text != NULL)
+	{
+		g_signal_emit (reloader, signals[SIGNAL_RELOADED], 0);
+	}
+
+out:
+	if (reloader->reload_pending && !reloader->stopped)
+	{
+		reloader->reload_pending = FALSE;
+		gcsv_file_reloader_reload (reloader);
+	}
+}
+
+static void
+launch_thread (GcsvFileReloader *reloader)
+{
+	ReloadData *data;
+	GTask *task;
+
+	data = g_new0 (ReloadData, 1);
+	data->location = g_object_ref (reloader->location);
+	data->old_hashes = reloader->hashes;
+	data->implicit_trailing_newline =
+		gtk_source_buffer_get_implicit_trailing_newline (GTK_SOURCE_BUFFER (reloader->buffer));
+
+	reloader->cancellable = g_cancellable_new ();
+
+	task = g_task_new (reloader, reloader->cancellable, reload_cb, NULL);
+	g_task_set_task_data (task, data, reload_data_free);
+	g_task_run_in_thread (task, reload_thread);
+	g_object_unref (task);
+}
+
+static void
+monitor_changed_cb (GFileMonitor      *monitor,
+		    GFile             *file,
+		    GFile             *other_file,
+		    GFileMonitorEvent  event_type,
+		    GcsvFileReloader  *reloader)
+{
+	/* CHANGES_DONE_HINT: the other program has closed the file.
+	 * CREATED: the file has been replaced, e.g. with a rename.
+	 */
+	if (event_type == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT ||
+	    event_type == G_FILE_MONITOR_EVENT_CREATED)
+	{
+		gcsv_file_reloader_reload (reloader);
+	}
+}
+
+static void
+gcsv_file_reloader_get_property (GObject    *object,
+				 guint       prop_id,
+				 GValue     *value,
+				 GParamSpec *pspec)
+{
+	GcsvFileReloader *reloader = GCSV_FILE_RELOADER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_value_set_object (value, reloader->buffer);
+			break;
+
+		case PROP_LOCATION:
+			g_value_set_object (value, reloader->location);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_file_reloader_set_property (GObject      *object,
+				 guint         prop_id,
+				 const GValue *value,
+				 GParamSpec   *pspec)
+{
+	GcsvFileReloader *reloader = GCSV_FILE_RELOADER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_assert (reloader->buffer == NULL);
+			reloader->buffer = g_value_dup_object (value);
+			break;
+
+		case PROP_LOCATION:
+			g_assert (reloader->location == NULL);
+			reloader->location = g_value_dup_object (value);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_file_reloader_constructed (GObject *object)
+{
+	GcsvFileReloader *reloader = GCSV_FILE_RELOADER (object);
+
+	G_OBJECT_CLASS (gcsv_file_reloader_parent_class)->constructed (object);
+
+	/* Without monitor, gcsv_file_reloader_reload() can still be called. */
+	reloader->monitor = g_file_monitor_file (reloader->location,
+						 G_FILE_MONITOR_NONE,
+						 NULL,
+						 NULL);
+
+	if (reloader->monitor != NULL)
+	{
+		g_signal_connect_object (reloader->monitor,
+					 "changed",
+					 G_CALLBACK (monitor_changed_cb),
+					 reloader,
+					 0);
+	}
+
+	/* Records the initial hashes. */
+	launch_thread (reloader);
+}
+
+static void
+gcsv_file_reloader_dispose (GObject *object)
+{
+	GcsvFileReloader *reloader = GCSV_FILE_RELOADER (object);
+
+	gcsv_file_reloader_stop (reloader);
+
+	g_clear_object (&reloader->buffer);
+	g_clear_object (&reloader->location);
+
+	G_OBJECT_CLASS (gcsv_file_reloader_parent_class)->dispose (object);
+}
+
+static void
+gcsv_file_reloader_finalize (GObject *object)
+{
+	GcsvFileReloader *reloader = GCSV_FILE_RELOADER (object);
+
+	gcsv_block_hashes_free (reloader->hashes);
+	g_free (reloader->etag);
+
+	G_OBJECT_CLASS (gcsv_file_reloader_parent_class)->finalize (object);
+}
+
+static void
+gcsv_file_reloader_class_init (GcsvFileReloaderClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_file_reloader_get_property;
+	object_class->set_property = gcsv_file_reloader_set_property;
+	object_class->constructed = gcsv_file_reloader_constructed;
+	object_class->dispose = gcsv_file_reloader_dispose;
+	object_class->finalize = gcsv_file_reloader_finalize;
+
+	g_object_class_install_property (object_class,
+					 PROP_BUFFER,
+					 g_param_spec_object ("buffer",
+							      "Buffer",
+							      "",
+							      GCSV_TYPE_BUFFER,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (object_class,
+					 PROP_LOCATION,
+					 g_param_spec_object ("location",
+							      "Location",
+							      "",
+							      G_TYPE_FILE,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GcsvFileReloader::reloaded:
+	 * @reloader: the #GcsvFileReloader who emits the signal.
+	 *
+	 * The ::reloaded signal is emitted after the changed lines of the file
+	 * have been replaced in the buffer.
+	 */
+	signals[SIGNAL_RELOADED] =
+		g_signal_new ("reloaded",
+			      G_TYPE_FROM_CLASS (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL, NULL,
+			      G_TYPE_NONE, 0);
+}
+
+static void
+gcsv_file_reloader_init (GcsvFileReloader *reloader)
+{
+}
+
+/* The buffer must contain the file content, i.e. the file has just been loaded
+ * or saved.
+ */
+GcsvFileReloader *
+gcsv_file_reloader_new (GcsvBuffer *buffer,
+			GFile      *location)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+	g_return_val_if_fail (G_IS_FILE (location), NULL);
+
+	return g_object_new (GCSV_TYPE_FILE_RELOADER,
+			     "buffer", buffer,
+			     "location", location,
+			     NULL);
+}
+
+/* Compares the file with the recorded hashes, and reloads the changed lines.
+ * Called automatically when the file changes.
+ */
+void
+gcsv_file_reloader_reload (GcsvFileReloader *reloader)
+{
+	g_return_if_fail (GCSV_IS_FILE_RELOADER (reloader));
+
+	if (reloader->stopped)
+	{
+		return;
+	}
+
+	/* Also while the initial hashes are computed: the file may have
+	 * changed since it has been read.
+	 */
+	if (reloader->cancellable != NULL)
+	{
+		reloader->reload_pending = TRUE;
+		return;
+	}
+
+	if (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (reloader->buffer)))
+	{
+		return;
+	}
+
+	launch_thread (reloader);
+}
+
+/* Stops monitoring the file, and cancels the running thread. */
+void
+gcsv_file_reloader_stop (GcsvFileReloader *reloader)
+{
+	g_return_if_fail (GCSV_IS_FILE_RELOADER (reloader));
+
+	reloader->stopped = TRUE;
+	reloader->reload_pending = FALSE;
+
+	if (reloader->cancellable != NULL)
+	{
+		g_cancellable_cancel (reloader->cancellable);
+	}
+
+	if (reloader->monitor != NULL)
+	{
+		g_file_monitor_cancel (reloader->monitor);
+		g_clear_object (&reloader->monitor);
+	}
+}
+
+/* Returns: the entity tag of the file, if its content has been reloaded or
+ * has been checked unchanged since the #GcsvFileReloader has been created.
+ * NULL otherwise.
+ */
+const gchar *
+gcsv_file_reloader_get_etag (GcsvFileReloader *reloader)
+{
+	g_return_val_if_fail (GCSV_IS_FILE_RELOADER (reloader), NULL);
+
+	return reloader->etag;
+}
@@ -0,0 +1,44 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_FILE_RELOADER_H
+#define GCSV_FILE_RELOADER_H
+
+#include <gtk/gtk.h>
+#include "gcsv-buffer.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_FILE_RELOADER (gcsv_file_reloader_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvFileReloader, gcsv_file_reloader,
+		      GCSV, FILE_RELOADER,
+		      GObject)
+
+GcsvFileReloader *	gcsv_file_reloader_new		(GcsvBuffer *buffer,
+							 GFile      *location);
+
+void			gcsv_file_reloader_reload	(GcsvFileReloader *reloader);
+
+void			gcsv_file_reloader_stop		(GcsvFileReloader *reloader);
+
+const gchar *		gcsv_file_reloader_get_etag	(GcsvFileReloader *reloader);
+
+G_END_DECLS
+
+#endif /* GCSV_FILE_RELOADER_H */
@@ -0,0 +1,280 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-filter-bar.h"
+#include <glib/gi18n.h>
+
+struct _GcsvFilterBar
+{
+	GtkGrid parent;
+
+	GcsvRowFilter *row_filter;
+
+	GtkSpinButton *column_spinbutton;
+	GtkComboBoxText *mode_combo;
+	GtkSearchEntry *entry;
+};
+
+enum
+{
+	PROP_0,
+	PROP_ROW_FILTER,
+};
+
+#define ROW_ID_SUBSTRING	"substring"
+#define ROW_ID_REGEX		"regex"
+#define ROW_ID_NUMERIC		"numeric"
+
+G_DEFINE_TYPE (GcsvFilterBar, gcsv_filter_bar, GTK_TYPE_GRID)
+
+static GcsvFilterMode
+get_mode (GcsvFilterBar *bar)
+{
+	const gchar *row_id;
+
+	row_id = gtk_combo_box_get_active_id (GTK_COMBO_BOX (bar->mode_combo));
+
+	if (g_strcmp0 (row_id, ROW_ID_REGEX) == 0)
+	{
+		return GCSV_FILTER_MODE_REGEX;
+	}
+	if (g_strcmp0 (row_id, ROW_ID_NUMERIC) == 0)
+	{
+		return GCSV_FILTER_MODE_NUMERIC;
+	}
+
+	return GCSV_FILTER_MODE_SUBSTRING;
+}
+
+static void
+set_error (GcsvFilterBar *bar,
+	   GError        *error)
+{
+	GtkStyleContext *style_context;
+
+	style_context = gtk_widget_get_style_context (GTK_WIDGET (bar->entry));
+
+	if (error != NULL)
+	{
+		gtk_style_context_add_class (style_context, GTK_STYLE_CLASS_ERROR);
+		gtk_widget_set_tooltip_text (GTK_WIDGET (bar->entry), error->message);
+	}
+	else
+	{
+		gtk_style_context_remove_class (style_context, GTK_STYLE_CLASS_ERROR);
+		gtk_widget_set_tooltip_text (GTK_WIDGET (bar->entry), NULL);
+	}
+}
+
+static void
+update_filter (GcsvFilterBar *bar)
+{
+	const gchar *pattern;
+	GcsvFilter *filter;
+	GError *error = NULL;
+
+	if (bar->row_filter == NULL)
+	{
+		return;
+	}
+
+	pattern = gtk_entry_get_text (GTK_ENTRY (bar->entry));
+
+	if (pattern == NULL || pattern[0] == '\0')
+	{
+		set_error (bar, NULL);
+		gcsv_row_filter_set_filter (bar->row_filter, NULL);
+		return;
+	}
+
+	filter = gcsv_filter_new (get_mode (bar),
+				  gtk_spin_button_get_value_as_int (bar->column_spinbutton) - 1,
+				  pattern,
+				  &error);
+
+	/* On error, the previous filter is kept until the pattern is fixed. */
+	set_error (bar, error);
+	g_clear_error (&error);
+
+	if (filter != NULL)
+	{
+		gcsv_row_filter_set_filter (bar->row_filter, filter);
+		gcsv_filter_unref (filter);
+	}
+}
+
+static void
+gcsv_filter_bar_get_property (GObject    *object,
+			      guint       prop_id,
+			      GValue     *value,
+			      GParamSpec *pspec)
+{
+	GcsvFilterBar *bar = GCSV_FILTER_BAR (object);
+
+	switch (prop_id)
+	{
+		case PROP_ROW_FILTER:
+			g_value_set_object (value, bar->row_filter);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_filter_bar_set_property (GObject      *object,
+			      guint         prop_id,
+			      const GValue *value,
+			      GParamSpec   *pspec)
+{
+	GcsvFilterBar *bar = GCSV_FILTER_BAR (object);
+
+	switch (prop_id)
+	{
+		case PROP_ROW_FILTER:
+			g_assert (bar->row_filter == NULL);
+			bar->row_filter = g_value_dup_object (value);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_filter_bar_dispose (GObject *object)
+{
+	GcsvFilterBar *bar = GCSV_FILTER_BAR (object);
+
+	g_clear_object (&bar->row_filter);
+
+	G_OBJECT_CLASS (gcsv_filter_bar_parent_class)->dispose (object);
+}
+
+static void
+gcsv_filter_bar_class_init (GcsvFilterBarClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_filter_bar_get_property;
+	object_class->set_property = gcsv_filter_bar_set_property;
+	object_class->dispose = gcsv_filter_bar_dispose;
+
+	g_object_class_install_property (object_class,
+					 PROP_ROW_FILTER,
+					 g_param_spec_object ("row-filter",
+							      "Row Filter",
+							      "",
+							      GCSV_TYPE_ROW_FILTER,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+}
+
+static void
+column_spinbutton_value_changed_cb (GtkSpinButton *column_spinbutton,
+				    GcsvFilterBar *bar)
+{
+	update_filter (bar);
+}
+
+static void
+mode_combo_changed_cb (GtkComboBox   *mode_combo,
+		       GcsvFilterBar *bar)
+{
+	update_filter (bar);
+}
+
+/* "search-changed" is emitted with a short delay after the last keystroke. */
+static void
+entry_search_changed_cb (GtkSearchEntry *entry,
+			 GcsvFilterBar  *bar)
+{
+	update_filter (bar);
+}
+
+static void
+gcsv_filter_bar_init (GcsvFilterBar *bar)
+{
+	GtkWidget *label;
+
+	gtk_orientable_set_orientation (GTK_ORIENTABLE (bar), GTK_ORIENTATION_HORIZONTAL);
+	gtk_grid_set_column_spacing (GTK_GRID (bar), 6);
+
+	label = gtk_label_new_with_mnemonic (_("Show the rows where the co_lumn"));
+	gtk_container_add (GTK_CONTAINER (bar), label);
+
+	bar->column_spinbutton = GTK_SPIN_BUTTON (gtk_spin_button_new_with_range (1, 9999, 1));
+	gtk_container_add (GTK_CONTAINER (bar), GTK_WIDGET (bar->column_spinbutton));
+
+	gtk_label_set_mnemonic_widget (GTK_LABEL (label),
+				       GTK_WIDGET (bar->column_spinbutton));
+
+	g_signal_connect (bar->column_spinbutton,
+			  "value-changed",
+			  G_CALLBACK (column_spinbutton_value_changed_cb),
+			  bar);
+
+	bar->mode_combo = GTK_COMBO_BOX_TEXT (gtk_combo_box_text_new ());
+	gtk_container_add (GTK_CONTAINER (bar), GTK_WIDGET (bar->mode_combo));
+
+	gtk_combo_box_text_append (bar->mode_combo, ROW_ID_SUBSTRING, _("contains"));
+	gtk_combo_box_text_append (bar->mode_combo, ROW_ID_REGEX, _("matches the regular expression"));
+	gtk_combo_box_text_append (bar->mode_combo, ROW_ID_NUMERIC, _("is a number"));
+
+	gtk_combo_box_set_active_id (GTK_COMBO_BOX (bar->mode_combo),
+				     ROW_ID_SUBSTRING);
+
+	g_signal_connect (bar->mode_combo,
+			  "changed",
+			  G_CALLBACK (mode_combo_changed_cb),
+			  bar);
+
+	bar->entry = GTK_SEARCH_ENTRY (gtk_search_entry_new ());
+	gtk_widget_set_hexpand (GTK_WIDGET (bar->entry), TRUE);
+	gtk_entry_set_placeholder_text (GTK_ENTRY (bar->entry), _("Text, regular expression, or “> 10”"));
+	gtk_container_add (GTK_CONTAINER (bar), GTK_WIDGET (bar->entry));
+
+	g_signal_connect (bar->entry,
+			  "search-changed",
+			  G_CALLBACK (entry_search_changed_cb),
+			  bar);
+}
+
+GcsvFilterBar *
+gcsv_filter_bar_new (GcsvRowFilter *row_filter)
+{
+	g_return_val_if_fail (GCSV_IS_ROW_FILTER (row_filter), NULL);
+
+	return g_object_new (GCSV_TYPE_FILTER_BAR,
+			     "row-filter", row_filter,
+			     "margin", 6,
+			     NULL);
+}
+
+void
+gcsv_filter_bar_grab_focus (GcsvFilterBar *bar)
+{
+	g_return_if_fail (GCSV_IS_FILTER_BAR (bar));
+
+	gtk_widget_grab_focus (GTK_WIDGET (bar->entry));
+}
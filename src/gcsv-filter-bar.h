@@ -0,0 +1,39 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_FILTER_BAR_H
+#define GCSV_FILTER_BAR_H
+
+#include <gtk/gtk.h>
+#include "gcsv-row-filter.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_FILTER_BAR (gcsv_filter_bar_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvFilterBar, gcsv_filter_bar,
+		      GCSV, FILTER_BAR,
+		      GtkGrid)
+
+GcsvFilterBar *	gcsv_filter_bar_new		(GcsvRowFilter *row_filter);
+
+void		gcsv_filter_bar_grab_focus	(GcsvFilterBar *bar);
+
+G_END_DECLS
+
+#endif /* GCSV_FILTER_BAR_H */
@@ -0,0 +1,360 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-filter.h"
+#include <glib/gi18n.h>
+#include <string.h>
+
+/* A predicate on one column, to filter the rows. A GcsvFilter is immutable
+ * once created, so it can be used from several threads at the same time.
+ */
+
+typedef enum
+{
+	OPERATOR_EQUAL,
+	OPERATOR_NOT_EQUAL,
+	OPERATOR_LESS,
+	OPERATOR_LESS_OR_EQUAL,
+	OPERATOR_GREATER,
+	OPERATOR_GREATER_OR_EQUAL,
+} Operator;
+
+struct _GcsvFilter
+{
+	GcsvFilterMode mode;
+	guint column_num;
+
+	/* For GCSV_FILTER_MODE_SUBSTRING. */
+	gchar *substring;
+	gsize substring_length;
+
+	/* For GCSV_FILTER_MODE_REGEX. */
+	GRegex *regex;
+
+	/* For GCSV_FILTER_MODE_NUMERIC. */
+	Operator op;
+	gdouble number;
+
+	gint ref_count;
+};
+
+G_DEFINE_QUARK (gcsv-filter-error-quark, gcsv_filter_error)
+
+static const gchar *
+parse_operator (const gchar *pattern,
+		Operator    *op)
+{
+	while (g_ascii_isspace (*pattern))
+	{
+		pattern++;
+	}
+
+	if (g_str_has_prefix (pattern, "<="))
+	{
+		*op = OPERATOR_LESS_OR_EQUAL;
+		return pattern + 2;
+	}
+
+	if (g_str_has_prefix (pattern, ">="))
+	{
+		*op = OPERATOR_GREATER_OR_EQUAL;
+		return pattern + 2;
+	}
+
+	if (g_str_has_prefix (pattern, "!="))
+	{
+		*op = OPERATOR_NOT_EQUAL;
+		return pattern + 2;
+	}
+
+	if (g_str_has_prefix (pattern, "=="))
+	{
+		*op = OPERATOR_EQUAL;
+		return pattern + 2;
+	}
+
+	switch (*pattern)
+	{
+		case '<':
+			*op = OPERATOR_LESS;
+			return pattern + 1;
+
+		case '>':
+			*op = OPERATOR_GREATER;
+			return pattern + 1;
+
+		case '=':
+			*op = OPERATOR_EQUAL;
+			return pattern + 1;
+
+		default:
+			break;
+	}
+
+	*op = OPERATOR_EQUAL;
+	return pattern;
+}
+
+/* Returns: (transfer full) (nullable): a new #GcsvFilter, or %NULL if @pattern
+ * is not valid for @mode.
+ */
+GcsvFilter *
+gcsv_filter_new (GcsvFilterMode   mode,
+		 guint            column_num,
+		 const gchar     *pattern,
+		 GError         **error)
+{
+	GcsvFilter *filter;
+
+	g_return_val_if_fail (pattern != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	filter = g_new0 (GcsvFilter, 1);
+	filter->ref_count = 1;
+	filter->mode = mode;
+	filter->column_num = column_num;
+
+	switch (mode)
+	{
+		case GCSV_FILTER_MODE_SUBSTRING:
+			filter->substring = g_strdup (pattern);
+			filter->substring_length = strlen (pattern);
+			break;
+
+		case GCSV_FILTER_MODE_REGEX:
+			filter->regex = g_regex_new (pattern, G_REGEX_OPTIMIZE, 0, error);
+			if (filter->regex == NULL)
+			{
+				gcsv_filter_unref (filter);
+				return NULL;
+			}
+			break;
+
+		case GCSV_FILTER_MODE_NUMERIC:
+		{
+			const gchar *number_str;
+
+			number_str = parse_operator (pattern, &filter->op);
+			if (!gcsv_tokenizer_parse_number (number_str, number_str + strlen (number_str), &filter->number))
+			{
+				g_set_error (error,
+					     GCSV_FILTER_ERROR,
+					     GCSV_FILTER_ERROR_INVALID_NUMBER,
+					     _("“%s” is not a number."),
+					     number_str);
+				gcsv_filter_unref (filter);
+				return NULL;
+			}
+			break;
+		}
+
+		default:
+			g_assert_not_reached ();
+	}
+
+	return filter;
+}
+
+GcsvFilter *
+gcsv_filter_ref (GcsvFilter *filter)
+{
+	g_return_val_if_fail (filter != NULL, NULL);
+
+	g_atomic_int_inc (&filter->ref_count);
+	return filter;
+}
+
+void
+gcsv_filter_unref (GcsvFilter *filter)
+{
+	if (filter == NULL)
+	{
+		return;
+	}
+
+	if (g_atomic_int_dec_and_test (&filter->ref_count))
+	{
+		g_free (filter->substring);
+
+		if (filter->regex != NULL)
+		{
+			g_regex_unref (filter->regex);
+		}
+
+		g_free (filter);
+	}
+}
+
+guint
+gcsv_filter_get_column_num (GcsvFilter *filter)
+{
+	g_return_val_if_fail (filter != NULL, 0);
+
+	return filter->column_num;
+}
+
+static gboolean
+match_number (GcsvFilter  *filter,
+	      const gchar *field,
+	      const gchar *field_end)
+{
+	gdouble number;
+
+	if (!gcsv_tokenizer_parse_number (field, field_end, &number))
+	{
+		return FALSE;
+	}
+
+	switch (filter->op)
+	{
+		case OPERATOR_EQUAL:
+			return number == filter->number;
+
+		case OPERATOR_NOT_EQUAL:
+			return number != filter->number;
+
+		case OPERATOR_LESS:
+			return number < filter->number;
+
+		case OPERATOR_LESS_OR_EQUAL:
+			return number <= filter->number;
+
+		case OPERATOR_GREATER:
+			return number > filter->number;
+
+		case OPERATOR_GREATER_OR_EQUAL:
+			return number >= filter->number;
+
+		default:
+			g_assert_not_reached ();
+	}
+
+	return FALSE;
+}
+
+static gboolean
+contains_substring (GcsvFilter  *filter,
+		    const gchar *field,
+		    const gchar *field_end)
+{
+	const gchar *p = field;
+
+	if (filter->substring_length == 0)
+	{
+		return TRUE;
+	}
+
+	while ((gsize) (field_end - p) >= filter->substring_length)
+	{
+		p = memchr (p, filter->substring[0], field_end - p - filter->substring_length + 1);
+		if (p == NULL)
+		{
+			return FALSE;
+		}
+
+		if (memcmp (p, filter->substring, filter->substring_length) == 0)
+		{
+			return TRUE;
+		}
+
+		p++;
+	}
+
+	return FALSE;
+}
+
+static gboolean
+match_field (GcsvFilter  *filter,
+	     const gchar *field,
+	     const gchar *field_end)
+{
+	switch (filter->mode)
+	{
+		case GCSV_FILTER_MODE_SUBSTRING:
+			return contains_substring (filter, field, field_end);
+
+		case GCSV_FILTER_MODE_REGEX:
+			return g_regex_match_full (filter->regex,
+						   field, field_end - field,
+						   0, 0, NULL, NULL);
+
+		case GCSV_FILTER_MODE_NUMERIC:
+			return match_number (filter, field, field_end);
+
+		default:
+			g_assert_not_reached ();
+	}
+
+	return FALSE;
+}
+
+/* A line without the column has an empty field. */
+gboolean
+gcsv_filter_match_line (GcsvFilter          *filter,
+			const GcsvTokenizer *tokenizer,
+			const gchar         *line,
+			const gchar         *line_end)
+{
+	const gchar *field_start;
+	const gchar *field_end;
+
+	g_return_val_if_fail (filter != NULL, FALSE);
+	g_return_val_if_fail (tokenizer != NULL, FALSE);
+
+	if (!gcsv_tokenizer_get_field_bounds (tokenizer, line, line_end, filter->column_num,
+					      &field_start, &field_end))
+	{
+		field_start = field_end = line_end;
+	}
+
+	return match_field (filter, field_start, field_end);
+}
+
+/* Appends to @rejected_lines, an array of guint's, the numbers of the lines of
+ * @text that don't match, the first line of @text being the line 0.
+ */
+void
+gcsv_filter_match_lines (GcsvFilter          *filter,
+			 const GcsvTokenizer *tokenizer,
+			 const gchar         *text,
+			 const gchar         *text_end,
+			 GArray              *rejected_lines)
+{
+	const gchar *line = text;
+	guint line_num;
+
+	g_return_if_fail (filter != NULL);
+	g_return_if_fail (tokenizer != NULL);
+	g_return_if_fail (rejected_lines != NULL);
+
+	for (line_num = 0; line < text_end; line_num++)
+	{
+		const gchar *line_end;
+		const gchar *next_line_start;
+
+		line_end = gcsv_tokenizer_find_line_end (line, text_end, &next_line_start);
+
+		if (!gcsv_filter_match_line (filter, tokenizer, line, line_end))
+		{
+			g_array_append_val (rejected_lines, line_num);
+		}
+
+		line = next_line_start;
+	}
+}
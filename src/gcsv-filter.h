@@ -0,0 +1,77 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_FILTER_H
+#define GCSV_FILTER_H
+
+#include <glib.h>
+#include "gcsv-tokenizer.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_FILTER_ERROR (gcsv_filter_error_quark ())
+
+typedef enum
+{
+	GCSV_FILTER_ERROR_INVALID_NUMBER,
+} GcsvFilterError;
+
+/**
+ * GcsvFilterMode:
+ * @GCSV_FILTER_MODE_SUBSTRING: the field contains the pattern.
+ * @GCSV_FILTER_MODE_REGEX: the field matches the regular expression.
+ * @GCSV_FILTER_MODE_NUMERIC: the field is a number satisfying a comparison,
+ *   like "> 10", "<= -2.5" or "!= 0". Without operator, it is an equality.
+ */
+typedef enum
+{
+	GCSV_FILTER_MODE_SUBSTRING,
+	GCSV_FILTER_MODE_REGEX,
+	GCSV_FILTER_MODE_NUMERIC,
+} GcsvFilterMode;
+
+typedef struct _GcsvFilter GcsvFilter;
+
+GQuark		gcsv_filter_error_quark		(void);
+
+GcsvFilter *	gcsv_filter_new			(GcsvFilterMode   mode,
+						 guint            column_num,
+						 const gchar     *pattern,
+						 GError         **error);
+
+GcsvFilter *	gcsv_filter_ref			(GcsvFilter *filter);
+
+void		gcsv_filter_unref		(GcsvFilter *filter);
+
+guint		gcsv_filter_get_column_num	(GcsvFilter *filter);
+
+gboolean	gcsv_filter_match_line		(GcsvFilter          *filter,
+						 const GcsvTokenizer *tokenizer,
+						 const gchar         *line,
+						 const gchar         *line_end);
+
+void		gcsv_filter_match_lines		(GcsvFilter          *filter,
+						 const GcsvTokenizer *tokenizer,
+						 const gchar         *text,
+						 const gchar         *text_end,
+						 GArray              *rejected_lines);
+
+G_END_DECLS
+
+#endif /* GCSV_FILTER_H */
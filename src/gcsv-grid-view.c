@@ -0,0 +1,872 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-grid-view.h"
+#include "gcsv-utils.h"
+
+/* A spreadsheet-like view of a GcsvRowModel, with one GtkEntry per field.
+ *
+ * Only the rows in the visible window have widgets: there is a pool of rows,
+ * as many as what fits in the allocation, and the entries are re-filled when
+ * scrolling or when the model changes. So the memory and the layout cost
+ * depend on the window size, not on the number of rows in the file. For the
+ * same reason the column widths are computed from the visible rows only.
+ *
+ * A modified entry is written back to the model when it is activated, when it
+ * loses the focus, or when it is recycled for another row.
+ */
+
+typedef struct _Cell Cell;
+typedef struct _PoolRow PoolRow;
+
+struct _Cell
+{
+	GcsvGridView *view;
+	GtkEntry *entry;
+
+	guint pool_row_num;
+	guint column_num;
+
+	/* The row displayed, valid only if has_field is set. */
+	guint row_num;
+
+	guint has_field : 1;
+
+	/* Whether the entry text has been modified by the user and not yet
+	 * written back to the model.
+	 */
+	guint modified : 1;
+};
+
+struct _PoolRow
+{
+	GtkLabel *row_num_label;
+
+	/* Element-type: Cell*. */
+	GPtrArray *cells;
+};
+
+struct _GcsvGridView
+{
+	GtkGrid parent;
+
+	GcsvRowModel *model;
+
+	GtkScrolledWindow *scrolled_window;
+	GtkGrid *cells_grid;
+
+	/* In rows. The horizontal scrolling is handled by the
+	 * GtkScrolledWindow.
+	 */
+	GtkAdjustment *vadjustment;
+
+	/* Element-type: PoolRow*. */
+	GPtrArray *pool;
+	guint n_pool_columns;
+
+	/* Number of rows that fit in the allocation, including a partially
+	 * visible one at the bottom.
+	 */
+	guint n_visible_rows;
+
+	gint row_height;
+
+	guint update_idle_id;
+
+	guint updating_cells : 1;
+};
+
+#define MAX_WIDTH_CHARS 40
+
+#define N_ROWS_PER_SCROLL_STEP 3
+
+/* Before the GTK+ redraw, so that all the changes of the same main loop
+ * iteration are coalesced.
+ */
+#define UPDATE_PRIORITY (G_PRIORITY_HIGH_IDLE + 10)
+
+G_DEFINE_TYPE (GcsvGridView, gcsv_grid_view, GTK_TYPE_GRID)
+
+/* Puts back the field content in the entry. */
+static void
+revert_cell (Cell *cell)
+{
+	GcsvGridView *view = cell->view;
+	GcsvRow *row;
+	const gchar *field;
+	gboolean updating_cells;
+
+	row = g_list_model_get_item (G_LIST_MODEL (view->model), cell->row_num);
+	if (row == NULL)
+	{
+		return;
+	}
+
+	field = gcsv_row_get_field (row, cell->column_num);
+
+	updating_cells = view->updating_cells;
+	view->updating_cells = TRUE;
+	gtk_entry_set_text (cell->entry, field != NULL ? field : "");
+	view->updating_cells = updating_cells;
+
+	g_object_unref (row);
+}
+
+static void
+commit_cell (Cell *cell)
+{
+	if (!cell->modified)
+	{
+		return;
+	}
+
+	cell->modified = FALSE;
+
+	/* For example when the text contains the delimiter. */
+	if (cell->has_field &&
+	    !gcsv_row_model_set_field (cell->view->model,
+				       cell->row_num,
+				       cell->column_num,
+				       gtk_entry_get_text (cell->entry)))
+	{
+		gtk_widget_error_bell (GTK_WIDGET (cell->entry));
+		revert_cell (cell);
+	}
+}
+
+static void
+cell_free (gpointer data)
+{
+	Cell *cell = data;
+
+	if (cell != NULL)
+	{
+		gtk_widget_destroy (GTK_WIDGET (cell->entry));
+		g_object_unref (cell->entry);
+		g_free (cell);
+	}
+}
+
+static void
+pool_row_free (gpointer data)
+{
+	PoolRow *pool_row = data;
+
+	if (pool_row != NULL)
+	{
+		g_ptr_array_unref (pool_row->cells);
+
+		gtk_widget_destroy (GTK_WIDGET (pool_row->row_num_label));
+		g_object_unref (pool_row->row_num_label);
+
+		g_free (pool_row);
+	}
+}
+
+static Cell *
+get_cell (GcsvGridView *view,
+	  guint         pool_row_num,
+	  guint         column_num)
+{
+	PoolRow *pool_row;
+
+	if (pool_row_num >= view->pool->len)
+	{
+		return NULL;
+	}
+
+	pool_row = g_ptr_array_index (view->pool, pool_row_num);
+	if (column_num >= pool_row->cells->len)
+	{
+		return NULL;
+	}
+
+	return g_ptr_array_index (pool_row->cells, column_num);
+}
+
+/* Calls commit_cell() on all cells. If @first_row_num is not -1, only on the
+ * cells that will display another row.
+ */
+static void
+commit_cells (GcsvGridView *view,
+	      gint          first_row_num)
+{
+	guint pool_row_num;
+
+	for (pool_row_num = 0; pool_row_num < view->pool->len; pool_row_num++)
+	{
+		PoolRow *pool_row = g_ptr_array_index (view->pool, pool_row_num);
+		guint column_num;
+
+		for (column_num = 0; column_num < pool_row->cells->len; column_num++)
+		{
+			Cell *cell = g_ptr_array_index (pool_row->cells, column_num);
+
+			if (first_row_num == -1 ||
+			    cell->row_num != first_row_num + pool_row_num)
+			{
+				commit_cell (cell);
+			}
+		}
+	}
+}
+
+static void
+gcsv_grid_view_dispose (GObject *object)
+{
+	GcsvGridView *view = GCSV_GRID_VIEW (object);
+
+	if (view->update_idle_id != 0)
+	{
+		g_source_remove (view->update_idle_id);
+		view->update_idle_id = 0;
+	}
+
+	if (view->pool != NULL)
+	{
+		if (view->model != NULL)
+		{
+			commit_cells (view, -1);
+		}
+
+		g_ptr_array_unref (view->pool);
+		view->pool = NULL;
+	}
+
+	g_clear_object (&view->model);
+	g_clear_object (&view->vadjustment);
+
+	G_OBJECT_CLASS (gcsv_grid_view_parent_class)->dispose (object);
+}
+
+static void
+gcsv_grid_view_class_init (GcsvGridViewClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gcsv_grid_view_dispose;
+}
+
+/* Number of rows entirely visible. */
+static guint
+get_page_size (GcsvGridView *view)
+{
+	return MAX (view->n_visible_rows, 2) - 1;
+}
+
+static void
+entry_changed_cb (GtkEditable *editable,
+		  Cell        *cell)
+{
+	if (!cell->view->updating_cells)
+	{
+		cell->modified = TRUE;
+	}
+}
+
+static void
+entry_activate_cb (GtkEntry *entry,
+		   Cell     *cell)
+{
+	commit_cell (cell);
+}
+
+static gboolean
+entry_focus_out_event_cb (GtkWidget     *entry,
+			  GdkEventFocus *event,
+			  Cell          *cell)
+{
+	commit_cell (cell);
+	return GDK_EVENT_PROPAGATE;
+}
+
+/* Moves the focus by @delta rows in the same column, scrolling if the target
+ * row is outside the visible window.
+ */
+static void
+move_focus (Cell *cell,
+	    gint  delta)
+{
+	GcsvGridView *view = cell->view;
+	gint page_size = get_page_size (view);
+	gint target_pool_row_num;
+	Cell *target_cell;
+
+	target_pool_row_num = (gint) cell->pool_row_num + delta;
+
+	if (target_pool_row_num < 0)
+	{
+		gcsv_utils_scroll_adjustment_by (view->vadjustment, target_pool_row_num);
+		target_pool_row_num = 0;
+	}
+	else if (target_pool_row_num >= page_size)
+	{
+		gcsv_utils_scroll_adjustment_by (view->vadjustment, target_pool_row_num - (page_size - 1));
+		target_pool_row_num = page_size - 1;
+	}
+
+	target_cell = get_cell (view, target_pool_row_num, cell->column_num);
+	if (target_cell != NULL && target_cell != cell)
+	{
+		gtk_widget_grab_focus (GTK_WIDGET (target_cell->entry));
+	}
+}
+
+static gboolean
+entry_key_press_event_cb (GtkWidget   *entry,
+			  GdkEventKey *event,
+			  Cell        *cell)
+{
+	gint page_size = get_page_size (cell->view);
+
+	switch (event->keyval)
+	{
+		case GDK_KEY_Up:
+			move_focus (cell, -1);
+			break;
+
+		case GDK_KEY_Down:
+			move_focus (cell, 1);
+			break;
+
+		case GDK_KEY_Page_Up:
+			move_focus (cell, -page_size);
+			break;
+
+		case GDK_KEY_Page_Down:
+			move_focus (cell, page_size);
+			break;
+
+		default:
+			return GDK_EVENT_PROPAGATE;
+	}
+
+	return GDK_EVENT_STOP;
+}
+
+static Cell *
+cell_new (GcsvGridView *view,
+	  guint         pool_row_num,
+	  guint         column_num)
+{
+	Cell *cell;
+
+	cell = g_new0 (Cell, 1);
+	cell->view = view;
+	cell->pool_row_num = pool_row_num;
+	cell->column_num = column_num;
+
+	cell->entry = GTK_ENTRY (gtk_entry_new ());
+	g_object_ref_sink (cell->entry);
+	gtk_editable_set_editable (GTK_EDITABLE (cell->entry),
+				   gcsv_row_model_is_editable (view->model));
+
+	g_signal_connect (cell->entry,
+			  "changed",
+			  G_CALLBACK (entry_changed_cb),
+			  cell);
+
+	g_signal_connect (cell->entry,
+			  "activate",
+			  G_CALLBACK (entry_activate_cb),
+			  cell);
+
+	g_signal_connect (cell->entry,
+			  "focus-out-event",
+			  G_CALLBACK (entry_focus_out_event_cb),
+			  cell);
+
+	g_signal_connect (cell->entry,
+			  "key-press-event",
+			  G_CALLBACK (entry_key_press_event_cb),
+			  cell);
+
+	/* The first grid column contains the row numbers. */
+	gtk_grid_attach (view->cells_grid,
+			 GTK_WIDGET (cell->entry),
+			 column_num + 1, pool_row_num,
+			 1, 1);
+
+	return cell;
+}
+
+static PoolRow *
+pool_row_new (GcsvGridView *view,
+	      guint         pool_row_num)
+{
+	PoolRow *pool_row;
+
+	pool_row = g_new0 (PoolRow, 1);
+	pool_row->cells = g_ptr_array_new_with_free_func (cell_free);
+
+	pool_row->row_num_label = GTK_LABEL (gtk_label_new (NULL));
+	g_object_ref_sink (pool_row->row_num_label);
+	gtk_label_set_xalign (pool_row->row_num_label, 1.0);
+	gtk_style_context_add_class (gtk_widget_get_style_context (GTK_WIDGET (pool_row->row_num_label)),
+				     GTK_STYLE_CLASS_DIM_LABEL);
+
+	gtk_grid_attach (view->cells_grid,
+			 GTK_WIDGET (pool_row->row_num_label),
+			 0, pool_row_num,
+			 1, 1);
+
+	return pool_row;
+}
+
+/* The number of columns only grows, to not re-create entries each time a
+ * narrower part of the file is scrolled to. Unneeded entries are hidden.
+ */
+static void
+ensure_pool_size (GcsvGridView *view,
+		  guint         n_rows,
+		  guint         n_columns)
+{
+	guint pool_row_num;
+
+	view->n_pool_columns = MAX (view->n_pool_columns, n_columns);
+
+	if (view->pool->len > n_rows)
+	{
+		for (pool_row_num = n_rows; pool_row_num < view->pool->len; pool_row_num++)
+		{
+			PoolRow *pool_row = g_ptr_array_index (view->pool, pool_row_num);
+
+			g_ptr_array_foreach (pool_row->cells, (GFunc) commit_cell, NULL);
+		}
+
+		g_ptr_array_remove_range (view->pool, n_rows, view->pool->len - n_rows);
+	}
+
+	for (pool_row_num = 0; pool_row_num < n_rows; pool_row_num++)
+	{
+		PoolRow *pool_row;
+
+		if (pool_row_num == view->pool->len)
+		{
+			g_ptr_array_add (view->pool, pool_row_new (view, pool_row_num));
+		}
+
+		pool_row = g_ptr_array_index (view->pool, pool_row_num);
+
+		while (pool_row->cells->len < view->n_pool_columns)
+		{
+			g_ptr_array_add (pool_row->cells,
+					 cell_new (view, pool_row_num, pool_row->cells->len));
+		}
+	}
+}
+
+static void
+update_cell (Cell        *cell,
+	     guint        row_num,
+	     const gchar *field)
+{
+	gint width_chars;
+
+	if (field == NULL)
+	{
+		cell->has_field = FALSE;
+		cell->modified = FALSE;
+		gtk_widget_hide (GTK_WIDGET (cell->entry));
+		return;
+	}
+
+	/* Don't overwrite what the user is typing. */
+	if (!(cell->modified && cell->has_field && cell->row_num == row_num))
+	{
+		if (g_strcmp0 (gtk_entry_get_text (cell->entry), field) != 0)
+		{
+			gtk_entry_set_text (cell->entry, field);
+		}
+
+		cell->modified = FALSE;
+	}
+
+	cell->row_num = row_num;
+	cell->has_field = TRUE;
+
+	width_chars = g_utf8_strlen (gtk_entry_get_text (cell->entry), -1);
+	width_chars = CLAMP (width_chars, 1, MAX_WIDTH_CHARS);
+	gtk_entry_set_width_chars (cell->entry, width_chars);
+	gtk_entry_set_max_width_chars (cell->entry, width_chars);
+
+	gtk_widget_show (GTK_WIDGET (cell->entry));
+}
+
+static void
+update_cells (GcsvGridView *view)
+{
+	guint first_row_num;
+	GPtrArray *rows;
+	guint max_n_fields = 1;
+	guint pool_row_num;
+
+	first_row_num = gtk_adjustment_get_value (view->vadjustment);
+
+	/* Before decoding the rows, since it modifies the model. */
+	commit_cells (view, first_row_num);
+
+	rows = g_ptr_array_new_with_free_func (g_object_unref);
+
+	for (pool_row_num = 0; pool_row_num < view->n_visible_rows; pool_row_num++)
+	{
+		GcsvRow *row;
+
+		row = g_list_model_get_item (G_LIST_MODEL (view->model), first_row_num + pool_row_num);
+		if (row == NULL)
+		{
+			break;
+		}
+
+		max_n_fields = MAX (max_n_fields, gcsv_row_get_n_fields (row));
+		g_ptr_array_add (rows, row);
+	}
+
+	ensure_pool_size (view, view->n_visible_rows, max_n_fields);
+
+	view->updating_cells = TRUE;
+
+	for (pool_row_num = 0; pool_row_num < view->pool->len; pool_row_num++)
+	{
+		PoolRow *pool_row = g_ptr_array_index (view->pool, pool_row_num);
+		GcsvRow *row = NULL;
+		guint row_num = first_row_num + pool_row_num;
+		guint column_num;
+
+		if (pool_row_num < rows->len)
+		{
+			gchar *row_num_str;
+
+			row = g_ptr_array_index (rows, pool_row_num);
+
+			/* Numbered from 1, like the line numbers in the
+			 * GtkTextView.
+			 */
+			row_num_str = g_strdup_printf ("%u", row_num + 1);
+			gtk_label_set_text (pool_row->row_num_label, row_num_str);
+			gtk_widget_show (GTK_WIDGET (pool_row->row_num_label));
+			g_free (row_num_str);
+		}
+		else
+		{
+			gtk_widget_hide (GTK_WIDGET (pool_row->row_num_label));
+		}
+
+		for (column_num = 0; column_num < pool_row->cells->len; column_num++)
+		{
+			Cell *cell = g_ptr_array_index (pool_row->cells, column_num);
+			const gchar *field = NULL;
+
+			if (row != NULL)
+			{
+				field = gcsv_row_get_field (row, column_num);
+			}
+
+			update_cell (cell, row_num, field);
+		}
+	}
+
+	view->updating_cells = FALSE;
+
+	g_ptr_array_unref (rows);
+}
+
+static void
+update_adjustment (GcsvGridView *view)
+{
+	guint n_items;
+	guint page_size;
+
+	n_items = g_list_model_get_n_items (G_LIST_MODEL (view->model));
+	page_size = get_page_size (view);
+
+	gtk_adjustment_configure (view->vadjustment,
+				  gtk_adjustment_get_value (view->vadjustment),
+				  0,
+				  n_items,
+				  1,
+				  page_size,
+				  page_size);
+}
+
+static gboolean
+update_idle_cb (gpointer user_data)
+{
+	GcsvGridView *view = GCSV_GRID_VIEW (user_data);
+
+	view->update_idle_id = 0;
+
+	update_adjustment (view);
+	update_cells (view);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+queue_update (GcsvGridView *view)
+{
+	if (view->update_idle_id == 0)
+	{
+		view->update_idle_id = g_idle_add_full (UPDATE_PRIORITY,
+							update_idle_cb,
+							view,
+							NULL);
+	}
+}
+
+/* When rows are inserted or removed before them, the cells keep the rows that
+ * they display, so that a modified entry is written back to the right row. A
+ * modification of a row that is removed is lost.
+ */
+static void
+shift_cells (GcsvGridView *view,
+	     guint         position,
+	     guint         n_removed,
+	     guint         n_added)
+{
+	guint pool_row_num;
+
+	for (pool_row_num = 0; pool_row_num < view->pool->len; pool_row_num++)
+	{
+		PoolRow *pool_row = g_ptr_array_index (view->pool, pool_row_num);
+		guint column_num;
+
+		for (column_num = 0; column_num < pool_row->cells->len; column_num++)
+		{
+			Cell *cell = g_ptr_array_index (pool_row->cells, column_num);
+
+			if (!cell->has_field || cell->row_num < position)
+			{
+				continue;
+			}
+
+			if (cell->row_num >= position + n_removed)
+			{
+				cell->row_num = cell->row_num - n_removed + n_added;
+			}
+			else
+			{
+				cell->has_field = FALSE;
+				cell->modified = FALSE;
+			}
+		}
+	}
+}
+
+static void
+items_changed_cb (GListModel   *model,
+		  guint         position,
+		  guint         n_removed,
+		  guint         n_added,
+		  GcsvGridView *view)
+{
+	guint first_row_num;
+
+	if (n_removed != n_added)
+	{
+		shift_cells (view, position, n_removed, n_added);
+		queue_update (view);
+		return;
+	}
+
+	first_row_num = gtk_adjustment_get_value (view->vadjustment);
+
+	if (position < first_row_num + view->n_visible_rows &&
+	    position + n_added > first_row_num)
+	{
+		queue_update (view);
+	}
+}
+
+static void
+adjustment_value_changed_cb (GtkAdjustment *adjustment,
+			     GcsvGridView  *view)
+{
+	queue_update (view);
+}
+
+static void
+scrolled_window_size_allocate_cb (GtkWidget     *scrolled_window,
+				  GdkRectangle  *allocation,
+				  GcsvGridView  *view)
+{
+	guint n_visible_rows;
+
+	n_visible_rows = allocation->height / view->row_height + 1;
+
+	if (n_visible_rows != view->n_visible_rows)
+	{
+		view->n_visible_rows = n_visible_rows;
+
+		/* The pool can not be resized during the size allocation. */
+		queue_update (view);
+	}
+}
+
+static gboolean
+scrolled_window_scroll_event_cb (GtkWidget      *scrolled_window,
+				 GdkEventScroll *event,
+				 GcsvGridView   *view)
+{
+	gdouble delta_x = 0.0;
+	gdouble delta_y = 0.0;
+
+	switch (event->direction)
+	{
+		case GDK_SCROLL_UP:
+			delta_y = -1.0;
+			break;
+
+		case GDK_SCROLL_DOWN:
+			delta_y = 1.0;
+			break;
+
+		case GDK_SCROLL_SMOOTH:
+			gdk_event_get_scroll_deltas ((GdkEvent *) event, &delta_x, &delta_y);
+			break;
+
+		default:
+			return GDK_EVENT_PROPAGATE;
+	}
+
+	/* The horizontal scrolling is done by the GtkScrolledWindow. */
+	if (delta_y == 0.0 || (event->state & GDK_SHIFT_MASK) != 0)
+	{
+		return GDK_EVENT_PROPAGATE;
+	}
+
+	gcsv_utils_scroll_adjustment_by (view->vadjustment, delta_y * N_ROWS_PER_SCROLL_STEP);
+	return GDK_EVENT_STOP;
+}
+
+static gint
+get_row_height (void)
+{
+	GtkWidget *entry;
+	gint row_height = 0;
+
+	entry = gtk_entry_new ();
+	g_object_ref_sink (entry);
+	gtk_widget_get_preferred_height (entry, NULL, &row_height);
+	gtk_widget_destroy (entry);
+	g_object_unref (entry);
+
+	return MAX (row_height, 1);
+}
+
+static void
+gcsv_grid_view_init (GcsvGridView *view)
+{
+	GtkWidget *scrollbar;
+
+	view->pool = g_ptr_array_new_with_free_func (pool_row_free);
+	view->row_height = get_row_height ();
+	view->n_visible_rows = 1;
+
+	view->cells_grid = GTK_GRID (gtk_grid_new ());
+	gtk_widget_set_halign (GTK_WIDGET (view->cells_grid), GTK_ALIGN_START);
+	gtk_widget_set_valign (GTK_WIDGET (view->cells_grid), GTK_ALIGN_START);
+	gtk_grid_set_column_spacing (view->cells_grid, 6);
+	gtk_widget_show (GTK_WIDGET (view->cells_grid));
+
+	/* With GTK_POLICY_EXTERNAL, the GtkScrolledWindow doesn't request the
+	 * height of the pool, it clips it. The vertical scrolling is done by
+	 * re-filling the pool.
+	 */
+	view->scrolled_window = GTK_SCROLLED_WINDOW (gtk_scrolled_window_new (NULL, NULL));
+	gtk_scrolled_window_set_policy (view->scrolled_window,
+					GTK_POLICY_AUTOMATIC,
+					GTK_POLICY_EXTERNAL);
+	gtk_widget_set_hexpand (GTK_WIDGET (view->scrolled_window), TRUE);
+	gtk_widget_set_vexpand (GTK_WIDGET (view->scrolled_window), TRUE);
+	gtk_container_add (GTK_CONTAINER (view->scrolled_window), GTK_WIDGET (view->cells_grid));
+	gtk_widget_show (GTK_WIDGET (view->scrolled_window));
+
+	g_signal_connect (view->scrolled_window,
+			  "size-allocate",
+			  G_CALLBACK (scrolled_window_size_allocate_cb),
+			  view);
+
+	g_signal_connect (view->scrolled_window,
+			  "scroll-event",
+			  G_CALLBACK (scrolled_window_scroll_event_cb),
+			  view);
+
+	view->vadjustment = gtk_adjustment_new (0, 0, 0, 1, 1, 1);
+	g_object_ref_sink (view->vadjustment);
+
+	g_signal_connect (view->vadjustment,
+			  "value-changed",
+			  G_CALLBACK (adjustment_value_changed_cb),
+			  view);
+
+	scrollbar = gtk_scrollbar_new (GTK_ORIENTATION_VERTICAL, view->vadjustment);
+	gtk_widget_show (scrollbar);
+
+	gtk_grid_attach (GTK_GRID (view), GTK_WIDGET (view->scrolled_window), 0, 0, 1, 1);
+	gtk_grid_attach (GTK_GRID (view), scrollbar, 1, 0, 1, 1);
+}
+
+GcsvGridView *
+gcsv_grid_view_new (GcsvRowModel *model)
+{
+	GcsvGridView *view;
+
+	g_return_val_if_fail (GCSV_IS_ROW_MODEL (model), NULL);
+
+	view = g_object_new (GCSV_TYPE_GRID_VIEW, NULL);
+	view->model = g_object_ref (model);
+
+	g_signal_connect_object (model,
+				 "items-changed",
+				 G_CALLBACK (items_changed_cb),
+				 view,
+				 0);
+
+	queue_update (view);
+
+	return view;
+}
+
+GcsvRowModel *
+gcsv_grid_view_get_model (GcsvGridView *view)
+{
+	g_return_val_if_fail (GCSV_IS_GRID_VIEW (view), NULL);
+
+	return view->model;
+}
+
+guint
+gcsv_grid_view_get_first_visible_row (GcsvGridView *view)
+{
+	g_return_val_if_fail (GCSV_IS_GRID_VIEW (view), 0);
+
+	return gtk_adjustment_get_value (view->vadjustment);
+}
+
+void
+gcsv_grid_view_scroll_to_row (GcsvGridView *view,
+			      guint         row_num)
+{
+	g_return_if_fail (GCSV_IS_GRID_VIEW (view));
+
+	/* The adjustment upper bound may not be up-to-date yet. */
+	update_adjustment (view);
+	gtk_adjustment_set_value (view->vadjustment, row_num);
+}
@@ -0,0 +1,44 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_GRID_VIEW_H
+#define GCSV_GRID_VIEW_H
+
+#include <gtk/gtk.h>
+#include "gcsv-row-model.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_GRID_VIEW (gcsv_grid_view_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvGridView, gcsv_grid_view,
+		      GCSV, GRID_VIEW,
+		      GtkGrid)
+
+GcsvGridView *		gcsv_grid_view_new			(GcsvRowModel *model);
+
+GcsvRowModel *		gcsv_grid_view_get_model		(GcsvGridView *view);
+
+guint			gcsv_grid_view_get_first_visible_row	(GcsvGridView *view);
+
+void			gcsv_grid_view_scroll_to_row		(GcsvGridView *view,
+								 guint         row_num);
+
+G_END_DECLS
+
+#endif /* GCSV_GRID_VIEW_H */
@@ -0,0 +1,1299 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-journal-writer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include "gcsv-journal.h"
+
+/* Records the user edits in a journal file next to the document, so that
+ * they can be recovered after a crash, without rewriting the whole document
+ * regularly.
+ *
+ * Each edit is appended to the journal as a small record, see gcsv-journal.c.
+ * The positions are in the text without the virtual spaces, and the edits
+ * done by GcsvAlignment are not recorded, so the journal applies to the file
+ * on disk. The records are kept in memory and written by a worker thread in
+ * batches, every FLUSH_INTERVAL_MS, followed by an fsync(). So a keystroke
+ * costs only the encoding of the record.
+ *
+ * When the document is saved, the records up to the snapshot of the save are
+ * in the file, so the journal is rewritten with only the records done during
+ * the save, or removed. When the document is closed normally, the journal is
+ * removed too.
+ *
+ * The journal of "/dir/data.csv" is "/dir/.data.csv.gcsv-journal". Only local
+ * files have a journal.
+ */
+
+struct _GcsvJournalWriter
+{
+	GObject parent;
+
+	GcsvBuffer *buffer;
+	GFile *location;
+
+	/* NULL if the file is not local, then nothing is recorded. */
+	gchar *path;
+
+	/* The journal of the previous location, removed by the next write. */
+	gchar *old_path;
+
+	/* The records not written yet. */
+	GString *pending;
+
+	/* Non-NULL during a save: the records since the snapshot. */
+	GString *since_save;
+
+	/* The GTask's of gcsv_journal_writer_flush_async() waiting for the
+	 * next write.
+	 */
+	GList *flush_tasks;
+
+	/* The size and modification time of the file on disk, for the header
+	 * of the journal. Unknown after a save, until the next rewrite.
+	 */
+	guint64 base_size;
+	guint64 base_mtime;
+	guint base_serial;
+
+	guint flush_timeout_id;
+
+	/* The next write replaces the whole journal, or removes it if there
+	 * is no pending records.
+	 */
+	guint rewrite : 1;
+
+	guint base_known : 1;
+	guint journal_exists : 1;
+	guint writing : 1;
+	guint replaying : 1;
+	guint in_replace_lines : 1;
+
+	/* No records are kept, until the next save. For example when a record
+	 * is too big.
+	 */
+	guint suspended : 1;
+
+	/* Whether @since_save contains all the records since the snapshot. */
+	guint since_save_complete : 1;
+
+	guint discarded : 1;
+};
+
+typedef struct _WriteData WriteData;
+struct _WriteData
+{
+	GFile *location;
+	gchar *path;
+	gchar *old_path;
+	GBytes *records;
+	GList *flush_tasks;
+
+	guint64 base_size;
+	guint64 base_mtime;
+	guint base_serial;
+
+	guint rewrite : 1;
+	guint base_known : 1;
+};
+
+typedef struct _RecoverData RecoverData;
+struct _RecoverData
+{
+	GFile *location;
+	gchar *path;
+
+	/* Filled by the thread. */
+	guint64 base_size;
+	guint64 base_mtime;
+	gchar *contents;
+	gsize length;
+	guint journal_exists : 1;
+};
+
+enum
+{
+	PROP_0,
+	PROP_BUFFER,
+	PROP_LOCATION,
+};
+
+#define FLUSH_INTERVAL_MS 1000
+
+/* Bigger edits, for example a sort of a big file, are not recorded: writing
+ * them would cost as much as saving the document.
+ */
+#define MAX_RECORD_LENGTH (64 * 1024 * 1024)
+
+#define JOURNAL_SUFFIX ".gcsv-journal"
+
+#define BASE_ATTRIBUTES			\
+	G_FILE_ATTRIBUTE_STANDARD_SIZE ","	\
+	G_FILE_ATTRIBUTE_TIME_MODIFIED ","	\
+	G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+G_DEFINE_TYPE (GcsvJournalWriter, gcsv_journal_writer, G_TYPE_OBJECT)
+
+static void write_next (GcsvJournalWriter *writer);
+
+static gchar *
+get_journal_path (GFile *location)
+{
+	gchar *document_path;
+	gchar *dirname;
+	gchar *basename;
+	gchar *journal_basename;
+	gchar *journal_path;
+
+	document_path = g_file_get_path (location);
+	if (document_path == NULL)
+	{
+		return NULL;
+	}
+
+	dirname = g_path_get_dirname (document_path);
+	basename = g_path_get_basename (document_path);
+	journal_basename = g_strconcat (".", basename, JOURNAL_SUFFIX, NULL);
+	journal_path = g_build_filename (dirname, journal_basename, NULL);
+
+	g_free (document_path);
+	g_free (dirname);
+	g_free (basename);
+	g_free (journal_basename);
+	return journal_path;
+}
+
+static gboolean
+query_base (GFile         *location,
+	    guint64       *base_size,
+	    guint64       *base_mtime,
+	    GCancellable  *cancellable,
+	    GError       **error)
+{
+	GFileInfo *info;
+
+	info = g_file_query_info (location,
+				  BASE_ATTRIBUTES,
+				  G_FILE_QUERY_INFO_NONE,
+				  cancellable,
+				  error);
+	if (info == NULL)
+	{
+		return FALSE;
+	}
+
+	*base_size = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+	*base_mtime = (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+		       g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC));
+
+	g_object_unref (info);
+	return TRUE;
+}
+
+static void
+set_errno_error (GError      **error,
+		 gint          saved_errno,
+		 const gchar  *path)
+{
+	g_set_error (error,
+		     G_FILE_ERROR,
+		     g_file_error_from_errno (saved_errno),
+		     "%s: %s",
+		     path,
+		     g_strerror (saved_errno));
+}
+
+/* Writes @data to @path and calls fsync(). */
+static gboolean
+write_to_file (const gchar  *path,
+	       gint          flags,
+	       const gchar  *data,
+	       gsize         length,
+	       GError      **error)
+{
+	gint fd;
+
+	fd = g_open (path, flags | O_WRONLY | O_CREAT, 0600);
+	if (fd == -1)
+	{
+		set_errno_error (error, errno, path);
+		return FALSE;
+	}
+
+	while (length > 0)
+	{
+		gssize n_written = write (fd, data, length);
+
+		if (n_written < 0)
+		{
+			gint saved_errno = errno;
+
+			if (saved_errno == EINTR)
+			{
+				continue;
+			}
+
+			set_errno_error (error, saved_errno, path);
+			close (fd);
+			return FALSE;
+		}
+
+		data += n_written;
+		length -= n_written;
+	}
+
+	if (fsync (fd) != 0 || close (fd) != 0)
+	{
+		set_errno_error (error, errno, path);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+remove_file (const gchar  *path,
+	     GError      **error)
+{
+	if (g_unlink (path) != 0 && errno != ENOENT)
+	{
+		set_errno_error (error, errno, path);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Writes the header and the records to a temporary file, renamed afterwards,
+ * so that a crash during the rewrite keeps the previous journal.
+ */
+static gboolean
+rewrite_journal (WriteData     *data,
+		 GCancellable  *cancellable,
+		 GError       **error)
+{
+	const gchar *records;
+	gsize length;
+	GString *journal;
+	gchar *tmp_path;
+	gboolean ok;
+
+	records = g_bytes_get_data (data->records, &length);
+
+	if (length == 0)
+	{
+		return remove_file (data->path, error);
+	}
+
+	if (!data->base_known)
+	{
+		if (!query_base (data->location, &data->base_size, &data->base_mtime, cancellable, error))
+		{
+			return FALSE;
+		}
+
+		data->base_known = TRUE;
+	}
+
+	journal = g_string_sized_new (length + 32);
+	gcsv_journal_append_header (journal, data->base_size, data->base_mtime);
+	g_string_append_len (journal, records, length);
+
+	tmp_path = g_strconcat (data->path, ".tmp", NULL);
+
+	ok = write_to_file (tmp_path, O_TRUNC, journal->str, journal->len, error);
+
+	if (ok && g_rename (tmp_path, data->path) != 0)
+	{
+		set_errno_error (error, errno, data->path);
+		ok = FALSE;
+	}
+
+	if (!ok)
+	{
+		g_unlink (tmp_path);
+	}
+
+	g_free (tmp_path);
+	g_string_free (journal, TRUE);
+	return ok;
+}
+
+static void
+write_thread (GTask        *task,
+	      gpointer      source_object,
+	      gpointer      task_data,
+	      GCancellable *cancellable)
+{
+	WriteData *data = task_data;
+	gboolean ok;
+	GError *error = NULL;
+
+	if (data->old_path != NULL &&
+	    !remove_file (data->old_path, &error))
+	{
+		g_task_return_error (task, error);
+		return;
+	}
+
+	if (data->rewrite)
+	{
+		ok = rewrite_journal (data, cancellable, &error);
+	}
+	else
+	{
+		const gchar *records;
+		gsize length;
+
+		records = g_bytes_get_data (data->records, &length);
+		ok = write_to_file (data->path, O_APPEND, records, length, &error);
+	}
+
+	if (ok)
+	{
+		g_task_return_boolean (task, TRUE);
+	}
+	else
+	{
+		g_task_return_error (task, error);
+	}
+}
+
+static void
+write_data_free (gpointer data)
+{
+	WriteData *write_data = data;
+
+	if (write_data != NULL)
+	{
+		g_object_unref (write_data->location);
+		g_free (write_data->path);
+		g_free (write_data->old_path);
+		g_bytes_unref (write_data->records);
+		g_free (write_data);
+	}
+}
+
+static void
+complete_flush_tasks (GList        *flush_tasks,
+		      const GError *error)
+{
+	GList *l;
+
+	for (l = flush_tasks; l != NULL; l = l->next)
+	{
+		GTask *task = G_TASK (l->data);
+
+		if (error != NULL)
+		{
+			g_task_return_error (task, g_error_copy (error));
+		}
+		else
+		{
+			g_task_return_boolean (task, TRUE);
+		}
+
+		g_object_unref (task);
+	}
+
+	g_list_free (flush_tasks);
+}
+
+/* The journal is removed and no records are kept, until the next save. */
+static void
+suspend (GcsvJournalWriter *writer)
+{
+	writer->suspended = TRUE;
+	writer->rewrite = TRUE;
+	g_string_truncate (writer->pending, 0);
+
+	write_next (writer);
+}
+
+static void
+write_cb (GObject      *source_object,
+	  GAsyncResult *result,
+	  gpointer      user_data)
+{
+	GcsvJournalWriter *writer = GCSV_JOURNAL_WRITER (source_object);
+	GTask *task = G_TASK (result);
+	WriteData *data = g_task_get_task_data (task);
+	GError *error = NULL;
+
+	writer->writing = FALSE;
+
+	if (g_task_propagate_boolean (task, &error))
+	{
+		if (data->rewrite)
+		{
+			writer->journal_exists = g_bytes_get_size (data->records) > 0;
+
+			/* Unless the base has changed during the write. */
+			if (data->base_known &&
+			    data->base_serial == writer->base_serial)
+			{
+				writer->base_size = data->base_size;
+				writer->base_mtime = data->base_mtime;
+				writer->base_known = TRUE;
+			}
+		}
+	}
+	else
+	{
+		g_warning ("Failed to write the journal of the document: %s", error->message);
+
+		/* Not retried until the next save. */
+		writer->journal_exists = FALSE;
+		writer->suspended = TRUE;
+		writer->rewrite = TRUE;
+		g_string_truncate (writer->pending, 0);
+	}
+
+	complete_flush_tasks (data->flush_tasks, error);
+	data->flush_tasks = NULL;
+	g_clear_error (&error);
+
+	/* What has been requested during the write. The other pending
+	 * records wait for the flush timeout.
+	 */
+	if (writer->flush_tasks != NULL ||
+	    (writer->rewrite && writer->journal_exists) ||
+	    (writer->pending->len > 0 && writer->flush_timeout_id == 0) ||
+	    writer->old_path != NULL)
+	{
+		write_next (writer);
+	}
+}
+
+static void
+write_next (GcsvJournalWriter *writer)
+{
+	WriteData *data;
+	GTask *task;
+
+	if (writer->writing)
+	{
+		return;
+	}
+
+	if (writer->path == NULL ||
+	    (writer->pending->len == 0 &&
+	     !(writer->rewrite && writer->journal_exists) &&
+	     writer->old_path == NULL))
+	{
+		complete_flush_tasks (writer->flush_tasks, NULL);
+		writer->flush_tasks = NULL;
+		return;
+	}
+
+	data = g_new0 (WriteData, 1);
+	data->location = g_object_ref (writer->location);
+	data->path = g_strdup (writer->path);
+	data->old_path = writer->old_path;
+	writer->old_path = NULL;
+	data->records = g_bytes_new (writer->pending->str, writer->pending->len);
+	data->flush_tasks = writer->flush_tasks;
+	writer->flush_tasks = NULL;
+
+	data->rewrite = writer->rewrite;
+	data->base_known = writer->base_known;
+	data->base_size = writer->base_size;
+	data->base_mtime = writer->base_mtime;
+	data->base_serial = writer->base_serial;
+
+	/* After a removal, the next records need a header again. */
+	if (writer->pending->len > 0)
+	{
+		writer->rewrite = FALSE;
+	}
+
+	g_string_truncate (writer->pending, 0);
+	writer->writing = TRUE;
+
+	task = g_task_new (writer, NULL, write_cb, NULL);
+	g_task_set_task_data (task, data, write_data_free);
+	g_task_run_in_thread (task, write_thread);
+	g_object_unref (task);
+}
+
+static gboolean
+flush_timeout_cb (gpointer user_data)
+{
+	GcsvJournalWriter *writer = GCSV_JOURNAL_WRITER (user_data);
+
+	/* The records are written in the next batch. */
+	if (writer->writing)
+	{
+		return G_SOURCE_CONTINUE;
+	}
+
+	writer->flush_timeout_id = 0;
+	write_next (writer);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+is_recording (GcsvJournalWriter *writer)
+{
+	if (writer->path == NULL ||
+	    writer->discarded ||
+	    writer->replaying ||
+	    writer->in_replace_lines ||
+	    gcsv_buffer_is_virtual_spaces_edit (writer->buffer))
+	{
+		return FALSE;
+	}
+
+	return (!writer->suspended ||
+		(writer->since_save != NULL && writer->since_save_complete));
+}
+
+static void
+add_record (GcsvJournalWriter *writer,
+	    GcsvJournalOp      op,
+	    guint              line,
+	    guint64            offset,
+	    const gchar       *text,
+	    gsize              length)
+{
+	GcsvJournalRecord record;
+
+	if (length > MAX_RECORD_LENGTH)
+	{
+		writer->since_save_complete = FALSE;
+
+		if (!writer->suspended)
+		{
+			suspend (writer);
+		}
+
+		return;
+	}
+
+	record.op = op;
+	record.line = line;
+	record.offset = offset;
+	record.text = text;
+	record.length = length;
+
+	if (writer->since_save != NULL && writer->since_save_complete)
+	{
+		gcsv_journal_append_record (writer->since_save, &record);
+	}
+
+	if (writer->suspended)
+	{
+		return;
+	}
+
+	gcsv_journal_append_record (writer->pending, &record);
+
+	if (writer->flush_timeout_id == 0)
+	{
+		writer->flush_timeout_id = g_timeout_add (FLUSH_INTERVAL_MS, flush_timeout_cb, writer);
+	}
+}
+
+static void
+insert_text_cb (GtkTextBuffer     *buffer,
+		GtkTextIter       *location,
+		const gchar       *text,
+		gint               length,
+		GcsvJournalWriter *writer)
+{
+	if (!is_recording (writer) || length == 0)
+	{
+		return;
+	}
+
+	add_record (writer,
+		    GCSV_JOURNAL_OP_INSERT,
+		    gtk_text_iter_get_line (location),
+		    gcsv_buffer_get_line_index_without_virtual_spaces (writer->buffer, location),
+		    text,
+		    length);
+}
+
+static void
+delete_range_cb (GtkTextBuffer     *buffer,
+		 GtkTextIter       *start,
+		 GtkTextIter       *end,
+		 GcsvJournalWriter *writer)
+{
+	gchar *text;
+
+	if (!is_recording (writer))
+	{
+		return;
+	}
+
+	text = gcsv_buffer_get_text_without_virtual_spaces (writer->buffer, start, end);
+
+	/* Only virtual spaces. */
+	if (text[0] != '\0')
+	{
+		add_record (writer,
+			    GCSV_JOURNAL_OP_DELETE,
+			    gtk_text_iter_get_line (start),
+			    gcsv_buffer_get_line_index_without_virtual_spaces (writer->buffer, start),
+			    text,
+			    strlen (text));
+	}
+
+	g_free (text);
+}
+
+static void
+replace_lines_cb (GcsvBuffer        *buffer,
+		  guint              start_line,
+		  guint              n_lines,
+		  const gchar       *text,
+		  GArray            *column_map,
+		  GArray            *column_lengths,
+		  GcsvJournalWriter *writer)
+{
+	if (is_recording (writer))
+	{
+		add_record (writer,
+			    GCSV_JOURNAL_OP_REPLACE_LINES,
+			    start_line,
+			    n_lines,
+			    text,
+			    strlen (text));
+	}
+
+	/* The edits done by the replacement are part of this record. */
+	writer->in_replace_lines = TRUE;
+}
+
+static void
+replace_lines_after_cb (GcsvBuffer        *buffer,
+			guint              start_line,
+			guint              n_lines,
+			const gchar       *text,
+			GArray            *column_map,
+			GArray            *column_lengths,
+			GcsvJournalWriter *writer)
+{
+	writer->in_replace_lines = FALSE;
+}
+
+static void
+gcsv_journal_writer_get_property (GObject    *object,
+				  guint       prop_id,
+				  GValue     *value,
+				  GParamSpec *pspec)
+{
+	GcsvJournalWriter *writer = GCSV_JOURNAL_WRITER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_value_set_object (value, writer->buffer);
+			break;
+
+		case PROP_LOCATION:
+			g_value_set_object (value, writer->location);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_journal_writer_set_property (GObject      *object,
+				  guint         prop_id,
+				  const GValue *value,
+				  GParamSpec   *pspec)
+{
+	GcsvJournalWriter *writer = GCSV_JOURNAL_WRITER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_assert (writer->buffer == NULL);
+			writer->buffer = g_value_dup_object (value);
+			break;
+
+		case PROP_LOCATION:
+			g_assert (writer->location == NULL);
+			writer->location = g_value_dup_object (value);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_journal_writer_constructed (GObject *object)
+{
+	GcsvJournalWriter *writer = GCSV_JOURNAL_WRITER (object);
+
+	G_OBJECT_CLASS (gcsv_journal_writer_parent_class)->constructed (object);
+
+	writer->path = get_journal_path (writer->location);
+
+	/* Before the default handlers, to have the locations before the
+	 * edits.
+	 */
+	g_signal_connect_object (writer->buffer,
+				 "insert-text",
+				 G_CALLBACK (insert_text_cb),
+				 writer,
+				 0);
+
+	g_signal_connect_object (writer->buffer,
+				 "delete-range",
+				 G_CALLBACK (delete_range_cb),
+				 writer,
+				 0);
+
+	g_signal_connect_object (writer->buffer,
+				 "replace-lines",
+				 G_CALLBACK (replace_lines_cb),
+				 writer,
+				 0);
+
+	g_signal_connect_object (writer->buffer,
+				 "replace-lines",
+				 G_CALLBACK (replace_lines_after_cb),
+				 writer,
+				 G_CONNECT_AFTER);
+}
+
+static void
+gcsv_journal_writer_dispose (GObject *object)
+{
+	GcsvJournalWriter *writer = GCSV_JOURNAL_WRITER (object);
+
+	if (writer->flush_timeout_id != 0)
+	{
+		g_source_remove (writer->flush_timeout_id);
+		writer->flush_timeout_id = 0;
+	}
+
+	g_clear_object (&writer->buffer);
+	g_clear_object (&writer->location);
+
+	G_OBJECT_CLASS (gcsv_journal_writer_parent_class)->dispose (object);
+}
+
+static void
+gcsv_journal_writer_finalize (GObject *object)
+{
+	GcsvJournalWriter *writer = GCSV_JOURNAL_WRITER (object);
+
+	g_free (writer->path);
+	g_free (writer->old_path);
+	g_string_free (writer->pending, TRUE);
+
+	if (writer->since_save != NULL)
+	{
+		g_string_free (writer->since_save, TRUE);
+	}
+
+	G_OBJECT_CLASS (gcsv_journal_writer_parent_class)->finalize (object);
+}
+
+static void
+gcsv_journal_writer_class_init (GcsvJournalWriterClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_journal_writer_get_property;
+	object_class->set_property = gcsv_journal_writer_set_property;
+	object_class->constructed = gcsv_journal_writer_constructed;
+	object_class->dispose = gcsv_journal_writer_dispose;
+	object_class->finalize = gcsv_journal_writer_finalize;
+
+	g_object_class_install_property (object_class,
+					 PROP_BUFFER,
+					 g_param_spec_object ("buffer",
+							      "Buffer",
+							      "",
+							      GCSV_TYPE_BUFFER,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (object_class,
+					 PROP_LOCATION,
+					 g_param_spec_object ("location",
+							      "Location",
+							      "",
+							      G_TYPE_FILE,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gcsv_journal_writer_init (GcsvJournalWriter *writer)
+{
+	writer->pending = g_string_new (NULL);
+	writer->rewrite = TRUE;
+}
+
+/* The buffer must contain the file content, i.e. the file has just been loaded
+ * or saved, and GcsvAlignment must not be enabled yet if
+ * gcsv_journal_writer_recover_async() is called.
+ */
+GcsvJournalWriter *
+gcsv_journal_writer_new (GcsvBuffer *buffer,
+			 GFile      *location)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+	g_return_val_if_fail (G_IS_FILE (location), NULL);
+
+	return g_object_new (GCSV_TYPE_JOURNAL_WRITER,
+			     "buffer", buffer,
+			     "location", location,
+			     NULL);
+}
+
+static void
+recover_data_free (gpointer data)
+{
+	RecoverData *recover_data = data;
+
+	if (recover_data != NULL)
+	{
+		g_object_unref (recover_data->location);
+		g_free (recover_data->path);
+		g_free (recover_data->contents);
+		g_free (recover_data);
+	}
+}
+
+static void
+recover_thread (GTask        *task,
+		gpointer      source_object,
+		gpointer      task_data,
+		GCancellable *cancellable)
+{
+	RecoverData *data = task_data;
+	GError *error = NULL;
+
+	if (!query_base (data->location, &data->base_size, &data->base_mtime, cancellable, &error))
+	{
+		g_task_return_error (task, error);
+		return;
+	}
+
+	if (data->path != NULL &&
+	    g_file_get_contents (data->path, &data->contents, &data->length, NULL))
+	{
+		data->journal_exists = TRUE;
+	}
+
+	g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+get_iter_at_line_index (GtkTextBuffer *buffer,
+			guint          line,
+			guint64        index,
+			GtkTextIter   *iter)
+{
+	GtkTextIter line_end;
+	gchar *line_text;
+	gboolean valid;
+
+	if (line >= (guint) gtk_text_buffer_get_line_count (buffer))
+	{
+		return FALSE;
+	}
+
+	gtk_text_buffer_get_iter_at_line (buffer, iter, line);
+
+	line_end = *iter;
+	if (!gtk_text_iter_ends_line (&line_end))
+	{
+		gtk_text_iter_forward_to_line_end (&line_end);
+	}
+
+	line_text = gtk_text_buffer_get_text (buffer, iter, &line_end, TRUE);
+
+	/* Not in the middle of a character. */
+	valid = (index <= strlen (line_text) &&
+		 ((guchar) line_text[index] & 0xc0) != 0x80);
+
+	g_free (line_text);
+
+	if (valid)
+	{
+		gtk_text_iter_set_line_index (iter, index);
+	}
+
+	return valid;
+}
+
+static gboolean
+replay_record (GcsvJournalWriter       *writer,
+	       const GcsvJournalRecord *record)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (writer->buffer);
+	GtkTextIter start;
+	GtkTextIter end;
+	gchar *text;
+	gboolean same_text;
+
+	switch (record->op)
+	{
+		case GCSV_JOURNAL_OP_INSERT:
+			if (!get_iter_at_line_index (buffer, record->line, record->offset, &start))
+			{
+				return FALSE;
+			}
+
+			gtk_text_buffer_insert (buffer, &start, record->text, record->length);
+			return TRUE;
+
+		case GCSV_JOURNAL_OP_DELETE:
+			if (!get_iter_at_line_index (buffer, record->line, record->offset, &start))
+			{
+				return FALSE;
+			}
+
+			/* The deleted text is recorded to check that the journal
+			 * applies to this text.
+			 */
+			end = start;
+			gtk_text_iter_forward_chars (&end, g_utf8_strlen (record->text, record->length));
+
+			text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+			same_text = (strlen (text) == record->length &&
+				     memcmp (text, record->text, record->length) == 0);
+			g_free (text);
+
+			if (same_text)
+			{
+				gtk_text_buffer_delete (buffer, &start, &end);
+			}
+
+			return same_text;
+
+		case GCSV_JOURNAL_OP_REPLACE_LINES:
+			if (record->line + record->offset > (guint64) gtk_text_buffer_get_line_count (buffer))
+			{
+				return FALSE;
+			}
+
+			text = g_strndup (record->text, record->length);
+			gcsv_buffer_replace_lines (writer->buffer, record->line, record->offset, text, NULL, NULL);
+			g_free (text);
+			return TRUE;
+
+		default:
+			return FALSE;
+	}
+}
+
+/* Replays the records up to the first one that doesn't apply, they are the
+ * state of the document at that time. The replayed records are kept in
+ * @pending, to rewrite the journal without the others. Returns the number of
+ * replayed records.
+ */
+static guint
+replay (GcsvJournalWriter *writer,
+	RecoverData       *data)
+{
+	const gchar *p = data->contents;
+	const gchar *end = data->contents + data->length;
+	const gchar *records_start;
+	const gchar *records_end;
+	guint64 base_size;
+	guint64 base_mtime;
+	GcsvJournalRecord record;
+	guint n_records = 0;
+
+	/* A journal of another version of the file. */
+	if (!gcsv_journal_read_header (&p, end, &base_size, &base_mtime) ||
+	    base_size != data->base_size ||
+	    base_mtime != data->base_mtime)
+	{
+		return 0;
+	}
+
+	records_start = p;
+	records_end = p;
+
+	writer->replaying = TRUE;
+	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (writer->buffer));
+
+	while (gcsv_journal_read_record (&p, end, &record) &&
+	       replay_record (writer, &record))
+	{
+		records_end = p;
+		n_records++;
+	}
+
+	gtk_source_buffer_end_not_undoable_action (GTK_SOURCE_BUFFER (writer->buffer));
+	writer->replaying = FALSE;
+
+	g_string_append_len (writer->pending, records_start, records_end - records_start);
+
+	return n_records;
+}
+
+static void
+recover_thread_cb (GObject      *source_object,
+		   GAsyncResult *result,
+		   gpointer      user_data)
+{
+	GcsvJournalWriter *writer = GCSV_JOURNAL_WRITER (source_object);
+	GTask *thread_task = G_TASK (result);
+	GTask *task = G_TASK (user_data);
+	RecoverData *data = g_task_get_task_data (thread_task);
+	guint n_records = 0;
+	GError *error = NULL;
+
+	if (!g_task_propagate_boolean (thread_task, &error))
+	{
+		g_task_return_error (task, error);
+		g_object_unref (task);
+		return;
+	}
+
+	writer->base_size = data->base_size;
+	writer->base_mtime = data->base_mtime;
+	writer->base_known = TRUE;
+	writer->journal_exists = data->journal_exists;
+
+	if (data->journal_exists && !writer->discarded)
+	{
+		n_records = replay (writer, data);
+
+		if (n_records > 0)
+		{
+			gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (writer->buffer), TRUE);
+		}
+
+		/* Rewrites the journal with only the replayed records, or
+		 * removes it.
+		 */
+		write_next (writer);
+	}
+
+	g_task_return_boolean (task, n_records > 0);
+	g_object_unref (task);
+}
+
+/**
+ * gcsv_journal_writer_recover_async:
+ * @writer: a #GcsvJournalWriter.
+ * @callback: the callback to call when the recovery is finished.
+ * @user_data: the data to pass to @callback.
+ *
+ * Replays the journal left by a previous session on the buffer, if it applies
+ * to the file on disk. Must be called before any edit of the buffer, and the
+ * journal continues with the recovered records.
+ */
+void
+gcsv_journal_writer_recover_async (GcsvJournalWriter   *writer,
+				   GAsyncReadyCallback  callback,
+				   gpointer             user_data)
+{
+	GTask *task;
+	GTask *thread_task;
+	RecoverData *data;
+
+	g_return_if_fail (GCSV_IS_JOURNAL_WRITER (writer));
+
+	task = g_task_new (writer, NULL, callback, user_data);
+
+	data = g_new0 (RecoverData, 1);
+	data->location = g_object_ref (writer->location);
+	data->path = g_strdup (writer->path);
+
+	thread_task = g_task_new (writer, NULL, recover_thread_cb, task);
+	g_task_set_task_data (thread_task, data, recover_data_free);
+	g_task_run_in_thread (thread_task, recover_thread);
+	g_object_unref (thread_task);
+}
+
+/* Returns: whether some edits have been recovered. */
+gboolean
+gcsv_journal_writer_recover_finish (GcsvJournalWriter  *writer,
+				    GAsyncResult       *result,
+				    GError            **error)
+{
+	g_return_val_if_fail (GCSV_IS_JOURNAL_WRITER (writer), FALSE);
+	g_return_val_if_fail (g_task_is_valid (result, writer), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/* Writes the pending records now, instead of waiting for the next batch. */
+void
+gcsv_journal_writer_flush_async (GcsvJournalWriter   *writer,
+				 GAsyncReadyCallback  callback,
+				 gpointer             user_data)
+{
+	GTask *task;
+
+	g_return_if_fail (GCSV_IS_JOURNAL_WRITER (writer));
+
+	task = g_task_new (writer, NULL, callback, user_data);
+	writer->flush_tasks = g_list_append (writer->flush_tasks, task);
+
+	if (writer->flush_timeout_id != 0)
+	{
+		g_source_remove (writer->flush_timeout_id);
+		writer->flush_timeout_id = 0;
+	}
+
+	/* If a write is running, the task waits for the next one. */
+	write_next (writer);
+}
+
+gboolean
+gcsv_journal_writer_flush_finish (GcsvJournalWriter  *writer,
+				  GAsyncResult       *result,
+				  GError            **error)
+{
+	g_return_val_if_fail (GCSV_IS_JOURNAL_WRITER (writer), FALSE);
+	g_return_val_if_fail (g_task_is_valid (result, writer), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/* The file on disk now contains @records, or nothing if @records is %NULL,
+ * the journal is rewritten with a new header.
+ */
+static void
+set_base (GcsvJournalWriter *writer,
+	  const GString     *records)
+{
+	g_string_truncate (writer->pending, 0);
+
+	if (records != NULL)
+	{
+		g_string_append_len (writer->pending, records->str, records->len);
+	}
+
+	writer->rewrite = TRUE;
+	writer->base_known = FALSE;
+	writer->base_serial++;
+
+	if (writer->flush_timeout_id != 0)
+	{
+		g_source_remove (writer->flush_timeout_id);
+		writer->flush_timeout_id = 0;
+	}
+
+	write_next (writer);
+}
+
+/* To call when the snapshot of a save is taken: the edits done until the end
+ * of the save are kept in the journal.
+ */
+void
+gcsv_journal_writer_begin_save (GcsvJournalWriter *writer)
+{
+	g_return_if_fail (GCSV_IS_JOURNAL_WRITER (writer));
+	g_return_if_fail (writer->since_save == NULL);
+
+	writer->since_save = g_string_new (NULL);
+	writer->since_save_complete = writer->path != NULL;
+}
+
+/* @saved_location: where the snapshot has been saved, or %NULL if the save has
+ * failed.
+ */
+void
+gcsv_journal_writer_end_save (GcsvJournalWriter *writer,
+			      GFile             *saved_location)
+{
+	GString *since_save;
+
+	g_return_if_fail (GCSV_IS_JOURNAL_WRITER (writer));
+	g_return_if_fail (saved_location == NULL || G_IS_FILE (saved_location));
+	g_return_if_fail (writer->since_save != NULL);
+
+	since_save = writer->since_save;
+	writer->since_save = NULL;
+
+	if (saved_location != NULL && !writer->discarded)
+	{
+		if (!g_file_equal (saved_location, writer->location))
+		{
+			if (writer->journal_exists)
+			{
+				g_free (writer->old_path);
+				writer->old_path = writer->path;
+				writer->journal_exists = FALSE;
+			}
+			else
+			{
+				g_free (writer->path);
+			}
+
+			g_object_unref (writer->location);
+			writer->location = g_object_ref (saved_location);
+			writer->path = get_journal_path (writer->location);
+		}
+
+		writer->suspended = !writer->since_save_complete;
+		set_base (writer, writer->suspended ? NULL : since_save);
+	}
+
+	g_string_free (since_save, TRUE);
+}
+
+/* To call when the buffer content has been replaced by the file content, for
+ * example by GcsvFileReloader.
+ */
+void
+gcsv_journal_writer_rebase (GcsvJournalWriter *writer)
+{
+	g_return_if_fail (GCSV_IS_JOURNAL_WRITER (writer));
+
+	if (!writer->discarded)
+	{
+		writer->suspended = FALSE;
+		set_base (writer, NULL);
+	}
+}
+
+/* Removes the journal, when the document is closed normally. The writer
+ * doesn't record anything afterwards.
+ */
+void
+gcsv_journal_writer_discard (GcsvJournalWriter *writer)
+{
+	g_return_if_fail (GCSV_IS_JOURNAL_WRITER (writer));
+
+	if (writer->discarded)
+	{
+		return;
+	}
+
+	set_base (writer, NULL);
+	writer->discarded = TRUE;
+}
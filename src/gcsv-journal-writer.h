@@ -0,0 +1,63 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_JOURNAL_WRITER_H
+#define GCSV_JOURNAL_WRITER_H
+
+#include <gtk/gtk.h>
+#include "gcsv-buffer.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_JOURNAL_WRITER (gcsv_journal_writer_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvJournalWriter, gcsv_journal_writer,
+		      GCSV, JOURNAL_WRITER,
+		      GObject)
+
+GcsvJournalWriter *	gcsv_journal_writer_new			(GcsvBuffer *buffer,
+								 GFile      *location);
+
+void			gcsv_journal_writer_recover_async	(GcsvJournalWriter   *writer,
+								 GAsyncReadyCallback  callback,
+								 gpointer             user_data);
+
+gboolean		gcsv_journal_writer_recover_finish	(GcsvJournalWriter  *writer,
+								 GAsyncResult       *result,
+								 GError            **error);
+
+void			gcsv_journal_writer_flush_async		(GcsvJournalWriter   *writer,
+								 GAsyncReadyCallback  callback,
+								 gpointer             user_data);
+
+gboolean		gcsv_journal_writer_flush_finish	(GcsvJournalWriter  *writer,
+								 GAsyncResult       *result,
+								 GError            **error);
+
+void			gcsv_journal_writer_begin_save		(GcsvJournalWriter *writer);
+
+void			gcsv_journal_writer_end_save		(GcsvJournalWriter *writer,
+								 GFile             *saved_location);
+
+void			gcsv_journal_writer_rebase		(GcsvJournalWriter *writer);
+
+void			gcsv_journal_writer_discard		(GcsvJournalWriter *writer);
+
+G_END_DECLS
+
+#endif /* GCSV_JOURNAL_WRITER_H */
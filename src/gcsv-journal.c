@@ -0,0 +1,186 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-journal.h"
+#include <string.h>
+
+/* The binary format of the edit journal, see GcsvJournalWriter.
+ *
+ * The journal starts with a header: the magic string, then the size and the
+ * modification time of the file the edits apply to, so that a journal is
+ * replayed only on the same version of the file.
+ *
+ * Then it is a sequence of records, each one being the operation, the line,
+ * the offset and the text length as unsigned LEB128 varints, followed by the
+ * text. A typed character takes only a few bytes. When the application
+ * crashes while a record is written, the last record is incomplete and it is
+ * ignored.
+ */
+
+#define MAGIC "GCSVJRN1"
+#define MAGIC_LENGTH 8
+
+static void
+append_varint (GString *journal,
+	       guint64  value)
+{
+	gchar bytes[10];
+	guint n_bytes = 0;
+
+	while (value >= 0x80)
+	{
+		bytes[n_bytes++] = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+
+	bytes[n_bytes++] = value;
+
+	g_string_append_len (journal, bytes, n_bytes);
+}
+
+static gboolean
+read_varint (const gchar **p,
+	     const gchar  *end,
+	     guint64      *value)
+{
+	const guchar *cur = (const guchar *) *p;
+	guint64 result = 0;
+	guint shift = 0;
+
+	while ((const gchar *) cur < end && shift < 64)
+	{
+		guchar byte = *cur++;
+
+		result |= (guint64) (byte & 0x7f) << shift;
+
+		if ((byte & 0x80) == 0)
+		{
+			*p = (const gchar *) cur;
+			*value = result;
+			return TRUE;
+		}
+
+		shift += 7;
+	}
+
+	return FALSE;
+}
+
+void
+gcsv_journal_append_header (GString *journal,
+			    guint64  base_size,
+			    guint64  base_mtime)
+{
+	g_return_if_fail (journal != NULL);
+
+	g_string_append_len (journal, MAGIC, MAGIC_LENGTH);
+	append_varint (journal, base_size);
+	append_varint (journal, base_mtime);
+}
+
+/* Returns: whether @p points to a valid header. @p is moved after it. */
+gboolean
+gcsv_journal_read_header (const gchar **p,
+			  const gchar  *end,
+			  guint64      *base_size,
+			  guint64      *base_mtime)
+{
+	const gchar *cur;
+
+	g_return_val_if_fail (p != NULL && *p <= end, FALSE);
+	g_return_val_if_fail (base_size != NULL, FALSE);
+	g_return_val_if_fail (base_mtime != NULL, FALSE);
+
+	cur = *p;
+
+	if (end - cur < MAGIC_LENGTH ||
+	    memcmp (cur, MAGIC, MAGIC_LENGTH) != 0)
+	{
+		return FALSE;
+	}
+
+	cur += MAGIC_LENGTH;
+
+	if (!read_varint (&cur, end, base_size) ||
+	    !read_varint (&cur, end, base_mtime))
+	{
+		return FALSE;
+	}
+
+	*p = cur;
+	return TRUE;
+}
+
+void
+gcsv_journal_append_record (GString                 *journal,
+			    const GcsvJournalRecord *record)
+{
+	g_return_if_fail (journal != NULL);
+	g_return_if_fail (record != NULL);
+
+	append_varint (journal, record->op);
+	append_varint (journal, record->line);
+	append_varint (journal, record->offset);
+	append_varint (journal, record->length);
+	g_string_append_len (journal, record->text, record->length);
+}
+
+/* Returns: %FALSE at the end of the journal, or if the record is incomplete or
+ * invalid. Otherwise @p is moved to the next record.
+ */
+gboolean
+gcsv_journal_read_record (const gchar       **p,
+			  const gchar        *end,
+			  GcsvJournalRecord  *record)
+{
+	const gchar *cur;
+	guint64 op;
+	guint64 line;
+	guint64 length;
+
+	g_return_val_if_fail (p != NULL && *p <= end, FALSE);
+	g_return_val_if_fail (record != NULL, FALSE);
+
+	cur = *p;
+
+	if (!read_varint (&cur, end, &op) ||
+	    !read_varint (&cur, end, &line) ||
+	    !read_varint (&cur, end, &record->offset) ||
+	    !read_varint (&cur, end, &length))
+	{
+		return FALSE;
+	}
+
+	if (op < GCSV_JOURNAL_OP_INSERT ||
+	    op > GCSV_JOURNAL_OP_REPLACE_LINES ||
+	    line > G_MAXUINT ||
+	    length > (guint64) (end - cur) ||
+	    !g_utf8_validate (cur, length, NULL))
+	{
+		return FALSE;
+	}
+
+	record->op = op;
+	record->line = line;
+	record->text = cur;
+	record->length = length;
+
+	*p = cur + length;
+	return TRUE;
+}
@@ -0,0 +1,71 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_JOURNAL_H
+#define GCSV_JOURNAL_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+	GCSV_JOURNAL_OP_INSERT = 1,
+	GCSV_JOURNAL_OP_DELETE = 2,
+	GCSV_JOURNAL_OP_REPLACE_LINES = 3,
+} GcsvJournalOp;
+
+/* An edit, in the coordinates of the text without the virtual spaces. */
+typedef struct _GcsvJournalRecord GcsvJournalRecord;
+struct _GcsvJournalRecord
+{
+	GcsvJournalOp op;
+	guint line;
+
+	/* The byte index in the line, or for %GCSV_JOURNAL_OP_REPLACE_LINES
+	 * the number of replaced lines.
+	 */
+	guint64 offset;
+
+	/* The inserted, deleted or replacement text. Points inside the journal
+	 * data when the record is read, it is not nul-terminated.
+	 */
+	const gchar *text;
+	gsize length;
+};
+
+void		gcsv_journal_append_header	(GString *journal,
+						 guint64  base_size,
+						 guint64  base_mtime);
+
+gboolean	gcsv_journal_read_header	(const gchar **p,
+						 const gchar  *end,
+						 guint64      *base_size,
+						 guint64      *base_mtime);
+
+void		gcsv_journal_append_record	(GString                 *journal,
+						 const GcsvJournalRecord *record);
+
+gboolean	gcsv_journal_read_record	(const gchar       **p,
+						 const gchar        *end,
+						 GcsvJournalRecord  *record);
+
+G_END_DECLS
+
+#endif /* GCSV_JOURNAL_H */
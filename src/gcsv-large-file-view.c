@@ -0,0 +1,644 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-large-file-view.h"
+#include <glib/gi18n.h>
+#include "gcsv-utils.h"
+
+/* A read-only view for files that are too large to be loaded in a
+ * GtkTextBuffer. The rows are read from a GcsvRowIndex, which is normally
+ * backed by a memory-mapped file. Only the rows in the visible window are
+ * decoded and laid out, so the memory and the drawing cost don't depend on the
+ * file size.
+ *
+ * The columns are aligned like in the GtkTextView, with spaces, but the spaces
+ * are added only when drawing.
+ */
+
+struct _GcsvLargeFileView
+{
+	GtkGrid parent;
+
+	GcsvRowIndex *index;
+	GCancellable *cancellable;
+
+	/* Copy of the column widths of the index, refreshed while the index is
+	 * being built.
+	 */
+	GcsvColumnWidths *column_widths;
+
+	GtkDrawingArea *drawing_area;
+	GtkLabel *status_label;
+
+	/* The vertical adjustment is in rows, the horizontal adjustment is in
+	 * pixels.
+	 */
+	GtkAdjustment *vadjustment;
+	GtkAdjustment *hadjustment;
+
+	PangoLayout *layout;
+	gint char_width;
+	gint line_height;
+
+	/* Re-used to compose the visible rows. */
+	GString *row_text;
+
+	guint refresh_timeout_id;
+};
+
+/* Refresh interval in milliseconds, while the index is being built. */
+#define REFRESH_INTERVAL 250
+
+#define N_ROWS_PER_SCROLL_STEP 3
+
+G_DEFINE_TYPE (GcsvLargeFileView, gcsv_large_file_view, GTK_TYPE_GRID)
+
+static void
+remove_refresh_timeout (GcsvLargeFileView *view)
+{
+	if (view->refresh_timeout_id != 0)
+	{
+		g_source_remove (view->refresh_timeout_id);
+		view->refresh_timeout_id = 0;
+	}
+}
+
+static void
+gcsv_large_file_view_dispose (GObject *object)
+{
+	GcsvLargeFileView *view = GCSV_LARGE_FILE_VIEW (object);
+
+	remove_refresh_timeout (view);
+
+	if (view->cancellable != NULL)
+	{
+		g_cancellable_cancel (view->cancellable);
+		g_clear_object (&view->cancellable);
+	}
+
+	if (view->index != NULL)
+	{
+		gcsv_row_index_unref (view->index);
+		view->index = NULL;
+	}
+
+	g_clear_object (&view->vadjustment);
+	g_clear_object (&view->hadjustment);
+	g_clear_object (&view->layout);
+
+	G_OBJECT_CLASS (gcsv_large_file_view_parent_class)->dispose (object);
+}
+
+static void
+gcsv_large_file_view_finalize (GObject *object)
+{
+	GcsvLargeFileView *view = GCSV_LARGE_FILE_VIEW (object);
+
+	gcsv_column_widths_free (view->column_widths);
+	g_string_free (view->row_text, TRUE);
+
+	G_OBJECT_CLASS (gcsv_large_file_view_parent_class)->finalize (object);
+}
+
+static void
+gcsv_large_file_view_class_init (GcsvLargeFileViewClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gcsv_large_file_view_dispose;
+	object_class->finalize = gcsv_large_file_view_finalize;
+}
+
+static gint
+get_column_length (GcsvLargeFileView *view,
+		   guint              column_num)
+{
+	if (view->column_widths == NULL)
+	{
+		return -1;
+	}
+
+	return gcsv_column_widths_get (view->column_widths, column_num);
+}
+
+/* Fills view->row_text with the row, with the same alignment as in the
+ * GtkTextView: spaces are added at the end of each field, except the last
+ * one.
+ */
+static void
+compose_row (GcsvLargeFileView *view,
+	     const gchar       *row_start,
+	     gsize              row_length)
+{
+	const gchar *row_end = row_start + row_length;
+	const gchar *field_start = row_start;
+	const GcsvTokenizer *tokenizer;
+	gchar delimiter_str[8] = { 0 };
+	gint delimiter_len;
+	guint column_num = 0;
+
+	g_string_truncate (view->row_text, 0);
+
+	tokenizer = gcsv_row_index_get_tokenizer (view->index);
+	if (gcsv_tokenizer_get_delimiter (tokenizer) == '\0')
+	{
+		gcsv_utils_append_valid_utf8 (view->row_text, row_start, row_length);
+		return;
+	}
+
+	delimiter_len = g_unichar_to_utf8 (gcsv_tokenizer_get_delimiter (tokenizer), delimiter_str);
+
+	while (TRUE)
+	{
+		const gchar *field_end;
+		gsize field_pos;
+		gint field_length;
+		gint column_length;
+
+		field_end = gcsv_tokenizer_find_delimiter (tokenizer, field_start, row_end);
+		if (field_end == NULL)
+		{
+			gcsv_utils_append_valid_utf8 (view->row_text, field_start, row_end - field_start);
+			break;
+		}
+
+		field_pos = view->row_text->len;
+		gcsv_utils_append_valid_utf8 (view->row_text, field_start, field_end - field_start);
+
+		field_length = g_utf8_strlen (view->row_text->str + field_pos,
+					      view->row_text->len - field_pos);
+		column_length = get_column_length (view, column_num);
+
+		for (; field_length < column_length; field_length++)
+		{
+			g_string_append_c (view->row_text, ' ');
+		}
+
+		g_string_append_len (view->row_text, delimiter_str, delimiter_len);
+
+		field_start = field_end + delimiter_len;
+		column_num++;
+	}
+}
+
+static gboolean
+drawing_area_draw_cb (GtkWidget         *drawing_area,
+		      cairo_t           *cr,
+		      GcsvLargeFileView *view)
+{
+	GtkStyleContext *style_context;
+	GdkRGBA color;
+	gint width;
+	gint height;
+	guint first_row;
+	guint n_visible_rows;
+	guint i;
+	gdouble x;
+
+	style_context = gtk_widget_get_style_context (drawing_area);
+	width = gtk_widget_get_allocated_width (drawing_area);
+	height = gtk_widget_get_allocated_height (drawing_area);
+
+	gtk_render_background (style_context, cr, 0, 0, width, height);
+
+	if (view->index == NULL)
+	{
+		return GDK_EVENT_PROPAGATE;
+	}
+
+	gtk_style_context_get_color (style_context,
+				     gtk_style_context_get_state (style_context),
+				     &color);
+	gdk_cairo_set_source_rgba (cr, &color);
+
+	first_row = gtk_adjustment_get_value (view->vadjustment);
+	n_visible_rows = height / view->line_height + 1;
+	x = -gtk_adjustment_get_value (view->hadjustment);
+
+	for (i = 0; i < n_visible_rows; i++)
+	{
+		const gchar *row_start;
+		gsize row_length;
+
+		if (!gcsv_row_index_get_row (view->index, first_row + i, &row_start, &row_length))
+		{
+			break;
+		}
+
+		compose_row (view, row_start, row_length);
+		pango_layout_set_text (view->layout, view->row_text->str, view->row_text->len);
+
+		cairo_move_to (cr, x, i * view->line_height);
+		pango_cairo_show_layout (cr, view->layout);
+	}
+
+	return GDK_EVENT_PROPAGATE;
+}
+
+static void
+update_adjustments (GcsvLargeFileView *view)
+{
+	guint n_rows = 0;
+	gint n_visible_rows;
+	gint total_width = 0;
+	gint width;
+	guint column_num;
+
+	if (view->index != NULL)
+	{
+		n_rows = gcsv_row_index_get_n_rows (view->index);
+	}
+
+	n_visible_rows = gtk_widget_get_allocated_height (GTK_WIDGET (view->drawing_area)) / view->line_height;
+	n_visible_rows = MAX (n_visible_rows, 1);
+
+	gtk_adjustment_configure (view->vadjustment,
+				  gtk_adjustment_get_value (view->vadjustment),
+				  0,
+				  n_rows,
+				  1,
+				  n_visible_rows,
+				  n_visible_rows);
+
+	if (view->column_widths != NULL)
+	{
+		guint n_columns = gcsv_column_widths_get_n_columns (view->column_widths);
+
+		for (column_num = 0; column_num < n_columns; column_num++)
+		{
+			/* Plus one for the delimiter. */
+			total_width += MAX (get_column_length (view, column_num), 0) + 1;
+		}
+	}
+
+	total_width *= view->char_width;
+	width = gtk_widget_get_allocated_width (GTK_WIDGET (view->drawing_area));
+
+	gtk_adjustment_configure (view->hadjustment,
+				  gtk_adjustment_get_value (view->hadjustment),
+				  0,
+				  MAX (total_width, width),
+				  view->char_width,
+				  width,
+				  width);
+}
+
+static void
+update_status_label (GcsvLargeFileView *view)
+{
+	guint n_rows;
+	gchar *label_text;
+
+	if (view->index == NULL)
+	{
+		gtk_label_set_text (view->status_label, NULL);
+		return;
+	}
+
+	n_rows = gcsv_row_index_get_n_rows (view->index);
+
+	if (gcsv_row_index_is_complete (view->index))
+	{
+		label_text = g_strdup_printf (ngettext ("Read-only, %u row",
+							"Read-only, %u rows",
+							n_rows),
+					      n_rows);
+	}
+	else
+	{
+		label_text = g_strdup_printf (ngettext ("Read-only, indexing… %u row so far",
+							"Read-only, indexing… %u rows so far",
+							n_rows),
+					      n_rows);
+	}
+
+	gtk_label_set_text (view->status_label, label_text);
+	g_free (label_text);
+}
+
+static void
+refresh (GcsvLargeFileView *view)
+{
+	gcsv_column_widths_free (view->column_widths);
+	view->column_widths = NULL;
+
+	if (view->index != NULL)
+	{
+		view->column_widths = gcsv_row_index_get_column_widths (view->index);
+	}
+
+	update_adjustments (view);
+	update_status_label (view);
+	gtk_widget_queue_draw (GTK_WIDGET (view->drawing_area));
+}
+
+static gboolean
+refresh_timeout_cb (gpointer user_data)
+{
+	GcsvLargeFileView *view = GCSV_LARGE_FILE_VIEW (user_data);
+
+	refresh (view);
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+drawing_area_size_allocate_cb (GtkWidget         *drawing_area,
+			       GdkRectangle      *allocation,
+			       GcsvLargeFileView *view)
+{
+	update_adjustments (view);
+}
+
+static gboolean
+drawing_area_scroll_event_cb (GtkWidget         *drawing_area,
+			      GdkEventScroll    *event,
+			      GcsvLargeFileView *view)
+{
+	gdouble delta_x = 0.0;
+	gdouble delta_y = 0.0;
+
+	switch (event->direction)
+	{
+		case GDK_SCROLL_UP:
+			delta_y = -1.0;
+			break;
+
+		case GDK_SCROLL_DOWN:
+			delta_y = 1.0;
+			break;
+
+		case GDK_SCROLL_LEFT:
+			delta_x = -1.0;
+			break;
+
+		case GDK_SCROLL_RIGHT:
+			delta_x = 1.0;
+			break;
+
+		case GDK_SCROLL_SMOOTH:
+			gdk_event_get_scroll_deltas ((GdkEvent *) event, &delta_x, &delta_y);
+			break;
+
+		default:
+			return GDK_EVENT_PROPAGATE;
+	}
+
+	if ((event->state & GDK_SHIFT_MASK) != 0)
+	{
+		delta_x = delta_y;
+		delta_y = 0.0;
+	}
+
+	gcsv_utils_scroll_adjustment_by (view->vadjustment, delta_y * N_ROWS_PER_SCROLL_STEP);
+	gcsv_utils_scroll_adjustment_by (view->hadjustment, delta_x * N_ROWS_PER_SCROLL_STEP * view->char_width);
+
+	return GDK_EVENT_STOP;
+}
+
+static gboolean
+drawing_area_key_press_event_cb (GtkWidget         *drawing_area,
+				 GdkEventKey       *event,
+				 GcsvLargeFileView *view)
+{
+	gdouble page_size = gtk_adjustment_get_page_size (view->vadjustment);
+
+	switch (event->keyval)
+	{
+		case GDK_KEY_Up:
+			gcsv_utils_scroll_adjustment_by (view->vadjustment, -1);
+			break;
+
+		case GDK_KEY_Down:
+			gcsv_utils_scroll_adjustment_by (view->vadjustment, 1);
+			break;
+
+		case GDK_KEY_Page_Up:
+			gcsv_utils_scroll_adjustment_by (view->vadjustment, -page_size);
+			break;
+
+		case GDK_KEY_Page_Down:
+			gcsv_utils_scroll_adjustment_by (view->vadjustment, page_size);
+			break;
+
+		case GDK_KEY_Home:
+			gtk_adjustment_set_value (view->vadjustment, 0);
+			break;
+
+		case GDK_KEY_End:
+			gcsv_utils_scroll_adjustment_by (view->vadjustment, gtk_adjustment_get_upper (view->vadjustment));
+			break;
+
+		case GDK_KEY_Left:
+			gcsv_utils_scroll_adjustment_by (view->hadjustment, -view->char_width);
+			break;
+
+		case GDK_KEY_Right:
+			gcsv_utils_scroll_adjustment_by (view->hadjustment, view->char_width);
+			break;
+
+		default:
+			return GDK_EVENT_PROPAGATE;
+	}
+
+	return GDK_EVENT_STOP;
+}
+
+static gboolean
+drawing_area_button_press_event_cb (GtkWidget         *drawing_area,
+				    GdkEventButton    *event,
+				    GcsvLargeFileView *view)
+{
+	gtk_widget_grab_focus (drawing_area);
+	return GDK_EVENT_PROPAGATE;
+}
+
+static void
+adjustment_value_changed_cb (GtkAdjustment     *adjustment,
+			     GcsvLargeFileView *view)
+{
+	gtk_widget_queue_draw (GTK_WIDGET (view->drawing_area));
+}
+
+static void
+init_layout (GcsvLargeFileView *view)
+{
+	PangoFontDescription *font_desc;
+
+	view->layout = gtk_widget_create_pango_layout (GTK_WIDGET (view->drawing_area), NULL);
+
+	font_desc = pango_font_description_from_string ("Monospace");
+	pango_layout_set_font_description (view->layout, font_desc);
+	pango_font_description_free (font_desc);
+
+	pango_layout_set_text (view->layout, "M", -1);
+	pango_layout_get_pixel_size (view->layout, &view->char_width, &view->line_height);
+
+	view->char_width = MAX (view->char_width, 1);
+	view->line_height = MAX (view->line_height, 1);
+}
+
+static void
+gcsv_large_file_view_init (GcsvLargeFileView *view)
+{
+	GtkWidget *vscrollbar;
+	GtkWidget *hscrollbar;
+
+	view->row_text = g_string_new (NULL);
+
+	view->vadjustment = g_object_ref_sink (gtk_adjustment_new (0, 0, 0, 0, 0, 0));
+	view->hadjustment = g_object_ref_sink (gtk_adjustment_new (0, 0, 0, 0, 0, 0));
+
+	view->drawing_area = GTK_DRAWING_AREA (gtk_drawing_area_new ());
+	gtk_widget_set_hexpand (GTK_WIDGET (view->drawing_area), TRUE);
+	gtk_widget_set_vexpand (GTK_WIDGET (view->drawing_area), TRUE);
+	gtk_widget_set_can_focus (GTK_WIDGET (view->drawing_area), TRUE);
+	gtk_widget_add_events (GTK_WIDGET (view->drawing_area),
+			       GDK_SCROLL_MASK |
+			       GDK_SMOOTH_SCROLL_MASK |
+			       GDK_KEY_PRESS_MASK |
+			       GDK_BUTTON_PRESS_MASK);
+	gtk_style_context_add_class (gtk_widget_get_style_context (GTK_WIDGET (view->drawing_area)),
+				     GTK_STYLE_CLASS_VIEW);
+	gtk_grid_attach (GTK_GRID (view), GTK_WIDGET (view->drawing_area), 0, 0, 1, 1);
+
+	vscrollbar = gtk_scrollbar_new (GTK_ORIENTATION_VERTICAL, view->vadjustment);
+	gtk_grid_attach (GTK_GRID (view), vscrollbar, 1, 0, 1, 1);
+
+	hscrollbar = gtk_scrollbar_new (GTK_ORIENTATION_HORIZONTAL, view->hadjustment);
+	gtk_grid_attach (GTK_GRID (view), hscrollbar, 0, 1, 1, 1);
+
+	view->status_label = GTK_LABEL (gtk_label_new (NULL));
+	gtk_widget_set_halign (GTK_WIDGET (view->status_label), GTK_ALIGN_START);
+	g_object_set (view->status_label, "margin", 6, NULL);
+	gtk_grid_attach (GTK_GRID (view), GTK_WIDGET (view->status_label), 0, 2, 2, 1);
+
+	init_layout (view);
+
+	g_signal_connect (view->drawing_area,
+			  "draw",
+			  G_CALLBACK (drawing_area_draw_cb),
+			  view);
+
+	g_signal_connect (view->drawing_area,
+			  "size-allocate",
+			  G_CALLBACK (drawing_area_size_allocate_cb),
+			  view);
+
+	g_signal_connect (view->drawing_area,
+			  "scroll-event",
+			  G_CALLBACK (drawing_area_scroll_event_cb),
+			  view);
+
+	g_signal_connect (view->drawing_area,
+			  "key-press-event",
+			  G_CALLBACK (drawing_area_key_press_event_cb),
+			  view);
+
+	g_signal_connect (view->drawing_area,
+			  "button-press-event",
+			  G_CALLBACK (drawing_area_button_press_event_cb),
+			  view);
+
+	g_signal_connect (view->vadjustment,
+			  "value-changed",
+			  G_CALLBACK (adjustment_value_changed_cb),
+			  view);
+
+	g_signal_connect (view->hadjustment,
+			  "value-changed",
+			  G_CALLBACK (adjustment_value_changed_cb),
+			  view);
+
+	gtk_widget_show_all (GTK_WIDGET (view));
+}
+
+GcsvLargeFileView *
+gcsv_large_file_view_new (void)
+{
+	return g_object_new (GCSV_TYPE_LARGE_FILE_VIEW, NULL);
+}
+
+static void
+build_index_thread (GTask        *task,
+		    gpointer      source_object,
+		    gpointer      task_data,
+		    GCancellable *cancellable)
+{
+	GcsvRowIndex *index = task_data;
+
+	gcsv_row_index_build (index, cancellable);
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+build_index_cb (GObject      *source_object,
+		GAsyncResult *result,
+		gpointer      user_data)
+{
+	GcsvLargeFileView *view = GCSV_LARGE_FILE_VIEW (source_object);
+	GTask *task = G_TASK (result);
+
+	if (g_task_get_task_data (task) != view->index)
+	{
+		/* The index has been replaced in the meantime. */
+		return;
+	}
+
+	remove_refresh_timeout (view);
+	refresh (view);
+}
+
+/* Sets the index and builds it in a worker thread. */
+void
+gcsv_large_file_view_set_index (GcsvLargeFileView *view,
+				GcsvRowIndex      *index)
+{
+	GTask *task;
+
+	g_return_if_fail (GCSV_IS_LARGE_FILE_VIEW (view));
+	g_return_if_fail (index != NULL);
+
+	if (view->cancellable != NULL)
+	{
+		g_cancellable_cancel (view->cancellable);
+		g_clear_object (&view->cancellable);
+	}
+
+	if (view->index != NULL)
+	{
+		gcsv_row_index_unref (view->index);
+	}
+
+	view->index = gcsv_row_index_ref (index);
+	view->cancellable = g_cancellable_new ();
+
+	task = g_task_new (view, view->cancellable, build_index_cb, NULL);
+	g_task_set_task_data (task,
+			      gcsv_row_index_ref (index),
+			      (GDestroyNotify) gcsv_row_index_unref);
+	g_task_run_in_thread (task, build_index_thread);
+	g_object_unref (task);
+
+	remove_refresh_timeout (view);
+	view->refresh_timeout_id = g_timeout_add (REFRESH_INTERVAL, refresh_timeout_cb, view);
+
+	gtk_adjustment_set_value (view->vadjustment, 0);
+	gtk_adjustment_set_value (view->hadjustment, 0);
+	refresh (view);
+}
@@ -0,0 +1,40 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_LARGE_FILE_VIEW_H
+#define GCSV_LARGE_FILE_VIEW_H
+
+#include <gtk/gtk.h>
+#include "gcsv-row-index.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_LARGE_FILE_VIEW (gcsv_large_file_view_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvLargeFileView, gcsv_large_file_view,
+		      GCSV, LARGE_FILE_VIEW,
+		      GtkGrid)
+
+GcsvLargeFileView *	gcsv_large_file_view_new		(void);
+
+void			gcsv_large_file_view_set_index		(GcsvLargeFileView *view,
+								 GcsvRowIndex      *index);
+
+G_END_DECLS
+
+#endif /* GCSV_LARGE_FILE_VIEW_H */
@@ -0,0 +1,883 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-ragged-rows.h"
+#include "gcsv-chunked-tracker.h"
+
+/* Finds the ragged rows, i.e. the rows that don't have the expected number of
+ * columns, without blocking the main thread on big files.
+ *
+ * The expected number of columns is the one of the column titles line. If the
+ * column titles line has only one column, for example when there is no
+ * column titles line, it is the most common number of columns instead. The
+ * empty lines are never ragged.
+ *
+ * The lines after the column titles are computed by chunks with a
+ * GcsvChunkedTracker. For each chunk, the numbers of columns are kept as runs
+ * of consecutive lines with the same number of columns. So a change of the
+ * expected number of columns doesn't require to compute the chunks again, and
+ * the runs are small: usually only one per chunk.
+ *
+ * The number of ragged rows of each chunk is summed into a prefix array, so
+ * that the next or previous chunk containing a ragged row is found with a
+ * binary search.
+ */
+
+struct _GcsvRaggedRows
+{
+	GObject parent;
+
+	GcsvBuffer *buffer;
+
+	GcsvTokenizer tokenizer;
+
+	GcsvChunkedTracker *chunked_tracker;
+
+	/* Contains n_chunks + 1 guint's: the number of ragged rows in the
+	 * chunks before each chunk, and the total at the end. Updated with the
+	 * merge.
+	 */
+	GArray *n_rows_before_chunk;
+
+	guint expected_n_columns;
+
+	guint merge_idle_id;
+};
+
+/* Consecutive lines with the same number of columns. */
+typedef struct _Run Run;
+struct _Run
+{
+	/* The first line of the run, relative to the chunk start. */
+	guint line_offset;
+
+	/* 0 for empty lines. */
+	guint n_columns;
+};
+
+/* The result of a chunk. */
+typedef struct _ChunkRuns ChunkRuns;
+struct _ChunkRuns
+{
+	GArray *runs;
+	guint n_lines;
+};
+
+enum
+{
+	PROP_0,
+	PROP_BUFFER,
+};
+
+enum
+{
+	SIGNAL_CHANGED,
+	LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE (GcsvRaggedRows, gcsv_ragged_rows, G_TYPE_OBJECT)
+
+static void
+chunk_runs_free (gpointer data)
+{
+	ChunkRuns *chunk_runs = data;
+
+	g_array_unref (chunk_runs->runs);
+	g_free (chunk_runs);
+}
+
+static gint
+get_chunk_start_line (GcsvRaggedRows *ragged_rows,
+		      guint           chunk_index)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gcsv_chunked_tracker_get_chunk_bounds (ragged_rows->chunked_tracker, chunk_index, &start, &end);
+	return gtk_text_iter_get_line (&start);
+}
+
+static guint
+get_run_end (const ChunkRuns *chunk_runs,
+	     guint            run_index)
+{
+	if (run_index + 1 < chunk_runs->runs->len)
+	{
+		return g_array_index (chunk_runs->runs, Run, run_index + 1).line_offset;
+	}
+
+	return chunk_runs->n_lines;
+}
+
+static gboolean
+is_ragged (GcsvRaggedRows *ragged_rows,
+	   const Run      *run)
+{
+	return run->n_columns != 0 && run->n_columns != ragged_rows->expected_n_columns;
+}
+
+static guint
+count_ragged_rows_in_chunk (GcsvRaggedRows  *ragged_rows,
+			    const ChunkRuns *chunk_runs)
+{
+	guint n_rows = 0;
+	guint i;
+
+	if (chunk_runs == NULL)
+	{
+		return 0;
+	}
+
+	for (i = 0; i < chunk_runs->runs->len; i++)
+	{
+		const Run *run = &g_array_index (chunk_runs->runs, Run, i);
+
+		if (is_ragged (ragged_rows, run))
+		{
+			n_rows += get_run_end (chunk_runs, i) - run->line_offset;
+		}
+	}
+
+	return n_rows;
+}
+
+static guint
+get_most_common_n_columns (GcsvRaggedRows *ragged_rows)
+{
+	GHashTable *n_lines_by_n_columns;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	guint most_common_n_columns = 1;
+	guint max_n_lines = 0;
+	guint n_chunks;
+	guint chunk_index;
+
+	n_lines_by_n_columns = g_hash_table_new (NULL, NULL);
+	n_chunks = gcsv_chunked_tracker_get_n_chunks (ragged_rows->chunked_tracker);
+
+	for (chunk_index = 0; chunk_index < n_chunks; chunk_index++)
+	{
+		const ChunkRuns *chunk_runs;
+		guint i;
+
+		chunk_runs = gcsv_chunked_tracker_get_chunk_result (ragged_rows->chunked_tracker, chunk_index);
+
+		if (chunk_runs == NULL)
+		{
+			continue;
+		}
+
+		for (i = 0; i < chunk_runs->runs->len; i++)
+		{
+			const Run *run = &g_array_index (chunk_runs->runs, Run, i);
+			guint n_lines;
+
+			if (run->n_columns == 0)
+			{
+				continue;
+			}
+
+			n_lines = GPOINTER_TO_UINT (g_hash_table_lookup (n_lines_by_n_columns,
+									 GUINT_TO_POINTER (run->n_columns)));
+			n_lines += get_run_end (chunk_runs, i) - run->line_offset;
+			g_hash_table_insert (n_lines_by_n_columns,
+					     GUINT_TO_POINTER (run->n_columns),
+					     GUINT_TO_POINTER (n_lines));
+		}
+	}
+
+	/* On a tie, the smallest number of columns wins, so that the result
+	 * doesn't depend on the hash table order.
+	 */
+	g_hash_table_iter_init (&iter, n_lines_by_n_columns);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+	{
+		guint n_columns = GPOINTER_TO_UINT (key);
+		guint n_lines = GPOINTER_TO_UINT (value);
+
+		if (n_lines > max_n_lines ||
+		    (n_lines == max_n_lines && n_columns < most_common_n_columns))
+		{
+			most_common_n_columns = n_columns;
+			max_n_lines = n_lines;
+		}
+	}
+
+	g_hash_table_unref (n_lines_by_n_columns);
+	return most_common_n_columns;
+}
+
+static guint
+compute_expected_n_columns (GcsvRaggedRows *ragged_rows)
+{
+	GtkTextIter titles_location;
+	guint n_columns;
+
+	gcsv_buffer_get_column_titles_location (ragged_rows->buffer, &titles_location);
+	n_columns = gcsv_buffer_count_columns_at_line (ragged_rows->buffer,
+						       gtk_text_iter_get_line (&titles_location));
+
+	if (n_columns > 1)
+	{
+		return n_columns;
+	}
+
+	return get_most_common_n_columns (ragged_rows);
+}
+
+/* Updates the expected number of columns and the prefix sums of the ragged
+ * rows, from the runs of the chunks.
+ */
+static void
+update_counts (GcsvRaggedRows *ragged_rows)
+{
+	guint n_rows = 0;
+	guint n_chunks;
+	guint i;
+
+	ragged_rows->expected_n_columns = compute_expected_n_columns (ragged_rows);
+
+	g_array_set_size (ragged_rows->n_rows_before_chunk, 0);
+	g_array_append_val (ragged_rows->n_rows_before_chunk, n_rows);
+
+	n_chunks = gcsv_chunked_tracker_get_n_chunks (ragged_rows->chunked_tracker);
+
+	for (i = 0; i < n_chunks; i++)
+	{
+		const ChunkRuns *chunk_runs;
+
+		chunk_runs = gcsv_chunked_tracker_get_chunk_result (ragged_rows->chunked_tracker, i);
+		n_rows += count_ragged_rows_in_chunk (ragged_rows, chunk_runs);
+		g_array_append_val (ragged_rows->n_rows_before_chunk, n_rows);
+	}
+}
+
+static void
+flush_merge (GcsvRaggedRows *ragged_rows)
+{
+	if (ragged_rows->merge_idle_id != 0)
+	{
+		g_source_remove (ragged_rows->merge_idle_id);
+		ragged_rows->merge_idle_id = 0;
+
+		update_counts (ragged_rows);
+		g_signal_emit (ragged_rows, signals[SIGNAL_CHANGED], 0);
+	}
+}
+
+static gboolean
+merge_idle_cb (gpointer user_data)
+{
+	GcsvRaggedRows *ragged_rows = GCSV_RAGGED_ROWS (user_data);
+
+	ragged_rows->merge_idle_id = 0;
+
+	update_counts (ragged_rows);
+	g_signal_emit (ragged_rows, signals[SIGNAL_CHANGED], 0);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Several results can arrive during the same main loop iteration, they are
+ * merged only once.
+ */
+static void
+queue_merge (GcsvRaggedRows *ragged_rows)
+{
+	if (ragged_rows->merge_idle_id == 0)
+	{
+		ragged_rows->merge_idle_id = g_idle_add (merge_idle_cb, ragged_rows);
+	}
+}
+
+static gint
+get_first_line (gpointer user_data)
+{
+	GcsvRaggedRows *ragged_rows = GCSV_RAGGED_ROWS (user_data);
+	GtkTextIter titles_location;
+
+	gcsv_buffer_get_column_titles_location (ragged_rows->buffer, &titles_location);
+	return gtk_text_iter_get_line (&titles_location) + 1;
+}
+
+/* Computes the whole buffer again. */
+static void
+recompute (gpointer user_data)
+{
+	GcsvRaggedRows *ragged_rows = GCSV_RAGGED_ROWS (user_data);
+	gunichar delimiter;
+
+	/* Without delimiter there are no columns, so no ragged rows. */
+	delimiter = gcsv_buffer_get_delimiter (ragged_rows->buffer);
+
+	if (delimiter != '\0')
+	{
+		gcsv_tokenizer_init (&ragged_rows->tokenizer, delimiter);
+		gcsv_chunked_tracker_start (ragged_rows->chunked_tracker);
+	}
+	else
+	{
+		gcsv_chunked_tracker_stop (ragged_rows->chunked_tracker);
+	}
+
+	update_counts (ragged_rows);
+	queue_merge (ragged_rows);
+}
+
+static gpointer
+job_data_new (gpointer user_data)
+{
+	GcsvRaggedRows *ragged_rows = GCSV_RAGGED_ROWS (user_data);
+	GcsvTokenizer *tokenizer;
+
+	tokenizer = g_new (GcsvTokenizer, 1);
+	*tokenizer = ragged_rows->tokenizer;
+
+	return tokenizer;
+}
+
+static gpointer
+compute_chunk (gpointer     job_data,
+	       const gchar *text,
+	       const gchar *text_end)
+{
+	GcsvTokenizer *tokenizer = job_data;
+	ChunkRuns *chunk_runs;
+	const gchar *line;
+
+	chunk_runs = g_new0 (ChunkRuns, 1);
+	chunk_runs->runs = g_array_new (FALSE, FALSE, sizeof (Run));
+
+	for (line = text; line < text_end; chunk_runs->n_lines++)
+	{
+		const gchar *line_end;
+		const gchar *next_line;
+		guint n_columns = 0;
+
+		line_end = gcsv_tokenizer_find_line_end (line, text_end, &next_line);
+
+		if (line_end > line)
+		{
+			n_columns = gcsv_tokenizer_count_columns (tokenizer, line, line_end);
+		}
+
+		if (chunk_runs->runs->len == 0 ||
+		    g_array_index (chunk_runs->runs, Run, chunk_runs->runs->len - 1).n_columns != n_columns)
+		{
+			Run run;
+
+			run.line_offset = chunk_runs->n_lines;
+			run.n_columns = n_columns;
+			g_array_append_val (chunk_runs->runs, run);
+		}
+
+		line = next_line;
+	}
+
+	return chunk_runs;
+}
+
+static void
+chunk_computed (gpointer user_data,
+		guint    chunk_index)
+{
+	queue_merge (GCSV_RAGGED_ROWS (user_data));
+}
+
+/* Also when the column titles line is edited, the expected number of columns
+ * can change.
+ */
+static void
+chunks_changed (gpointer user_data)
+{
+	queue_merge (GCSV_RAGGED_ROWS (user_data));
+}
+
+static const GcsvChunkedTrackerFuncs chunked_tracker_funcs =
+{
+	get_first_line,
+	recompute,
+	job_data_new,
+	g_free,
+	compute_chunk,
+	chunk_runs_free,
+	chunk_computed,
+	chunks_changed,
+};
+
+static void
+delimiter_notify_cb (GcsvBuffer     *buffer,
+		     GParamSpec     *pspec,
+		     GcsvRaggedRows *ragged_rows)
+{
+	recompute (ragged_rows);
+}
+
+static void
+column_titles_set_cb (GcsvBuffer     *buffer,
+		      GcsvRaggedRows *ragged_rows)
+{
+	recompute (ragged_rows);
+}
+
+static void
+set_buffer (GcsvRaggedRows *ragged_rows,
+	    GcsvBuffer     *buffer)
+{
+	g_assert (ragged_rows->buffer == NULL);
+
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+	ragged_rows->buffer = g_object_ref (buffer);
+
+	ragged_rows->chunked_tracker = gcsv_chunked_tracker_new (buffer, &chunked_tracker_funcs, ragged_rows);
+
+	g_signal_connect_object (buffer,
+				 "notify::delimiter",
+				 G_CALLBACK (delimiter_notify_cb),
+				 ragged_rows,
+				 0);
+
+	g_signal_connect_object (buffer,
+				 "column-titles-set",
+				 G_CALLBACK (column_titles_set_cb),
+				 ragged_rows,
+				 0);
+
+	g_object_notify (G_OBJECT (ragged_rows), "buffer");
+}
+
+static void
+gcsv_ragged_rows_get_property (GObject    *object,
+			       guint       prop_id,
+			       GValue     *value,
+			       GParamSpec *pspec)
+{
+	GcsvRaggedRows *ragged_rows = GCSV_RAGGED_ROWS (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_value_set_object (value, ragged_rows->buffer);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_ragged_rows_set_property (GObject      *object,
+			       guint         prop_id,
+			       const GValue *value,
+			       GParamSpec   *pspec)
+{
+	GcsvRaggedRows *ragged_rows = GCSV_RAGGED_ROWS (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			set_buffer (ragged_rows, g_value_get_object (value));
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_ragged_rows_constructed (GObject *object)
+{
+	G_OBJECT_CLASS (gcsv_ragged_rows_parent_class)->constructed (object);
+
+	recompute (GCSV_RAGGED_ROWS (object));
+}
+
+static void
+gcsv_ragged_rows_dispose (GObject *object)
+{
+	GcsvRaggedRows *ragged_rows = GCSV_RAGGED_ROWS (object);
+
+	if (ragged_rows->chunked_tracker != NULL)
+	{
+		gcsv_chunked_tracker_stop (ragged_rows->chunked_tracker);
+		g_clear_object (&ragged_rows->chunked_tracker);
+	}
+
+	if (ragged_rows->merge_idle_id != 0)
+	{
+		g_source_remove (ragged_rows->merge_idle_id);
+		ragged_rows->merge_idle_id = 0;
+	}
+
+	g_clear_object (&ragged_rows->buffer);
+
+	G_OBJECT_CLASS (gcsv_ragged_rows_parent_class)->dispose (object);
+}
+
+static void
+gcsv_ragged_rows_finalize (GObject *object)
+{
+	GcsvRaggedRows *ragged_rows = GCSV_RAGGED_ROWS (object);
+
+	g_array_unref (ragged_rows->n_rows_before_chunk);
+
+	G_OBJECT_CLASS (gcsv_ragged_rows_parent_class)->finalize (object);
+}
+
+static void
+gcsv_ragged_rows_class_init (GcsvRaggedRowsClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_ragged_rows_get_property;
+	object_class->set_property = gcsv_ragged_rows_set_property;
+	object_class->constructed = gcsv_ragged_rows_constructed;
+	object_class->dispose = gcsv_ragged_rows_dispose;
+	object_class->finalize = gcsv_ragged_rows_finalize;
+
+	g_object_class_install_property (object_class,
+					 PROP_BUFFER,
+					 g_param_spec_object ("buffer",
+							      "Buffer",
+							      "",
+							      GCSV_TYPE_BUFFER,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GcsvRaggedRows::changed:
+	 * @ragged_rows: the #GcsvRaggedRows who emits the signal.
+	 *
+	 * The ::changed signal is emitted when new results are available, which
+	 * can be partial, see gcsv_ragged_rows_is_complete().
+	 */
+	signals[SIGNAL_CHANGED] =
+		g_signal_new ("changed",
+			      G_TYPE_FROM_CLASS (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL, NULL,
+			      G_TYPE_NONE, 0);
+}
+
+static void
+gcsv_ragged_rows_init (GcsvRaggedRows *ragged_rows)
+{
+	ragged_rows->n_rows_before_chunk = g_array_new (FALSE, FALSE, sizeof (guint));
+}
+
+GcsvRaggedRows *
+gcsv_ragged_rows_new (GcsvBuffer *buffer)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+
+	return g_object_new (GCSV_TYPE_RAGGED_ROWS,
+			     "buffer", buffer,
+			     NULL);
+}
+
+static guint
+get_n_rows_before_chunk (GcsvRaggedRows *ragged_rows,
+			 guint           chunk_index)
+{
+	return g_array_index (ragged_rows->n_rows_before_chunk, guint, chunk_index);
+}
+
+/* Returns: the number of ragged rows found so far. */
+guint
+gcsv_ragged_rows_get_n_rows (GcsvRaggedRows *ragged_rows)
+{
+	g_return_val_if_fail (GCSV_IS_RAGGED_ROWS (ragged_rows), 0);
+
+	return get_n_rows_before_chunk (ragged_rows, ragged_rows->n_rows_before_chunk->len - 1);
+}
+
+guint
+gcsv_ragged_rows_get_expected_n_columns (GcsvRaggedRows *ragged_rows)
+{
+	g_return_val_if_fail (GCSV_IS_RAGGED_ROWS (ragged_rows), 0);
+
+	return ragged_rows->expected_n_columns;
+}
+
+/* Returns: whether all the chunks have been computed since their last
+ * edit.
+ */
+gboolean
+gcsv_ragged_rows_is_complete (GcsvRaggedRows *ragged_rows)
+{
+	g_return_val_if_fail (GCSV_IS_RAGGED_ROWS (ragged_rows), FALSE);
+
+	return (ragged_rows->merge_idle_id == 0 &&
+		gcsv_chunked_tracker_is_complete (ragged_rows->chunked_tracker));
+}
+
+/* Returns: the line offset in the chunk of the first ragged row at or after
+ * @line_offset, or of the last one at or before @line_offset if @backward, or
+ * -1 if there is none. While the chunk is dirty, its runs can go beyond its
+ * current bounds, they are clamped.
+ */
+static gint
+find_in_chunk (GcsvRaggedRows *ragged_rows,
+	       guint           chunk_index,
+	       gint            line_offset,
+	       gboolean        backward)
+{
+	const ChunkRuns *chunk_runs;
+	gint n_lines;
+	gint i;
+
+	chunk_runs = gcsv_chunked_tracker_get_chunk_result (ragged_rows->chunked_tracker, chunk_index);
+
+	if (chunk_runs == NULL)
+	{
+		return -1;
+	}
+
+	if (chunk_index + 1 < gcsv_chunked_tracker_get_n_chunks (ragged_rows->chunked_tracker))
+	{
+		n_lines = get_chunk_start_line (ragged_rows, chunk_index + 1) -
+			  get_chunk_start_line (ragged_rows, chunk_index);
+	}
+	else
+	{
+		n_lines = gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (ragged_rows->buffer)) -
+			  get_chunk_start_line (ragged_rows, chunk_index);
+	}
+
+	if (!backward)
+	{
+		for (i = 0; i < (gint) chunk_runs->runs->len; i++)
+		{
+			const Run *run = &g_array_index (chunk_runs->runs, Run, i);
+			gint run_start = run->line_offset;
+			gint run_end = MIN ((gint) get_run_end (chunk_runs, i), n_lines);
+
+			if (is_ragged (ragged_rows, run) &&
+			    run_end > line_offset &&
+			    run_end > run_start)
+			{
+				return MAX (run_start, line_offset);
+			}
+		}
+	}
+	else
+	{
+		for (i = (gint) chunk_runs->runs->len - 1; i >= 0; i--)
+		{
+			const Run *run = &g_array_index (chunk_runs->runs, Run, i);
+			gint run_start = run->line_offset;
+			gint run_end = MIN ((gint) get_run_end (chunk_runs, i), n_lines);
+
+			if (is_ragged (ragged_rows, run) &&
+			    run_start <= line_offset &&
+			    run_end > run_start)
+			{
+				return MIN (run_end - 1, line_offset);
+			}
+		}
+	}
+
+	return -1;
+}
+
+/* Returns: the index of the first chunk after @chunk_index containing ragged
+ * rows, or -1. @chunk_index can be -1.
+ */
+static gint
+find_next_chunk (GcsvRaggedRows *ragged_rows,
+		 gint            chunk_index)
+{
+	guint n_rows_before = get_n_rows_before_chunk (ragged_rows, chunk_index + 1);
+	gint low = chunk_index + 1;
+	gint high = (gint) gcsv_chunked_tracker_get_n_chunks (ragged_rows->chunked_tracker) - 1;
+	gint result = -1;
+
+	/* The first chunk whose end has more ragged rows before it. */
+	while (low <= high)
+	{
+		gint middle = low + (high - low) / 2;
+
+		if (get_n_rows_before_chunk (ragged_rows, middle + 1) > n_rows_before)
+		{
+			result = middle;
+			high = middle - 1;
+		}
+		else
+		{
+			low = middle + 1;
+		}
+	}
+
+	return result;
+}
+
+/* Returns: the index of the last chunk before @chunk_index containing ragged
+ * rows, or -1. @chunk_index can be the number of chunks.
+ */
+static gint
+find_previous_chunk (GcsvRaggedRows *ragged_rows,
+		     gint            chunk_index)
+{
+	guint n_rows_before = get_n_rows_before_chunk (ragged_rows, chunk_index);
+	gint low = 0;
+	gint high = chunk_index - 1;
+	gint result = -1;
+
+	/* The last chunk whose start has less ragged rows before it. */
+	while (low <= high)
+	{
+		gint middle = low + (high - low) / 2;
+
+		if (get_n_rows_before_chunk (ragged_rows, middle) < n_rows_before)
+		{
+			result = middle;
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+
+	return result;
+}
+
+/* Searches from @line excluded, without wrapping around. @line can be -1 or
+ * the line count.
+ */
+static gboolean
+find_without_wrap (GcsvRaggedRows *ragged_rows,
+		   gint            line,
+		   gboolean        backward,
+		   guint          *found_line)
+{
+	gint n_chunks;
+	gint chunk_index;
+	gint line_offset;
+
+	n_chunks = gcsv_chunked_tracker_get_n_chunks (ragged_rows->chunked_tracker);
+
+	if (line < 0)
+	{
+		chunk_index = -1;
+	}
+	else if (line >= gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (ragged_rows->buffer)))
+	{
+		chunk_index = n_chunks;
+	}
+	else
+	{
+		GtkTextIter iter;
+
+		gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (ragged_rows->buffer), &iter, line);
+		chunk_index = gcsv_chunked_tracker_find_chunk (ragged_rows->chunked_tracker, &iter);
+	}
+
+	/* In the chunk containing @line. */
+	if (chunk_index >= 0 && chunk_index < n_chunks)
+	{
+		line_offset = find_in_chunk (ragged_rows,
+					     chunk_index,
+					     line - get_chunk_start_line (ragged_rows, chunk_index) + (backward ? -1 : 1),
+					     backward);
+
+		if (line_offset >= 0)
+		{
+			*found_line = get_chunk_start_line (ragged_rows, chunk_index) + line_offset;
+			return TRUE;
+		}
+	}
+
+	/* In the next or previous chunks containing ragged rows. A chunk can
+	 * have no ragged row in its current bounds while it is dirty, hence the
+	 * loop.
+	 */
+	while (TRUE)
+	{
+		chunk_index = (backward ?
+			       find_previous_chunk (ragged_rows, chunk_index) :
+			       find_next_chunk (ragged_rows, chunk_index));
+
+		if (chunk_index < 0)
+		{
+			return FALSE;
+		}
+
+		line_offset = find_in_chunk (ragged_rows,
+					     chunk_index,
+					     backward ? G_MAXINT : 0,
+					     backward);
+
+		if (line_offset >= 0)
+		{
+			*found_line = get_chunk_start_line (ragged_rows, chunk_index) + line_offset;
+			return TRUE;
+		}
+	}
+}
+
+/**
+ * gcsv_ragged_rows_find:
+ * @ragged_rows: a #GcsvRaggedRows.
+ * @from_line: the line where to start the search, excluded.
+ * @backward: whether to search the previous ragged row instead of the next
+ *   one.
+ * @found_line: (out): the line of the ragged row.
+ *
+ * Finds the next or previous ragged row, wrapping around at the end or at the
+ * start of the buffer. The chunks edited since their last computation can
+ * give out of date results.
+ *
+ * Returns: whether a ragged row has been found.
+ */
+gboolean
+gcsv_ragged_rows_find (GcsvRaggedRows *ragged_rows,
+		       guint           from_line,
+		       gboolean        backward,
+		       guint          *found_line)
+{
+	gint line_count;
+
+	g_return_val_if_fail (GCSV_IS_RAGGED_ROWS (ragged_rows), FALSE);
+	g_return_val_if_fail (found_line != NULL, FALSE);
+
+	flush_merge (ragged_rows);
+
+	if (gcsv_chunked_tracker_get_n_chunks (ragged_rows->chunked_tracker) == 0)
+	{
+		return FALSE;
+	}
+
+	line_count = gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (ragged_rows->buffer));
+	from_line = MIN (from_line, (guint) line_count - 1);
+
+	if (find_without_wrap (ragged_rows, from_line, backward, found_line))
+	{
+		return TRUE;
+	}
+
+	return find_without_wrap (ragged_rows, backward ? line_count : -1, backward, found_line);
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_RAGGED_ROWS_H
+#define GCSV_RAGGED_ROWS_H
+
+#include <gtk/gtk.h>
+#include "gcsv-buffer.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_RAGGED_ROWS (gcsv_ragged_rows_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvRaggedRows, gcsv_ragged_rows,
+		      GCSV, RAGGED_ROWS,
+		      GObject)
+
+GcsvRaggedRows *	gcsv_ragged_rows_new				(GcsvBuffer *buffer);
+
+guint			gcsv_ragged_rows_get_n_rows			(GcsvRaggedRows *ragged_rows);
+
+guint			gcsv_ragged_rows_get_expected_n_columns		(GcsvRaggedRows *ragged_rows);
+
+gboolean		gcsv_ragged_rows_is_complete			(GcsvRaggedRows *ragged_rows);
+
+gboolean		gcsv_ragged_rows_find				(GcsvRaggedRows *ragged_rows,
+									 guint           from_line,
+									 gboolean        backward,
+									 guint          *found_line);
+
+G_END_DECLS
+
+#endif /* GCSV_RAGGED_ROWS_H */
@@ -0,0 +1,328 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-replace.h"
+#include <string.h>
+
+/* Replaces all the occurrences of a string in some columns, in one pass over
+ * the text. Only the selected fields are searched, the rest of the text is
+ * copied as is.
+ */
+
+typedef struct _Replace Replace;
+struct _Replace
+{
+	const gchar *search;
+	gsize search_length;
+	const gchar *replacement;
+	gsize replacement_length;
+
+	/* Only when the search is case insensitive. */
+	GRegex *regex;
+
+	guint64 n_replacements;
+};
+
+/* Number of lines between two checks of the cancellable. */
+#define CANCELLABLE_CHECK_INTERVAL 4096
+
+static const gchar *
+find_string (const gchar *p,
+	     const gchar *end,
+	     const gchar *str,
+	     gsize        str_length)
+{
+	while ((gsize) (end - p) >= str_length)
+	{
+		p = memchr (p, str[0], end - p - str_length + 1);
+		if (p == NULL)
+		{
+			return NULL;
+		}
+
+		if (memcmp (p, str, str_length) == 0)
+		{
+			return p;
+		}
+
+		p++;
+	}
+
+	return NULL;
+}
+
+static void
+replace_in_field_with_regex (Replace     *replace,
+			     const gchar *field_start,
+			     const gchar *field_end,
+			     GString     *output)
+{
+	GMatchInfo *match_info = NULL;
+	gint pos = 0;
+
+	g_regex_match_full (replace->regex,
+			    field_start,
+			    field_end - field_start,
+			    0, 0,
+			    &match_info,
+			    NULL);
+
+	while (g_match_info_matches (match_info))
+	{
+		gint match_start;
+		gint match_end;
+
+		g_match_info_fetch_pos (match_info, 0, &match_start, &match_end);
+
+		g_string_append_len (output, field_start + pos, match_start - pos);
+		g_string_append_len (output, replace->replacement, replace->replacement_length);
+		replace->n_replacements++;
+		pos = match_end;
+
+		g_match_info_next (match_info, NULL);
+	}
+
+	g_match_info_free (match_info);
+
+	g_string_append_len (output, field_start + pos, (field_end - field_start) - pos);
+}
+
+static void
+replace_in_field (Replace     *replace,
+		  const gchar *field_start,
+		  const gchar *field_end,
+		  GString     *output)
+{
+	const gchar *p = field_start;
+
+	if (replace->regex != NULL)
+	{
+		replace_in_field_with_regex (replace, field_start, field_end, output);
+		return;
+	}
+
+	while (TRUE)
+	{
+		const gchar *match;
+
+		match = find_string (p, field_end, replace->search, replace->search_length);
+		if (match == NULL)
+		{
+			break;
+		}
+
+		g_string_append_len (output, p, match - p);
+		g_string_append_len (output, replace->replacement, replace->replacement_length);
+		replace->n_replacements++;
+		p = match + replace->search_length;
+	}
+
+	g_string_append_len (output, p, field_end - p);
+}
+
+static void
+replace_in_line (Replace             *replace,
+		 const GcsvTokenizer *tokenizer,
+		 GArray              *columns,
+		 const gchar         *line,
+		 const gchar         *line_end,
+		 GString             *output)
+{
+	const gchar *field_start = line;
+	gsize delimiter_length = gcsv_tokenizer_get_delimiter_length (tokenizer);
+	guint column_num = 0;
+	guint columns_pos = 0;
+
+	while (TRUE)
+	{
+		const gchar *field_end;
+		gboolean selected = TRUE;
+
+		if (columns != NULL)
+		{
+			while (columns_pos < columns->len &&
+			       g_array_index (columns, guint, columns_pos) < column_num)
+			{
+				columns_pos++;
+			}
+
+			/* No more selected columns on this line. */
+			if (columns_pos == columns->len)
+			{
+				g_string_append_len (output, field_start, line_end - field_start);
+				return;
+			}
+
+			selected = g_array_index (columns, guint, columns_pos) == column_num;
+		}
+
+		field_end = gcsv_tokenizer_find_delimiter (tokenizer, field_start, line_end);
+		if (field_end == NULL)
+		{
+			field_end = line_end;
+		}
+
+		if (selected)
+		{
+			replace_in_field (replace, field_start, field_end, output);
+		}
+		else
+		{
+			g_string_append_len (output, field_start, field_end - field_start);
+		}
+
+		if (field_end == line_end)
+		{
+			return;
+		}
+
+		g_string_append_len (output, field_end, delimiter_length);
+		field_start = field_end + delimiter_length;
+		column_num++;
+	}
+}
+
+/**
+ * gcsv_replace_in_columns:
+ * @tokenizer: the #GcsvTokenizer to split the lines into fields.
+ * @text: the lines.
+ * @text_end: the end of @text.
+ * @columns: (nullable) (element-type guint): the columns where to replace,
+ *   sorted in increasing order, or %NULL for all the columns.
+ * @search: the string to search, not empty.
+ * @replacement: the string to put instead.
+ * @case_sensitive: whether the search is case sensitive.
+ * @output: where to append the new lines.
+ * @n_replacements: (out) (optional): the number of replacements.
+ * @first_line: (out) (optional): the first line of @text with a replacement.
+ * @last_line: (out) (optional): the last line of @text with a replacement.
+ * @cancellable: (nullable): a #GCancellable.
+ *
+ * Appends @text to @output, with the occurrences of @search replaced by
+ * @replacement in the fields of @columns. The search is literal, and an
+ * occurrence never spans several fields. The line terminators are kept.
+ *
+ * The lines before @first_line and after @last_line are copied as is. Without
+ * replacement, @first_line and @last_line are set to 0.
+ *
+ * Returns: %FALSE if cancelled, in which case @output is incomplete.
+ */
+gboolean
+gcsv_replace_in_columns (const GcsvTokenizer *tokenizer,
+			 const gchar         *text,
+			 const gchar         *text_end,
+			 GArray              *columns,
+			 const gchar         *search,
+			 const gchar         *replacement,
+			 gboolean             case_sensitive,
+			 GString             *output,
+			 guint64             *n_replacements,
+			 guint               *first_line,
+			 guint               *last_line,
+			 GCancellable        *cancellable)
+{
+	Replace replace = { 0 };
+	const gchar *line = text;
+	guint n_lines = 0;
+	guint first_changed_line = 0;
+	guint last_changed_line = 0;
+	gboolean ok = TRUE;
+
+	g_return_val_if_fail (tokenizer != NULL, FALSE);
+	g_return_val_if_fail (text <= text_end, FALSE);
+	g_return_val_if_fail (search != NULL && search[0] != '\0', FALSE);
+	g_return_val_if_fail (g_utf8_validate (search, -1, NULL), FALSE);
+	g_return_val_if_fail (replacement != NULL, FALSE);
+	g_return_val_if_fail (output != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+
+	replace.search = search;
+	replace.search_length = strlen (search);
+	replace.replacement = replacement;
+	replace.replacement_length = strlen (replacement);
+
+	/* Unicode case folding is left to GRegex, with the search escaped. */
+	if (!case_sensitive)
+	{
+		gchar *escaped;
+
+		escaped = g_regex_escape_string (search, -1);
+		replace.regex = g_regex_new (escaped,
+					     G_REGEX_CASELESS | G_REGEX_OPTIMIZE,
+					     0,
+					     NULL);
+		g_free (escaped);
+
+		g_return_val_if_fail (replace.regex != NULL, FALSE);
+	}
+
+	while (line < text_end)
+	{
+		const gchar *line_end;
+		const gchar *next_line;
+		guint64 n_replacements_before = replace.n_replacements;
+
+		line_end = gcsv_tokenizer_find_line_end (line, text_end, &next_line);
+
+		replace_in_line (&replace, tokenizer, columns, line, line_end, output);
+		g_string_append_len (output, line_end, next_line - line_end);
+
+		if (replace.n_replacements > n_replacements_before)
+		{
+			if (n_replacements_before == 0)
+			{
+				first_changed_line = n_lines;
+			}
+
+			last_changed_line = n_lines;
+		}
+
+		line = next_line;
+		n_lines++;
+
+		if (n_lines % CANCELLABLE_CHECK_INTERVAL == 0 &&
+		    g_cancellable_is_cancelled (cancellable))
+		{
+			ok = FALSE;
+			break;
+		}
+	}
+
+	if (replace.regex != NULL)
+	{
+		g_regex_unref (replace.regex);
+	}
+
+	if (n_replacements != NULL)
+	{
+		*n_replacements = replace.n_replacements;
+	}
+
+	if (first_line != NULL)
+	{
+		*first_line = first_changed_line;
+	}
+
+	if (last_line != NULL)
+	{
+		*last_line = last_changed_line;
+	}
+
+	return ok;
+}
@@ -0,0 +1,43 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_REPLACE_H
+#define GCSV_REPLACE_H
+
+#include <gio/gio.h>
+#include "gcsv-tokenizer.h"
+
+G_BEGIN_DECLS
+
+gboolean	gcsv_replace_in_columns		(const GcsvTokenizer *tokenizer,
+						 const gchar         *text,
+						 const gchar         *text_end,
+						 GArray              *columns,
+						 const gchar         *search,
+						 const gchar         *replacement,
+						 gboolean             case_sensitive,
+						 GString             *output,
+						 guint64             *n_replacements,
+						 guint               *first_line,
+						 guint               *last_line,
+						 GCancellable        *cancellable);
+
+G_END_DECLS
+
+#endif /* GCSV_REPLACE_H */
@@ -0,0 +1,502 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-row-filter.h"
+#include "gcsv-chunked-tracker.h"
+
+/* Hides the rows that don't match a GcsvFilter, with an invisible tag. The
+ * text is never modified, so the filter has no effect on the file content,
+ * the undo history or the alignment.
+ *
+ * When the filter is set, the lines after the column titles are matched by
+ * chunks with a GcsvChunkedTracker, and the result of each chunk is applied as
+ * soon as it arrives. The edited chunks are matched again in worker threads
+ * after a short delay, like the other trackers.
+ */
+
+struct _GcsvRowFilter
+{
+	GObject parent;
+
+	GcsvBuffer *buffer;
+
+	/* Applied to the rejected lines, line terminator included. */
+	GtkTextTag *hidden_tag;
+
+	/* NULL if the rows are not filtered. */
+	GcsvFilter *filter;
+	GcsvTokenizer tokenizer;
+
+	GcsvChunkedTracker *chunked_tracker;
+};
+
+/* The parameters of a chunk matching, for the worker thread. */
+typedef struct _JobData JobData;
+struct _JobData
+{
+	GcsvFilter *filter;
+	GcsvTokenizer tokenizer;
+};
+
+enum
+{
+	PROP_0,
+	PROP_BUFFER,
+};
+
+G_DEFINE_TYPE (GcsvRowFilter, gcsv_row_filter, G_TYPE_OBJECT)
+
+/* Shows or hides the lines from @first_line to @last_line included. */
+static void
+set_lines_hidden (GcsvRowFilter *row_filter,
+		  gint           first_line,
+		  gint           last_line,
+		  gboolean       hidden)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (row_filter->buffer);
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_iter_at_line (buffer, &start, first_line);
+
+	if (last_line + 1 < gtk_text_buffer_get_line_count (buffer))
+	{
+		gtk_text_buffer_get_iter_at_line (buffer, &end, last_line + 1);
+	}
+	else
+	{
+		gtk_text_buffer_get_end_iter (buffer, &end);
+	}
+
+	if (hidden)
+	{
+		gtk_text_buffer_apply_tag (buffer, row_filter->hidden_tag, &start, &end);
+	}
+	else
+	{
+		gtk_text_buffer_remove_tag (buffer, row_filter->hidden_tag, &start, &end);
+	}
+}
+
+static gint
+get_first_line (gpointer user_data)
+{
+	GcsvRowFilter *row_filter = GCSV_ROW_FILTER (user_data);
+	GtkTextIter titles_location;
+
+	gcsv_buffer_get_column_titles_location (row_filter->buffer, &titles_location);
+	return gtk_text_iter_get_line (&titles_location) + 1;
+}
+
+/* Filters the whole buffer again. The current hidden lines stay hidden until
+ * the result of their chunk arrives, to avoid flickering.
+ */
+static void
+refilter (gpointer user_data)
+{
+	GcsvRowFilter *row_filter = GCSV_ROW_FILTER (user_data);
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (row_filter->buffer);
+	gunichar delimiter;
+
+	delimiter = gcsv_buffer_get_delimiter (row_filter->buffer);
+
+	if (row_filter->filter == NULL || delimiter == '\0')
+	{
+		GtkTextIter start;
+		GtkTextIter end;
+
+		gcsv_chunked_tracker_stop (row_filter->chunked_tracker);
+
+		gtk_text_buffer_get_bounds (buffer, &start, &end);
+		gtk_text_buffer_remove_tag (buffer, row_filter->hidden_tag, &start, &end);
+		return;
+	}
+
+	gcsv_tokenizer_init (&row_filter->tokenizer, delimiter);
+
+	/* The header and the column titles are always shown. */
+	set_lines_hidden (row_filter, 0, get_first_line (row_filter) - 1, FALSE);
+
+	gcsv_chunked_tracker_start (row_filter->chunked_tracker);
+}
+
+static gpointer
+job_data_new (gpointer user_data)
+{
+	GcsvRowFilter *row_filter = GCSV_ROW_FILTER (user_data);
+	JobData *data;
+
+	data = g_new0 (JobData, 1);
+	data->filter = gcsv_filter_ref (row_filter->filter);
+	data->tokenizer = row_filter->tokenizer;
+
+	return data;
+}
+
+static void
+job_data_free (gpointer user_data)
+{
+	JobData *data = user_data;
+
+	gcsv_filter_unref (data->filter);
+	g_free (data);
+}
+
+/* Returns: the line numbers of the rejected lines, relative to the chunk
+ * start, as guint's.
+ */
+static gpointer
+match_chunk (gpointer     job_data,
+	     const gchar *text,
+	     const gchar *text_end)
+{
+	JobData *data = job_data;
+	GArray *rejected_lines;
+
+	rejected_lines = g_array_new (FALSE, FALSE, sizeof (guint));
+	gcsv_filter_match_lines (data->filter, &data->tokenizer, text, text_end, rejected_lines);
+
+	return rejected_lines;
+}
+
+static void
+apply_chunk_result (gpointer user_data,
+		    guint    chunk_index)
+{
+	GcsvRowFilter *row_filter = GCSV_ROW_FILTER (user_data);
+	GArray *rejected_lines;
+	GtkTextIter start;
+	GtkTextIter end;
+	gint first_line;
+	guint i;
+
+	rejected_lines = gcsv_chunked_tracker_get_chunk_result (row_filter->chunked_tracker, chunk_index);
+	gcsv_chunked_tracker_get_chunk_bounds (row_filter->chunked_tracker, chunk_index, &start, &end);
+
+	gtk_text_buffer_remove_tag (GTK_TEXT_BUFFER (row_filter->buffer),
+				    row_filter->hidden_tag,
+				    &start,
+				    &end);
+
+	first_line = gtk_text_iter_get_line (&start);
+
+	/* Hides the runs of consecutive rejected lines at once. */
+	i = 0;
+	while (i < rejected_lines->len)
+	{
+		guint run_start = g_array_index (rejected_lines, guint, i);
+		guint run_end = run_start;
+
+		for (i++; i < rejected_lines->len; i++)
+		{
+			if (g_array_index (rejected_lines, guint, i) != run_end + 1)
+			{
+				break;
+			}
+
+			run_end++;
+		}
+
+		set_lines_hidden (row_filter, first_line + run_start, first_line + run_end, TRUE);
+	}
+}
+
+static const GcsvChunkedTrackerFuncs chunked_tracker_funcs =
+{
+	get_first_line,
+	refilter,
+	job_data_new,
+	job_data_free,
+	match_chunk,
+	(GDestroyNotify) g_array_unref,
+	apply_chunk_result,
+	NULL,
+};
+
+static gboolean
+is_filtering (GcsvRowFilter *row_filter)
+{
+	return (row_filter->filter != NULL &&
+		gcsv_chunked_tracker_is_started (row_filter->chunked_tracker));
+}
+
+static gboolean
+is_hidden_around (GcsvRowFilter     *row_filter,
+		  const GtkTextIter *start,
+		  const GtkTextIter *end)
+{
+	GtkTextIter before = *start;
+
+	if (!gtk_text_iter_is_end (end))
+	{
+		return gtk_text_iter_has_tag (end, row_filter->hidden_tag);
+	}
+
+	return (gtk_text_iter_backward_char (&before) &&
+		gtk_text_iter_has_tag (&before, row_filter->hidden_tag));
+}
+
+/* The inserted text doesn't inherit the tags. The virtual spaces inserted in a
+ * hidden line must be hidden too, and they don't change the result of the
+ * filter. The other edits are matched again by the chunked tracker.
+ */
+static void
+insert_text_after_cb (GtkTextBuffer *buffer,
+		      GtkTextIter   *location,
+		      const gchar   *text,
+		      gint           length,
+		      GcsvRowFilter *row_filter)
+{
+	GtkTextIter start;
+
+	if (!is_filtering (row_filter) ||
+	    !gcsv_buffer_is_virtual_spaces_edit (row_filter->buffer))
+	{
+		return;
+	}
+
+	start = *location;
+	gtk_text_iter_backward_chars (&start, g_utf8_strlen (text, length));
+
+	if (is_hidden_around (row_filter, &start, location))
+	{
+		gtk_text_buffer_apply_tag (buffer, row_filter->hidden_tag, &start, location);
+	}
+}
+
+static void
+delimiter_notify_cb (GcsvBuffer    *buffer,
+		     GParamSpec    *pspec,
+		     GcsvRowFilter *row_filter)
+{
+	if (row_filter->filter != NULL)
+	{
+		refilter (row_filter);
+	}
+}
+
+static void
+column_titles_set_cb (GcsvBuffer    *buffer,
+		      GcsvRowFilter *row_filter)
+{
+	if (row_filter->filter != NULL)
+	{
+		refilter (row_filter);
+	}
+}
+
+static void
+set_buffer (GcsvRowFilter *row_filter,
+	    GcsvBuffer    *buffer)
+{
+	g_assert (row_filter->buffer == NULL);
+
+	g_return_if_fail (GCSV_IS_BUFFER (buffer));
+	row_filter->buffer = g_object_ref (buffer);
+
+	row_filter->hidden_tag = gtk_text_buffer_create_tag (GTK_TEXT_BUFFER (buffer),
+							     NULL,
+							     "invisible", TRUE,
+							     NULL);
+	g_object_ref (row_filter->hidden_tag);
+
+	row_filter->chunked_tracker = gcsv_chunked_tracker_new (buffer, &chunked_tracker_funcs, row_filter);
+
+	g_signal_connect_object (buffer,
+				 "insert-text",
+				 G_CALLBACK (insert_text_after_cb),
+				 row_filter,
+				 G_CONNECT_AFTER);
+
+	g_signal_connect_object (buffer,
+				 "notify::delimiter",
+				 G_CALLBACK (delimiter_notify_cb),
+				 row_filter,
+				 0);
+
+	g_signal_connect_object (buffer,
+				 "column-titles-set",
+				 G_CALLBACK (column_titles_set_cb),
+				 row_filter,
+				 0);
+
+	g_object_notify (G_OBJECT (row_filter), "buffer");
+}
+
+static void
+gcsv_row_filter_get_property (GObject    *object,
+			      guint       prop_id,
+			      GValue     *value,
+			      GParamSpec *pspec)
+{
+	GcsvRowFilter *row_filter = GCSV_ROW_FILTER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_value_set_object (value, row_filter->buffer);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_row_filter_set_property (GObject      *object,
+			      guint         prop_id,
+			      const GValue *value,
+			      GParamSpec   *pspec)
+{
+	GcsvRowFilter *row_filter = GCSV_ROW_FILTER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			set_buffer (row_filter, g_value_get_object (value));
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_row_filter_dispose (GObject *object)
+{
+	GcsvRowFilter *row_filter = GCSV_ROW_FILTER (object);
+
+	if (row_filter->chunked_tracker != NULL)
+	{
+		gcsv_chunked_tracker_stop (row_filter->chunked_tracker);
+		g_clear_object (&row_filter->chunked_tracker);
+	}
+
+	if (row_filter->hidden_tag != NULL)
+	{
+		GtkTextTagTable *tag_table;
+
+		tag_table = gtk_text_buffer_get_tag_table (GTK_TEXT_BUFFER (row_filter->buffer));
+		gtk_text_tag_table_remove (tag_table, row_filter->hidden_tag);
+		g_clear_object (&row_filter->hidden_tag);
+	}
+
+	g_clear_object (&row_filter->buffer);
+
+	G_OBJECT_CLASS (gcsv_row_filter_parent_class)->dispose (object);
+}
+
+static void
+gcsv_row_filter_finalize (GObject *object)
+{
+	GcsvRowFilter *row_filter = GCSV_ROW_FILTER (object);
+
+	gcsv_filter_unref (row_filter->filter);
+
+	G_OBJECT_CLASS (gcsv_row_filter_parent_class)->finalize (object);
+}
+
+static void
+gcsv_row_filter_class_init (GcsvRowFilterClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_row_filter_get_property;
+	object_class->set_property = gcsv_row_filter_set_property;
+	object_class->dispose = gcsv_row_filter_dispose;
+	object_class->finalize = gcsv_row_filter_finalize;
+
+	g_object_class_install_property (object_class,
+					 PROP_BUFFER,
+					 g_param_spec_object ("buffer",
+							      "Buffer",
+							      "",
+							      GCSV_TYPE_BUFFER,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gcsv_row_filter_init (GcsvRowFilter *row_filter)
+{
+}
+
+GcsvRowFilter *
+gcsv_row_filter_new (GcsvBuffer *buffer)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+
+	return g_object_new (GCSV_TYPE_ROW_FILTER,
+			     "buffer", buffer,
+			     NULL);
+}
+
+/* Sets the filter, or %NULL to show all the rows. The rows are filtered
+ * asynchronously.
+ */
+void
+gcsv_row_filter_set_filter (GcsvRowFilter *row_filter,
+			    GcsvFilter    *filter)
+{
+	g_return_if_fail (GCSV_IS_ROW_FILTER (row_filter));
+
+	if (row_filter->filter == filter)
+	{
+		return;
+	}
+
+	gcsv_filter_unref (row_filter->filter);
+	row_filter->filter = filter != NULL ? gcsv_filter_ref (filter) : NULL;
+
+	refilter (row_filter);
+}
+
+/* Returns: (transfer none) (nullable): the current filter. */
+GcsvFilter *
+gcsv_row_filter_get_filter (GcsvRowFilter *row_filter)
+{
+	g_return_val_if_fail (GCSV_IS_ROW_FILTER (row_filter), NULL);
+
+	return row_filter->filter;
+}
+
+/* Returns whether some results are not yet applied. */
+gboolean
+gcsv_row_filter_is_busy (GcsvRowFilter *row_filter)
+{
+	g_return_val_if_fail (GCSV_IS_ROW_FILTER (row_filter), FALSE);
+
+	return (gcsv_chunked_tracker_is_started (row_filter->chunked_tracker) &&
+		!gcsv_chunked_tracker_is_complete (row_filter->chunked_tracker));
+}
+
+gboolean
+gcsv_row_filter_is_line_hidden (GcsvRowFilter *row_filter,
+				guint          line_num)
+{
+	GtkTextIter iter;
+
+	g_return_val_if_fail (GCSV_IS_ROW_FILTER (row_filter), FALSE);
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (row_filter->buffer), &iter, line_num);
+	return gtk_text_iter_has_tag (&iter, row_filter->hidden_tag);
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_ROW_FILTER_H
+#define GCSV_ROW_FILTER_H
+
+#include <gtk/gtk.h>
+#include "gcsv-buffer.h"
+#include "gcsv-filter.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_ROW_FILTER (gcsv_row_filter_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvRowFilter, gcsv_row_filter,
+		      GCSV, ROW_FILTER,
+		      GObject)
+
+GcsvRowFilter *	gcsv_row_filter_new		(GcsvBuffer *buffer);
+
+void		gcsv_row_filter_set_filter	(GcsvRowFilter *row_filter,
+						 GcsvFilter    *filter);
+
+GcsvFilter *	gcsv_row_filter_get_filter	(GcsvRowFilter *row_filter);
+
+gboolean	gcsv_row_filter_is_busy		(GcsvRowFilter *row_filter);
+
+gboolean	gcsv_row_filter_is_line_hidden	(GcsvRowFilter *row_filter,
+						 guint          line_num);
+
+G_END_DECLS
+
+#endif /* GCSV_ROW_FILTER_H */
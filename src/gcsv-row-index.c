@@ -0,0 +1,291 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-row-index.h"
+
+/* A sparse index of the row offsets in a (possibly memory-mapped) byte array.
+ * Only the offset of one row every CHECKPOINT_INTERVAL rows is stored, the
+ * other rows are found by scanning forward from the previous checkpoint. So
+ * the index takes roughly 8 bytes per CHECKPOINT_INTERVAL rows.
+ *
+ * While building the index, the column lengths are computed too, with the
+ * same rules as GcsvAlignment: a column length is the maximum number of
+ * characters of the fields in that column. Until the index is complete, the
+ * column lengths are computed from the rows indexed so far.
+ *
+ * gcsv_row_index_build() is meant to be called in a worker thread, the other
+ * functions can be called from any thread at the same time.
+ */
+
+struct _GcsvRowIndex
+{
+	GBytes *bytes;
+	const gchar *data;
+	gsize length;
+
+	GcsvTokenizer tokenizer;
+
+	/* Protects the fields below, which are filled progressively by
+	 * gcsv_row_index_build().
+	 */
+	GMutex mutex;
+
+	/* Byte offsets, as gsize's, of the rows 0, CHECKPOINT_INTERVAL,
+	 * 2*CHECKPOINT_INTERVAL, etc.
+	 */
+	GArray *checkpoints;
+
+	guint n_rows;
+
+	GcsvColumnWidths *column_widths;
+
+	guint complete : 1;
+
+	gint ref_count;
+};
+
+#define CHECKPOINT_INTERVAL 64
+
+/* Number of rows to index before making them available to the readers. */
+#define PUBLISH_INTERVAL (64 * 1024)
+
+GcsvRowIndex *
+gcsv_row_index_new (GBytes   *bytes,
+		    gunichar  delimiter)
+{
+	GcsvRowIndex *index;
+
+	g_return_val_if_fail (bytes != NULL, NULL);
+
+	index = g_new0 (GcsvRowIndex, 1);
+	index->ref_count = 1;
+
+	index->bytes = g_bytes_ref (bytes);
+	index->data = g_bytes_get_data (bytes, &index->length);
+
+	gcsv_tokenizer_init (&index->tokenizer, delimiter);
+
+	g_mutex_init (&index->mutex);
+	index->checkpoints = g_array_new (FALSE, FALSE, sizeof (gsize));
+	index->column_widths = gcsv_column_widths_new ();
+
+	return index;
+}
+
+GcsvRowIndex *
+gcsv_row_index_ref (GcsvRowIndex *index)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+
+	g_atomic_int_inc (&index->ref_count);
+	return index;
+}
+
+void
+gcsv_row_index_unref (GcsvRowIndex *index)
+{
+	if (index == NULL)
+	{
+		return;
+	}
+
+	if (g_atomic_int_dec_and_test (&index->ref_count))
+	{
+		g_array_unref (index->checkpoints);
+		gcsv_column_widths_free (index->column_widths);
+		g_mutex_clear (&index->mutex);
+		g_bytes_unref (index->bytes);
+		g_free (index);
+	}
+}
+
+/* Returns: (transfer none): the tokenizer to split the rows into fields. */
+const GcsvTokenizer *
+gcsv_row_index_get_tokenizer (GcsvRowIndex *index)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+
+	return &index->tokenizer;
+}
+
+static void
+publish (GcsvRowIndex     *index,
+	 GArray           *checkpoints,
+	 guint             n_rows,
+	 GcsvColumnWidths *column_widths,
+	 gboolean          complete)
+{
+	g_mutex_lock (&index->mutex);
+
+	g_array_append_vals (index->checkpoints, checkpoints->data, checkpoints->len);
+	index->n_rows = n_rows;
+	gcsv_column_widths_merge (index->column_widths, column_widths);
+	index->complete = complete != FALSE;
+
+	g_mutex_unlock (&index->mutex);
+
+	g_array_set_size (checkpoints, 0);
+}
+
+/* Blocking function, to call in a worker thread. */
+void
+gcsv_row_index_build (GcsvRowIndex *index,
+		      GCancellable *cancellable)
+{
+	const gchar *data_end;
+	const gchar *row_start;
+	GArray *checkpoints;
+	GcsvColumnWidths *column_widths;
+	guint n_rows = 0;
+
+	g_return_if_fail (index != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	data_end = index->data + index->length;
+	row_start = index->data;
+
+	checkpoints = g_array_new (FALSE, FALSE, sizeof (gsize));
+	column_widths = gcsv_column_widths_new ();
+
+	while (row_start < data_end)
+	{
+		const gchar *row_end;
+		const gchar *next_row_start;
+
+		if (n_rows % CHECKPOINT_INTERVAL == 0)
+		{
+			gsize offset = row_start - index->data;
+			g_array_append_val (checkpoints, offset);
+		}
+
+		row_end = gcsv_tokenizer_find_line_end (row_start, data_end, &next_row_start);
+		gcsv_column_widths_add_line (column_widths, &index->tokenizer, row_start, row_end);
+
+		n_rows++;
+		row_start = next_row_start;
+
+		if (n_rows % PUBLISH_INTERVAL == 0)
+		{
+			publish (index, checkpoints, n_rows, column_widths, FALSE);
+
+			if (g_cancellable_is_cancelled (cancellable))
+			{
+				goto out;
+			}
+		}
+	}
+
+	publish (index, checkpoints, n_rows, column_widths, TRUE);
+
+out:
+	g_array_unref (checkpoints);
+	gcsv_column_widths_free (column_widths);
+}
+
+gboolean
+gcsv_row_index_is_complete (GcsvRowIndex *index)
+{
+	gboolean complete;
+
+	g_return_val_if_fail (index != NULL, FALSE);
+
+	g_mutex_lock (&index->mutex);
+	complete = index->complete;
+	g_mutex_unlock (&index->mutex);
+
+	return complete;
+}
+
+/* Returns the number of rows indexed so far. */
+guint
+gcsv_row_index_get_n_rows (GcsvRowIndex *index)
+{
+	guint n_rows;
+
+	g_return_val_if_fail (index != NULL, 0);
+
+	g_mutex_lock (&index->mutex);
+	n_rows = index->n_rows;
+	g_mutex_unlock (&index->mutex);
+
+	return n_rows;
+}
+
+/* Gets the row content, without the line terminator. The returned data points
+ * inside the #GBytes, it is not nul-terminated.
+ */
+gboolean
+gcsv_row_index_get_row (GcsvRowIndex  *index,
+			guint          row_num,
+			const gchar  **row_start,
+			gsize         *row_length)
+{
+	const gchar *data_end;
+	const gchar *p;
+	const gchar *row_end;
+	const gchar *next_row_start;
+	gsize checkpoint;
+	guint i;
+
+	g_return_val_if_fail (index != NULL, FALSE);
+	g_return_val_if_fail (row_start != NULL, FALSE);
+	g_return_val_if_fail (row_length != NULL, FALSE);
+
+	g_mutex_lock (&index->mutex);
+
+	if (row_num >= index->n_rows)
+	{
+		g_mutex_unlock (&index->mutex);
+		return FALSE;
+	}
+
+	checkpoint = g_array_index (index->checkpoints, gsize, row_num / CHECKPOINT_INTERVAL);
+
+	g_mutex_unlock (&index->mutex);
+
+	data_end = index->data + index->length;
+	p = index->data + checkpoint;
+
+	for (i = 0; i < row_num % CHECKPOINT_INTERVAL; i++)
+	{
+		gcsv_tokenizer_find_line_end (p, data_end, &next_row_start);
+		p = next_row_start;
+	}
+
+	row_end = gcsv_tokenizer_find_line_end (p, data_end, &next_row_start);
+
+	*row_start = p;
+	*row_length = row_end - p;
+	return TRUE;
+}
+
+/* Returns: (transfer full): a copy of the column widths computed so far. */
+GcsvColumnWidths *
+gcsv_row_index_get_column_widths (GcsvRowIndex *index)
+{
+	GcsvColumnWidths *copy;
+
+	g_return_val_if_fail (index != NULL, NULL);
+
+	g_mutex_lock (&index->mutex);
+	copy = gcsv_column_widths_copy (index->column_widths);
+	g_mutex_unlock (&index->mutex);
+
+	return copy;
+}
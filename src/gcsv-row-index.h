@@ -0,0 +1,58 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_ROW_INDEX_H
+#define GCSV_ROW_INDEX_H
+
+#include <gio/gio.h>
+#include "gcsv-column-widths.h"
+#include "gcsv-tokenizer.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GcsvRowIndex GcsvRowIndex;
+
+GcsvRowIndex *	gcsv_row_index_new			(GBytes   *bytes,
+							 gunichar  delimiter);
+
+GcsvRowIndex *	gcsv_row_index_ref			(GcsvRowIndex *index);
+
+void		gcsv_row_index_unref			(GcsvRowIndex *index);
+
+const GcsvTokenizer *
+		gcsv_row_index_get_tokenizer		(GcsvRowIndex *index);
+
+void		gcsv_row_index_build			(GcsvRowIndex *index,
+							 GCancellable *cancellable);
+
+gboolean	gcsv_row_index_is_complete		(GcsvRowIndex *index);
+
+guint		gcsv_row_index_get_n_rows		(GcsvRowIndex *index);
+
+gboolean	gcsv_row_index_get_row			(GcsvRowIndex  *index,
+							 guint          row_num,
+							 const gchar  **row_start,
+							 gsize         *row_length);
+
+GcsvColumnWidths *
+		gcsv_row_index_get_column_widths	(GcsvRowIndex *index);
+
+G_END_DECLS
+
+#endif /* GCSV_ROW_INDEX_H */
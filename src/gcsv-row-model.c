@@ -0,0 +1,489 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-row-model.h"
+#include <string.h>
+#include "gcsv-utils.h"
+
+/* A GListModel of the rows of a CSV file, for GcsvGridView. The rows are
+ * decoded on demand, when an item is requested, so only the rows that are
+ * displayed take memory. There are two kinds of backends:
+ *
+ * - A GcsvBuffer: the GtkTextBuffer B-tree is the row-offset index, row N is
+ *   line N of the buffer. The virtual spaces are not part of the fields, and
+ *   the fields can be modified.
+ *
+ * - A GcsvRowIndex, normally over a memory-mapped file, read-only. The number
+ *   of items grows while the index is being built.
+ */
+
+struct _GcsvRow
+{
+	GObject parent;
+
+	guint row_num;
+	gchar **fields;
+	guint n_fields;
+};
+
+struct _GcsvRowModel
+{
+	GObject parent;
+
+	/* Only one of the two is set. */
+	GcsvBuffer *buffer;
+	GcsvRowIndex *index;
+
+	/* The number of items last announced with ::items-changed. */
+	guint n_items;
+
+	guint refresh_timeout_id;
+};
+
+/* Refresh interval in milliseconds, while the row index is being built. */
+#define REFRESH_INTERVAL 250
+
+static void list_model_interface_init (GListModelInterface *iface);
+
+G_DEFINE_TYPE (GcsvRow, gcsv_row, G_TYPE_OBJECT)
+
+G_DEFINE_TYPE_WITH_CODE (GcsvRowModel, gcsv_row_model, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL,
+						list_model_interface_init))
+
+static void
+gcsv_row_finalize (GObject *object)
+{
+	GcsvRow *row = GCSV_ROW (object);
+
+	g_strfreev (row->fields);
+
+	G_OBJECT_CLASS (gcsv_row_parent_class)->finalize (object);
+}
+
+static void
+gcsv_row_class_init (GcsvRowClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = gcsv_row_finalize;
+}
+
+static void
+gcsv_row_init (GcsvRow *row)
+{
+}
+
+/* Takes ownership of @text. */
+static GcsvRow *
+row_new (guint     row_num,
+	 gchar    *text,
+	 gunichar  delimiter)
+{
+	GcsvRow *row;
+
+	row = g_object_new (GCSV_TYPE_ROW, NULL);
+	row->row_num = row_num;
+
+	if (delimiter != '\0' && text[0] != '\0')
+	{
+		gchar delimiter_str[8] = { 0 };
+
+		g_unichar_to_utf8 (delimiter, delimiter_str);
+		row->fields = g_strsplit (text, delimiter_str, -1);
+		g_free (text);
+	}
+	else
+	{
+		/* A row always has at least one field, even if empty. */
+		row->fields = g_new0 (gchar *, 2);
+		row->fields[0] = text;
+	}
+
+	row->n_fields = g_strv_length (row->fields);
+
+	return row;
+}
+
+/* Returns: the row number, which is the line number for a GcsvBuffer. */
+guint
+gcsv_row_get_row_num (GcsvRow *row)
+{
+	g_return_val_if_fail (GCSV_IS_ROW (row), 0);
+
+	return row->row_num;
+}
+
+guint
+gcsv_row_get_n_fields (GcsvRow *row)
+{
+	g_return_val_if_fail (GCSV_IS_ROW (row), 0);
+
+	return row->n_fields;
+}
+
+/* Returns: the field content, without the virtual spaces, or %NULL if the row
+ * doesn't have that column.
+ */
+const gchar *
+gcsv_row_get_field (GcsvRow *row,
+		    guint    column_num)
+{
+	g_return_val_if_fail (GCSV_IS_ROW (row), NULL);
+
+	if (column_num >= row->n_fields)
+	{
+		return NULL;
+	}
+
+	return row->fields[column_num];
+}
+
+static guint
+get_n_items (GcsvRowModel *model)
+{
+	if (model->buffer != NULL)
+	{
+		return gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (model->buffer));
+	}
+
+	if (model->index != NULL)
+	{
+		return gcsv_row_index_get_n_rows (model->index);
+	}
+
+	return 0;
+}
+
+static GType
+gcsv_row_model_get_item_type (GListModel *list)
+{
+	return GCSV_TYPE_ROW;
+}
+
+static guint
+gcsv_row_model_get_n_items (GListModel *list)
+{
+	GcsvRowModel *model = GCSV_ROW_MODEL (list);
+
+	return model->n_items;
+}
+
+static GcsvRow *
+decode_buffer_row (GcsvRowModel *model,
+		   guint         row_num)
+{
+	GtkTextIter line_start;
+	GtkTextIter line_end;
+	gchar *text;
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (model->buffer), &line_start, row_num);
+
+	line_end = line_start;
+	if (!gtk_text_iter_ends_line (&line_end))
+	{
+		gtk_text_iter_forward_to_line_end (&line_end);
+	}
+
+	text = gcsv_buffer_get_text_without_virtual_spaces (model->buffer, &line_start, &line_end);
+
+	return row_new (row_num, text, gcsv_buffer_get_delimiter (model->buffer));
+}
+
+static GcsvRow *
+decode_index_row (GcsvRowModel *model,
+		  guint         row_num)
+{
+	const gchar *row_start;
+	gsize row_length;
+	GString *text;
+
+	if (!gcsv_row_index_get_row (model->index, row_num, &row_start, &row_length))
+	{
+		return NULL;
+	}
+
+	text = g_string_sized_new (row_length);
+	gcsv_utils_append_valid_utf8 (text, row_start, row_length);
+
+	return row_new (row_num,
+			g_string_free (text, FALSE),
+			gcsv_tokenizer_get_delimiter (gcsv_row_index_get_tokenizer (model->index)));
+}
+
+static gpointer
+gcsv_row_model_get_item (GListModel *list,
+			 guint       position)
+{
+	GcsvRowModel *model = GCSV_ROW_MODEL (list);
+
+	if (position >= model->n_items)
+	{
+		return NULL;
+	}
+
+	if (model->buffer != NULL)
+	{
+		return decode_buffer_row (model, position);
+	}
+
+	if (model->index != NULL)
+	{
+		return decode_index_row (model, position);
+	}
+
+	return NULL;
+}
+
+static void
+list_model_interface_init (GListModelInterface *iface)
+{
+	iface->get_item_type = gcsv_row_model_get_item_type;
+	iface->get_n_items = gcsv_row_model_get_n_items;
+	iface->get_item = gcsv_row_model_get_item;
+}
+
+static void
+remove_refresh_timeout (GcsvRowModel *model)
+{
+	if (model->refresh_timeout_id != 0)
+	{
+		g_source_remove (model->refresh_timeout_id);
+		model->refresh_timeout_id = 0;
+	}
+}
+
+static void
+gcsv_row_model_dispose (GObject *object)
+{
+	GcsvRowModel *model = GCSV_ROW_MODEL (object);
+
+	remove_refresh_timeout (model);
+	g_clear_object (&model->buffer);
+
+	if (model->index != NULL)
+	{
+		gcsv_row_index_unref (model->index);
+		model->index = NULL;
+	}
+
+	G_OBJECT_CLASS (gcsv_row_model_parent_class)->dispose (object);
+}
+
+static void
+gcsv_row_model_class_init (GcsvRowModelClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gcsv_row_model_dispose;
+}
+
+static void
+gcsv_row_model_init (GcsvRowModel *model)
+{
+}
+
+/* The text insertion or deletion has been done, @location is at the end of the
+ * inserted text, or at the place of the deleted text. Everything is expressed
+ * in lines: the line at @location has changed, and the difference in the
+ * number of lines has been added or removed just before it.
+ */
+static void
+lines_changed (GcsvRowModel      *model,
+	       const GtkTextIter *location)
+{
+	guint old_n_items;
+	guint new_n_items;
+	guint line;
+
+	old_n_items = model->n_items;
+	new_n_items = get_n_items (model);
+	model->n_items = new_n_items;
+
+	line = gtk_text_iter_get_line (location);
+
+	if (new_n_items >= old_n_items)
+	{
+		guint n_added = new_n_items - old_n_items;
+
+		g_list_model_items_changed (G_LIST_MODEL (model), line - n_added, 1, n_added + 1);
+	}
+	else
+	{
+		guint n_removed = old_n_items - new_n_items;
+
+		g_list_model_items_changed (G_LIST_MODEL (model), line, n_removed + 1, 1);
+	}
+}
+
+static void
+insert_text_after_cb (GtkTextBuffer *buffer,
+		      GtkTextIter   *location,
+		      const gchar   *text,
+		      gint           length,
+		      GcsvRowModel  *model)
+{
+	/* The virtual spaces are not part of the fields. */
+	if (gcsv_buffer_is_virtual_spaces_edit (model->buffer))
+	{
+		return;
+	}
+
+	lines_changed (model, location);
+}
+
+static void
+delete_range_after_cb (GtkTextBuffer *buffer,
+		       GtkTextIter   *start,
+		       GtkTextIter   *end,
+		       GcsvRowModel  *model)
+{
+	/* The virtual spaces are not part of the fields. */
+	if (gcsv_buffer_is_virtual_spaces_edit (model->buffer))
+	{
+		return;
+	}
+
+	lines_changed (model, start);
+}
+
+static void
+delimiter_notify_cb (GcsvBuffer   *buffer,
+		     GParamSpec   *pspec,
+		     GcsvRowModel *model)
+{
+	/* All the rows are split differently. */
+	g_list_model_items_changed (G_LIST_MODEL (model), 0, model->n_items, model->n_items);
+}
+
+GcsvRowModel *
+gcsv_row_model_new_for_buffer (GcsvBuffer *buffer)
+{
+	GcsvRowModel *model;
+
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+
+	model = g_object_new (GCSV_TYPE_ROW_MODEL, NULL);
+	model->buffer = g_object_ref (buffer);
+	model->n_items = get_n_items (model);
+
+	g_signal_connect_object (buffer,
+				 "insert-text",
+				 G_CALLBACK (insert_text_after_cb),
+				 model,
+				 G_CONNECT_AFTER);
+
+	g_signal_connect_object (buffer,
+				 "delete-range",
+				 G_CALLBACK (delete_range_after_cb),
+				 model,
+				 G_CONNECT_AFTER);
+
+	g_signal_connect_object (buffer,
+				 "notify::delimiter",
+				 G_CALLBACK (delimiter_notify_cb),
+				 model,
+				 0);
+
+	return model;
+}
+
+static gboolean
+refresh_timeout_cb (gpointer user_data)
+{
+	GcsvRowModel *model = GCSV_ROW_MODEL (user_data);
+	gboolean complete;
+	guint old_n_items;
+
+	/* Check completeness before getting the number of rows, to not miss
+	 * the last rows.
+	 */
+	complete = gcsv_row_index_is_complete (model->index);
+
+	old_n_items = model->n_items;
+	model->n_items = get_n_items (model);
+
+	if (model->n_items > old_n_items)
+	{
+		g_list_model_items_changed (G_LIST_MODEL (model),
+					    old_n_items,
+					    0,
+					    model->n_items - old_n_items);
+	}
+
+	if (complete)
+	{
+		model->refresh_timeout_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/* The index can be in the process of being built, in which case the rows are
+ * added progressively to the model.
+ */
+GcsvRowModel *
+gcsv_row_model_new_for_row_index (GcsvRowIndex *index)
+{
+	GcsvRowModel *model;
+
+	g_return_val_if_fail (index != NULL, NULL);
+
+	model = g_object_new (GCSV_TYPE_ROW_MODEL, NULL);
+	model->index = gcsv_row_index_ref (index);
+	model->n_items = get_n_items (model);
+
+	if (!gcsv_row_index_is_complete (index))
+	{
+		model->refresh_timeout_id = g_timeout_add (REFRESH_INTERVAL,
+							   refresh_timeout_cb,
+							   model);
+	}
+
+	return model;
+}
+
+gboolean
+gcsv_row_model_is_editable (GcsvRowModel *model)
+{
+	g_return_val_if_fail (GCSV_IS_ROW_MODEL (model), FALSE);
+
+	return model->buffer != NULL;
+}
+
+/* Writes back a field to the GcsvBuffer. Returns FALSE if the model is not
+ * editable or if the row doesn't have that column.
+ */
+gboolean
+gcsv_row_model_set_field (GcsvRowModel *model,
+			  guint         row_num,
+			  guint         column_num,
+			  const gchar  *text)
+{
+	g_return_val_if_fail (GCSV_IS_ROW_MODEL (model), FALSE);
+	g_return_val_if_fail (text != NULL, FALSE);
+
+	if (model->buffer == NULL)
+	{
+		return FALSE;
+	}
+
+	return gcsv_buffer_set_field_text (model->buffer, row_num, column_num, text);
+}
@@ -0,0 +1,59 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_ROW_MODEL_H
+#define GCSV_ROW_MODEL_H
+
+#include <gio/gio.h>
+#include "gcsv-buffer.h"
+#include "gcsv-row-index.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_ROW (gcsv_row_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvRow, gcsv_row,
+		      GCSV, ROW,
+		      GObject)
+
+#define GCSV_TYPE_ROW_MODEL (gcsv_row_model_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvRowModel, gcsv_row_model,
+		      GCSV, ROW_MODEL,
+		      GObject)
+
+guint			gcsv_row_get_row_num			(GcsvRow *row);
+
+guint			gcsv_row_get_n_fields			(GcsvRow *row);
+
+const gchar *		gcsv_row_get_field			(GcsvRow *row,
+								 guint    column_num);
+
+GcsvRowModel *		gcsv_row_model_new_for_buffer		(GcsvBuffer *buffer);
+
+GcsvRowModel *		gcsv_row_model_new_for_row_index	(GcsvRowIndex *index);
+
+gboolean		gcsv_row_model_is_editable		(GcsvRowModel *model);
+
+gboolean		gcsv_row_model_set_field		(GcsvRowModel *model,
+								 guint         row_num,
+								 guint         column_num,
+								 const gchar  *text);
+
+G_END_DECLS
+
+#endif /* GCSV_ROW_MODEL_H */
@@ -0,0 +1,636 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-search-bar.h"
+#include <glib/gi18n.h>
+#include "gcsv-buffer.h"
+
+struct _GcsvSearchBar
+{
+	GtkGrid parent;
+
+	GtkTextView *view;
+	GcsvColumnSearch *search;
+
+	GtkSearchEntry *entry;
+	GtkEntry *columns_entry;
+	GtkCheckButton *case_sensitive_checkbutton;
+	GtkLabel *status_label;
+
+	GtkEntry *replace_entry;
+	GtkWidget *replace_all_button;
+	GCancellable *replace_cancellable;
+	gint64 replace_start_time;
+};
+
+enum
+{
+	PROP_0,
+	PROP_VIEW,
+	PROP_SEARCH,
+};
+
+/* Like the spin buttons of the other bars. */
+#define MAX_COLUMN_NUM 9999
+
+G_DEFINE_TYPE (GcsvSearchBar, gcsv_search_bar, GTK_TYPE_GRID)
+
+static void
+set_entry_error (GtkEntry    *entry,
+		 const gchar *error_message)
+{
+	GtkStyleContext *style_context;
+
+	style_context = gtk_widget_get_style_context (GTK_WIDGET (entry));
+
+	if (error_message != NULL)
+	{
+		gtk_style_context_add_class (style_context, GTK_STYLE_CLASS_ERROR);
+	}
+	else
+	{
+		gtk_style_context_remove_class (style_context, GTK_STYLE_CLASS_ERROR);
+	}
+
+	gtk_widget_set_tooltip_text (GTK_WIDGET (entry), error_message);
+}
+
+/* Parses a list of column numbers starting at 1, and of ranges, for example
+ * "1, 3-5", into 0-based column numbers.
+ * Returns: (transfer full) (nullable): the column numbers, or %NULL on error.
+ */
+static GArray *
+parse_columns (const gchar *text)
+{
+	GArray *columns;
+	gchar **items;
+	gint i;
+
+	columns = g_array_new (FALSE, FALSE, sizeof (guint));
+	items = g_strsplit (text, ",", -1);
+
+	for (i = 0; items[i] != NULL; i++)
+	{
+		const gchar *p = items[i];
+		gchar *end;
+		guint64 first;
+		guint64 last;
+		guint64 column_num;
+
+		first = g_ascii_strtoull (p, &end, 10);
+		if (end == p || first == 0 || first > MAX_COLUMN_NUM)
+		{
+			goto error;
+		}
+
+		last = first;
+		p = end;
+		while (g_ascii_isspace (*p))
+		{
+			p++;
+		}
+
+		if (*p == '-')
+		{
+			p++;
+			last = g_ascii_strtoull (p, &end, 10);
+			if (end == p || last < first || last > MAX_COLUMN_NUM)
+			{
+				goto error;
+			}
+
+			p = end;
+		}
+
+		while (g_ascii_isspace (*p))
+		{
+			p++;
+		}
+
+		if (*p != '\0')
+		{
+			goto error;
+		}
+
+		for (column_num = first; column_num <= last; column_num++)
+		{
+			guint value = column_num - 1;
+			g_array_append_val (columns, value);
+		}
+	}
+
+	g_strfreev (items);
+	return columns;
+
+error:
+	g_strfreev (items);
+	g_array_unref (columns);
+	return NULL;
+}
+
+/* Returns whether the columns are valid. */
+static gboolean
+update_columns (GcsvSearchBar *bar)
+{
+	const gchar *text;
+	GArray *columns;
+
+	text = gtk_entry_get_text (bar->columns_entry);
+
+	if (text == NULL || text[0] == '\0')
+	{
+		set_entry_error (bar->columns_entry, NULL);
+		gcsv_column_search_set_columns (bar->search, NULL);
+		return TRUE;
+	}
+
+	columns = parse_columns (text);
+	if (columns == NULL)
+	{
+		set_entry_error (bar->columns_entry, _("Expected column numbers, for example “1, 3-5”."));
+		return FALSE;
+	}
+
+	set_entry_error (bar->columns_entry, NULL);
+	gcsv_column_search_set_columns (bar->search, columns);
+	g_array_unref (columns);
+	return TRUE;
+}
+
+static void
+update_status (GcsvSearchBar *bar,
+	       gboolean       found)
+{
+	const gchar *pattern;
+
+	pattern = gtk_entry_get_text (GTK_ENTRY (bar->entry));
+
+	if (pattern[0] != '\0' && !found)
+	{
+		gtk_label_set_text (bar->status_label, _("Not found"));
+	}
+	else if (gcsv_column_search_is_indexing (bar->search))
+	{
+		gtk_label_set_text (bar->status_label, _("Indexing…"));
+	}
+	else
+	{
+		gtk_label_set_text (bar->status_label, NULL);
+	}
+}
+
+/* @from_selection_end: whether to search after the selection, to find the
+ * next match, or at the selection start, to search as the pattern is typed.
+ */
+static void
+find (GcsvSearchBar *bar,
+      gboolean       backward,
+      gboolean       from_selection_end)
+{
+	GtkTextBuffer *buffer;
+	const gchar *pattern;
+	GtkTextIter selection_start;
+	GtkTextIter selection_end;
+	GtkTextIter match_start;
+	GtkTextIter match_end;
+	gboolean found = FALSE;
+
+	if (bar->view == NULL || bar->search == NULL)
+	{
+		return;
+	}
+
+	pattern = gtk_entry_get_text (GTK_ENTRY (bar->entry));
+
+	if (pattern[0] != '\0' && update_columns (bar))
+	{
+		buffer = gtk_text_view_get_buffer (bar->view);
+		gtk_text_buffer_get_selection_bounds (buffer, &selection_start, &selection_end);
+
+		gcsv_column_search_set_case_sensitive (bar->search,
+						       gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (bar->case_sensitive_checkbutton)));
+
+		found = gcsv_column_search_find (bar->search,
+						 pattern,
+						 backward || !from_selection_end ? &selection_start : &selection_end,
+						 backward,
+						 &match_start,
+						 &match_end);
+
+		if (found)
+		{
+			gtk_text_buffer_select_range (buffer, &match_start, &match_end);
+			gtk_text_view_scroll_to_mark (bar->view,
+						      gtk_text_buffer_get_insert (buffer),
+						      0.25, FALSE, 0.0, 0.0);
+		}
+	}
+
+	update_status (bar, found);
+}
+
+static void
+replace_all_cb (GObject      *source_object,
+		GAsyncResult *result,
+		gpointer      user_data)
+{
+	GcsvSearchBar *bar = GCSV_SEARCH_BAR (user_data);
+	guint64 n_replacements = 0;
+	GError *error = NULL;
+
+	gcsv_buffer_replace_in_columns_finish (GCSV_BUFFER (source_object),
+					       result,
+					       &n_replacements,
+					       &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		/* The bar is being destroyed. */
+		g_error_free (error);
+		g_object_unref (bar);
+		return;
+	}
+
+	g_clear_object (&bar->replace_cancellable);
+	gtk_widget_set_sensitive (bar->replace_all_button, TRUE);
+
+	if (bar->view != NULL)
+	{
+		gtk_text_view_set_editable (bar->view, TRUE);
+	}
+
+	if (error != NULL)
+	{
+		gtk_label_set_text (bar->status_label, error->message);
+		g_error_free (error);
+	}
+	else
+	{
+		gchar *n_replacements_str;
+		gdouble seconds;
+		gchar *status;
+
+		n_replacements_str = g_strdup_printf ("%" G_GUINT64_FORMAT, n_replacements);
+		seconds = (g_get_monotonic_time () - bar->replace_start_time) / (gdouble) G_USEC_PER_SEC;
+
+		/* Translators: the first %s is a number of replacements, the
+		 * second is a duration in seconds.
+		 */
+		status = g_strdup_printf (ngettext ("%s replacement in %.2f s",
+						    "%s replacements in %.2f s",
+						    (gulong) MIN (n_replacements, G_MAXULONG)),
+					  n_replacements_str,
+					  seconds);
+		gtk_label_set_text (bar->status_label, status);
+		g_free (n_replacements_str);
+		g_free (status);
+	}
+
+	g_object_unref (bar);
+}
+
+static void
+replace_all (GcsvSearchBar *bar)
+{
+	const gchar *pattern;
+	const gchar *columns_text;
+	GArray *columns = NULL;
+
+	if (bar->view == NULL || bar->replace_cancellable != NULL)
+	{
+		return;
+	}
+
+	pattern = gtk_entry_get_text (GTK_ENTRY (bar->entry));
+	if (pattern[0] == '\0' || !update_columns (bar))
+	{
+		return;
+	}
+
+	columns_text = gtk_entry_get_text (bar->columns_entry);
+	if (columns_text[0] != '\0')
+	{
+		columns = parse_columns (columns_text);
+	}
+
+	/* The buffer must not change until the replacement is applied. */
+	gtk_text_view_set_editable (bar->view, FALSE);
+	gtk_widget_set_sensitive (bar->replace_all_button, FALSE);
+	gtk_label_set_text (bar->status_label, _("Replacing…"));
+
+	bar->replace_cancellable = g_cancellable_new ();
+	bar->replace_start_time = g_get_monotonic_time ();
+
+	gcsv_buffer_replace_in_columns_async (GCSV_BUFFER (gtk_text_view_get_buffer (bar->view)),
+					      columns,
+					      pattern,
+					      gtk_entry_get_text (bar->replace_entry),
+					      gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (bar->case_sensitive_checkbutton)),
+					      bar->replace_cancellable,
+					      replace_all_cb,
+					      g_object_ref (bar));
+
+	if (columns != NULL)
+	{
+		g_array_unref (columns);
+	}
+}
+
+static void
+gcsv_search_bar_get_property (GObject    *object,
+			      guint       prop_id,
+			      GValue     *value,
+			      GParamSpec *pspec)
+{
+	GcsvSearchBar *bar = GCSV_SEARCH_BAR (object);
+
+	switch (prop_id)
+	{
+		case PROP_VIEW:
+			g_value_set_object (value, bar->view);
+			break;
+
+		case PROP_SEARCH:
+			g_value_set_object (value, bar->search);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_search_bar_set_property (GObject      *object,
+			      guint         prop_id,
+			      const GValue *value,
+			      GParamSpec   *pspec)
+{
+	GcsvSearchBar *bar = GCSV_SEARCH_BAR (object);
+
+	switch (prop_id)
+	{
+		case PROP_VIEW:
+			g_assert (bar->view == NULL);
+			bar->view = g_value_dup_object (value);
+			break;
+
+		case PROP_SEARCH:
+			g_assert (bar->search == NULL);
+			bar->search = g_value_dup_object (value);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_search_bar_dispose (GObject *object)
+{
+	GcsvSearchBar *bar = GCSV_SEARCH_BAR (object);
+
+	if (bar->replace_cancellable != NULL)
+	{
+		g_cancellable_cancel (bar->replace_cancellable);
+		g_clear_object (&bar->replace_cancellable);
+
+		if (bar->view != NULL)
+		{
+			gtk_text_view_set_editable (bar->view, TRUE);
+		}
+	}
+
+	g_clear_object (&bar->view);
+	g_clear_object (&bar->search);
+
+	G_OBJECT_CLASS (gcsv_search_bar_parent_class)->dispose (object);
+}
+
+static void
+gcsv_search_bar_class_init (GcsvSearchBarClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_search_bar_get_property;
+	object_class->set_property = gcsv_search_bar_set_property;
+	object_class->dispose = gcsv_search_bar_dispose;
+
+	g_object_class_install_property (object_class,
+					 PROP_VIEW,
+					 g_param_spec_object ("view",
+							      "View",
+							      "",
+							      GTK_TYPE_TEXT_VIEW,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (object_class,
+					 PROP_SEARCH,
+					 g_param_spec_object ("search",
+							      "Search",
+							      "",
+							      GCSV_TYPE_COLUMN_SEARCH,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+}
+
+/* "search-changed" is emitted with a short delay after the last keystroke. */
+static void
+entry_search_changed_cb (GtkSearchEntry *entry,
+			 GcsvSearchBar  *bar)
+{
+	find (bar, FALSE, FALSE);
+}
+
+static void
+entry_activate_cb (GtkEntry      *entry,
+		   GcsvSearchBar *bar)
+{
+	find (bar, FALSE, TRUE);
+}
+
+static void
+entry_next_match_cb (GtkSearchEntry *entry,
+		     GcsvSearchBar  *bar)
+{
+	find (bar, FALSE, TRUE);
+}
+
+static void
+entry_previous_match_cb (GtkSearchEntry *entry,
+			 GcsvSearchBar  *bar)
+{
+	find (bar, TRUE, FALSE);
+}
+
+static void
+columns_entry_changed_cb (GtkEntry      *columns_entry,
+			  GcsvSearchBar *bar)
+{
+	find (bar, FALSE, FALSE);
+}
+
+static void
+case_sensitive_toggled_cb (GtkToggleButton *checkbutton,
+			   GcsvSearchBar   *bar)
+{
+	find (bar, FALSE, FALSE);
+}
+
+static void
+previous_button_clicked_cb (GtkButton     *button,
+			    GcsvSearchBar *bar)
+{
+	find (bar, TRUE, FALSE);
+}
+
+static void
+next_button_clicked_cb (GtkButton     *button,
+			GcsvSearchBar *bar)
+{
+	find (bar, FALSE, TRUE);
+}
+
+static void
+replace_all_button_clicked_cb (GtkButton     *button,
+			       GcsvSearchBar *bar)
+{
+	replace_all (bar);
+}
+
+static void
+gcsv_search_bar_init (GcsvSearchBar *bar)
+{
+	GtkWidget *label;
+	GtkWidget *previous_button;
+	GtkWidget *next_button;
+
+	gtk_orientable_set_orientation (GTK_ORIENTABLE (bar), GTK_ORIENTATION_HORIZONTAL);
+	gtk_grid_set_column_spacing (GTK_GRID (bar), 6);
+
+	bar->entry = GTK_SEARCH_ENTRY (gtk_search_entry_new ());
+	gtk_widget_set_hexpand (GTK_WIDGET (bar->entry), TRUE);
+	gtk_container_add (GTK_CONTAINER (bar), GTK_WIDGET (bar->entry));
+
+	g_signal_connect (bar->entry,
+			  "search-changed",
+			  G_CALLBACK (entry_search_changed_cb),
+			  bar);
+
+	g_signal_connect (bar->entry,
+			  "activate",
+			  G_CALLBACK (entry_activate_cb),
+			  bar);
+
+	g_signal_connect (bar->entry,
+			  "next-match",
+			  G_CALLBACK (entry_next_match_cb),
+			  bar);
+
+	g_signal_connect (bar->entry,
+			  "previous-match",
+			  G_CALLBACK (entry_previous_match_cb),
+			  bar);
+
+	previous_button = gtk_button_new_from_icon_name ("go-up-symbolic", GTK_ICON_SIZE_BUTTON);
+	gtk_widget_set_tooltip_text (previous_button, _("Find the previous match"));
+	gtk_container_add (GTK_CONTAINER (bar), previous_button);
+
+	g_signal_connect (previous_button,
+			  "clicked",
+			  G_CALLBACK (previous_button_clicked_cb),
+			  bar);
+
+	next_button = gtk_button_new_from_icon_name ("go-down-symbolic", GTK_ICON_SIZE_BUTTON);
+	gtk_widget_set_tooltip_text (next_button, _("Find the next match"));
+	gtk_container_add (GTK_CONTAINER (bar), next_button);
+
+	g_signal_connect (next_button,
+			  "clicked",
+			  G_CALLBACK (next_button_clicked_cb),
+			  bar);
+
+	label = gtk_label_new_with_mnemonic (_("in the co_lumns"));
+	gtk_container_add (GTK_CONTAINER (bar), label);
+
+	bar->columns_entry = GTK_ENTRY (gtk_entry_new ());
+	gtk_entry_set_placeholder_text (bar->columns_entry, _("All"));
+	gtk_entry_set_width_chars (bar->columns_entry, 10);
+	gtk_container_add (GTK_CONTAINER (bar), GTK_WIDGET (bar->columns_entry));
+
+	gtk_label_set_mnemonic_widget (GTK_LABEL (label), GTK_WIDGET (bar->columns_entry));
+
+	g_signal_connect (bar->columns_entry,
+			  "changed",
+			  G_CALLBACK (columns_entry_changed_cb),
+			  bar);
+
+	bar->case_sensitive_checkbutton = GTK_CHECK_BUTTON (gtk_check_button_new_with_mnemonic (_("_Match case")));
+	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (bar->case_sensitive_checkbutton), TRUE);
+	gtk_container_add (GTK_CONTAINER (bar), GTK_WIDGET (bar->case_sensitive_checkbutton));
+
+	g_signal_connect (bar->case_sensitive_checkbutton,
+			  "toggled",
+			  G_CALLBACK (case_sensitive_toggled_cb),
+			  bar);
+
+	bar->replace_entry = GTK_ENTRY (gtk_entry_new ());
+	gtk_entry_set_placeholder_text (bar->replace_entry, _("Replace with"));
+	gtk_widget_set_tooltip_text (GTK_WIDGET (bar->replace_entry), _("The replacement text"));
+	gtk_container_add (GTK_CONTAINER (bar), GTK_WIDGET (bar->replace_entry));
+
+	bar->replace_all_button = gtk_button_new_with_mnemonic (_("Replace _All"));
+	gtk_widget_set_tooltip_text (bar->replace_all_button,
+				     _("Replace all the matches in the columns, in one edit"));
+	gtk_container_add (GTK_CONTAINER (bar), bar->replace_all_button);
+
+	g_signal_connect (bar->replace_all_button,
+			  "clicked",
+			  G_CALLBACK (replace_all_button_clicked_cb),
+			  bar);
+
+	bar->status_label = GTK_LABEL (gtk_label_new (NULL));
+	gtk_container_add (GTK_CONTAINER (bar), GTK_WIDGET (bar->status_label));
+}
+
+GcsvSearchBar *
+gcsv_search_bar_new (GtkTextView      *view,
+		     GcsvColumnSearch *search)
+{
+	g_return_val_if_fail (GTK_IS_TEXT_VIEW (view), NULL);
+	g_return_val_if_fail (GCSV_IS_COLUMN_SEARCH (search), NULL);
+
+	return g_object_new (GCSV_TYPE_SEARCH_BAR,
+			     "view", view,
+			     "search", search,
+			     "margin", 6,
+			     NULL);
+}
+
+void
+gcsv_search_bar_grab_focus (GcsvSearchBar *bar)
+{
+	g_return_if_fail (GCSV_IS_SEARCH_BAR (bar));
+
+	gtk_widget_grab_focus (GTK_WIDGET (bar->entry));
+}
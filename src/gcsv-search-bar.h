@@ -0,0 +1,40 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_SEARCH_BAR_H
+#define GCSV_SEARCH_BAR_H
+
+#include <gtk/gtk.h>
+#include "gcsv-column-search.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_SEARCH_BAR (gcsv_search_bar_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvSearchBar, gcsv_search_bar,
+		      GCSV, SEARCH_BAR,
+		      GtkGrid)
+
+GcsvSearchBar *	gcsv_search_bar_new		(GtkTextView      *view,
+						 GcsvColumnSearch *search);
+
+void		gcsv_search_bar_grab_focus	(GcsvSearchBar *bar);
+
+G_END_DECLS
+
+#endif /* GCSV_SEARCH_BAR_H */
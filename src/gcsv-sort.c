@@ -0,0 +1,521 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-sort.h"
+#include <math.h>
+#include <string.h>
+
+/* Stable sort of the lines of a text by the content of one column.
+ *
+ * The key column of each line is parsed once into a compact SortItem, then the
+ * array of SortItem's is sorted with a merge sort: first each chunk of the
+ * array is sorted in a GThreadPool worker, then the sorted chunks are merged
+ * pairwise, the merges of a same round running in parallel. The output text is
+ * then written in one pass.
+ */
+
+typedef struct _SortItem SortItem;
+struct _SortItem
+{
+	union
+	{
+		gdouble number;
+
+		struct
+		{
+			const gchar *str;
+			gsize length;
+		} bytes;
+	} key;
+
+	/* The start of the line in the text. */
+	const gchar *line;
+};
+
+typedef gint (* CompareFunc) (const SortItem *a,
+			      const SortItem *b);
+
+typedef struct _Job Job;
+struct _Job
+{
+	CompareFunc compare;
+	SortItem *items;
+	SortItem *tmp;
+
+	GMutex mutex;
+	GCond cond;
+	guint n_pending_tasks;
+};
+
+/* A chunk to sort, or two adjacent runs to merge. */
+typedef struct _Task Task;
+struct _Task
+{
+	gsize start;
+	gsize middle;
+	gsize end;
+
+	/* For a merge: the runs are read from src and written to dst. */
+	SortItem *src;
+	SortItem *dst;
+};
+
+/* Under this number of items, the sort is not split between threads. */
+#define MIN_CHUNK_SIZE (16 * 1024)
+
+#define INSERTION_SORT_THRESHOLD 16
+
+static gint
+compare_numbers (const SortItem *a,
+		 const SortItem *b)
+{
+	gboolean a_is_nan = isnan (a->key.number);
+	gboolean b_is_nan = isnan (b->key.number);
+
+	if (a_is_nan || b_is_nan)
+	{
+		return a_is_nan - b_is_nan;
+	}
+
+	if (a->key.number < b->key.number)
+	{
+		return -1;
+	}
+
+	return a->key.number > b->key.number;
+}
+
+static gint
+compare_bytes (const SortItem *a,
+	       const SortItem *b)
+{
+	gint result;
+
+	result = memcmp (a->key.bytes.str,
+			 b->key.bytes.str,
+			 MIN (a->key.bytes.length, b->key.bytes.length));
+
+	if (result != 0)
+	{
+		return result;
+	}
+
+	if (a->key.bytes.length < b->key.bytes.length)
+	{
+		return -1;
+	}
+
+	return a->key.bytes.length > b->key.bytes.length;
+}
+
+static gdouble
+parse_number (const gchar *start,
+	      const gchar *end)
+{
+	gdouble number;
+
+	if (!gcsv_tokenizer_parse_number (start, end, &number))
+	{
+		return NAN;
+	}
+
+	return number;
+}
+
+static void
+insertion_sort (SortItem    *items,
+		gsize        n_items,
+		CompareFunc  compare)
+{
+	gsize i;
+
+	for (i = 1; i < n_items; i++)
+	{
+		SortItem item = items[i];
+		gsize j = i;
+
+		while (j > 0 && compare (&items[j - 1], &item) > 0)
+		{
+			items[j] = items[j - 1];
+			j--;
+		}
+
+		items[j] = item;
+	}
+}
+
+/* Stable: on equal keys, the item of @a goes first. */
+static void
+merge (const SortItem *a,
+       gsize           n_a,
+       const SortItem *b,
+       gsize           n_b,
+       SortItem       *out,
+       CompareFunc     compare)
+{
+	const SortItem *a_end = a + n_a;
+	const SortItem *b_end = b + n_b;
+
+	while (a < a_end && b < b_end)
+	{
+		if (compare (b, a) < 0)
+		{
+			*out++ = *b++;
+		}
+		else
+		{
+			*out++ = *a++;
+		}
+	}
+
+	memcpy (out, a, (a_end - a) * sizeof (SortItem));
+	out += a_end - a;
+	memcpy (out, b, (b_end - b) * sizeof (SortItem));
+}
+
+/* Sorts @items, using @tmp of the same size as scratch space. */
+static void
+merge_sort (SortItem    *items,
+	    SortItem    *tmp,
+	    gsize        n_items,
+	    CompareFunc  compare)
+{
+	gsize middle;
+
+	if (n_items <= INSERTION_SORT_THRESHOLD)
+	{
+		insertion_sort (items, n_items, compare);
+		return;
+	}
+
+	middle = n_items / 2;
+	merge_sort (items, tmp, middle, compare);
+	merge_sort (items + middle, tmp + middle, n_items - middle, compare);
+
+	/* Already in order, common for partially sorted data. */
+	if (compare (&items[middle - 1], &items[middle]) <= 0)
+	{
+		return;
+	}
+
+	merge (items, middle, items + middle, n_items - middle, tmp, compare);
+	memcpy (items, tmp, n_items * sizeof (SortItem));
+}
+
+static void
+task_func (gpointer data,
+	   gpointer user_data)
+{
+	Task *task = data;
+	Job *job = user_data;
+
+	if (task->src == NULL)
+	{
+		merge_sort (job->items + task->start,
+			    job->tmp + task->start,
+			    task->end - task->start,
+			    job->compare);
+	}
+	else
+	{
+		merge (task->src + task->start,
+		       task->middle - task->start,
+		       task->src + task->middle,
+		       task->end - task->middle,
+		       task->dst + task->start,
+		       job->compare);
+	}
+
+	g_mutex_lock (&job->mutex);
+	job->n_pending_tasks--;
+	g_cond_signal (&job->cond);
+	g_mutex_unlock (&job->mutex);
+}
+
+static void
+run_tasks (Job         *job,
+	   GThreadPool *pool,
+	   Task        *tasks,
+	   guint        n_tasks)
+{
+	guint i;
+
+	job->n_pending_tasks = n_tasks;
+
+	for (i = 0; i < n_tasks; i++)
+	{
+		g_thread_pool_push (pool, &tasks[i], NULL);
+	}
+
+	g_mutex_lock (&job->mutex);
+	while (job->n_pending_tasks > 0)
+	{
+		g_cond_wait (&job->cond, &job->mutex);
+	}
+	g_mutex_unlock (&job->mutex);
+}
+
+/* Returns: whether it was not cancelled. */
+static gboolean
+parallel_merge_sort (Job          *job,
+		     gsize         n_items,
+		     GCancellable *cancellable)
+{
+	GThreadPool *pool;
+	GArray *run_starts;
+	Task *tasks;
+	guint n_chunks;
+	SortItem *src;
+	SortItem *dst;
+	guint i;
+	gboolean ok = TRUE;
+
+	n_chunks = CLAMP (n_items / MIN_CHUNK_SIZE, 1, g_get_num_processors ());
+
+	if (n_chunks == 1)
+	{
+		merge_sort (job->items, job->tmp, n_items, job->compare);
+		return TRUE;
+	}
+
+	pool = g_thread_pool_new (task_func, job, n_chunks, TRUE, NULL);
+	tasks = g_new0 (Task, n_chunks);
+
+	/* The boundaries of the sorted runs, with n_items at the end. */
+	run_starts = g_array_new (FALSE, FALSE, sizeof (gsize));
+
+	for (i = 0; i <= n_chunks; i++)
+	{
+		gsize run_start = n_items * i / n_chunks;
+
+		g_array_append_val (run_starts, run_start);
+
+		if (i < n_chunks)
+		{
+			tasks[i].start = run_start;
+			tasks[i].end = n_items * (i + 1) / n_chunks;
+		}
+	}
+
+	run_tasks (job, pool, tasks, n_chunks);
+
+	src = job->items;
+	dst = job->tmp;
+
+	/* Merges the runs pairwise until only one remains. */
+	while (run_starts->len > 2)
+	{
+		GArray *new_run_starts;
+		guint n_tasks = 0;
+
+		if (g_cancellable_is_cancelled (cancellable))
+		{
+			ok = FALSE;
+			break;
+		}
+
+		new_run_starts = g_array_new (FALSE, FALSE, sizeof (gsize));
+
+		for (i = 0; i + 1 < run_starts->len; i += 2)
+		{
+			gsize start = g_array_index (run_starts, gsize, i);
+
+			g_array_append_val (new_run_starts, start);
+
+			if (i + 2 < run_starts->len)
+			{
+				tasks[n_tasks].start = start;
+				tasks[n_tasks].middle = g_array_index (run_starts, gsize, i + 1);
+				tasks[n_tasks].end = g_array_index (run_starts, gsize, i + 2);
+				tasks[n_tasks].src = src;
+				tasks[n_tasks].dst = dst;
+				n_tasks++;
+			}
+			else
+			{
+				/* Odd run, just copied. */
+				gsize end = g_array_index (run_starts, gsize, i + 1);
+
+				memcpy (dst + start, src + start, (end - start) * sizeof (SortItem));
+			}
+		}
+
+		g_array_append_val (new_run_starts, n_items);
+
+		run_tasks (job, pool, tasks, n_tasks);
+
+		g_array_unref (run_starts);
+		run_starts = new_run_starts;
+
+		src = dst;
+		dst = (src == job->items) ? job->tmp : job->items;
+	}
+
+	if (ok && src != job->items)
+	{
+		memcpy (job->items, src, n_items * sizeof (SortItem));
+	}
+
+	g_thread_pool_free (pool, FALSE, TRUE);
+	g_array_unref (run_starts);
+	g_free (tasks);
+
+	return ok;
+}
+
+static void
+append_line (GString     *output,
+	     const gchar *line,
+	     const gchar *text_end,
+	     gboolean     last_line,
+	     gboolean     terminated)
+{
+	const gchar *line_end;
+	const gchar *next_line_start;
+
+	line_end = gcsv_tokenizer_find_line_end (line, text_end, &next_line_start);
+	g_string_append_len (output, line, line_end - line);
+
+	if (last_line && !terminated)
+	{
+		return;
+	}
+
+	if (line_end < next_line_start)
+	{
+		g_string_append_len (output, line_end, next_line_start - line_end);
+	}
+	else
+	{
+		/* It was the last line, without line terminator. */
+		g_string_append_c (output, '\n');
+	}
+}
+
+/* Sorts the lines of @text by the field at @column_num, and appends the result
+ * to @output. The sort is stable, and the lines without that column are
+ * considered to have an empty field. The line terminators are kept, and
+ * whether @text ends with a line terminator too.
+ *
+ * Blocking function, to call in a worker thread for large texts. It uses
+ * itself several threads.
+ *
+ * Returns: %FALSE if it was cancelled, %TRUE otherwise.
+ */
+gboolean
+gcsv_sort_lines (const GcsvTokenizer *tokenizer,
+		 const gchar         *text,
+		 gsize                text_length,
+		 guint                column_num,
+		 GcsvSortMode         mode,
+		 GString             *output,
+		 GCancellable        *cancellable)
+{
+	const gchar *text_end = text + text_length;
+	const gchar *p = text;
+	GArray *items;
+	Job job;
+	gboolean terminated;
+	gboolean ok;
+	guint i;
+
+	g_return_val_if_fail (tokenizer != NULL, FALSE);
+	g_return_val_if_fail (text != NULL || text_length == 0, FALSE);
+	g_return_val_if_fail (output != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+
+	items = g_array_new (FALSE, FALSE, sizeof (SortItem));
+
+	while (p < text_end)
+	{
+		const gchar *line_end;
+		const gchar *next_line_start;
+		const gchar *field_start;
+		const gchar *field_end;
+		SortItem item;
+
+		line_end = gcsv_tokenizer_find_line_end (p, text_end, &next_line_start);
+
+		if (!gcsv_tokenizer_get_field_bounds (tokenizer, p, line_end, column_num, &field_start, &field_end))
+		{
+			field_start = field_end = line_end;
+		}
+
+		switch (mode)
+		{
+			case GCSV_SORT_MODE_NUMERIC:
+				item.key.number = parse_number (field_start, field_end);
+				break;
+
+			case GCSV_SORT_MODE_COLLATE:
+				item.key.bytes.str = g_utf8_collate_key (field_start, field_end - field_start);
+				item.key.bytes.length = strlen (item.key.bytes.str);
+				break;
+
+			case GCSV_SORT_MODE_LEXICOGRAPHIC:
+			default:
+				item.key.bytes.str = field_start;
+				item.key.bytes.length = field_end - field_start;
+				break;
+		}
+
+		item.line = p;
+		g_array_append_val (items, item);
+
+		p = next_line_start;
+	}
+
+	job.compare = mode == GCSV_SORT_MODE_NUMERIC ? compare_numbers : compare_bytes;
+	job.items = (SortItem *) (gpointer) items->data;
+	job.tmp = g_new (SortItem, MAX (items->len, 1));
+	g_mutex_init (&job.mutex);
+	g_cond_init (&job.cond);
+
+	ok = (!g_cancellable_is_cancelled (cancellable) &&
+	      parallel_merge_sort (&job, items->len, cancellable));
+
+	if (ok)
+	{
+		terminated = text_length > 0 && text_end[-1] == '\n';
+
+		for (i = 0; i < items->len; i++)
+		{
+			append_line (output,
+				     job.items[i].line,
+				     text_end,
+				     i == items->len - 1,
+				     terminated);
+		}
+	}
+
+	if (mode == GCSV_SORT_MODE_COLLATE)
+	{
+		for (i = 0; i < items->len; i++)
+		{
+			g_free ((gchar *) g_array_index (items, SortItem, i).key.bytes.str);
+		}
+	}
+
+	g_mutex_clear (&job.mutex);
+	g_cond_clear (&job.cond);
+	g_free (job.tmp);
+	g_array_unref (items);
+
+	return ok;
+}
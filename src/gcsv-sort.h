@@ -0,0 +1,53 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_SORT_H
+#define GCSV_SORT_H
+
+#include <gio/gio.h>
+#include "gcsv-tokenizer.h"
+
+G_BEGIN_DECLS
+
+/**
+ * GcsvSortMode:
+ * @GCSV_SORT_MODE_LEXICOGRAPHIC: compares the bytes of the fields.
+ * @GCSV_SORT_MODE_NUMERIC: compares the fields as decimal numbers, the fields
+ *   that are not numbers come last.
+ * @GCSV_SORT_MODE_COLLATE: compares the fields with the collation rules of the
+ *   current locale.
+ */
+typedef enum
+{
+	GCSV_SORT_MODE_LEXICOGRAPHIC,
+	GCSV_SORT_MODE_NUMERIC,
+	GCSV_SORT_MODE_COLLATE,
+} GcsvSortMode;
+
+gboolean	gcsv_sort_lines		(const GcsvTokenizer *tokenizer,
+					 const gchar         *text,
+					 gsize                text_length,
+					 guint                column_num,
+					 GcsvSortMode         mode,
+					 GString             *output,
+					 GCancellable        *cancellable);
+
+G_END_DECLS
+
+#endif /* GCSV_SORT_H */
@@ -0,0 +1,343 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-stats-panel.h"
+#include <glib/gi18n.h>
+
+/* Shows the GcsvColumnStats of a GcsvColumnStatsTracker. The panel only
+ * displays the stats, they are computed in the background by the tracker.
+ */
+
+struct _GcsvStatsPanel
+{
+	GtkGrid parent;
+
+	GcsvColumnStatsTracker *tracker;
+
+	GtkSpinButton *column_spinbutton;
+	GtkLabel *status_label;
+
+	GtkLabel *count_label;
+	GtkLabel *n_empty_label;
+	GtkLabel *n_numbers_label;
+	GtkLabel *min_label;
+	GtkLabel *max_label;
+	GtkLabel *mean_label;
+	GtkLabel *stddev_label;
+	GtkLabel *n_distinct_label;
+	GtkLabel *top_values_label;
+};
+
+enum
+{
+	PROP_0,
+	PROP_TRACKER,
+};
+
+/* Number of most frequent values shown. */
+#define N_TOP_VALUES 5
+
+/* Number of lines of the grid before the statistics. */
+#define FIRST_STAT_ROW 2
+
+G_DEFINE_TYPE (GcsvStatsPanel, gcsv_stats_panel, GTK_TYPE_GRID)
+
+static void
+set_label_uint64 (GtkLabel *label,
+		  guint64   value)
+{
+	gchar *text;
+
+	text = g_strdup_printf ("%" G_GUINT64_FORMAT, value);
+	gtk_label_set_text (label, text);
+	g_free (text);
+}
+
+static void
+set_label_double (GtkLabel *label,
+		  gboolean  has_value,
+		  gdouble   value)
+{
+	gchar *text;
+
+	if (!has_value)
+	{
+		gtk_label_set_text (label, "—");
+		return;
+	}
+
+	text = g_strdup_printf ("%g", value);
+	gtk_label_set_text (label, text);
+	g_free (text);
+}
+
+static void
+update_top_values (GcsvStatsPanel        *panel,
+		   const GcsvColumnStats *stats)
+{
+	GPtrArray *top_values;
+	GString *text;
+	guint i;
+
+	top_values = gcsv_column_stats_get_top_values (stats, N_TOP_VALUES);
+	text = g_string_new (NULL);
+
+	for (i = 0; i < top_values->len; i++)
+	{
+		GcsvValueCount *value_count = g_ptr_array_index (top_values, i);
+
+		if (i > 0)
+		{
+			g_string_append_c (text, '\n');
+		}
+
+		g_string_append_printf (text, "%s (%" G_GUINT64_FORMAT ")",
+					value_count->value,
+					value_count->count);
+	}
+
+	gtk_label_set_text (panel->top_values_label, text->str);
+
+	g_string_free (text, TRUE);
+	g_ptr_array_unref (top_values);
+}
+
+static void
+update (GcsvStatsPanel *panel)
+{
+	const GcsvColumnStats *stats;
+	gboolean has_numbers;
+
+	stats = gcsv_column_stats_tracker_get_stats (panel->tracker);
+
+	if (stats == NULL)
+	{
+		gtk_label_set_text (panel->status_label, _("No delimiter"));
+		return;
+	}
+
+	if (gcsv_column_stats_tracker_is_complete (panel->tracker))
+	{
+		gtk_label_set_text (panel->status_label, NULL);
+	}
+	else
+	{
+		gtk_label_set_text (panel->status_label, _("Computing…"));
+	}
+
+	has_numbers = gcsv_column_stats_get_n_numbers (stats) > 0;
+
+	set_label_uint64 (panel->count_label, gcsv_column_stats_get_count (stats));
+	set_label_uint64 (panel->n_empty_label, gcsv_column_stats_get_n_empty (stats));
+	set_label_uint64 (panel->n_numbers_label, gcsv_column_stats_get_n_numbers (stats));
+	set_label_double (panel->min_label, has_numbers, gcsv_column_stats_get_min (stats));
+	set_label_double (panel->max_label, has_numbers, gcsv_column_stats_get_max (stats));
+	set_label_double (panel->mean_label, has_numbers, gcsv_column_stats_get_mean (stats));
+	set_label_double (panel->stddev_label, has_numbers, gcsv_column_stats_get_stddev (stats));
+	set_label_uint64 (panel->n_distinct_label, gcsv_column_stats_get_n_distinct (stats));
+	update_top_values (panel, stats);
+}
+
+static void
+tracker_changed_cb (GcsvColumnStatsTracker *tracker,
+		    GcsvStatsPanel         *panel)
+{
+	update (panel);
+}
+
+static void
+set_tracker (GcsvStatsPanel         *panel,
+	     GcsvColumnStatsTracker *tracker)
+{
+	g_assert (panel->tracker == NULL);
+
+	g_return_if_fail (GCSV_IS_COLUMN_STATS_TRACKER (tracker));
+	panel->tracker = g_object_ref (tracker);
+
+	gtk_spin_button_set_value (panel->column_spinbutton,
+				   gcsv_column_stats_tracker_get_column_num (tracker) + 1);
+
+	g_signal_connect_object (tracker,
+				 "changed",
+				 G_CALLBACK (tracker_changed_cb),
+				 panel,
+				 0);
+
+	update (panel);
+}
+
+static void
+gcsv_stats_panel_get_property (GObject    *object,
+			       guint       prop_id,
+			       GValue     *value,
+			       GParamSpec *pspec)
+{
+	GcsvStatsPanel *panel = GCSV_STATS_PANEL (object);
+
+	switch (prop_id)
+	{
+		case PROP_TRACKER:
+			g_value_set_object (value, panel->tracker);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_stats_panel_set_property (GObject      *object,
+			       guint         prop_id,
+			       const GValue *value,
+			       GParamSpec   *pspec)
+{
+	GcsvStatsPanel *panel = GCSV_STATS_PANEL (object);
+
+	switch (prop_id)
+	{
+		case PROP_TRACKER:
+			set_tracker (panel, g_value_get_object (value));
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_stats_panel_dispose (GObject *object)
+{
+	GcsvStatsPanel *panel = GCSV_STATS_PANEL (object);
+
+	g_clear_object (&panel->tracker);
+
+	G_OBJECT_CLASS (gcsv_stats_panel_parent_class)->dispose (object);
+}
+
+static void
+gcsv_stats_panel_class_init (GcsvStatsPanelClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_stats_panel_get_property;
+	object_class->set_property = gcsv_stats_panel_set_property;
+	object_class->dispose = gcsv_stats_panel_dispose;
+
+	g_object_class_install_property (object_class,
+					 PROP_TRACKER,
+					 g_param_spec_object ("tracker",
+							      "Tracker",
+							      "",
+							      GCSV_TYPE_COLUMN_STATS_TRACKER,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+}
+
+static void
+column_spinbutton_value_changed_cb (GtkSpinButton  *column_spinbutton,
+				    GcsvStatsPanel *panel)
+{
+	if (panel->tracker != NULL)
+	{
+		gcsv_column_stats_tracker_set_column_num (panel->tracker,
+							  gtk_spin_button_get_value_as_int (column_spinbutton) - 1);
+	}
+}
+
+static GtkLabel *
+add_stat_row (GcsvStatsPanel *panel,
+	      gint            row,
+	      const gchar    *title)
+{
+	GtkWidget *title_label;
+	GtkWidget *value_label;
+
+	title_label = gtk_label_new (title);
+	gtk_widget_set_halign (title_label, GTK_ALIGN_END);
+	gtk_widget_set_valign (title_label, GTK_ALIGN_START);
+	gtk_style_context_add_class (gtk_widget_get_style_context (title_label),
+				     GTK_STYLE_CLASS_DIM_LABEL);
+	gtk_grid_attach (GTK_GRID (panel), title_label, 0, FIRST_STAT_ROW + row, 1, 1);
+
+	value_label = gtk_label_new (NULL);
+	gtk_widget_set_halign (value_label, GTK_ALIGN_START);
+	gtk_label_set_selectable (GTK_LABEL (value_label), TRUE);
+	gtk_label_set_ellipsize (GTK_LABEL (value_label), PANGO_ELLIPSIZE_END);
+	gtk_label_set_max_width_chars (GTK_LABEL (value_label), 30);
+	gtk_grid_attach (GTK_GRID (panel), value_label, 1, FIRST_STAT_ROW + row, 1, 1);
+
+	return GTK_LABEL (value_label);
+}
+
+static void
+gcsv_stats_panel_init (GcsvStatsPanel *panel)
+{
+	GtkWidget *label;
+	gint row = 0;
+
+	gtk_grid_set_row_spacing (GTK_GRID (panel), 6);
+	gtk_grid_set_column_spacing (GTK_GRID (panel), 12);
+
+	label = gtk_label_new_with_mnemonic (_("Statistics of the co_lumn"));
+	gtk_widget_set_halign (label, GTK_ALIGN_END);
+	gtk_grid_attach (GTK_GRID (panel), label, 0, 0, 1, 1);
+
+	panel->column_spinbutton = GTK_SPIN_BUTTON (gtk_spin_button_new_with_range (1, 9999, 1));
+	gtk_widget_set_halign (GTK_WIDGET (panel->column_spinbutton), GTK_ALIGN_START);
+	gtk_grid_attach (GTK_GRID (panel), GTK_WIDGET (panel->column_spinbutton), 1, 0, 1, 1);
+
+	gtk_label_set_mnemonic_widget (GTK_LABEL (label),
+				       GTK_WIDGET (panel->column_spinbutton));
+
+	g_signal_connect (panel->column_spinbutton,
+			  "value-changed",
+			  G_CALLBACK (column_spinbutton_value_changed_cb),
+			  panel);
+
+	panel->status_label = GTK_LABEL (gtk_label_new (NULL));
+	gtk_widget_set_halign (GTK_WIDGET (panel->status_label), GTK_ALIGN_START);
+	gtk_grid_attach (GTK_GRID (panel), GTK_WIDGET (panel->status_label), 1, 1, 1, 1);
+
+	panel->count_label = add_stat_row (panel, row++, _("Rows"));
+	panel->n_empty_label = add_stat_row (panel, row++, _("Empty"));
+	panel->n_numbers_label = add_stat_row (panel, row++, _("Numbers"));
+	panel->min_label = add_stat_row (panel, row++, _("Minimum"));
+	panel->max_label = add_stat_row (panel, row++, _("Maximum"));
+	panel->mean_label = add_stat_row (panel, row++, _("Mean"));
+	panel->stddev_label = add_stat_row (panel, row++, _("Standard deviation"));
+	panel->n_distinct_label = add_stat_row (panel, row++, _("Distinct values (approx.)"));
+	panel->top_values_label = add_stat_row (panel, row++, _("Most frequent"));
+
+	gtk_label_set_ellipsize (panel->top_values_label, PANGO_ELLIPSIZE_NONE);
+	gtk_label_set_lines (panel->top_values_label, N_TOP_VALUES);
+}
+
+GcsvStatsPanel *
+gcsv_stats_panel_new (GcsvColumnStatsTracker *tracker)
+{
+	g_return_val_if_fail (GCSV_IS_COLUMN_STATS_TRACKER (tracker), NULL);
+
+	return g_object_new (GCSV_TYPE_STATS_PANEL,
+			     "tracker", tracker,
+			     "margin", 6,
+			     NULL);
+}
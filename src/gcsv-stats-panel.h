@@ -0,0 +1,37 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_STATS_PANEL_H
+#define GCSV_STATS_PANEL_H
+
+#include <gtk/gtk.h>
+#include "gcsv-column-stats-tracker.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_STATS_PANEL (gcsv_stats_panel_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvStatsPanel, gcsv_stats_panel,
+		      GCSV, STATS_PANEL,
+		      GtkGrid)
+
+GcsvStatsPanel *	gcsv_stats_panel_new		(GcsvColumnStatsTracker *tracker);
+
+G_END_DECLS
+
+#endif /* GCSV_STATS_PANEL_H */
@@ -18,13 +18,153 @@
  */
 
 #include "gcsv-tab.h"
+#include <string.h>
 #include <glib/gi18n.h>
 #include "gcsv-buffer.h"
+#include "gcsv-file-follower.h"
+#include "gcsv-file-reloader.h"
+#include "gcsv-filter-bar.h"
+#include "gcsv-grid-view.h"
+#include "gcsv-journal-writer.h"
+#include "gcsv-large-file-view.h"
 #include "gcsv-properties-chooser.h"
+#include "gcsv-search-bar.h"
+#include "gcsv-stats-panel.h"
+#include "gcsv-tokenizer.h"
+#include "gcsv-utils.h"
 
 struct _GcsvTabPrivate
 {
 	GcsvAlignment *align;
+
+	/* For the read-only mode. The file content is memory-mapped and shown
+	 * in the GcsvLargeFileView instead of the TeplView.
+	 */
+	GBytes *mapped_bytes;
+	GcsvLargeFileView *large_file_view;
+
+	/* Shown instead of the TeplView when enabled. */
+	GcsvGridView *grid_view;
+
+	GcsvRowFilter *row_filter;
+
+	/* Always kept up to date, for the statusbar. */
+	GcsvRaggedRows *ragged_rows;
+
+	/* Shown below the view when enabled. */
+	GcsvFilterBar *filter_bar;
+
+	/* Created when the search bar is shown for the first time, and kept
+	 * afterwards so that its index is reused.
+	 */
+	GcsvColumnSearch *column_search;
+	GcsvSearchBar *search_bar;
+
+	/* Created only while the stats panel is shown, so that the stats are
+	 * not computed otherwise.
+	 */
+	GcsvColumnStatsTracker *stats_tracker;
+	GcsvStatsPanel *stats_panel;
+
+	/* Non-NULL while a sort is running. */
+	GCancellable *sort_cancellable;
+
+	/* Non-NULL while the file is followed. The mark has a right gravity,
+	 * so it stays at the end of the buffer, for the auto-scroll.
+	 */
+	GcsvFileFollower *file_follower;
+	GtkTextMark *follow_end_mark;
+
+	/* Reloads the changed lines when the file is rewritten. Not used while
+	 * the file is followed.
+	 */
+	GcsvFileReloader *file_reloader;
+
+	/* Records the unsaved edits, to recover them after a crash. Created
+	 * only when the buffer content is the one of the file.
+	 */
+	GcsvJournalWriter *journal_writer;
+
+	/* The compression format of the file, detected when loading it. The
+	 * file is saved back in the same format.
+	 */
+	GcsvCompression compression;
+
+	/* The line terminators of the file, detected when loading it. The file
+	 * is saved with the same ones. TeplFile knows them only for the files
+	 * loaded with TeplFileLoader.
+	 */
+	TeplNewlineType newline_type;
+
+	/* The entity tag of the file when it has been loaded or saved, to not
+	 * overwrite the changes done by another program.
+	 */
+	gchar *etag;
+
+	/* A save requested while another one is running, launched when it is
+	 * finished.
+	 */
+	GFile *pending_save_location;
+	GcsvCompression pending_save_compression;
+
+	guint follow_auto_scroll : 1;
+	guint saving : 1;
+};
+
+enum
+{
+	PROP_0,
+	PROP_FOLLOW_ENABLED,
+	PROP_COMPRESSED,
+	PROP_CAN_FOLLOW,
+};
+
+/* For loading compressed files. */
+typedef struct _CompressedFileData CompressedFileData;
+struct _CompressedFileData
+{
+	GFile *location;
+	GcsvCompression compression;
+	guint implicit_trailing_newline : 1;
+
+	/* Filled by the thread. */
+	gchar *etag;
+	TeplNewlineType newline_type;
+
+	/* The uncompressed content, filled by the thread. */
+	GString *text;
+};
+
+/* The snapshot of the buffer content, written by a worker thread. */
+typedef struct _SaveData SaveData;
+struct _SaveData
+{
+	GFile *location;
+	GcsvCompression compression;
+	TeplNewlineType newline_type;
+	guint implicit_trailing_newline : 1;
+
+	/* The expected entity tag of the file, and the one after the save,
+	 * filled by the thread.
+	 */
+	gchar *etag;
+	gchar *new_etag;
+
+	/* The charset of the file, or NULL for UTF-8. */
+	gchar *charset;
+
+	/* With the virtual spaces, removed by the thread from the offsets of
+	 * the tag toggles.
+	 */
+	gchar *text;
+	gsize text_length;
+	GArray *virtual_spaces;
+
+	/* See gcsv_buffer_get_change_count(). */
+	guint64 change_count;
+
+	/* The journal writer when the snapshot has been taken. */
+	GcsvJournalWriter *journal_writer;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GcsvTab, gcsv_tab, TEPL_TYPE_TAB)
@@ -61,12 +201,87 @@ create_view (void)
 	return TEPL_VIEW (view);
 }
 
+/* From this number of columns, only the visible columns are aligned. */
+#define WIDE_FILE_MIN_COLUMNS 100
+
+/* Returns: the last column visible at the right edge of the view, on the line
+ * at @y.
+ */
+static gint
+get_last_visible_column (GtkTextView        *view,
+			 const GdkRectangle *visible_rect,
+			 gint                y)
+{
+	GtkTextIter iter;
+
+	gtk_text_view_get_iter_at_location (view,
+					    &iter,
+					    visible_rect->x + visible_rect->width,
+					    y);
+
+	return gcsv_buffer_get_column_num (GCSV_BUFFER (gtk_text_view_get_buffer (view)), &iter);
+}
+
+static void
+update_alignment_viewport (GcsvTab *tab)
+{
+	GtkTextView *view;
+	GcsvBuffer *buffer;
+	GdkRectangle visible_rect;
+	GtkTextIter first;
+	GtkTextIter last;
+	gint last_visible_column = -1;
+
+	if (tab->priv->align == NULL)
+	{
+		return;
+	}
+
+	view = GTK_TEXT_VIEW (tepl_tab_get_view (TEPL_TAB (tab)));
+	buffer = GCSV_BUFFER (gtk_text_view_get_buffer (view));
+	gtk_text_view_get_visible_rect (view, &visible_rect);
+
+	gtk_text_view_get_line_at_y (view, &first, visible_rect.y, NULL);
+	gtk_text_view_get_line_at_y (view, &last, visible_rect.y + visible_rect.height, NULL);
+
+	gcsv_alignment_set_viewport (tab->priv->align,
+				     gtk_text_iter_get_line (&first),
+				     gtk_text_iter_get_line (&last));
+
+	/* The first visible line can be the column titles, which are not
+	 * aligned, so the last visible line is taken into account too.
+	 */
+	if (gcsv_buffer_count_columns_at_line (buffer, gtk_text_iter_get_line (&last)) >= WIDE_FILE_MIN_COLUMNS)
+	{
+		last_visible_column = MAX (get_last_visible_column (view, &visible_rect, visible_rect.y),
+					   get_last_visible_column (view, &visible_rect, visible_rect.y + visible_rect.height - 1));
+	}
+
+	gcsv_alignment_set_last_visible_column (tab->priv->align, last_visible_column);
+}
+
+static void
+view_size_allocate_cb (GtkWidget     *view,
+		       GtkAllocation *allocation,
+		       GcsvTab       *tab)
+{
+	update_alignment_viewport (tab);
+}
+
+static void
+adjustment_value_changed_cb (GtkAdjustment *adjustment,
+			     GcsvTab       *tab)
+{
+	update_alignment_viewport (tab);
+}
+
 static void
 gcsv_tab_constructed (GObject *object)
 {
 	GcsvTab *tab = GCSV_TAB (object);
 	GcsvBuffer *buffer;
 	GcsvPropertiesChooser *properties_chooser;
+	TeplView *view;
 
 	G_OBJECT_CLASS (gcsv_tab_parent_class)->constructed (object);
 
@@ -76,6 +291,164 @@ gcsv_tab_constructed (GObject *object)
 	gtk_grid_attach (GTK_GRID (tab), GTK_WIDGET (properties_chooser), 0, 0, 1, 1);
 
 	tab->priv->align = gcsv_alignment_new (buffer);
+	tab->priv->row_filter = gcsv_row_filter_new (buffer);
+	tab->priv->ragged_rows = gcsv_ragged_rows_new (buffer);
+
+	view = tepl_tab_get_view (TEPL_TAB (tab));
+	gcsv_alignment_set_view (tab->priv->align, GTK_WIDGET (view));
+
+	g_signal_connect_object (view,
+				 "size-allocate",
+				 G_CALLBACK (view_size_allocate_cb),
+				 tab,
+				 0);
+
+	g_signal_connect_object (gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (view)),
+				 "value-changed",
+				 G_CALLBACK (adjustment_value_changed_cb),
+				 tab,
+				 0);
+
+	g_signal_connect_object (gtk_scrollable_get_hadjustment (GTK_SCROLLABLE (view)),
+				 "value-changed",
+				 G_CALLBACK (adjustment_value_changed_cb),
+				 tab,
+				 0);
+}
+
+static void
+gcsv_tab_get_property (GObject    *object,
+		       guint       prop_id,
+		       GValue     *value,
+		       GParamSpec *pspec)
+{
+	GcsvTab *tab = GCSV_TAB (object);
+
+	switch (prop_id)
+	{
+		case PROP_FOLLOW_ENABLED:
+			g_value_set_boolean (value, gcsv_tab_get_follow_enabled (tab));
+			break;
+
+		case PROP_COMPRESSED:
+			g_value_set_boolean (value, tab->priv->compression != GCSV_COMPRESSION_NONE);
+			break;
+
+		case PROP_CAN_FOLLOW:
+			g_value_set_boolean (value, gcsv_tab_can_follow (tab));
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+clear_file_reloader (GcsvTab *tab)
+{
+	if (tab->priv->file_reloader != NULL)
+	{
+		gcsv_file_reloader_stop (tab->priv->file_reloader);
+		g_clear_object (&tab->priv->file_reloader);
+	}
+}
+
+static void
+file_reloader_reloaded_cb (GcsvFileReloader *reloader,
+			   GcsvTab          *tab)
+{
+	if (tab->priv->journal_writer != NULL)
+	{
+		gcsv_journal_writer_rebase (tab->priv->journal_writer);
+	}
+}
+
+/* The reloader and the follower insert the bytes read from the file as-is,
+ * without converting them from the file encoding.
+ */
+static gboolean
+is_file_in_utf8 (GcsvTab *tab)
+{
+	TeplFile *file;
+	const TeplEncoding *encoding;
+
+	file = tepl_buffer_get_file (tepl_tab_get_buffer (TEPL_TAB (tab)));
+	encoding = tepl_file_get_encoding (file);
+
+	return encoding == NULL || tepl_encoding_is_utf8 (encoding);
+}
+
+/* To call when the buffer contains the file content. */
+static void
+update_file_reloader (GcsvTab *tab)
+{
+	TeplBuffer *buffer;
+	TeplFile *file;
+	GFile *location;
+
+	clear_file_reloader (tab);
+
+	/* The hashes would be the ones of the compressed data. */
+	if (gcsv_tab_is_read_only (tab) ||
+	    gcsv_tab_get_follow_enabled (tab) ||
+	    tab->priv->compression != GCSV_COMPRESSION_NONE ||
+	    !is_file_in_utf8 (tab))
+	{
+		return;
+	}
+
+	buffer = tepl_tab_get_buffer (TEPL_TAB (tab));
+	file = tepl_buffer_get_file (buffer);
+
+	location = tepl_file_get_location (file);
+
+	if (location != NULL)
+	{
+		tab->priv->file_reloader = gcsv_file_reloader_new (GCSV_BUFFER (buffer), location);
+
+		g_signal_connect_object (tab->priv->file_reloader,
+					 "reloaded",
+					 G_CALLBACK (file_reloader_reloaded_cb),
+					 tab,
+					 0);
+	}
+}
+
+/* Removes the journal, the edits are no longer recorded. */
+static void
+clear_journal_writer (GcsvTab *tab)
+{
+	if (tab->priv->journal_writer != NULL)
+	{
+		gcsv_journal_writer_discard (tab->priv->journal_writer);
+		g_clear_object (&tab->priv->journal_writer);
+	}
+}
+
+/* The journal contains the edits done on the file on disk, so it is started
+ * only when the buffer is not modified. The followed files are not recorded,
+ * they change on disk.
+ */
+static void
+create_journal_writer (GcsvTab *tab)
+{
+	TeplBuffer *buffer;
+	GFile *location;
+
+	buffer = tepl_tab_get_buffer (TEPL_TAB (tab));
+	location = tepl_file_get_location (tepl_buffer_get_file (buffer));
+
+	if (tab->priv->journal_writer != NULL ||
+	    location == NULL ||
+	    gcsv_tab_is_read_only (tab) ||
+	    gcsv_tab_get_follow_enabled (tab) ||
+	    gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)))
+	{
+		return;
+	}
+
+	tab->priv->journal_writer = gcsv_journal_writer_new (GCSV_BUFFER (buffer), location);
 }
 
 static void
@@ -83,7 +456,47 @@ gcsv_tab_dispose (GObject *object)
 {
 	GcsvTab *tab = GCSV_TAB (object);
 
+	clear_file_reloader (tab);
+
+	/* Closed normally, the unsaved edits are discarded. */
+	clear_journal_writer (tab);
+
+	if (tab->priv->file_follower != NULL)
+	{
+		gcsv_file_follower_stop (tab->priv->file_follower);
+		g_clear_object (&tab->priv->file_follower);
+	}
+
+	if (tab->priv->sort_cancellable != NULL)
+	{
+		g_cancellable_cancel (tab->priv->sort_cancellable);
+		g_clear_object (&tab->priv->sort_cancellable);
+	}
+
 	g_clear_object (&tab->priv->align);
+	g_clear_object (&tab->priv->ragged_rows);
+	g_clear_object (&tab->priv->stats_tracker);
+	g_clear_object (&tab->priv->column_search);
+	g_clear_object (&tab->priv->pending_save_location);
+	g_clear_pointer (&tab->priv->etag, g_free);
+
+	if (tab->priv->row_filter != NULL)
+	{
+		gcsv_row_filter_set_filter (tab->priv->row_filter, NULL);
+		g_clear_object (&tab->priv->row_filter);
+	}
+
+	if (tab->priv->mapped_bytes != NULL)
+	{
+		g_bytes_unref (tab->priv->mapped_bytes);
+		tab->priv->mapped_bytes = NULL;
+	}
+
+	tab->priv->large_file_view = NULL;
+	tab->priv->grid_view = NULL;
+	tab->priv->filter_bar = NULL;
+	tab->priv->search_bar = NULL;
+	tab->priv->stats_panel = NULL;
 
 	G_OBJECT_CLASS (gcsv_tab_parent_class)->dispose (object);
 }
@@ -93,14 +506,45 @@ gcsv_tab_class_init (GcsvTabClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
+	object_class->get_property = gcsv_tab_get_property;
 	object_class->constructed = gcsv_tab_constructed;
 	object_class->dispose = gcsv_tab_dispose;
+
+	g_object_class_install_property (object_class,
+					 PROP_FOLLOW_ENABLED,
+					 g_param_spec_boolean ("follow-enabled",
+							       "Follow Enabled",
+							       "",
+							       FALSE,
+							       G_PARAM_READABLE |
+							       G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (object_class,
+					 PROP_COMPRESSED,
+					 g_param_spec_boolean ("compressed",
+							       "Compressed",
+							       "",
+							       FALSE,
+							       G_PARAM_READABLE |
+							       G_PARAM_STATIC_STRINGS));
+
+	/* Not notified when the location changes, see TeplFile:location. */
+	g_object_class_install_property (object_class,
+					 PROP_CAN_FOLLOW,
+					 g_param_spec_boolean ("can-follow",
+							       "Can Follow",
+							       "",
+							       FALSE,
+							       G_PARAM_READABLE |
+							       G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gcsv_tab_init (GcsvTab *tab)
 {
 	tab->priv = gcsv_tab_get_instance_private (tab);
+	tab->priv->follow_auto_scroll = TRUE;
+	tab->priv->newline_type = TEPL_NEWLINE_TYPE_LF;
 }
 
 GcsvTab *
@@ -122,6 +566,80 @@ finish_file_loading (GcsvTab *tab)
 	gcsv_alignment_set_enabled (tab->priv->align, TRUE);
 }
 
+static void
+show_error (GcsvTab     *tab,
+	    const gchar *primary_msg,
+	    GError      *error)
+{
+	TeplInfoBar *info_bar;
+
+	info_bar = tepl_info_bar_new_simple (GTK_MESSAGE_ERROR,
+					     primary_msg,
+					     error->message);
+	tepl_info_bar_setup_close_button (info_bar);
+
+	tepl_tab_add_info_bar (TEPL_TAB (tab), GTK_INFO_BAR (info_bar));
+	gtk_widget_show (GTK_WIDGET (info_bar));
+}
+
+static void
+show_recovered_info (GcsvTab *tab)
+{
+	TeplInfoBar *info_bar;
+
+	info_bar = tepl_info_bar_new_simple (GTK_MESSAGE_INFO,
+					     _("Unsaved changes have been recovered."),
+					     _("The document was not closed properly last time. "
+					       "Save it to keep the changes."));
+	tepl_info_bar_setup_close_button (info_bar);
+
+	tepl_tab_add_info_bar (TEPL_TAB (tab), GTK_INFO_BAR (info_bar));
+	gtk_widget_show (GTK_WIDGET (info_bar));
+}
+
+static void
+recover_journal_cb (GObject      *source_object,
+		    GAsyncResult *result,
+		    gpointer      user_data)
+{
+	GcsvJournalWriter *writer = GCSV_JOURNAL_WRITER (source_object);
+	GcsvTab *tab = GCSV_TAB (user_data);
+	GError *error = NULL;
+
+	if (gcsv_journal_writer_recover_finish (writer, result, &error))
+	{
+		show_recovered_info (tab);
+	}
+
+	/* Not important, the file has been loaded anyway. */
+	g_clear_error (&error);
+
+	finish_file_loading (tab);
+	update_file_reloader (tab);
+
+	g_object_unref (tab);
+}
+
+/* Replays the edits of a previous session that has not been closed properly,
+ * while the alignment is not yet enabled, then finishes the loading.
+ */
+static void
+recover_journal (GcsvTab *tab)
+{
+	create_journal_writer (tab);
+
+	if (tab->priv->journal_writer == NULL)
+	{
+		finish_file_loading (tab);
+		update_file_reloader (tab);
+		return;
+	}
+
+	gcsv_journal_writer_recover_async (tab->priv->journal_writer,
+					   recover_journal_cb,
+					   g_object_ref (tab));
+}
+
 static void
 load_file_content_cb (GObject      *source_object,
 		      GAsyncResult *result,
@@ -140,8 +658,11 @@ load_file_content_cb (GObject      *source_object,
 		file = tepl_buffer_get_file (TEPL_BUFFER (buffer));
 		tepl_file_add_uri_to_recent_manager (file);
 
+		tab->priv->newline_type = tepl_file_get_newline_type (file);
+		g_object_notify (G_OBJECT (tab), "can-follow");
+
 		tepl_buffer_load_metadata_from_metadata_manager (buffer);
-		finish_file_loading (tab);
+		recover_journal (tab);
 	}
 	else
 	{
@@ -150,16 +671,7 @@ load_file_content_cb (GObject      *source_object,
 
 	if (error != NULL)
 	{
-		TeplInfoBar *info_bar;
-
-		info_bar = tepl_info_bar_new_simple (GTK_MESSAGE_ERROR,
-						     _("Error when loading file:"),
-						     error->message);
-		tepl_info_bar_setup_close_button (info_bar);
-
-		tepl_tab_add_info_bar (TEPL_TAB (tab), GTK_INFO_BAR (info_bar));
-		gtk_widget_show (GTK_WIDGET (info_bar));
-
+		show_error (tab, _("Error when loading file:"), error);
 		g_clear_error (&error);
 	}
 
@@ -167,26 +679,18 @@ load_file_content_cb (GObject      *source_object,
 	g_object_unref (tab);
 }
 
-void
-gcsv_tab_load_file (GcsvTab *tab,
-		    GFile   *location)
+static void
+load_with_file_loader (GcsvTab *tab)
 {
 	TeplBuffer *buffer;
 	TeplFile *file;
 	TeplFileLoader *loader;
 
-	g_return_if_fail (GCSV_IS_TAB (tab));
-	g_return_if_fail (G_IS_FILE (location));
-
 	buffer = tepl_tab_get_buffer (TEPL_TAB (tab));
 	file = tepl_buffer_get_file (buffer);
 
-	tepl_file_set_location (file, location);
-
 	loader = tepl_file_loader_new (buffer, file);
 
-	gcsv_alignment_set_enabled (tab->priv->align, FALSE);
-
 	tepl_file_loader_load_async (loader,
 				     G_PRIORITY_DEFAULT,
 				     NULL, /* cancellable */
@@ -195,79 +699,1208 @@ gcsv_tab_load_file (GcsvTab *tab,
 }
 
 static void
-save_cb (GObject      *source_object,
-	 GAsyncResult *result,
-	 gpointer      user_data)
+compressed_file_data_free (gpointer data)
 {
-	TeplFileSaver *saver = TEPL_FILE_SAVER (source_object);
-	GcsvTab *tab = GCSV_TAB (user_data);
-	TeplBuffer *buffer_without_align;
-	GApplication *app = g_application_get_default ();
-	GError *error = NULL;
+	CompressedFileData *file_data = data;
 
-	if (tepl_file_saver_save_finish (saver, result, &error))
+	if (file_data != NULL)
 	{
-		GcsvBuffer *buffer;
-		TeplFile *file;
-
-		buffer = GCSV_BUFFER (tepl_tab_get_buffer (TEPL_TAB (tab)));
-		gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), FALSE);
+		g_object_unref (file_data->location);
+		g_free (file_data->etag);
 
-		file = tepl_buffer_get_file (TEPL_BUFFER (buffer));
-		tepl_file_add_uri_to_recent_manager (file);
+		if (file_data->text != NULL)
+		{
+			g_string_free (file_data->text, TRUE);
+		}
 
-		gcsv_buffer_save_metadata (buffer);
+		g_free (file_data);
 	}
+}
 
-	if (error != NULL)
-	{
-		TeplInfoBar *info_bar;
+/* From the first line terminator. */
+static TeplNewlineType
+detect_newline_type (const GString *text)
+{
+	const gchar *newline;
 
-		info_bar = tepl_info_bar_new_simple (GTK_MESSAGE_ERROR,
-						     _("Error when saving the file:"),
-						     error->message);
-		tepl_info_bar_setup_close_button (info_bar);
+	newline = memchr (text->str, '\n', text->len);
 
-		tepl_tab_add_info_bar (TEPL_TAB (tab), GTK_INFO_BAR (info_bar));
-		gtk_widget_show (GTK_WIDGET (info_bar));
+	if (newline != NULL)
+	{
+		if (newline > text->str && newline[-1] == '\r')
+		{
+			return TEPL_NEWLINE_TYPE_CR_LF;
+		}
 
-		g_clear_error (&error);
+		return TEPL_NEWLINE_TYPE_LF;
 	}
 
-	buffer_without_align = tepl_file_saver_get_buffer (saver);
-	g_object_unref (buffer_without_align);
-	g_object_unref (saver);
-
-	g_application_unmark_busy (app);
-	g_application_release (app);
+	if (memchr (text->str, '\r', text->len) != NULL)
+	{
+		return TEPL_NEWLINE_TYPE_CR;
+	}
 
-	g_object_unref (tab);
+	return TEPL_NEWLINE_TYPE_LF;
 }
 
+#define READ_CHUNK_SIZE (64 * 1024)
+
+/* Detects the compression, and if the file is compressed, decompresses it.
+ * Only UTF-8 is supported for compressed files.
+ */
 static void
-launch_saver (GcsvTab       *tab,
-	      TeplFileSaver *saver)
+load_compressed_thread (GTask        *task,
+			gpointer      source_object,
+			gpointer      task_data,
+			GCancellable *cancellable)
 {
-	GApplication *app = g_application_get_default ();
+	CompressedFileData *data = task_data;
+	GFileInfo *info;
+	GInputStream *stream;
+	GError *error = NULL;
 
-	g_application_hold (app);
-	g_application_mark_busy (app);
+	/* Queried before reading the file: if it changes in between, the save
+	 * fails instead of overwriting the changes.
+	 */
+	info = g_file_query_info (data->location,
+				  G_FILE_ATTRIBUTE_ETAG_VALUE,
+				  G_FILE_QUERY_INFO_NONE,
+				  cancellable,
+				  NULL);
+	if (info != NULL)
+	{
+		data->etag = g_strdup (g_file_info_get_etag (info));
+		g_object_unref (info);
+	}
 
-	tepl_file_saver_save_async (saver,
-				    G_PRIORITY_DEFAULT,
-				    NULL, /* Cancellable */
-				    save_cb,
-				    g_object_ref (tab));
-}
+	stream = gcsv_compression_open_file (data->location, &data->compression, cancellable, &error);
+	if (stream == NULL)
+	{
+		g_task_return_error (task, error);
+		return;
+	}
 
-void
-gcsv_tab_save (GcsvTab *tab)
-{
-	TeplBuffer *buffer;
-	TeplFile *file;
-	GFile *location;
-	TeplBuffer *buffer_without_align;
-	TeplFileSaver *saver;
+	if (data->compression == GCSV_COMPRESSION_NONE)
+	{
+		g_object_unref (stream);
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	/* Decompressed directly in the string, which is then copied only in
+	 * the buffer.
+	 */
+	data->text = g_string_sized_new (READ_CHUNK_SIZE);
+
+	while (TRUE)
+	{
+		gsize old_length = data->text->len;
+		gsize n_bytes_read;
+
+		g_string_set_size (data->text, old_length + READ_CHUNK_SIZE);
+
+		if (!g_input_stream_read_all (stream,
+					      data->text->str + old_length,
+					      READ_CHUNK_SIZE,
+					      &n_bytes_read,
+					      cancellable,
+					      &error))
+		{
+			g_object_unref (stream);
+			g_task_return_error (task, error);
+			return;
+		}
+
+		g_string_set_size (data->text, old_length + n_bytes_read);
+
+		if (n_bytes_read < READ_CHUNK_SIZE)
+		{
+			break;
+		}
+	}
+
+	g_object_unref (stream);
+
+	/* The invalid bytes can't be shown, and replacing them would modify
+	 * the file when saving it.
+	 */
+	if (!g_utf8_validate (data->text->str, data->text->len, NULL))
+	{
+		g_task_return_new_error (task,
+					 G_IO_ERROR,
+					 G_IO_ERROR_INVALID_DATA,
+					 _("The file is not in UTF-8. Only UTF-8 is supported "
+					   "for compressed files."));
+		return;
+	}
+
+	data->newline_type = detect_newline_type (data->text);
+
+	if (data->implicit_trailing_newline)
+	{
+		gcsv_utils_strip_last_line_terminator (data->text);
+	}
+
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+load_compressed_cb (GObject      *source_object,
+		    GAsyncResult *result,
+		    gpointer      user_data)
+{
+	GcsvTab *tab = GCSV_TAB (source_object);
+	GTask *task = G_TASK (result);
+	CompressedFileData *data;
+	TeplBuffer *buffer;
+	GtkTextIter start;
+	GError *error = NULL;
+
+	if (!g_task_propagate_boolean (task, &error))
+	{
+		finish_file_loading (tab);
+		show_error (tab, _("Error when loading file:"), error);
+		g_clear_error (&error);
+		return;
+	}
+
+	data = g_task_get_task_data (task);
+
+	g_free (tab->priv->etag);
+	tab->priv->etag = data->etag;
+	data->etag = NULL;
+
+	if (data->compression == GCSV_COMPRESSION_NONE)
+	{
+		load_with_file_loader (tab);
+		return;
+	}
+
+	buffer = tepl_tab_get_buffer (TEPL_TAB (tab));
+
+	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), data->text->str, data->text->len);
+	gtk_source_buffer_end_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (buffer), &start);
+	gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (buffer), &start);
+	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), FALSE);
+
+	tab->priv->compression = data->compression;
+	tab->priv->newline_type = data->newline_type;
+	g_object_notify (G_OBJECT (tab), "compressed");
+	g_object_notify (G_OBJECT (tab), "can-follow");
+
+	tepl_file_add_uri_to_recent_manager (tepl_buffer_get_file (buffer));
+	tepl_buffer_load_metadata_from_metadata_manager (buffer);
+	recover_journal (tab);
+}
+
+/* gzip, zstd and xz compressed files are decompressed in a worker thread.
+ * Other files are loaded with TeplFileLoader.
+ */
+void
+gcsv_tab_load_file (GcsvTab *tab,
+		    GFile   *location)
+{
+	TeplBuffer *buffer;
+	TeplFile *file;
+	CompressedFileData *data;
+	GTask *task;
+
+	g_return_if_fail (GCSV_IS_TAB (tab));
+	g_return_if_fail (G_IS_FILE (location));
+
+	buffer = tepl_tab_get_buffer (TEPL_TAB (tab));
+	file = tepl_buffer_get_file (buffer);
+
+	tepl_file_set_location (file, location);
+
+	gcsv_alignment_set_enabled (tab->priv->align, FALSE);
+
+	data = g_new0 (CompressedFileData, 1);
+	data->location = g_object_ref (location);
+	data->implicit_trailing_newline =
+		gtk_source_buffer_get_implicit_trailing_newline (GTK_SOURCE_BUFFER (buffer));
+
+	task = g_task_new (tab, NULL, load_compressed_cb, NULL);
+	g_task_set_task_data (task, data, compressed_file_data_free);
+	g_task_run_in_thread (task, load_compressed_thread);
+	g_object_unref (task);
+}
+
+static void
+update_large_file_view_index (GcsvTab *tab)
+{
+	GcsvBuffer *buffer;
+	GcsvRowIndex *index;
+
+	buffer = GCSV_BUFFER (tepl_tab_get_buffer (TEPL_TAB (tab)));
+
+	index = gcsv_row_index_new (tab->priv->mapped_bytes,
+				    gcsv_buffer_get_delimiter (buffer));
+	gcsv_large_file_view_set_index (tab->priv->large_file_view, index);
+	gcsv_row_index_unref (index);
+}
+
+static void
+read_only_delimiter_notify_cb (GcsvBuffer *buffer,
+			       GParamSpec *pspec,
+			       GcsvTab    *tab)
+{
+	update_large_file_view_index (tab);
+}
+
+static GtkWidget *
+get_view_scrolled_window (GcsvTab *tab)
+{
+	TeplView *view;
+
+	/* The TeplView is in a GtkScrolledWindow, which is a child of the
+	 * TeplTab.
+	 */
+	view = tepl_tab_get_view (TEPL_TAB (tab));
+	return gtk_widget_get_parent (GTK_WIDGET (view));
+}
+
+static void
+show_large_file_view (GcsvTab *tab)
+{
+	gtk_widget_hide (get_view_scrolled_window (tab));
+
+	tab->priv->large_file_view = gcsv_large_file_view_new ();
+	gtk_container_add (GTK_CONTAINER (tab), GTK_WIDGET (tab->priv->large_file_view));
+	gtk_widget_show (GTK_WIDGET (tab->priv->large_file_view));
+}
+
+/* Opens @location in read-only mode: the file is memory-mapped instead of
+ * being loaded into the GcsvBuffer, so that files larger than the available
+ * memory can be viewed. The rows are indexed in a worker thread.
+ *
+ * The tab must be untouched, and can no longer be used to edit a file
+ * afterwards.
+ */
+void
+gcsv_tab_load_file_read_only (GcsvTab *tab,
+			      GFile   *location)
+{
+	TeplBuffer *buffer;
+	TeplFile *file;
+	gchar *path;
+	GMappedFile *mapped_file;
+	const gchar *data;
+	gsize length;
+	GError *error = NULL;
+
+	g_return_if_fail (GCSV_IS_TAB (tab));
+	g_return_if_fail (G_IS_FILE (location));
+	g_return_if_fail (!gcsv_tab_is_read_only (tab));
+
+	buffer = tepl_tab_get_buffer (TEPL_TAB (tab));
+	file = tepl_buffer_get_file (buffer);
+
+	tepl_file_set_location (file, location);
+	gcsv_alignment_set_enabled (tab->priv->align, FALSE);
+	gtk_text_view_set_editable (GTK_TEXT_VIEW (tepl_tab_get_view (TEPL_TAB (tab))), FALSE);
+
+	path = g_file_get_path (location);
+	if (path == NULL)
+	{
+		g_set_error_literal (&error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_SUPPORTED,
+				     _("Only local files can be opened in read-only mode."));
+		show_error (tab, _("Error when loading file:"), error);
+		g_clear_error (&error);
+		return;
+	}
+
+	mapped_file = g_mapped_file_new (path, FALSE, &error);
+	g_free (path);
+
+	if (error != NULL)
+	{
+		show_error (tab, _("Error when loading file:"), error);
+		g_clear_error (&error);
+		return;
+	}
+
+	tab->priv->mapped_bytes = g_mapped_file_get_bytes (mapped_file);
+	g_mapped_file_unref (mapped_file);
+
+	tepl_file_add_uri_to_recent_manager (file);
+	tepl_buffer_load_metadata_from_metadata_manager (buffer);
+
+	/* Only the beginning of the mapping is looked at, see
+	 * gcsv_tokenizer_guess_delimiter().
+	 */
+	data = g_bytes_get_data (tab->priv->mapped_bytes, &length);
+	gcsv_buffer_setup_state_from_sample (GCSV_BUFFER (buffer), data, length);
+
+	show_large_file_view (tab);
+	update_large_file_view_index (tab);
+
+	g_signal_connect_object (buffer,
+				 "notify::delimiter",
+				 G_CALLBACK (read_only_delimiter_notify_cb),
+				 tab,
+				 0);
+}
+
+gboolean
+gcsv_tab_is_read_only (GcsvTab *tab)
+{
+	g_return_val_if_fail (GCSV_IS_TAB (tab), FALSE);
+
+	return tab->priv->large_file_view != NULL;
+}
+
+void
+gcsv_tab_set_alignment_priority (GcsvTab               *tab,
+				 GcsvAlignmentPriority  priority)
+{
+	g_return_if_fail (GCSV_IS_TAB (tab));
+
+	if (tab->priv->align != NULL)
+	{
+		gcsv_alignment_set_priority (tab->priv->align, priority);
+	}
+}
+
+/* Returns: the number of lines that remain to be scanned or aligned. */
+guint
+gcsv_tab_get_alignment_queue_depth (GcsvTab *tab)
+{
+	g_return_val_if_fail (GCSV_IS_TAB (tab), 0);
+
+	if (tab->priv->align == NULL)
+	{
+		return 0;
+	}
+
+	return gcsv_alignment_get_queue_depth (tab->priv->align);
+}
+
+static void
+show_grid_view (GcsvTab *tab)
+{
+	GtkTextBuffer *buffer;
+	GtkTextIter insert_iter;
+	GcsvRowModel *model;
+
+	buffer = GTK_TEXT_BUFFER (tepl_tab_get_buffer (TEPL_TAB (tab)));
+	gtk_text_buffer_get_iter_at_mark (buffer,
+					  &insert_iter,
+					  gtk_text_buffer_get_insert (buffer));
+
+	model = gcsv_row_model_new_for_buffer (GCSV_BUFFER (buffer));
+	tab->priv->grid_view = gcsv_grid_view_new (model);
+	g_object_unref (model);
+
+	gtk_widget_hide (get_view_scrolled_window (tab));
+	gtk_container_add (GTK_CONTAINER (tab), GTK_WIDGET (tab->priv->grid_view));
+	gtk_widget_show (GTK_WIDGET (tab->priv->grid_view));
+
+	gcsv_grid_view_scroll_to_row (tab->priv->grid_view,
+				      gtk_text_iter_get_line (&insert_iter));
+}
+
+static void
+hide_grid_view (GcsvTab *tab)
+{
+	TeplView *view;
+	GtkTextBuffer *buffer;
+	GtkTextIter iter;
+	guint first_row_num;
+
+	first_row_num = gcsv_grid_view_get_first_visible_row (tab->priv->grid_view);
+
+	/* Destroying the grid view writes back the modified cells. */
+	gtk_widget_destroy (GTK_WIDGET (tab->priv->grid_view));
+	tab->priv->grid_view = NULL;
+
+	gtk_widget_show (get_view_scrolled_window (tab));
+
+	view = tepl_tab_get_view (TEPL_TAB (tab));
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+	gtk_text_buffer_get_iter_at_line (buffer, &iter, first_row_num);
+	gtk_text_buffer_place_cursor (buffer, &iter);
+	tepl_view_scroll_to_cursor (view);
+	gtk_widget_grab_focus (GTK_WIDGET (view));
+}
+
+/* In the grid view, the fields are shown in GtkEntry's, and only the visible
+ * rows are laid out. It is not available in read-only mode.
+ */
+void
+gcsv_tab_set_grid_view_enabled (GcsvTab  *tab,
+				gboolean  enabled)
+{
+	g_return_if_fail (GCSV_IS_TAB (tab));
+	g_return_if_fail (!gcsv_tab_is_read_only (tab));
+
+	enabled = enabled != FALSE;
+
+	if (enabled == gcsv_tab_get_grid_view_enabled (tab))
+	{
+		return;
+	}
+
+	if (enabled)
+	{
+		show_grid_view (tab);
+	}
+	else
+	{
+		hide_grid_view (tab);
+	}
+}
+
+gboolean
+gcsv_tab_get_grid_view_enabled (GcsvTab *tab)
+{
+	g_return_val_if_fail (GCSV_IS_TAB (tab), FALSE);
+
+	return tab->priv->grid_view != NULL;
+}
+
+/* The rows that don't match the filter are hidden in the view, the text is not
+ * modified. Hiding the filter bar shows all the rows again.
+ */
+void
+gcsv_tab_set_filter_bar_visible (GcsvTab  *tab,
+				 gboolean  visible)
+{
+	g_return_if_fail (GCSV_IS_TAB (tab));
+	g_return_if_fail (!gcsv_tab_is_read_only (tab));
+
+	visible = visible != FALSE;
+
+	if (visible == gcsv_tab_get_filter_bar_visible (tab))
+	{
+		return;
+	}
+
+	if (visible)
+	{
+		tab->priv->filter_bar = gcsv_filter_bar_new (tab->priv->row_filter);
+		gtk_container_add (GTK_CONTAINER (tab), GTK_WIDGET (tab->priv->filter_bar));
+		gtk_widget_show_all (GTK_WIDGET (tab->priv->filter_bar));
+		gcsv_filter_bar_grab_focus (tab->priv->filter_bar);
+	}
+	else
+	{
+		gtk_widget_destroy (GTK_WIDGET (tab->priv->filter_bar));
+		tab->priv->filter_bar = NULL;
+
+		gcsv_row_filter_set_filter (tab->priv->row_filter, NULL);
+	}
+}
+
+gboolean
+gcsv_tab_get_filter_bar_visible (GcsvTab *tab)
+{
+	g_return_val_if_fail (GCSV_IS_TAB (tab), FALSE);
+
+	return tab->priv->filter_bar != NULL;
+}
+
+/* The search is limited to some columns and ignores the virtual spaces. The
+ * buffer is indexed in the background from the first time the search bar is
+ * shown, to make the next searches fast on big files.
+ */
+void
+gcsv_tab_set_search_bar_visible (GcsvTab  *tab,
+				 gboolean  visible)
+{
+	g_return_if_fail (GCSV_IS_TAB (tab));
+	g_return_if_fail (!gcsv_tab_is_read_only (tab));
+
+	visible = visible != FALSE;
+
+	if (visible == gcsv_tab_get_search_bar_visible (tab))
+	{
+		return;
+	}
+
+	if (visible)
+	{
+		TeplView *view;
+
+		if (tab->priv->column_search == NULL)
+		{
+			GcsvBuffer *buffer;
+
+			buffer = GCSV_BUFFER (tepl_tab_get_buffer (TEPL_TAB (tab)));
+			tab->priv->column_search = gcsv_column_search_new (buffer);
+		}
+
+		view = tepl_tab_get_view (TEPL_TAB (tab));
+		tab->priv->search_bar = gcsv_search_bar_new (GTK_TEXT_VIEW (view), tab->priv->column_search);
+		gtk_container_add (GTK_CONTAINER (tab), GTK_WIDGET (tab->priv->search_bar));
+		gtk_widget_show_all (GTK_WIDGET (tab->priv->search_bar));
+		gcsv_search_bar_grab_focus (tab->priv->search_bar);
+	}
+	else
+	{
+		gtk_widget_destroy (GTK_WIDGET (tab->priv->search_bar));
+		tab->priv->search_bar = NULL;
+	}
+}
+
+gboolean
+gcsv_tab_get_search_bar_visible (GcsvTab *tab)
+{
+	g_return_val_if_fail (GCSV_IS_TAB (tab), FALSE);
+
+	return tab->priv->search_bar != NULL;
+}
+
+/* The statistics are computed in the background, and kept up to date while the
+ * panel is shown.
+ */
+void
+gcsv_tab_set_stats_panel_visible (GcsvTab  *tab,
+				  gboolean  visible)
+{
+	g_return_if_fail (GCSV_IS_TAB (tab));
+	g_return_if_fail (!gcsv_tab_is_read_only (tab));
+
+	visible = visible != FALSE;
+
+	if (visible == gcsv_tab_get_stats_panel_visible (tab))
+	{
+		return;
+	}
+
+	if (visible)
+	{
+		GcsvBuffer *buffer;
+
+		buffer = GCSV_BUFFER (tepl_tab_get_buffer (TEPL_TAB (tab)));
+		tab->priv->stats_tracker = gcsv_column_stats_tracker_new (buffer);
+
+		tab->priv->stats_panel = gcsv_stats_panel_new (tab->priv->stats_tracker);
+		gtk_container_add (GTK_CONTAINER (tab), GTK_WIDGET (tab->priv->stats_panel));
+		gtk_widget_show_all (GTK_WIDGET (tab->priv->stats_panel));
+	}
+	else
+	{
+		gtk_widget_destroy (GTK_WIDGET (tab->priv->stats_panel));
+		tab->priv->stats_panel = NULL;
+
+		g_clear_object (&tab->priv->stats_tracker);
+	}
+}
+
+gboolean
+gcsv_tab_get_stats_panel_visible (GcsvTab *tab)
+{
+	g_return_val_if_fail (GCSV_IS_TAB (tab), FALSE);
+
+	return tab->priv->stats_panel != NULL;
+}
+
+/* Returns: (transfer none): the #GcsvRaggedRows of the buffer. */
+GcsvRaggedRows *
+gcsv_tab_get_ragged_rows (GcsvTab *tab)
+{
+	g_return_val_if_fail (GCSV_IS_TAB (tab), NULL);
+
+	return tab->priv->ragged_rows;
+}
+
+/* Moves the cursor to the start of the next or previous ragged row, from the
+ * cursor line. Returns FALSE if there is no ragged row.
+ */
+gboolean
+gcsv_tab_goto_ragged_row (GcsvTab  *tab,
+			  gboolean  backward)
+{
+	GtkTextBuffer *buffer;
+	TeplView *view;
+	GtkTextIter iter;
+	guint line;
+
+	g_return_val_if_fail (GCSV_IS_TAB (tab), FALSE);
+
+	buffer = GTK_TEXT_BUFFER (tepl_tab_get_buffer (TEPL_TAB (tab)));
+	gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+
+	if (!gcsv_ragged_rows_find (tab->priv->ragged_rows,
+				    gtk_text_iter_get_line (&iter),
+				    backward,
+				    &line))
+	{
+		return FALSE;
+	}
+
+	gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+	gtk_text_buffer_place_cursor (buffer, &iter);
+
+	view = tepl_tab_get_view (TEPL_TAB (tab));
+	gtk_text_view_scroll_to_mark (GTK_TEXT_VIEW (view),
+				      gtk_text_buffer_get_insert (buffer),
+				      0.25, FALSE, 0.0, 0.0);
+
+	return TRUE;
+}
+
+static void
+file_follower_appended_cb (GcsvFileFollower *follower,
+			   GcsvTab          *tab)
+{
+	TeplView *view;
+
+	if (!tab->priv->follow_auto_scroll)
+	{
+		return;
+	}
+
+	view = tepl_tab_get_view (TEPL_TAB (tab));
+	gtk_text_view_scroll_to_mark (GTK_TEXT_VIEW (view),
+				      tab->priv->follow_end_mark,
+				      0.0, TRUE, 0.0, 1.0);
+}
+
+static void
+file_follower_stopped_cb (GcsvFileFollower *follower,
+			  GError           *error,
+			  GcsvTab          *tab)
+{
+	show_error (tab, _("Stopped following the file changes."), error);
+	gcsv_tab_set_follow_enabled (tab, FALSE);
+}
+
+/* When enabled, the lines appended to the file are appended to the buffer,
+ * like "tail -f". It is possible only if gcsv_tab_can_follow() returns TRUE.
+ */
+void
+gcsv_tab_set_follow_enabled (GcsvTab  *tab,
+			     gboolean  enabled)
+{
+	GtkTextBuffer *buffer;
+
+	g_return_if_fail (GCSV_IS_TAB (tab));
+
+	enabled = enabled != FALSE;
+
+	if (enabled == gcsv_tab_get_follow_enabled (tab))
+	{
+		return;
+	}
+
+	buffer = GTK_TEXT_BUFFER (tepl_tab_get_buffer (TEPL_TAB (tab)));
+
+	if (enabled)
+	{
+		TeplFile *file;
+		GFile *location;
+		GtkTextIter end;
+
+		g_return_if_fail (gcsv_tab_can_follow (tab));
+
+		file = tepl_buffer_get_file (TEPL_BUFFER (buffer));
+		location = tepl_file_get_location (file);
+
+		/* The follower handles the changes instead. */
+		clear_file_reloader (tab);
+		clear_journal_writer (tab);
+
+		/* The file is expected to be changed by another program, the
+		 * save no longer checks that it is unchanged.
+		 */
+		g_clear_pointer (&tab->priv->etag, g_free);
+
+		gtk_text_buffer_get_end_iter (buffer, &end);
+		tab->priv->follow_end_mark = gtk_text_buffer_create_mark (buffer, NULL, &end, FALSE);
+
+		tab->priv->file_follower = gcsv_file_follower_new (GCSV_BUFFER (buffer), location);
+
+		g_signal_connect_object (tab->priv->file_follower,
+					 "appended",
+					 G_CALLBACK (file_follower_appended_cb),
+					 tab,
+					 0);
+
+		g_signal_connect_object (tab->priv->file_follower,
+					 "stopped",
+					 G_CALLBACK (file_follower_stopped_cb),
+					 tab,
+					 0);
+
+		gcsv_file_follower_start (tab->priv->file_follower);
+	}
+	else
+	{
+		gcsv_file_follower_stop (tab->priv->file_follower);
+		g_clear_object (&tab->priv->file_follower);
+
+		gtk_text_buffer_delete_mark (buffer, tab->priv->follow_end_mark);
+		tab->priv->follow_end_mark = NULL;
+
+		update_file_reloader (tab);
+		create_journal_writer (tab);
+	}
+
+	g_object_notify (G_OBJECT (tab), "follow-enabled");
+}
+
+/* The follower needs the location, and it appends the bytes as-is: not for a
+ * compressed file or a file in another encoding than UTF-8.
+ */
+gboolean
+gcsv_tab_can_follow (GcsvTab *tab)
+{
+	TeplFile *file;
+
+	g_return_val_if_fail (GCSV_IS_TAB (tab), FALSE);
+
+	file = tepl_buffer_get_file (tepl_tab_get_buffer (TEPL_TAB (tab)));
+
+	return (tepl_file_get_location (file) != NULL &&
+		!gcsv_tab_is_read_only (tab) &&
+		tab->priv->compression == GCSV_COMPRESSION_NONE &&
+		is_file_in_utf8 (tab));
+}
+
+GcsvCompression
+gcsv_tab_get_compression (GcsvTab *tab)
+{
+	g_return_val_if_fail (GCSV_IS_TAB (tab), GCSV_COMPRESSION_NONE);
+
+	return tab->priv->compression;
+}
+
+gboolean
+gcsv_tab_get_follow_enabled (GcsvTab *tab)
+{
+	g_return_val_if_fail (GCSV_IS_TAB (tab), FALSE);
+
+	return tab->priv->file_follower != NULL;
+}
+
+/* Whether to scroll to the end of the buffer when lines are appended while
+ * following the file. TRUE by default.
+ */
+void
+gcsv_tab_set_follow_auto_scroll (GcsvTab  *tab,
+				 gboolean  auto_scroll)
+{
+	g_return_if_fail (GCSV_IS_TAB (tab));
+
+	tab->priv->follow_auto_scroll = auto_scroll != FALSE;
+}
+
+gboolean
+gcsv_tab_get_follow_auto_scroll (GcsvTab *tab)
+{
+	g_return_val_if_fail (GCSV_IS_TAB (tab), FALSE);
+
+	return tab->priv->follow_auto_scroll;
+}
+
+static void
+sort_by_column_cb (GObject      *source_object,
+		   GAsyncResult *result,
+		   gpointer      user_data)
+{
+	GcsvBuffer *buffer = GCSV_BUFFER (source_object);
+	GcsvTab *tab = GCSV_TAB (user_data);
+	GError *error = NULL;
+
+	gcsv_buffer_sort_by_column_finish (buffer, result, &error);
+
+	if (tab->priv->sort_cancellable != NULL)
+	{
+		g_clear_object (&tab->priv->sort_cancellable);
+		gtk_text_view_set_editable (GTK_TEXT_VIEW (tepl_tab_get_view (TEPL_TAB (tab))), TRUE);
+	}
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_clear_error (&error);
+	}
+	else if (error != NULL)
+	{
+		show_error (tab, _("Failed to sort the rows."), error);
+		g_clear_error (&error);
+	}
+
+	g_object_unref (tab);
+}
+
+/* Sorts the rows after the column titles. The view is not editable until the
+ * sort is finished. Does nothing if a sort is already running.
+ */
+void
+gcsv_tab_sort_by_column (GcsvTab      *tab,
+			 guint         column_num,
+			 GcsvSortMode  mode)
+{
+	GcsvBuffer *buffer;
+
+	g_return_if_fail (GCSV_IS_TAB (tab));
+	g_return_if_fail (!gcsv_tab_is_read_only (tab));
+
+	if (tab->priv->sort_cancellable != NULL)
+	{
+		return;
+	}
+
+	tab->priv->sort_cancellable = g_cancellable_new ();
+	gtk_text_view_set_editable (GTK_TEXT_VIEW (tepl_tab_get_view (TEPL_TAB (tab))), FALSE);
+
+	buffer = GCSV_BUFFER (tepl_tab_get_buffer (TEPL_TAB (tab)));
+	gcsv_buffer_sort_by_column_async (buffer,
+					  column_num,
+					  mode,
+					  tab->priv->sort_cancellable,
+					  sort_by_column_cb,
+					  g_object_ref (tab));
+}
+
+static void
+save_data_free (gpointer data)
+{
+	SaveData *save_data = data;
+
+	if (save_data != NULL)
+	{
+		g_object_unref (save_data->location);
+		g_free (save_data->etag);
+		g_free (save_data->new_etag);
+		g_free (save_data->charset);
+		g_free (save_data->text);
+
+		if (save_data->virtual_spaces != NULL)
+		{
+			g_array_unref (save_data->virtual_spaces);
+		}
+
+		if (save_data->journal_writer != NULL)
+		{
+			g_object_unref (save_data->journal_writer);
+		}
+
+		g_free (save_data);
+	}
+}
+
+static const gchar *
+get_newline_string (TeplNewlineType newline_type)
+{
+	switch (newline_type)
+	{
+		case TEPL_NEWLINE_TYPE_CR:
+			return "\r";
+
+		case TEPL_NEWLINE_TYPE_CR_LF:
+			return "\r\n";
+
+		case TEPL_NEWLINE_TYPE_LF:
+		default:
+			return "\n";
+	}
+}
+
+/* Serializes the snapshot, with the line terminators and the encoding of the
+ * file, and writes it.
+ */
+static void
+save_thread (GTask        *task,
+	     gpointer      source_object,
+	     gpointer      task_data,
+	     GCancellable *cancellable)
+{
+	SaveData *data = task_data;
+	const gchar *newline;
+	const gchar *p;
+	const gchar *end;
+	GString *contents;
+	GBytes *bytes;
+	GError *error = NULL;
+
+	data->text_length = gcsv_utils_remove_char_ranges (data->text,
+							   data->text_length,
+							   data->virtual_spaces);
+
+	newline = get_newline_string (data->newline_type);
+	p = data->text;
+	end = data->text + data->text_length;
+
+	contents = g_string_sized_new (data->text_length + data->text_length / 32 + 2);
+
+	while (p < end)
+	{
+		const gchar *line_end;
+		const gchar *next_line_start;
+
+		line_end = gcsv_tokenizer_find_line_end (p, end, &next_line_start);
+		g_string_append_len (contents, p, line_end - p);
+
+		if (line_end != next_line_start)
+		{
+			g_string_append (contents, newline);
+		}
+
+		p = next_line_start;
+	}
+
+	if (data->implicit_trailing_newline)
+	{
+		g_string_append (contents, newline);
+	}
+
+	/* The snapshot is no longer needed, free it before writing. */
+	g_clear_pointer (&data->text, g_free);
+
+	if (data->charset != NULL)
+	{
+		gchar *converted;
+		gsize converted_length;
+
+		converted = g_convert (contents->str, contents->len,
+				       data->charset, "UTF-8",
+				       NULL, &converted_length,
+				       &error);
+		g_string_free (contents, TRUE);
+
+		if (converted == NULL)
+		{
+			g_task_return_error (task, error);
+			return;
+		}
+
+		bytes = g_bytes_new_take (converted, converted_length);
+	}
+	else
+	{
+		bytes = g_string_free_to_bytes (contents);
+	}
+
+	if (gcsv_compression_save_file (data->location,
+					data->compression,
+					bytes,
+					data->etag,
+					&data->new_etag,
+					cancellable,
+					&error))
+	{
+		g_task_return_boolean (task, TRUE);
+	}
+	else
+	{
+		g_task_return_error (task, error);
+	}
+
+	g_bytes_unref (bytes);
+}
+
+static void launch_saver (GcsvTab         *tab,
+			  GFile           *location,
+			  GcsvCompression  compression);
+
+static void
+save_cb (GObject      *source_object,
+	 GAsyncResult *result,
+	 gpointer      user_data)
+{
+	GcsvTab *tab = GCSV_TAB (source_object);
+	GTask *task = G_TASK (result);
+	SaveData *data = g_task_get_task_data (task);
+	GcsvBuffer *buffer;
+	GApplication *app = g_application_get_default ();
+	gboolean saved;
+	GError *error = NULL;
+
+	saved = g_task_propagate_boolean (task, &error);
+
+	/* The tab has been closed during the save. It was modified, so the
+	 * user has confirmed to close it without saving.
+	 */
+	if (tepl_tab_get_buffer (TEPL_TAB (tab)) == NULL)
+	{
+		if (!saved)
+		{
+			g_warning ("Error when saving the file: %s", error->message);
+			g_clear_error (&error);
+		}
+
+		tab->priv->saving = FALSE;
+		g_application_release (app);
+		return;
+	}
+
+	buffer = GCSV_BUFFER (tepl_tab_get_buffer (TEPL_TAB (tab)));
+
+	if (saved)
+	{
+		TeplFile *file;
+
+		/* The buffer stays modified if the text has been edited since
+		 * the snapshot.
+		 */
+		if (gcsv_buffer_get_change_count (buffer) == data->change_count)
+		{
+			gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), FALSE);
+		}
+
+		file = tepl_buffer_get_file (TEPL_BUFFER (buffer));
+		tepl_file_set_location (file, data->location);
+		tepl_file_add_uri_to_recent_manager (file);
+
+		g_free (tab->priv->etag);
+		tab->priv->etag = data->new_etag;
+		data->new_etag = NULL;
+
+		if (tab->priv->compression != data->compression)
+		{
+			tab->priv->compression = data->compression;
+			g_object_notify (G_OBJECT (tab), "compressed");
+			g_object_notify (G_OBJECT (tab), "can-follow");
+		}
+
+		gcsv_buffer_save_metadata (buffer);
+	}
+	else
+	{
+		show_error (tab, _("Error when saving the file:"), error);
+		g_clear_error (&error);
+	}
+
+	/* The journal keeps only the edits done during the save. */
+	if (data->journal_writer != NULL)
+	{
+		gcsv_journal_writer_end_save (data->journal_writer, saved ? data->location : NULL);
+	}
+	else if (saved)
+	{
+		create_journal_writer (tab);
+	}
+
+	tab->priv->saving = FALSE;
+
+	if (tab->priv->pending_save_location != NULL)
+	{
+		GFile *location = tab->priv->pending_save_location;
+
+		tab->priv->pending_save_location = NULL;
+		launch_saver (tab, location, tab->priv->pending_save_compression);
+		g_object_unref (location);
+	}
+	else
+	{
+		/* Also after an error, to record what is on disk. */
+		update_file_reloader (tab);
+	}
+
+	g_application_release (app);
+}
+
+/* Only the snapshot of the text is taken on the main thread, so the user can
+ * continue to edit the buffer while the content is serialized and written by
+ * a worker thread.
+ *
+ * If a save is already running, this one is launched when it is finished, so
+ * that the file is written in order.
+ */
+static void
+launch_saver (GcsvTab         *tab,
+	      GFile           *location,
+	      GcsvCompression  compression)
+{
+	GApplication *app = g_application_get_default ();
+	GcsvBuffer *buffer;
+	TeplFile *file;
+	const TeplEncoding *encoding;
+	GtkTextIter start;
+	GtkTextIter end;
+	SaveData *data;
+	GTask *task;
+
+	/* The content reloaded since the last load or save. */
+	if (tab->priv->file_reloader != NULL &&
+	    gcsv_file_reloader_get_etag (tab->priv->file_reloader) != NULL)
+	{
+		g_free (tab->priv->etag);
+		tab->priv->etag = g_strdup (gcsv_file_reloader_get_etag (tab->priv->file_reloader));
+	}
+
+	/* The saved content must not be reloaded. */
+	clear_file_reloader (tab);
+
+	if (tab->priv->saving)
+	{
+		g_set_object (&tab->priv->pending_save_location, location);
+		tab->priv->pending_save_compression = compression;
+		return;
+	}
+
+	buffer = GCSV_BUFFER (tepl_tab_get_buffer (TEPL_TAB (tab)));
+	file = tepl_buffer_get_file (TEPL_BUFFER (buffer));
+
+	data = g_new0 (SaveData, 1);
+	data->location = g_object_ref (location);
+	data->compression = compression;
+	data->newline_type = tab->priv->newline_type;
+
+	/* With "Save As", the file is another one, it is overwritten. */
+	if (tepl_file_get_location (file) != NULL &&
+	    g_file_equal (location, tepl_file_get_location (file)))
+	{
+		data->etag = g_strdup (tab->priv->etag);
+	}
+
+	data->implicit_trailing_newline =
+		gtk_source_buffer_get_implicit_trailing_newline (GTK_SOURCE_BUFFER (buffer));
+
+	/* Compressed files are always in UTF-8, like when loading them. */
+	encoding = tepl_file_get_encoding (file);
+	if (compression == GCSV_COMPRESSION_NONE &&
+	    encoding != NULL &&
+	    !tepl_encoding_is_utf8 (encoding))
+	{
+		data->charset = g_strdup (tepl_encoding_get_charset (encoding));
+	}
+
+	/* A single copy of the text, the virtual spaces are removed by the
+	 * thread.
+	 */
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (buffer), &start, &end);
+	data->text = gtk_text_buffer_get_text (GTK_TEXT_BUFFER (buffer), &start, &end, TRUE);
+	data->text_length = strlen (data->text);
+	data->virtual_spaces = gcsv_utils_get_tag_offsets (GTK_TEXT_BUFFER (buffer),
+							   gcsv_buffer_get_virtual_spaces_tag (buffer));
+	data->change_count = gcsv_buffer_get_change_count (buffer);
+
+	if (tab->priv->journal_writer != NULL)
+	{
+		data->journal_writer = g_object_ref (tab->priv->journal_writer);
+		gcsv_journal_writer_begin_save (data->journal_writer);
+	}
+
+	/* The application must not quit before the file is written. It is not
+	 * marked as busy, the buffer stays editable. It stays modified until
+	 * the file is written, so that closing the window during the save
+	 * asks for a confirmation.
+	 */
+	tab->priv->saving = TRUE;
+	g_application_hold (app);
+
+	task = g_task_new (tab, NULL, save_cb, NULL);
+	g_task_set_task_data (task, data, save_data_free);
+	g_task_run_in_thread (task, save_thread);
+	g_object_unref (task);
+}
+
+/* A compressed file is saved in the same compression format. */
+void
+gcsv_tab_save (GcsvTab *tab)
+{
+	TeplBuffer *buffer;
+	TeplFile *file;
+	GFile *location;
 
 	g_return_if_fail (GCSV_IS_TAB (tab));
 
@@ -276,29 +1909,30 @@ gcsv_tab_save (GcsvTab *tab)
 	location = tepl_file_get_location (file);
 	g_return_if_fail (location != NULL);
 
-	buffer_without_align = gcsv_alignment_copy_buffer_without_alignment (tab->priv->align);
+	/* The file would no longer be the one that is followed. */
+	gcsv_tab_set_follow_enabled (tab, FALSE);
 
-	saver = tepl_file_saver_new (buffer_without_align, file);
-	launch_saver (tab, saver);
+	launch_saver (tab, location, tab->priv->compression);
 }
 
+/* The compression format is chosen from the extension of @target_location,
+ * for example ".csv.gz" for gzip.
+ */
 void
 gcsv_tab_save_as (GcsvTab *tab,
 		  GFile   *target_location)
 {
-	TeplBuffer *buffer;
-	TeplFile *file;
-	TeplBuffer *buffer_without_align;
-	TeplFileSaver *saver;
+	gchar *basename;
+	GcsvCompression compression;
 
 	g_return_if_fail (GCSV_IS_TAB (tab));
 	g_return_if_fail (G_IS_FILE (target_location));
 
-	buffer = tepl_tab_get_buffer (TEPL_TAB (tab));
-	file = tepl_buffer_get_file (buffer);
+	gcsv_tab_set_follow_enabled (tab, FALSE);
 
-	buffer_without_align = gcsv_alignment_copy_buffer_without_alignment (tab->priv->align);
+	basename = g_file_get_basename (target_location);
+	compression = gcsv_compression_from_filename (basename);
+	g_free (basename);
 
-	saver = tepl_file_saver_new_with_target (buffer_without_align, file, target_location);
-	launch_saver (tab, saver);
+	launch_saver (tab, target_location, compression);
 }
@@ -22,6 +22,9 @@
 
 #include <tepl/tepl.h>
 #include "gcsv-alignment.h"
+#include "gcsv-compression.h"
+#include "gcsv-ragged-rows.h"
+#include "gcsv-sort.h"
 
 G_BEGIN_DECLS
 
@@ -48,17 +51,74 @@ struct _GcsvTabClass
 	TeplTabClass parent_class;
 };
 
-GType		gcsv_tab_get_type	(void);
+GType		gcsv_tab_get_type		(void);
 
-GcsvTab *	gcsv_tab_new		(void);
+GcsvTab *	gcsv_tab_new			(void);
 
-void		gcsv_tab_load_file	(GcsvTab *tab,
-					 GFile   *location);
+void		gcsv_tab_load_file		(GcsvTab *tab,
+						 GFile   *location);
 
-void		gcsv_tab_save		(GcsvTab *tab);
+void		gcsv_tab_load_file_read_only	(GcsvTab *tab,
+						 GFile   *location);
 
-void		gcsv_tab_save_as	(GcsvTab *tab,
-					 GFile   *target_location);
+gboolean	gcsv_tab_is_read_only		(GcsvTab *tab);
+
+void		gcsv_tab_set_alignment_priority	(GcsvTab               *tab,
+						 GcsvAlignmentPriority  priority);
+
+guint		gcsv_tab_get_alignment_queue_depth
+						(GcsvTab *tab);
+
+void		gcsv_tab_set_grid_view_enabled	(GcsvTab  *tab,
+						 gboolean  enabled);
+
+gboolean	gcsv_tab_get_grid_view_enabled	(GcsvTab *tab);
+
+void		gcsv_tab_set_filter_bar_visible	(GcsvTab  *tab,
+						 gboolean  visible);
+
+gboolean	gcsv_tab_get_filter_bar_visible	(GcsvTab *tab);
+
+void		gcsv_tab_set_search_bar_visible	(GcsvTab  *tab,
+						 gboolean  visible);
+
+gboolean	gcsv_tab_get_search_bar_visible	(GcsvTab *tab);
+
+void		gcsv_tab_set_stats_panel_visible
+						(GcsvTab  *tab,
+						 gboolean  visible);
+
+gboolean	gcsv_tab_get_stats_panel_visible
+						(GcsvTab *tab);
+
+GcsvRaggedRows *
+		gcsv_tab_get_ragged_rows	(GcsvTab *tab);
+
+gboolean	gcsv_tab_goto_ragged_row	(GcsvTab  *tab,
+						 gboolean  backward);
+
+void		gcsv_tab_set_follow_enabled	(GcsvTab  *tab,
+						 gboolean  enabled);
+
+gboolean	gcsv_tab_get_follow_enabled	(GcsvTab *tab);
+
+void		gcsv_tab_set_follow_auto_scroll	(GcsvTab  *tab,
+						 gboolean  auto_scroll);
+
+gboolean	gcsv_tab_get_follow_auto_scroll	(GcsvTab *tab);
+
+gboolean	gcsv_tab_can_follow		(GcsvTab *tab);
+
+GcsvCompression	gcsv_tab_get_compression	(GcsvTab *tab);
+
+void		gcsv_tab_sort_by_column		(GcsvTab      *tab,
+						 guint         column_num,
+						 GcsvSortMode  mode);
+
+void		gcsv_tab_save			(GcsvTab *tab);
+
+void		gcsv_tab_save_as		(GcsvTab *tab,
+						 GFile   *target_location);
 
 G_END_DECLS
 
@@ -0,0 +1,535 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-tokenizer.h"
+#include <string.h>
+
+/* Splits lines into fields, on plain UTF-8 byte ranges. It is the GLib-only
+ * equivalent of the GcsvBuffer functions working on GtkTextIter's, so it can
+ * be used in worker threads and without a display.
+ *
+ * The byte ranges are given as [start, end) pointers, they don't need to be
+ * nul-terminated. A line doesn't contain its line terminator.
+ *
+ * When the delimiter is '\0', there is no delimiter: each line contains only
+ * one field.
+ */
+
+void
+gcsv_tokenizer_init (GcsvTokenizer *tokenizer,
+		     gunichar       delimiter)
+{
+	g_return_if_fail (tokenizer != NULL);
+
+	memset (tokenizer, 0, sizeof (GcsvTokenizer));
+	tokenizer->delimiter = delimiter;
+
+	if (delimiter != '\0')
+	{
+		tokenizer->delimiter_len = g_unichar_to_utf8 (delimiter, tokenizer->delimiter_str);
+	}
+}
+
+gunichar
+gcsv_tokenizer_get_delimiter (const GcsvTokenizer *tokenizer)
+{
+	g_return_val_if_fail (tokenizer != NULL, '\0');
+
+	return tokenizer->delimiter;
+}
+
+/* Returns: the number of bytes of the delimiter in UTF-8. */
+gsize
+gcsv_tokenizer_get_delimiter_length (const GcsvTokenizer *tokenizer)
+{
+	g_return_val_if_fail (tokenizer != NULL, 0);
+
+	return tokenizer->delimiter_len;
+}
+
+/* Returns: the next delimiter between @p and @end, or %NULL if not found. */
+const gchar *
+gcsv_tokenizer_find_delimiter (const GcsvTokenizer *tokenizer,
+			       const gchar         *p,
+			       const gchar         *end)
+{
+	if (tokenizer->delimiter == '\0')
+	{
+		return NULL;
+	}
+
+	/* memchr() on the first byte is much faster than decoding each
+	 * character. The other bytes of a multi-byte delimiter are then
+	 * compared; in valid UTF-8 the first byte can not match in the
+	 * middle of another character.
+	 */
+	while (p < end)
+	{
+		p = memchr (p, tokenizer->delimiter_str[0], end - p);
+		if (p == NULL)
+		{
+			return NULL;
+		}
+
+		if ((gsize) (end - p) >= tokenizer->delimiter_len &&
+		    memcmp (p, tokenizer->delimiter_str, tokenizer->delimiter_len) == 0)
+		{
+			return p;
+		}
+
+		p++;
+	}
+
+	return NULL;
+}
+
+/* Returns: the column number (starting at 0) at @pos in @line, i.e. the number
+ * of delimiters between @line and @pos.
+ */
+guint
+gcsv_tokenizer_get_column_num (const GcsvTokenizer *tokenizer,
+			       const gchar         *line,
+			       const gchar         *pos)
+{
+	const gchar *p = line;
+	guint column_num = 0;
+
+	g_return_val_if_fail (tokenizer != NULL, 0);
+	g_return_val_if_fail (line <= pos, 0);
+
+	while ((p = gcsv_tokenizer_find_delimiter (tokenizer, p, pos)) != NULL)
+	{
+		column_num++;
+		p += tokenizer->delimiter_len;
+	}
+
+	return column_num;
+}
+
+/* Returns: the number of fields in the line, at least one. */
+guint
+gcsv_tokenizer_count_columns (const GcsvTokenizer *tokenizer,
+			      const gchar         *line,
+			      const gchar         *line_end)
+{
+	return gcsv_tokenizer_get_column_num (tokenizer, line, line_end) + 1;
+}
+
+/* Gets the field bounds, delimiters excluded. Returns FALSE if the line
+ * doesn't have that column.
+ */
+gboolean
+gcsv_tokenizer_get_field_bounds (const GcsvTokenizer  *tokenizer,
+				 const gchar          *line,
+				 const gchar          *line_end,
+				 guint                 column_num,
+				 const gchar         **field_start,
+				 const gchar         **field_end)
+{
+	const gchar *start = line;
+	const gchar *end;
+	guint i;
+
+	g_return_val_if_fail (tokenizer != NULL, FALSE);
+	g_return_val_if_fail (line <= line_end, FALSE);
+
+	for (i = 0; i < column_num; i++)
+	{
+		start = gcsv_tokenizer_find_delimiter (tokenizer, start, line_end);
+		if (start == NULL)
+		{
+			return FALSE;
+		}
+
+		start += tokenizer->delimiter_len;
+	}
+
+	end = gcsv_tokenizer_find_delimiter (tokenizer, start, line_end);
+	if (end == NULL)
+	{
+		end = line_end;
+	}
+
+	if (field_start != NULL)
+	{
+		*field_start = start;
+	}
+
+	if (field_end != NULL)
+	{
+		*field_end = end;
+	}
+
+	return TRUE;
+}
+
+/* Longer fields are not numbers. */
+#define MAX_NUMBER_LENGTH 63
+
+/* Parses a field as a decimal number, in the C locale, ignoring the leading
+ * and trailing spaces. Returns FALSE if the field is not a number.
+ */
+gboolean
+gcsv_tokenizer_parse_number (const gchar *field,
+			     const gchar *field_end,
+			     gdouble     *number)
+{
+	gchar buffer[MAX_NUMBER_LENGTH + 1];
+	gchar *number_end;
+
+	g_return_val_if_fail (field <= field_end, FALSE);
+	g_return_val_if_fail (number != NULL, FALSE);
+
+	while (field < field_end && g_ascii_isspace (*field))
+	{
+		field++;
+	}
+
+	while (field < field_end && g_ascii_isspace (field_end[-1]))
+	{
+		field_end--;
+	}
+
+	if (field == field_end || field_end - field > MAX_NUMBER_LENGTH)
+	{
+		return FALSE;
+	}
+
+	memcpy (buffer, field, field_end - field);
+	buffer[field_end - field] = '\0';
+
+	*number = g_ascii_strtod (buffer, &number_end);
+	return *number_end == '\0';
+}
+
+/* Splits the line into fields. @fields is an array of #GcsvField, it is
+ * emptied first, so it can be reused between lines without reallocation.
+ */
+void
+gcsv_tokenizer_split_line (const GcsvTokenizer *tokenizer,
+			   const gchar         *line,
+			   const gchar         *line_end,
+			   GArray              *fields)
+{
+	GcsvField field;
+
+	g_return_if_fail (tokenizer != NULL);
+	g_return_if_fail (line <= line_end);
+	g_return_if_fail (fields != NULL);
+
+	g_array_set_size (fields, 0);
+	field.start = line;
+
+	while ((field.end = gcsv_tokenizer_find_delimiter (tokenizer, field.start, line_end)) != NULL)
+	{
+		g_array_append_val (fields, field);
+		field.start = field.end + tokenizer->delimiter_len;
+	}
+
+	field.end = line_end;
+	g_array_append_val (fields, field);
+}
+
+/* Returns: the end of the line starting at @p, without the line terminator
+ * ("\n" or "\r\n"). Sets @next_line_start to the start of the next line, or to
+ * @end if it is the last line.
+ */
+const gchar *
+gcsv_tokenizer_find_line_end (const gchar  *p,
+			      const gchar  *end,
+			      const gchar **next_line_start)
+{
+	const gchar *newline;
+
+	g_return_val_if_fail (p <= end, end);
+	g_return_val_if_fail (next_line_start != NULL, end);
+
+	newline = memchr (p, '\n', end - p);
+	if (newline == NULL)
+	{
+		*next_line_start = end;
+		return end;
+	}
+
+	*next_line_start = newline + 1;
+
+	if (newline > p && newline[-1] == '\r')
+	{
+		return newline - 1;
+	}
+
+	return newline;
+}
+
+/* Histogram of the number of occurrences of a candidate delimiter per line.
+ * Lines with more than MAX_COUNT occurrences are ignored for that candidate.
+ */
+#define MAX_COUNT 63
+
+typedef struct
+{
+	gunichar delimiter;
+	guint n_lines_with_count[MAX_COUNT + 1];
+} Candidate;
+
+static guint
+candidate_get_mode (const Candidate *candidate,
+		    guint           *n_lines)
+{
+	guint mode = 0;
+	guint count;
+
+	*n_lines = 0;
+
+	/* A count of 0 means that the candidate doesn't appear in the line, it
+	 * cannot be the mode.
+	 */
+	for (count = 1; count <= MAX_COUNT; count++)
+	{
+		if (candidate->n_lines_with_count[count] > *n_lines)
+		{
+			mode = count;
+			*n_lines = candidate->n_lines_with_count[count];
+		}
+	}
+
+	return mode;
+}
+
+/* Guesses the delimiter from the first GCSV_TOKENIZER_GUESS_SAMPLE_SIZE bytes
+ * of @sample. Each candidate delimiter is counted in each line, outside of
+ * double-quoted fields, and the candidate that occurs the same number of times
+ * in the most lines wins. On a tie, the candidate occurring the most times per
+ * line wins, so that the commas of decimal numbers in a semicolon-separated
+ * file don't win over the semicolons.
+ *
+ * @sample can be the whole content: when it is longer than the bytes looked at,
+ * the last line, likely truncated, is ignored.
+ *
+ * Returns: the guessed delimiter, a comma if no candidate was found.
+ */
+gunichar
+gcsv_tokenizer_guess_delimiter (const gchar *sample,
+				gsize        sample_length)
+{
+	Candidate candidates[] = {
+		{ ',' },
+		{ ';' },
+		{ '\t' },
+		{ '|' },
+	};
+	const gchar *p = sample;
+	const gchar *end;
+	gboolean truncated;
+	gunichar best_delimiter = ',';
+	guint best_n_lines = 0;
+	guint best_mode = 0;
+	guint i;
+
+	g_return_val_if_fail (sample != NULL || sample_length == 0, ',');
+
+	truncated = sample_length > GCSV_TOKENIZER_GUESS_SAMPLE_SIZE;
+	end = sample + MIN (sample_length, GCSV_TOKENIZER_GUESS_SAMPLE_SIZE);
+
+	while (p < end)
+	{
+		const gchar *line_end;
+		const gchar *next_line_start;
+		guint counts[G_N_ELEMENTS (candidates)] = { 0 };
+		gboolean in_quotes = FALSE;
+
+		line_end = gcsv_tokenizer_find_line_end (p, end, &next_line_start);
+
+		if (truncated && next_line_start == end && p != sample)
+		{
+			break;
+		}
+
+		for (; p < line_end; p++)
+		{
+			switch (*p)
+			{
+				case '"':
+					in_quotes = !in_quotes;
+					break;
+
+				case ',':
+					counts[0] += !in_quotes;
+					break;
+
+				case ';':
+					counts[1] += !in_quotes;
+					break;
+
+				case '\t':
+					counts[2] += !in_quotes;
+					break;
+
+				case '|':
+					counts[3] += !in_quotes;
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		for (i = 0; i < G_N_ELEMENTS (candidates); i++)
+		{
+			if (counts[i] <= MAX_COUNT)
+			{
+				candidates[i].n_lines_with_count[counts[i]]++;
+			}
+		}
+
+		p = next_line_start;
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (candidates); i++)
+	{
+		guint mode;
+		guint n_lines;
+
+		mode = candidate_get_mode (&candidates[i], &n_lines);
+
+		if (mode > 0 &&
+		    (n_lines > best_n_lines ||
+		     (n_lines == best_n_lines && mode > best_mode)))
+		{
+			best_delimiter = candidates[i].delimiter;
+			best_n_lines = n_lines;
+			best_mode = mode;
+		}
+	}
+
+	return best_delimiter;
+}
+
+/* Returns: the maximum number of fields of the lines in @text. */
+guint
+gcsv_tokenizer_count_max_columns (const GcsvTokenizer *tokenizer,
+				  const gchar         *text,
+				  const gchar         *text_end)
+{
+	const gchar *p = text;
+	guint max_columns = 1;
+
+	g_return_val_if_fail (tokenizer != NULL, 1);
+	g_return_val_if_fail (text <= text_end, 1);
+
+	while (p < text_end)
+	{
+		const gchar *line_end;
+		const gchar *next_line_start;
+
+		line_end = gcsv_tokenizer_find_line_end (p, text_end, &next_line_start);
+		max_columns = MAX (max_columns, gcsv_tokenizer_count_columns (tokenizer, p, line_end));
+		p = next_line_start;
+	}
+
+	return max_columns;
+}
+
+/* Rewrites the fields of each line of @text, in one pass, and appends the
+ * result to @output.
+ *
+ * @column_map contains gint's: the new column i contains the field of the old
+ * column g_array_index (column_map, gint, i), or is an empty field if the value
+ * is -1. When a line doesn't have the old column, the new field is empty too,
+ * but such fields are dropped at the end of the line, so that short lines stay
+ * short. The line terminators are kept.
+ */
+void
+gcsv_tokenizer_remap_columns (const GcsvTokenizer *tokenizer,
+			      const gchar         *text,
+			      const gchar         *text_end,
+			      const GArray        *column_map,
+			      GString             *output)
+{
+	const gchar *p = text;
+	GArray *fields;
+
+	g_return_if_fail (tokenizer != NULL);
+	g_return_if_fail (tokenizer->delimiter != '\0');
+	g_return_if_fail (text <= text_end);
+	g_return_if_fail (column_map != NULL);
+	g_return_if_fail (output != NULL);
+
+	fields = g_array_new (FALSE, FALSE, sizeof (GcsvField));
+
+	while (p < text_end)
+	{
+		const gchar *line_end;
+		const gchar *next_line_start;
+		guint n_new_columns;
+		guint i;
+
+		line_end = gcsv_tokenizer_find_line_end (p, text_end, &next_line_start);
+
+		/* Empty lines stay empty. */
+		if (p == line_end)
+		{
+			g_string_append_len (output, p, next_line_start - p);
+			p = next_line_start;
+			continue;
+		}
+
+		gcsv_tokenizer_split_line (tokenizer, p, line_end, fields);
+
+		/* Drop the trailing missing fields. */
+		n_new_columns = column_map->len;
+		while (n_new_columns > 1)
+		{
+			gint old_column = g_array_index (column_map, gint, n_new_columns - 1);
+
+			if (old_column == -1 || (guint) old_column < fields->len)
+			{
+				break;
+			}
+
+			n_new_columns--;
+		}
+
+		for (i = 0; i < n_new_columns; i++)
+		{
+			gint old_column = g_array_index (column_map, gint, i);
+
+			if (i > 0)
+			{
+				g_string_append_len (output,
+						     tokenizer->delimiter_str,
+						     tokenizer->delimiter_len);
+			}
+
+			if (old_column >= 0 && (guint) old_column < fields->len)
+			{
+				const GcsvField *field = &g_array_index (fields, GcsvField, old_column);
+
+				g_string_append_len (output, field->start, field->end - field->start);
+			}
+		}
+
+		/* The line terminator. */
+		g_string_append_len (output, line_end, next_line_start - line_end);
+
+		p = next_line_start;
+	}
+
+	g_array_unref (fields);
+}
@@ -0,0 +1,103 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_TOKENIZER_H
+#define GCSV_TOKENIZER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GcsvTokenizer GcsvTokenizer;
+
+typedef struct _GcsvField GcsvField;
+
+struct _GcsvField
+{
+	const gchar *start;
+	const gchar *end;
+};
+
+/* Number of bytes looked at by gcsv_tokenizer_guess_delimiter(). */
+#define GCSV_TOKENIZER_GUESS_SAMPLE_SIZE (64 * 1024)
+
+/* To allocate on the stack or inside another struct. */
+struct _GcsvTokenizer
+{
+	/*< private >*/
+	gunichar delimiter;
+	gchar delimiter_str[8];
+	gsize delimiter_len;
+};
+
+void		gcsv_tokenizer_init			(GcsvTokenizer *tokenizer,
+							 gunichar       delimiter);
+
+gunichar	gcsv_tokenizer_get_delimiter		(const GcsvTokenizer *tokenizer);
+
+gsize		gcsv_tokenizer_get_delimiter_length	(const GcsvTokenizer *tokenizer);
+
+const gchar *	gcsv_tokenizer_find_delimiter		(const GcsvTokenizer *tokenizer,
+							 const gchar         *p,
+							 const gchar         *end);
+
+guint		gcsv_tokenizer_get_column_num		(const GcsvTokenizer *tokenizer,
+							 const gchar         *line,
+							 const gchar         *pos);
+
+guint		gcsv_tokenizer_count_columns		(const GcsvTokenizer *tokenizer,
+							 const gchar         *line,
+							 const gchar         *line_end);
+
+gboolean	gcsv_tokenizer_get_field_bounds		(const GcsvTokenizer  *tokenizer,
+							 const gchar          *line,
+							 const gchar          *line_end,
+							 guint                 column_num,
+							 const gchar         **field_start,
+							 const gchar         **field_end);
+
+gboolean	gcsv_tokenizer_parse_number		(const gchar *field,
+							 const gchar *field_end,
+							 gdouble     *number);
+
+void		gcsv_tokenizer_split_line		(const GcsvTokenizer *tokenizer,
+							 const gchar         *line,
+							 const gchar         *line_end,
+							 GArray              *fields);
+
+const gchar *	gcsv_tokenizer_find_line_end		(const gchar  *p,
+							 const gchar  *end,
+							 const gchar **next_line_start);
+
+gunichar	gcsv_tokenizer_guess_delimiter		(const gchar *sample,
+							 gsize        sample_length);
+
+guint		gcsv_tokenizer_count_max_columns	(const GcsvTokenizer *tokenizer,
+							 const gchar         *text,
+							 const gchar         *text_end);
+
+void		gcsv_tokenizer_remap_columns		(const GcsvTokenizer *tokenizer,
+							 const gchar         *text,
+							 const gchar         *text_end,
+							 const GArray        *column_map,
+							 GString             *output);
+
+G_END_DECLS
+
+#endif /* GCSV_TOKENIZER_H */
@@ -0,0 +1,340 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-trigram-index.h"
+#include <stdlib.h>
+#include <string.h>
+#include "gcsv-tokenizer.h"
+
+/* An index of the trigrams (sequences of 3 bytes) of some lines, to find
+ * quickly the lines that may contain a pattern: a line contains the pattern
+ * only if it contains all the trigrams of the pattern. The candidate lines
+ * must then be checked, the index gives a superset.
+ *
+ * The ASCII letters are indexed in lowercase, so the same index works for a
+ * case sensitive search and for a case insensitive search of an ASCII pattern.
+ * The trigrams spanning a line terminator are not indexed.
+ *
+ * To keep the index small, the lines are grouped in at most 256 blocks, and
+ * the index stores, for each distinct trigram, the sorted list of the blocks
+ * containing it, one byte per block. The candidate lines are the lines of the
+ * blocks that contain all the trigrams of the pattern.
+ *
+ * The index is immutable: it is built in one go, typically in a worker thread,
+ * for a chunk of a few thousand lines. When the lines change, the index of the
+ * chunk is built again.
+ */
+
+#define MAX_N_BLOCKS 256
+
+struct _GcsvTrigramIndex
+{
+	guint n_lines;
+	guint block_n_lines;
+
+	/* Sorted distinct trigrams. The blocks of trigrams[i] are
+	 * blocks[starts[i]] to blocks[starts[i+1] - 1], in increasing order.
+	 */
+	guint32 *trigrams;
+	guint32 *starts;
+	guint8 *blocks;
+	guint n_trigrams;
+};
+
+static inline guint32
+get_trigram (const gchar *p)
+{
+	return (((guint32) (guint8) g_ascii_tolower (p[0])) << 16 |
+		((guint32) (guint8) g_ascii_tolower (p[1])) << 8 |
+		((guint32) (guint8) g_ascii_tolower (p[2])));
+}
+
+static gint
+compare_keys (gconstpointer a,
+	      gconstpointer b)
+{
+	guint32 key_a = *(const guint32 *) a;
+	guint32 key_b = *(const guint32 *) b;
+
+	return key_a < key_b ? -1 : key_a > key_b;
+}
+
+static guint
+count_lines (const gchar *text,
+	     const gchar *text_end)
+{
+	const gchar *line = text;
+	guint n_lines = 0;
+
+	while (line < text_end)
+	{
+		gcsv_tokenizer_find_line_end (line, text_end, &line);
+		n_lines++;
+	}
+
+	return n_lines;
+}
+
+/* Blocking function, to call in a worker thread for big texts. */
+GcsvTrigramIndex *
+gcsv_trigram_index_new (const gchar *text,
+			const gchar *text_end)
+{
+	GcsvTrigramIndex *index;
+	GArray *keys;
+	const gchar *line;
+	guint32 *key_data;
+	guint n_keys;
+	guint line_num;
+	guint i;
+
+	g_return_val_if_fail (text <= text_end, NULL);
+
+	index = g_new0 (GcsvTrigramIndex, 1);
+	index->n_lines = count_lines (text, text_end);
+	index->block_n_lines = MAX (1, (index->n_lines + MAX_N_BLOCKS - 1) / MAX_N_BLOCKS);
+
+	/* A key is the trigram in the high 24 bits and the block in the low 8
+	 * bits, so sorting the keys groups them by trigram, then by block.
+	 */
+	keys = g_array_sized_new (FALSE, FALSE, sizeof (guint32), text_end - text);
+
+	line = text;
+	for (line_num = 0; line < text_end; line_num++)
+	{
+		const gchar *line_end;
+		const gchar *next_line_start;
+		guint32 block = line_num / index->block_n_lines;
+		const gchar *p;
+
+		line_end = gcsv_tokenizer_find_line_end (line, text_end, &next_line_start);
+
+		for (p = line; p + 3 <= line_end; p++)
+		{
+			guint32 key = get_trigram (p) << 8 | block;
+			g_array_append_val (keys, key);
+		}
+
+		line = next_line_start;
+	}
+
+	qsort (keys->data, keys->len, sizeof (guint32), compare_keys);
+
+	/* Removes the duplicates. */
+	key_data = (guint32 *) (gpointer) keys->data;
+	n_keys = 0;
+	for (i = 0; i < keys->len; i++)
+	{
+		if (n_keys == 0 || key_data[i] != key_data[n_keys - 1])
+		{
+			key_data[n_keys++] = key_data[i];
+		}
+	}
+
+	index->blocks = g_new (guint8, MAX (n_keys, 1));
+	index->trigrams = g_new (guint32, MAX (n_keys, 1));
+	index->starts = g_new (guint32, n_keys + 1);
+
+	for (i = 0; i < n_keys; i++)
+	{
+		guint32 trigram = key_data[i] >> 8;
+
+		if (index->n_trigrams == 0 ||
+		    index->trigrams[index->n_trigrams - 1] != trigram)
+		{
+			index->trigrams[index->n_trigrams] = trigram;
+			index->starts[index->n_trigrams] = i;
+			index->n_trigrams++;
+		}
+
+		index->blocks[i] = key_data[i] & 0xff;
+	}
+
+	index->starts[index->n_trigrams] = n_keys;
+
+	/* The trigrams array is usually much smaller than the blocks array. */
+	index->trigrams = g_renew (guint32, index->trigrams, MAX (index->n_trigrams, 1));
+	index->starts = g_renew (guint32, index->starts, index->n_trigrams + 1);
+
+	g_array_unref (keys);
+	return index;
+}
+
+void
+gcsv_trigram_index_free (GcsvTrigramIndex *index)
+{
+	if (index != NULL)
+	{
+		g_free (index->trigrams);
+		g_free (index->starts);
+		g_free (index->blocks);
+		g_free (index);
+	}
+}
+
+guint
+gcsv_trigram_index_get_n_lines (const GcsvTrigramIndex *index)
+{
+	g_return_val_if_fail (index != NULL, 0);
+
+	return index->n_lines;
+}
+
+/* Returns: the approximate memory used by the index, in bytes. */
+gsize
+gcsv_trigram_index_get_size (const GcsvTrigramIndex *index)
+{
+	g_return_val_if_fail (index != NULL, 0);
+
+	return (sizeof (GcsvTrigramIndex) +
+		index->n_trigrams * 2 * sizeof (guint32) +
+		index->starts[index->n_trigrams]);
+}
+
+/* Returns: the position of @trigram in index->trigrams, or -1. */
+static gint
+find_trigram (const GcsvTrigramIndex *index,
+	      guint32                 trigram)
+{
+	gint low = 0;
+	gint high = (gint) index->n_trigrams - 1;
+
+	while (low <= high)
+	{
+		gint middle = low + (high - low) / 2;
+
+		if (index->trigrams[middle] == trigram)
+		{
+			return middle;
+		}
+
+		if (index->trigrams[middle] < trigram)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+
+	return -1;
+}
+
+/* Keeps in @candidates, of length *n_candidates, only the blocks that are
+ * also in the blocks of the trigram at @trigram_pos.
+ */
+static void
+intersect (const GcsvTrigramIndex *index,
+	   gint                    trigram_pos,
+	   guint8                 *candidates,
+	   guint                  *n_candidates)
+{
+	const guint8 *blocks = index->blocks + index->starts[trigram_pos];
+	guint n_blocks = index->starts[trigram_pos + 1] - index->starts[trigram_pos];
+	guint n_kept = 0;
+	guint i = 0;
+	guint j = 0;
+
+	while (i < *n_candidates && j < n_blocks)
+	{
+		if (candidates[i] == blocks[j])
+		{
+			candidates[n_kept++] = candidates[i];
+			i++;
+			j++;
+		}
+		else if (candidates[i] < blocks[j])
+		{
+			i++;
+		}
+		else
+		{
+			j++;
+		}
+	}
+
+	*n_candidates = n_kept;
+}
+
+/* Appends to @candidate_lines (an array of guint's) the numbers of the lines
+ * that may contain @pattern, in increasing order. @pattern must not contain a
+ * line terminator.
+ *
+ * Returns: %FALSE if @pattern is too short to use the index, in which case all
+ * the lines are candidates and nothing is appended.
+ */
+gboolean
+gcsv_trigram_index_lookup (const GcsvTrigramIndex *index,
+			   const gchar            *pattern,
+			   gsize                   pattern_length,
+			   GArray                 *candidate_lines)
+{
+	guint8 candidates[MAX_N_BLOCKS];
+	guint n_candidates = 0;
+	gsize pos;
+	guint i;
+
+	g_return_val_if_fail (index != NULL, FALSE);
+	g_return_val_if_fail (pattern != NULL, FALSE);
+	g_return_val_if_fail (candidate_lines != NULL, FALSE);
+
+	if (pattern_length < 3)
+	{
+		return FALSE;
+	}
+
+	for (pos = 0; pos + 3 <= pattern_length; pos++)
+	{
+		gint trigram_pos = find_trigram (index, get_trigram (pattern + pos));
+
+		if (trigram_pos == -1)
+		{
+			return TRUE;
+		}
+
+		if (pos == 0)
+		{
+			n_candidates = index->starts[trigram_pos + 1] - index->starts[trigram_pos];
+			memcpy (candidates, index->blocks + index->starts[trigram_pos], n_candidates);
+		}
+		else
+		{
+			intersect (index, trigram_pos, candidates, &n_candidates);
+		}
+
+		if (n_candidates == 0)
+		{
+			return TRUE;
+		}
+	}
+
+	for (i = 0; i < n_candidates; i++)
+	{
+		guint line_num = candidates[i] * index->block_n_lines;
+		guint block_end = MIN (line_num + index->block_n_lines, index->n_lines);
+
+		for (; line_num < block_end; line_num++)
+		{
+			g_array_append_val (candidate_lines, line_num);
+		}
+	}
+
+	return TRUE;
+}
@@ -0,0 +1,45 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_TRIGRAM_INDEX_H
+#define GCSV_TRIGRAM_INDEX_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GcsvTrigramIndex GcsvTrigramIndex;
+
+GcsvTrigramIndex *	gcsv_trigram_index_new		(const gchar *text,
+							 const gchar *text_end);
+
+void			gcsv_trigram_index_free		(GcsvTrigramIndex *index);
+
+guint			gcsv_trigram_index_get_n_lines	(const GcsvTrigramIndex *index);
+
+gsize			gcsv_trigram_index_get_size	(const GcsvTrigramIndex *index);
+
+gboolean		gcsv_trigram_index_lookup	(const GcsvTrigramIndex *index,
+							 const gchar            *pattern,
+							 gsize                   pattern_length,
+							 GArray                 *candidate_lines);
+
+G_END_DECLS
+
+#endif /* GCSV_TRIGRAM_INDEX_H */
@@ -0,0 +1,1259 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-undo-manager.h"
+#include <string.h>
+
+/* An undo manager for GcsvBuffer that records only the user edits, not the
+ * virtual spaces inserted or removed by GcsvAlignment. The default undo
+ * manager of GtkSourceBuffer records all the edits, so undoing an edit would
+ * also undo pieces of the alignment.
+ *
+ * An action is a list of deltas, with the positions in the text without the
+ * virtual spaces. A delta is applied with normal buffer edits, so
+ * GcsvAlignment re-aligns only the lines touched by the undo or redo. A
+ * GcsvBuffer::replace-lines edit, for example a sort or a column operation,
+ * is one delta containing the old and the new lines.
+ *
+ * The keystrokes typed in the same word are merged into one delta. The
+ * history is bounded by its memory usage (see the max-size property): the
+ * oldest actions are dropped when it is exceeded.
+ */
+
+typedef enum
+{
+	DELTA_INSERT,
+	DELTA_DELETE,
+	DELTA_REPLACE_LINES,
+} DeltaType;
+
+typedef struct _Delta Delta;
+struct _Delta
+{
+	DeltaType type;
+	guint line;
+
+	/* For DELTA_INSERT and DELTA_DELETE: the byte index in @line, without
+	 * the virtual spaces. For DELTA_REPLACE_LINES: the number of replaced
+	 * lines.
+	 */
+	guint index;
+
+	/* For DELTA_REPLACE_LINES: the number of lines after the replacement. */
+	guint new_n_lines;
+
+	/* The inserted or deleted text, or the new lines. Nul-terminated. */
+	gchar *text;
+	gsize length;
+
+	/* For DELTA_REPLACE_LINES: the replaced lines. */
+	gchar *old_text;
+	gsize old_length;
+};
+
+typedef struct _Action Action;
+struct _Action
+{
+	/* Array of Delta's, in the order of the edits. */
+	GArray *deltas;
+
+	/* Whether the next keystroke can be merged into this action. */
+	guint can_merge : 1;
+};
+
+struct _GcsvUndoManager
+{
+	GObject parent;
+
+	/* Weak ref, the buffer owns the undo manager. */
+	GcsvBuffer *buffer;
+
+	/* The Action's, oldest first. The first @n_done actions can be undone,
+	 * the others can be redone.
+	 */
+	GQueue *actions;
+	guint n_done;
+
+	/* The action that receives the deltas of the current user action. */
+	Action *current_action;
+
+	/* The value of @n_done when the buffer was saved, or -1 if that state
+	 * is no longer in the history.
+	 */
+	gint saved_n_done;
+
+	/* Approximate memory used by the actions, in bytes. */
+	guint64 size;
+	guint64 max_size;
+
+	/* During GcsvBuffer::replace-lines, the delta to add after the
+	 * replacement. Its text is NULL if the replacement is not recorded.
+	 */
+	Delta replace_lines_delta;
+	gint line_count_before_replace_lines;
+
+	/* The last line touched by the recorded deltas, when they have been
+	 * recorded. Only reset when the history is cleared, so it is an upper
+	 * bound.
+	 */
+	guint last_recorded_line;
+
+	gint not_undoable_depth;
+
+	/* During a not undoable action, whether it has only inserted text on
+	 * lines after @last_recorded_line, for example a followed file that
+	 * grows. The positions of the history are still valid in that case.
+	 */
+	guint not_undoable_after_history : 1;
+
+	guint in_user_action : 1;
+	guint in_replace_lines : 1;
+
+	/* During an undo or redo. */
+	guint applying : 1;
+};
+
+enum
+{
+	PROP_0,
+	PROP_BUFFER,
+	PROP_MAX_SIZE,
+};
+
+#define DEFAULT_MAX_SIZE (32 * 1024 * 1024)
+
+static void gtk_source_undo_manager_iface_init (GtkSourceUndoManagerIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (GcsvUndoManager, gcsv_undo_manager, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (GTK_SOURCE_TYPE_UNDO_MANAGER,
+						gtk_source_undo_manager_iface_init))
+
+static void
+delta_clear (Delta *delta)
+{
+	g_free (delta->text);
+	g_free (delta->old_text);
+	delta->text = NULL;
+	delta->old_text = NULL;
+}
+
+static guint64
+get_delta_size (const Delta *delta)
+{
+	return sizeof (Delta) + delta->length + delta->old_length;
+}
+
+static guint64
+get_action_size (Action *action)
+{
+	guint64 size = sizeof (Action);
+	guint i;
+
+	for (i = 0; i < action->deltas->len; i++)
+	{
+		size += get_delta_size (&g_array_index (action->deltas, Delta, i));
+	}
+
+	return size;
+}
+
+static void
+free_action (GcsvUndoManager *manager,
+	     Action          *action)
+{
+	guint i;
+
+	if (action == manager->current_action)
+	{
+		manager->current_action = NULL;
+	}
+
+	manager->size -= get_action_size (action);
+
+	for (i = 0; i < action->deltas->len; i++)
+	{
+		delta_clear (&g_array_index (action->deltas, Delta, i));
+	}
+
+	g_array_unref (action->deltas);
+	g_free (action);
+}
+
+static gboolean
+can_undo (GcsvUndoManager *manager)
+{
+	return manager->n_done > 0;
+}
+
+static gboolean
+can_redo (GcsvUndoManager *manager)
+{
+	return manager->n_done < g_queue_get_length (manager->actions);
+}
+
+static void
+notify_can_undo_redo (GcsvUndoManager *manager,
+		      gboolean         could_undo,
+		      gboolean         could_redo)
+{
+	if (could_undo != can_undo (manager))
+	{
+		gtk_source_undo_manager_can_undo_changed (GTK_SOURCE_UNDO_MANAGER (manager));
+	}
+
+	if (could_redo != can_redo (manager))
+	{
+		gtk_source_undo_manager_can_redo_changed (GTK_SOURCE_UNDO_MANAGER (manager));
+	}
+}
+
+/* Without notifying. */
+static void
+clear_history (GcsvUndoManager *manager)
+{
+	while (!g_queue_is_empty (manager->actions))
+	{
+		free_action (manager, g_queue_pop_head (manager->actions));
+	}
+
+	manager->n_done = 0;
+	manager->last_recorded_line = 0;
+
+	if (manager->buffer != NULL &&
+	    !gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (manager->buffer)))
+	{
+		manager->saved_n_done = 0;
+	}
+	else
+	{
+		manager->saved_n_done = -1;
+	}
+}
+
+static void
+remove_redo_actions (GcsvUndoManager *manager)
+{
+	while (can_redo (manager))
+	{
+		free_action (manager, g_queue_pop_tail (manager->actions));
+	}
+
+	if (manager->saved_n_done > (gint) manager->n_done)
+	{
+		manager->saved_n_done = -1;
+	}
+}
+
+/* Drops the oldest actions until the history fits in max_size. */
+static void
+limit_size (GcsvUndoManager *manager)
+{
+	while (manager->size > manager->max_size &&
+	       !g_queue_is_empty (manager->actions))
+	{
+		/* The redo actions depend on each other. */
+		if (manager->n_done == 0)
+		{
+			clear_history (manager);
+			break;
+		}
+
+		free_action (manager, g_queue_pop_head (manager->actions));
+		manager->n_done--;
+
+		if (manager->saved_n_done >= 0)
+		{
+			manager->saved_n_done--;
+		}
+	}
+}
+
+/* Counts "\r\n" twice, which is fine for an upper bound. */
+static guint
+count_line_terminators (const gchar *text,
+			gsize        length)
+{
+	guint count = 0;
+	gsize i;
+
+	for (i = 0; i < length; i++)
+	{
+		if (text[i] == '\n' || text[i] == '\r')
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static guint
+get_delta_last_line (const Delta *delta)
+{
+	if (delta->type == DELTA_REPLACE_LINES)
+	{
+		/* Up to the start of the line after the replaced ones. */
+		return delta->line + MAX (delta->index, delta->new_n_lines);
+	}
+
+	return delta->line + count_line_terminators (delta->text, delta->length);
+}
+
+/* A one-character insertion or deletion, on one line. */
+static gboolean
+is_keystroke (const Delta *delta)
+{
+	return (delta->type != DELTA_REPLACE_LINES &&
+		delta->text + delta->length == g_utf8_next_char (delta->text) &&
+		delta->text[0] != '\n' &&
+		delta->text[0] != '\r');
+}
+
+static gboolean
+is_word_char (GcsvUndoManager *manager,
+	      gunichar         ch)
+{
+	return (!g_unichar_isspace (ch) &&
+		ch != gcsv_buffer_get_delimiter (manager->buffer));
+}
+
+static void
+join_texts (Delta       *delta,
+	    const gchar *text,
+	    gsize        length,
+	    gboolean     prepend)
+{
+	gchar *joined;
+
+	joined = g_malloc (delta->length + length + 1);
+
+	if (prepend)
+	{
+		memcpy (joined, text, length);
+		memcpy (joined + length, delta->text, delta->length);
+	}
+	else
+	{
+		memcpy (joined, delta->text, delta->length);
+		memcpy (joined + delta->length, text, length);
+	}
+
+	delta->length += length;
+	joined[delta->length] = '\0';
+
+	g_free (delta->text);
+	delta->text = joined;
+}
+
+/* Merges a keystroke into the last action, if it continues the same word.
+ * Returns whether @delta has been merged, in which case its content is
+ * consumed.
+ */
+static gboolean
+merge_delta (GcsvUndoManager *manager,
+	     Delta           *delta)
+{
+	Action *action;
+	Delta *prev;
+	gboolean word_char;
+
+	if (!can_undo (manager) ||
+	    can_redo (manager) ||
+	    !is_keystroke (delta))
+	{
+		return FALSE;
+	}
+
+	action = g_queue_peek_tail (manager->actions);
+	if (!action->can_merge)
+	{
+		return FALSE;
+	}
+
+	prev = &g_array_index (action->deltas, Delta, 0);
+	if (prev->type != delta->type || prev->line != delta->line)
+	{
+		return FALSE;
+	}
+
+	word_char = is_word_char (manager, g_utf8_get_char (delta->text));
+
+	if (delta->type == DELTA_INSERT ||
+	    delta->index == prev->index)
+	{
+		/* Typing forward, or the Delete key. A new word starts at a
+		 * space or a delimiter.
+		 */
+		gunichar prev_ch = g_utf8_get_char (g_utf8_prev_char (prev->text + prev->length));
+
+		if ((delta->type == DELTA_INSERT && delta->index != prev->index + prev->length) ||
+		    (!word_char && is_word_char (manager, prev_ch)))
+		{
+			return FALSE;
+		}
+
+		join_texts (prev, delta->text, delta->length, FALSE);
+	}
+	else if (delta->index + delta->length == prev->index)
+	{
+		/* The BackSpace key. */
+		if (word_char != is_word_char (manager, g_utf8_get_char (prev->text)))
+		{
+			return FALSE;
+		}
+
+		join_texts (prev, delta->text, delta->length, TRUE);
+		prev->index = delta->index;
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	manager->size += delta->length;
+	delta_clear (delta);
+	return TRUE;
+}
+
+/* Takes the content of @delta. */
+static void
+add_delta (GcsvUndoManager *manager,
+	   Delta           *delta)
+{
+	gboolean could_undo = can_undo (manager);
+	gboolean could_redo = can_redo (manager);
+
+	manager->last_recorded_line = MAX (manager->last_recorded_line, get_delta_last_line (delta));
+
+	/* It can't be undone, and the actions before it neither. */
+	if (get_delta_size (delta) > manager->max_size)
+	{
+		delta_clear (delta);
+		clear_history (manager);
+		notify_can_undo_redo (manager, could_undo, could_redo);
+		return;
+	}
+
+	if (manager->current_action == NULL &&
+	    merge_delta (manager, delta))
+	{
+		manager->current_action = g_queue_peek_tail (manager->actions);
+	}
+	else
+	{
+		if (manager->current_action == NULL)
+		{
+			Action *action;
+
+			remove_redo_actions (manager);
+
+			action = g_new0 (Action, 1);
+			action->deltas = g_array_new (FALSE, FALSE, sizeof (Delta));
+			action->can_merge = is_keystroke (delta);
+
+			g_queue_push_tail (manager->actions, action);
+			manager->n_done++;
+			manager->size += sizeof (Action);
+			manager->current_action = action;
+		}
+		else
+		{
+			manager->current_action->can_merge = FALSE;
+		}
+
+		manager->size += get_delta_size (delta);
+		g_array_append_vals (manager->current_action->deltas, delta, 1);
+	}
+
+	if (!manager->in_user_action)
+	{
+		manager->current_action = NULL;
+	}
+
+	limit_size (manager);
+	notify_can_undo_redo (manager, could_undo, could_redo);
+}
+
+static gboolean
+is_recording (GcsvUndoManager *manager)
+{
+	return (manager->buffer != NULL &&
+		manager->not_undoable_depth == 0 &&
+		!manager->applying &&
+		!manager->in_replace_lines &&
+		!gcsv_buffer_is_virtual_spaces_edit (manager->buffer));
+}
+
+/* Called for the edits done during a not undoable action. */
+static void
+check_not_undoable_edit (GcsvUndoManager *manager,
+			 gboolean         insertion,
+			 gint             line)
+{
+	if (manager->buffer == NULL ||
+	    gcsv_buffer_is_virtual_spaces_edit (manager->buffer) ||
+	    (!can_undo (manager) && !can_redo (manager)))
+	{
+		return;
+	}
+
+	if (!insertion || (guint) line <= manager->last_recorded_line)
+	{
+		manager->not_undoable_after_history = FALSE;
+	}
+}
+
+static void
+insert_text_cb (GtkTextBuffer   *buffer,
+		GtkTextIter     *location,
+		const gchar     *text,
+		gint             length,
+		GcsvUndoManager *manager)
+{
+	Delta delta = { 0 };
+
+	if (manager->not_undoable_depth > 0)
+	{
+		check_not_undoable_edit (manager, TRUE, gtk_text_iter_get_line (location));
+		return;
+	}
+
+	if (!is_recording (manager) || length == 0)
+	{
+		return;
+	}
+
+	delta.type = DELTA_INSERT;
+	delta.line = gtk_text_iter_get_line (location);
+	delta.index = gcsv_buffer_get_line_index_without_virtual_spaces (manager->buffer, location);
+	delta.text = g_strndup (text, length);
+	delta.length = length;
+
+	add_delta (manager, &delta);
+}
+
+static void
+delete_range_cb (GtkTextBuffer   *buffer,
+		 GtkTextIter     *start,
+		 GtkTextIter     *end,
+		 GcsvUndoManager *manager)
+{
+	Delta delta = { 0 };
+
+	if (manager->not_undoable_depth > 0)
+	{
+		check_not_undoable_edit (manager, FALSE, gtk_text_iter_get_line (start));
+		return;
+	}
+
+	if (!is_recording (manager))
+	{
+		return;
+	}
+
+	delta.text = gcsv_buffer_get_text_without_virtual_spaces (manager->buffer, start, end);
+
+	/* Only virtual spaces. */
+	if (delta.text[0] == '\0')
+	{
+		g_free (delta.text);
+		return;
+	}
+
+	delta.type = DELTA_DELETE;
+	delta.line = gtk_text_iter_get_line (start);
+	delta.index = gcsv_buffer_get_line_index_without_virtual_spaces (manager->buffer, start);
+	delta.length = strlen (delta.text);
+
+	add_delta (manager, &delta);
+}
+
+static void
+replace_lines_cb (GcsvBuffer      *buffer,
+		  guint            start_line,
+		  guint            n_lines,
+		  const gchar     *text,
+		  GArray          *column_map,
+		  GArray          *column_lengths,
+		  GcsvUndoManager *manager)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	Delta *delta = &manager->replace_lines_delta;
+	GtkTextIter start;
+	GtkTextIter end;
+	gboolean recording;
+
+	recording = is_recording (manager);
+
+	if (manager->not_undoable_depth > 0)
+	{
+		check_not_undoable_edit (manager, FALSE, start_line);
+	}
+
+	/* The edits done by the replacement are part of this delta. */
+	manager->in_replace_lines = TRUE;
+
+	if (!recording)
+	{
+		return;
+	}
+
+	gtk_text_buffer_get_iter_at_line (text_buffer, &start, start_line);
+
+	if ((gint) (start_line + n_lines) < gtk_text_buffer_get_line_count (text_buffer))
+	{
+		gtk_text_buffer_get_iter_at_line (text_buffer, &end, start_line + n_lines);
+	}
+	else
+	{
+		gtk_text_buffer_get_end_iter (text_buffer, &end);
+	}
+
+	/* Don't copy the old lines if the delta can't fit in the history
+	 * anyway. Their number of characters is a lower bound of their size.
+	 */
+	if (strlen (text) + (guint64) (gtk_text_iter_get_offset (&end) - gtk_text_iter_get_offset (&start)) > manager->max_size)
+	{
+		gboolean could_undo = can_undo (manager);
+		gboolean could_redo = can_redo (manager);
+
+		clear_history (manager);
+		notify_can_undo_redo (manager, could_undo, could_redo);
+		return;
+	}
+
+	delta->type = DELTA_REPLACE_LINES;
+	delta->line = start_line;
+	delta->index = n_lines;
+	delta->text = g_strdup (text);
+	delta->length = strlen (text);
+	delta->old_text = gcsv_buffer_get_text_without_virtual_spaces (buffer, &start, &end);
+	delta->old_length = strlen (delta->old_text);
+
+	manager->line_count_before_replace_lines = gtk_text_buffer_get_line_count (text_buffer);
+}
+
+static void
+replace_lines_after_cb (GcsvBuffer      *buffer,
+			guint            start_line,
+			guint            n_lines,
+			const gchar     *text,
+			GArray          *column_map,
+			GArray          *column_lengths,
+			GcsvUndoManager *manager)
+{
+	Delta delta = manager->replace_lines_delta;
+
+	manager->in_replace_lines = FALSE;
+
+	if (delta.text == NULL)
+	{
+		return;
+	}
+
+	manager->replace_lines_delta.text = NULL;
+	manager->replace_lines_delta.old_text = NULL;
+
+	delta.new_n_lines = (n_lines +
+			     gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (buffer)) -
+			     manager->line_count_before_replace_lines);
+
+	add_delta (manager, &delta);
+}
+
+static void
+begin_user_action_cb (GtkTextBuffer   *buffer,
+		      GcsvUndoManager *manager)
+{
+	manager->in_user_action = TRUE;
+	manager->current_action = NULL;
+}
+
+static void
+end_user_action_cb (GtkTextBuffer   *buffer,
+		    GcsvUndoManager *manager)
+{
+	manager->in_user_action = FALSE;
+	manager->current_action = NULL;
+}
+
+static void
+modified_changed_cb (GtkTextBuffer   *buffer,
+		     GcsvUndoManager *manager)
+{
+	Action *action;
+
+	if (gtk_text_buffer_get_modified (buffer))
+	{
+		/* Not caused by a recorded edit, which would be a new action:
+		 * the save has failed (the flag is reset when the save starts).
+		 * The file doesn't contain that state.
+		 */
+		if (is_recording (manager) &&
+		    manager->saved_n_done == (gint) manager->n_done)
+		{
+			manager->saved_n_done = -1;
+		}
+
+		return;
+	}
+
+	manager->saved_n_done = manager->n_done;
+
+	/* The keystrokes after a save are a new action. */
+	if (manager->n_done > 0)
+	{
+		action = g_queue_peek_nth (manager->actions, manager->n_done - 1);
+		action->can_merge = FALSE;
+	}
+}
+
+static void
+forward_chars_without_virtual_spaces (GcsvUndoManager *manager,
+				      GtkTextIter     *iter,
+				      glong            n_chars)
+{
+	GtkTextTag *tag = gcsv_buffer_get_virtual_spaces_tag (manager->buffer);
+
+	while (n_chars > 0 && !gtk_text_iter_is_end (iter))
+	{
+		GtkTextIter chunk_end = *iter;
+		glong chunk_n_chars;
+
+		gtk_text_iter_forward_to_tag_toggle (&chunk_end, tag);
+
+		if (gtk_text_iter_has_tag (iter, tag))
+		{
+			*iter = chunk_end;
+			continue;
+		}
+
+		chunk_n_chars = gtk_text_iter_get_offset (&chunk_end) - gtk_text_iter_get_offset (iter);
+
+		if (n_chars <= chunk_n_chars)
+		{
+			gtk_text_iter_forward_chars (iter, n_chars);
+			return;
+		}
+
+		n_chars -= chunk_n_chars;
+		*iter = chunk_end;
+	}
+}
+
+static gboolean
+insert_text (GcsvUndoManager *manager,
+	     guint            line,
+	     guint            index,
+	     const gchar     *text,
+	     gsize            length)
+{
+	GtkTextIter iter;
+
+	if (!gcsv_buffer_get_iter_at_line_index_without_virtual_spaces (manager->buffer, &iter, line, index))
+	{
+		return FALSE;
+	}
+
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (manager->buffer), &iter, text, length);
+	return TRUE;
+}
+
+static gboolean
+delete_text (GcsvUndoManager *manager,
+	     guint            line,
+	     guint            index,
+	     const gchar     *text,
+	     gsize            length)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+	gchar *buffer_text;
+	gboolean same_text;
+
+	if (!gcsv_buffer_get_iter_at_line_index_without_virtual_spaces (manager->buffer, &start, line, index))
+	{
+		return FALSE;
+	}
+
+	end = start;
+	forward_chars_without_virtual_spaces (manager, &end, g_utf8_strlen (text, length));
+
+	/* In case the history doesn't match the buffer anymore, rather than
+	 * deleting the wrong text.
+	 */
+	buffer_text = gcsv_buffer_get_text_without_virtual_spaces (manager->buffer, &start, &end);
+	same_text = strcmp (buffer_text, text) == 0;
+	g_free (buffer_text);
+
+	if (same_text)
+	{
+		gtk_text_buffer_delete (GTK_TEXT_BUFFER (manager->buffer), &start, &end);
+	}
+
+	return same_text;
+}
+
+static gboolean
+replace_lines (GcsvUndoManager *manager,
+	       guint            start_line,
+	       guint            n_lines,
+	       const gchar     *text)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (manager->buffer);
+
+	if (start_line + n_lines > (guint) gtk_text_buffer_get_line_count (text_buffer))
+	{
+		return FALSE;
+	}
+
+	gcsv_buffer_replace_lines (manager->buffer, start_line, n_lines, text, NULL, NULL);
+	return TRUE;
+}
+
+static gboolean
+apply_delta (GcsvUndoManager *manager,
+	     const Delta     *delta,
+	     gboolean         undo)
+{
+	switch (delta->type)
+	{
+		case DELTA_INSERT:
+			return (undo ?
+				delete_text (manager, delta->line, delta->index, delta->text, delta->length) :
+				insert_text (manager, delta->line, delta->index, delta->text, delta->length));
+
+		case DELTA_DELETE:
+			return (undo ?
+				insert_text (manager, delta->line, delta->index, delta->text, delta->length) :
+				delete_text (manager, delta->line, delta->index, delta->text, delta->length));
+
+		case DELTA_REPLACE_LINES:
+			return (undo ?
+				replace_lines (manager, delta->line, delta->new_n_lines, delta->old_text) :
+				replace_lines (manager, delta->line, delta->index, delta->text));
+
+		default:
+			g_return_val_if_reached (FALSE);
+	}
+}
+
+/* Places the cursor where @delta has been undone or redone. */
+static void
+place_cursor (GcsvUndoManager *manager,
+	      const Delta     *delta,
+	      gboolean         undo)
+{
+	GtkTextIter iter;
+	gboolean after_text;
+
+	if (delta->type == DELTA_REPLACE_LINES)
+	{
+		gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (manager->buffer), &iter, delta->line);
+		gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (manager->buffer), &iter);
+		return;
+	}
+
+	if (!gcsv_buffer_get_iter_at_line_index_without_virtual_spaces (manager->buffer,
+									&iter,
+									delta->line,
+									delta->index))
+	{
+		return;
+	}
+
+	/* After the re-inserted or inserted text. */
+	after_text = (delta->type == DELTA_DELETE) == undo;
+	if (after_text)
+	{
+		forward_chars_without_virtual_spaces (manager, &iter, g_utf8_strlen (delta->text, delta->length));
+	}
+
+	gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (manager->buffer), &iter);
+}
+
+static void
+apply_action (GcsvUndoManager *manager,
+	      gboolean         undo)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (manager->buffer);
+	gboolean could_undo = can_undo (manager);
+	gboolean could_redo = can_redo (manager);
+	Action *action;
+	const Delta *last_delta = NULL;
+	gboolean success = TRUE;
+	guint i;
+
+	action = g_queue_peek_nth (manager->actions, undo ? manager->n_done - 1 : manager->n_done);
+	action->can_merge = FALSE;
+
+	manager->applying = TRUE;
+	gtk_text_buffer_begin_user_action (text_buffer);
+
+	for (i = 0; i < action->deltas->len && success; i++)
+	{
+		/* Undo in the reverse order. */
+		last_delta = &g_array_index (action->deltas, Delta,
+					     undo ? action->deltas->len - 1 - i : i);
+
+		success = apply_delta (manager, last_delta, undo);
+	}
+
+	gtk_text_buffer_end_user_action (text_buffer);
+	manager->applying = FALSE;
+
+	if (success)
+	{
+		if (undo)
+		{
+			manager->n_done--;
+		}
+		else
+		{
+			manager->n_done++;
+		}
+
+		place_cursor (manager, last_delta, undo);
+
+		gtk_text_buffer_set_modified (text_buffer, manager->saved_n_done != (gint) manager->n_done);
+	}
+	else
+	{
+		g_warning ("The undo history doesn't match the document, clearing it.");
+		clear_history (manager);
+	}
+
+	notify_can_undo_redo (manager, could_undo, could_redo);
+}
+
+static gboolean
+gcsv_undo_manager_can_undo (GtkSourceUndoManager *undo_manager)
+{
+	return can_undo (GCSV_UNDO_MANAGER (undo_manager));
+}
+
+static gboolean
+gcsv_undo_manager_can_redo (GtkSourceUndoManager *undo_manager)
+{
+	return can_redo (GCSV_UNDO_MANAGER (undo_manager));
+}
+
+static void
+gcsv_undo_manager_undo (GtkSourceUndoManager *undo_manager)
+{
+	GcsvUndoManager *manager = GCSV_UNDO_MANAGER (undo_manager);
+
+	g_return_if_fail (manager->buffer != NULL);
+	g_return_if_fail (can_undo (manager));
+
+	apply_action (manager, TRUE);
+}
+
+static void
+gcsv_undo_manager_redo (GtkSourceUndoManager *undo_manager)
+{
+	GcsvUndoManager *manager = GCSV_UNDO_MANAGER (undo_manager);
+
+	g_return_if_fail (manager->buffer != NULL);
+	g_return_if_fail (can_redo (manager));
+
+	apply_action (manager, FALSE);
+}
+
+static void
+gcsv_undo_manager_begin_not_undoable_action (GtkSourceUndoManager *undo_manager)
+{
+	GcsvUndoManager *manager = GCSV_UNDO_MANAGER (undo_manager);
+
+	if (manager->not_undoable_depth == 0)
+	{
+		manager->not_undoable_after_history = TRUE;
+	}
+
+	manager->not_undoable_depth++;
+}
+
+/* The positions in the history are no longer valid after a not undoable
+ * action, so the history is cleared. Except if the action has only inserted
+ * text after the lines of the history.
+ */
+static void
+gcsv_undo_manager_end_not_undoable_action (GtkSourceUndoManager *undo_manager)
+{
+	GcsvUndoManager *manager = GCSV_UNDO_MANAGER (undo_manager);
+	gboolean could_undo;
+	gboolean could_redo;
+
+	g_return_if_fail (manager->not_undoable_depth > 0);
+
+	manager->not_undoable_depth--;
+	if (manager->not_undoable_depth > 0 ||
+	    manager->not_undoable_after_history)
+	{
+		return;
+	}
+
+	could_undo = can_undo (manager);
+	could_redo = can_redo (manager);
+	clear_history (manager);
+	notify_can_undo_redo (manager, could_undo, could_redo);
+}
+
+static void
+gtk_source_undo_manager_iface_init (GtkSourceUndoManagerIface *iface)
+{
+	iface->can_undo = gcsv_undo_manager_can_undo;
+	iface->can_redo = gcsv_undo_manager_can_redo;
+	iface->undo = gcsv_undo_manager_undo;
+	iface->redo = gcsv_undo_manager_redo;
+	iface->begin_not_undoable_action = gcsv_undo_manager_begin_not_undoable_action;
+	iface->end_not_undoable_action = gcsv_undo_manager_end_not_undoable_action;
+}
+
+static void
+gcsv_undo_manager_get_property (GObject    *object,
+				guint       prop_id,
+				GValue     *value,
+				GParamSpec *pspec)
+{
+	GcsvUndoManager *manager = GCSV_UNDO_MANAGER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_value_set_object (value, manager->buffer);
+			break;
+
+		case PROP_MAX_SIZE:
+			g_value_set_uint64 (value, manager->max_size);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_undo_manager_set_property (GObject      *object,
+				guint         prop_id,
+				const GValue *value,
+				GParamSpec   *pspec)
+{
+	GcsvUndoManager *manager = GCSV_UNDO_MANAGER (object);
+
+	switch (prop_id)
+	{
+		case PROP_BUFFER:
+			g_assert (manager->buffer == NULL);
+			manager->buffer = g_value_get_object (value);
+			g_object_add_weak_pointer (G_OBJECT (manager->buffer),
+						   (gpointer *) &manager->buffer);
+			break;
+
+		case PROP_MAX_SIZE:
+			gcsv_undo_manager_set_max_size (manager, g_value_get_uint64 (value));
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gcsv_undo_manager_constructed (GObject *object)
+{
+	GcsvUndoManager *manager = GCSV_UNDO_MANAGER (object);
+
+	G_OBJECT_CLASS (gcsv_undo_manager_parent_class)->constructed (object);
+
+	/* Before the default handlers, to have the locations before the
+	 * edits.
+	 */
+	g_signal_connect_object (manager->buffer,
+				 "insert-text",
+				 G_CALLBACK (insert_text_cb),
+				 manager,
+				 0);
+
+	g_signal_connect_object (manager->buffer,
+				 "delete-range",
+				 G_CALLBACK (delete_range_cb),
+				 manager,
+				 0);
+
+	g_signal_connect_object (manager->buffer,
+				 "replace-lines",
+				 G_CALLBACK (replace_lines_cb),
+				 manager,
+				 0);
+
+	g_signal_connect_object (manager->buffer,
+				 "replace-lines",
+				 G_CALLBACK (replace_lines_after_cb),
+				 manager,
+				 G_CONNECT_AFTER);
+
+	g_signal_connect_object (manager->buffer,
+				 "begin-user-action",
+				 G_CALLBACK (begin_user_action_cb),
+				 manager,
+				 0);
+
+	g_signal_connect_object (manager->buffer,
+				 "end-user-action",
+				 G_CALLBACK (end_user_action_cb),
+				 manager,
+				 0);
+
+	g_signal_connect_object (manager->buffer,
+				 "modified-changed",
+				 G_CALLBACK (modified_changed_cb),
+				 manager,
+				 0);
+
+	manager->saved_n_done = gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (manager->buffer)) ? -1 : 0;
+}
+
+static void
+gcsv_undo_manager_dispose (GObject *object)
+{
+	GcsvUndoManager *manager = GCSV_UNDO_MANAGER (object);
+
+	if (manager->buffer != NULL)
+	{
+		g_object_remove_weak_pointer (G_OBJECT (manager->buffer),
+					      (gpointer *) &manager->buffer);
+		manager->buffer = NULL;
+	}
+
+	G_OBJECT_CLASS (gcsv_undo_manager_parent_class)->dispose (object);
+}
+
+static void
+gcsv_undo_manager_finalize (GObject *object)
+{
+	GcsvUndoManager *manager = GCSV_UNDO_MANAGER (object);
+
+	clear_history (manager);
+	g_queue_free (manager->actions);
+	delta_clear (&manager->replace_lines_delta);
+
+	G_OBJECT_CLASS (gcsv_undo_manager_parent_class)->finalize (object);
+}
+
+static void
+gcsv_undo_manager_class_init (GcsvUndoManagerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = gcsv_undo_manager_get_property;
+	object_class->set_property = gcsv_undo_manager_set_property;
+	object_class->constructed = gcsv_undo_manager_constructed;
+	object_class->dispose = gcsv_undo_manager_dispose;
+	object_class->finalize = gcsv_undo_manager_finalize;
+
+	g_object_class_install_property (object_class,
+					 PROP_BUFFER,
+					 g_param_spec_object ("buffer",
+							      "Buffer",
+							      "",
+							      GCSV_TYPE_BUFFER,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GcsvUndoManager:max-size:
+	 *
+	 * The maximum memory used by the history, in bytes. The oldest actions
+	 * are dropped when it is exceeded.
+	 */
+	g_object_class_install_property (object_class,
+					 PROP_MAX_SIZE,
+					 g_param_spec_uint64 ("max-size",
+							      "Max Size",
+							      "",
+							      0,
+							      G_MAXUINT64,
+							      DEFAULT_MAX_SIZE,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT |
+							      G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gcsv_undo_manager_init (GcsvUndoManager *manager)
+{
+	manager->actions = g_queue_new ();
+	manager->saved_n_done = -1;
+}
+
+/* To set with gtk_source_buffer_set_undo_manager(). */
+GcsvUndoManager *
+gcsv_undo_manager_new (GcsvBuffer *buffer)
+{
+	g_return_val_if_fail (GCSV_IS_BUFFER (buffer), NULL);
+
+	return g_object_new (GCSV_TYPE_UNDO_MANAGER,
+			     "buffer", buffer,
+			     NULL);
+}
+
+guint64
+gcsv_undo_manager_get_max_size (GcsvUndoManager *manager)
+{
+	g_return_val_if_fail (GCSV_IS_UNDO_MANAGER (manager), 0);
+
+	return manager->max_size;
+}
+
+void
+gcsv_undo_manager_set_max_size (GcsvUndoManager *manager,
+				guint64          max_size)
+{
+	gboolean could_undo;
+	gboolean could_redo;
+
+	g_return_if_fail (GCSV_IS_UNDO_MANAGER (manager));
+
+	if (manager->max_size == max_size)
+	{
+		return;
+	}
+
+	could_undo = can_undo (manager);
+	could_redo = can_redo (manager);
+
+	manager->max_size = max_size;
+	limit_size (manager);
+
+	notify_can_undo_redo (manager, could_undo, could_redo);
+	g_object_notify (G_OBJECT (manager), "max-size");
+}
+
+/* Returns: the approximate memory used by the history, in bytes. */
+guint64
+gcsv_undo_manager_get_size (GcsvUndoManager *manager)
+{
+	g_return_val_if_fail (GCSV_IS_UNDO_MANAGER (manager), 0);
+
+	return manager->size;
+}
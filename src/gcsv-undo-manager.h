@@ -0,0 +1,44 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCSV_UNDO_MANAGER_H
+#define GCSV_UNDO_MANAGER_H
+
+#include <gtksourceview/gtksource.h>
+#include "gcsv-buffer.h"
+
+G_BEGIN_DECLS
+
+#define GCSV_TYPE_UNDO_MANAGER (gcsv_undo_manager_get_type ())
+G_DECLARE_FINAL_TYPE (GcsvUndoManager, gcsv_undo_manager,
+		      GCSV, UNDO_MANAGER,
+		      GObject)
+
+GcsvUndoManager *	gcsv_undo_manager_new			(GcsvBuffer *buffer);
+
+guint64			gcsv_undo_manager_get_max_size		(GcsvUndoManager *manager);
+
+void			gcsv_undo_manager_set_max_size		(GcsvUndoManager *manager,
+								 guint64          max_size);
+
+guint64			gcsv_undo_manager_get_size		(GcsvUndoManager *manager);
+
+G_END_DECLS
+
+#endif /* GCSV_UNDO_MANAGER_H */
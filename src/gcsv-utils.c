@@ -20,6 +20,7 @@
  */
 
 #include "gcsv-utils.h"
+#include <string.h>
 
 /* Delete text in @buffer between @start and @end and containing @tag. */
 void
@@ -144,3 +145,151 @@ gcsv_utils_unblock_signal_handlers (GObject      *instance,
 		g_signal_handler_unblock (instance, handler_ids[i]);
 	}
 }
+
+/* Appends @text to @string. The text of a file is not necessarily valid UTF-8,
+ * and GTK+ needs valid UTF-8. Invalid bytes are replaced by U+FFFD.
+ */
+void
+gcsv_utils_append_valid_utf8 (GString     *string,
+			      const gchar *text,
+			      gsize        length)
+{
+	const gchar *end = text + length;
+
+	while (text < end)
+	{
+		const gchar *valid_end;
+
+		if (g_utf8_validate (text, end - text, &valid_end))
+		{
+			g_string_append_len (string, text, end - text);
+			return;
+		}
+
+		g_string_append_len (string, text, valid_end - text);
+		g_string_append (string, "\357\277\275");
+		text = valid_end + 1;
+	}
+}
+
+/* Removes the "\n" or "\r\n" at the end of @string, if any. A buffer with an
+ * implicit trailing newline doesn't contain the last line terminator of the
+ * file.
+ */
+void
+gcsv_utils_strip_last_line_terminator (GString *string)
+{
+	g_return_if_fail (string != NULL);
+
+	if (string->len > 0 && string->str[string->len - 1] == '\n')
+	{
+		g_string_truncate (string, string->len - 1);
+
+		if (string->len > 0 && string->str[string->len - 1] == '\r')
+		{
+			g_string_truncate (string, string->len - 1);
+		}
+	}
+}
+
+/* Returns: the character offsets where @tag is toggled in @buffer, by pairs:
+ * the start and the end of each range of text having @tag. Free with
+ * g_array_unref().
+ */
+GArray *
+gcsv_utils_get_tag_offsets (GtkTextBuffer *buffer,
+			    GtkTextTag    *tag)
+{
+	GArray *offsets;
+	GtkTextIter iter;
+	gint offset;
+
+	g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+	g_return_val_if_fail (GTK_IS_TEXT_TAG (tag), NULL);
+
+	offsets = g_array_new (FALSE, FALSE, sizeof (gint));
+	gtk_text_buffer_get_start_iter (buffer, &iter);
+
+	if (gtk_text_iter_has_tag (&iter, tag))
+	{
+		offset = 0;
+		g_array_append_val (offsets, offset);
+	}
+
+	while (gtk_text_iter_forward_to_tag_toggle (&iter, tag))
+	{
+		offset = gtk_text_iter_get_offset (&iter);
+		g_array_append_val (offsets, offset);
+	}
+
+	/* The last range goes until the end of the buffer. */
+	if (offsets->len % 2 == 1)
+	{
+		offset = gtk_text_iter_get_offset (&iter);
+		g_array_append_val (offsets, offset);
+	}
+
+	return offsets;
+}
+
+/* Removes from @text the ranges of characters given by @offsets, as returned
+ * by gcsv_utils_get_tag_offsets() for the buffer that @text comes from. @text
+ * is modified in place, it stays nul-terminated.
+ *
+ * It doesn't need the buffer, so it can run in a worker thread.
+ *
+ * Returns: the new length of @text, in bytes.
+ */
+gsize
+gcsv_utils_remove_char_ranges (gchar        *text,
+			       gsize         length,
+			       const GArray *offsets)
+{
+	const gchar *src = text;
+	gchar *dest = text;
+	gint src_offset = 0;
+	gsize n_bytes;
+	guint i;
+
+	g_return_val_if_fail (text != NULL, 0);
+	g_return_val_if_fail (offsets != NULL, length);
+
+	for (i = 0; i + 1 < offsets->len; i += 2)
+	{
+		gint range_start = g_array_index (offsets, gint, i);
+		gint range_end = g_array_index (offsets, gint, i + 1);
+		const gchar *range_start_pos;
+
+		range_start_pos = g_utf8_offset_to_pointer (src, range_start - src_offset);
+
+		n_bytes = range_start_pos - src;
+		memmove (dest, src, n_bytes);
+		dest += n_bytes;
+
+		src = g_utf8_offset_to_pointer (range_start_pos, range_end - range_start);
+		src_offset = range_end;
+	}
+
+	n_bytes = text + length - src;
+	memmove (dest, src, n_bytes);
+	dest += n_bytes;
+	*dest = '\0';
+
+	return dest - text;
+}
+
+/* Scrolls by @delta, without going past the bounds of @adjustment. */
+void
+gcsv_utils_scroll_adjustment_by (GtkAdjustment *adjustment,
+				 gdouble        delta)
+{
+	gdouble upper;
+	gdouble value;
+
+	g_return_if_fail (GTK_IS_ADJUSTMENT (adjustment));
+
+	upper = gtk_adjustment_get_upper (adjustment) - gtk_adjustment_get_page_size (adjustment);
+	value = gtk_adjustment_get_value (adjustment) + delta;
+
+	gtk_adjustment_set_value (adjustment, CLAMP (value, 0, MAX (upper, 0)));
+}
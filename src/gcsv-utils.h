@@ -37,6 +37,22 @@ gulong *	gcsv_utils_block_all_signal_handlers	(GObject     *instance,
 void		gcsv_utils_unblock_signal_handlers	(GObject      *instance,
 							 const gulong *handler_ids);
 
+void		gcsv_utils_append_valid_utf8		(GString     *string,
+							 const gchar *text,
+							 gsize        length);
+
+void		gcsv_utils_strip_last_line_terminator	(GString *string);
+
+GArray *	gcsv_utils_get_tag_offsets		(GtkTextBuffer *buffer,
+							 GtkTextTag    *tag);
+
+gsize		gcsv_utils_remove_char_ranges		(gchar        *text,
+							 gsize         length,
+							 const GArray *offsets);
+
+void		gcsv_utils_scroll_adjustment_by		(GtkAdjustment *adjustment,
+							 gdouble        delta);
+
 G_END_DECLS
 
 #endif /* GCSV_UTILS_H */
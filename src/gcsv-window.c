@@ -33,6 +33,9 @@ struct _GcsvWindow
 	GtkApplicationWindow parent;
 
 	GtkLabel *statusbar_label;
+
+	/* Tick callback to update the statusbar label at most once per frame. */
+	guint statusbar_tick_id;
 };
 
 G_DEFINE_TYPE (GcsvWindow, gcsv_window, GTK_TYPE_APPLICATION_WINDOW)
@@ -69,13 +72,22 @@ open_file_chooser_response_cb (GtkFileChooserDialog *file_chooser_dialog,
 {
 	if (response_id == GTK_RESPONSE_ACCEPT)
 	{
-		TeplApplication *app;
+		GtkWidget *read_only_check_button;
 		GFile *file;
 
 		file = gtk_file_chooser_get_file (GTK_FILE_CHOOSER (file_chooser_dialog));
-
-		app = tepl_application_get_default ();
-		tepl_application_open_simple (app, file);
+		read_only_check_button = gtk_file_chooser_get_extra_widget (GTK_FILE_CHOOSER (file_chooser_dialog));
+
+		if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (read_only_check_button)))
+		{
+			GApplication *app = g_application_get_default ();
+			g_application_open (app, &file, 1, GCSV_OPEN_HINT_READ_ONLY);
+		}
+		else
+		{
+			TeplApplication *app = tepl_application_get_default ();
+			tepl_application_open_simple (app, file);
+		}
 
 		g_object_unref (file);
 	}
@@ -93,6 +105,7 @@ open_activate_cb (GSimpleAction *open_action,
 	GtkFileChooser *file_chooser;
 	GtkFileFilter *dsv_filter;
 	GtkFileFilter *all_filter;
+	GtkWidget *read_only_check_button;
 
 	/* Create a GtkFileChooserDialog, not a GtkFileChooserNative, because
 	 * with GtkFileChooserNative the GFile that we obtain (in flatpak)
@@ -133,6 +146,13 @@ open_activate_cb (GSimpleAction *open_action,
 
 	gtk_file_chooser_set_filter (file_chooser, dsv_filter);
 
+	read_only_check_button = gtk_check_button_new_with_mnemonic (_("Open _read-only, for very large files"));
+	gtk_widget_set_tooltip_text (read_only_check_button,
+				     _("The file is not loaded into memory, so it can be larger than the available memory. "
+				       "It cannot be edited."));
+	gtk_widget_show (read_only_check_button);
+	gtk_file_chooser_set_extra_widget (file_chooser, read_only_check_button);
+
 	g_signal_connect_object (file_chooser_dialog,
 				 "response",
 				 G_CALLBACK (open_file_chooser_response_cb),
@@ -213,13 +233,303 @@ update_save_action_sensitivity (GcsvWindow *window)
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "save");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
 				     tepl_file_get_location (file) != NULL &&
-				     gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)));
+				     gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)) &&
+				     !gcsv_tab_is_read_only (get_tab (window)));
+}
+
+static void
+update_save_as_action_sensitivity (GcsvWindow *window)
+{
+	GAction *action;
+
+	action = g_action_map_lookup_action (G_ACTION_MAP (window), "save-as");
+	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
+				     !gcsv_tab_is_read_only (get_tab (window)));
+}
+
+static void
+update_grid_view_action_sensitivity (GcsvWindow *window)
+{
+	GAction *action;
+
+	action = g_action_map_lookup_action (G_ACTION_MAP (window), "grid-view");
+	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
+				     !gcsv_tab_is_read_only (get_tab (window)));
+}
+
+static void
+update_filter_bar_action_sensitivity (GcsvWindow *window)
+{
+	GAction *action;
+
+	action = g_action_map_lookup_action (G_ACTION_MAP (window), "filter-bar");
+	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
+				     !gcsv_tab_is_read_only (get_tab (window)));
+}
+
+static void
+update_search_bar_action_sensitivity (GcsvWindow *window)
+{
+	GAction *action;
+
+	action = g_action_map_lookup_action (G_ACTION_MAP (window), "search-bar");
+	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
+				     !gcsv_tab_is_read_only (get_tab (window)));
+}
+
+static void
+update_stats_panel_action_sensitivity (GcsvWindow *window)
+{
+	GAction *action;
+
+	action = g_action_map_lookup_action (G_ACTION_MAP (window), "stats-panel");
+	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
+				     !gcsv_tab_is_read_only (get_tab (window)));
+}
+
+static void
+update_follow_action_sensitivity (GcsvWindow *window)
+{
+	GAction *action;
+
+	action = g_action_map_lookup_action (G_ACTION_MAP (window), "follow");
+	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
+				     gcsv_tab_can_follow (get_tab (window)));
+}
+
+static void
+update_column_actions_sensitivity (GcsvWindow *window)
+{
+	const gchar *action_names[] = {
+		"insert-column",
+		"delete-column",
+		"duplicate-column",
+		"move-column-left",
+		"move-column-right",
+		"sort-by-column-text",
+		"sort-by-column-numeric",
+		"sort-by-column-locale",
+	};
+	gboolean enabled;
+	guint i;
+
+	enabled = (!gcsv_tab_is_read_only (get_tab (window)) &&
+		   gcsv_buffer_get_delimiter (get_buffer (window)) != '\0');
+
+	for (i = 0; i < G_N_ELEMENTS (action_names); i++)
+	{
+		GAction *action;
+
+		action = g_action_map_lookup_action (G_ACTION_MAP (window), action_names[i]);
+		g_simple_action_set_enabled (G_SIMPLE_ACTION (action), enabled);
+	}
 }
 
 static void
 update_actions_sensitivity (GcsvWindow *window)
 {
 	update_save_action_sensitivity (window);
+	update_save_as_action_sensitivity (window);
+	update_grid_view_action_sensitivity (window);
+	update_filter_bar_action_sensitivity (window);
+	update_search_bar_action_sensitivity (window);
+	update_stats_panel_action_sensitivity (window);
+	update_follow_action_sensitivity (window);
+	update_column_actions_sensitivity (window);
+}
+
+static void
+grid_view_change_state_cb (GSimpleAction *grid_view_action,
+			   GVariant      *state,
+			   gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_tab_set_grid_view_enabled (get_tab (window), g_variant_get_boolean (state));
+	g_simple_action_set_state (grid_view_action, state);
+}
+
+static void
+filter_bar_change_state_cb (GSimpleAction *filter_bar_action,
+			    GVariant      *state,
+			    gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_tab_set_filter_bar_visible (get_tab (window), g_variant_get_boolean (state));
+	g_simple_action_set_state (filter_bar_action, state);
+}
+
+static void
+search_bar_change_state_cb (GSimpleAction *search_bar_action,
+			    GVariant      *state,
+			    gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_tab_set_search_bar_visible (get_tab (window), g_variant_get_boolean (state));
+	g_simple_action_set_state (search_bar_action, state);
+}
+
+static void
+stats_panel_change_state_cb (GSimpleAction *stats_panel_action,
+			     GVariant      *state,
+			     gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_tab_set_stats_panel_visible (get_tab (window), g_variant_get_boolean (state));
+	g_simple_action_set_state (stats_panel_action, state);
+}
+
+static void
+follow_change_state_cb (GSimpleAction *follow_action,
+			GVariant      *state,
+			gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	/* The action state is updated by tab_follow_enabled_notify_cb(). */
+	gcsv_tab_set_follow_enabled (get_tab (window), g_variant_get_boolean (state));
+}
+
+static void
+follow_auto_scroll_change_state_cb (GSimpleAction *follow_auto_scroll_action,
+				    GVariant      *state,
+				    gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_tab_set_follow_auto_scroll (get_tab (window), g_variant_get_boolean (state));
+	g_simple_action_set_state (follow_auto_scroll_action, state);
+}
+
+/* The column where the cursor is. */
+static guint
+get_current_column_num (GcsvWindow *window)
+{
+	GtkTextBuffer *buffer;
+	GtkTextIter insert_iter;
+
+	buffer = GTK_TEXT_BUFFER (get_buffer (window));
+	gtk_text_buffer_get_iter_at_mark (buffer,
+					  &insert_iter,
+					  gtk_text_buffer_get_insert (buffer));
+
+	return gcsv_buffer_get_column_num (GCSV_BUFFER (buffer), &insert_iter);
+}
+
+static void
+insert_column_activate_cb (GSimpleAction *action,
+			   GVariant      *parameter,
+			   gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_buffer_insert_column (get_buffer (window), get_current_column_num (window));
+}
+
+static void
+delete_column_activate_cb (GSimpleAction *action,
+			   GVariant      *parameter,
+			   gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_buffer_delete_column (get_buffer (window), get_current_column_num (window));
+}
+
+static void
+duplicate_column_activate_cb (GSimpleAction *action,
+			      GVariant      *parameter,
+			      gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_buffer_duplicate_column (get_buffer (window), get_current_column_num (window));
+}
+
+static void
+move_column_left_activate_cb (GSimpleAction *action,
+			      GVariant      *parameter,
+			      gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+	guint column_num;
+
+	column_num = get_current_column_num (window);
+	if (column_num > 0)
+	{
+		gcsv_buffer_move_column (get_buffer (window), column_num, column_num - 1);
+	}
+}
+
+static void
+move_column_right_activate_cb (GSimpleAction *action,
+			       GVariant      *parameter,
+			       gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+	guint column_num;
+
+	column_num = get_current_column_num (window);
+	gcsv_buffer_move_column (get_buffer (window), column_num, column_num + 1);
+}
+
+static void
+sort_by_column_text_activate_cb (GSimpleAction *action,
+				 GVariant      *parameter,
+				 gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_tab_sort_by_column (get_tab (window),
+				 get_current_column_num (window),
+				 GCSV_SORT_MODE_LEXICOGRAPHIC);
+}
+
+static void
+sort_by_column_numeric_activate_cb (GSimpleAction *action,
+				    GVariant      *parameter,
+				    gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_tab_sort_by_column (get_tab (window),
+				 get_current_column_num (window),
+				 GCSV_SORT_MODE_NUMERIC);
+}
+
+static void
+sort_by_column_locale_activate_cb (GSimpleAction *action,
+				   GVariant      *parameter,
+				   gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_tab_sort_by_column (get_tab (window),
+				 get_current_column_num (window),
+				 GCSV_SORT_MODE_COLLATE);
+}
+
+static void
+next_ragged_row_activate_cb (GSimpleAction *action,
+			     GVariant      *parameter,
+			     gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_tab_goto_ragged_row (get_tab (window), FALSE);
+}
+
+static void
+previous_ragged_row_activate_cb (GSimpleAction *action,
+				 GVariant      *parameter,
+				 gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	gcsv_tab_goto_ragged_row (get_tab (window), TRUE);
 }
 
 static void
@@ -229,6 +539,22 @@ add_actions (GcsvWindow *window)
 		{ "open", open_activate_cb },
 		{ "save", save_activate_cb },
 		{ "save-as", save_as_activate_cb },
+		{ "grid-view", NULL, NULL, "false", grid_view_change_state_cb },
+		{ "filter-bar", NULL, NULL, "false", filter_bar_change_state_cb },
+		{ "search-bar", NULL, NULL, "false", search_bar_change_state_cb },
+		{ "stats-panel", NULL, NULL, "false", stats_panel_change_state_cb },
+		{ "follow", NULL, NULL, "false", follow_change_state_cb },
+		{ "follow-auto-scroll", NULL, NULL, "true", follow_auto_scroll_change_state_cb },
+		{ "insert-column", insert_column_activate_cb },
+		{ "delete-column", delete_column_activate_cb },
+		{ "duplicate-column", duplicate_column_activate_cb },
+		{ "move-column-left", move_column_left_activate_cb },
+		{ "move-column-right", move_column_right_activate_cb },
+		{ "sort-by-column-text", sort_by_column_text_activate_cb },
+		{ "sort-by-column-numeric", sort_by_column_numeric_activate_cb },
+		{ "sort-by-column-locale", sort_by_column_locale_activate_cb },
+		{ "next-ragged-row", next_ragged_row_activate_cb },
+		{ "previous-ragged-row", previous_ragged_row_activate_cb },
 	};
 
 	amtk_action_map_add_action_entries_check_dups (G_ACTION_MAP (window),
@@ -252,6 +578,22 @@ location_notify_cb (TeplFile   *file,
 		    GcsvWindow *window)
 {
 	update_save_action_sensitivity (window);
+	update_follow_action_sensitivity (window);
+}
+
+static void
+tab_follow_enabled_notify_cb (GcsvTab    *tab,
+			      GParamSpec *pspec,
+			      GcsvWindow *window)
+{
+	GAction *action;
+
+	/* Also when the tab stops following the file by itself, after an
+	 * error.
+	 */
+	action = g_action_map_lookup_action (G_ACTION_MAP (window), "follow");
+	g_simple_action_set_state (G_SIMPLE_ACTION (action),
+				   g_variant_new_boolean (gcsv_tab_get_follow_enabled (tab)));
 }
 
 static void
@@ -262,6 +604,7 @@ update_statusbar_label (GcsvWindow *window)
 	GtkTextIter insert_iter;
 	gint line_num;
 	gint csv_column_num;
+	guint n_ragged_rows;
 	gchar *label_text;
 
 	buffer = get_buffer (window);
@@ -273,18 +616,67 @@ update_statusbar_label (GcsvWindow *window)
 
 	csv_column_num = gcsv_buffer_get_column_num (buffer, &insert_iter) + 1;
 
-	label_text = g_strdup_printf (_("Line: %d   CSV Column: %d"),
-				      line_num,
-				      csv_column_num);
+	n_ragged_rows = gcsv_ragged_rows_get_n_rows (gcsv_tab_get_ragged_rows (get_tab (window)));
+
+	if (n_ragged_rows > 0)
+	{
+		label_text = g_strdup_printf (ngettext ("Line: %d   CSV Column: %d   %u Ragged Row",
+							"Line: %d   CSV Column: %d   %u Ragged Rows",
+							n_ragged_rows),
+					      line_num,
+					      csv_column_num,
+					      n_ragged_rows);
+	}
+	else
+	{
+		label_text = g_strdup_printf (_("Line: %d   CSV Column: %d"),
+					      line_num,
+					      csv_column_num);
+	}
 
 	gtk_label_set_text (window->statusbar_label, label_text);
 	g_free (label_text);
 }
 
+static gboolean
+statusbar_tick_cb (GtkWidget     *widget,
+		   GdkFrameClock *frame_clock,
+		   gpointer       user_data)
+{
+	GcsvWindow *window = GCSV_WINDOW (user_data);
+
+	window->statusbar_tick_id = 0;
+	update_statusbar_label (window);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* The cursor can move many times per frame, for example when an arrow key is
+ * held down, so coalesce the label updates.
+ */
+static void
+queue_update_statusbar_label (GcsvWindow *window)
+{
+	if (window->statusbar_tick_id == 0)
+	{
+		window->statusbar_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (window->statusbar_label),
+									  statusbar_tick_cb,
+									  window,
+									  NULL);
+	}
+}
+
 static void
 cursor_moved (GcsvWindow *window)
 {
-	update_statusbar_label (window);
+	queue_update_statusbar_label (window);
+}
+
+static void
+ragged_rows_changed_cb (GcsvRaggedRows *ragged_rows,
+			GcsvWindow     *window)
+{
+	queue_update_statusbar_label (window);
 }
 
 static void
@@ -292,7 +684,8 @@ buffer_notify_delimiter_cb (GcsvBuffer *buffer,
 			    GParamSpec *pspec,
 			    GcsvWindow *window)
 {
-	update_statusbar_label (window);
+	queue_update_statusbar_label (window);
+	update_column_actions_sensitivity (window);
 }
 
 static void
@@ -319,12 +712,92 @@ gcsv_window_delete_event (GtkWidget   *widget,
 	return GDK_EVENT_STOP;
 }
 
+/* Minimized or hidden windows don't need their alignment done quickly, the
+ * focused window goes first. See GcsvAlignmentScheduler.
+ */
+static void
+update_alignment_priority (GcsvWindow *window)
+{
+	GcsvTab *tab;
+	GdkWindow *gdk_window;
+	GcsvAlignmentPriority priority;
+
+	tab = get_tab (window);
+	if (tab == NULL)
+	{
+		return;
+	}
+
+	gdk_window = gtk_widget_get_window (GTK_WIDGET (window));
+
+	if (!gtk_widget_get_mapped (GTK_WIDGET (window)) ||
+	    (gdk_window != NULL &&
+	     (gdk_window_get_state (gdk_window) & GDK_WINDOW_STATE_ICONIFIED) != 0))
+	{
+		priority = GCSV_ALIGNMENT_PRIORITY_BACKGROUND;
+	}
+	else if (gtk_window_is_active (GTK_WINDOW (window)))
+	{
+		priority = GCSV_ALIGNMENT_PRIORITY_FOCUSED;
+	}
+	else
+	{
+		priority = GCSV_ALIGNMENT_PRIORITY_VISIBLE;
+	}
+
+	gcsv_tab_set_alignment_priority (tab, priority);
+}
+
+static void
+gcsv_window_map (GtkWidget *widget)
+{
+	GTK_WIDGET_CLASS (gcsv_window_parent_class)->map (widget);
+
+	update_alignment_priority (GCSV_WINDOW (widget));
+}
+
+static void
+gcsv_window_unmap (GtkWidget *widget)
+{
+	GTK_WIDGET_CLASS (gcsv_window_parent_class)->unmap (widget);
+
+	update_alignment_priority (GCSV_WINDOW (widget));
+}
+
+static gboolean
+gcsv_window_window_state_event (GtkWidget           *widget,
+				GdkEventWindowState *event)
+{
+	if ((event->changed_mask & GDK_WINDOW_STATE_ICONIFIED) != 0)
+	{
+		update_alignment_priority (GCSV_WINDOW (widget));
+	}
+
+	if (GTK_WIDGET_CLASS (gcsv_window_parent_class)->window_state_event != NULL)
+	{
+		return GTK_WIDGET_CLASS (gcsv_window_parent_class)->window_state_event (widget, event);
+	}
+
+	return GDK_EVENT_PROPAGATE;
+}
+
+static void
+is_active_notify_cb (GcsvWindow *window,
+		     GParamSpec *pspec,
+		     gpointer    user_data)
+{
+	update_alignment_priority (window);
+}
+
 static void
 gcsv_window_class_init (GcsvWindowClass *klass)
 {
 	GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
 	widget_class->delete_event = gcsv_window_delete_event;
+	widget_class->map = gcsv_window_map;
+	widget_class->unmap = gcsv_window_unmap;
+	widget_class->window_state_event = gcsv_window_window_state_event;
 }
 
 static GtkWidget *
@@ -357,12 +830,47 @@ create_edit_submenu (void)
 {
 	GtkMenuShell *edit_submenu;
 
+	AmtkFactory *factory;
+
 	edit_submenu = GTK_MENU_SHELL (gtk_menu_new ());
 	tepl_menu_shell_append_edit_actions (edit_submenu);
+	gtk_menu_shell_append (edit_submenu, gtk_separator_menu_item_new ());
+
+	factory = amtk_factory_new_with_default_application ();
+	gtk_menu_shell_append (edit_submenu, amtk_factory_create_menu_item (factory, "win.insert-column"));
+	gtk_menu_shell_append (edit_submenu, amtk_factory_create_menu_item (factory, "win.delete-column"));
+	gtk_menu_shell_append (edit_submenu, amtk_factory_create_menu_item (factory, "win.duplicate-column"));
+	gtk_menu_shell_append (edit_submenu, amtk_factory_create_menu_item (factory, "win.move-column-left"));
+	gtk_menu_shell_append (edit_submenu, amtk_factory_create_menu_item (factory, "win.move-column-right"));
+	gtk_menu_shell_append (edit_submenu, gtk_separator_menu_item_new ());
+	gtk_menu_shell_append (edit_submenu, amtk_factory_create_menu_item (factory, "win.sort-by-column-text"));
+	gtk_menu_shell_append (edit_submenu, amtk_factory_create_menu_item (factory, "win.sort-by-column-numeric"));
+	gtk_menu_shell_append (edit_submenu, amtk_factory_create_menu_item (factory, "win.sort-by-column-locale"));
+	g_object_unref (factory);
 
 	return GTK_WIDGET (edit_submenu);
 }
 
+static GtkWidget *
+create_view_submenu (void)
+{
+	GtkMenuShell *view_submenu;
+	AmtkFactory *factory;
+
+	view_submenu = GTK_MENU_SHELL (gtk_menu_new ());
+
+	factory = amtk_factory_new_with_default_application ();
+	gtk_menu_shell_append (view_submenu, amtk_factory_create_check_menu_item (factory, "win.grid-view"));
+	gtk_menu_shell_append (view_submenu, amtk_factory_create_check_menu_item (factory, "win.filter-bar"));
+	gtk_menu_shell_append (view_submenu, amtk_factory_create_check_menu_item (factory, "win.stats-panel"));
+	gtk_menu_shell_append (view_submenu, gtk_separator_menu_item_new ());
+	gtk_menu_shell_append (view_submenu, amtk_factory_create_check_menu_item (factory, "win.follow"));
+	gtk_menu_shell_append (view_submenu, amtk_factory_create_check_menu_item (factory, "win.follow-auto-scroll"));
+	g_object_unref (factory);
+
+	return GTK_WIDGET (view_submenu);
+}
+
 static GtkWidget *
 create_search_submenu (void)
 {
@@ -372,7 +880,11 @@ create_search_submenu (void)
 	search_submenu = GTK_MENU_SHELL (gtk_menu_new ());
 
 	factory = amtk_factory_new_with_default_application ();
+	gtk_menu_shell_append (search_submenu, amtk_factory_create_check_menu_item (factory, "win.search-bar"));
 	gtk_menu_shell_append (search_submenu, amtk_factory_create_menu_item (factory, "win.tepl-goto-line"));
+	gtk_menu_shell_append (search_submenu, gtk_separator_menu_item_new ());
+	gtk_menu_shell_append (search_submenu, amtk_factory_create_menu_item (factory, "win.next-ragged-row"));
+	gtk_menu_shell_append (search_submenu, amtk_factory_create_menu_item (factory, "win.previous-ragged-row"));
 	g_object_unref (factory);
 
 	return GTK_WIDGET (search_submenu);
@@ -398,6 +910,7 @@ create_menu_bar (GcsvWindow *window)
 {
 	GtkWidget *file_menu_item;
 	GtkWidget *edit_menu_item;
+	GtkWidget *view_menu_item;
 	GtkWidget *search_menu_item;
 	GtkWidget *help_menu_item;
 	GtkMenuBar *menu_bar;
@@ -412,6 +925,10 @@ create_menu_bar (GcsvWindow *window)
 	gtk_menu_item_set_submenu (GTK_MENU_ITEM (edit_menu_item),
 				   create_edit_submenu ());
 
+	view_menu_item = gtk_menu_item_new_with_mnemonic (_("_View"));
+	gtk_menu_item_set_submenu (GTK_MENU_ITEM (view_menu_item),
+				   create_view_submenu ());
+
 	search_menu_item = gtk_menu_item_new_with_mnemonic (_("_Search"));
 	gtk_menu_item_set_submenu (GTK_MENU_ITEM (search_menu_item),
 				   create_search_submenu ());
@@ -423,6 +940,7 @@ create_menu_bar (GcsvWindow *window)
 	menu_bar = GTK_MENU_BAR (gtk_menu_bar_new ());
 	gtk_menu_shell_append (GTK_MENU_SHELL (menu_bar), file_menu_item);
 	gtk_menu_shell_append (GTK_MENU_SHELL (menu_bar), edit_menu_item);
+	gtk_menu_shell_append (GTK_MENU_SHELL (menu_bar), view_menu_item);
 	gtk_menu_shell_append (GTK_MENU_SHELL (menu_bar), search_menu_item);
 	gtk_menu_shell_append (GTK_MENU_SHELL (menu_bar), help_menu_item);
 
@@ -536,12 +1054,35 @@ gcsv_window_init (GcsvWindow *window)
 				 window,
 				 0);
 
+	g_signal_connect_object (gcsv_tab_get_ragged_rows (tab),
+				 "changed",
+				 G_CALLBACK (ragged_rows_changed_cb),
+				 window,
+				 0);
+
+	g_signal_connect_object (tab,
+				 "notify::follow-enabled",
+				 G_CALLBACK (tab_follow_enabled_notify_cb),
+				 window,
+				 0);
+
+	g_signal_connect_object (tab,
+				 "notify::can-follow",
+				 G_CALLBACK (update_follow_action_sensitivity),
+				 window,
+				 G_CONNECT_SWAPPED);
+
 	g_signal_connect_object (get_file (window),
 				 "notify::location",
 				 G_CALLBACK (location_notify_cb),
 				 window,
 				 0);
 
+	g_signal_connect (window,
+			  "notify::is-active",
+			  G_CALLBACK (is_active_notify_cb),
+			  NULL);
+
 	gtk_widget_show_all (vgrid);
 }
 
@@ -565,6 +1106,29 @@ gcsv_window_load_file (GcsvWindow *window,
 	gcsv_tab_load_file (get_tab (window), location);
 }
 
+void
+gcsv_window_load_file_read_only (GcsvWindow *window,
+				 GFile      *location)
+{
+	g_return_if_fail (GCSV_IS_WINDOW (window));
+	g_return_if_fail (G_IS_FILE (location));
+
+	gcsv_tab_load_file_read_only (get_tab (window), location);
+	update_actions_sensitivity (window);
+}
+
+static void
+save_metadata (GcsvWindow *window)
+{
+	/* In read-only mode the buffer is empty, the column titles line would
+	 * not be correct.
+	 */
+	if (!gcsv_tab_is_read_only (get_tab (window)))
+	{
+		gcsv_buffer_save_metadata (get_buffer (window));
+	}
+}
+
 static void
 launch_close_confirmation_dialog (GTask *task)
 {
@@ -594,7 +1158,7 @@ launch_close_confirmation_dialog (GTask *task)
 
 	if (response_id == GTK_RESPONSE_CLOSE)
 	{
-		gcsv_buffer_save_metadata (get_buffer (window));
+		save_metadata (window);
 
 		g_task_return_boolean (task, TRUE);
 		g_object_unref (task);
@@ -624,7 +1188,7 @@ gcsv_window_close_async (GcsvWindow          *window,
 		return;
 	}
 
-	gcsv_buffer_save_metadata (buffer);
+	save_metadata (window);
 
 	g_task_return_boolean (task, TRUE);
 	g_object_unref (task);
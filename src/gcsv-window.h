@@ -32,17 +32,23 @@ G_DECLARE_FINAL_TYPE (GcsvWindow, gcsv_window,
 		      GCSV, WINDOW,
 		      GtkApplicationWindow)
 
-GcsvWindow *	gcsv_window_new			(GtkApplication *app);
+/* The hint to pass to g_application_open() to open files in read-only mode. */
+#define GCSV_OPEN_HINT_READ_ONLY "read-only"
 
-void		gcsv_window_load_file		(GcsvWindow *window,
-						 GFile      *location);
+GcsvWindow *	gcsv_window_new				(GtkApplication *app);
 
-void		gcsv_window_close_async		(GcsvWindow          *window,
-						 GAsyncReadyCallback  callback,
-						 gpointer             user_data);
+void		gcsv_window_load_file			(GcsvWindow *window,
+							 GFile      *location);
 
-gboolean	gcsv_window_close_finish	(GcsvWindow   *window,
-						 GAsyncResult *result);
+void		gcsv_window_load_file_read_only		(GcsvWindow *window,
+							 GFile      *location);
+
+void		gcsv_window_close_async			(GcsvWindow          *window,
+							 GAsyncReadyCallback  callback,
+							 gpointer             user_data);
+
+gboolean	gcsv_window_close_finish		(GcsvWindow   *window,
+							 GAsyncResult *result);
 
 G_END_DECLS
 
@@ -0,0 +1,201 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include "gcsv-alignment.h"
+#include "gcsv-buffer.h"
+#include "gcsv-undo-manager.h"
+
+/* Measures the column operations on an aligned GcsvBuffer, the time includes
+ * the re-alignment. Then the undo history: its memory usage, and the time to
+ * undo and redo.
+ * Usage: benchmark-column-ops [N_ROWS]
+ */
+
+#define DEFAULT_N_ROWS 200000
+
+/* Number of single-character edits to measure the undo history. */
+#define N_EDITS 1000
+
+static void
+flush_queue (void)
+{
+	while (gtk_events_pending ())
+	{
+		gtk_main_iteration ();
+	}
+}
+
+static gchar *
+generate_content (guint n_rows)
+{
+	GString *content;
+	GRand *rand;
+	guint row_num;
+
+	content = g_string_new (NULL);
+	rand = g_rand_new_with_seed (42);
+
+	for (row_num = 0; row_num < n_rows; row_num++)
+	{
+		guint column_num;
+
+		for (column_num = 0; column_num < 6; column_num++)
+		{
+			guint field_length = g_rand_int_range (rand, 1, 12);
+			guint i;
+
+			if (column_num > 0)
+			{
+				g_string_append_c (content, ',');
+			}
+
+			for (i = 0; i < field_length; i++)
+			{
+				g_string_append_c (content, 'a' + g_rand_int_range (rand, 0, 26));
+			}
+		}
+
+		g_string_append_c (content, '\n');
+	}
+
+	g_rand_free (rand);
+
+	return g_string_free (content, FALSE);
+}
+
+static void
+report (const gchar *name,
+	guint        n_rows,
+	GTimer      *timer)
+{
+	gdouble seconds = g_timer_elapsed (timer, NULL);
+
+	g_print ("%-24s %.3f s, %.0f rows/s\n", name, seconds, n_rows / seconds);
+}
+
+/* Each edit on a different line, so they are not merged. */
+static void
+do_edits (GcsvBuffer *buffer,
+	  guint       n_rows)
+{
+	guint i;
+
+	for (i = 0; i < N_EDITS; i++)
+	{
+		GtkTextIter iter;
+
+		gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, (i * 97) % n_rows);
+
+		gtk_text_buffer_begin_user_action (GTK_TEXT_BUFFER (buffer));
+		gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, "x", -1);
+		gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (buffer));
+	}
+
+	flush_queue ();
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	guint n_rows = DEFAULT_N_ROWS;
+	GcsvBuffer *buffer;
+	GcsvAlignment *align;
+	GcsvUndoManager *undo_manager;
+	guint64 history_size;
+	gchar *content;
+	GTimer *timer;
+	guint i;
+
+	gtk_init (&argc, &argv);
+
+	if (argc > 1)
+	{
+		n_rows = MAX (strtol (argv[1], NULL, 10), 1);
+	}
+
+	content = generate_content (n_rows);
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), content, -1);
+	g_free (content);
+
+	timer = g_timer_new ();
+	align = gcsv_alignment_new (buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+	report ("initial alignment:", n_rows, timer);
+
+	g_timer_start (timer);
+	gcsv_buffer_delete_column (buffer, 2);
+	flush_queue ();
+	report ("delete column:", n_rows, timer);
+
+	g_timer_start (timer);
+	gcsv_buffer_insert_column (buffer, 0);
+	flush_queue ();
+	report ("insert column:", n_rows, timer);
+
+	g_timer_start (timer);
+	gcsv_buffer_move_column (buffer, 1, 4);
+	flush_queue ();
+	report ("move column:", n_rows, timer);
+
+	g_timer_start (timer);
+	gcsv_buffer_duplicate_column (buffer, 3);
+	flush_queue ();
+	report ("duplicate column:", n_rows, timer);
+
+	undo_manager = GCSV_UNDO_MANAGER (gtk_source_buffer_get_undo_manager (GTK_SOURCE_BUFFER (buffer)));
+	history_size = gcsv_undo_manager_get_size (undo_manager);
+
+	g_timer_start (timer);
+	do_edits (buffer, n_rows);
+	g_print ("%-24s %.1f us/edit, %.0f bytes/edit in the undo history\n",
+		 "edits:",
+		 g_timer_elapsed (timer, NULL) * 1e6 / N_EDITS,
+		 (gdouble) (gcsv_undo_manager_get_size (undo_manager) - history_size) / N_EDITS);
+
+	g_timer_start (timer);
+	for (i = 0; i < N_EDITS; i++)
+	{
+		gtk_source_buffer_undo (GTK_SOURCE_BUFFER (buffer));
+	}
+	flush_queue ();
+	g_print ("%-24s %.1f us/undo\n",
+		 "undo edits:",
+		 g_timer_elapsed (timer, NULL) * 1e6 / N_EDITS);
+
+	g_timer_start (timer);
+	gtk_source_buffer_undo (GTK_SOURCE_BUFFER (buffer));
+	flush_queue ();
+	report ("undo duplicate column:", n_rows, timer);
+
+	g_timer_start (timer);
+	gtk_source_buffer_redo (GTK_SOURCE_BUFFER (buffer));
+	flush_queue ();
+	report ("redo duplicate column:", n_rows, timer);
+
+	g_timer_destroy (timer);
+	g_object_unref (align);
+	g_object_unref (buffer);
+	return 0;
+}
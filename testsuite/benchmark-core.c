@@ -0,0 +1,281 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include "gcsv-column-stats.h"
+#include "gcsv-column-widths.h"
+#include "gcsv-row-index.h"
+#include "gcsv-sort.h"
+#include "gcsv-tokenizer.h"
+
+/* Measures the throughput of the core functions on generated CSV content.
+ * Usage: benchmark-core [SIZE_IN_MB]
+ */
+
+#define DEFAULT_SIZE_MB 256
+
+static GBytes *
+generate_content (gsize size)
+{
+	GString *content;
+	GRand *rand;
+
+	content = g_string_sized_new (size + 1024);
+	rand = g_rand_new_with_seed (42);
+
+	while (content->len < size)
+	{
+		guint column_num;
+
+		for (column_num = 0; column_num < 8; column_num++)
+		{
+			guint field_length = g_rand_int_range (rand, 0, 16);
+			guint i;
+
+			if (column_num > 0)
+			{
+				g_string_append_c (content, ',');
+			}
+
+			for (i = 0; i < field_length; i++)
+			{
+				g_string_append_c (content, 'a' + g_rand_int_range (rand, 0, 26));
+			}
+		}
+
+		g_string_append_c (content, '\n');
+	}
+
+	g_rand_free (rand);
+
+	return g_string_free_to_bytes (content);
+}
+
+static void
+report (const gchar *name,
+	gsize        size,
+	GTimer      *timer)
+{
+	gdouble seconds = g_timer_elapsed (timer, NULL);
+
+	g_print ("%-24s %.3f s, %.3f GB/s\n", name, seconds, size / 1e9 / seconds);
+}
+
+static void
+benchmark_column_widths (GBytes *bytes)
+{
+	GcsvTokenizer tokenizer;
+	GcsvColumnWidths *widths;
+	const gchar *data;
+	const gchar *end;
+	const gchar *line_start;
+	gsize size;
+	GTimer *timer;
+
+	data = g_bytes_get_data (bytes, &size);
+	end = data + size;
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	widths = gcsv_column_widths_new ();
+	timer = g_timer_new ();
+
+	line_start = data;
+	while (line_start < end)
+	{
+		const gchar *line_end;
+		const gchar *next_line_start;
+
+		line_end = gcsv_tokenizer_find_line_end (line_start, end, &next_line_start);
+		gcsv_column_widths_add_line (widths, &tokenizer, line_start, line_end);
+		line_start = next_line_start;
+	}
+
+	g_timer_stop (timer);
+	report ("column widths:", size, timer);
+
+	g_timer_destroy (timer);
+	gcsv_column_widths_free (widths);
+}
+
+static void
+benchmark_count_columns (GBytes *bytes)
+{
+	GcsvTokenizer tokenizer;
+	const gchar *data;
+	const gchar *end;
+	const gchar *line_start;
+	gsize size;
+	guint64 n_columns = 0;
+	GTimer *timer;
+
+	data = g_bytes_get_data (bytes, &size);
+	end = data + size;
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	timer = g_timer_new ();
+
+	line_start = data;
+	while (line_start < end)
+	{
+		const gchar *line_end;
+		const gchar *next_line_start;
+
+		line_end = gcsv_tokenizer_find_line_end (line_start, end, &next_line_start);
+		n_columns += gcsv_tokenizer_count_columns (&tokenizer, line_start, line_end);
+		line_start = next_line_start;
+	}
+
+	g_timer_stop (timer);
+	report ("count columns:", size, timer);
+
+	/* Use the result, so that the loop is not optimized away. */
+	g_assert_cmpuint (n_columns, >, 0);
+
+	g_timer_destroy (timer);
+}
+
+static void
+benchmark_row_index (GBytes *bytes)
+{
+	GcsvRowIndex *index;
+	GTimer *timer;
+
+	index = gcsv_row_index_new (bytes, ',');
+	timer = g_timer_new ();
+
+	gcsv_row_index_build (index, NULL);
+
+	g_timer_stop (timer);
+	report ("row index build:", g_bytes_get_size (bytes), timer);
+
+	g_timer_destroy (timer);
+	gcsv_row_index_unref (index);
+}
+
+static void
+benchmark_remap_columns (GBytes *bytes)
+{
+	GcsvTokenizer tokenizer;
+	const gchar *data;
+	gsize size;
+	GArray *column_map;
+	GString *output;
+	GTimer *timer;
+	gint column_num;
+
+	data = g_bytes_get_data (bytes, &size);
+
+	/* Deletes the column 3. */
+	column_map = g_array_new (FALSE, FALSE, sizeof (gint));
+	for (column_num = 0; column_num < 8; column_num++)
+	{
+		if (column_num != 3)
+		{
+			g_array_append_val (column_map, column_num);
+		}
+	}
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	output = g_string_sized_new (size);
+	timer = g_timer_new ();
+
+	gcsv_tokenizer_remap_columns (&tokenizer, data, data + size, column_map, output);
+
+	g_timer_stop (timer);
+	report ("remap columns:", size, timer);
+
+	g_timer_destroy (timer);
+	g_string_free (output, TRUE);
+	g_array_unref (column_map);
+}
+
+static void
+benchmark_sort_lines (GBytes *bytes)
+{
+	GcsvTokenizer tokenizer;
+	const gchar *data;
+	gsize size;
+	GString *output;
+	GTimer *timer;
+
+	data = g_bytes_get_data (bytes, &size);
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	output = g_string_sized_new (size);
+	timer = g_timer_new ();
+
+	gcsv_sort_lines (&tokenizer, data, size, 2, GCSV_SORT_MODE_LEXICOGRAPHIC, output, NULL);
+
+	g_timer_stop (timer);
+	report ("sort lines:", size, timer);
+
+	g_timer_destroy (timer);
+	g_string_free (output, TRUE);
+}
+
+static void
+benchmark_column_stats (GBytes *bytes)
+{
+	GcsvTokenizer tokenizer;
+	GcsvColumnStats *stats;
+	const gchar *data;
+	gsize size;
+	GTimer *timer;
+
+	data = g_bytes_get_data (bytes, &size);
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	stats = gcsv_column_stats_new ();
+	timer = g_timer_new ();
+
+	gcsv_column_stats_add_lines (stats, &tokenizer, 2, data, data + size);
+
+	g_timer_stop (timer);
+	report ("column stats:", size, timer);
+
+	g_assert_cmpuint (gcsv_column_stats_get_count (stats), >, 0);
+
+	g_timer_destroy (timer);
+	gcsv_column_stats_free (stats);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gsize size_mb = DEFAULT_SIZE_MB;
+	GBytes *bytes;
+
+	if (argc > 1)
+	{
+		size_mb = MAX (strtol (argv[1], NULL, 10), 1);
+	}
+
+	bytes = generate_content (size_mb * 1024 * 1024);
+
+	benchmark_count_columns (bytes);
+	benchmark_column_widths (bytes);
+	benchmark_row_index (bytes);
+	benchmark_remap_columns (bytes);
+	benchmark_sort_lines (bytes);
+	benchmark_column_stats (bytes);
+
+	g_bytes_unref (bytes);
+	return 0;
+}
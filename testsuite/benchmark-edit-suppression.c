@@ -0,0 +1,165 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include "gcsv-buffer.h"
+#include "gcsv-utils.h"
+
+/* Compares two ways to hide the alignment edits (a chunk of virtual spaces
+ * insertions and deletions) from the GtkTextBuffer::modified-changed handlers:
+ * blocking all the handlers one by one, as GcsvAlignment used to do for each
+ * chunk, and gcsv_buffer_begin_virtual_spaces_edit(), which stops the signal
+ * emission in the buffer's own first handler.
+ * Usage: benchmark-edit-suppression [N_CHUNKS]
+ */
+
+#define DEFAULT_N_CHUNKS 100000
+
+static guint n_handler_calls;
+
+static void
+modified_changed_cb (GtkTextBuffer *buffer,
+		     gpointer       user_data)
+{
+	n_handler_calls++;
+}
+
+/* Like a small alignment chunk: the modified flag changes and is restored. */
+static void
+edit_chunk (GcsvBuffer *buffer)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+	gboolean modified;
+
+	modified = gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer));
+
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (buffer), &start);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &start, " ", 1);
+
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (buffer), &start);
+	end = start;
+	gtk_text_iter_forward_char (&end);
+	gtk_text_buffer_delete (GTK_TEXT_BUFFER (buffer), &start, &end);
+
+	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), modified);
+}
+
+static gdouble
+run_block_all_handlers (GcsvBuffer *buffer,
+			guint       n_chunks)
+{
+	GTimer *timer;
+	gdouble seconds;
+	guint i;
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < n_chunks; i++)
+	{
+		gulong *handler_ids;
+
+		handler_ids = gcsv_utils_block_all_signal_handlers (G_OBJECT (buffer), "modified-changed");
+		gcsv_buffer_begin_virtual_spaces_edit (buffer);
+		edit_chunk (buffer);
+		gcsv_buffer_end_virtual_spaces_edit (buffer);
+		gcsv_utils_unblock_signal_handlers (G_OBJECT (buffer), handler_ids);
+		g_free (handler_ids);
+	}
+
+	seconds = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	return seconds;
+}
+
+static gdouble
+run_virtual_spaces_edit (GcsvBuffer *buffer,
+			 guint       n_chunks)
+{
+	GTimer *timer;
+	gdouble seconds;
+	guint i;
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < n_chunks; i++)
+	{
+		gcsv_buffer_begin_virtual_spaces_edit (buffer);
+		edit_chunk (buffer);
+		gcsv_buffer_end_virtual_spaces_edit (buffer);
+	}
+
+	seconds = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	return seconds;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	const guint n_handlers_values[] = { 1, 10, 100 };
+	guint n_chunks = DEFAULT_N_CHUNKS;
+	guint i;
+
+	gtk_init (&argc, &argv);
+
+	if (argc > 1)
+	{
+		n_chunks = MAX (strtol (argv[1], NULL, 10), 1);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (n_handlers_values); i++)
+	{
+		GcsvBuffer *buffer;
+		guint n_handlers = n_handlers_values[i];
+		gdouble block_all_seconds;
+		gdouble virtual_spaces_edit_seconds;
+		guint j;
+
+		buffer = gcsv_buffer_new ();
+		gcsv_buffer_set_delimiter (buffer, ',');
+		gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "a,b\n1,2\n", -1);
+		gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), FALSE);
+
+		for (j = 0; j < n_handlers; j++)
+		{
+			g_signal_connect (buffer,
+					  "modified-changed",
+					  G_CALLBACK (modified_changed_cb),
+					  NULL);
+		}
+
+		n_handler_calls = 0;
+		block_all_seconds = run_block_all_handlers (buffer, n_chunks);
+		virtual_spaces_edit_seconds = run_virtual_spaces_edit (buffer, n_chunks);
+		g_assert_cmpuint (n_handler_calls, ==, 0);
+
+		g_print ("%3u handlers: block all %.2f us/chunk, virtual spaces edit %.2f us/chunk\n",
+			 n_handlers,
+			 block_all_seconds * 1e6 / n_chunks,
+			 virtual_spaces_edit_seconds * 1e6 / n_chunks);
+
+		g_object_unref (buffer);
+	}
+
+	return 0;
+}
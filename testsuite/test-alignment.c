@@ -285,6 +285,551 @@ test_header (void)
 	g_object_unref (align);
 }
 
+static void
+test_column_ops (void)
+{
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvAlignment *align;
+	gchar *buffer_text;
+
+	csv_buffer = gcsv_buffer_new ();
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (buffer, "aaa,bb,c\n1,2,3", -1);
+
+	align = gcsv_alignment_new (csv_buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "aaa,bb,c\n1  ,2 ,3");
+	g_free (buffer_text);
+
+	/* The column lengths follow the columns. */
+	g_assert_true (gcsv_buffer_move_column (csv_buffer, 0, 1));
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "bb,aaa,c\n2 ,1  ,3");
+	g_free (buffer_text);
+
+	g_assert_true (gcsv_buffer_delete_column (csv_buffer, 1));
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "bb,c\n2 ,3");
+	g_free (buffer_text);
+
+	g_object_unref (align);
+	g_object_unref (csv_buffer);
+}
+
+static void
+replace_finished_cb (GObject      *source_object,
+		     GAsyncResult *result,
+		     gpointer      user_data)
+{
+	GMainLoop *main_loop = user_data;
+	GError *error = NULL;
+
+	gcsv_buffer_replace_in_columns_finish (GCSV_BUFFER (source_object), result, NULL, &error);
+	g_assert_no_error (error);
+
+	g_main_loop_quit (main_loop);
+}
+
+static void
+test_replace_in_columns (void)
+{
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvAlignment *align;
+	GMainLoop *main_loop;
+	gchar *buffer_text;
+
+	csv_buffer = gcsv_buffer_new ();
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (buffer, "name,v\nxxxxxx,1\ny,2", -1);
+
+	align = gcsv_alignment_new (csv_buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "name  ,v\nxxxxxx,1\ny     ,2");
+	g_free (buffer_text);
+
+	/* The column lengths are recomputed from the new fields, so the
+	 * column can shrink.
+	 */
+	main_loop = g_main_loop_new (NULL, FALSE);
+	gcsv_buffer_replace_in_columns_async (csv_buffer, NULL, "xxxxxx", "x", TRUE,
+					      NULL, replace_finished_cb, main_loop);
+	g_main_loop_run (main_loop);
+	g_main_loop_unref (main_loop);
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "name,v\nx   ,1\ny   ,2");
+	g_free (buffer_text);
+
+	g_object_unref (align);
+	g_object_unref (csv_buffer);
+}
+
+static GcsvBuffer *
+create_buffer_with_lines (guint n_lines)
+{
+	GcsvBuffer *csv_buffer;
+	GString *text;
+	guint i;
+
+	text = g_string_new ("aaa,b\n");
+	for (i = 1; i < n_lines; i++)
+	{
+		g_string_append (text, "1,2\n");
+	}
+
+	csv_buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (csv_buffer), text->str, -1);
+
+	g_string_free (text, TRUE);
+	return csv_buffer;
+}
+
+static gchar *
+get_line_text (GtkTextBuffer *buffer,
+	       gint           line)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_iter_at_line (buffer, &start, line);
+	end = start;
+	gtk_text_iter_forward_to_line_end (&end);
+
+	return gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+}
+
+static void
+test_scheduler_priority (void)
+{
+	GcsvBuffer *focused_buffer;
+	GcsvBuffer *other_buffer;
+	GcsvAlignment *focused_align;
+	GcsvAlignment *other_align;
+	guint other_queue_depth;
+
+	focused_buffer = create_buffer_with_lines (500);
+	other_buffer = create_buffer_with_lines (500);
+
+	other_align = gcsv_alignment_new (other_buffer);
+	gcsv_alignment_set_unit_test_mode (other_align, TRUE);
+
+	focused_align = gcsv_alignment_new (focused_buffer);
+	gcsv_alignment_set_unit_test_mode (focused_align, TRUE);
+	gcsv_alignment_set_priority (focused_align, GCSV_ALIGNMENT_PRIORITY_FOCUSED);
+
+	other_queue_depth = gcsv_alignment_get_queue_depth (other_align);
+	g_assert_cmpuint (other_queue_depth, >, 0);
+	g_assert_cmpuint (gcsv_alignment_get_queue_depth (focused_align), >, 0);
+
+	/* The focused alignment is finished first. */
+	while (gcsv_alignment_get_queue_depth (focused_align) > 0)
+	{
+		g_assert_cmpuint (gcsv_alignment_get_queue_depth (other_align), ==, other_queue_depth);
+		gtk_main_iteration ();
+	}
+
+	flush_queue ();
+	g_assert_cmpuint (gcsv_alignment_get_queue_depth (other_align), ==, 0);
+
+	g_object_unref (focused_align);
+	g_object_unref (other_align);
+	g_object_unref (focused_buffer);
+	g_object_unref (other_buffer);
+}
+
+static void
+test_scheduler_viewport (void)
+{
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvAlignment *align;
+	gchar *line_text;
+
+	csv_buffer = create_buffer_with_lines (500);
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+
+	align = gcsv_alignment_new (csv_buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	gcsv_alignment_set_viewport (align, 400, 420);
+
+	/* The viewport is aligned before the lines above it. */
+	while (TRUE)
+	{
+		line_text = get_line_text (buffer, 410);
+		if (g_str_equal (line_text, "1  ,2"))
+		{
+			break;
+		}
+
+		g_free (line_text);
+		g_assert_true (gcsv_alignment_process_next_chunk (align));
+	}
+	g_free (line_text);
+
+	line_text = get_line_text (buffer, 1);
+	g_assert_cmpstr (line_text, ==, "1,2");
+	g_free (line_text);
+
+	flush_queue ();
+
+	line_text = get_line_text (buffer, 1);
+	g_assert_cmpstr (line_text, ==, "1  ,2");
+	g_free (line_text);
+
+	g_object_unref (align);
+	g_object_unref (csv_buffer);
+}
+
+static void
+test_last_visible_column (void)
+{
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvAlignment *align;
+	GString *expected;
+	gchar *line_text;
+	guint i;
+
+	/* 16 columns, with a width of 2. */
+	csv_buffer = gcsv_buffer_new ();
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (buffer,
+				  "aa,aa,aa,aa,aa,aa,aa,aa,aa,aa,aa,aa,aa,aa,aa,aa\n"
+				  "b,b,b,b,b,b,b,b,b,b,b,b,b,b,b,b\n",
+				  -1);
+
+	align = gcsv_alignment_new (csv_buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+
+	/* The columns 0 to 2, plus a margin of 10 columns, are aligned. */
+	gcsv_alignment_set_last_visible_column (align, 2);
+	flush_queue ();
+
+	expected = g_string_new (NULL);
+	for (i = 0; i < 13; i++)
+	{
+		g_string_append (expected, "b ,");
+	}
+	g_string_append (expected, "b,b,b");
+
+	line_text = get_line_text (buffer, 1);
+	g_assert_cmpstr (line_text, ==, expected->str);
+	g_free (line_text);
+
+	/* Scrolling by a few columns doesn't change the alignment. */
+	gcsv_alignment_set_last_visible_column (align, 5);
+	flush_queue ();
+
+	line_text = get_line_text (buffer, 1);
+	g_assert_cmpstr (line_text, ==, expected->str);
+	g_free (line_text);
+
+	/* All the columns. */
+	gcsv_alignment_set_last_visible_column (align, -1);
+	flush_queue ();
+
+	g_string_truncate (expected, 0);
+	for (i = 0; i < 15; i++)
+	{
+		g_string_append (expected, "b ,");
+	}
+	g_string_append (expected, "b");
+
+	line_text = get_line_text (buffer, 1);
+	g_assert_cmpstr (line_text, ==, expected->str);
+	g_free (line_text);
+
+	/* The columns after the margin are compact again. */
+	gcsv_alignment_set_last_visible_column (align, 0);
+	flush_queue ();
+
+	g_string_truncate (expected, 0);
+	for (i = 0; i < 11; i++)
+	{
+		g_string_append (expected, "b ,");
+	}
+	g_string_append (expected, "b,b,b,b,b");
+
+	line_text = get_line_text (buffer, 1);
+	g_assert_cmpstr (line_text, ==, expected->str);
+	g_free (line_text);
+
+	g_string_free (expected, TRUE);
+	g_object_unref (align);
+	g_object_unref (csv_buffer);
+}
+
+static gboolean
+is_line_wrapped (GtkTextBuffer *buffer,
+		 gint           line)
+{
+	GtkTextIter iter;
+	GSList *tags;
+	GSList *l;
+	gboolean wrapped = FALSE;
+
+	gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+	tags = gtk_text_iter_get_tags (&iter);
+
+	for (l = tags; l != NULL; l = l->next)
+	{
+		GtkWrapMode wrap_mode;
+
+		g_object_get (l->data, "wrap-mode", &wrap_mode, NULL);
+		if (wrap_mode != GTK_WRAP_NONE)
+		{
+			wrapped = TRUE;
+		}
+	}
+
+	g_slist_free (tags);
+	return wrapped;
+}
+
+static void
+test_max_line_length (void)
+{
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvAlignment *align;
+	GtkTextIter iter;
+	gchar *buffer_text;
+
+	csv_buffer = gcsv_buffer_new ();
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (buffer, "a,b\nlonger,x\n1,2", -1);
+
+	align = gcsv_alignment_new (csv_buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+
+	/* The second line is too long, it is ignored and wrapped. */
+	gcsv_alignment_set_max_line_length (align, 5);
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "a,b\nlonger,x\n1,2");
+	g_free (buffer_text);
+	g_assert_false (is_line_wrapped (buffer, 0));
+	g_assert_true (is_line_wrapped (buffer, 1));
+
+	/* Typing in it doesn't align it. */
+	gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 1, 1);
+	gtk_text_buffer_insert (buffer, &iter, "z", -1);
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "a,b\nlzonger,x\n1,2");
+	g_free (buffer_text);
+
+	/* No limit. */
+	gcsv_alignment_set_max_line_length (align, G_MAXUINT);
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "a      ,b\nlzonger,x\n1      ,2");
+	g_free (buffer_text);
+	g_assert_false (is_line_wrapped (buffer, 1));
+
+	/* The virtual spaces are removed when a line becomes too long. */
+	gcsv_alignment_set_max_line_length (align, 12);
+	flush_queue ();
+	gtk_text_buffer_get_iter_at_line (buffer, &iter, 2);
+	gtk_text_buffer_insert (buffer, &iter, "123456", -1);
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "a      ,b\nlzonger,x\n1234561,2");
+	g_free (buffer_text);
+	g_assert_true (is_line_wrapped (buffer, 2));
+
+	g_object_unref (align);
+	g_object_unref (csv_buffer);
+}
+
+static void
+test_delimiter_change (void)
+{
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvAlignment *align;
+	GString *content;
+	gchar *buffer_text;
+	gchar *line_text;
+	guint i;
+
+	/* More lines than what is stripped in one chunk. */
+	content = g_string_new (NULL);
+	for (i = 0; i < 2500; i++)
+	{
+		g_string_append (content, i % 2 == 0 ? "a,bb;c\n" : "ccc,d;ee\n");
+	}
+
+	csv_buffer = gcsv_buffer_new ();
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (buffer, content->str, -1);
+
+	align = gcsv_alignment_new (csv_buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	line_text = get_line_text (buffer, 2498);
+	g_assert_cmpstr (line_text, ==, "a  ,bb;c");
+	g_free (line_text);
+
+	/* Realigned with the new delimiter. */
+	gcsv_buffer_set_delimiter (csv_buffer, ';');
+	g_assert_cmpuint (gcsv_alignment_get_queue_depth (align), >, 0);
+	flush_queue ();
+
+	line_text = get_line_text (buffer, 2498);
+	g_assert_cmpstr (line_text, ==, "a,bb ;c");
+	g_free (line_text);
+
+	line_text = get_line_text (buffer, 2499);
+	g_assert_cmpstr (line_text, ==, "ccc,d;ee");
+	g_free (line_text);
+
+	/* No delimiter. */
+	gcsv_buffer_set_delimiter (csv_buffer, '\0');
+	flush_queue ();
+
+	g_assert_cmpuint (gcsv_alignment_get_queue_depth (align), ==, 0);
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, content->str);
+	g_free (buffer_text);
+
+	g_string_free (content, TRUE);
+	g_object_unref (align);
+	g_object_unref (csv_buffer);
+}
+
+static void
+modified_changed_cb (GtkTextBuffer *buffer,
+		     guint         *n_calls)
+{
+	(*n_calls)++;
+}
+
+static void
+test_before_paint (void)
+{
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvAlignment *align;
+	GtkTextIter iter;
+	gchar *buffer_text;
+	const gchar *p;
+
+	csv_buffer = gcsv_buffer_new ();
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (buffer, "aa,b\n1,2", -1);
+
+	align = gcsv_alignment_new (csv_buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	/* Several keystrokes in the same frame are aligned together. */
+	for (p = "xyz"; *p != '\0'; p++)
+	{
+		gtk_text_buffer_get_start_iter (buffer, &iter);
+		gtk_text_buffer_insert (buffer, &iter, p, 1);
+	}
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "zyxaa,b\n1 ,2");
+	g_free (buffer_text);
+	g_assert_cmpuint (gcsv_alignment_get_queue_depth (align), >, 0);
+
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "zyxaa,b\n1    ,2");
+	g_free (buffer_text);
+	g_assert_cmpuint (gcsv_alignment_get_queue_depth (align), ==, 0);
+
+	/* Same for a deletion in a field shorter than its column. */
+	gtk_text_buffer_get_iter_at_line (buffer, &iter, 1);
+	gtk_text_buffer_insert (buffer, &iter, "9", -1);
+	flush_queue ();
+
+	gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 1, 1);
+	gtk_text_buffer_backspace (buffer, &iter, FALSE, TRUE);
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "zyxaa,b\n1   ,2");
+	g_free (buffer_text);
+
+	g_assert_cmpuint (gcsv_alignment_get_queue_depth (align), >, 0);
+	flush_queue ();
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==, "zyxaa,b\n1    ,2");
+	g_free (buffer_text);
+
+	g_object_unref (align);
+	g_object_unref (csv_buffer);
+}
+
+static void
+test_modified_flag (void)
+{
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvAlignment *align;
+	GtkTextIter iter;
+	guint n_calls = 0;
+
+	csv_buffer = gcsv_buffer_new ();
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (buffer, "aaa,b\n1,2", -1);
+	gtk_text_buffer_set_modified (buffer, FALSE);
+
+	g_signal_connect (buffer,
+			  "modified-changed",
+			  G_CALLBACK (modified_changed_cb),
+			  &n_calls);
+
+	/* The alignment edits are not noticed. */
+	align = gcsv_alignment_new (csv_buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	g_assert_false (gtk_text_buffer_get_modified (buffer));
+	g_assert_cmpuint (n_calls, ==, 0);
+
+	/* The user edits are. */
+	gtk_text_buffer_get_iter_at_line (buffer, &iter, 1);
+	gtk_text_buffer_insert (buffer, &iter, "x", -1);
+	flush_queue ();
+
+	g_assert_true (gtk_text_buffer_get_modified (buffer));
+	g_assert_cmpuint (n_calls, ==, 1);
+
+	g_object_unref (align);
+	g_object_unref (csv_buffer);
+}
+
 gint
 main (gint    argc,
       gchar **argv)
@@ -295,6 +840,15 @@ main (gint    argc,
 	g_test_add_func ("/align/column_growing", test_column_growing);
 	g_test_add_func ("/align/column_shrinking", test_column_shrinking);
 	g_test_add_func ("/align/header", test_header);
+	g_test_add_func ("/align/column-ops", test_column_ops);
+	g_test_add_func ("/align/replace-in-columns", test_replace_in_columns);
+	g_test_add_func ("/align/scheduler-priority", test_scheduler_priority);
+	g_test_add_func ("/align/scheduler-viewport", test_scheduler_viewport);
+	g_test_add_func ("/align/last-visible-column", test_last_visible_column);
+	g_test_add_func ("/align/max-line-length", test_max_line_length);
+	g_test_add_func ("/align/modified-flag", test_modified_flag);
+	g_test_add_func ("/align/before-paint", test_before_paint);
+	g_test_add_func ("/align/delimiter-change", test_delimiter_change);
 
 	return g_test_run ();
 }
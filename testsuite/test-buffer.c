@@ -0,0 +1,527 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-buffer.h"
+
+static guint
+get_column_num_at (GcsvBuffer *buffer,
+		   gint        line,
+		   gint        line_offset)
+{
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &iter, line, line_offset);
+	return gcsv_buffer_get_column_num (buffer, &iter);
+}
+
+static void
+test_column_num (void)
+{
+	GcsvBuffer *buffer;
+	GtkTextIter iter;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "a,bb,\xc3\xa9\xc3\xa9,d\n,x", -1);
+
+	g_assert_cmpuint (get_column_num_at (buffer, 0, 0), ==, 0);
+	g_assert_cmpuint (get_column_num_at (buffer, 0, 1), ==, 0);
+	g_assert_cmpuint (get_column_num_at (buffer, 0, 2), ==, 1);
+	g_assert_cmpuint (get_column_num_at (buffer, 0, 5), ==, 2);
+	g_assert_cmpuint (get_column_num_at (buffer, 0, 7), ==, 2);
+	g_assert_cmpuint (get_column_num_at (buffer, 0, 9), ==, 3);
+	g_assert_cmpuint (get_column_num_at (buffer, 1, 0), ==, 0);
+	g_assert_cmpuint (get_column_num_at (buffer, 1, 2), ==, 1);
+	g_assert_cmpuint (gcsv_buffer_count_columns_at_line (buffer, 0), ==, 4);
+
+	/* The cached line must be invalidated by a text change. */
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, 0);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, ",,", -1);
+	g_assert_cmpuint (get_column_num_at (buffer, 0, 2), ==, 2);
+	g_assert_cmpuint (gcsv_buffer_count_columns_at_line (buffer, 0), ==, 6);
+
+	/* And by a delimiter change. */
+	gcsv_buffer_set_delimiter (buffer, ';');
+	g_assert_cmpuint (gcsv_buffer_count_columns_at_line (buffer, 0), ==, 1);
+
+	g_object_unref (buffer);
+}
+
+/* Compares the cached column numbers with a count of the delimiters in a copy
+ * of the line.
+ */
+static void
+check_column_nums (GcsvBuffer *buffer,
+		   gint        line)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+	gchar *line_text;
+	const gchar *p;
+	guint n_delimiters = 0;
+	gint line_offset = 0;
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &start, line);
+	end = start;
+	if (!gtk_text_iter_ends_line (&end))
+	{
+		gtk_text_iter_forward_to_line_end (&end);
+	}
+
+	line_text = gtk_text_iter_get_slice (&start, &end);
+
+	for (p = line_text; *p != '\0'; p = g_utf8_next_char (p))
+	{
+		g_assert_cmpuint (get_column_num_at (buffer, line, line_offset), ==, n_delimiters);
+
+		if (*p == ',')
+		{
+			n_delimiters++;
+		}
+
+		line_offset++;
+	}
+
+	g_assert_cmpuint (get_column_num_at (buffer, line, line_offset), ==, n_delimiters);
+	g_assert_cmpuint (gcsv_buffer_count_columns_at_line (buffer, line), ==, n_delimiters + 1);
+
+	g_free (line_text);
+}
+
+static void
+delete_at (GcsvBuffer *buffer,
+	   gint        line,
+	   gint        line_offset,
+	   gint        n_chars)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &start, line, line_offset);
+	end = start;
+	gtk_text_iter_forward_chars (&end, n_chars);
+	gtk_text_buffer_delete (GTK_TEXT_BUFFER (buffer), &start, &end);
+}
+
+static void
+insert_at (GcsvBuffer  *buffer,
+	   gint         line,
+	   gint         line_offset,
+	   const gchar *text)
+{
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &iter, line, line_offset);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, text, -1);
+}
+
+static void
+test_column_num_edits (void)
+{
+	GcsvBuffer *buffer;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "a,bb,\xc3\xa9\xc3\xa9,d\r\nx,y", -1);
+	check_column_nums (buffer, 0);
+
+	/* Edits in the cached line update the cache in place. */
+	insert_at (buffer, 0, 3, "c,\xc3\xa9,");
+	check_column_nums (buffer, 0);
+
+	delete_at (buffer, 0, 1, 5);
+	check_column_nums (buffer, 0);
+
+	insert_at (buffer, 0, 0, ",");
+	check_column_nums (buffer, 0);
+
+	delete_at (buffer, 0, 0, 1);
+	check_column_nums (buffer, 0);
+
+	/* The field bounds come from the cache too. */
+	gcsv_buffer_get_field_bounds (buffer, 0, 1, &start, &end);
+	g_assert_cmpint (gtk_text_iter_get_line_offset (&start), ==, 2);
+	g_assert_cmpint (gtk_text_iter_get_line_offset (&end), ==, 3);
+	gcsv_buffer_get_field_bounds (buffer, 0, 4, &start, &end);
+	g_assert_true (gtk_text_iter_equal (&start, &end));
+	g_assert_true (gtk_text_iter_ends_line (&start));
+
+	/* An edit in another line keeps the cache. */
+	check_column_nums (buffer, 1);
+	insert_at (buffer, 0, 0, ",");
+	check_column_nums (buffer, 1);
+
+	/* Lines added or removed. */
+	insert_at (buffer, 1, 1, "\n,");
+	check_column_nums (buffer, 1);
+	check_column_nums (buffer, 2);
+
+	delete_at (buffer, 1, 1, 1);
+	check_column_nums (buffer, 1);
+
+	/* Between "\r" and "\n", line 0 being ",a,b,\xc3\xa9\xc3\xa9,d\r\n". */
+	check_column_nums (buffer, 0);
+	insert_at (buffer, 0, 10, ",");
+	check_column_nums (buffer, 0);
+	check_column_nums (buffer, 1);
+	delete_at (buffer, 1, 0, 1);
+	check_column_nums (buffer, 0);
+	check_column_nums (buffer, 1);
+
+	g_object_unref (buffer);
+}
+
+static gchar *
+get_buffer_text (GtkTextBuffer *buffer)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_bounds (buffer, &start, &end);
+	return gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+}
+
+static void
+check_buffer_text (GcsvBuffer  *buffer,
+		   const gchar *expected)
+{
+	gchar *text;
+
+	text = get_buffer_text (GTK_TEXT_BUFFER (buffer));
+	g_assert_cmpstr (text, ==, expected);
+	g_free (text);
+}
+
+static void
+test_column_ops (void)
+{
+	GcsvBuffer *buffer;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer),
+				  "A header, kept as-is.\n"
+				  "a,b,c\n"
+				  "1,2\n",
+				  -1);
+	gcsv_buffer_set_column_titles_line (buffer, 1);
+
+	g_assert_true (gcsv_buffer_move_column (buffer, 0, 2));
+	check_buffer_text (buffer, "A header, kept as-is.\nb,c,a\n2,,1\n");
+
+	g_assert_true (gcsv_buffer_delete_column (buffer, 1));
+	check_buffer_text (buffer, "A header, kept as-is.\nb,a\n2,1\n");
+
+	g_assert_true (gcsv_buffer_insert_column (buffer, 2));
+	check_buffer_text (buffer, "A header, kept as-is.\nb,a,\n2,1,\n");
+
+	g_assert_true (gcsv_buffer_duplicate_column (buffer, 0));
+	check_buffer_text (buffer, "A header, kept as-is.\nb,b,a,\n2,2,1,\n");
+
+	/* Columns that don't exist. */
+	g_assert_false (gcsv_buffer_delete_column (buffer, 4));
+	g_assert_false (gcsv_buffer_insert_column (buffer, 5));
+	g_assert_false (gcsv_buffer_move_column (buffer, 0, 4));
+
+	g_object_unref (buffer);
+}
+
+static void
+sort_finished_cb (GObject      *source_object,
+		  GAsyncResult *result,
+		  gpointer      user_data)
+{
+	GMainLoop *main_loop = user_data;
+	GError *error = NULL;
+
+	gcsv_buffer_sort_by_column_finish (GCSV_BUFFER (source_object), result, &error);
+	g_assert_no_error (error);
+
+	g_main_loop_quit (main_loop);
+}
+
+static void
+sort_by_column (GcsvBuffer   *buffer,
+		guint         column_num,
+		GcsvSortMode  mode)
+{
+	GMainLoop *main_loop;
+
+	main_loop = g_main_loop_new (NULL, FALSE);
+	gcsv_buffer_sort_by_column_async (buffer, column_num, mode, NULL, sort_finished_cb, main_loop);
+	g_main_loop_run (main_loop);
+	g_main_loop_unref (main_loop);
+}
+
+static void
+test_set_field_text (void)
+{
+	GcsvBuffer *buffer;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "a,b\nc,d", -1);
+
+	g_assert_true (gcsv_buffer_set_field_text (buffer, 1, 0, "e f"));
+	check_buffer_text (buffer, "a,b\ne f,d");
+
+	/* The line doesn't have that column. */
+	g_assert_false (gcsv_buffer_set_field_text (buffer, 1, 2, "e"));
+	g_assert_false (gcsv_buffer_set_field_text (buffer, 2, 0, "e"));
+
+	/* The text would create other fields or lines. */
+	g_assert_false (gcsv_buffer_set_field_text (buffer, 0, 1, "e,f"));
+	g_assert_false (gcsv_buffer_set_field_text (buffer, 0, 1, "e\nf"));
+	g_assert_false (gcsv_buffer_set_field_text (buffer, 0, 1, "e\rf"));
+	check_buffer_text (buffer, "a,b\ne f,d");
+
+	g_object_unref (buffer);
+}
+
+static void
+test_sort_by_column (void)
+{
+	GcsvBuffer *buffer;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer),
+				  "A header, kept as-is.\n"
+				  "name,n\n"
+				  "b,10\n"
+				  "a,9\n"
+				  "c,9",
+				  -1);
+	gcsv_buffer_set_column_titles_line (buffer, 1);
+
+	/* The header and the column titles stay in place. */
+	sort_by_column (buffer, 1, GCSV_SORT_MODE_NUMERIC);
+	check_buffer_text (buffer, "A header, kept as-is.\nname,n\na,9\nc,9\nb,10");
+
+	sort_by_column (buffer, 1, GCSV_SORT_MODE_LEXICOGRAPHIC);
+	check_buffer_text (buffer, "A header, kept as-is.\nname,n\nb,10\na,9\nc,9");
+
+	sort_by_column (buffer, 0, GCSV_SORT_MODE_COLLATE);
+	check_buffer_text (buffer, "A header, kept as-is.\nname,n\na,9\nb,10\nc,9");
+
+	g_object_unref (buffer);
+}
+
+static void
+sort_modified_cb (GObject      *source_object,
+		  GAsyncResult *result,
+		  gpointer      user_data)
+{
+	GMainLoop *main_loop = user_data;
+	GError *error = NULL;
+
+	g_assert_false (gcsv_buffer_sort_by_column_finish (GCSV_BUFFER (source_object), result, &error));
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+	g_clear_error (&error);
+
+	g_main_loop_quit (main_loop);
+}
+
+static void
+test_sort_modified (void)
+{
+	GcsvBuffer *buffer;
+	GMainLoop *main_loop;
+	GtkTextIter iter;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "n\n2\n1", -1);
+
+	/* Edited before the end of the sort, the edit is kept. */
+	main_loop = g_main_loop_new (NULL, FALSE);
+	gcsv_buffer_sort_by_column_async (buffer, 0, GCSV_SORT_MODE_NUMERIC, NULL, sort_modified_cb, main_loop);
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, 1);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, "3", -1);
+	g_main_loop_run (main_loop);
+	g_main_loop_unref (main_loop);
+	check_buffer_text (buffer, "n\n32\n1");
+
+	/* The virtual spaces are not an edit. */
+	main_loop = g_main_loop_new (NULL, FALSE);
+	gcsv_buffer_sort_by_column_async (buffer, 0, GCSV_SORT_MODE_NUMERIC, NULL, sort_finished_cb, main_loop);
+	gcsv_buffer_begin_virtual_spaces_edit (buffer);
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, 1);
+	gtk_text_buffer_insert_with_tags (GTK_TEXT_BUFFER (buffer), &iter, " ", -1,
+					  gcsv_buffer_get_virtual_spaces_tag (buffer),
+					  NULL);
+	gcsv_buffer_end_virtual_spaces_edit (buffer);
+	g_main_loop_run (main_loop);
+	g_main_loop_unref (main_loop);
+	check_buffer_text (buffer, "n\n1\n32");
+
+	g_object_unref (buffer);
+}
+
+static void
+replace_finished_cb (GObject      *source_object,
+		     GAsyncResult *result,
+		     gpointer      user_data)
+{
+	GMainLoop *main_loop = user_data;
+	guint64 n_replacements = 0;
+	GError *error = NULL;
+
+	gcsv_buffer_replace_in_columns_finish (GCSV_BUFFER (source_object), result, &n_replacements, &error);
+	g_assert_no_error (error);
+
+	g_object_set_data (G_OBJECT (main_loop), "n-replacements", GUINT_TO_POINTER ((guint) n_replacements));
+	g_main_loop_quit (main_loop);
+}
+
+static guint
+replace_in_column (GcsvBuffer  *buffer,
+		   guint        column_num,
+		   const gchar *search,
+		   const gchar *replacement)
+{
+	GMainLoop *main_loop;
+	GArray *columns;
+	guint n_replacements;
+
+	columns = g_array_new (FALSE, FALSE, sizeof (guint));
+	g_array_append_val (columns, column_num);
+
+	main_loop = g_main_loop_new (NULL, FALSE);
+	gcsv_buffer_replace_in_columns_async (buffer, columns, search, replacement, TRUE,
+					      NULL, replace_finished_cb, main_loop);
+	g_main_loop_run (main_loop);
+
+	n_replacements = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (main_loop), "n-replacements"));
+
+	g_main_loop_unref (main_loop);
+	g_array_unref (columns);
+	return n_replacements;
+}
+
+static void
+replace_lines_cb (GcsvBuffer   *buffer,
+		  guint         start_line,
+		  guint         n_lines,
+		  const gchar  *text,
+		  GArray       *column_map,
+		  GArray       *column_lengths,
+		  gchar       **replaced_lines)
+{
+	g_free (*replaced_lines);
+	*replaced_lines = g_strdup_printf ("%u+%u:%s", start_line, n_lines, text);
+}
+
+static void
+test_replace_in_columns (void)
+{
+	GcsvBuffer *buffer;
+	gchar *replaced_lines = NULL;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer),
+				  "A header, kept as-is.\n"
+				  "a,a\n"
+				  "a,ba\n"
+				  "aa,a",
+				  -1);
+	gcsv_buffer_set_column_titles_line (buffer, 1);
+
+	g_signal_connect (buffer,
+			  "replace-lines",
+			  G_CALLBACK (replace_lines_cb),
+			  &replaced_lines);
+
+	/* The header and the column titles are not replaced. */
+	g_assert_cmpuint (replace_in_column (buffer, 0, "a", "x"), ==, 3);
+	check_buffer_text (buffer, "A header, kept as-is.\na,a\nx,ba\nxx,a");
+	g_assert_cmpstr (replaced_lines, ==, "2+2:x,ba\nxx,a");
+
+	/* Only the lines from the first to the last replacement are replaced. */
+	g_assert_cmpuint (replace_in_column (buffer, 1, "b", ""), ==, 1);
+	check_buffer_text (buffer, "A header, kept as-is.\na,a\nx,a\nxx,a");
+	g_assert_cmpstr (replaced_lines, ==, "2+1:x,a\n");
+
+	g_assert_cmpuint (replace_in_column (buffer, 2, "a", "x"), ==, 0);
+	check_buffer_text (buffer, "A header, kept as-is.\na,a\nx,a\nxx,a");
+	g_assert_cmpstr (replaced_lines, ==, "2+1:x,a\n");
+
+	g_object_unref (buffer);
+	g_free (replaced_lines);
+}
+
+static void
+replace_modified_cb (GObject      *source_object,
+		     GAsyncResult *result,
+		     gpointer      user_data)
+{
+	GMainLoop *main_loop = user_data;
+	GError *error = NULL;
+
+	g_assert_false (gcsv_buffer_replace_in_columns_finish (GCSV_BUFFER (source_object), result, NULL, &error));
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+	g_clear_error (&error);
+
+	g_main_loop_quit (main_loop);
+}
+
+static void
+test_replace_modified (void)
+{
+	GcsvBuffer *buffer;
+	GMainLoop *main_loop;
+	GtkTextIter iter;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "n\na\nb", -1);
+
+	/* Edited before the end of the replacement, the edit is kept. */
+	main_loop = g_main_loop_new (NULL, FALSE);
+	gcsv_buffer_replace_in_columns_async (buffer, NULL, "a", "x", TRUE,
+					      NULL, replace_modified_cb, main_loop);
+	gtk_text_buffer_get_end_iter (GTK_TEXT_BUFFER (buffer), &iter);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, "a", -1);
+	g_main_loop_run (main_loop);
+	g_main_loop_unref (main_loop);
+	check_buffer_text (buffer, "n\na\nba");
+
+	g_object_unref (buffer);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/buffer/column-num", test_column_num);
+	g_test_add_func ("/buffer/column-num-edits", test_column_num_edits);
+	g_test_add_func ("/buffer/column-ops", test_column_ops);
+	g_test_add_func ("/buffer/set-field-text", test_set_field_text);
+	g_test_add_func ("/buffer/sort-by-column", test_sort_by_column);
+	g_test_add_func ("/buffer/sort-modified", test_sort_modified);
+	g_test_add_func ("/buffer/replace-in-columns", test_replace_in_columns);
+	g_test_add_func ("/buffer/replace-modified", test_replace_modified);
+
+	return g_test_run ();
+}
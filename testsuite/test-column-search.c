@@ -0,0 +1,138 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-column-search.h"
+#include "gcsv-alignment.h"
+
+static void
+wait_indexing (GcsvColumnSearch *search)
+{
+	while (gcsv_column_search_is_indexing (search))
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+}
+
+static void
+check_find (GcsvColumnSearch *search,
+	    GtkTextBuffer    *buffer,
+	    const gchar      *pattern,
+	    gint              from_line,
+	    gboolean          backward,
+	    gint              expected_line,
+	    gint              expected_offset)
+{
+	GtkTextIter from;
+	GtkTextIter match_start;
+	GtkTextIter match_end;
+	gboolean found;
+
+	gtk_text_buffer_get_iter_at_line (buffer, &from, from_line);
+	found = gcsv_column_search_find (search, pattern, &from, backward, &match_start, &match_end);
+
+	if (expected_line == -1)
+	{
+		g_assert_false (found);
+		return;
+	}
+
+	g_assert_true (found);
+	g_assert_cmpint (gtk_text_iter_get_line (&match_start), ==, expected_line);
+	g_assert_cmpint (gtk_text_iter_get_line_offset (&match_start), ==, expected_offset);
+}
+
+static void
+test_find (void)
+{
+	GcsvBuffer *buffer;
+	GcsvAlignment *align;
+	GcsvColumnSearch *search;
+	GArray *columns;
+	guint column_num;
+	gint i;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer),
+				  "name,fruit\n"
+				  "a,apple\n"
+				  "applesauce,pear\n"
+				  "b,Pineapple",
+				  -1);
+
+	search = gcsv_column_search_new (buffer);
+
+	/* Searched line by line, before the index is built. */
+	check_find (search, GTK_TEXT_BUFFER (buffer), "apple", 0, FALSE, 1, 2);
+	wait_indexing (search);
+
+	/* The search wraps around. */
+	check_find (search, GTK_TEXT_BUFFER (buffer), "apple", 2, FALSE, 2, 0);
+	check_find (search, GTK_TEXT_BUFFER (buffer), "apple", 3, FALSE, 3, 6);
+	check_find (search, GTK_TEXT_BUFFER (buffer), "apple", 1, TRUE, 3, 6);
+	check_find (search, GTK_TEXT_BUFFER (buffer), "kiwi", 0, FALSE, -1, 0);
+
+	/* Only in the second column. */
+	columns = g_array_new (FALSE, FALSE, sizeof (guint));
+	column_num = 1;
+	g_array_append_val (columns, column_num);
+	gcsv_column_search_set_columns (search, columns);
+	g_array_unref (columns);
+
+	check_find (search, GTK_TEXT_BUFFER (buffer), "apple", 2, FALSE, 3, 6);
+
+	/* Case insensitive, with the index. */
+	check_find (search, GTK_TEXT_BUFFER (buffer), "PINE", 0, FALSE, -1, 0);
+	gcsv_column_search_set_case_sensitive (search, FALSE);
+	check_find (search, GTK_TEXT_BUFFER (buffer), "PINE", 0, FALSE, 3, 2);
+
+	/* The virtual spaces are ignored: "a" is followed by padding in the
+	 * first column.
+	 */
+	gcsv_column_search_set_columns (search, NULL);
+	align = gcsv_alignment_new (buffer);
+	for (i = 0; i < 100; i++)
+	{
+		g_main_context_iteration (NULL, FALSE);
+	}
+
+	check_find (search, GTK_TEXT_BUFFER (buffer), "a ", 0, FALSE, -1, 0);
+
+	/* Edits are searched before being indexed again. */
+	wait_indexing (search);
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "kiwi,melon", -1);
+	check_find (search, GTK_TEXT_BUFFER (buffer), "melon", 0, FALSE, 0, 5);
+	wait_indexing (search);
+	check_find (search, GTK_TEXT_BUFFER (buffer), "melon", 0, FALSE, 0, 5);
+
+	g_object_unref (align);
+	g_object_unref (search);
+	g_object_unref (buffer);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/column-search/find", test_find);
+
+	return g_test_run ();
+}
@@ -0,0 +1,94 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-column-stats-tracker.h"
+
+static void
+wait_tracker (GcsvColumnStatsTracker *tracker)
+{
+	while (!gcsv_column_stats_tracker_is_complete (tracker))
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+}
+
+static void
+test_tracker (void)
+{
+	GcsvBuffer *buffer;
+	GcsvColumnStatsTracker *tracker;
+	const GcsvColumnStats *stats;
+	GtkTextIter iter;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer),
+				  "A header.\n"
+				  "name,price\n"
+				  "a,1\n"
+				  "b,2\n"
+				  "c,\n"
+				  "d,3",
+				  -1);
+	gcsv_buffer_set_column_titles_line (buffer, 1);
+
+	/* The header and the column titles are not counted. */
+	tracker = gcsv_column_stats_tracker_new (buffer);
+	gcsv_column_stats_tracker_set_column_num (tracker, 1);
+	wait_tracker (tracker);
+
+	stats = gcsv_column_stats_tracker_get_stats (tracker);
+	g_assert_cmpuint (gcsv_column_stats_get_count (stats), ==, 4);
+	g_assert_cmpuint (gcsv_column_stats_get_n_empty (stats), ==, 1);
+	g_assert_cmpuint (gcsv_column_stats_get_n_numbers (stats), ==, 3);
+	g_assert_cmpfloat (gcsv_column_stats_get_max (stats), ==, 3.0);
+
+	/* The edited lines are computed again. */
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &iter, 4, 2);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, "10", -1);
+	gtk_text_buffer_get_end_iter (GTK_TEXT_BUFFER (buffer), &iter);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, "\ne,4", -1);
+	g_assert_false (gcsv_column_stats_tracker_is_complete (tracker));
+	wait_tracker (tracker);
+
+	stats = gcsv_column_stats_tracker_get_stats (tracker);
+	g_assert_cmpuint (gcsv_column_stats_get_count (stats), ==, 5);
+	g_assert_cmpuint (gcsv_column_stats_get_n_empty (stats), ==, 0);
+	g_assert_cmpuint (gcsv_column_stats_get_n_numbers (stats), ==, 5);
+	g_assert_cmpfloat (gcsv_column_stats_get_max (stats), ==, 10.0);
+	g_assert_cmpfloat (gcsv_column_stats_get_mean (stats), ==, 4.0);
+
+	/* Without delimiter, there are no stats. */
+	gcsv_buffer_set_delimiter (buffer, '\0');
+	g_assert_null (gcsv_column_stats_tracker_get_stats (tracker));
+
+	g_object_unref (tracker);
+	g_object_unref (buffer);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/column-stats-tracker/tracker", test_tracker);
+
+	return g_test_run ();
+}
@@ -0,0 +1,1108 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <glib/gstdio.h>
+
+#ifdef G_OS_UNIX
+#include <signal.h>
+#include <sys/resource.h>
+#endif
+
+#include "gcsv-block-hashes.h"
+#include "gcsv-cli.h"
+#include "gcsv-column-stats.h"
+#include "gcsv-compression.h"
+#include "gcsv-column-widths.h"
+#include "gcsv-filter.h"
+#include "gcsv-journal.h"
+#include "gcsv-replace.h"
+#include "gcsv-row-index.h"
+#include "gcsv-sort.h"
+#include "gcsv-tokenizer.h"
+#include "gcsv-trigram-index.h"
+
+static void
+test_find_delimiter (void)
+{
+	GcsvTokenizer tokenizer;
+	const gchar *line = "a,b;c\xc2\xa7" "d";
+	const gchar *end = line + strlen (line);
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	g_assert_true (gcsv_tokenizer_find_delimiter (&tokenizer, line, end) == line + 1);
+	g_assert_null (gcsv_tokenizer_find_delimiter (&tokenizer, line + 2, end));
+
+	/* Multi-byte delimiter: U+00A7 SECTION SIGN. */
+	gcsv_tokenizer_init (&tokenizer, 0xA7);
+	g_assert_cmpuint (gcsv_tokenizer_get_delimiter_length (&tokenizer), ==, 2);
+	g_assert_true (gcsv_tokenizer_find_delimiter (&tokenizer, line, end) == line + 5);
+
+	/* The delimiter must be entirely in the range. */
+	g_assert_null (gcsv_tokenizer_find_delimiter (&tokenizer, line, line + 6));
+
+	gcsv_tokenizer_init (&tokenizer, '\0');
+	g_assert_null (gcsv_tokenizer_find_delimiter (&tokenizer, line, end));
+}
+
+static void
+test_columns (void)
+{
+	GcsvTokenizer tokenizer;
+	const gchar *line = "aa,,bbb,";
+	const gchar *end = line + strlen (line);
+	const gchar *field_start;
+	const gchar *field_end;
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+
+	g_assert_cmpuint (gcsv_tokenizer_count_columns (&tokenizer, line, end), ==, 4);
+	g_assert_cmpuint (gcsv_tokenizer_count_columns (&tokenizer, line, line), ==, 1);
+	g_assert_cmpuint (gcsv_tokenizer_get_column_num (&tokenizer, line, line + 2), ==, 0);
+	g_assert_cmpuint (gcsv_tokenizer_get_column_num (&tokenizer, line, line + 3), ==, 1);
+	g_assert_cmpuint (gcsv_tokenizer_get_column_num (&tokenizer, line, end), ==, 3);
+
+	g_assert_true (gcsv_tokenizer_get_field_bounds (&tokenizer, line, end, 0, &field_start, &field_end));
+	g_assert_true (field_start == line && field_end == line + 2);
+
+	g_assert_true (gcsv_tokenizer_get_field_bounds (&tokenizer, line, end, 1, &field_start, &field_end));
+	g_assert_true (field_start == line + 3 && field_end == line + 3);
+
+	g_assert_true (gcsv_tokenizer_get_field_bounds (&tokenizer, line, end, 2, &field_start, &field_end));
+	g_assert_true (field_start == line + 4 && field_end == line + 7);
+
+	g_assert_true (gcsv_tokenizer_get_field_bounds (&tokenizer, line, end, 3, &field_start, &field_end));
+	g_assert_true (field_start == end && field_end == end);
+
+	g_assert_false (gcsv_tokenizer_get_field_bounds (&tokenizer, line, end, 4, NULL, NULL));
+}
+
+static void
+test_line_end (void)
+{
+	const gchar *text = "a\r\nb\nc";
+	const gchar *end = text + strlen (text);
+	const gchar *next_line_start;
+
+	g_assert_true (gcsv_tokenizer_find_line_end (text, end, &next_line_start) == text + 1);
+	g_assert_true (next_line_start == text + 3);
+
+	g_assert_true (gcsv_tokenizer_find_line_end (text + 3, end, &next_line_start) == text + 4);
+	g_assert_true (next_line_start == text + 5);
+
+	g_assert_true (gcsv_tokenizer_find_line_end (text + 5, end, &next_line_start) == end);
+	g_assert_true (next_line_start == end);
+}
+
+static void
+test_guess_delimiter (void)
+{
+	const gchar *csv = "a,b\n1,2\n";
+	const gchar *tsv = "a\tb\n1\t2\n";
+	const gchar *semicolons = "name;price;unit\nfoo;1,5;kg\nbar;2,25;l\nbaz;10;g\n";
+	const gchar *pipes = "a|b|c\r\nx, y|z|w\r\n";
+	const gchar *quoted = "\"a;b\",c\n\"d;e\",f\n";
+	GString *long_sample;
+
+	g_assert_cmpuint (gcsv_tokenizer_guess_delimiter (csv, strlen (csv)), ==, ',');
+	g_assert_cmpuint (gcsv_tokenizer_guess_delimiter (tsv, strlen (tsv)), ==, '\t');
+	g_assert_cmpuint (gcsv_tokenizer_guess_delimiter (semicolons, strlen (semicolons)), ==, ';');
+	g_assert_cmpuint (gcsv_tokenizer_guess_delimiter (pipes, strlen (pipes)), ==, '|');
+	g_assert_cmpuint (gcsv_tokenizer_guess_delimiter (quoted, strlen (quoted)), ==, ',');
+	g_assert_cmpuint (gcsv_tokenizer_guess_delimiter ("abc\n", 4), ==, ',');
+	g_assert_cmpuint (gcsv_tokenizer_guess_delimiter (NULL, 0), ==, ',');
+
+	/* Only the beginning is looked at. */
+	long_sample = g_string_new (NULL);
+	while (long_sample->len <= GCSV_TOKENIZER_GUESS_SAMPLE_SIZE)
+	{
+		g_string_append (long_sample, "a;b;c\n");
+	}
+	g_string_append (long_sample, "d,e,f\nd,e,f\nd,e,f\n");
+	g_assert_cmpuint (gcsv_tokenizer_guess_delimiter (long_sample->str, long_sample->len), ==, ';');
+	g_string_free (long_sample, TRUE);
+}
+
+static void
+check_remap (const gchar *text,
+	     const gint  *map,
+	     guint        map_length,
+	     const gchar *expected)
+{
+	GcsvTokenizer tokenizer;
+	GArray *column_map;
+	GString *output;
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+
+	column_map = g_array_new (FALSE, FALSE, sizeof (gint));
+	g_array_append_vals (column_map, map, map_length);
+
+	output = g_string_new (NULL);
+	gcsv_tokenizer_remap_columns (&tokenizer, text, text + strlen (text), column_map, output);
+	g_assert_cmpstr (output->str, ==, expected);
+
+	g_string_free (output, TRUE);
+	g_array_unref (column_map);
+}
+
+static void
+test_remap_columns (void)
+{
+	const gchar *text = "a,b,c\r\n1,2\n\nx,y,z,w";
+	const gint delete_map[] = { 0, 2, 3 };
+	const gint insert_map[] = { 0, -1, 1, 2, 3 };
+	const gint move_map[] = { 1, 0, 2, 3 };
+	const gint duplicate_map[] = { 0, 0, 1, 2, 3 };
+	GcsvTokenizer tokenizer;
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	g_assert_cmpuint (gcsv_tokenizer_count_max_columns (&tokenizer, text, text + strlen (text)), ==, 4);
+
+	/* Short lines stay short, empty lines stay empty. */
+	check_remap (text, delete_map, G_N_ELEMENTS (delete_map), "a,c\r\n1\n\nx,z,w");
+	check_remap (text, insert_map, G_N_ELEMENTS (insert_map), "a,,b,c\r\n1,,2\n\nx,,y,z,w");
+	check_remap (text, move_map, G_N_ELEMENTS (move_map), "b,a,c\r\n2,1\n\ny,x,z,w");
+	check_remap (text, duplicate_map, G_N_ELEMENTS (duplicate_map), "a,a,b,c\r\n1,1,2\n\nx,x,y,z,w");
+}
+
+static void
+add_line (GcsvColumnWidths    *widths,
+	  const GcsvTokenizer *tokenizer,
+	  const gchar         *line)
+{
+	gcsv_column_widths_add_line (widths, tokenizer, line, line + strlen (line));
+}
+
+static void
+check_filter (GcsvFilterMode  mode,
+	      const gchar    *pattern,
+	      const gchar    *text,
+	      const guint    *expected_rejected_lines,
+	      guint           n_expected)
+{
+	GcsvTokenizer tokenizer;
+	GcsvFilter *filter;
+	GArray *rejected_lines;
+	GError *error = NULL;
+	guint i;
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	filter = gcsv_filter_new (mode, 1, pattern, &error);
+	g_assert_no_error (error);
+
+	rejected_lines = g_array_new (FALSE, FALSE, sizeof (guint));
+	gcsv_filter_match_lines (filter, &tokenizer, text, text + strlen (text), rejected_lines);
+
+	g_assert_cmpuint (rejected_lines->len, ==, n_expected);
+	for (i = 0; i < n_expected; i++)
+	{
+		g_assert_cmpuint (g_array_index (rejected_lines, guint, i), ==, expected_rejected_lines[i]);
+	}
+
+	g_array_unref (rejected_lines);
+	gcsv_filter_unref (filter);
+}
+
+static void
+test_filter (void)
+{
+	const gchar *text = "a,apple\nb, 12 \r\nc\nd,banana\ne,3.5";
+	const guint substring_rejected[] = { 1, 2, 4 };
+	const guint regex_rejected[] = { 0, 1, 2, 4 };
+	const guint digit_rejected[] = { 0, 2, 3 };
+	const guint greater_rejected[] = { 0, 2, 3, 4 };
+	const guint equal_rejected[] = { 0, 1, 2, 3 };
+	GcsvFilter *filter;
+	GError *error = NULL;
+
+	/* A line without the column has an empty field. */
+	check_filter (GCSV_FILTER_MODE_SUBSTRING, "a", text, substring_rejected, G_N_ELEMENTS (substring_rejected));
+	check_filter (GCSV_FILTER_MODE_SUBSTRING, "", text, NULL, 0);
+	check_filter (GCSV_FILTER_MODE_REGEX, "^[b-z]", text, regex_rejected, G_N_ELEMENTS (regex_rejected));
+	check_filter (GCSV_FILTER_MODE_REGEX, "[0-9]", text, digit_rejected, G_N_ELEMENTS (digit_rejected));
+
+	/* Fields that are not numbers never match. */
+	check_filter (GCSV_FILTER_MODE_NUMERIC, "> 10", text, greater_rejected, G_N_ELEMENTS (greater_rejected));
+	check_filter (GCSV_FILTER_MODE_NUMERIC, "!=3.5", text, greater_rejected, G_N_ELEMENTS (greater_rejected));
+	check_filter (GCSV_FILTER_MODE_NUMERIC, " 3.5 ", text, equal_rejected, G_N_ELEMENTS (equal_rejected));
+
+	filter = gcsv_filter_new (GCSV_FILTER_MODE_NUMERIC, 0, ">= ten", &error);
+	g_assert_null (filter);
+	g_assert_error (error, GCSV_FILTER_ERROR, GCSV_FILTER_ERROR_INVALID_NUMBER);
+	g_clear_error (&error);
+}
+
+static void
+check_replace (const gchar *text,
+	       GArray      *columns,
+	       const gchar *search,
+	       const gchar *replacement,
+	       gboolean     case_sensitive,
+	       const gchar *expected_text,
+	       guint64      expected_n_replacements,
+	       guint        expected_first_line,
+	       guint        expected_last_line)
+{
+	GcsvTokenizer tokenizer;
+	GString *output;
+	guint64 n_replacements = 0;
+	guint first_line = 0;
+	guint last_line = 0;
+	gboolean ok;
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	output = g_string_new (NULL);
+
+	ok = gcsv_replace_in_columns (&tokenizer,
+				      text, text + strlen (text),
+				      columns,
+				      search, replacement,
+				      case_sensitive,
+				      output,
+				      &n_replacements,
+				      &first_line,
+				      &last_line,
+				      NULL);
+	g_assert_true (ok);
+	g_assert_cmpstr (output->str, ==, expected_text);
+	g_assert_cmpuint (n_replacements, ==, expected_n_replacements);
+	g_assert_cmpuint (first_line, ==, expected_first_line);
+	g_assert_cmpuint (last_line, ==, expected_last_line);
+
+	g_string_free (output, TRUE);
+}
+
+static void
+test_replace (void)
+{
+	const gchar *text = "a,foo foo,x\nfoo,bar\r\nfoo\nb,FOO,foo";
+	GArray *columns;
+	guint column_num;
+
+	columns = g_array_new (FALSE, FALSE, sizeof (guint));
+	column_num = 1;
+	g_array_append_val (columns, column_num);
+
+	/* A line without the column is kept as is. */
+	check_replace (text, columns, "foo", "X", TRUE,
+		       "a,X X,x\nfoo,bar\r\nfoo\nb,FOO,foo", 2, 0, 0);
+	check_replace (text, columns, "foo", "X", FALSE,
+		       "a,X X,x\nfoo,bar\r\nfoo\nb,X,foo", 3, 0, 3);
+	check_replace (text, NULL, "foo", "longer", TRUE,
+		       "a,longer longer,x\nlonger,bar\r\nlonger\nb,FOO,longer", 5, 0, 3);
+
+	/* The changed lines are the ones with a replacement. */
+	check_replace ("a,b\nc,foo\nd,e\nfoo,f\ng,h", NULL, "foo", "X", TRUE,
+		       "a,b\nc,X\nd,e\nX,f\ng,h", 2, 1, 3);
+
+	/* The occurrences don't overlap, and never span two fields. */
+	check_replace ("aaa,a", NULL, "aa", "b", TRUE, "ba,a", 1, 0, 0);
+	check_replace ("a,a", NULL, "a,a", "b", TRUE, "a,a", 0, 0, 0);
+	check_replace ("x,aBcd\n", columns, "bC", "", FALSE, "x,ad\n", 1, 0, 0);
+
+	g_array_unref (columns);
+}
+
+/* Returns: the byte offset of the line @line_num, or the length. */
+static gsize
+get_line_offset (const gchar *text,
+		 guint        line_num)
+{
+	const gchar *end = text + strlen (text);
+	const gchar *p = text;
+	guint i;
+
+	for (i = 0; i < line_num && p < end; i++)
+	{
+		gcsv_tokenizer_find_line_end (p, end, &p);
+	}
+
+	return p - text;
+}
+
+/* Applies the diff to @old_text, the result must be @new_text. Returns the
+ * number of replaced lines.
+ */
+static guint
+check_block_diff (const gchar *old_text,
+		  const gchar *new_text)
+{
+	GcsvBlockHashes *old_hashes;
+	GcsvBlockHashes *new_hashes;
+	GcsvBlockDiff diff;
+	GString *result;
+	gsize old_start;
+	gsize old_end;
+
+	old_hashes = gcsv_block_hashes_new (old_text, strlen (old_text), NULL);
+	new_hashes = gcsv_block_hashes_new (new_text, strlen (new_text), NULL);
+
+	if (!gcsv_block_hashes_diff (old_hashes, new_hashes, &diff))
+	{
+		g_assert_cmpstr (old_text, ==, new_text);
+		gcsv_block_hashes_free (old_hashes);
+		gcsv_block_hashes_free (new_hashes);
+		return 0;
+	}
+
+	old_start = get_line_offset (old_text, diff.start_line);
+	old_end = get_line_offset (old_text, diff.start_line + diff.old_n_lines);
+	g_assert_cmpuint (diff.new_start, ==, get_line_offset (new_text, diff.start_line));
+	g_assert_cmpuint (diff.new_end, ==, get_line_offset (new_text, diff.start_line + diff.new_n_lines));
+
+	result = g_string_new_len (old_text, old_start);
+	g_string_append_len (result, new_text + diff.new_start, diff.new_end - diff.new_start);
+	g_string_append (result, old_text + old_end);
+	g_assert_cmpstr (result->str, ==, new_text);
+	g_string_free (result, TRUE);
+
+	g_assert_cmpuint (gcsv_block_hashes_get_n_lines (new_hashes), ==,
+			  gcsv_block_hashes_get_n_lines (old_hashes) - diff.old_n_lines + diff.new_n_lines);
+
+	gcsv_block_hashes_free (old_hashes);
+	gcsv_block_hashes_free (new_hashes);
+	return MAX (diff.old_n_lines, diff.new_n_lines);
+}
+
+static gchar *
+create_rows (guint        n_rows,
+	     guint        changed_row,
+	     const gchar *changed_row_text)
+{
+	GString *text;
+	guint row_num;
+
+	text = g_string_new (NULL);
+	for (row_num = 0; row_num < n_rows; row_num++)
+	{
+		if (row_num == changed_row)
+		{
+			g_string_append (text, changed_row_text);
+		}
+		else
+		{
+			g_string_append_printf (text, "row%u,%u\n", row_num, row_num * 7);
+		}
+	}
+
+	return g_string_free (text, FALSE);
+}
+
+static void
+test_block_hashes (void)
+{
+	gchar *text;
+	gchar *other_text;
+	GcsvBlockHashes *hashes;
+
+	text = create_rows (20000, G_MAXUINT, NULL);
+
+	hashes = gcsv_block_hashes_new (text, strlen (text), NULL);
+	g_assert_cmpuint (gcsv_block_hashes_get_n_lines (hashes), ==, 20000);
+	g_assert_cmpuint (gcsv_block_hashes_get_n_blocks (hashes), >, 1);
+	gcsv_block_hashes_free (hashes);
+
+	g_assert_cmpuint (check_block_diff (text, text), ==, 0);
+
+	/* Only the blocks around a change are replaced. */
+	other_text = create_rows (20000, 10000, "changed\n");
+	g_assert_cmpuint (check_block_diff (text, other_text), <=, 4096);
+	g_free (other_text);
+
+	other_text = create_rows (20000, 5000, "inserted\ninserted\ninserted\n");
+	g_assert_cmpuint (check_block_diff (text, other_text), <=, 4096);
+	g_free (other_text);
+
+	other_text = create_rows (20000, 5000, "");
+	g_assert_cmpuint (check_block_diff (text, other_text), <=, 4096);
+	g_free (other_text);
+
+	/* Appended, truncated, and a change of line terminator. */
+	other_text = g_strconcat (text, "new,1\nnew,2", NULL);
+	g_assert_cmpuint (check_block_diff (text, other_text), <=, 4096 + 2);
+	check_block_diff (other_text, text);
+	g_free (other_text);
+
+	other_text = create_rows (20000, 0, "row0,0\r\n");
+	g_assert_cmpuint (check_block_diff (text, other_text), <=, 4096);
+	g_free (other_text);
+
+	check_block_diff ("", "a\nb");
+	check_block_diff ("a\nb", "");
+	check_block_diff ("a\nb", "a\nb\n");
+
+	g_free (text);
+}
+
+static void
+test_column_stats (void)
+{
+	const gchar *text = "a,1\nb, 2 \r\nc\nd,foo\ne,3\nf,foo\ng,\n";
+	GcsvTokenizer tokenizer;
+	GcsvColumnStats *stats;
+	GcsvColumnStats *first;
+	GcsvColumnStats *second;
+	GcsvValueCount *value_count;
+	GPtrArray *top_values;
+	const gchar *middle;
+	GString *value;
+	guint i;
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+
+	/* Lines without the column, or with only spaces, are empty. */
+	stats = gcsv_column_stats_new ();
+	gcsv_column_stats_add_lines (stats, &tokenizer, 1, text, text + strlen (text));
+
+	g_assert_cmpuint (gcsv_column_stats_get_count (stats), ==, 7);
+	g_assert_cmpuint (gcsv_column_stats_get_n_empty (stats), ==, 2);
+	g_assert_cmpuint (gcsv_column_stats_get_n_numbers (stats), ==, 3);
+	g_assert_cmpfloat (gcsv_column_stats_get_min (stats), ==, 1.0);
+	g_assert_cmpfloat (gcsv_column_stats_get_max (stats), ==, 3.0);
+	g_assert_cmpfloat_with_epsilon (gcsv_column_stats_get_mean (stats), 2.0, 1e-9);
+	g_assert_cmpfloat_with_epsilon (gcsv_column_stats_get_stddev (stats), 1.0, 1e-9);
+	g_assert_cmpuint (gcsv_column_stats_get_n_distinct (stats), ==, 4);
+
+	top_values = gcsv_column_stats_get_top_values (stats, 2);
+	g_assert_cmpuint (top_values->len, ==, 2);
+	value_count = g_ptr_array_index (top_values, 0);
+	g_assert_cmpstr (value_count->value, ==, "foo");
+	g_assert_cmpuint (value_count->count, ==, 2);
+	value_count = g_ptr_array_index (top_values, 1);
+	g_assert_cmpstr (value_count->value, ==, "1");
+	g_assert_cmpuint (value_count->count, ==, 1);
+	g_ptr_array_unref (top_values);
+
+	/* Merging the stats of two halves gives the same result. */
+	middle = strstr (text, "d,");
+	first = gcsv_column_stats_new ();
+	second = gcsv_column_stats_new ();
+	gcsv_column_stats_add_lines (first, &tokenizer, 1, text, middle);
+	gcsv_column_stats_add_lines (second, &tokenizer, 1, middle, text + strlen (text));
+	gcsv_column_stats_merge (first, second);
+
+	g_assert_cmpuint (gcsv_column_stats_get_count (first), ==, 7);
+	g_assert_cmpuint (gcsv_column_stats_get_n_empty (first), ==, 2);
+	g_assert_cmpuint (gcsv_column_stats_get_n_numbers (first), ==, 3);
+	g_assert_cmpfloat_with_epsilon (gcsv_column_stats_get_mean (first), 2.0, 1e-9);
+	g_assert_cmpfloat_with_epsilon (gcsv_column_stats_get_stddev (first), 1.0, 1e-9);
+	g_assert_cmpuint (gcsv_column_stats_get_n_distinct (first), ==, 4);
+
+	top_values = gcsv_column_stats_get_top_values (first, 1);
+	value_count = g_ptr_array_index (top_values, 0);
+	g_assert_cmpstr (value_count->value, ==, "foo");
+	g_assert_cmpuint (value_count->count, ==, 2);
+	g_ptr_array_unref (top_values);
+
+	gcsv_column_stats_free (first);
+	gcsv_column_stats_free (second);
+	gcsv_column_stats_free (stats);
+
+	/* The distinct count is an estimate, and the most frequent value is
+	 * found among many distinct values.
+	 */
+	stats = gcsv_column_stats_new ();
+	value = g_string_new (NULL);
+
+	for (i = 0; i < 100000; i++)
+	{
+		if (i % 3 == 0)
+		{
+			g_string_assign (value, "frequent");
+		}
+		else
+		{
+			g_string_printf (value, "value %u", i);
+		}
+
+		gcsv_column_stats_add_field (stats, value->str, value->str + value->len);
+	}
+
+	g_assert_cmpuint (gcsv_column_stats_get_n_distinct (stats), >, 66667 * 0.9);
+	g_assert_cmpuint (gcsv_column_stats_get_n_distinct (stats), <, 66667 * 1.1);
+
+	top_values = gcsv_column_stats_get_top_values (stats, 1);
+	value_count = g_ptr_array_index (top_values, 0);
+	g_assert_cmpstr (value_count->value, ==, "frequent");
+	g_assert_cmpuint (value_count->count, >=, 33334);
+	g_ptr_array_unref (top_values);
+
+	g_string_free (value, TRUE);
+	gcsv_column_stats_free (stats);
+}
+
+static void
+check_trigram_lookup (const GcsvTrigramIndex *index,
+		      const gchar            *pattern,
+		      gboolean                expected_result,
+		      const guint            *expected_lines,
+		      guint                   n_expected)
+{
+	GArray *candidate_lines;
+	guint i;
+
+	candidate_lines = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	g_assert_cmpint (gcsv_trigram_index_lookup (index, pattern, strlen (pattern), candidate_lines),
+			 ==, expected_result);
+
+	g_assert_cmpuint (candidate_lines->len, ==, n_expected);
+	for (i = 0; i < n_expected; i++)
+	{
+		g_assert_cmpuint (g_array_index (candidate_lines, guint, i), ==, expected_lines[i]);
+	}
+
+	g_array_unref (candidate_lines);
+}
+
+static void
+test_trigram_index (void)
+{
+	const gchar *text = "apple,pie\nbanana,split\r\nCherry,PIE\n\nap,ple";
+	const guint pie_lines[] = { 0, 2 };
+	const guint banana_lines[] = { 1 };
+	const guint cherry_lines[] = { 2 };
+	GcsvTrigramIndex *index;
+	GString *big_text;
+	GArray *candidate_lines;
+	guint i;
+
+	index = gcsv_trigram_index_new (text, text + strlen (text));
+	g_assert_cmpuint (gcsv_trigram_index_get_n_lines (index), ==, 5);
+
+	/* The ASCII letters are indexed in lowercase. */
+	check_trigram_lookup (index, "pie", TRUE, pie_lines, G_N_ELEMENTS (pie_lines));
+	check_trigram_lookup (index, "anana", TRUE, banana_lines, G_N_ELEMENTS (banana_lines));
+	check_trigram_lookup (index, "cherry", TRUE, cherry_lines, G_N_ELEMENTS (cherry_lines));
+
+	/* The trigrams spanning a line terminator are not indexed. */
+	check_trigram_lookup (index, "pie\nba", TRUE, NULL, 0);
+	check_trigram_lookup (index, "kiwi", TRUE, NULL, 0);
+	check_trigram_lookup (index, "ap", FALSE, NULL, 0);
+
+	gcsv_trigram_index_free (index);
+
+	/* With more lines than blocks, the candidates are whole blocks. */
+	big_text = g_string_new (NULL);
+	for (i = 0; i < 1000; i++)
+	{
+		g_string_append_printf (big_text, "%s,%u\n", i == 500 ? "needle" : "hay", i);
+	}
+
+	index = gcsv_trigram_index_new (big_text->str, big_text->str + big_text->len);
+	candidate_lines = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	g_assert_true (gcsv_trigram_index_lookup (index, "needle", 6, candidate_lines));
+	g_assert_cmpuint (candidate_lines->len, >=, 1);
+	g_assert_cmpuint (candidate_lines->len, <=, 4);
+	g_assert_cmpuint (g_array_index (candidate_lines, guint, 0), <=, 500);
+	g_assert_cmpuint (g_array_index (candidate_lines, guint, candidate_lines->len - 1), >=, 500);
+
+	g_array_unref (candidate_lines);
+	gcsv_trigram_index_free (index);
+	g_string_free (big_text, TRUE);
+}
+
+static void
+check_sort (const gchar  *text,
+	    guint         column_num,
+	    GcsvSortMode  mode,
+	    const gchar  *expected)
+{
+	GcsvTokenizer tokenizer;
+	GString *output;
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	output = g_string_new (NULL);
+
+	g_assert_true (gcsv_sort_lines (&tokenizer, text, strlen (text), column_num, mode, output, NULL));
+	g_assert_cmpstr (output->str, ==, expected);
+
+	g_string_free (output, TRUE);
+}
+
+static void
+test_sort_lines (void)
+{
+	GcsvTokenizer tokenizer;
+	GString *text;
+	GString *output;
+	const gchar *p;
+	guint prev_key = 0;
+	guint prev_id = 0;
+	guint i;
+
+	/* Stable, lines without the column have an empty field. */
+	check_sort ("b,1\na,2\nb,0\na,3\n", 0, GCSV_SORT_MODE_LEXICOGRAPHIC, "a,2\na,3\nb,1\nb,0\n");
+	check_sort ("x,10\ny\nz,9\n", 1, GCSV_SORT_MODE_LEXICOGRAPHIC, "y\nx,10\nz,9\n");
+
+	/* Not-a-number fields come last. The last line gets a line terminator
+	 * if it moves, and the text doesn't end with one, like before.
+	 */
+	check_sort ("x,10\ny, n/a\r\nz, 9 \nw,-1.5", 1, GCSV_SORT_MODE_NUMERIC, "w,-1.5\nz, 9 \nx,10\ny, n/a");
+	check_sort ("", 0, GCSV_SORT_MODE_NUMERIC, "");
+
+	check_sort ("b\na\nc\n", 0, GCSV_SORT_MODE_COLLATE, "a\nb\nc\n");
+
+	/* Large enough to be sorted by several threads. */
+	text = g_string_new (NULL);
+	for (i = 0; i < 100000; i++)
+	{
+		g_string_append_printf (text, "%u,%u\n", (i * 7919) % 1000, i);
+	}
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	output = g_string_new (NULL);
+	g_assert_true (gcsv_sort_lines (&tokenizer, text->str, text->len, 0,
+					GCSV_SORT_MODE_NUMERIC, output, NULL));
+	g_assert_cmpuint (output->len, ==, text->len);
+
+	for (p = output->str; *p != '\0'; p = strchr (p, '\n') + 1)
+	{
+		guint key;
+		guint id;
+
+		g_assert_true (sscanf (p, "%u,%u", &key, &id) == 2);
+		g_assert_true (key > prev_key || (key == prev_key && id >= prev_id));
+		prev_key = key;
+		prev_id = id;
+	}
+
+	g_string_free (text, TRUE);
+	g_string_free (output, TRUE);
+}
+
+static void
+test_column_widths (void)
+{
+	GcsvTokenizer tokenizer;
+	GcsvColumnWidths *widths;
+	GcsvColumnWidths *other;
+
+	gcsv_tokenizer_init (&tokenizer, ',');
+	widths = gcsv_column_widths_new ();
+
+	/* Same rules as GcsvAlignment, the lengths are in characters. */
+	add_line (widths, &tokenizer, "a,b,c,");
+	add_line (widths, &tokenizer, "1,2");
+	add_line (widths, &tokenizer, "xx,\xc3\xa9t\xc3\xa9,Zzz");
+
+	g_assert_cmpuint (gcsv_column_widths_get_n_columns (widths), ==, 4);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 0), ==, 2);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 1), ==, 3);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 2), ==, 3);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 3), ==, 0);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 4), ==, -1);
+
+	/* Merge, as done for accumulators filled by different threads. */
+	other = gcsv_column_widths_new ();
+	add_line (other, &tokenizer, "x,yyyyy,z,w,vv");
+	gcsv_column_widths_merge (widths, other);
+
+	g_assert_cmpuint (gcsv_column_widths_get_n_columns (widths), ==, 5);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 0), ==, 2);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 1), ==, 5);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 3), ==, 1);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 4), ==, 2);
+
+	gcsv_column_widths_free (other);
+
+	/* No delimiter, no alignment. */
+	gcsv_column_widths_clear (widths);
+	gcsv_tokenizer_init (&tokenizer, '\0');
+	add_line (widths, &tokenizer, "a,b");
+	g_assert_cmpuint (gcsv_column_widths_get_n_columns (widths), ==, 0);
+
+	gcsv_column_widths_free (widths);
+}
+
+static void
+test_row_index (void)
+{
+	const gchar *text = "aaa,b\r\n1,22\n\n333";
+	GBytes *bytes;
+	GcsvRowIndex *index;
+	GcsvColumnWidths *widths;
+	const gchar *row_start;
+	gsize row_length;
+
+	bytes = g_bytes_new_static (text, strlen (text));
+	index = gcsv_row_index_new (bytes, ',');
+	gcsv_row_index_build (index, NULL);
+
+	g_assert_true (gcsv_row_index_is_complete (index));
+	g_assert_cmpuint (gcsv_row_index_get_n_rows (index), ==, 4);
+
+	g_assert_true (gcsv_row_index_get_row (index, 0, &row_start, &row_length));
+	g_assert_cmpuint (row_length, ==, 5);
+	g_assert_true (strncmp (row_start, "aaa,b", row_length) == 0);
+
+	g_assert_true (gcsv_row_index_get_row (index, 2, &row_start, &row_length));
+	g_assert_cmpuint (row_length, ==, 0);
+
+	g_assert_true (gcsv_row_index_get_row (index, 3, &row_start, &row_length));
+	g_assert_true (strncmp (row_start, "333", row_length) == 0);
+
+	g_assert_false (gcsv_row_index_get_row (index, 4, &row_start, &row_length));
+
+	widths = gcsv_row_index_get_column_widths (index);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 0), ==, 3);
+	g_assert_cmpint (gcsv_column_widths_get (widths, 1), ==, 2);
+	gcsv_column_widths_free (widths);
+
+	gcsv_row_index_unref (index);
+	g_bytes_unref (bytes);
+}
+
+static void
+append_record (GString       *journal,
+	       GcsvJournalOp  op,
+	       guint          line,
+	       guint64        offset,
+	       const gchar   *text)
+{
+	GcsvJournalRecord record;
+
+	record.op = op;
+	record.line = line;
+	record.offset = offset;
+	record.text = text;
+	record.length = strlen (text);
+
+	gcsv_journal_append_record (journal, &record);
+}
+
+static void
+check_record (const gchar   **p,
+	      const gchar    *end,
+	      GcsvJournalOp   op,
+	      guint           line,
+	      guint64         offset,
+	      const gchar    *text)
+{
+	GcsvJournalRecord record;
+
+	g_assert_true (gcsv_journal_read_record (p, end, &record));
+	g_assert_cmpint (record.op, ==, op);
+	g_assert_cmpuint (record.line, ==, line);
+	g_assert_cmpuint (record.offset, ==, offset);
+	g_assert_cmpuint (record.length, ==, strlen (text));
+	g_assert_true (strncmp (record.text, text, record.length) == 0);
+}
+
+static void
+test_journal (void)
+{
+	GString *journal;
+	const gchar *p;
+	const gchar *end;
+	guint64 base_size;
+	guint64 base_mtime;
+	GcsvJournalRecord record;
+
+	journal = g_string_new (NULL);
+	gcsv_journal_append_header (journal, 3000000000, G_GUINT64_CONSTANT (1700000000123456));
+	append_record (journal, GCSV_JOURNAL_OP_INSERT, 0, 3, "x");
+	append_record (journal, GCSV_JOURNAL_OP_DELETE, 100000, 200, "ab\xc3\xa9");
+	append_record (journal, GCSV_JOURNAL_OP_REPLACE_LINES, 2, 5, "a,b\nc,d\n");
+	append_record (journal, GCSV_JOURNAL_OP_INSERT, 7, 0, "");
+
+	p = journal->str;
+	end = journal->str + journal->len;
+
+	g_assert_true (gcsv_journal_read_header (&p, end, &base_size, &base_mtime));
+	g_assert_cmpuint (base_size, ==, 3000000000);
+	g_assert_cmpuint (base_mtime, ==, G_GUINT64_CONSTANT (1700000000123456));
+
+	check_record (&p, end, GCSV_JOURNAL_OP_INSERT, 0, 3, "x");
+	check_record (&p, end, GCSV_JOURNAL_OP_DELETE, 100000, 200, "ab\xc3\xa9");
+	check_record (&p, end, GCSV_JOURNAL_OP_REPLACE_LINES, 2, 5, "a,b\nc,d\n");
+	check_record (&p, end, GCSV_JOURNAL_OP_INSERT, 7, 0, "");
+	g_assert_true (p == end);
+	g_assert_false (gcsv_journal_read_record (&p, end, &record));
+
+	/* A record truncated by a crash is ignored. */
+	p = journal->str;
+	end = journal->str + journal->len - 6;
+	g_assert_true (gcsv_journal_read_header (&p, end, &base_size, &base_mtime));
+	check_record (&p, end, GCSV_JOURNAL_OP_INSERT, 0, 3, "x");
+	check_record (&p, end, GCSV_JOURNAL_OP_DELETE, 100000, 200, "ab\xc3\xa9");
+	g_assert_false (gcsv_journal_read_record (&p, end, &record));
+
+	/* Not a journal. */
+	p = "a,b,c\n";
+	g_assert_false (gcsv_journal_read_header (&p, p + 6, &base_size, &base_mtime));
+
+	/* Invalid operation. */
+	g_string_truncate (journal, 0);
+	append_record (journal, 9, 0, 0, "x");
+	p = journal->str;
+	g_assert_false (gcsv_journal_read_record (&p, journal->str + journal->len, &record));
+
+	g_string_free (journal, TRUE);
+}
+
+static void
+check_compression_round_trip (GcsvCompression  compression,
+			      const gchar     *text)
+{
+	gchar *path;
+	GFile *location;
+	GBytes *contents;
+	GInputStream *stream;
+	GcsvCompression detected;
+	gchar buffer[256];
+	gsize n_bytes_read;
+	gchar *etag = NULL;
+	gint fd;
+	GError *error = NULL;
+
+	fd = g_file_open_tmp ("gcsvedit-test-compression-XXXXXX", &path, NULL);
+	g_assert_cmpint (fd, !=, -1);
+	g_close (fd, NULL);
+	location = g_file_new_for_path (path);
+
+	contents = g_bytes_new_static (text, strlen (text));
+	gcsv_compression_save_file (location, compression, contents, NULL, &etag, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (etag);
+
+	/* Modified by another program. */
+	g_assert_false (gcsv_compression_save_file (location, compression, contents, "0:0", NULL, NULL, &error));
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_WRONG_ETAG);
+	g_clear_error (&error);
+
+	gcsv_compression_save_file (location, compression, contents, etag, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_bytes_unref (contents);
+	g_free (etag);
+
+	stream = gcsv_compression_open_file (location, &detected, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (detected, ==, compression);
+
+	g_input_stream_read_all (stream, buffer, sizeof (buffer), &n_bytes_read, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpuint (n_bytes_read, ==, strlen (text));
+	g_assert_true (memcmp (buffer, text, n_bytes_read) == 0);
+
+	g_object_unref (stream);
+	g_object_unref (location);
+	g_unlink (path);
+	g_free (path);
+}
+
+#ifdef G_OS_UNIX
+/* The write fails after the file has been opened, because of the file size
+ * limit. The original file must be kept.
+ */
+static void
+check_compression_failed_save (GcsvCompression compression)
+{
+	const gchar *original = "a,b,c\n";
+	const gsize size_limit = 64 * 1024;
+	gchar *path;
+	GFile *location;
+	GRand *rand;
+	guint8 *data;
+	gsize length;
+	gsize i;
+	GBytes *contents;
+	struct rlimit old_limit;
+	struct rlimit limit;
+	gchar *text;
+	gboolean ok;
+	GError *error = NULL;
+
+	path = g_build_filename (g_get_tmp_dir (), "gcsvedit-test-failed-save.csv", NULL);
+	g_file_set_contents (path, original, -1, &error);
+	g_assert_no_error (error);
+	location = g_file_new_for_path (path);
+
+	/* Random bytes are not compressible. */
+	length = 4 * size_limit;
+	data = g_malloc (length);
+	rand = g_rand_new_with_seed (42);
+	for (i = 0; i < length; i++)
+	{
+		data[i] = g_rand_int_range (rand, 0, 256);
+	}
+	g_rand_free (rand);
+	contents = g_bytes_new_take (data, length);
+
+	g_assert_cmpint (getrlimit (RLIMIT_FSIZE, &old_limit), ==, 0);
+	limit = old_limit;
+	limit.rlim_cur = size_limit;
+	signal (SIGXFSZ, SIG_IGN);
+	g_assert_cmpint (setrlimit (RLIMIT_FSIZE, &limit), ==, 0);
+
+	ok = gcsv_compression_save_file (location, compression, contents, NULL, NULL, NULL, &error);
+
+	g_assert_cmpint (setrlimit (RLIMIT_FSIZE, &old_limit), ==, 0);
+	signal (SIGXFSZ, SIG_DFL);
+
+	g_assert_false (ok);
+	g_assert_nonnull (error);
+	g_clear_error (&error);
+
+	g_file_get_contents (path, &text, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (text, ==, original);
+	g_free (text);
+
+	g_bytes_unref (contents);
+	g_object_unref (location);
+	g_unlink (path);
+	g_free (path);
+}
+#endif
+
+static void
+test_compression (void)
+{
+	const guint8 gzip_magic[] = { 0x1f, 0x8b, 0x08 };
+	const guint8 zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+	const guint8 xz_magic[] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+	const gchar *text = "a,b,c\n1,2,3\n";
+
+	g_assert_cmpint (gcsv_compression_detect (gzip_magic, sizeof (gzip_magic)), ==, GCSV_COMPRESSION_GZIP);
+	g_assert_cmpint (gcsv_compression_detect (zstd_magic, sizeof (zstd_magic)), ==, GCSV_COMPRESSION_ZSTD);
+	g_assert_cmpint (gcsv_compression_detect (xz_magic, sizeof (xz_magic)), ==, GCSV_COMPRESSION_XZ);
+	g_assert_cmpint (gcsv_compression_detect (xz_magic, 3), ==, GCSV_COMPRESSION_NONE);
+	g_assert_cmpint (gcsv_compression_detect ((const guint8 *) text, strlen (text)), ==, GCSV_COMPRESSION_NONE);
+
+	g_assert_cmpint (gcsv_compression_from_filename ("data.csv"), ==, GCSV_COMPRESSION_NONE);
+	g_assert_cmpint (gcsv_compression_from_filename ("data.csv.gz"), ==, GCSV_COMPRESSION_GZIP);
+	g_assert_cmpint (gcsv_compression_from_filename ("data.csv.zst"), ==, GCSV_COMPRESSION_ZSTD);
+	g_assert_cmpint (gcsv_compression_from_filename ("data.csv.xz"), ==, GCSV_COMPRESSION_XZ);
+
+	check_compression_round_trip (GCSV_COMPRESSION_NONE, text);
+	check_compression_round_trip (GCSV_COMPRESSION_GZIP, text);
+
+	if (gcsv_compression_is_supported (GCSV_COMPRESSION_ZSTD))
+	{
+		check_compression_round_trip (GCSV_COMPRESSION_ZSTD, text);
+	}
+
+	if (gcsv_compression_is_supported (GCSV_COMPRESSION_XZ))
+	{
+		check_compression_round_trip (GCSV_COMPRESSION_XZ, text);
+	}
+
+#ifdef G_OS_UNIX
+	check_compression_failed_save (GCSV_COMPRESSION_NONE);
+	check_compression_failed_save (GCSV_COMPRESSION_GZIP);
+#endif
+}
+
+static gchar *
+create_tmp_file (const gchar *contents)
+{
+	gchar *path;
+	gint fd;
+	GError *error = NULL;
+
+	fd = g_file_open_tmp ("gcsvedit-test-cli-XXXXXX", &path, NULL);
+	g_assert_cmpint (fd, !=, -1);
+	g_close (fd, NULL);
+
+	g_file_set_contents (path, contents, -1, &error);
+	g_assert_no_error (error);
+
+	return path;
+}
+
+static void
+check_cli_run (GcsvCliMode  mode,
+	       const gchar *input_path,
+	       const gchar *output_path,
+	       guint        titles_line,
+	       const gchar *expected_output)
+{
+	gchar *output;
+	GError *error = NULL;
+
+	gcsv_cli_run (mode, input_path, output_path, ",", titles_line, &error);
+	g_assert_no_error (error);
+
+	g_file_get_contents (output_path, &output, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (output, ==, expected_output);
+	g_free (output);
+}
+
+static void
+test_cli_round_trip (void)
+{
+	const gchar *text = "header,x\na,bb\nccc,d\nee\n";
+	gchar *input_path;
+	gchar *aligned_path;
+	gchar *unaligned_path;
+
+	input_path = create_tmp_file (text);
+	aligned_path = create_tmp_file ("");
+	unaligned_path = create_tmp_file ("");
+
+	check_cli_run (GCSV_CLI_MODE_ALIGN, input_path, aligned_path, 0,
+		       "header,x\na     ,bb\nccc   ,d\nee\n");
+	check_cli_run (GCSV_CLI_MODE_UNALIGN, aligned_path, unaligned_path, 0, text);
+
+	/* The header is copied as is, and is not part of the column lengths. */
+	check_cli_run (GCSV_CLI_MODE_ALIGN, input_path, aligned_path, 1,
+		       "header,x\na  ,bb\nccc,d\nee\n");
+	check_cli_run (GCSV_CLI_MODE_UNALIGN, aligned_path, unaligned_path, 1, text);
+
+	/* The header is kept when unaligning. */
+	g_file_set_contents (input_path, "h  ,x\na  ,bb\n", -1, NULL);
+	check_cli_run (GCSV_CLI_MODE_UNALIGN, input_path, unaligned_path, 1, "h  ,x\na,bb\n");
+
+	g_unlink (input_path);
+	g_unlink (aligned_path);
+	g_unlink (unaligned_path);
+	g_free (input_path);
+	g_free (aligned_path);
+	g_free (unaligned_path);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/core/tokenizer/find-delimiter", test_find_delimiter);
+	g_test_add_func ("/core/tokenizer/columns", test_columns);
+	g_test_add_func ("/core/tokenizer/line-end", test_line_end);
+	g_test_add_func ("/core/tokenizer/guess-delimiter", test_guess_delimiter);
+	g_test_add_func ("/core/tokenizer/remap-columns", test_remap_columns);
+	g_test_add_func ("/core/sort-lines", test_sort_lines);
+	g_test_add_func ("/core/filter", test_filter);
+	g_test_add_func ("/core/replace", test_replace);
+	g_test_add_func ("/core/block-hashes", test_block_hashes);
+	g_test_add_func ("/core/compression", test_compression);
+	g_test_add_func ("/core/journal", test_journal);
+	g_test_add_func ("/core/column-stats", test_column_stats);
+	g_test_add_func ("/core/trigram-index", test_trigram_index);
+	g_test_add_func ("/core/column-widths", test_column_widths);
+	g_test_add_func ("/core/row-index", test_row_index);
+	g_test_add_func ("/core/cli-round-trip", test_cli_round_trip);
+
+	return g_test_run ();
+}
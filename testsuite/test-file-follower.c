@@ -0,0 +1,231 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-alignment.h"
+#include "gcsv-file-follower.h"
+#include <glib/gstdio.h>
+
+typedef struct _AppendData AppendData;
+struct _AppendData
+{
+	const gchar *path;
+	const gchar *text;
+};
+
+static gchar *
+get_buffer_text (GtkTextBuffer *buffer)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_bounds (buffer, &start, &end);
+	return gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+}
+
+static void
+flush_queue (void)
+{
+	while (gtk_events_pending ())
+	{
+		gtk_main_iteration ();
+	}
+}
+
+static void
+append_to_file (const gchar *path,
+		const gchar *text)
+{
+	FILE *file;
+
+	file = g_fopen (path, "ab");
+	g_assert_nonnull (file);
+	fputs (text, file);
+	fclose (file);
+}
+
+static gboolean
+append_timeout_cb (gpointer user_data)
+{
+	AppendData *data = user_data;
+
+	append_to_file (data->path, data->text);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+fail_timeout_cb (gpointer user_data)
+{
+	g_assert_not_reached ();
+	return G_SOURCE_REMOVE;
+}
+
+/* Appends @text to the file, after a delay so that the follower is started,
+ * and waits for the GcsvFileFollower::appended signal.
+ */
+static void
+append_and_wait (GcsvFileFollower *follower,
+		 const gchar      *path,
+		 const gchar      *text)
+{
+	GMainLoop *main_loop;
+	AppendData data;
+	gulong handler_id;
+	guint fail_timeout_id;
+
+	main_loop = g_main_loop_new (NULL, FALSE);
+	handler_id = g_signal_connect_swapped (follower,
+					       "appended",
+					       G_CALLBACK (g_main_loop_quit),
+					       main_loop);
+
+	data.path = path;
+	data.text = text;
+	g_timeout_add (200, append_timeout_cb, &data);
+	fail_timeout_id = g_timeout_add_seconds (10, fail_timeout_cb, NULL);
+
+	g_main_loop_run (main_loop);
+
+	g_source_remove (fail_timeout_id);
+	g_signal_handler_disconnect (follower, handler_id);
+	g_main_loop_unref (main_loop);
+
+	flush_queue ();
+}
+
+static void
+test_follow (void)
+{
+	gchar *path;
+	GFile *location;
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvAlignment *align;
+	GcsvFileFollower *follower;
+	gchar *buffer_text;
+	gint fd;
+
+	fd = g_file_open_tmp ("gcsvedit-test-follow-XXXXXX.csv", &path, NULL);
+	g_assert_cmpint (fd, !=, -1);
+	g_close (fd, NULL);
+	append_to_file (path, "aa,b\n1,2\n");
+	location = g_file_new_for_path (path);
+
+	/* Like after loading the file, without the trailing newline. */
+	csv_buffer = gcsv_buffer_new ();
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (buffer, "aa,b\n1,2", -1);
+	gtk_text_buffer_set_modified (buffer, FALSE);
+
+	align = gcsv_alignment_new (csv_buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	follower = gcsv_file_follower_new (csv_buffer, location);
+	gcsv_file_follower_start (follower);
+
+	/* The incomplete last line is kept until its line terminator. The
+	 * first column becomes wider.
+	 */
+	append_and_wait (follower, path, "333,4\n5,");
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==,
+			 "aa ,b\n"
+			 "1  ,2\n"
+			 "333,4");
+	g_free (buffer_text);
+
+	append_and_wait (follower, path, "6\n");
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==,
+			 "aa ,b\n"
+			 "1  ,2\n"
+			 "333,4\n"
+			 "5  ,6");
+	g_free (buffer_text);
+
+	g_assert_false (gtk_text_buffer_get_modified (buffer));
+
+	gcsv_file_follower_stop (follower);
+	g_assert_false (gcsv_file_follower_is_started (follower));
+
+	g_object_unref (follower);
+	g_object_unref (align);
+	g_object_unref (csv_buffer);
+	g_object_unref (location);
+	g_unlink (path);
+	g_free (path);
+}
+
+static void
+test_follow_incomplete_last_line (void)
+{
+	gchar *path;
+	GFile *location;
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvFileFollower *follower;
+	gchar *buffer_text;
+	gint fd;
+
+	fd = g_file_open_tmp ("gcsvedit-test-follow-XXXXXX.csv", &path, NULL);
+	g_assert_cmpint (fd, !=, -1);
+	g_close (fd, NULL);
+	append_to_file (path, "a,b\n1,");
+	location = g_file_new_for_path (path);
+
+	/* The file doesn't end with a line terminator, so the buffer contains
+	 * all the file.
+	 */
+	csv_buffer = gcsv_buffer_new ();
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (buffer, "a,b\n1,", -1);
+	gtk_text_buffer_set_modified (buffer, FALSE);
+
+	follower = gcsv_file_follower_new (csv_buffer, location);
+	gcsv_file_follower_start (follower);
+
+	/* The appended bytes continue the last line. */
+	append_and_wait (follower, path, "2\n3,4\n");
+	buffer_text = get_buffer_text (buffer);
+	g_assert_cmpstr (buffer_text, ==,
+			 "a,b\n"
+			 "1,2\n"
+			 "3,4");
+	g_free (buffer_text);
+
+	g_object_unref (follower);
+	g_object_unref (csv_buffer);
+	g_object_unref (location);
+	g_unlink (path);
+	g_free (path);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/file-follower/follow", test_follow);
+	g_test_add_func ("/file-follower/follow-incomplete-last-line", test_follow_incomplete_last_line);
+
+	return g_test_run ();
+}
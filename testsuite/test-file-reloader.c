@@ -0,0 +1,243 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-alignment.h"
+#include "gcsv-file-reloader.h"
+#include <glib/gstdio.h>
+#include <string.h>
+
+static gchar *
+get_buffer_text (GtkTextBuffer *buffer)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_bounds (buffer, &start, &end);
+	return gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+}
+
+static void
+flush_queue (void)
+{
+	while (gtk_events_pending ())
+	{
+		gtk_main_iteration ();
+	}
+}
+
+static gboolean
+quit_timeout_cb (gpointer user_data)
+{
+	g_main_loop_quit (user_data);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+fail_timeout_cb (gpointer user_data)
+{
+	g_assert_not_reached ();
+	return G_SOURCE_REMOVE;
+}
+
+/* Waits for a thread that doesn't emit ::reloaded, for example the first one
+ * which computes the initial hashes.
+ */
+static void
+wait_thread (void)
+{
+	GMainLoop *main_loop;
+
+	main_loop = g_main_loop_new (NULL, FALSE);
+	g_timeout_add (200, quit_timeout_cb, main_loop);
+	g_main_loop_run (main_loop);
+	g_main_loop_unref (main_loop);
+}
+
+static void
+reload_and_wait (GcsvFileReloader *reloader)
+{
+	GMainLoop *main_loop;
+	gulong handler_id;
+	guint fail_timeout_id;
+
+	main_loop = g_main_loop_new (NULL, FALSE);
+	handler_id = g_signal_connect_swapped (reloader,
+					       "reloaded",
+					       G_CALLBACK (g_main_loop_quit),
+					       main_loop);
+	fail_timeout_id = g_timeout_add_seconds (10, fail_timeout_cb, NULL);
+
+	gcsv_file_reloader_reload (reloader);
+	g_main_loop_run (main_loop);
+
+	g_source_remove (fail_timeout_id);
+	g_signal_handler_disconnect (reloader, handler_id);
+	g_main_loop_unref (main_loop);
+
+	flush_queue ();
+}
+
+static gchar *
+create_rows (guint        n_rows,
+	     guint        changed_row,
+	     const gchar *changed_row_text)
+{
+	GString *text;
+	guint row_num;
+
+	text = g_string_new (NULL);
+	for (row_num = 0; row_num < n_rows; row_num++)
+	{
+		if (row_num == changed_row)
+		{
+			g_string_append (text, changed_row_text);
+		}
+		else
+		{
+			g_string_append_printf (text, "r%u,%u\n", row_num % 10, row_num);
+		}
+	}
+
+	return g_string_free (text, FALSE);
+}
+
+/* Checks that the buffer without the alignment is the file content, without
+ * the trailing newline.
+ */
+static void
+check_buffer (GcsvAlignment *align,
+	      const gchar   *file_content)
+{
+	TeplBuffer *copy;
+	gchar *expected;
+	gchar *buffer_text;
+
+	expected = g_strdup (file_content);
+	if (g_str_has_suffix (expected, "\n"))
+	{
+		expected[strlen (expected) - 1] = '\0';
+	}
+
+	copy = gcsv_alignment_copy_buffer_without_alignment (align);
+	buffer_text = get_buffer_text (GTK_TEXT_BUFFER (copy));
+	g_assert_cmpstr (buffer_text, ==, expected);
+
+	g_free (buffer_text);
+	g_free (expected);
+	g_object_unref (copy);
+}
+
+static void
+test_reload (void)
+{
+	gchar *path;
+	GFile *location;
+	GcsvBuffer *csv_buffer;
+	GtkTextBuffer *buffer;
+	GcsvAlignment *align;
+	GcsvFileReloader *reloader;
+	gchar *content;
+	gchar *old_content;
+	gchar *buffer_text;
+	gint fd;
+
+	fd = g_file_open_tmp ("gcsvedit-test-reload-XXXXXX.csv", &path, NULL);
+	g_assert_cmpint (fd, !=, -1);
+	g_close (fd, NULL);
+	location = g_file_new_for_path (path);
+
+	content = create_rows (5000, G_MAXUINT, NULL);
+	g_assert_true (g_file_set_contents (path, content, -1, NULL));
+
+	/* Like after loading the file, without the trailing newline. */
+	csv_buffer = gcsv_buffer_new ();
+	buffer = GTK_TEXT_BUFFER (csv_buffer);
+	gcsv_buffer_set_delimiter (csv_buffer, ',');
+	gtk_text_buffer_set_text (buffer, content, strlen (content) - 1);
+	gtk_text_buffer_set_modified (buffer, FALSE);
+	g_free (content);
+
+	align = gcsv_alignment_new (csv_buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	reloader = gcsv_file_reloader_new (csv_buffer, location);
+	wait_thread ();
+
+	/* A changed row in the middle. */
+	content = create_rows (5000, 2500, "r0,changed\n");
+	g_assert_true (g_file_set_contents (path, content, -1, NULL));
+	reload_and_wait (reloader);
+	check_buffer (align, content);
+	g_assert_false (gtk_text_buffer_get_modified (buffer));
+	g_free (content);
+
+	/* Rows appended, with a wider column. */
+	content = create_rows (5002, 5001, "r1234,5001\n");
+	g_assert_true (g_file_set_contents (path, content, -1, NULL));
+	reload_and_wait (reloader);
+	check_buffer (align, content);
+	g_free (content);
+
+	buffer_text = get_buffer_text (buffer);
+	g_assert_true (g_str_has_prefix (buffer_text, "r0   ,0\n"));
+	g_free (buffer_text);
+
+	/* Truncated. */
+	content = create_rows (3000, G_MAXUINT, NULL);
+	g_assert_true (g_file_set_contents (path, content, -1, NULL));
+	reload_and_wait (reloader);
+	check_buffer (align, content);
+	g_free (content);
+
+	/* A changed row that is not in UTF-8 is not reloaded. */
+	old_content = create_rows (3000, G_MAXUINT, NULL);
+	content = create_rows (3000, 1500, "r0,\xe9t\xe9\n");
+	g_assert_true (g_file_set_contents (path, content, -1, NULL));
+	gcsv_file_reloader_reload (reloader);
+	wait_thread ();
+	check_buffer (align, old_content);
+	g_free (old_content);
+	g_free (content);
+
+	content = create_rows (3000, 1500, "r0,\xc3\xa9t\xc3\xa9\n");
+	g_assert_true (g_file_set_contents (path, content, -1, NULL));
+	reload_and_wait (reloader);
+	check_buffer (align, content);
+	g_free (content);
+
+	gcsv_file_reloader_stop (reloader);
+	g_object_unref (reloader);
+	g_object_unref (align);
+	g_object_unref (csv_buffer);
+	g_object_unref (location);
+	g_unlink (path);
+	g_free (path);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/file-reloader/reload", test_reload);
+
+	return g_test_run ();
+}
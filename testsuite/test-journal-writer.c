@@ -0,0 +1,326 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-alignment.h"
+#include "gcsv-journal-writer.h"
+#include <glib/gstdio.h>
+#include <string.h>
+
+static gchar *
+get_buffer_text (GtkTextBuffer *buffer)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_bounds (buffer, &start, &end);
+	return gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+}
+
+static void
+flush_queue (void)
+{
+	while (gtk_events_pending ())
+	{
+		gtk_main_iteration ();
+	}
+}
+
+static gboolean
+fail_timeout_cb (gpointer user_data)
+{
+	g_assert_not_reached ();
+	return G_SOURCE_REMOVE;
+}
+
+static void
+async_ready_cb (GObject      *source_object,
+		GAsyncResult *result,
+		gpointer      user_data)
+{
+	GAsyncResult **result_out = user_data;
+
+	*result_out = g_object_ref (result);
+}
+
+static GAsyncResult *
+wait_for_result (GAsyncResult **result)
+{
+	guint fail_timeout_id;
+
+	fail_timeout_id = g_timeout_add_seconds (10, fail_timeout_cb, NULL);
+
+	while (*result == NULL)
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+
+	g_source_remove (fail_timeout_id);
+	return *result;
+}
+
+static gboolean
+recover (GcsvJournalWriter *writer)
+{
+	GAsyncResult *result = NULL;
+	gboolean recovered;
+	GError *error = NULL;
+
+	gcsv_journal_writer_recover_async (writer, async_ready_cb, &result);
+	recovered = gcsv_journal_writer_recover_finish (writer, wait_for_result (&result), &error);
+	g_assert_no_error (error);
+	g_object_unref (result);
+
+	return recovered;
+}
+
+static void
+flush (GcsvJournalWriter *writer)
+{
+	GAsyncResult *result = NULL;
+	GError *error = NULL;
+
+	gcsv_journal_writer_flush_async (writer, async_ready_cb, &result);
+	gcsv_journal_writer_flush_finish (writer, wait_for_result (&result), &error);
+	g_assert_no_error (error);
+	g_object_unref (result);
+}
+
+/* Like after loading the file: without the trailing newline, not modified. */
+static GcsvBuffer *
+create_buffer (const gchar *content)
+{
+	GcsvBuffer *buffer;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), content, strlen (content) - 1);
+	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), FALSE);
+
+	return buffer;
+}
+
+static void
+insert_at (GcsvBuffer  *buffer,
+	   guint        line,
+	   guint        line_offset,
+	   const gchar *text)
+{
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &iter, line, line_offset);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, text, -1);
+}
+
+static gboolean
+is_comma (gunichar ch,
+	  gpointer user_data)
+{
+	return ch == ',';
+}
+
+/* After the virtual spaces of the first column. */
+static void
+insert_after_comma (GcsvBuffer  *buffer,
+		    guint        line,
+		    const gchar *text)
+{
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, line);
+	g_assert_true (gtk_text_iter_forward_find_char (&iter, is_comma, NULL, NULL));
+	gtk_text_iter_forward_char (&iter);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, text, -1);
+}
+
+static void
+test_recover (void)
+{
+	const gchar *content = "aaa,b\nc,dd\neeeee,f\n";
+	gchar *path;
+	gchar *journal_path;
+	gchar *dirname;
+	gchar *basename;
+	GFile *location;
+	GcsvBuffer *buffer;
+	GcsvBuffer *recovered_buffer;
+	GcsvAlignment *align;
+	GcsvJournalWriter *writer;
+	TeplBuffer *copy;
+	GtkTextIter start;
+	GtkTextIter end;
+	gchar *expected;
+	gchar *buffer_text;
+	gint fd;
+
+	fd = g_file_open_tmp ("gcsvedit-test-journal-XXXXXX.csv", &path, NULL);
+	g_assert_cmpint (fd, !=, -1);
+	g_close (fd, NULL);
+	g_assert_true (g_file_set_contents (path, content, -1, NULL));
+	location = g_file_new_for_path (path);
+
+	dirname = g_path_get_dirname (path);
+	basename = g_path_get_basename (path);
+	journal_path = g_strconcat (dirname, G_DIR_SEPARATOR_S, ".", basename, ".gcsv-journal", NULL);
+
+	/* Edits on an aligned buffer, then a "crash": the writer is destroyed
+	 * without discarding the journal.
+	 */
+	buffer = create_buffer (content);
+	writer = gcsv_journal_writer_new (buffer, location);
+	g_assert_false (recover (writer));
+
+	align = gcsv_alignment_new (buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	insert_at (buffer, 1, 0, "X");
+	flush_queue ();
+
+	insert_after_comma (buffer, 1, "Y");
+	flush_queue ();
+
+	/* Deletes ",b" and the virtual spaces after it. */
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &start, 0, 3);
+	end = start;
+	gtk_text_iter_forward_to_line_end (&end);
+	gtk_text_buffer_delete (GTK_TEXT_BUFFER (buffer), &start, &end);
+	flush_queue ();
+
+	gcsv_buffer_insert_column (buffer, 0);
+	flush_queue ();
+
+	insert_at (buffer, 2, 0, "g");
+	flush_queue ();
+
+	flush (writer);
+	g_assert_true (g_file_test (journal_path, G_FILE_TEST_EXISTS));
+	g_object_unref (writer);
+
+	copy = gcsv_alignment_copy_buffer_without_alignment (align);
+	expected = get_buffer_text (GTK_TEXT_BUFFER (copy));
+	g_object_unref (copy);
+	g_object_unref (align);
+	g_object_unref (buffer);
+
+	/* The recovery. */
+	recovered_buffer = create_buffer (content);
+	writer = gcsv_journal_writer_new (recovered_buffer, location);
+	g_assert_true (recover (writer));
+	g_assert_true (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (recovered_buffer)));
+
+	buffer_text = get_buffer_text (GTK_TEXT_BUFFER (recovered_buffer));
+	g_assert_cmpstr (buffer_text, ==, expected);
+	g_free (buffer_text);
+
+	/* A save: only the edits done during the save are kept. */
+	gcsv_journal_writer_begin_save (writer);
+	buffer_text = get_buffer_text (GTK_TEXT_BUFFER (recovered_buffer));
+	g_free (expected);
+	expected = g_strconcat (buffer_text, "\n", NULL);
+	g_free (buffer_text);
+
+	insert_at (recovered_buffer, 0, 0, "h");
+
+	g_assert_true (g_file_set_contents (path, expected, -1, NULL));
+	gcsv_journal_writer_end_save (writer, location);
+	flush (writer);
+	g_object_unref (writer);
+
+	buffer = create_buffer (expected);
+	writer = gcsv_journal_writer_new (buffer, location);
+	g_assert_true (recover (writer));
+
+	g_free (expected);
+	expected = get_buffer_text (GTK_TEXT_BUFFER (recovered_buffer));
+	buffer_text = get_buffer_text (GTK_TEXT_BUFFER (buffer));
+	g_assert_cmpstr (buffer_text, ==, expected);
+	g_free (buffer_text);
+
+	/* Closed normally. */
+	gcsv_journal_writer_discard (writer);
+	flush (writer);
+	g_assert_false (g_file_test (journal_path, G_FILE_TEST_EXISTS));
+	g_object_unref (writer);
+
+	g_object_unref (buffer);
+	g_object_unref (recovered_buffer);
+	g_object_unref (location);
+	g_unlink (path);
+	g_free (path);
+	g_free (journal_path);
+	g_free (dirname);
+	g_free (basename);
+	g_free (expected);
+}
+
+static void
+test_other_version (void)
+{
+	const gchar *content = "a,b\nc,d\n";
+	gchar *path;
+	GFile *location;
+	GcsvBuffer *buffer;
+	GcsvJournalWriter *writer;
+	gint fd;
+
+	fd = g_file_open_tmp ("gcsvedit-test-journal-XXXXXX.csv", &path, NULL);
+	g_assert_cmpint (fd, !=, -1);
+	g_close (fd, NULL);
+	g_assert_true (g_file_set_contents (path, content, -1, NULL));
+	location = g_file_new_for_path (path);
+
+	buffer = create_buffer (content);
+	writer = gcsv_journal_writer_new (buffer, location);
+	g_assert_false (recover (writer));
+	insert_at (buffer, 0, 0, "x");
+	flush (writer);
+	g_object_unref (writer);
+	g_object_unref (buffer);
+
+	/* The file has been changed by another program: the journal doesn't
+	 * apply to it.
+	 */
+	g_assert_true (g_file_set_contents (path, "a,b\nc,d\ne,f\n", -1, NULL));
+
+	buffer = create_buffer ("a,b\nc,d\ne,f\n");
+	writer = gcsv_journal_writer_new (buffer, location);
+	g_assert_false (recover (writer));
+	g_assert_false (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)));
+
+	gcsv_journal_writer_discard (writer);
+	flush (writer);
+	g_object_unref (writer);
+
+	g_object_unref (buffer);
+	g_object_unref (location);
+	g_unlink (path);
+	g_free (path);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/journal-writer/recover", test_recover);
+	g_test_add_func ("/journal-writer/other-version", test_other_version);
+
+	return g_test_run ();
+}
@@ -0,0 +1,180 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-ragged-rows.h"
+
+static void
+wait_ragged_rows (GcsvRaggedRows *ragged_rows)
+{
+	while (!gcsv_ragged_rows_is_complete (ragged_rows))
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+}
+
+static void
+check_find (GcsvRaggedRows *ragged_rows,
+	    guint           from_line,
+	    gboolean        backward,
+	    guint           expected_line)
+{
+	guint line = 0;
+
+	g_assert_true (gcsv_ragged_rows_find (ragged_rows, from_line, backward, &line));
+	g_assert_cmpuint (line, ==, expected_line);
+}
+
+static void
+test_ragged_rows (void)
+{
+	GcsvBuffer *buffer;
+	GcsvRaggedRows *ragged_rows;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer),
+				  "A header.\n"
+				  "name,a,b\n"
+				  "1,2,3\n"
+				  "1,2\n"
+				  "\n"
+				  "1,2,3\n"
+				  "1,2,3,4\n",
+				  -1);
+	gcsv_buffer_set_column_titles_line (buffer, 1);
+
+	/* The header and the empty lines are not ragged. */
+	ragged_rows = gcsv_ragged_rows_new (buffer);
+	wait_ragged_rows (ragged_rows);
+
+	g_assert_cmpuint (gcsv_ragged_rows_get_expected_n_columns (ragged_rows), ==, 3);
+	g_assert_cmpuint (gcsv_ragged_rows_get_n_rows (ragged_rows), ==, 2);
+
+	check_find (ragged_rows, 0, FALSE, 3);
+	check_find (ragged_rows, 3, FALSE, 6);
+	check_find (ragged_rows, 5, TRUE, 3);
+
+	/* Wrapping around. */
+	check_find (ragged_rows, 6, FALSE, 3);
+	check_find (ragged_rows, 3, TRUE, 6);
+
+	/* The edited lines are computed again. */
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &end, 3);
+	gtk_text_iter_forward_to_line_end (&end);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &end, ",3", -1);
+	g_assert_false (gcsv_ragged_rows_is_complete (ragged_rows));
+	wait_ragged_rows (ragged_rows);
+
+	g_assert_cmpuint (gcsv_ragged_rows_get_n_rows (ragged_rows), ==, 1);
+	check_find (ragged_rows, 0, FALSE, 6);
+	check_find (ragged_rows, 6, FALSE, 6);
+
+	/* An edit of the column titles changes the expected number of
+	 * columns.
+	 */
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &start, 1, 6);
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &end, 1, 8);
+	gtk_text_buffer_delete (GTK_TEXT_BUFFER (buffer), &start, &end);
+	wait_ragged_rows (ragged_rows);
+
+	g_assert_cmpuint (gcsv_ragged_rows_get_expected_n_columns (ragged_rows), ==, 2);
+	g_assert_cmpuint (gcsv_ragged_rows_get_n_rows (ragged_rows), ==, 4);
+
+	/* Without column titles, the most common number of columns is
+	 * expected.
+	 */
+	gcsv_buffer_set_column_titles_line (buffer, 0);
+	wait_ragged_rows (ragged_rows);
+
+	g_assert_cmpuint (gcsv_ragged_rows_get_expected_n_columns (ragged_rows), ==, 3);
+	g_assert_cmpuint (gcsv_ragged_rows_get_n_rows (ragged_rows), ==, 2);
+	check_find (ragged_rows, 0, FALSE, 1);
+	check_find (ragged_rows, 1, FALSE, 6);
+
+	/* Without delimiter, there are no ragged rows. */
+	gcsv_buffer_set_delimiter (buffer, '\0');
+	g_assert_cmpuint (gcsv_ragged_rows_get_n_rows (ragged_rows), ==, 0);
+
+	g_object_unref (ragged_rows);
+	g_object_unref (buffer);
+}
+
+/* Only the replaced lines are computed again, and the lines after them keep
+ * their results.
+ */
+static void
+test_replace_lines (void)
+{
+	GcsvBuffer *buffer;
+	GcsvRaggedRows *ragged_rows;
+	GString *text;
+	gint line_num;
+
+	text = g_string_new ("a,b,c\n");
+	for (line_num = 1; line_num <= 10000; line_num++)
+	{
+		g_string_append (text, line_num % 1000 == 0 ? "1,2\n" : "1,2,3\n");
+	}
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), text->str, -1);
+
+	ragged_rows = gcsv_ragged_rows_new (buffer);
+	wait_ragged_rows (ragged_rows);
+	g_assert_cmpuint (gcsv_ragged_rows_get_n_rows (ragged_rows), ==, 10);
+
+	/* Across the boundary of the first two chunks, with fewer lines. */
+	gcsv_buffer_replace_lines (buffer, 3990, 200, "1\n1,2,3\n1\n", NULL, NULL);
+	g_assert_false (gcsv_ragged_rows_is_complete (ragged_rows));
+	wait_ragged_rows (ragged_rows);
+
+	g_assert_cmpuint (gcsv_ragged_rows_get_n_rows (ragged_rows), ==, 11);
+	check_find (ragged_rows, 3001, FALSE, 3990);
+	check_find (ragged_rows, 3991, FALSE, 3992);
+	check_find (ragged_rows, 3993, FALSE, 5000 - 197);
+	check_find (ragged_rows, 9999 - 197, TRUE, 9000 - 197);
+
+	/* With more lines. */
+	gcsv_buffer_replace_lines (buffer, 3990, 3, "1,2\n1,2,3\n1,2,3\n1,2,3\n1,2,3\n", NULL, NULL);
+	wait_ragged_rows (ragged_rows);
+
+	g_assert_cmpuint (gcsv_ragged_rows_get_n_rows (ragged_rows), ==, 10);
+	check_find (ragged_rows, 3001, FALSE, 3990);
+	check_find (ragged_rows, 3990, FALSE, 5000 - 195);
+	check_find (ragged_rows, 10001 - 195, TRUE, 10000 - 195);
+
+	g_object_unref (ragged_rows);
+	g_object_unref (buffer);
+	g_string_free (text, TRUE);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/ragged-rows/ragged-rows", test_ragged_rows);
+	g_test_add_func ("/ragged-rows/replace-lines", test_replace_lines);
+
+	return g_test_run ();
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-row-filter.h"
+
+static void
+wait_row_filter (GcsvRowFilter *row_filter)
+{
+	while (gcsv_row_filter_is_busy (row_filter))
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+}
+
+static void
+check_hidden_lines (GcsvRowFilter  *row_filter,
+		    GtkTextBuffer  *buffer,
+		    const gboolean *hidden)
+{
+	gint line_num;
+
+	wait_row_filter (row_filter);
+
+	for (line_num = 0; line_num < gtk_text_buffer_get_line_count (buffer); line_num++)
+	{
+		g_assert_cmpint (gcsv_row_filter_is_line_hidden (row_filter, line_num), ==, hidden[line_num]);
+	}
+}
+
+static void
+test_filter (void)
+{
+	GcsvBuffer *buffer;
+	GcsvRowFilter *row_filter;
+	GcsvFilter *filter;
+	GtkTextIter iter;
+	GtkTextIter end;
+	gchar *text;
+	const gboolean initial[] = { FALSE, FALSE, TRUE, FALSE, TRUE, FALSE };
+	const gboolean after_edit[] = { FALSE, FALSE, FALSE, FALSE, TRUE, FALSE };
+	const gboolean none[] = { FALSE, FALSE, FALSE, FALSE, FALSE, FALSE };
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer),
+				  "A header, without match.\n"
+				  "name,fruit\n"
+				  "a,cherry\n"
+				  "b,apple\n"
+				  "c,cherry\n"
+				  "d,pineapple",
+				  -1);
+	gcsv_buffer_set_column_titles_line (buffer, 1);
+
+	row_filter = gcsv_row_filter_new (buffer);
+
+	/* The header and the column titles are always shown. */
+	filter = gcsv_filter_new (GCSV_FILTER_MODE_SUBSTRING, 1, "apple", NULL);
+	gcsv_row_filter_set_filter (row_filter, filter);
+	gcsv_filter_unref (filter);
+	check_hidden_lines (row_filter, GTK_TEXT_BUFFER (buffer), initial);
+
+	/* The edited chunk is matched again. */
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &iter, 2, 2);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, "apple ", -1);
+	check_hidden_lines (row_filter, GTK_TEXT_BUFFER (buffer), after_edit);
+
+	/* The text is not modified. */
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (buffer), &iter, &end);
+	text = gcsv_buffer_get_text_without_virtual_spaces (buffer, &iter, &end);
+	g_assert_cmpstr (text, ==,
+			 "A header, without match.\n"
+			 "name,fruit\n"
+			 "a,apple cherry\n"
+			 "b,apple\n"
+			 "c,cherry\n"
+			 "d,pineapple");
+	g_free (text);
+
+	gcsv_row_filter_set_filter (row_filter, NULL);
+	check_hidden_lines (row_filter, GTK_TEXT_BUFFER (buffer), none);
+
+	g_object_unref (row_filter);
+	g_object_unref (buffer);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/row-filter/filter", test_filter);
+
+	return g_test_run ();
+}
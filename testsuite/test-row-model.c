@@ -0,0 +1,179 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-row-model.h"
+#include "gcsv-alignment.h"
+#include <string.h>
+
+static void
+flush_queue (void)
+{
+	while (gtk_events_pending ())
+	{
+		gtk_main_iteration ();
+	}
+}
+
+static void
+items_changed_cb (GListModel *model,
+		  guint       position,
+		  guint       n_removed,
+		  guint       n_added,
+		  guint      *n_changes)
+{
+	(*n_changes)++;
+}
+
+static void
+check_row (GcsvRowModel *model,
+	   guint         row_num,
+	   const gchar  *fields[])
+{
+	GcsvRow *row;
+	guint n_fields;
+	guint column_num;
+
+	row = g_list_model_get_item (G_LIST_MODEL (model), row_num);
+	g_assert_nonnull (row);
+	g_assert_cmpuint (gcsv_row_get_row_num (row), ==, row_num);
+
+	n_fields = g_strv_length ((gchar **) fields);
+	g_assert_cmpuint (gcsv_row_get_n_fields (row), ==, n_fields);
+
+	for (column_num = 0; column_num < n_fields; column_num++)
+	{
+		g_assert_cmpstr (gcsv_row_get_field (row, column_num), ==, fields[column_num]);
+	}
+
+	g_assert_null (gcsv_row_get_field (row, n_fields));
+
+	g_object_unref (row);
+}
+
+static void
+test_buffer_rows (void)
+{
+	GcsvBuffer *buffer;
+	GcsvAlignment *align;
+	GcsvRowModel *model;
+	const gchar *row0[] = { "aaa", "bbb", NULL };
+	const gchar *row1[] = { "1", "2", NULL };
+	const gchar *row2[] = { "", NULL };
+	const gchar *row1_modified[] = { "1", "22222", NULL };
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+	align = gcsv_alignment_new (buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "aaa,bbb\n1,2\n", -1);
+	flush_queue ();
+
+	/* The virtual spaces are not part of the fields. */
+	model = gcsv_row_model_new_for_buffer (buffer);
+	g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (model)), ==, 3);
+	check_row (model, 0, row0);
+	check_row (model, 1, row1);
+	check_row (model, 2, row2);
+	g_assert_null (g_list_model_get_item (G_LIST_MODEL (model), 3));
+
+	/* Write back, the virtual spaces are replaced too. */
+	g_assert_true (gcsv_row_model_set_field (model, 1, 1, "22222"));
+	g_assert_false (gcsv_row_model_set_field (model, 1, 2, "x"));
+	flush_queue ();
+	check_row (model, 1, row1_modified);
+
+	g_object_unref (model);
+	g_object_unref (align);
+	g_object_unref (buffer);
+}
+
+static void
+test_buffer_items_changed (void)
+{
+	GcsvBuffer *buffer;
+	GcsvRowModel *model;
+	GtkTextIter iter;
+	guint n_changes = 0;
+
+	buffer = gcsv_buffer_new ();
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "a\nb\nc", -1);
+
+	model = gcsv_row_model_new_for_buffer (buffer);
+	g_signal_connect (model,
+			  "items-changed",
+			  G_CALLBACK (items_changed_cb),
+			  &n_changes);
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, 1);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, "x\ny\n", -1);
+	g_assert_cmpuint (n_changes, ==, 1);
+	g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (model)), ==, 5);
+
+	/* The virtual spaces are not part of the fields. */
+	gcsv_buffer_begin_virtual_spaces_edit (buffer);
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, 1);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, "  ", -1);
+	gcsv_buffer_end_virtual_spaces_edit (buffer);
+	g_assert_cmpuint (n_changes, ==, 1);
+
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "z", -1);
+	g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (model)), ==, 1);
+
+	g_object_unref (model);
+	g_object_unref (buffer);
+}
+
+static void
+test_row_index_rows (void)
+{
+	const gchar *text = "aaa,bbb\r\n1,2\n\xff,x";
+	GBytes *bytes;
+	GcsvRowIndex *index;
+	GcsvRowModel *model;
+	const gchar *row0[] = { "aaa", "bbb", NULL };
+	const gchar *row2[] = { "\357\277\275", "x", NULL };
+
+	bytes = g_bytes_new_static (text, strlen (text));
+	index = gcsv_row_index_new (bytes, ',');
+	gcsv_row_index_build (index, NULL);
+
+	model = gcsv_row_model_new_for_row_index (index);
+	g_assert_false (gcsv_row_model_is_editable (model));
+	g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (model)), ==, 3);
+	check_row (model, 0, row0);
+	check_row (model, 2, row2);
+
+	g_object_unref (model);
+	gcsv_row_index_unref (index);
+	g_bytes_unref (bytes);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/row-model/buffer-rows", test_buffer_rows);
+	g_test_add_func ("/row-model/buffer-items-changed", test_buffer_items_changed);
+	g_test_add_func ("/row-model/row-index-rows", test_row_index_rows);
+
+	return g_test_run ();
+}
@@ -0,0 +1,389 @@
+/*
+ * This file is part of gCSVedit.
+ *
+ * Copyright 2026 - Sébastien Wilmet <swilmet@gnome.org>
+ *
+ * gCSVedit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gCSVedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gCSVedit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcsv-alignment.h"
+#include "gcsv-undo-manager.h"
+#include <string.h>
+
+static void
+flush_queue (void)
+{
+	while (gtk_events_pending ())
+	{
+		gtk_main_iteration ();
+	}
+}
+
+/* Like after loading a file. */
+static GcsvBuffer *
+create_buffer (const gchar *content)
+{
+	GcsvBuffer *buffer;
+
+	buffer = gcsv_buffer_new ();
+	gcsv_buffer_set_delimiter (buffer, ',');
+
+	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), content, -1);
+	gtk_source_buffer_end_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+
+	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), FALSE);
+
+	return buffer;
+}
+
+static void
+check_text (GcsvAlignment *align,
+	    const gchar   *expected)
+{
+	TeplBuffer *copy;
+	GtkTextIter start;
+	GtkTextIter end;
+	gchar *text;
+
+	flush_queue ();
+
+	copy = gcsv_alignment_copy_buffer_without_alignment (align);
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (copy), &start, &end);
+	text = gtk_text_buffer_get_text (GTK_TEXT_BUFFER (copy), &start, &end, TRUE);
+	g_assert_cmpstr (text, ==, expected);
+
+	g_free (text);
+	g_object_unref (copy);
+}
+
+/* Like GtkTextView, one user action per keystroke. */
+static void
+type_text (GcsvBuffer  *buffer,
+	   const gchar *text)
+{
+	const gchar *p;
+
+	for (p = text; *p != '\0'; p = g_utf8_next_char (p))
+	{
+		gtk_text_buffer_begin_user_action (GTK_TEXT_BUFFER (buffer));
+		gtk_text_buffer_insert_at_cursor (GTK_TEXT_BUFFER (buffer), p, g_utf8_next_char (p) - p);
+		gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (buffer));
+		flush_queue ();
+	}
+}
+
+static void
+press_backspace (GcsvBuffer *buffer)
+{
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
+					  &iter,
+					  gtk_text_buffer_get_insert (GTK_TEXT_BUFFER (buffer)));
+	gtk_text_buffer_backspace (GTK_TEXT_BUFFER (buffer), &iter, TRUE, TRUE);
+	flush_queue ();
+}
+
+static void
+undo (GcsvBuffer *buffer)
+{
+	g_assert_true (gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer)));
+	gtk_source_buffer_undo (GTK_SOURCE_BUFFER (buffer));
+	flush_queue ();
+}
+
+static void
+redo (GcsvBuffer *buffer)
+{
+	g_assert_true (gtk_source_buffer_can_redo (GTK_SOURCE_BUFFER (buffer)));
+	gtk_source_buffer_redo (GTK_SOURCE_BUFFER (buffer));
+	flush_queue ();
+}
+
+static void
+test_keystrokes (void)
+{
+	GcsvBuffer *buffer;
+	GcsvAlignment *align;
+	GtkTextIter iter;
+
+	buffer = create_buffer ("aaa,b\nc,dd");
+	align = gcsv_alignment_new (buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	/* The alignment is not recorded. */
+	g_assert_false (gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer)));
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, 1);
+	gtk_text_iter_forward_to_line_end (&iter);
+	gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (buffer), &iter);
+
+	/* One action per word. */
+	type_text (buffer, "ee ff");
+	check_text (align, "aaa,b\nc,ddee ff");
+
+	undo (buffer);
+	check_text (align, "aaa,b\nc,ddee");
+
+	undo (buffer);
+	check_text (align, "aaa,b\nc,dd");
+	g_assert_false (gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer)));
+	g_assert_false (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)));
+
+	redo (buffer);
+	redo (buffer);
+	check_text (align, "aaa,b\nc,ddee ff");
+	g_assert_false (gtk_source_buffer_can_redo (GTK_SOURCE_BUFFER (buffer)));
+	g_assert_true (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)));
+
+	/* Like a save. */
+	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), FALSE);
+
+	press_backspace (buffer);
+	press_backspace (buffer);
+	check_text (align, "aaa,b\nc,ddee ");
+
+	undo (buffer);
+	check_text (align, "aaa,b\nc,ddee ff");
+	g_assert_false (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)));
+
+	undo (buffer);
+	g_assert_true (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)));
+
+	/* A new edit removes the redo actions. */
+	type_text (buffer, "g");
+	g_assert_false (gtk_source_buffer_can_redo (GTK_SOURCE_BUFFER (buffer)));
+	check_text (align, "aaa,b\nc,ddeeg");
+
+	g_object_unref (align);
+	g_object_unref (buffer);
+}
+
+static void
+test_failed_save (void)
+{
+	GcsvBuffer *buffer;
+
+	buffer = create_buffer ("a,b");
+	type_text (buffer, "c");
+
+	/* The modified flag is reset when the save starts, and set again when
+	 * it fails.
+	 */
+	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), FALSE);
+	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), TRUE);
+
+	undo (buffer);
+	g_assert_true (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)));
+
+	redo (buffer);
+	g_assert_true (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)));
+
+	/* A successful save. */
+	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (buffer), FALSE);
+	type_text (buffer, " ");
+	undo (buffer);
+	g_assert_false (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (buffer)));
+
+	g_object_unref (buffer);
+}
+
+static gboolean
+is_comma (gunichar ch,
+	  gpointer user_data)
+{
+	return ch == ',';
+}
+
+static void
+test_virtual_spaces (void)
+{
+	const gchar *content = "aaa,b\nc,dd\neeeee,f";
+	GcsvBuffer *buffer;
+	GcsvAlignment *align;
+	GtkTextIter start;
+	GtkTextIter end;
+	TeplBuffer *copy;
+	gchar *expected;
+
+	buffer = create_buffer (content);
+	align = gcsv_alignment_new (buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	/* After the virtual spaces of the first column. */
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &start, 1);
+	g_assert_true (gtk_text_iter_forward_find_char (&start, is_comma, NULL, NULL));
+	gtk_text_iter_forward_char (&start);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &start, "Y", -1);
+	flush_queue ();
+
+	/* Deletes ",b" and the virtual spaces after it. */
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &start, 0, 3);
+	end = start;
+	gtk_text_iter_forward_to_line_end (&end);
+	gtk_text_buffer_delete (GTK_TEXT_BUFFER (buffer), &start, &end);
+	flush_queue ();
+
+	/* A replace-lines edit. */
+	gcsv_buffer_insert_column (buffer, 0);
+	flush_queue ();
+
+	copy = gcsv_alignment_copy_buffer_without_alignment (align);
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (copy), &start, &end);
+	expected = gtk_text_buffer_get_text (GTK_TEXT_BUFFER (copy), &start, &end, TRUE);
+	g_object_unref (copy);
+
+	undo (buffer);
+	check_text (align, "aaa\nc,Ydd\neeeee,f");
+
+	undo (buffer);
+	check_text (align, "aaa,b\nc,Ydd\neeeee,f");
+
+	undo (buffer);
+	check_text (align, content);
+	g_assert_false (gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer)));
+
+	redo (buffer);
+	redo (buffer);
+	redo (buffer);
+	check_text (align, expected);
+
+	g_free (expected);
+	g_object_unref (align);
+	g_object_unref (buffer);
+}
+
+static void
+test_not_undoable (void)
+{
+	GcsvBuffer *buffer;
+
+	buffer = create_buffer ("a,b");
+	g_assert_false (gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer)));
+
+	gtk_text_buffer_insert_at_cursor (GTK_TEXT_BUFFER (buffer), "c,d\n", -1);
+	g_assert_true (gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer)));
+
+	/* The positions in the history would no longer be valid. */
+	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+	gtk_text_buffer_insert_at_cursor (GTK_TEXT_BUFFER (buffer), "e,f\n", -1);
+	gtk_source_buffer_end_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+	g_assert_false (gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer)));
+
+	g_object_unref (buffer);
+}
+
+/* Like a followed file that grows. */
+static void
+test_append_after_history (void)
+{
+	GcsvBuffer *buffer;
+	GcsvAlignment *align;
+	GtkTextIter iter;
+
+	buffer = create_buffer ("a,b\nc,d");
+	align = gcsv_alignment_new (buffer);
+	gcsv_alignment_set_unit_test_mode (align, TRUE);
+	flush_queue ();
+
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (buffer), &iter);
+	gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (buffer), &iter);
+	type_text (buffer, "x");
+
+	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+	gtk_text_buffer_get_end_iter (GTK_TEXT_BUFFER (buffer), &iter);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, "\ne,f", -1);
+	gtk_source_buffer_end_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+	flush_queue ();
+
+	undo (buffer);
+	check_text (align, "a,b\nc,d\ne,f");
+	redo (buffer);
+	check_text (align, "xa,b\nc,d\ne,f");
+
+	/* On the last line of the history. */
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer), &iter, 2);
+	gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (buffer), &iter);
+	type_text (buffer, "y");
+
+	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+	gtk_text_buffer_get_end_iter (GTK_TEXT_BUFFER (buffer), &iter);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &iter, "\ng,h", -1);
+	gtk_source_buffer_end_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+	g_assert_false (gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer)));
+
+	g_object_unref (align);
+	g_object_unref (buffer);
+}
+
+static void
+test_max_size (void)
+{
+	GcsvBuffer *buffer;
+	GcsvUndoManager *manager;
+	gchar *line;
+	gint i;
+
+	buffer = create_buffer ("");
+	manager = GCSV_UNDO_MANAGER (gtk_source_buffer_get_undo_manager (GTK_SOURCE_BUFFER (buffer)));
+	gcsv_undo_manager_set_max_size (manager, 1000);
+
+	line = g_strnfill (300, 'x');
+
+	for (i = 0; i < 5; i++)
+	{
+		gtk_text_buffer_insert_at_cursor (GTK_TEXT_BUFFER (buffer), line, -1);
+		gtk_text_buffer_insert_at_cursor (GTK_TEXT_BUFFER (buffer), "\n", -1);
+		g_assert_cmpuint (gcsv_undo_manager_get_size (manager), <=, 1000);
+	}
+
+	/* The oldest actions have been dropped. */
+	g_assert_cmpint (gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (buffer)), ==, 6);
+	while (gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer)))
+	{
+		gtk_source_buffer_undo (GTK_SOURCE_BUFFER (buffer));
+	}
+	g_assert_cmpint (gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (buffer)), >, 1);
+	g_assert_cmpint (gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (buffer)), <, 6);
+
+	/* Too big to be undone. */
+	g_free (line);
+	line = g_strnfill (2000, 'x');
+	gtk_text_buffer_insert_at_cursor (GTK_TEXT_BUFFER (buffer), line, -1);
+	g_assert_false (gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer)));
+	g_assert_false (gtk_source_buffer_can_redo (GTK_SOURCE_BUFFER (buffer)));
+	g_assert_cmpuint (gcsv_undo_manager_get_size (manager), ==, 0);
+
+	g_free (line);
+	g_object_unref (buffer);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/undo-manager/keystrokes", test_keystrokes);
+	g_test_add_func ("/undo-manager/failed-save", test_failed_save);
+	g_test_add_func ("/undo-manager/virtual-spaces", test_virtual_spaces);
+	g_test_add_func ("/undo-manager/not-undoable", test_not_undoable);
+	g_test_add_func ("/undo-manager/append-after-history", test_append_after_history);
+	g_test_add_func ("/undo-manager/max-size", test_max_size);
+
+	return g_test_run ();
+}
@@ -20,6 +20,7 @@
  */
 
 #include "gcsv-utils.h"
+#include <string.h>
 #include <gtk/gtk.h>
 
 static gchar *
@@ -98,6 +99,91 @@ test_delete_text_with_tag (void)
 	g_object_unref (buffer);
 }
 
+static void
+check_strip_last_line_terminator (const gchar *text,
+				  const gchar *expected)
+{
+	GString *string;
+
+	string = g_string_new (text);
+	gcsv_utils_strip_last_line_terminator (string);
+	g_assert_cmpstr (string->str, ==, expected);
+	g_string_free (string, TRUE);
+}
+
+static void
+test_strip_last_line_terminator (void)
+{
+	check_strip_last_line_terminator ("", "");
+	check_strip_last_line_terminator ("\n", "");
+	check_strip_last_line_terminator ("a,b", "a,b");
+	check_strip_last_line_terminator ("a,b\n", "a,b");
+	check_strip_last_line_terminator ("a,b\r\n", "a,b");
+	check_strip_last_line_terminator ("a,b\n\n", "a,b\n");
+	check_strip_last_line_terminator ("a,b\r", "a,b\r");
+}
+
+static void
+test_remove_tagged_text (void)
+{
+	GtkTextBuffer *buffer;
+	GtkTextTag *tag;
+	GtkTextIter start;
+	GtkTextIter end;
+	GArray *offsets;
+	gchar *text;
+	gsize length;
+
+	buffer = gtk_text_buffer_new (NULL);
+	tag = gtk_text_buffer_create_tag (buffer, NULL, NULL);
+	gtk_text_buffer_set_text (buffer, "h\xc3\xa9llo  universe  ", -1);
+
+	/* Add tag to the 'h', to one space after "héllo" and to the last
+	 * spaces.
+	 */
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, 0);
+	gtk_text_buffer_get_iter_at_offset (buffer, &end, 1);
+	gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, 6);
+	gtk_text_buffer_get_iter_at_offset (buffer, &end, 7);
+	gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, 15);
+	gtk_text_buffer_get_end_iter (buffer, &end);
+	gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+
+	offsets = gcsv_utils_get_tag_offsets (buffer, tag);
+	g_assert_cmpuint (offsets->len, ==, 6);
+	g_assert_cmpint (g_array_index (offsets, gint, 0), ==, 0);
+	g_assert_cmpint (g_array_index (offsets, gint, 1), ==, 1);
+	g_assert_cmpint (g_array_index (offsets, gint, 2), ==, 6);
+	g_assert_cmpint (g_array_index (offsets, gint, 3), ==, 7);
+	g_assert_cmpint (g_array_index (offsets, gint, 4), ==, 15);
+	g_assert_cmpint (g_array_index (offsets, gint, 5), ==, 17);
+
+	text = get_buffer_text (buffer);
+	length = gcsv_utils_remove_char_ranges (text, strlen (text), offsets);
+	g_assert_cmpstr (text, ==, "\xc3\xa9llo universe");
+	g_assert_cmpuint (length, ==, strlen (text));
+	g_free (text);
+	g_array_unref (offsets);
+
+	/* Without tag. */
+	gtk_text_buffer_set_text (buffer, "a,b", -1);
+	offsets = gcsv_utils_get_tag_offsets (buffer, tag);
+	g_assert_cmpuint (offsets->len, ==, 0);
+
+	text = get_buffer_text (buffer);
+	length = gcsv_utils_remove_char_ranges (text, strlen (text), offsets);
+	g_assert_cmpstr (text, ==, "a,b");
+	g_assert_cmpuint (length, ==, 3);
+	g_free (text);
+	g_array_unref (offsets);
+
+	g_object_unref (buffer);
+}
+
 gint
 main (gint    argc,
       gchar **argv)
@@ -105,6 +191,8 @@ main (gint    argc,
 	gtk_test_init (&argc, &argv);
 
 	g_test_add_func ("/utils/delete-text-with-tag", test_delete_text_with_tag);
+	g_test_add_func ("/utils/strip-last-line-terminator", test_strip_last_line_terminator);
+	g_test_add_func ("/utils/remove-tagged-text", test_remove_tagged_text);
 
 	return g_test_run ();
 }